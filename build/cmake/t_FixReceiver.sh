@@ -18,7 +18,7 @@ set -e
 
 OUTPUT_DIR=${OUTPUT_DIR:-${BUILD_DIR}/${BUILD_TYPE}/fon9}
 
-rm -f fix.log
+rm -f fix.log fix.log.sidx
 $OUTPUT_DIR/FixReceiver_UT ./fix.log ../../fon9/fix/FixReceiver_UT_Case.txt
 
 # 移除紀錄的 timestamp.
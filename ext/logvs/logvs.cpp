@@ -14,6 +14,7 @@
 //--------------------------------------------------------------------------//
 #include "fon9/LogFile.hpp"
 #include "fon9/Log.hpp"
+#include "fon9/LogRing.hpp"
 #include "fon9/buffer/MemBlockImpl.hpp"
 #include "fon9/DefaultThreadPool.hpp"
 #include "mpsc_slist.hpp"
@@ -198,6 +199,7 @@ void print_usage() {
     printf("Usage: logvs logName iCOUNT sSLEEP t1 t2 t3...\n"
            "    logName     fon9     use fon9_LOG_INFO(test_values)\n"
            "                fon9fmt  use fon9_LOG_INFO(fon9::Fmt{}, test_values)\n"
+           "                fon9ring use fon9_LOGR_INFO(test_values): per-thread ring + lazy format\n"
          //"                fon9lf   lock-free test\n"
            "                spdlog\n"
            "                nanolog\n"
@@ -288,6 +290,18 @@ int main(int argc, char * argv[])
            };
         run_benchmark_threads(fon9BenchmarkFn, "fon9_LOG");
     }
+    else if(strcmp(argv[1], "fon9ring") == 0) {
+        fon9::InitLogWriteToFile("/tmp/fon9ring-latency.txt", fon9::TimeChecker::TimeScale::No, 0, 0);
+        fon9::LogRingArgs args;
+        args.RingSize_ = 1024 * 1024 * 4;
+        args.FullPolicy_ = fon9::LogRingFullPolicy::Block;
+        fon9::LogRingStart(args);
+        auto fon9BenchmarkFn = [](int i, char const * const cstr) {
+           fon9_LOGR_INFO("[" __FILE__ ":", __func__, ":" fon9_CTXTOCSTR(__LINE__) "] ", "Logging ", cstr, i, 0, 'K', fon9::Decimal<int64_t, 6>(-42.42), ", for more info.");
+           };
+        run_benchmark_threads(fon9BenchmarkFn, "fon9_LOGR");
+        fon9::LogRingStop();
+    }
     else if(strcmp(argv[1], "fon9lf") == 0) {
         fon9::impl::MemBlockInit(fon9::kLogBlockNodeSize, 16, 1024); // mem usage: (lists) * (nodes) * 256(bytes)
         fon9::slistfd.Open("/tmp/fon9-slist.txt", fon9::FileMode::Append | fon9::FileMode::CreatePath);
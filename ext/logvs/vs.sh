@@ -13,6 +13,8 @@ echo ----------------------------------------------------------------------
 for i in {1..5}; do /usr/bin/time -v ./logvs fon9lf $*; done
 echo ----------------------------------------------------------------------
 for i in {1..5}; do /usr/bin/time -v ./logvs fon9 $*; done
+echo ----------------------------------------------------------------------
+for i in {1..5}; do /usr/bin/time -v ./logvs fon9ring $*; done
 echo ======================================================================
 #ls -l /tmp
 #tail /tmp/*txt /tmp/*log
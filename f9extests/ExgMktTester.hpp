@@ -9,6 +9,7 @@
 #include "fon9/TestTools.hpp"
 #include "fon9/RevPrint.hpp"
 #include "fon9/buffer/DcQueue.hpp"
+#include "fon9/PkReceiver.hpp"
 
 namespace f9extests {
 
@@ -96,6 +97,44 @@ unsigned long CheckExgMktFeederStep(const PkReceiverT& orig, const MktDataFile&
    return step;
 }
 
+/// 比較各種 CheckSum 計算方式(fon9::PkXorImpl)的效率, 並檢查結果是否與 orig 相同.
+/// 顯示每種方式的處理時間, 及相對於 PkXorImpl::Byte(每次處理 1 byte) 的加速倍數.
+template <class PkReceiverT>
+void ExgMktBenchCheckSum(const PkReceiverT& orig, const MktDataFile& mdf) {
+   const fon9::PkXorImpl saved = fon9::GetPkXorImpl();
+   const struct {
+      fon9::PkXorImpl   Impl_;
+      const char*       Name_;
+   } impls[] = {
+      {fon9::PkXorImpl::Byte,   "CheckSum.Byte"},
+      {fon9::PkXorImpl::Word64, "CheckSum.Word64"},
+      {fon9::PkXorImpl::Sse2,   "CheckSum.Sse2"},
+      {fon9::PkXorImpl::Avx2,   "CheckSum.Avx2"},
+   };
+   double tmByte = 0;
+   for (const auto& i : impls) {
+      if (fon9::SetPkXorImpl(i.Impl_) != i.Impl_) {
+         std::cout << i.Name_ << ": not supported." << std::endl;
+         continue;
+      }
+      std::unique_ptr<PkReceiverT> pkReceiver{new PkReceiverT};
+      fon9::DcQueueFixedMem        dcq{mdf.Buffer_, mdf.Size_};
+      fon9::StopWatch              stopWatch;
+      pkReceiver->FeedBuffer(dcq);
+      const double tm = stopWatch.StopTimer();
+      if (pkReceiver->ReceivedCount_ != orig.ReceivedCount_
+          || pkReceiver->ChkSumErrCount_ != orig.ChkSumErrCount_
+          || pkReceiver->DroppedBytes_ != orig.DroppedBytes_) {
+         std::cout << "[ERROR] " << i.Name_ << ": result not match." << std::endl;
+         abort();
+      }
+      if (tmByte == 0)
+         tmByte = tm;
+      stopWatch.PrintResultNoEOL(tm, i.Name_, orig.ReceivedCount_) << "|speedup=" << (tmByte / tm) << std::endl;
+   }
+   fon9::SetPkXorImpl(saved);
+}
+
 /// 測試 Parser 的速度及結果.
 /// - struct ParserT : public PkReceiverT, public fon9::fmkt::SymbTree;
 /// - 若 argv 有 "?SymbId" or "SymbId, 則顯示 SymbId 的最後成交及最後買賣報價.
@@ -6,6 +6,7 @@
 #include "f9twf/ExgMrRecover.hpp"
 #include "fon9/FileReadAll.hpp"
 #include "fon9/TsReceiver.hpp"
+#include "fon9/LatencyHist.hpp"
 #include "fon9/Log.hpp"
 
 namespace f9twf {
@@ -410,7 +411,10 @@ void ExgMcChannel::PkContOnReceived(const void* pk, unsigned pksz, SeqT seq) {
 void ExgMcChannel::DispatchMcMessage(ExgMcMessage& e) {
    assert(this->PkPendings_.IsLocked());
    assert(e.Pk_.GetChannelId() == this->ChannelId_);
-   this->ChannelMgr_->DispatchMcMessage(e);
+   {
+      fon9_LATENCY_SCOPE("TwfMc.Handler");
+      this->ChannelMgr_->DispatchMcMessage(e);
+   }
    this->NotifyConsumersLocked(e);
 }
 void ExgMcChannel::NotifyConsumersLocked(ExgMcMessage& e) {
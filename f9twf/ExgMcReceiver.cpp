@@ -1,6 +1,7 @@
 ﻿// \file f9twf/ExgMcReceiver.cpp
 // \author fonwinz@gmail.com
 #include "f9twf/ExgMcReceiver.hpp"
+#include "fon9/LatencyHist.hpp"
 
 namespace f9twf {
 using namespace fon9;
@@ -38,6 +39,7 @@ bool ExgMcReceiver::OnDevice_BeforeOpen(fon9::io::Device& dev, std::string& cfgs
 }
 io::RecvBufferSize ExgMcReceiver::OnDevice_Recv(io::Device& dev, DcQueue& rxbuf) {
    (void)dev;
+   fon9_LATENCY_ORIGIN_SCOPE("Md.RecvReady");
    this->FeedBuffer(rxbuf);
    return io::RecvBufferSize::Default;
 }
@@ -138,7 +138,7 @@ fon9::fmkt::SymbSP ExgMdSymbs::MakeSymb(const fon9::StrView& symbid) {
    assert(this->SymbMap_.IsLocked());
    return new ExgMdSymb(symbid, *this);
 }
-void ExgMdSymbs::OnAfterLoadFrom(Locker&& symbsLk) {
+void ExgMdSymbs::OnAfterLoadFrom(AllSymbsLocker&& symbsLk) {
    (void)symbsLk;
    this->Contracts_.OnSymbsReload();
 }
@@ -84,7 +84,7 @@ class f9twf_API ExgMdSymbs : public fon9::fmkt::MdSymbsT<ExgMdSymb> {
    using base = fon9::fmkt::MdSymbsT<ExgMdSymb>;
    ExgMdContracts Contracts_;
 
-   void OnAfterLoadFrom(Locker&& symbsLk) override;
+   void OnAfterLoadFrom(AllSymbsLocker&& symbsLk) override;
 
 public:
    ExgMdSymbs(std::string rtiPathFmt, bool isAddMarketSeq, bool isAddChannelSeq);
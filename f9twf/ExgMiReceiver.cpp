@@ -1,6 +1,7 @@
 ﻿// \file f9twf/ExgMiReceiver.cpp
 // \author fonwinz@gmail.com
 #include "f9twf/ExgMiSystemBase.hpp"
+#include "fon9/LatencyHist.hpp"
 
 namespace f9twf {
 
@@ -92,6 +93,7 @@ void ExgMiReceiver::OnDevice_CommonTimer(fon9::io::Device& dev, fon9::TimeStamp
 }
 fon9::io::RecvBufferSize ExgMiReceiver::OnDevice_Recv(fon9::io::Device& dev, fon9::DcQueue& rxbuf) {
    (void)dev;
+   fon9_LATENCY_ORIGIN_SCOPE("Md.RecvReady");
    this->FeedBuffer(rxbuf);
    return fon9::io::RecvBufferSize::Default;
 }
@@ -321,9 +321,10 @@ int main(int argc, char* argv[]) {
    fon9::AutoPrintTestInfo utinfo{"f9twf ExgMkt"};
 
    if (argc < 4) {
-      std::cout << "Usage: MarketDataFile ReadFrom ReadSize [Steps or ?SymbId]\n"
+      std::cout << "Usage: MarketDataFile ReadFrom ReadSize [Steps or ?SymbId or bench]\n"
          "ReadSize=0 for read to EOF.\n"
          "Steps=0 for test Rt(Match & BS) parsing.\n"
+         "Steps=bench to compare the speed of CheckSum implementations.\n"
          << std::endl;
       return 3;
    }
@@ -417,7 +418,9 @@ int main(int argc, char* argv[]) {
       }
    }
    if (argc >= 5) {
-      if (f9extests::CheckExgMktFeederStep(pkReceiver, mdf, argv[4]) == 0)
+      if (strcmp(argv[4], "bench") == 0)
+         f9extests::ExgMktBenchCheckSum(pkReceiver, mdf);
+      else if (f9extests::CheckExgMktFeederStep(pkReceiver, mdf, argv[4]) == 0)
          f9extests::ExgMktTestParser<RtParser>("Parse Match+BS", mdf, argc - 4, argv + 4, tmFull,
                                                fon9::FmtDef{7,8});
    }
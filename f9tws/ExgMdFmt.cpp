@@ -0,0 +1,57 @@
+﻿// \file f9tws/ExgMdFmt.cpp
+// \author fonwinz@gmail.com
+#include "f9tws/ExgMdFmt.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define f9tws_PRIQTY_SSE2
+fon9_BEFORE_INCLUDE_STD;
+#include <emmintrin.h>
+fon9_AFTER_INCLUDE_STD;
+#endif
+
+namespace f9tws {
+
+#ifdef f9tws_PRIQTY_SSE2
+/// 每個 64 bits lane 放入一組價量的 [PriV4_[1..4], Qty_[0..3]] 共 8 bytes(16 個 BCD 數字),
+/// 轉換後每個 32 bits lane 為一個 8 位數的整數: [PriLo8, Qty, PriLo8, Qty];
+static inline __m128i PackBcd8x4To(__m128i v) {
+   // 每個 byte: (hi * 10 + lo) = byte - hi * 6;
+   const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f));
+   v = _mm_sub_epi8(v, _mm_add_epi8(_mm_slli_epi16(hi, 1), _mm_slli_epi16(hi, 2)));
+   // 每個 16 bits: 低位址的 byte 為較高的 2 位數: lo * 100 + hi;
+   v = _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi16(0xff)), _mm_set1_epi16(100)),
+                     _mm_srli_epi16(v, 8));
+   // 每個 32 bits: lo * 10000 + hi;
+   return _mm_madd_epi16(v, _mm_set1_epi32((1 << 16) | 10000));
+}
+static inline void AssignDecoded(fon9::fmkt::PriQty& dst, const ExgMdPriQty& src, uint32_t priLo8, uint32_t qty) {
+   dst.Pri_.Assign<4>(static_cast<uint64_t>(src.PriV4_[0] & 0x0f) * 100000000u + priLo8);
+   dst.Qty_ = qty;
+}
+#endif
+
+f9tws_API void ExgMdPriQtyDecode(const ExgMdPriQty* pqs, unsigned count, fon9::fmkt::PriQty* dst) {
+#ifdef f9tws_PRIQTY_SSE2
+   static_assert(sizeof(ExgMdPriQty::PriV4_) == 5 && sizeof(ExgMdPriQty::Qty_) == 4, "");
+   uint32_t res[4];
+   for (; count >= 2; count -= 2) {
+      const __m128i v = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pqs[0].PriV4_ + 1)),
+                                           _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pqs[1].PriV4_ + 1)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(res), PackBcd8x4To(v));
+      AssignDecoded(dst[0], pqs[0], res[0], res[1]);
+      AssignDecoded(dst[1], pqs[1], res[2], res[3]);
+      pqs += 2;
+      dst += 2;
+   }
+   if (count) {
+      const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pqs->PriV4_ + 1));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(res), PackBcd8x4To(v));
+      AssignDecoded(*dst, *pqs, res[0], res[1]);
+   }
+#else
+   for (; count > 0; --count)
+      (pqs++)->AssignTo(*dst++);
+#endif
+}
+
+} // namespaces
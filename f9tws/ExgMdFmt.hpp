@@ -76,6 +76,12 @@ struct ExgMdTail {
 
 fon9_PACK_POP;
 
+/// 將 pqs 開始的 count 組價量, 轉成 dst[0..count).
+/// - 用於一次轉換整個封包的價量(成交 + 最多 5 檔買賣), 結果與逐一呼叫 ExgMdPriQty::AssignTo() 相同.
+/// - x86/x64 使用 SSE2, 每次轉換 2 組價量; 其他平台使用 ExgMdPriQty::AssignTo();
+/// - 與 PackBcdTo() 相同, 不檢查 Pack BCD 的內容是否正確.
+f9tws_API void ExgMdPriQtyDecode(const ExgMdPriQty* pqs, unsigned count, fon9::fmkt::PriQty* dst);
+
 //--------------------------------------------------------------------------//
 
 enum {
@@ -35,5 +35,11 @@ struct ExgMdFmt23v1 : public ExgMdFmtRtBase {
 };
 fon9_PACK_POP;
 
+/// 零股的數量為 12 位數, 使用 ExgMdOddPriQty::AssignTo() 逐一轉換.
+inline void ExgMdPriQtyDecode(const ExgMdOddPriQty* pqs, unsigned count, fon9::fmkt::PriQty* dst) {
+   for (; count > 0; --count)
+      (pqs++)->AssignTo(*dst++);
+}
+
 } // namespaces
 #endif//__f9tws_ExgMdFmt23_hpp__
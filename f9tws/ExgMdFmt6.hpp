@@ -84,6 +84,15 @@ inline const ExgMdPQ* AssignBS(DstPQ (&adst)[kBSCount], const ExgMdPQ* pqs, unsi
       memset(static_cast<void*>(pdst), 0, sizeof(*pdst) * (kBSCount - count));
    return pqs;
 }
+/// 將已轉換好的 src[0..count) 填入 adst, 其餘檔位清為 0;
+/// count 必須 <= kBSCount;
+template <class DstPQ, unsigned kBSCount>
+inline void CopyBS(DstPQ (&adst)[kBSCount], const DstPQ* src, unsigned count) {
+   assert(count <= kBSCount);
+   memcpy(static_cast<void*>(adst), src, sizeof(*src) * count);
+   if (count < kBSCount)
+      memset(static_cast<void*>(adst + count), 0, sizeof(*src) * (kBSCount - count));
+}
 
 } // namespaces
 #endif//__f9tws_ExgMdFmt6_hpp__
@@ -3,6 +3,7 @@
 #ifndef __f9tws_ExgMdFmt6Handler_hpp__
 #define __f9tws_ExgMdFmt6Handler_hpp__
 #include "f9tws/ExgMdSystem.hpp"
+#include "f9tws/ExgMdFmt6.hpp"
 
 namespace f9tws {
 
@@ -28,7 +29,27 @@ inline void FmtRt_PkContOnReceived(ExgMdHandlerPkCont& handler, ExgMdSymbs& symb
    handler.CheckLogLost(&mdfmt, seq);
    if (mdfmt.IsLastDealSent())
       return;
-   const auto  dealTime = mdfmt.Time_.ToDayTime();
+   // 在鎖定商品表之前, 先將封包內的價量全部轉換完畢, 縮短鎖定的時間.
+   // ExgMdPriQtyDecode() 在 ExgMdFmt.hpp(整股), ExgMdFmt23.hpp(零股);
+   enum : unsigned {
+      kBSCount = f9fmkt::SymbBSData::kBSCount,
+   };
+   const auto     dealTime = mdfmt.Time_.ToDayTime();
+   const bool     isCalc = ((mdfmt.StatusMask_ & 0x80) != 0);
+   const bool     hasDeal = ((mdfmt.ItemMask_ & 0x80) != 0);
+   const bool     hasBS = mdfmt.HasBS();
+   unsigned       buyCount = 0, sellCount = 0;
+   if (hasBS) {
+      if ((buyCount = static_cast<unsigned>((mdfmt.ItemMask_ & 0x70) >> 4)) > kBSCount)
+         buyCount = kBSCount;
+      if ((sellCount = static_cast<unsigned>((mdfmt.ItemMask_ & 0x0e) >> 1)) > kBSCount)
+         sellCount = kBSCount;
+   }
+   f9fmkt::PriQty       pqs[1 + kBSCount * 2];
+   const f9fmkt::PriQty *pqDeal = pqs, *pqBuys = pqs + hasDeal, *pqSells = pqBuys + buyCount;
+   ExgMdPriQtyDecode(mdfmt.PQs_, static_cast<unsigned>(hasDeal + buyCount + sellCount), pqs);
+   const f9fmkt::Qty    pkTotalQty = ((hasDeal && !isCalc) ? fon9::PackBcdTo<f9fmkt::Qty>(mdfmt.TotalQty_) : 0);
+
    auto        symblk = symbs.SymbMap_.Lock();
    auto        symb = fon9::static_pointer_cast<ExgMdSymb>(symbs.FetchSymb(symblk, ToStrView(mdfmt.StkNo_)));
 
@@ -46,9 +67,6 @@ inline void FmtRt_PkContOnReceived(ExgMdHandlerPkCont& handler, ExgMdSymbs& symb
              fon9::PackBcdTo<unsigned>(mdfmt.TotalQty_));
    }
 #endif
-   const bool  isCalc = ((mdfmt.StatusMask_ & 0x80) != 0);
-   const bool  hasDeal = ((mdfmt.ItemMask_ & 0x80) != 0);
-   const auto* mdPQs = mdfmt.PQs_;
    if (hasDeal) {
       symb->Deal_.Data_.Flags_ = (isCalc ? f9sv_DealFlag_Calculated : f9sv_DealFlag{});
       if (symb->Deal_.Data_.InfoTime_ != dealTime) {
@@ -58,12 +76,11 @@ inline void FmtRt_PkContOnReceived(ExgMdHandlerPkCont& handler, ExgMdSymbs& symb
    #ifdef DEBUG_FMTRT
       if (kDebugPrint) {
          printf("Deal=%u*%u/",
-                static_cast<unsigned>(fon9::PackBcdTo<uint64_t>(mdPQs->PriV4_)),
-                fon9::PackBcdTo<unsigned>(mdPQs->Qty_));
+                static_cast<unsigned>(pqDeal->Pri_.GetOrigValue()),
+                static_cast<unsigned>(pqDeal->Qty_));
       }
    #endif
-      mdPQs->AssignTo(symb->Deal_.Data_.Deal_);
-      ++mdPQs;
+      symb->Deal_.Data_.Deal_ = *pqDeal;
       // mdfmt.TotalQty_ 包含此次成交, 試算階段 DealQty = TotalQty, 所以不更新 TotalQty.
       if (!isCalc) {
          // 若有「暫緩撮合」, 則: DealQty=0, 並提供「瞬間價格趨勢」.
@@ -71,7 +88,6 @@ inline void FmtRt_PkContOnReceived(ExgMdHandlerPkCont& handler, ExgMdSymbs& symb
          // 訂閱者如果有回補成交明細, 則會收到此訊息(DealQty=0), 處理時要注意。
          if (symb->Deal_.Data_.Deal_.Qty_ > 0)
             symb->CheckOHL(symb->Deal_.Data_.Deal_.Pri_, dealTime);
-         const f9fmkt::Qty pkTotalQty = fon9::PackBcdTo<f9fmkt::Qty>(mdfmt.TotalQty_);
          if (symb->Deal_.Data_.TotalQty_ + symb->Deal_.Data_.Deal_.Qty_ != pkTotalQty)
             symb->Deal_.Data_.Flags_ |= f9sv_DealFlag_TotalQtyLost;
          symb->Deal_.Data_.TotalQty_ = pkTotalQty;
@@ -112,13 +128,13 @@ inline void FmtRt_PkContOnReceived(ExgMdHandlerPkCont& handler, ExgMdSymbs& symb
    fon9::RevBufferList  rts{pksz};
    f9sv_RtsPackType     rtsPackType;
    f9sv_MdRtsKind       pkKind;
-   if (mdfmt.HasBS()) {
+   if (hasBS) {
       symb->BS_.Data_.InfoTime_ = dealTime;
       symb->BS_.Data_.Flags_ = (isCalc ? f9sv_BSFlag_Calculated : f9sv_BSFlag{});
       symb->BS_.Data_.Flags_ |= (f9sv_BSFlag_OrderBuy | f9sv_BSFlag_OrderSell);
-      // AssignBS() 在 ExgMdFmt6.hpp
-      mdPQs = AssignBS(symb->BS_.Data_.Buys_, mdPQs, static_cast<unsigned>((mdfmt.ItemMask_ & 0x70) >> 4));
-      mdPQs = AssignBS(symb->BS_.Data_.Sells_, mdPQs, static_cast<unsigned>((mdfmt.ItemMask_ & 0x0e) >> 1));
+      // CopyBS() 在 ExgMdFmt6.hpp
+      CopyBS(symb->BS_.Data_.Buys_, pqBuys, buyCount);
+      CopyBS(symb->BS_.Data_.Sells_, pqSells, sellCount);
 
       static_assert(f9sv_BSLmtFlag_UpLmtBuy == 0x20, "");
       static_assert(f9sv_BSLmtFlag_DnLmtBuy == 0x10, "");
@@ -3,6 +3,7 @@
 #include "f9tws/ExgMdReceiverSession.hpp"
 #include "fon9/io/Device.hpp"
 #include "fon9/TsAppend.hpp"
+#include "fon9/LatencyHist.hpp"
 
 namespace f9tws {
 using namespace fon9;
@@ -51,6 +52,8 @@ bool ExgMdReceiverSession::OnDevice_BeforeOpen(io::Device& dev, std::string& cfg
 }
 io::RecvBufferSize ExgMdReceiverSession::OnDevice_Recv(io::Device& dev, DcQueue& rxbuf) {
    (void)dev;
+   // 只在行情接收端設定延遲起點, 避免 rc/FIX 等一般連線的請求, 污染 TickToPublish/TickToSend.
+   fon9_LATENCY_ORIGIN_SCOPE("Md.RecvReady");
    this->FeedBuffer(rxbuf);
    return io::RecvBufferSize::Default;
 }
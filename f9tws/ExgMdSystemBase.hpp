@@ -5,6 +5,7 @@
 #include "f9tws/ExgMdFmt.hpp"
 #include "fon9/PkCont.hpp"
 #include "fon9/fmkt/MdSystem.hpp"
+#include "fon9/LatencyHist.hpp"
 
 namespace f9tws {
 
@@ -59,8 +60,10 @@ public:
 
    /// Session 收到封包後, 丟到這裡分派給 handler 處理.
    void OnPkReceived(const ExgMdHead& pk, unsigned pksz) {
-      if (ExgMdHandler* handler = this->MdHandlers_.Get(pk).get())
+      if (ExgMdHandler* handler = this->MdHandlers_.Get(pk).get()) {
+         fon9_LATENCY_SCOPE("TwsMd.Handler");
          handler->OnPkReceived(pk, pksz);
+      }
    }
 };
 using ExgMdSystemBaseSP = fon9::intrusive_ptr<ExgMdSystemBase>;
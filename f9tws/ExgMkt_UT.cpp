@@ -7,6 +7,8 @@
 #include "f9tws/ExgMdPkReceiver.hpp"
 #include "f9tws/ExgMdFmt6.hpp"
 #include "f9extests/ExgMktTester.hpp"
+#include "fon9/fmkt/SymbTreeSharded.hpp"
+#include "fon9/PkReplayer.hpp"
 
 struct TwsPkReceiver : public f9tws::ExgMdPkReceiver {
    fon9_NON_COPY_NON_MOVE(TwsPkReceiver);
@@ -57,21 +59,31 @@ struct Fmt6Parser : public TwsPkReceiver, public fon9::fmkt::MdSymbTree {
    }
    bool OnPkReceived(const void* pkptr, unsigned pksz) override {
       basePkReceiver::OnPkReceived(pkptr, pksz);
+      const f9tws::ExgMdFmt6v4* fmt6 = GetFmt6(pkptr);
+      if (fmt6 == nullptr)
+         return true;
+      fon9::StrView     stkno{ToStrView(fmt6->StkNo_)};
+      SymbMap::Locker   symbs{this->SymbMap_};
+      Apply(*static_cast<f9extests::SymbIn*>(this->FetchSymb(symbs, stkno).get()), *fmt6);
+      return true;
+   }
+   /// 若 pkptr 不是需要處理的 Fmt6/17, 則返回 nullptr;
+   static const f9tws::ExgMdFmt6v4* GetFmt6(const void* pkptr) {
       const f9tws::ExgMdHead& pk = *reinterpret_cast<const f9tws::ExgMdHead*>(pkptr);
       auto fmtNo = pk.GetFmtNo();
       if (fmtNo != 6 && fmtNo != 17)
-         return true;
+         return nullptr;
       const f9tws::ExgMdFmt6v4& fmt6 = *static_cast<const f9tws::ExgMdFmt6v4*>(&pk);
+      if (fon9_UNLIKELY(fon9::PackBcdTo<unsigned>(fmt6.Time_.HH_) == 99)) // 股票代號"000000"且撮合時間"999999999999",
+         return nullptr;                                                 // 表示普通股競價交易末筆即時行情資料已送出.
+      return &fmt6;
+   }
+   static void Apply(f9extests::SymbIn& symb, const f9tws::ExgMdFmt6v4& fmt6) {
       const f9tws::ExgMdPriQty* pqs  = fmt6.PQs_;
       unsigned                  tmHH = fon9::PackBcdTo<unsigned>(fmt6.Time_.HH_);
-      if (fon9_UNLIKELY(tmHH == 99)) // 股票代號"000000"且撮合時間"999999999999",
-         return true;                // 表示普通股競價交易末筆即時行情資料已送出.
       uint64_t tmu6 = (((tmHH * 60) + fon9::PackBcdTo<unsigned>(fmt6.Time_.MM_)) * 60
                        + fon9::PackBcdTo<unsigned>(fmt6.Time_.SS_));
       tmu6 = (tmu6 * 1000000) + fon9::PackBcdTo<unsigned>(fmt6.Time_.U6_);
-      fon9::StrView        stkno{ToStrView(fmt6.StkNo_)};
-      SymbMap::Locker      symbs{this->SymbMap_};
-      f9extests::SymbIn&   symb = *static_cast<f9extests::SymbIn*>(this->FetchSymb(symbs, stkno).get());
       if (fmt6.ItemMask_ & 0x80) {
          symb.Deal_.Data_.InfoTime_.Assign<6>(tmu6);
          symb.Deal_.Data_.TotalQty_ = fon9::PackBcdTo<fon9::fmkt::Qty>(fmt6.TotalQty_);
@@ -83,7 +95,6 @@ struct Fmt6Parser : public TwsPkReceiver, public fon9::fmkt::MdSymbTree {
          pqs = AssignBS(symb.BS_.Data_.Buys_, pqs, (fmt6.ItemMask_ & 0x70) >> 4);
          pqs = AssignBS(symb.BS_.Data_.Sells_, pqs, (fmt6.ItemMask_ & 0x0e) >> 1);
       }
-      return true;
    }
    static const f9tws::ExgMdPriQty* AssignBS(fon9::fmkt::PriQty* dst, const f9tws::ExgMdPriQty* pqs, int count) {
       if (count > fon9::fmkt::SymbBSData::kBSCount)
@@ -99,13 +110,258 @@ struct Fmt6Parser : public TwsPkReceiver, public fon9::fmkt::MdSymbTree {
    }
 };
 
+/// 先將一批封包(kBatchSize)的價量, 使用 ExgMdPriQtyDecode() 轉換完畢, 再一次鎖定商品表填入.
+/// 用來與 Fmt6Parser(每個封包鎖定一次, 逐欄位轉換) 比較.
+struct Fmt6BatchParser : public TwsPkReceiver, public fon9::fmkt::MdSymbTree {
+   fon9_NON_COPY_NON_MOVE(Fmt6BatchParser);
+   using basePkReceiver = TwsPkReceiver;
+   using baseTree = fon9::fmkt::MdSymbTree;
+   enum : unsigned {
+      kBatchSize = 64,
+      kBSCount = fon9::fmkt::SymbBSData::kBSCount,
+   };
+   struct Decoded {
+      f9tws::StkNo         StkNo_;
+      fon9::byte           ItemMask_;
+      uint8_t              BuyCount_;
+      uint8_t              SellCount_;
+      uint64_t             Tmu6_;
+      fon9::fmkt::Qty      TotalQty_;
+      fon9::fmkt::PriQty   PQs_[1 + kBSCount * 2];
+   };
+   Decoded  Pending_[kBatchSize];
+   unsigned PendingCount_{0};
+
+   Fmt6BatchParser() : baseTree{fon9::seed::LayoutSP{}} {
+   }
+   fon9::fmkt::SymbSP MakeSymb(const fon9::StrView& symbid) override {
+      return new f9extests::SymbIn{symbid};
+   }
+   size_t GetParsedCount() const {
+      return this->FmtCount_[6] + this->FmtCount_[17];
+   }
+   void PrintInfo() {
+   }
+   bool FeedBuffer(fon9::DcQueue& rxbuf) {
+      const bool retval = basePkReceiver::FeedBuffer(rxbuf);
+      this->Flush();
+      return retval;
+   }
+   bool OnPkReceived(const void* pkptr, unsigned pksz) override {
+      basePkReceiver::OnPkReceived(pkptr, pksz);
+      const f9tws::ExgMdHead& pk = *reinterpret_cast<const f9tws::ExgMdHead*>(pkptr);
+      auto fmtNo = pk.GetFmtNo();
+      if (fmtNo != 6 && fmtNo != 17)
+         return true;
+      const f9tws::ExgMdFmt6v4& fmt6 = *static_cast<const f9tws::ExgMdFmt6v4*>(&pk);
+      unsigned                  tmHH = fon9::PackBcdTo<unsigned>(fmt6.Time_.HH_);
+      if (fon9_UNLIKELY(tmHH == 99))
+         return true;
+      Decoded& dst = this->Pending_[this->PendingCount_];
+      dst.Tmu6_ = (((tmHH * 60) + fon9::PackBcdTo<unsigned>(fmt6.Time_.MM_)) * 60
+                   + fon9::PackBcdTo<unsigned>(fmt6.Time_.SS_));
+      dst.Tmu6_ = (dst.Tmu6_ * 1000000) + fon9::PackBcdTo<unsigned>(fmt6.Time_.U6_);
+      dst.StkNo_ = fmt6.StkNo_;
+      dst.ItemMask_ = fmt6.ItemMask_;
+      dst.BuyCount_ = dst.SellCount_ = 0;
+      if (fmt6.HasBS()) {
+         dst.BuyCount_ = static_cast<uint8_t>(std::min(static_cast<unsigned>((fmt6.ItemMask_ & 0x70) >> 4), unsigned{kBSCount}));
+         dst.SellCount_ = static_cast<uint8_t>(std::min(static_cast<unsigned>((fmt6.ItemMask_ & 0x0e) >> 1), unsigned{kBSCount}));
+      }
+      const unsigned hasDeal = ((fmt6.ItemMask_ & 0x80) ? 1u : 0u);
+      dst.TotalQty_ = (hasDeal ? fon9::PackBcdTo<fon9::fmkt::Qty>(fmt6.TotalQty_) : 0);
+      f9tws::ExgMdPriQtyDecode(fmt6.PQs_, hasDeal + dst.BuyCount_ + dst.SellCount_, dst.PQs_);
+      if (++this->PendingCount_ >= kBatchSize)
+         this->Flush();
+      return true;
+   }
+   void Flush() {
+      if (this->PendingCount_ == 0)
+         return;
+      SymbMap::Locker   symbs{this->SymbMap_};
+      for (unsigned L = 0; L < this->PendingCount_; ++L) {
+         const Decoded&       src = this->Pending_[L];
+         f9extests::SymbIn&   symb = *static_cast<f9extests::SymbIn*>(this->FetchSymb(symbs, ToStrView(src.StkNo_)).get());
+         const auto*          pqs = src.PQs_;
+         if (src.ItemMask_ & 0x80) {
+            symb.Deal_.Data_.InfoTime_.Assign<6>(src.Tmu6_);
+            symb.Deal_.Data_.TotalQty_ = src.TotalQty_;
+            symb.Deal_.Data_.Deal_ = *pqs++;
+         }
+         if ((src.ItemMask_ & 0x7e) || (src.ItemMask_ & 1) == 0) {
+            symb.BS_.Data_.InfoTime_.Assign<6>(src.Tmu6_);
+            f9tws::CopyBS(symb.BS_.Data_.Buys_, pqs, src.BuyCount_);
+            f9tws::CopyBS(symb.BS_.Data_.Sells_, pqs + src.BuyCount_, src.SellCount_);
+         }
+      }
+      this->PendingCount_ = 0;
+   }
+};
+
+/// 檢查 ExgMdPriQtyDecode() 的結果, 是否與 ExgMdPriQty::AssignTo() 相同, 並比較兩者的速度.
+struct PriQtyDecodeChecker : public TwsPkReceiver {
+   fon9_NON_COPY_NON_MOVE(PriQtyDecodeChecker);
+   using base = TwsPkReceiver;
+   /// 0:檢查結果; 1:僅使用 ExgMdPriQtyDecode(); 2:僅使用 AssignTo();
+   const int   Mode_;
+   uint64_t    PQCount_{0};
+   uint64_t    ErrCount_{0};
+   PriQtyDecodeChecker(int mode) : Mode_{mode} {
+   }
+   bool OnPkReceived(const void* pkptr, unsigned pksz) override {
+      base::OnPkReceived(pkptr, pksz);
+      const f9tws::ExgMdHead& pk = *reinterpret_cast<const f9tws::ExgMdHead*>(pkptr);
+      auto fmtNo = pk.GetFmtNo();
+      if (fmtNo != 6 && fmtNo != 17)
+         return true;
+      const f9tws::ExgMdFmt6v4& fmt6 = *static_cast<const f9tws::ExgMdFmt6v4*>(&pk);
+      const auto     count = static_cast<unsigned>((pksz - sizeof(fmt6) + sizeof(fmt6.PQs_)) / sizeof(f9tws::ExgMdPriQty));
+      const unsigned n = std::min(count, 16u);
+      fon9::fmkt::PriQty pqsSimd[16], pqsOrig[16];
+      if (this->Mode_ != 2)
+         f9tws::ExgMdPriQtyDecode(fmt6.PQs_, n, pqsSimd);
+      if (this->Mode_ != 1) {
+         for (unsigned L = 0; L < n; ++L)
+            fmt6.PQs_[L].AssignTo(pqsOrig[L]);
+      }
+      if (this->Mode_ == 0) {
+         for (unsigned L = 0; L < n; ++L) {
+            if (pqsOrig[L].Pri_ != pqsSimd[L].Pri_ || pqsOrig[L].Qty_ != pqsSimd[L].Qty_)
+               ++this->ErrCount_;
+         }
+      }
+      this->PQCount_ += n;
+      return true;
+   }
+};
+//--------------------------------------------------------------------------//
+
+/// 使用 fon9::PkReplayer 多 thread 播放行情檔:
+/// - sequencer: 統計各 FmtNo 的序號(與 TwsPkReceiver 相同), 將 Fmt6/17 依股票代號分派給 shard;
+/// - shard: 使用與 Fmt6Parser 相同的規則, 更新 MdSymbTreeSharded 的商品.
+struct Fmt6Replayer : public fon9::PkReplayer, public fon9::fmkt::MdSymbTreeSharded {
+   fon9_NON_COPY_NON_MOVE(Fmt6Replayer);
+   using baseTree = fon9::fmkt::MdSymbTreeSharded;
+   /// 提供 GetPkSize(), 及在 sequencer 統計序號.
+   TwsPkReceiver  Framer_;
+
+   Fmt6Replayer() : PkReplayer{sizeof(f9tws::ExgMdHead)}, baseTree{fon9::seed::LayoutSP{}} {
+   }
+   fon9::fmkt::SymbSP MakeSymb(const fon9::StrView& symbid) override {
+      return new f9extests::SymbIn{symbid};
+   }
+   unsigned OnReplayGetPkSize(const void* pkptr) override {
+      return this->Framer_.GetPkSize(pkptr);
+   }
+   void OnReplaySequence(const fon9::PkReplayPk& pk) override {
+      this->Framer_.OnPkReceived(pk.Pk_, pk.PkSize_);
+      if (const f9tws::ExgMdFmt6v4* fmt6 = Fmt6Parser::GetFmt6(pk.Pk_))
+         this->Dispatch(pk, std::hash<fon9::StrView>{}(ToStrView(fmt6->StkNo_)));
+   }
+   void OnReplayPacket(unsigned shardIdx, const fon9::PkReplayPk& pk) override {
+      (void)shardIdx;
+      const f9tws::ExgMdFmt6v4& fmt6 = *static_cast<const f9tws::ExgMdFmt6v4*>(pk.Pk_);
+      const fon9::StrView       stkno{ToStrView(fmt6.StkNo_)};
+      Locker                    symbs = this->LockShard(stkno);
+      Fmt6Parser::Apply(*static_cast<f9extests::SymbIn*>(this->FetchSymb(symbs, stkno).get()), fmt6);
+   }
+};
+static bool IsSamePQs(const fon9::fmkt::PriQty* a, const fon9::fmkt::PriQty* b, unsigned count) {
+   for (unsigned L = 0; L < count; ++L) {
+      if (a[L].Pri_ != b[L].Pri_ || a[L].Qty_ != b[L].Qty_)
+         return false;
+   }
+   return true;
+}
+static bool IsSameSymbState(const f9extests::SymbIn& a, const f9extests::SymbIn& b) {
+   const auto& da = a.Deal_.Data_;
+   const auto& db = b.Deal_.Data_;
+   const auto& ba = a.BS_.Data_;
+   const auto& bb = b.BS_.Data_;
+   return da.InfoTime_ == db.InfoTime_ && da.TotalQty_ == db.TotalQty_
+      && IsSamePQs(&da.Deal_, &db.Deal_, 1)
+      && ba.InfoTime_ == bb.InfoTime_
+      && IsSamePQs(ba.Buys_, bb.Buys_, fon9::fmkt::SymbBSData::kBSCount)
+      && IsSamePQs(ba.Sells_, bb.Sells_, fon9::fmkt::SymbBSData::kBSCount);
+}
+/// 使用 Fmt6Replayer 播放行情檔, 每個商品的最後狀態、各 FmtNo 的序號統計, 必須與單一 thread 的解析相同.
+void TestPkReplayer(const f9extests::MktDataFile& mdf, const TwsPkReceiver& orig, char* argv[]) {
+   std::unique_ptr<Fmt6Parser> expected{new Fmt6Parser};
+   fon9::DcQueueFixedMem       dcq{mdf.Buffer_, mdf.Size_};
+   expected->FeedBuffer(dcq);
+   fon9::PkReplayArgs args;
+   args.From_ = f9extests::StrToVal(argv[2]);
+   if (const auto rdsz = f9extests::StrToVal(argv[3]))
+      args.To_ = args.From_ + rdsz;
+   for (unsigned shardCount : {0u, 1u, 2u, 4u}) {
+      std::cout << "[TEST ] PkReplayer.Fmt6|shards=" << shardCount << std::flush;
+      args.ShardCount_ = shardCount;
+      std::unique_ptr<Fmt6Replayer> replayer{new Fmt6Replayer};
+      fon9::StopWatch               stopWatch;
+      auto                          res = replayer->Run(argv[1], args);
+      const double                  secs = stopWatch.StopTimer();
+      if (!res) {
+         std::cout << "|err=" << fon9::RevPrintTo<std::string>(res) << "\r[ERROR]" << std::endl;
+         abort();
+      }
+      const TwsPkReceiver& framer = replayer->Framer_;
+      size_t   symbCount = 0, errCount = 0;
+      {
+         Fmt6Replayer::AllLocker symbs{*replayer};
+         symbCount = symbs.size();
+         auto expectedSymbs = expected->SymbMap_.Lock();
+         for (const auto& isymb : *expectedSymbs) {
+            const auto& symb = *static_cast<const f9extests::SymbIn*>(&fon9::fmkt::GetSymbValue(isymb));
+            const auto  stkno = ToStrView(symb.SymbId_);
+            auto        ifind = symbs[Fmt6Replayer::GetShardIndex(stkno)]->find(stkno);
+            if (ifind == symbs[Fmt6Replayer::GetShardIndex(stkno)]->end()
+                || !IsSameSymbState(symb, *static_cast<const f9extests::SymbIn*>(&fon9::fmkt::GetSymbValue(*ifind))))
+               ++errCount;
+         }
+         if (symbCount != expectedSymbs->size())
+            ++errCount;
+      }
+      std::cout << "|pk=" << res.GetResult() << "|symbs=" << symbCount << "|secs=" << secs;
+      if (errCount || res.GetResult() != orig.ReceivedCount_
+          || memcmp(framer.FmtCount_, orig.FmtCount_, sizeof(orig.FmtCount_)) != 0
+          || memcmp(framer.LastSeq_, orig.LastSeq_, sizeof(orig.LastSeq_)) != 0
+          || memcmp(framer.SeqMisCount_, orig.SeqMisCount_, sizeof(orig.SeqMisCount_)) != 0) {
+         std::cout << "|errCount=" << errCount << "\r[ERROR]" << std::endl;
+         abort();
+      }
+      std::cout << "\r[OK   ]" << std::endl;
+   }
+}
+
+void TestPriQtyDecode(const f9extests::MktDataFile& mdf) {
+   std::cout << "[TEST ] ExgMdPriQtyDecode()" << std::flush;
+   PriQtyDecodeChecker     checker{0};
+   fon9::DcQueueFixedMem   dcq{mdf.Buffer_, mdf.Size_};
+   checker.FeedBuffer(dcq);
+   std::cout << "|PQCount=" << checker.PQCount_ << "|ErrCount=" << checker.ErrCount_;
+   if (checker.ErrCount_) {
+      std::cout << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+   // 包含解析封包框架的時間.
+   for (int mode = 1; mode <= 2; ++mode) {
+      PriQtyDecodeChecker  bench{mode};
+      fon9::StopWatch      stopWatch;
+      dcq.Reset(mdf.Buffer_, mdf.Buffer_ + mdf.Size_);
+      bench.FeedBuffer(dcq);
+      stopWatch.PrintResult(mode == 1 ? "PriQty.Decode(SIMD)" : "PriQty.AssignTo", bench.PQCount_);
+   }
+}
+
 int main(int argc, char* argv[]) {
    fon9::AutoPrintTestInfo utinfo{"f9tws ExgMkt"};
 
    if (argc < 4) {
-      std::cout << "Usage: MarketDataFile ReadFrom ReadSize [Steps or ?SymbId]\n"
+      std::cout << "Usage: MarketDataFile ReadFrom ReadSize [Steps or ?SymbId or bench]\n"
          "ReadSize=0 for read to EOF.\n"
          "Steps=0 or '?SymbId' for test Match/BS(Fmt6+17) parsing.\n"
+         "Steps=bench to compare the speed of CheckSum implementations.\n"
          << std::endl;
       return 3;
    }
@@ -126,7 +382,13 @@ int main(int argc, char* argv[]) {
       }
    }
    if (argc >= 5) {
-      if (f9extests::CheckExgMktFeederStep(pkReceiver, mdf, argv[4]) == 0)
+      if (strcmp(argv[4], "bench") == 0)
+         f9extests::ExgMktBenchCheckSum(pkReceiver, mdf);
+      else if (f9extests::CheckExgMktFeederStep(pkReceiver, mdf, argv[4]) == 0) {
+         TestPriQtyDecode(mdf);
+         TestPkReplayer(mdf, pkReceiver, argv);
+         f9extests::ExgMktTestParser<Fmt6BatchParser>("Parse Fmt6+17(Batch)", mdf, 0, nullptr, tmFull);
          f9extests::ExgMktTestParser<Fmt6Parser>("Parse Fmt6+17", mdf, argc - 4, argv + 4, tmFull);
+      }
    }
 }
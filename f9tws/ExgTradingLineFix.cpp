@@ -60,9 +60,12 @@ ExgTradingLineFix::ExgTradingLineFix(f9fix::IoFixManager&         mgr,
                                      f9fix::IoFixSenderSP&&       fixSender)
    : base(mgr, fixcfg)
    , RawAppendNo_{static_cast<unsigned>(fon9::UtcNow().GetDecPart() / 1000)}
-   , FlowCounter_{lineargs.FcArgs_}
    , LineArgs_(lineargs)
    , FixSender_{std::move(fixSender)} {
+   this->FlowCounter_.Resize(lineargs.FcArgs_);
+}
+bool ExgTradingLineFix::IsConcurrentSendable() const {
+   return true;
 }
 void ExgTradingLineFix::OnFixSessionConnected() {
    base::OnFixSessionConnected();
@@ -47,7 +47,11 @@ class f9tws_API ExgTradingLineFix : public f9fix::IoFixSession, public f9fmkt::T
    unsigned RawAppendNo_;
 
 protected:
-   fon9::FlowCounter FlowCounter_;
+   /// IsConcurrentSendable() 返回 true, SendRequest() 可能同時被多個 thread 呼叫:
+   /// - 衍生者應使用 FlowCounter_.Fetch(now) 在同一次鎖定中檢查並使用流量.
+   /// - 下單序號(MsgSeqNum) 由 FixSender_->Send() 在 FixSender 的鎖定中處理.
+   /// - 若衍生者在 SendRequest() 使用其他未保護的狀態, 則應覆寫 IsConcurrentSendable() 返回 false.
+   fon9::FlowCounterThreadSafe FlowCounter_;
 
    /// 連線成功, 在此主動送出 Logon 訊息.
    void OnFixSessionConnected() override;
@@ -63,6 +67,10 @@ public:
                      const f9fix::FixConfig&      fixcfg,
                      const ExgTradingLineFixArgs& lineargs,
                      f9fix::IoFixSenderSP&&       fixSender);
+
+   /// 返回 true: 流量管制(FlowCounter_) 及 FixSender_ 都有鎖定保護,
+   /// 所以可放入 TradingLineManager 的「快速線路表」, 下單時不用鎖住「可用線路表」.
+   bool IsConcurrentSendable() const override;
 };
 fon9_WARN_POP;
 
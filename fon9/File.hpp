@@ -189,6 +189,9 @@ public:
    /// 取得檔案最後異動時間.
    TimeStamp GetLastModifyTime() const;
 
+   Fdr::fdr_t GetFD() const {
+      return this->Fdr_.GetFD();
+   }
    Fdr::fdr_t ReleaseFD() {
       return this->Fdr_.ReleaseFD();
    }
@@ -0,0 +1,63 @@
+﻿// \file fon9/FileMap.cpp
+// \author fonwinz@gmail.com
+#include "fon9/FileMap.hpp"
+#ifndef fon9_WINDOWS
+#include <sys/mman.h>
+#endif
+
+namespace fon9 {
+
+FileMap::~FileMap() {
+   this->Close();
+}
+File::Result FileMap::Open(std::string fname) {
+   std::lock_guard<std::mutex> lk{this->Mutex_};
+   if (this->Storage_.IsOpened())
+      return File::Result{std::errc::already_connected};
+#ifdef fon9_WINDOWS
+   (void)fname;
+   return File::Result{std::errc::function_not_supported};
+#else
+   return this->Storage_.Open(std::move(fname), FileMode::Read);
+#endif
+}
+void FileMap::Close() {
+   std::lock_guard<std::mutex> lk{this->Mutex_};
+#ifndef fon9_WINDOWS
+   for (byte* v : this->Views_) {
+      if (v)
+         munmap(v, kViewSize);
+   }
+#endif
+   this->Views_.clear();
+   this->Storage_.Close();
+}
+const byte* FileMap::Peek(PosType pos, SizeType& sz) {
+#ifdef fon9_WINDOWS
+   (void)pos; (void)sz;
+   return nullptr;
+#else
+   const size_t   vidx = static_cast<size_t>(pos / kViewSize);
+   const PosType  vofs = pos % kViewSize;
+   std::lock_guard<std::mutex> lk{this->Mutex_};
+   if (fon9_UNLIKELY(vidx >= this->Views_.size())) {
+      if (!this->Storage_.IsOpened())
+         return nullptr;
+      this->Views_.resize(vidx + 1);
+   }
+   byte* view = this->Views_[vidx];
+   if (fon9_UNLIKELY(view == nullptr)) {
+      // 映射範圍可以超過現在的檔案大小, 檔案成長後, 就可以讀到新增的內容.
+      void* pmap = mmap(nullptr, kViewSize, PROT_READ, MAP_SHARED,
+                        this->Storage_.GetFD(), static_cast<off_t>(vidx * kViewSize));
+      if (pmap == MAP_FAILED)
+         return nullptr;
+      madvise(pmap, kViewSize, MADV_SEQUENTIAL);
+      this->Views_[vidx] = view = static_cast<byte*>(pmap);
+   }
+   sz = kViewSize - vofs;
+   return view + vofs;
+#endif
+}
+
+} // namespaces
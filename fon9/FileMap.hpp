@@ -0,0 +1,53 @@
+﻿/// \file fon9/FileMap.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_FileMap_hpp__
+#define __fon9_FileMap_hpp__
+#include "fon9/File.hpp"
+#include <mutex>
+#include <vector>
+
+namespace fon9 {
+
+/// \ingroup Misc
+/// 唯讀的檔案記憶體映射(mmap), 用於大量循序讀取(例: 回補)時, 避免 read() 的系統呼叫及資料複製.
+/// - 檔案可能由其他物件持續寫入而成長, 所以依照 kViewSize 分段映射, 需要時才映射.
+///   - 已映射的區段, 在 Close() 或解構前不會解除映射, 所以 Peek() 取得的記憶體可以安全使用到 Close() 為止.
+/// - 僅能讀取「已寫入」的資料, 讀取超過檔案大小的位置, 結果無法預期(例: SIGBUS).
+/// - 若平台不支援, 則 Open() 返回 std::errc::function_not_supported, 使用者應改用 File::Read();
+/// - 注意: POSIX 的 fcntl() 檔案鎖定是 per process, 關閉同一檔案的任一 fd 都會解除該檔的鎖定,
+///   所以 FileMap 的生命週期, 應與原本開啟(並鎖定)該檔的物件相同.
+class fon9_API FileMap {
+   fon9_NON_COPY_NON_MOVE(FileMap);
+public:
+   using PosType = File::PosType;
+   using SizeType = File::SizeType;
+   enum : SizeType {
+      /// 每個映射區段的大小, 必須是 page size 的倍數.
+      kViewSize = 64 * 1024 * 1024,
+   };
+
+   FileMap() = default;
+   ~FileMap();
+
+   /// 使用 FileMode::Read 開啟 fname.
+   File::Result Open(std::string fname);
+   void Close();
+   bool IsOpened() const {
+      return this->Storage_.IsOpened();
+   }
+
+   /// 取得 pos 開始的連續記憶體, 最多到該映射區段結束.
+   /// \retval nullptr  尚未開啟, 或映射失敗.
+   /// \retval !nullptr 返回時 sz = 可用的連續資料量(不考慮檔案大小, 由呼叫端自行確保不超過已寫入的資料).
+   ///         映射區段在 Close() 之前不會解除, 所以呼叫端可以保留返回的位置重複使用.
+   const byte* Peek(PosType pos, SizeType& sz);
+
+private:
+   using Views = std::vector<byte*>;
+   std::mutex  Mutex_;
+   File        Storage_;
+   Views       Views_;
+};
+
+} // namespaces
+#endif//__fon9_FileMap_hpp__
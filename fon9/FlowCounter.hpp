@@ -126,6 +126,18 @@ public:
    TimeInterval Fetch() {
       return (this->IsNeedsLock_ ? Locker{*this}->Fetch() : TimeInterval{});
    }
+   TimeInterval Check(TimeStamp now) {
+      return (this->IsNeedsLock_ ? Locker{*this}->Check(now) : TimeInterval{});
+   }
+   /// 多個 thread 同時使用時, 應使用 Fetch() 在同一次鎖定中檢查並使用流量,
+   /// 不要分開呼叫 Check() 及 ForceUsed().
+   TimeInterval Fetch(TimeStamp now) {
+      return (this->IsNeedsLock_ ? Locker{*this}->Fetch(now) : TimeInterval{});
+   }
+   void ForceUsed(TimeStamp now) {
+      if (this->IsNeedsLock_)
+         Locker{*this}->ForceUsed(now);
+   }
 };
 fon9_WARN_POP;
 
@@ -259,5 +259,75 @@ void InnApf::StreamRW::Close() {
    if (StreamSP stream = std::move(this->Stream_))
       intrusive_ptr_release(&stream->Owner()); // add_ref 在 InnApf::KeyMapImpl::OpenStream();
 }
+//--------------------------------------------------------------------------//
+FileMap* InnApf::GetFileMap() {
+   std::call_once(this->FileMapOnce_, [this]() {
+      auto res = this->FileMap_.Open(this->InnFile_.GetOpenName());
+      if (!res)
+         fon9_LOG_WARN("InnApf.FileMap|fname=", this->InnFile_.GetOpenName(), '|', res);
+   });
+   return this->FileMap_.IsOpened() ? &this->FileMap_ : nullptr;
+}
+bool InnApf::StreamMapReader::Open(Stream& stream, SPosT endPos) {
+   this->Spans_.clear();
+   this->EndPos_ = this->SpanPos_ = 0;
+   this->SpanIdx_ = 0;
+   this->View_ = nullptr;
+   this->ViewPos_ = 0;
+   if ((this->FileMap_ = stream.Owner().GetFileMap()) == nullptr)
+      return false;
+   if (endPos > 0)
+      this->EndPos_ = stream.GetFileSpans(0, endPos, this->Spans_);
+   return true;
+}
+InnApf::SizeT InnApf::StreamMapReader::Peek(SPosT pos, const void*& pmem) {
+   if (pos >= this->EndPos_)
+      return 0;
+   // 通常是循序讀取, 或稍微倒退(例: 尾端不足一個封包, 下次重讀), 所以從上次的位置開始尋找.
+   while (pos < this->SpanPos_)
+      this->SpanPos_ -= this->Spans_[--this->SpanIdx_].Size_;
+   for (;;) {
+      const Stream::FileSpan& sp = this->Spans_[this->SpanIdx_];
+      if (pos < this->SpanPos_ + sp.Size_)
+         break;
+      this->SpanPos_ += sp.Size_;
+      ++this->SpanIdx_;
+   }
+   const Stream::FileSpan& sp = this->Spans_[this->SpanIdx_];
+   const SizeT          ofs = static_cast<SizeT>(pos - this->SpanPos_);
+   const File::PosType  fpos = sp.FilePos_ + ofs;
+   if (fon9_UNLIKELY(this->View_ == nullptr || fpos < this->ViewPos_ || fpos - this->ViewPos_ >= FileMap::kViewSize)) {
+      FileMap::SizeType mapsz;
+      const byte*       pmap = this->FileMap_->Peek(fpos, mapsz);
+      if (pmap == nullptr)
+         return 0;
+      // FileMap::Peek() 返回 [fpos, 區段結尾), 記錄區段的開始位置.
+      const FileMap::SizeType vofs = FileMap::kViewSize - mapsz;
+      this->View_ = pmap - vofs;
+      this->ViewPos_ = fpos - vofs;
+   }
+   const FileMap::SizeType vofs = static_cast<FileMap::SizeType>(fpos - this->ViewPos_);
+   const FileMap::SizeType mapsz = FileMap::kViewSize - vofs;
+   pmem = this->View_ + vofs;
+   const SizeT sz = sp.Size_ - ofs;
+   return sz < mapsz ? sz : static_cast<SizeT>(mapsz);
+}
+InnApf::SizeT InnApf::StreamMapReader::Read(SPosT pos, void* buf, SizeT bufsz) {
+   SizeT totsz = 0;
+   while (bufsz > 0) {
+      const void* pmem;
+      SizeT       sz = this->Peek(pos, pmem);
+      if (sz == 0)
+         break;
+      if (sz > bufsz)
+         sz = bufsz;
+      memcpy(buf, pmem, sz);
+      buf = reinterpret_cast<byte*>(buf) + sz;
+      bufsz -= sz;
+      pos += sz;
+      totsz += sz;
+   }
+   return totsz;
+}
 
 } // namespace fon9
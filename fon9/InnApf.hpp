@@ -3,6 +3,7 @@
 #ifndef __fon9_InnApf_hpp__
 #define __fon9_InnApf_hpp__
 #include "fon9/InnStream.hpp"
+#include "fon9/FileMap.hpp"
 #include "fon9/intrusive_ref_counter.hpp"
 #include "fon9/BitvFixedInt.hpp"
 #include "fon9/buffer/DcQueueList.hpp"
@@ -104,6 +105,9 @@ public: // 雖然為 public, 但一般不會直接使用到, 只是為了在 Inn
          return this->Saved_.Key_;
       }
       using base::Size;
+      using base::FileSpan;
+      using base::FileSpans;
+      using base::GetFileSpans;
 
       SizeT Read(SPosT pos, void* buf, SizeT bufsz) {
          return base::Read(pos, buf, bufsz);
@@ -210,6 +214,45 @@ public:
       }
    };
 
+   /// 使用 FileMap 直接讀取 Stream 的內容, 不需經過 Stream::Read() 的鎖定及複製.
+   /// - 適用於: 讀取範圍已確定(例: 回補到訂閱時的最後位置), 且需大量循序讀取.
+   /// - 非 thread safe, 通常由單一回補作業使用.
+   /// - 使用期間, 必須保持 stream 的存活(例: 持有 StreamSP).
+   class fon9_API StreamMapReader {
+      fon9_NON_COPY_NON_MOVE(StreamMapReader);
+      FileMap*    FileMap_{nullptr};
+      Stream::FileSpans Spans_;
+      SPosT       EndPos_{0};
+      /// Spans_[SpanIdx_] 在 stream 的開始位置.
+      SPosT       SpanPos_{0};
+      size_t      SpanIdx_{0};
+      /// 最近使用的映射區段: [ViewPos_, ViewPos_ + FileMap::kViewSize) 映射到 View_;
+      /// 循序讀取大多落在同一區段, 不用每次都經過 FileMap::Peek() 的鎖定.
+      const byte*    View_{nullptr};
+      File::PosType  ViewPos_{0};
+   public:
+      StreamMapReader() = default;
+
+      /// 載入 stream 的 [0, endPos) 在檔案中的位置.
+      /// \retval false 無法使用 FileMap(例: 平台不支援), 此時應改用 Stream::Read();
+      bool Open(Stream& stream, SPosT endPos);
+      bool IsReady() const {
+         return this->FileMap_ != nullptr;
+      }
+      /// 可讀取的範圍: [0, EndPos());
+      SPosT EndPos() const {
+         return this->EndPos_;
+      }
+      /// 取得 pos 開始的連續資料(最多到該 room 的結尾), 不複製.
+      /// \retval 0 pos >= EndPos(), 或映射失敗.
+      SizeT Peek(SPosT pos, const void*& pmem);
+      /// 從 pos 開始複製到 buf, 可跨越多個 rooms.
+      SizeT Read(SPosT pos, void* buf, SizeT bufsz);
+   };
+   /// 取得此 InnApf 檔案的唯讀記憶體映射, 首次呼叫時開啟.
+   /// \retval nullptr 無法映射(例: 平台不支援).
+   FileMap* GetFileMap();
+
 private:
    const char* ReadExHeader();
    void OnNewInnFile();
@@ -241,6 +284,9 @@ private:
    InnFileP    InnFile_;
    RoomPos     FreeRoomPos1st_; 
    InnStream   ExHeader_;
+   /// 必須在 InnFile_ 之後: 先關閉 FileMap_(及其 fd), 再關閉 InnFile_;
+   FileMap        FileMap_;
+   std::once_flag FileMapOnce_;
 
    void StartUpdateTimer() {
       this->UpdateTimer_.RunAfter(TimeInterval_Second(1));
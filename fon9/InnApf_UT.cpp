@@ -77,6 +77,31 @@ void TestInnStreamRead(fon9::InnApf::StreamRW& aprw, const std::string& resExpec
       << "\r[ERROR]" << std::endl;
    abort();
 }
+void TestInnStreamMapRead(fon9::InnApf::StreamRW& aprw, const std::string& resExpected) {
+   fon9::InnApf::StreamMapReader rd;
+   if (!rd.Open(*aprw.GetStream(), resExpected.size() + 1)) // 要求 endPos > stream size;
+      return; // 不支援 FileMap.
+   std::string rdin;
+   if (rd.EndPos() == resExpected.size()) {
+      // 使用 Peek() 逐一取得每個 room 的內容.
+      const void* pmem;
+      while (auto sz = rd.Peek(rdin.size(), pmem))
+         rdin.append(static_cast<const char*>(pmem), sz);
+      if (rdin == resExpected) {
+         // 從中間開始使用 Read() 讀取(可能跨越多個 rooms).
+         const auto from = resExpected.size() / 3;
+         rdin.resize(resExpected.size() - from);
+         if (rd.Read(from, &*rdin.begin(), rdin.size() + 1) == rdin.size()
+             && memcmp(rdin.c_str(), resExpected.c_str() + from, rdin.size()) == 0)
+            return;
+      }
+   }
+   std::cout << "|streamKey=" << aprw.GetKey().ToString()
+      << "|endPos=" << rd.EndPos() << "|expected=" << resExpected.size()
+      << "|err=MapRead not expected."
+      << "\r[ERROR]" << std::endl;
+   abort();
+}
 void TestInnStreamWrite(fon9::InnApf::StreamRW& aprw, const std::string& resExpected) {
    auto wrsz = aprw.Write(0, fon9::DcQueueFixedMem(resExpected));
    if (wrsz == resExpected.size()) {
@@ -192,6 +217,12 @@ void TestInnApf() {
       (void)ores;
       TestInnStreamRead(aprw, testData[idx]);
    });
+   std::cout << "[TEST ] MapRead(CheckAll):";
+   TestInnApfRW(kKeyCount, kKeyCount, fon9::FileMode::Read,
+                [&testData](unsigned idx, OpenResult ores, fon9::InnApf::StreamRW& aprw) {
+      (void)ores;
+      TestInnStreamMapRead(aprw, testData[idx]);
+   });
 }
 //--------------------------------------------------------------------------//
 void InnApf_Benchmark(const double   kTestSpan) {
@@ -273,6 +304,108 @@ void InnApf_Benchmark(const double   kTestSpan) {
    std::cout << fon9::AutoTimeUnit{stopWatch.StopTimer()} << "\r[OK   ]" << std::endl;
 }
 //--------------------------------------------------------------------------//
+// 模擬一整天的行情儲存檔(參考 fon9/fmkt/MdRtStreamInn.cpp), 比較回補時:
+// - 使用 Stream::Read() 每次讀入 4K;
+// - 使用 StreamMapReader::Peek() 直接取用映射的記憶體;
+// - 使用 StreamMapReader::Read() 每次複製 4K;
+// 的讀取速度.
+void InnApf_RecoverBenchmark(const size_t kDaySize) {
+   const size_t   kKeyCount = 100;
+   const size_t   kPkSize = 40;
+   std::cout << "Recover benchmark: "
+      << "|KeyCount=" << kKeyCount
+      << "|DaySize=" << (kDaySize / 1024 / 1024) << "MB"
+      << std::endl;
+   fon9::InnStream::OpenArgs  streamArgs{fon9::InnRoomType{}};
+   streamArgs.ExpectedRoomSize_[0] = 1024 * 2;
+   streamArgs.ExpectedRoomSize_[1] = 1024 * 4;
+   streamArgs.ExpectedRoomSize_[2] = 1024 * 8;
+   streamArgs.ExpectedRoomSize_[3] = 1024 * 16;
+   fon9::InnApf::OpenArgs     innArgs{kInnApfFileName};
+   fon9::InnApf::OpenResult   ores;
+   remove(kInnApfFileName);
+   fon9::InnApfSP apf = fon9::InnApf::Make(innArgs, streamArgs, ores);
+   CheckOpenResult(ores, OpenResult{0});
+
+   std::vector<fon9::InnApf::StreamRW> streams(kKeyCount);
+   fon9::NumOutBuf   nbuf;
+   for (size_t L = 0; L < kKeyCount; ++L) {
+      fon9::StrView keystr{fon9::ToStrRev(nbuf.end(), L), nbuf.end()};
+      CheckOpenResult(streams[L].Open(*apf, keystr, fon9::FileMode::CreatePath), OpenResult{0});
+   }
+   char pk[kPkSize];
+   for (size_t L = 0; L < kDaySize / kPkSize; ++L) {
+      memset(pk, static_cast<char>(L), sizeof(pk));
+      streams[L % kKeyCount].AppendBuffered(pk, sizeof(pk));
+   }
+   std::vector<fon9::InnApf::SizeT> sizes(kKeyCount);
+   for (size_t L = 0; L < kKeyCount; ++L)
+      sizes[L] = streams[L].Size(); // Flush;
+
+   auto runTest = [&](const char* name, std::function<uint64_t(fon9::InnApf::StreamRW&, fon9::InnApf::SizeT)> fnRead) {
+      std::cout << "[TEST ] " << name;
+      fon9::StopWatch stopWatch;
+      uint64_t chk = 0, totsz = 0;
+      for (size_t L = 0; L < kKeyCount; ++L) {
+         chk += fnRead(streams[L], sizes[L]);
+         totsz += sizes[L];
+      }
+      const double span = stopWatch.StopTimer();
+      std::cout << fon9::AutoTimeUnit{span}
+         << "|" << static_cast<uint64_t>(static_cast<double>(totsz) / span / 1024 / 1024) << " MB/s"
+         << "|chk=" << chk
+         << "\r[OK   ]" << std::endl;
+   };
+   runTest("Stream.Read(4K): ", [](fon9::InnApf::StreamRW& aprw, fon9::InnApf::SizeT endPos) {
+      char     rdbuf[4 * 1024];
+      uint64_t chk = 0;
+      for (fon9::InnApf::SPosT pos = 0; pos < endPos;) {
+         auto rdsz = aprw.Read(pos, rdbuf, sizeof(rdbuf));
+         if (rdsz == 0)
+            break;
+         for (size_t i = 0; i < rdsz; i += kPkSize)
+            chk += static_cast<fon9::byte>(rdbuf[i]);
+         pos += rdsz;
+      }
+      return chk;
+   });
+   runTest("MapReader.Peek:  ", [](fon9::InnApf::StreamRW& aprw, fon9::InnApf::SizeT endPos) {
+      fon9::InnApf::StreamMapReader rd;
+      uint64_t    chk = 0;
+      const void* pmem;
+      rd.Open(*aprw.GetStream(), endPos);
+      for (fon9::InnApf::SPosT pos = 0; pos < endPos;) {
+         auto rdsz = rd.Peek(pos, pmem);
+         if (rdsz == 0)
+            break;
+         // Peek() 不一定從封包開頭開始, 所以這裡的 chk 僅供參考.
+         for (size_t i = 0; i < rdsz; i += kPkSize)
+            chk += static_cast<const fon9::byte*>(pmem)[i];
+         pos += rdsz;
+      }
+      return chk;
+   });
+   runTest("MapReader.Read:  ", [](fon9::InnApf::StreamRW& aprw, fon9::InnApf::SizeT endPos) {
+      fon9::InnApf::StreamMapReader rd;
+      char     rdbuf[4 * 1024];
+      uint64_t chk = 0;
+      rd.Open(*aprw.GetStream(), endPos);
+      for (fon9::InnApf::SPosT pos = 0; pos < endPos;) {
+         auto rdsz = rd.Read(pos, rdbuf, sizeof(rdbuf));
+         if (rdsz == 0)
+            break;
+         for (size_t i = 0; i < rdsz; i += kPkSize)
+            chk += static_cast<fon9::byte>(rdbuf[i]);
+         pos += rdsz;
+      }
+      return chk;
+   });
+   streams.clear();
+   while (apf->use_count() != 1)
+      std::this_thread::yield();
+   apf.reset();
+}
+//--------------------------------------------------------------------------//
 int main() {
 #if defined(_MSC_VER) && defined(_DEBUG)
    _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
@@ -289,5 +422,7 @@ int main() {
       utinfo.PrintSplitter();
       InnApf_Benchmark(L);
    }
+   utinfo.PrintSplitter();
+   InnApf_RecoverBenchmark(256 * 1024 * 1024);
    remove(kInnApfFileName);
 }
@@ -286,6 +286,13 @@ public:
    }
    SizeT ReadAll(const RoomKey& roomKey, void* buf, SizeT bufsz);
 
+   /// 取得 room 儲存的內容, 從 offset 開始的資料在檔案中的位置, 提供直接存取檔案(例: FileMap)時使用.
+   /// - 參數的檢查及 size 的調整, 與 Read() 相同.
+   /// - 返回 0 表示沒有可讀取的資料.
+   RoomPosT GetDataFilePos(const RoomKey& roomKey, SizeT offset, SizeT& size) {
+      return this->CheckReadArgs(roomKey, offset, size);
+   }
+
    /// 將 「buf全部」 覆寫入 room, 成功後返回寫入 room 的資料量 = roomKey.GetDataSize() = buf.CalcSize();
    /// 若 room 的空間不足, 則 room 內容不變, 直接拋出 InnRoomSizeError 異常.
    SizeT Rewrite(RoomKey& roomKey, DcQueue& buf);
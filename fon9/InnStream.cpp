@@ -225,6 +225,38 @@ InnStream::SizeType InnStream::Append(DcQueue&& buf) {
    PosType pos = this->SeekToEndWithFlush(impl);
    return pos + this->WriteDcQueue(impl, pos, std::move(buf));
 }
+InnStream::SizeType InnStream::GetFileSpans(PosType pos, SizeType size, FileSpans& spans) {
+   Locker      impl{this->Lock()};
+   InnRoomSize ofsBlock;
+   size_t      idx = SeekWithFlush(impl, pos, ofsBlock);
+   if (idx == 0)
+      return 0;
+   --idx;
+   SizeType totsz = 0;
+   for (;;) {
+      Block&         curr = impl->BlockList_[idx];
+      InnFile::SizeT spsz = (size < curr.GetBlockSize() ? static_cast<InnFile::SizeT>(size) : curr.GetBlockSize());
+      if (auto fpos = impl->OwnerInnFile()->GetDataFilePos(curr.RoomKey_, static_cast<InnRoomSize>(ofsBlock + sizeof(RoomHeader)), spsz)) {
+         FileSpan sp;
+         sp.FilePos_ = fpos;
+         sp.Size_ = spsz;
+         spans.push_back(sp);
+         totsz += spsz;
+         if ((size -= spsz) == 0)
+            break;
+      }
+      if (++idx >= impl->BlockList_.size()) {
+         if (impl->NextRoomPos_ == 0)
+            break;
+         Block next = impl->LoadNextBlock();
+         impl->ValidateBlockRoomKey(next);
+         next.SPos_ = curr.SPos_ + curr.GetPayloadSize();
+         impl->BlockList_.emplace_back(std::move(next));
+      }
+      ofsBlock = 0;
+   }
+   return totsz;
+}
 InnStream::PosType InnStream::Size() {
    return this->SeekToEndWithFlush(this->Lock());
 }
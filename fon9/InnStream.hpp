@@ -6,6 +6,7 @@
 #include "fon9/MustLock.hpp"
 #include "fon9/Endian.hpp"
 #include <deque>
+#include <vector>
 
 namespace fon9 {
 
@@ -22,6 +23,8 @@ public:
    using base::Write;
    using base::Read;
    using base::MakeRoomKey;
+   using base::GetOpenName;
+   using base::GetDataFilePos;
 
    RoomKey MakeNewRoom(InnRoomType roomType, SizeT size) {
       Locker locker{this->Mutex_};
@@ -86,6 +89,19 @@ public:
 
    PosType Size();
 
+   /// Stream 的一段資料在檔案中的位置.
+   struct FileSpan {
+      File::PosType  FilePos_;
+      InnRoomSize    Size_;
+      char           Padding___[4];
+   };
+   using FileSpans = std::vector<FileSpan>;
+   /// 取得 stream 的 [pos, pos + size) 在檔案中的位置(依序加入 spans 尾端), 不讀取資料內容.
+   /// - 提供直接存取檔案(例: FileMap)時使用, 可避免逐次 Read() 的鎖定及複製.
+   /// - 返回前會先 Flush(), 所以取得的範圍都已寫入檔案.
+   /// \return 實際取得的資料量, 可能小於 size (stream 的資料不足).
+   SizeType GetFileSpans(PosType pos, SizeType size, FileSpans& spans);
+
 protected:
    struct RoomHeader {
       char  NextRoomPos_[sizeof(RoomPos)];
@@ -0,0 +1,458 @@
+﻿// \file fon9/LatencyHist.cpp
+// \author fonwinz@gmail.com
+#include "fon9/LatencyHist.hpp"
+#include "fon9/seed/Plugins.hpp"
+#include "fon9/seed/FieldMaker.hpp"
+#include "fon9/seed/TreeLockContainerT.hpp"
+#include "fon9/CharVector.hpp"
+#include "fon9/MustLock.hpp"
+
+fon9_BEFORE_INCLUDE_STD;
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <algorithm>
+fon9_AFTER_INCLUDE_STD;
+
+namespace fon9 {
+
+fon9_API double LatencyNsPerTick() {
+#ifdef fon9_LATENCY_USE_TSC
+   static const double nsPerTick = []() {
+      using Clock = std::chrono::steady_clock;
+      const auto        t0 = Clock::now();
+      const LatencyTick k0 = GetLatencyTick();
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      const auto        t1 = Clock::now();
+      const LatencyTick k1 = GetLatencyTick();
+      const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+      return (k1 > k0) ? (static_cast<double>(ns) / static_cast<double>(k1 - k0)) : 1.0;
+   }();
+   return nsPerTick;
+#else
+   return 1.0;
+#endif
+}
+//--------------------------------------------------------------------------//
+/// 某個 thread 的某個 stage 的統計資料.
+/// 只有擁有者 thread 會異動, 所以使用 relaxed load + store 即可, 不須 atomic RMW.
+struct LatencyHistData {
+   fon9_NON_COPY_NON_MOVE(LatencyHistData);
+   std::atomic<uint64_t>   Buckets_[kLatencyHistBucketCount];
+   std::atomic<uint64_t>   Sum_;
+   std::atomic<uint64_t>   Max_;
+   /// Max_ 在此 epoch 期間有效, 若與 LatencyEpochs_[id] 不同, 表示 Max_ 已被 Reset.
+   std::atomic<uint32_t>   MaxEpoch_;
+
+   LatencyHistData() {
+      for (auto& b : this->Buckets_)
+         b.store(0, std::memory_order_relaxed);
+      this->Sum_.store(0, std::memory_order_relaxed);
+      this->Max_.store(0, std::memory_order_relaxed);
+      this->MaxEpoch_.store(0, std::memory_order_relaxed);
+   }
+};
+/// 合併後的統計資料.
+struct LatencyHistSum {
+   uint64_t Buckets_[kLatencyHistBucketCount];
+   uint64_t Sum_;
+   uint64_t Max_;
+
+   LatencyHistSum() {
+      this->Clear();
+   }
+   void Clear() {
+      memset(this, 0, sizeof(*this));
+   }
+   void Add(const LatencyHistData& src, uint32_t epoch) {
+      for (unsigned L = 0; L < kLatencyHistBucketCount; ++L)
+         this->Buckets_[L] += src.Buckets_[L].load(std::memory_order_relaxed);
+      this->Sum_ += src.Sum_.load(std::memory_order_relaxed);
+      if (src.MaxEpoch_.load(std::memory_order_relaxed) == epoch) {
+         const uint64_t mx = src.Max_.load(std::memory_order_relaxed);
+         if (this->Max_ < mx)
+            this->Max_ = mx;
+      }
+   }
+   void Add(const LatencyHistSum& src) {
+      for (unsigned L = 0; L < kLatencyHistBucketCount; ++L)
+         this->Buckets_[L] += src.Buckets_[L];
+      this->Sum_ += src.Sum_;
+      if (this->Max_ < src.Max_)
+         this->Max_ = src.Max_;
+   }
+   void Sub(const LatencyHistSum& base) {
+      for (unsigned L = 0; L < kLatencyHistBucketCount; ++L)
+         this->Buckets_[L] -= base.Buckets_[L];
+      this->Sum_ -= base.Sum_;
+   }
+};
+struct LatencyThreadHist {
+   fon9_NON_COPY_NON_MOVE(LatencyThreadHist);
+   LatencyThreadHist() = default;
+   LatencyHistData* Stages_[LatencyStage::kMaxCount]{};
+   ~LatencyThreadHist() {
+      for (LatencyHistData* d : this->Stages_)
+         delete d;
+   }
+};
+static std::atomic<uint32_t> LatencyEpochs_[LatencyStage::kMaxCount];
+
+struct LatencyRegistry {
+   std::mutex                       Mutex_;
+   unsigned                         StageCount_{0};
+   std::string                      Names_[LatencyStage::kMaxCount];
+   std::vector<LatencyThreadHist*>  Threads_;
+   /// 已結束的 thread 的統計資料.
+   std::unique_ptr<LatencyHistSum>  Retired_[LatencyStage::kMaxCount];
+   /// Reset 時的統計資料, 查詢時扣除.
+   std::unique_ptr<LatencyHistSum>  Base_[LatencyStage::kMaxCount];
+
+   unsigned FindStage(StrView name) const {
+      for (unsigned L = 0; L < this->StageCount_; ++L) {
+         if (ToStrView(this->Names_[L]) == name)
+            return L;
+      }
+      return LatencyStage::kMaxCount;
+   }
+   /// 合併全部 thread 的統計資料, 不扣除 Base_.
+   void MergeAll(unsigned id, LatencyHistSum& res) const {
+      res.Clear();
+      if (this->Retired_[id])
+         res.Add(*this->Retired_[id]);
+      const uint32_t epoch = LatencyEpochs_[id].load(std::memory_order_relaxed);
+      for (const LatencyThreadHist* thr : this->Threads_) {
+         if (const LatencyHistData* d = thr->Stages_[id])
+            res.Add(*d, epoch);
+      }
+   }
+   void Query(unsigned id, LatencyHistResult& res) const {
+      LatencyHistSum sum;
+      this->MergeAll(id, sum);
+      if (this->Base_[id])
+         sum.Sub(*this->Base_[id]);
+      uint64_t count = 0;
+      for (uint64_t b : sum.Buckets_)
+         count += b;
+      res = LatencyHistResult{};
+      if ((res.Count_ = count) == 0)
+         return;
+      const double nsPerTick = LatencyNsPerTick();
+      auto toNs = [nsPerTick](uint64_t ticks) {
+         return static_cast<uint64_t>(static_cast<double>(ticks) * nsPerTick);
+      };
+      res.Avg_ = toNs(sum.Sum_ / count);
+      res.Max_ = toNs(sum.Max_);
+      struct Pct {
+         uint64_t* Dst_;
+         uint64_t  Rank_;
+      } pcts[] = {
+         {&res.P50_,  (count * 500 + 999) / 1000},
+         {&res.P99_,  (count * 990 + 999) / 1000},
+         {&res.P999_, (count * 999 + 999) / 1000},
+      };
+      uint64_t cum = 0;
+      unsigned ipct = 0;
+      for (unsigned L = 0; L < kLatencyHistBucketCount && ipct < numofele(pcts); ++L) {
+         cum += sum.Buckets_[L];
+         while (ipct < numofele(pcts) && cum >= pcts[ipct].Rank_) {
+            uint64_t v = LatencyHistBucketUpper(L);
+            // Max_ 為精確值, bucket 的上限不應超過 Max_;
+            if (sum.Max_ > 0 && v > sum.Max_)
+               v = sum.Max_;
+            *pcts[ipct++].Dst_ = toNs(v);
+         }
+      }
+   }
+   void Reset(unsigned id) {
+      if (!this->Base_[id])
+         this->Base_[id].reset(new LatencyHistSum);
+      this->MergeAll(id, *this->Base_[id]);
+      if (this->Retired_[id])
+         this->Retired_[id]->Max_ = 0;
+      LatencyEpochs_[id].fetch_add(1, std::memory_order_relaxed);
+   }
+};
+static LatencyRegistry& GetLatencyRegistry() {
+   // 不解構: thread 結束時(可能在 static 物件解構之後), 仍需要使用 registry.
+   static LatencyRegistry* reg = new LatencyRegistry;
+   return *reg;
+}
+//--------------------------------------------------------------------------//
+static thread_local LatencyThreadHist* TlsHist_{nullptr};
+static thread_local LatencyTick        TlsOrigin_{0};
+
+/// thread 結束時, 將統計資料移到 LatencyRegistry::Retired_;
+struct LatencyThreadRetirer {
+   fon9_NON_COPY_NON_MOVE(LatencyThreadRetirer);
+   LatencyThreadRetirer() = default;
+   ~LatencyThreadRetirer() {
+      LatencyThreadHist* thr = TlsHist_;
+      if (thr == nullptr)
+         return;
+      LatencyRegistry& reg = GetLatencyRegistry();
+      {
+         std::lock_guard<std::mutex> lk{reg.Mutex_};
+         for (unsigned id = 0; id < LatencyStage::kMaxCount; ++id) {
+            if (const LatencyHistData* d = thr->Stages_[id]) {
+               if (!reg.Retired_[id])
+                  reg.Retired_[id].reset(new LatencyHistSum);
+               reg.Retired_[id]->Add(*d, LatencyEpochs_[id].load(std::memory_order_relaxed));
+            }
+         }
+         auto ifind = std::find(reg.Threads_.begin(), reg.Threads_.end(), thr);
+         if (ifind != reg.Threads_.end())
+            reg.Threads_.erase(ifind);
+      }
+      TlsHist_ = nullptr;
+      delete thr;
+   }
+};
+static LatencyHistData& AllocThreadData(unsigned id) {
+   LatencyRegistry& reg = GetLatencyRegistry();
+   LatencyThreadHist* thr = TlsHist_;
+   if (thr == nullptr) {
+      static thread_local LatencyThreadRetirer retirer;
+      (void)retirer;
+      thr = new LatencyThreadHist;
+      std::lock_guard<std::mutex> lk{reg.Mutex_};
+      reg.Threads_.push_back(thr);
+      TlsHist_ = thr;
+   }
+   LatencyHistData* d = new LatencyHistData;
+   d->MaxEpoch_.store(LatencyEpochs_[id].load(std::memory_order_relaxed), std::memory_order_relaxed);
+   std::lock_guard<std::mutex> lk{reg.Mutex_};
+   thr->Stages_[id] = d;
+   return *d;
+}
+//--------------------------------------------------------------------------//
+LatencyStage::LatencyStage(StrView name) {
+   LatencyRegistry& reg = GetLatencyRegistry();
+   std::lock_guard<std::mutex> lk{reg.Mutex_};
+   this->Id_ = reg.FindStage(name);
+   if (this->Id_ >= kMaxCount && reg.StageCount_ < kMaxCount) {
+      this->Id_ = reg.StageCount_++;
+      reg.Names_[this->Id_] = name.ToString();
+   }
+}
+void LatencyStage::Add(LatencyTick ticks) const {
+   if (fon9_UNLIKELY(this->Id_ >= kMaxCount))
+      return;
+   LatencyThreadHist* thr = TlsHist_;
+   LatencyHistData*   d = (thr ? thr->Stages_[this->Id_] : nullptr);
+   if (fon9_UNLIKELY(d == nullptr))
+      d = &AllocThreadData(this->Id_);
+   auto& b = d->Buckets_[LatencyHistBucketIndex(ticks)];
+   b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   d->Sum_.store(d->Sum_.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+   const uint32_t epoch = LatencyEpochs_[this->Id_].load(std::memory_order_relaxed);
+   if (fon9_UNLIKELY(d->MaxEpoch_.load(std::memory_order_relaxed) != epoch)) {
+      d->Max_.store(ticks, std::memory_order_relaxed);
+      d->MaxEpoch_.store(epoch, std::memory_order_relaxed);
+   }
+   else if (d->Max_.load(std::memory_order_relaxed) < ticks)
+      d->Max_.store(ticks, std::memory_order_relaxed);
+}
+fon9_API LatencyTick LatencySetOrigin(LatencyTick tick) {
+   const LatencyTick prev = TlsOrigin_;
+   TlsOrigin_ = tick;
+   return prev;
+}
+fon9_API void LatencyAddSinceOrigin(const LatencyStage& stage) {
+   if (const LatencyTick origin = TlsOrigin_)
+      stage.Add(GetLatencyTick() - origin);
+}
+fon9_API bool LatencyHistQuery(StrView stageName, LatencyHistResult& res) {
+   LatencyRegistry& reg = GetLatencyRegistry();
+   std::lock_guard<std::mutex> lk{reg.Mutex_};
+   const unsigned id = reg.FindStage(stageName);
+   if (id >= LatencyStage::kMaxCount)
+      return false;
+   reg.Query(id, res);
+   return true;
+}
+fon9_API bool LatencyHistReset(StrView stageName) {
+   LatencyRegistry& reg = GetLatencyRegistry();
+   std::lock_guard<std::mutex> lk{reg.Mutex_};
+   if (stageName.empty()) {
+      for (unsigned id = 0; id < reg.StageCount_; ++id)
+         reg.Reset(id);
+      return true;
+   }
+   const unsigned id = reg.FindStage(stageName);
+   if (id >= LatencyStage::kMaxCount)
+      return false;
+   reg.Reset(id);
+   return true;
+}
+//--------------------------------------------------------------------------//
+/// 延遲統計的 seed tree, 每個 stage 一筆.
+/// - 每次查詢(GridView, Get)時, 重新合併各 thread 的統計資料.
+/// - 指令: "reset" 清除此 stage 的統計; "resetall" 清除全部 stage 的統計.
+struct LatencyHistRow {
+   CharVector  Name_;
+   uint64_t    Count_{0};
+   uint64_t    Avg_{0};
+   uint64_t    P50_{0};
+   uint64_t    P99_{0};
+   uint64_t    P999_{0};
+   uint64_t    Max_{0};
+
+   void Assign(const LatencyHistResult& src) {
+      this->Count_ = src.Count_;
+      this->Avg_ = src.Avg_;
+      this->P50_ = src.P50_;
+      this->P99_ = src.P99_;
+      this->P999_ = src.P999_;
+      this->Max_ = src.Max_;
+   }
+
+   LatencyHistRow& GetSeedRW(seed::Tab&) {
+      return *this;
+   }
+   seed::TreeSP HandleGetSapling(seed::Tab&) {
+      return seed::TreeSP{};
+   }
+   template <class Locker>
+   void HandleSeedCommand(Locker& locker, seed::SeedOpResult& res, StrView cmdln, seed::FnCommandResultHandler&& resHandler) {
+      const CharVector name = this->Name_;
+      locker.unlock();
+      res.OpResult_ = seed::OpResult::no_error;
+      if (cmdln == "reset") {
+         LatencyHistReset(ToStrView(name));
+         resHandler(res, "reset done");
+      }
+      else if (cmdln == "resetall") {
+         LatencyHistReset(StrView{});
+         resHandler(res, "resetall done");
+      }
+      else if (cmdln == "?") {
+         resHandler(res,
+                    "reset" fon9_kCSTR_CELLSPL "Reset this stage" fon9_kCSTR_ROWSPL
+                    "resetall" fon9_kCSTR_CELLSPL "Reset all stages");
+      }
+      else {
+         res.OpResult_ = seed::OpResult::not_supported_cmd;
+         resHandler(res, cmdln);
+      }
+   }
+};
+struct LatencyHistRows {
+   using iterator = LatencyHistRow*;
+   using const_iterator = const LatencyHistRow*;
+   LatencyHistRow Rows_[LatencyStage::kMaxCount];
+   unsigned       RowCount_{0};
+
+   iterator find(StrView name) {
+      iterator i = this->begin();
+      for (; i != this->end(); ++i) {
+         if (ToStrView(i->Name_) == name)
+            break;
+      }
+      return i;
+   }
+   iterator lower_bound(StrView name) {
+      return this->find(name);
+   }
+   iterator begin() { return this->Rows_; }
+   iterator end() { return this->Rows_ + this->RowCount_; }
+   const_iterator begin() const { return this->Rows_; }
+   const_iterator end() const { return this->Rows_ + this->RowCount_; }
+};
+using LatencyHistRowsMx = MustLock<LatencyHistRows>;
+
+class LatencyHistTree : public seed::Tree {
+   fon9_NON_COPY_NON_MOVE(LatencyHistTree);
+   using base = seed::Tree;
+   using Locker = LatencyHistRowsMx::Locker;
+   using PodOp = seed::PodOpLockerNoWrite<LatencyHistRow, Locker>;
+   LatencyHistRowsMx Rows_;
+
+   void Refresh() {
+      Locker            rows{this->Rows_};
+      LatencyRegistry&  reg = GetLatencyRegistry();
+      std::lock_guard<std::mutex> lk{reg.Mutex_};
+      rows->RowCount_ = reg.StageCount_;
+      LatencyHistResult res;
+      for (unsigned id = 0; id < reg.StageCount_; ++id) {
+         LatencyHistRow& row = rows->Rows_[id];
+         if (row.Name_.empty())
+            row.Name_.assign(ToStrView(reg.Names_[id]));
+         reg.Query(id, res);
+         row.Assign(res);
+      }
+   }
+   struct TreeOp : public seed::TreeOp {
+      fon9_NON_COPY_NON_MOVE(TreeOp);
+      using base = seed::TreeOp;
+      using base::base;
+      static void MakeRecordView(LatencyHistRows::iterator ivalue, seed::Tab* tab, RevBuffer& rbuf) {
+         if (tab)
+            FieldsCellRevPrint(tab->Fields_, seed::SimpleRawRd{*ivalue}, rbuf);
+         RevPrint(rbuf, ivalue->Name_);
+      }
+      void GridView(const seed::GridViewRequest& req, seed::FnGridViewOp fnCallback) override {
+         LatencyHistTree& tree = *static_cast<LatencyHistTree*>(&this->Tree_);
+         tree.Refresh();
+         seed::TreeOp_GridView_MustLock(*this, tree.Rows_, req, std::move(fnCallback), &MakeRecordView);
+      }
+      void Get(StrView strKeyText, seed::FnPodOp fnCallback) override {
+         LatencyHistTree& tree = *static_cast<LatencyHistTree*>(&this->Tree_);
+         tree.Refresh();
+         seed::TreeOp_Get_MustLock<PodOp>(*this, tree.Rows_, strKeyText, std::move(fnCallback));
+      }
+   };
+   static seed::LayoutSP MakeLayout() {
+      seed::Fields fields;
+      fields.Add(fon9_MakeField2_const(LatencyHistRow, Count));
+      fields.Add(fon9_MakeField2_const(LatencyHistRow, Avg));
+      fields.Add(fon9_MakeField2_const(LatencyHistRow, P50));
+      fields.Add(fon9_MakeField2_const(LatencyHistRow, P99));
+      fields.Add(fon9_MakeField2_const(LatencyHistRow, P999));
+      fields.Add(fon9_MakeField2_const(LatencyHistRow, Max));
+      return new seed::Layout1(fon9_MakeField(LatencyHistRow, Name_, "Stage"),
+                               new seed::Tab{Named{"Hist", "Latency(ns)"}, std::move(fields), seed::TabFlag::NoSapling},
+                               seed::TreeFlag{});
+   }
+public:
+   LatencyHistTree() : base{MakeLayout()} {
+   }
+   void OnTreeOp(seed::FnTreeOp fnCallback) override {
+      TreeOp op{*this};
+      fnCallback(seed::TreeOpResult{this, seed::OpResult::no_error}, &op);
+   }
+};
+//--------------------------------------------------------------------------//
+/// args = "Name=LatencyHist"
+/// - 在 holder.Root_ 加入延遲統計.
+static bool LatencyHist_Start(seed::PluginsHolder& holder, StrView args) {
+   std::string name{"LatencyHist"};
+   StrView     tag, value;
+   while (SbrFetchTagValue(args, tag, value)) {
+      if (tag == "Name")
+         name = value.ToString();
+      else {
+         holder.SetPluginsSt(LogLevel::Error, "Unknown tag=", tag);
+         return false;
+      }
+   }
+   if (!holder.Root_->AddNamedSapling(new LatencyHistTree, name)) {
+      holder.SetPluginsSt(LogLevel::Error, "Name=", name, "|err=Name is dup");
+      return false;
+   }
+   return true;
+}
+
+} // namespace fon9
+
+extern "C" fon9_API fon9::seed::PluginsDesc f9p_LatencyHist;
+static fon9::seed::PluginsPark f9pAutoPluginsReg{"LatencyHist", &f9p_LatencyHist};
+
+fon9::seed::PluginsDesc f9p_LatencyHist{
+   "",
+   &fon9::LatencyHist_Start,
+   nullptr,
+   nullptr,
+};
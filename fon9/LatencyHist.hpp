@@ -0,0 +1,182 @@
+﻿/// \file fon9/LatencyHist.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_LatencyHist_hpp__
+#define __fon9_LatencyHist_hpp__
+#include "fon9/StrView.hpp"
+
+fon9_BEFORE_INCLUDE_STD;
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <intrin.h>
+#  define fon9_LATENCY_USE_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#  define fon9_LATENCY_USE_TSC
+#else
+#  include <chrono>
+#endif
+fon9_AFTER_INCLUDE_STD;
+
+namespace fon9 {
+
+/// \ingroup Misc
+/// 延遲量測使用的時間單位.
+/// - x86: 使用 rdtsc(需要 invariant TSC, 近代 CPU 皆支援).
+/// - 其他: 使用 std::chrono::steady_clock 的 ns.
+/// - 使用 LatencyNsPerTick() 換算成 ns.
+using LatencyTick = uint64_t;
+
+inline LatencyTick GetLatencyTick() {
+#ifdef fon9_LATENCY_USE_TSC
+   return __rdtsc();
+#else
+   return static_cast<LatencyTick>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+/// 每個 LatencyTick 的 ns 數, 第一次呼叫時才會校正.
+fon9_API double LatencyNsPerTick();
+
+/// 延遲分布使用 log-linear 的 bucket(類似 HdrHistogram):
+/// - 值 < 16: 每個值一個 bucket.
+/// - 值 >= 16: 每個 2 的次方範圍, 再細分成 16 個 bucket, 誤差 < 1/16.
+enum : unsigned {
+   kLatencyHistSubBits = 4,
+   kLatencyHistSubCount = (1u << kLatencyHistSubBits),
+   kLatencyHistBucketCount = (64 - kLatencyHistSubBits + 1) * kLatencyHistSubCount,
+};
+inline unsigned LatencyHistBucketIndex(uint64_t v) {
+   if (v < kLatencyHistSubCount)
+      return static_cast<unsigned>(v);
+#if defined(_MSC_VER) && defined(_M_X64)
+   unsigned long e;
+   _BitScanReverse64(&e, v);
+#elif defined(__GNUC__)
+   const unsigned e = static_cast<unsigned>(63 - __builtin_clzll(v));
+#else
+   unsigned e = 63;
+   while ((v >> e) == 0)
+      --e;
+#endif
+   return (e - kLatencyHistSubBits + 1) * kLatencyHistSubCount
+      + static_cast<unsigned>((v >> (e - kLatencyHistSubBits)) & (kLatencyHistSubCount - 1));
+}
+/// 返回 bucket 範圍內的最大值.
+inline uint64_t LatencyHistBucketUpper(unsigned idx) {
+   if (idx < kLatencyHistSubCount)
+      return idx;
+   const unsigned sh = idx / kLatencyHistSubCount - 1;
+   const uint64_t lower = static_cast<uint64_t>(kLatencyHistSubCount + (idx % kLatencyHistSubCount)) << sh;
+   return lower + ((static_cast<uint64_t>(1) << sh) - 1);
+}
+
+/// \ingroup Misc
+/// 延遲量測點(stage).
+/// - 通常使用 fon9_LATENCY_SCOPE(); 之類的巨集, 在 function 裡面建立 static LatencyStage.
+/// - 相同名稱的 stage 共用統計資料, 例: 不同的 dll 各自建立了同名的 stage.
+/// - 最多 kMaxCount 個 stage, 超過的 stage 不會記錄.
+/// - 每個 thread 有各自的統計資料, 記錄時不須鎖定, 查詢時再合併.
+class fon9_API LatencyStage {
+   fon9_NON_COPY_NON_MOVE(LatencyStage);
+   unsigned Id_;
+public:
+   enum : unsigned {
+      kMaxCount = 64,
+   };
+   explicit LatencyStage(StrView name);
+
+   /// 記錄一筆延遲時間.
+   void Add(LatencyTick ticks) const;
+};
+
+/// \ingroup Misc
+/// 在解構時記錄 [建構 .. 解構] 的時間.
+class LatencyScope {
+   fon9_NON_COPY_NON_MOVE(LatencyScope);
+   const LatencyStage&  Stage_;
+   const LatencyTick    Start_;
+public:
+   explicit LatencyScope(const LatencyStage& stage) : Stage_(stage), Start_{GetLatencyTick()} {
+   }
+   ~LatencyScope() {
+      this->Stage_.Add(GetLatencyTick() - this->Start_);
+   }
+};
+
+/// 設定 this thread 的延遲起點(例: 收到封包的時間), 返回先前的起點.
+/// tick == 0 表示沒有起點.
+fon9_API LatencyTick LatencySetOrigin(LatencyTick tick);
+/// 若 this thread 有延遲起點, 則記錄 [起點 .. 現在] 的時間.
+fon9_API void LatencyAddSinceOrigin(const LatencyStage& stage);
+
+/// \ingroup Misc
+/// 設定延遲起點, 並在解構時:
+/// - 記錄 [建構 .. 解構] 的時間.
+/// - 還原先前的延遲起點.
+class LatencyOriginScope {
+   fon9_NON_COPY_NON_MOVE(LatencyOriginScope);
+   const LatencyStage&  Stage_;
+   const LatencyTick    Start_;
+   const LatencyTick    PrevOrigin_;
+public:
+   explicit LatencyOriginScope(const LatencyStage& stage)
+      : Stage_(stage)
+      , Start_{GetLatencyTick()}
+      , PrevOrigin_{LatencySetOrigin(Start_)} {
+   }
+   ~LatencyOriginScope() {
+      this->Stage_.Add(GetLatencyTick() - this->Start_);
+      LatencySetOrigin(this->PrevOrigin_);
+   }
+};
+
+/// 統計結果, 時間單位為 ns.
+struct LatencyHistResult {
+   uint64_t Count_{0};
+   uint64_t Avg_{0};
+   uint64_t P50_{0};
+   uint64_t P99_{0};
+   uint64_t P999_{0};
+   uint64_t Max_{0};
+};
+/// 查詢 stageName 的統計結果, 找不到 stageName 則返回 false.
+fon9_API bool LatencyHistQuery(StrView stageName, LatencyHistResult& res);
+/// 清除 stageName 的統計資料; stageName.empty() 表示清除全部.
+/// 找不到 stageName 則返回 false.
+fon9_API bool LatencyHistReset(StrView stageName);
+
+} // namespace fon9
+
+/// \ingroup Misc
+/// 延遲量測巨集, 定義 fon9_NO_LATENCY_HIST 則全部移除.
+/// - fon9_LATENCY_SCOPE("stageName");
+///   記錄此 scope 的執行時間.
+/// - fon9_LATENCY_ORIGIN_SCOPE("stageName");
+///   在收到資料處設定延遲起點, 並記錄此 scope 的執行時間.
+///   只應放在行情接收端(例: OnDevice_Recv() => PkReceiver::FeedBuffer()),
+///   若放在 io 底層, 則一般連線(rc/FIX)的請求所觸發的回覆, 也會被計入 SINCE_ORIGIN.
+/// - fon9_LATENCY_SINCE_ORIGIN("stageName");
+///   記錄從延遲起點到現在的時間, 例: 從收到封包, 到發行(送出)的時間.
+#ifdef fon9_NO_LATENCY_HIST
+#define fon9_LATENCY_SCOPE(stageName)           do{}while(0)
+#define fon9_LATENCY_ORIGIN_SCOPE(stageName)    do{}while(0)
+#define fon9_LATENCY_SINCE_ORIGIN(stageName)    do{}while(0)
+#else
+#define fon9_LATENCY_CAT_(a,b)   a##b
+#define fon9_LATENCY_CAT(a,b)    fon9_LATENCY_CAT_(a,b)
+#define fon9_LATENCY_STAGE_VAR   fon9_LATENCY_CAT(fon9_LatencyStage_, __LINE__)
+
+#define fon9_LATENCY_SCOPE(stageName)                                  \
+   static const fon9::LatencyStage  fon9_LATENCY_STAGE_VAR{stageName}; \
+   const fon9::LatencyScope fon9_LATENCY_CAT(fon9_LatencyScope_, __LINE__){fon9_LATENCY_STAGE_VAR}
+
+#define fon9_LATENCY_ORIGIN_SCOPE(stageName)                           \
+   static const fon9::LatencyStage  fon9_LATENCY_STAGE_VAR{stageName}; \
+   const fon9::LatencyOriginScope fon9_LATENCY_CAT(fon9_LatencyScope_, __LINE__){fon9_LATENCY_STAGE_VAR}
+
+#define fon9_LATENCY_SINCE_ORIGIN(stageName) do {                      \
+   static const fon9::LatencyStage  fon9_LATENCY_STAGE_VAR{stageName}; \
+   fon9::LatencyAddSinceOrigin(fon9_LATENCY_STAGE_VAR);                \
+} while(0)
+#endif
+
+#endif//__fon9_LatencyHist_hpp__
@@ -0,0 +1,86 @@
+﻿// \file fon9/LatencyHist_UT.cpp
+// \author fonwinz@gmail.com
+#include "fon9/LatencyHist.hpp"
+#include "fon9/TestTools.hpp"
+#include <thread>
+#include <vector>
+
+void TestBucket() {
+   bool isOk = true;
+   for (uint64_t v = 0; v < 1024 * 1024; ++v) {
+      const unsigned idx = fon9::LatencyHistBucketIndex(v);
+      // v 必須在 bucket 範圍內, 且誤差 < 1/16.
+      const uint64_t upper = fon9::LatencyHistBucketUpper(idx);
+      if (v > upper || (upper - v) * fon9::kLatencyHistSubCount > (v < 16 ? 0 : v)) {
+         std::cout << "|v=" << v << "|idx=" << idx << "|upper=" << upper;
+         isOk = false;
+         break;
+      }
+   }
+   fon9_CheckTestResult("BucketRange", isOk);
+   fon9_CheckTestResult("BucketMax", fon9::LatencyHistBucketIndex(~static_cast<uint64_t>(0)) == fon9::kLatencyHistBucketCount - 1
+                        && fon9::LatencyHistBucketUpper(fon9::kLatencyHistBucketCount - 1) == ~static_cast<uint64_t>(0));
+}
+
+void TestStage() {
+   static const fon9::LatencyStage stage{"UT.Stage"};
+   static const fon9::LatencyStage stageDup{"UT.Stage"};
+   const unsigned kThreadCount = 4;
+   const unsigned kTimes = 1000;
+   std::vector<std::thread> thrs;
+   for (unsigned L = 0; L < kThreadCount; ++L) {
+      thrs.emplace_back([&]() {
+         for (unsigned i = 1; i <= kTimes; ++i)
+            (i % 2 ? stage : stageDup).Add(i);
+      });
+   }
+   for (auto& t : thrs)
+      t.join();
+   fon9::LatencyHistResult res;
+   fon9_CheckTestResult("Query", fon9::LatencyHistQuery("UT.Stage", res) && res.Count_ == kThreadCount * kTimes);
+   std::cout << "|Count=" << res.Count_ << "|Avg=" << res.Avg_ << "|P50=" << res.P50_
+      << "|P99=" << res.P99_ << "|P999=" << res.P999_ << "|Max=" << res.Max_ << std::endl;
+   fon9_CheckTestResult("Percentile", res.P50_ <= res.P99_ && res.P99_ <= res.P999_ && res.P999_ <= res.Max_);
+
+   fon9_CheckTestResult("Reset", fon9::LatencyHistReset("UT.Stage")
+                        && fon9::LatencyHistQuery("UT.Stage", res) && res.Count_ == 0 && res.Max_ == 0);
+   stage.Add(1);
+   fon9_CheckTestResult("AfterReset", fon9::LatencyHistQuery("UT.Stage", res) && res.Count_ == 1);
+   fon9_CheckTestResult("NotFound", !fon9::LatencyHistQuery("UT.NotFound", res));
+}
+
+void TestOrigin() {
+   fon9::LatencyHistResult res;
+   fon9_LATENCY_SINCE_ORIGIN("UT.SinceOrigin");
+   fon9_CheckTestResult("NoOrigin", fon9::LatencyHistQuery("UT.SinceOrigin", res) && res.Count_ == 0);
+   {
+      fon9_LATENCY_ORIGIN_SCOPE("UT.Origin");
+      fon9_LATENCY_SINCE_ORIGIN("UT.SinceOrigin");
+   }
+   fon9_LATENCY_SINCE_ORIGIN("UT.SinceOrigin");
+   fon9_CheckTestResult("SinceOrigin", fon9::LatencyHistQuery("UT.SinceOrigin", res) && res.Count_ == 1);
+   fon9_CheckTestResult("OriginScope", fon9::LatencyHistQuery("UT.Origin", res) && res.Count_ == 1);
+}
+
+void TestOverhead() {
+   const uint64_t kTimes = 1000 * 1000 * 10;
+   fon9::StopWatch stopWatch;
+   for (uint64_t L = 0; L < kTimes; ++L) {
+      fon9_LATENCY_SCOPE("UT.Overhead");
+   }
+   stopWatch.PrintResult("LATENCY_SCOPE", kTimes);
+   fon9::LatencyHistResult res;
+   fon9::LatencyHistQuery("UT.Overhead", res);
+   std::cout << "|Count=" << res.Count_ << "|Avg=" << res.Avg_ << "ns|P50=" << res.P50_
+      << "|P99=" << res.P99_ << "|P999=" << res.P999_ << "|Max=" << res.Max_ << std::endl;
+}
+
+int main(int argc, char** argv) {
+   (void)argc; (void)argv;
+   fon9::AutoPrintTestInfo utinfo{"LatencyHist"};
+   TestBucket();
+   TestStage();
+   TestOrigin();
+   utinfo.PrintSplitter();
+   TestOverhead();
+}
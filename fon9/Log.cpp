@@ -40,6 +40,7 @@ static void LogWriteToStdout(const LogArgs& /*logArgs*/, BufferList&& buf) {
 }
 static FnLogWriter      FnLogWriter_ = &LogWriteToStdout;
 static FnLogFlusher     FnLogFlusher_ = nullptr;
+static FnLogBodyWriter  FnLogBodyWriter_ = nullptr;
 static TimeZoneOffset   LogTimeZoneAdjust_;
 void (*gWaitLogSystemReady)();
 
@@ -56,16 +57,34 @@ fon9_API void UnsetLogWriter(FnLogWriter fnLogWriter) {
    }
 }
 
+fon9_API void SetLogBodyWriter(FnLogBodyWriter fnLogBodyWriter) {
+   FnLogBodyWriter_ = fnLogBodyWriter;
+}
+fon9_API void UnsetLogBodyWriter(FnLogBodyWriter fnLogBodyWriter) {
+   if (FnLogBodyWriter_ == fnLogBodyWriter)
+      FnLogBodyWriter_ = nullptr;
+}
+fon9_API FnLogBodyWriter GetLogBodyWriter() {
+   return FnLogBodyWriter_;
+}
+
 fon9_API void LogWrite(const LogArgs& logArgs, BufferList&& buf) {
    FnLogWriter_(logArgs, std::move(buf));
 }
 
 fon9_API void AddLogHeader(RevBufferList& rbuf, TimeStamp utctm, LogLevel level) {
-   RevPrint(rbuf, ThisThread_.GetThreadIdStr(), GetLevelStr(level));
+   AddLogHeader(rbuf, utctm, level, ThisThread_.GetThreadIdStr());
+}
+fon9_API void AddLogHeader(RevBufferList& rbuf, TimeStamp utctm, LogLevel level, StrView thrid) {
+   RevPrint(rbuf, thrid, GetLevelStr(level));
    RevPut_Date_Time_us(rbuf, utctm + LogTimeZoneAdjust_);
 }
 fon9_API void LogWrite(LogLevel level, RevBufferList&& rbuf) {
    LogArgs logArgs{level};
+   if (FnLogBodyWriter_) {
+      FnLogBodyWriter_(logArgs, ThisThread_.ThreadId_, rbuf.MoveOut());
+      return;
+   }
    AddLogHeader(rbuf, logArgs.UtcTime_, level);
    FnLogWriter_(logArgs, rbuf.MoveOut());
 }
@@ -76,6 +76,24 @@ fon9_API void SetLogWriter(FnLogWriter fnLogWriter, TimeZoneOffset tzadj, FnLogF
 /// 如果現在的 LogWriter == fnLogWriter, 則還原成預設值: 寫到 stdout.
 fon9_API void UnsetLogWriter(FnLogWriter fnLogWriter);
 
+/// \ingroup Misc
+/// 直接接收 log 內容(尚未加上文字頭部)的寫入函式型別.
+/// - buf = 訊息內容 + '\n'; 不含 `YYYYMMDD-HHMMSS.uuuuuu thrid[LEVEL]`;
+/// - thrid = 產生此筆 log 的 ThreadId::ThreadId_;
+/// - 提供給「不需要文字格式」的 writer(例: LogBin), 可直接使用 logArgs 及 thrid, 不必再從文字解析.
+typedef void (*FnLogBodyWriter) (const LogArgs& logArgs, uintptr_t thrid, BufferList&& buf);
+/// \ingroup Misc
+/// 設定後, fon9_LOG() 及 LogRing 的記錄不再加上文字頭部, 改由 fnLogBodyWriter 寫入;
+/// 自行加上文字頭部後呼叫 LogWrite(logArgs, buf) 的, 仍使用 SetLogWriter() 的設定.
+/// NOT thread safe!
+fon9_API void SetLogBodyWriter(FnLogBodyWriter fnLogBodyWriter);
+/// \ingroup Misc
+/// 如果現在的 LogBodyWriter == fnLogBodyWriter, 則清除.
+fon9_API void UnsetLogBodyWriter(FnLogBodyWriter fnLogBodyWriter);
+/// \ingroup Misc
+/// 取得目前的 LogBodyWriter, 若沒有設定則為 nullptr.
+fon9_API FnLogBodyWriter GetLogBodyWriter();
+
 /// \ingroup Misc
 /// 把 buf 寫入 log: 透過 SetLogWriter() 設定的 log 寫入函式.
 fon9_API void LogWrite(const LogArgs& logArgs, BufferList&& buf);
@@ -83,6 +101,7 @@ fon9_API void LogWrite(const LogArgs& logArgs, BufferList&& buf);
 /// \ingroup Misc
 /// 在 rbuf 之前加上 `YYYYMMDD-HHMMSS.uuuuuu thrid[LEVEL]` 之後, 寫入 log:
 /// `FnLogWriter(tm, rbuf.MoveOut());` 所以返回前 rbuf 會被清空.
+/// 若有 SetLogBodyWriter(), 則不加文字頭部, 直接透過 FnLogBodyWriter 寫入.
 fon9_API void LogWrite(LogLevel level, RevBufferList&& rbuf);
 
 /// \ingroup Misc
@@ -142,6 +161,9 @@ extern void (*gWaitLogSystemReady)();
 /// RevPut_Date_Time_us(rbuf, utctm + tzadj) + ThisThread_.GetThreadIdStr() + GetLevelStr(level)
 /// - tzadj 在 SetLogWriter() 設定.
 fon9_API void AddLogHeader(RevBufferList& rbuf, TimeStamp utctm, LogLevel level);
+/// 在 rbuf 前端增加: RevPut_Date_Time_us(rbuf, utctm + tzadj) + thrid + GetLevelStr(level)
+/// 提供給「非產生 log 的 thread」使用, 例: LogRing 的 writer thread.
+fon9_API void AddLogHeader(RevBufferList& rbuf, TimeStamp utctm, LogLevel level, StrView thrid);
 
 }// namespace
 #endif//__fon9_Log_hpp__
@@ -0,0 +1,434 @@
+﻿// \file fon9/LogBin.cpp
+// \author fonwinz@gmail.com
+#include "fon9/LogBin.hpp"
+#include "fon9/LogFile.hpp"
+#include "fon9/BitvDecode.hpp"
+#include "fon9/StrTo.hpp"
+#include "fon9/Endian.hpp"
+#include "fon9/buffer/DcQueueList.hpp"
+
+fon9_BEFORE_INCLUDE_STD;
+#include <mutex>
+fon9_AFTER_INCLUDE_STD;
+
+namespace fon9 {
+
+namespace impl {
+fon9_API bool IsLogBinOpened_{false};
+} // namespace impl
+
+/// 在 rbuf 前端加上記錄的頭部: RecKind + BodySize;
+/// bodySize = rbuf 在填入 body 之前之後的 CalcDataSize() 差值.
+static void RevPutLogBinRecHead(RevBufferList& rbuf, LogBinRecKind kind, size_t bodySize) {
+   char* pout = rbuf.AllocPrefix(kLogBinRecHeadSize);
+   PutBigEndian(pout -= sizeof(uint32_t), static_cast<uint32_t>(bodySize));
+   *--pout = static_cast<char>(kind);
+   rbuf.SetPrefixUsed(pout);
+}
+/// 在 rbuf 前端加上 LogBinRecKind::Log 的頭部(RecKind + BodySize + 固定欄位);
+/// argsSize = rbuf 裡面 Bitv(args) 的資料量.
+static void RevPutLogBinLogHead(RevBufferList& rbuf, size_t argsSize,
+                                TimeStamp utctm, LogLevel level, uint32_t thrid, LogBinSiteId siteId) {
+   char* pout = rbuf.AllocPrefix(kLogBinRecHeadSize + kLogBinLogHeadSize);
+   PutBigEndian(pout -= sizeof(siteId), siteId);
+   PutBigEndian(pout -= sizeof(thrid), thrid);
+   *--pout = static_cast<char>(level);
+   PutBigEndian(pout -= sizeof(TimeStamp::OrigType), utctm.GetOrigValue());
+   PutBigEndian(pout -= sizeof(uint32_t), static_cast<uint32_t>(argsSize + kLogBinLogHeadSize));
+   *--pout = static_cast<char>(LogBinRecKind::Log);
+   rbuf.SetPrefixUsed(pout);
+}
+
+//--------------------------------------------------------------------------//
+
+struct LogBinSiteReg {
+   const char* FileName_;
+   unsigned    Line_;
+   const char* FuncName_;
+};
+struct LogBinSites {
+   std::mutex                 Mutex_;
+   std::vector<LogBinSiteReg> Sites_;
+};
+static LogBinSites& GetLogBinSites() {
+   static LogBinSites Sites_;
+   return Sites_;
+}
+static void RevPutLogBinSite(RevBufferList& rbuf, LogBinSiteId siteId, const LogBinSiteReg& site) {
+   const size_t szBefore = CalcDataSize(rbuf.cfront());
+   ToBitv(rbuf, StrView_cstr(site.FuncName_));
+   ToBitv(rbuf, site.Line_);
+   ToBitv(rbuf, StrView_cstr(site.FileName_));
+   ToBitv(rbuf, siteId);
+   RevPutLogBinRecHead(rbuf, LogBinRecKind::Site, CalcDataSize(rbuf.cfront()) - szBefore);
+}
+/// 依照 SiteId 順序放入全部已註冊的 Site.
+static void RevPutLogBinSites(RevBufferList& rbuf) {
+   LogBinSites& sites = GetLogBinSites();
+   std::lock_guard<std::mutex> lk{sites.Mutex_};
+   for (size_t idx = sites.Sites_.size(); idx > 0; --idx)
+      RevPutLogBinSite(rbuf, static_cast<LogBinSiteId>(idx), sites.Sites_[idx - 1]);
+}
+
+//--------------------------------------------------------------------------//
+
+class LogBinFileImpl : public LogFileAppender {
+   fon9_NON_COPY_NON_MOVE(LogBinFileImpl);
+   using base = LogFileAppender;
+
+   bool  IsRedirectLog_{false};
+   char  Padding___[7];
+
+   LogBinFileImpl(FileRotate& frConfig) {
+      LogBinFileImpl::gLogBinFile = this;
+      frConfig.CheckTime(UtcNow());
+   }
+
+   /// 由 fon9_LOG() 及 LogRing 轉入(SetLogBodyWriter()): buf = message + '\n';
+   /// 直接使用 logArgs 的 level, time 及 thrid 編碼, 不需要再解析文字.
+   static void LogBodyWriteToFile(const LogArgs& logArgs, uintptr_t thrid, BufferList&& buf);
+   /// 自行加上文字頭部後, 透過 LogWrite(logArgs, buf) 寫入的 log(例: PluginsHolder 的狀態 log).
+   /// 使用 SetLogWriter(..., TimeZoneOffset{}), 所以 buf 裡面的時間為 UTC.
+   /// buf 可能有多行, 每行格式: `YYYYMMDD-HHMMSS.uuuuuu thrid[LEVEL]message`
+   static void LogWriteToFile(const LogArgs& logArgs, BufferList&& buf);
+   static void UnsetRedirectLog() {
+      UnsetLogBodyWriter(&LogBinFileImpl::LogBodyWriteToFile);
+      UnsetLogWriter(&LogBinFileImpl::LogWriteToFile);
+   }
+   static void LogWriteToFile_Flusher() {
+      LogBinFileImpl::gLogBinFile->WaitFlushed();
+   }
+
+   virtual File* OnFileRotate(File& fd, Result openResult) override {
+      if (!fd.IsOpened()) {
+         if (this->IsRedirectLog_)
+            UnsetRedirectLog();
+         fon9_LOG_ERROR("LogBin|open=", fd.GetOpenName(), "|mode=", FileModeToStr(fd.GetOpenMode()), "|err=", openResult.GetError());
+         return nullptr;
+      }
+      File* curfd = base::OnFileRotate(fd, openResult);
+      if (curfd) {
+         // 每次開啟新檔(包含重新開啟), 都需要有完整的 FileHead + Sites, 讓每個檔案可以獨立解碼.
+         RevBufferList rbuf{kLogBlockNodeSize};
+         RevPutLogBinSites(rbuf);
+         const size_t szBefore = CalcDataSize(rbuf.cfront());
+         const TimeZoneOffset tz = this->GetRotateTimeChecker().GetTimeZoneOffset();
+         ToBitv(rbuf, UtcNow());
+         ToBitv(rbuf, static_cast<int>(tz.ToTimeInterval().GetIntPart() / 60));
+         ToBitv(rbuf, static_cast<unsigned>(kLogBinVersion));
+         ToBitv(rbuf, StrView{kLogBinMagic});
+         RevPutLogBinRecHead(rbuf, LogBinRecKind::FileHead, CalcDataSize(rbuf.cfront()) - szBefore);
+         DcQueueList dcQueue{rbuf.MoveOut()};
+         curfd->Append(dcQueue);
+      }
+      return curfd;
+   }
+
+public:
+   static LogBinFileImpl* gLogBinFile;
+   ~LogBinFileImpl() {
+      impl::IsLogBinOpened_ = false;
+      UnsetRedirectLog();
+      this->DisposeAsync();
+      this->Worker_.TakeCall();
+      gLogBinFile = nullptr;
+   }
+   void AppendRec(TimeStamp utctm, BufferList&& buf) {
+      this->CheckRotateTime(utctm);
+      this->Append(std::move(buf));
+   }
+   static File::Result Init(FileRotateSP frConfig, size_t highWaterLevelNodeCount, bool isRedirectLog) {
+      if (LogBinFileImpl::gLogBinFile)
+         frConfig->CheckTime(UtcNow());
+      static intrusive_ptr<LogBinFileImpl> LogBinFile_{new LogBinFileImpl{*frConfig}};
+      gLogBinFile->IsRedirectLog_ = isRedirectLog;
+      auto resfut = gLogBinFile->OpenAsync(std::move(frConfig), FileMode::CreatePath);
+      gLogBinFile->SetHighWaterLevelNodeCount(highWaterLevelNodeCount);
+      gLogBinFile->Worker_.TakeCall();//強制處理開檔要求.
+      File::Result res = resfut.get();
+      if (res) {
+         impl::IsLogBinOpened_ = true;
+         if (isRedirectLog) {
+            SetLogWriter(&LogBinFileImpl::LogWriteToFile, TimeZoneOffset{}, &LogBinFileImpl::LogWriteToFile_Flusher);
+            SetLogBodyWriter(&LogBinFileImpl::LogBodyWriteToFile);
+         }
+      }
+      return res;
+   }
+};
+LogBinFileImpl* LogBinFileImpl::gLogBinFile;
+
+void LogBinFileImpl::LogBodyWriteToFile(const LogArgs& logArgs, uintptr_t thrid, BufferList&& buf) {
+   size_t msgsz = CalcDataSize(buf.cfront());
+   if (msgsz > 0) {
+      const BufferNode* back = buf.back();
+      if (back->GetDataSize() > 0 && *(back->GetDataEnd() - 1) == '\n')
+         --msgsz;
+   }
+   RevBufferList rbuf{static_cast<BufferNodeSize>(msgsz + kLogBinRecHeadSize + kLogBinLogHeadSize + 8)};
+   DcQueueList   dcq{std::move(buf)};
+   if (msgsz > 0) {
+      char* pout = rbuf.AllocPrefix(msgsz) - msgsz;
+      dcq.Read(pout, msgsz);
+      rbuf.SetPrefixUsed(pout);
+   }
+   // buf 可能有 BufferNodeWaiter 之類的控制節點, 必須透過 DcQueue 的 PopConsumed() 處理.
+   dcq.PopConsumedAll();
+   const size_t argsSize = msgsz + ByteArraySizeToBitvT(rbuf, msgsz);
+   RevPutLogBinLogHead(rbuf, argsSize, logArgs.UtcTime_, logArgs.Level_, static_cast<uint32_t>(thrid), 0);
+   gLogBinFile->AppendRec(logArgs.UtcTime_, rbuf.MoveOut());
+}
+
+void LogBinFileImpl::LogWriteToFile(const LogArgs& logArgs, BufferList&& buf) {
+   const std::string text = BufferTo<std::string>(buf);
+   // buf 可能有 BufferNodeWaiter 之類的控制節點, 必須透過 DcQueue 的 PopConsumed() 處理.
+   DcQueueList{std::move(buf)}.PopConsumedAll();
+
+   RevBufferList rbuf{kLogBlockNodeSize};
+   StrView       txt{&text};
+   while (!txt.empty()) {
+      // 從最後一行開始, 因為 RevBuffer 從後往前填入.
+      const char* pln = txt.end() - 1; // 最後一行的 '\n'
+      while (pln != txt.begin() && *(pln - 1) != '\n')
+         --pln;
+      StrView ln{pln, txt.end()};
+      txt.SetEnd(pln);
+      if (!ln.empty() && *(ln.end() - 1) == '\n')
+         ln.SetEnd(ln.end() - 1);
+
+      TimeStamp   utctm = logArgs.UtcTime_;
+      LogLevel    level = logArgs.Level_;
+      uint32_t    thrid = 0;
+      StrView     msg = ln;
+      const char* plv = (ln.size() > kDateTimeStrWidth + 1 ? StrView{ln.begin() + kDateTimeStrWidth + 1, ln.end()}.Find('[') : nullptr);
+      if (plv && ln.end() - plv >= static_cast<int>(sizeof(CstrLevelMap[0]) - 1)) {
+         for (unsigned L = 0; L < static_cast<unsigned>(LogLevel::Count); ++L) {
+            if (memcmp(plv, CstrLevelMap[L], sizeof(CstrLevelMap[L]) - 1) == 0) {
+               level = static_cast<LogLevel>(L);
+               utctm = StrTo(StrView{ln.begin(), kDateTimeStrWidth + 1}, utctm);
+               thrid = StrTo(StrView{ln.begin() + kDateTimeStrWidth + 1, plv}, thrid);
+               msg.SetBegin(plv + sizeof(CstrLevelMap[L]) - 1);
+               break;
+            }
+         }
+      }
+      const size_t szBefore = CalcDataSize(rbuf.cfront());
+      impl::LogBinStrToBitv(rbuf, msg.begin(), msg.size());
+      RevPutLogBinLogHead(rbuf, CalcDataSize(rbuf.cfront()) - szBefore, utctm, level, thrid, 0);
+   }
+   gLogBinFile->AppendRec(logArgs.UtcTime_, rbuf.MoveOut());
+}
+
+//--------------------------------------------------------------------------//
+
+fon9_API LogBinSiteId LogBinRegisterSite(const char* fileName, unsigned line, const char* funcName) {
+   LogBinSites&   sites = GetLogBinSites();
+   LogBinSiteReg  site{fileName, line, funcName};
+   LogBinSiteId   siteId;
+   {
+      std::lock_guard<std::mutex> lk{sites.Mutex_};
+      sites.Sites_.push_back(site);
+      siteId = static_cast<LogBinSiteId>(sites.Sites_.size());
+   }
+   if (impl::IsLogBinOpened_) {
+      // 若此時正在切換檔案: 新檔會在 OnFileRotate() 寫入全部的 Sites, 重複的 Site 記錄不會造成問題.
+      RevBufferList rbuf{kLogBlockNodeSize};
+      RevPutLogBinSite(rbuf, siteId, site);
+      LogBinFileImpl::gLogBinFile->Append(rbuf.MoveOut());
+   }
+   return siteId;
+}
+
+fon9_API File::Result InitLogBinWriteToFile(std::string fmtFileName,
+                                            FileRotate::TimeScale tmScale,
+                                            File::SizeType maxFileSize,
+                                            size_t highWaterLevelNodeCount,
+                                            bool isRedirectLog) {
+   return LogBinFileImpl::Init(FileRotateSP{new FileRotate(std::move(fmtFileName), tmScale, maxFileSize)},
+                               highWaterLevelNodeCount, isRedirectLog);
+}
+
+fon9_API bool WaitLogBinFileFlushed() {
+   if (LogBinFileImpl::gLogBinFile)
+      return LogBinFileImpl::gLogBinFile->WaitFlushed();
+   return false;
+}
+
+fon9_API void impl::LogBinAppend(LogLevel level, LogBinSiteId siteId, RevBufferList&& rbuf) {
+   const TimeStamp now = UtcNow();
+   // rbuf 只有此筆記錄的 Bitv(args).
+   RevPutLogBinLogHead(rbuf, CalcDataSize(rbuf.cfront()), now, level,
+                       static_cast<uint32_t>(ThisThread_.ThreadId_), siteId);
+   LogBinFileImpl::gLogBinFile->AppendRec(now, rbuf.MoveOut());
+}
+
+//--------------------------------------------------------------------------//
+
+fon9_API void BitvToTextAppend(DcQueue& buf, std::string& out) {
+   const byte* ptype = buf.Peek1();
+   if (ptype == nullptr)
+      Raise<BitvNeedsMore>("BitvToTextAppend: needs more");
+   const byte type = *ptype;
+   if ((type & 0x80) == 0 || type == fon9_BitvV_ByteArrayEmpty || (type & fon9_BitvT_Mask) == fon9_BitvT_ByteArray) {
+      BitvToStrAppend(buf, out);
+      return;
+   }
+   switch (type) {
+   case fon9_BitvV_Char0:
+      buf.PopConsumed(1);
+      return;
+   case fon9_BitvV_BoolTrue:
+   case fon9_BitvV_BoolFalse:
+      out.push_back(type == fon9_BitvV_BoolTrue ? 'Y' : 'N');
+      buf.PopConsumed(1);
+      return;
+   case fon9_BitvT_TimeStamp_Orig7:
+      {
+         TimeStamp ts;
+         BitvTo(buf, ts);
+         char  strbuf[kDateTimeStrWidth + 8];
+         char* pend = strbuf + sizeof(strbuf);
+         out.append(ToStrRev(pend, ts), pend);
+      }
+      return;
+   }
+   fon9_BitvNumR numr;
+   BitvToNumber(buf, numr);
+   switch (numr.Type_) {
+   case fon9_BitvNumT_Null:
+      return;
+   case fon9_BitvNumT_Zero:
+      out.push_back('0');
+      return;
+   case fon9_BitvNumT_Pos:
+   case fon9_BitvNumT_Neg:
+      break;
+   }
+   // 與 RevPrint(Decimal) 相同: 移除小數尾端的 0.
+   uintmax_t   num = (numr.Type_ == fon9_BitvNumT_Neg) ? static_cast<uintmax_t>(-static_cast<intmax_t>(numr.Num_)) : numr.Num_;
+   DecScaleT   scale = numr.Scale_;
+   while (scale > 0 && num % 10 == 0) {
+      num /= 10;
+      --scale;
+   }
+   char  strbuf[sizeof(uintmax_t) * 4];
+   char* pend = strbuf + sizeof(strbuf);
+   char* pout = UDecToStrRev(pend, num, scale);
+   if (numr.Type_ == fon9_BitvNumT_Neg)
+      *--pout = '-';
+   out.append(pout, pend);
+}
+
+//--------------------------------------------------------------------------//
+
+bool LogBinDecoder::ParseRec(LogBinRecKind kind, const char* pbeg, const char* pend) {
+   DcQueueFixedMem buf{pbeg, pend};
+   try {
+      switch (kind) {
+      case LogBinRecKind::FileHead:
+         {
+            std::string magic;
+            BitvTo(buf, magic);
+            if (magic != kLogBinMagic)
+               return false;
+            unsigned ver = 0;
+            int      tzMinutes = 0;
+            BitvTo(buf, ver);
+            BitvTo(buf, tzMinutes);
+            this->Sites_.clear();
+            this->TimeZone_ = TimeZoneOffset::FromOffsetMinutes(tzMinutes);
+         }
+         return true;
+      case LogBinRecKind::Site:
+         {
+            LogBinSiteId siteId = 0;
+            BitvTo(buf, siteId);
+            if (siteId == 0)
+               return false;
+            if (this->Sites_.size() < siteId)
+               this->Sites_.resize(siteId);
+            LogBinSite& site = this->Sites_[siteId - 1];
+            BitvTo(buf, site.FileName_);
+            BitvTo(buf, site.Line_);
+            BitvTo(buf, site.FuncName_);
+         }
+         return true;
+      case LogBinRecKind::Log:
+         if (pend - pbeg < static_cast<int>(kLogBinLogHeadSize))
+            return false;
+         this->Rec_.UtcTime_.SetOrigValue(GetBigEndian<TimeStamp::OrigType>(pbeg));
+         this->Rec_.Level_ = static_cast<LogLevel>(pbeg[sizeof(TimeStamp::OrigType)]);
+         pbeg += sizeof(TimeStamp::OrigType) + 1;
+         this->Rec_.ThreadId_ = GetBigEndian<uint32_t>(pbeg);
+         this->Rec_.SiteId_ = GetBigEndian<LogBinSiteId>(pbeg + sizeof(uint32_t));
+         buf.PopConsumed(kLogBinLogHeadSize);
+         this->Rec_.Site_ = this->GetSite(this->Rec_.SiteId_);
+         this->Rec_.Text_.clear();
+         while (!buf.empty())
+            BitvToTextAppend(buf, this->Rec_.Text_);
+         if (this->OnLogRec_)
+            this->OnLogRec_(this->Rec_);
+         return true;
+      }
+   }
+   catch (BitvDecodeError&) {
+   }
+   return false;
+}
+
+size_t LogBinDecoder::Feed(const void* mem, size_t size) {
+   const char* pbeg;
+   const char* pend;
+   if (this->Pending_.empty()) {
+      pbeg = static_cast<const char*>(mem);
+      pend = pbeg + size;
+   }
+   else {
+      this->Pending_.append(static_cast<const char*>(mem), size);
+      pbeg = this->Pending_.data();
+      pend = pbeg + this->Pending_.size();
+   }
+   size_t count = 0;
+   while (static_cast<size_t>(pend - pbeg) >= kLogBinRecHeadSize) {
+      const size_t recSize = kLogBinRecHeadSize + GetBigEndian<uint32_t>(pbeg + 1);
+      if (static_cast<size_t>(pend - pbeg) < recSize)
+         break;
+      const LogBinRecKind kind = static_cast<LogBinRecKind>(*pbeg);
+      switch (kind) {
+      case LogBinRecKind::FileHead:
+      case LogBinRecKind::Site:
+      case LogBinRecKind::Log:
+         if (!this->ParseRec(kind, pbeg + kLogBinRecHeadSize, pbeg + recSize))
+            ++this->BadRecCount_;
+         else if (kind == LogBinRecKind::Log)
+            ++count;
+         break;
+      default: // 不認識的記錄: 可能是新版的格式, 略過.
+         ++this->BadRecCount_;
+         break;
+      }
+      pbeg += recSize;
+   }
+   std::string rest{pbeg, pend};
+   this->Pending_.swap(rest);
+   return count;
+}
+
+std::string LogBinDecoder::ToText(const LogBinRec& rec, bool isShowSite) const {
+   RevBufferList rbuf{kLogBlockNodeSize};
+   if (isShowSite && rec.Site_)
+      RevPrint(rbuf, "|@", rec.Site_->FileName_, ':', rec.Site_->Line_);
+   RevPrint(rbuf, rec.Text_);
+   // 與 ThreadId::ThreadIdStr_ 相同: " nnnnn", 最少 5 碼.
+   char  thrid[32];
+   char* pend = thrid + sizeof(thrid);
+   char* pout = UIntToStrRev(pend, rec.ThreadId_);
+   while (pend - pout < 5)
+      *--pout = ' ';
+   *--pout = ' ';
+   RevPrint(rbuf, StrView{pout, pend}, GetLevelStr(rec.Level_));
+   RevPut_Date_Time_us(rbuf, rec.UtcTime_ + this->TimeZone_);
+   return BufferTo<std::string>(rbuf.MoveOut());
+}
+
+} // namespace
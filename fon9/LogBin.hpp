@@ -0,0 +1,269 @@
+﻿/// \file fon9/LogBin.hpp
+///
+/// 二進位 log 檔(LogBin):
+/// - 每筆記錄: 時間、LogLevel、ThreadId、CallSiteId、使用 Bitv 編碼的參數.
+/// - 寫入時不需要格式化文字(日期時間、thread id 字串、數值...), 檔案也比較小.
+/// - 使用 fon9_LOGB_INFO(...) 等寫入; 透過 LogBinDecoder 或 tools/f9logbin 轉成文字.
+///
+/// 檔案格式, 每筆記錄: RecKind(1 byte) + BodySize(uint32_t BigEndian) + Body;
+/// - LogBinRecKind::FileHead: 每個檔案的開頭(或重新開啟時)
+///   - Bitv(kLogBinMagic) + Bitv(version) + Bitv(TimeZoneOffset 分鐘數) + Bitv(UtcTime 開檔時間)
+///   - 之後必定會有目前已註冊的全部 LogBinRecKind::Site;
+///   - 解碼時遇到 FileHead, 必須清除之前的 Site 資料.
+/// - LogBinRecKind::Site: Bitv(SiteId) + Bitv(FileName) + Bitv(Line) + Bitv(FuncName)
+/// - LogBinRecKind::Log:  固定長度的頭部(kLogBinLogHeadSize) + Bitv(args)...
+///   - UtcTime(TimeStamp::GetOrigValue(), int64_t BigEndian) + LogLevel(1 byte)
+///     + ThreadId(uint32_t BigEndian) + SiteId(uint32_t BigEndian)
+///   - 使用固定長度: 寫入時只需要一次 AllocPrefix(), 不用逐欄編碼.
+///   - SiteId == 0: 由 fon9_LOG() 轉入的文字 log, 此時 args 為一個字串(已格式化的訊息).
+///
+/// \author fonwinz@gmail.com
+#ifndef __fon9_LogBin_hpp__
+#define __fon9_LogBin_hpp__
+#include "fon9/Log.hpp"
+#include "fon9/BitvEncode.hpp"
+#include "fon9/FileAppender.hpp"
+#include "fon9/ThreadId.hpp"
+
+fon9_BEFORE_INCLUDE_STD;
+#include <string>
+#include <vector>
+#include <functional>
+fon9_AFTER_INCLUDE_STD;
+
+namespace fon9 {
+
+enum class LogBinRecKind : char {
+   FileHead = 'H',
+   Site = 'S',
+   Log = 'L',
+};
+/// RecKind(1) + BodySize(4)
+enum : unsigned {
+   kLogBinRecHeadSize = 5,
+   /// LogBinRecKind::Log 的固定頭部: UtcTime(8) + LogLevel(1) + ThreadId(4) + SiteId(4)
+   kLogBinLogHeadSize = 17,
+   kLogBinVersion = 1,
+};
+constexpr char kLogBinMagic[] = "fon9.LogBin";
+
+using LogBinSiteId = uint32_t;
+
+/// \ingroup Misc
+/// 註冊 call-site, 返回 SiteId(從 1 開始).
+/// 由 fon9_LOGB() 在每個 call-site 第一次執行時呼叫.
+/// 若 LogBin 檔已開啟, 會立即寫入 LogBinRecKind::Site;
+fon9_API LogBinSiteId LogBinRegisterSite(const char* fileName, unsigned line, const char* funcName);
+
+/// \ingroup Misc
+/// 開啟 LogBin 檔, 參數的意義同 InitLogWriteToFile();
+/// \param isRedirectLog = true: 使用 SetLogWriter(), 讓 fon9_LOG() 的文字 log 也寫入 LogBin 檔(SiteId = 0).
+fon9_API File::Result InitLogBinWriteToFile(std::string fmtFileName,
+                                            FileRotate::TimeScale tmScale,
+                                            File::SizeType maxFileSize,
+                                            size_t highWaterLevelNodeCount,
+                                            bool isRedirectLog);
+fon9_API bool WaitLogBinFileFlushed();
+
+namespace impl {
+/// 是否已開啟 LogBin 檔: InitLogBinWriteToFile() 成功.
+extern fon9_API bool IsLogBinOpened_;
+/// rbuf 已填入 Bitv(args), 在此加上記錄的頭部之後, 寫入 LogBin 檔.
+fon9_API void LogBinAppend(LogLevel level, LogBinSiteId siteId, RevBufferList&& rbuf);
+
+/// 字串: 長度 <= 0x80 時直接在此填入, 避免呼叫 ByteArrayToBitv_NoEmpty().
+inline void LogBinStrToBitv(RevBufferList& rbuf, const char* str, size_t len) {
+   if (fon9_LIKELY(0 < len && len <= 0x80)) {
+      char* pout = rbuf.AllocPrefix(len + 1) - len;
+      memcpy(pout, str, len);
+      *--pout = static_cast<char>(len - 1);
+      rbuf.SetPrefixUsed(pout);
+   }
+   else {
+      ByteArrayToBitv(rbuf, str, len);
+   }
+}
+
+template <class T>
+inline auto LogBinValueToBitv(RevBufferList& rbuf, const T& value, int) -> decltype(ToBitv(rbuf, value), void()) {
+   ToBitv(rbuf, value);
+}
+/// 沒有提供 ToBitv() 的型別: 先用 RevPrint() 轉成字串.
+template <class T>
+inline void LogBinValueToBitv(RevBufferList& rbuf, const T& value, ...) {
+   const std::string str = RevPrintTo<std::string>(value);
+   LogBinStrToBitv(rbuf, str.c_str(), str.size());
+}
+
+/// 參數的 Bitv 編碼; 字串類的參數使用 LogBinStrToBitv();
+template <class T>
+struct LogBinArg {
+   static void Put(RevBufferList& rbuf, const T& value) {
+      LogBinValueToBitv(rbuf, value, 0);
+   }
+};
+/// 字串常數 or char[]: 與 ToBitv(const char (&ary)[arysz]) 相同, 若最後為 EOS 則移除.
+template <size_t arysz>
+struct LogBinArg<char[arysz]> {
+   static void Put(RevBufferList& rbuf, const char (&ary)[arysz]) {
+      LogBinStrToBitv(rbuf, ary, arysz - (ary[arysz - 1] == 0));
+   }
+};
+template <>
+struct LogBinArg<const char*> {
+   static void Put(RevBufferList& rbuf, const char* value) {
+      LogBinStrToBitv(rbuf, value, strlen(value));
+   }
+};
+template <>
+struct LogBinArg<char*> : public LogBinArg<const char*> {
+};
+template <>
+struct LogBinArg<StrView> {
+   static void Put(RevBufferList& rbuf, const StrView& value) {
+      LogBinStrToBitv(rbuf, value.begin(), value.size());
+   }
+};
+template <>
+struct LogBinArg<std::string> {
+   static void Put(RevBufferList& rbuf, const std::string& value) {
+      LogBinStrToBitv(rbuf, value.c_str(), value.size());
+   }
+};
+
+inline void LogBinArgsToBitv(RevBufferList&) {
+}
+/// RevBuffer 從後往前填入, 所以先處理最後的參數.
+template <class T, class... ArgsT>
+inline void LogBinArgsToBitv(RevBufferList& rbuf, const T& value, const ArgsT&... args) {
+   LogBinArgsToBitv(rbuf, args...);
+   LogBinArg<T>::Put(rbuf, value);
+}
+} // namespace impl
+
+/// \ingroup Misc
+/// 將 args 使用 Bitv 編碼後寫入 LogBin 檔.
+/// 若 LogBin 檔尚未開啟, 則與 fon9_LOG() 相同: 立即格式化後透過 LogWrite() 寫入.
+template <class... ArgsT>
+inline void LogBinWrite(LogLevel level, LogBinSiteId siteId, const ArgsT&... args) {
+   RevBufferList rbuf{kLogBlockNodeSize};
+   if (fon9_LIKELY(impl::IsLogBinOpened_)) {
+      impl::LogBinArgsToBitv(rbuf, args...);
+      impl::LogBinAppend(level, siteId, std::move(rbuf));
+   }
+   else {
+      RevPutChar(rbuf, '\n');
+      RevPrint(rbuf, args...);
+      LogWrite(level, std::move(rbuf));
+   }
+}
+
+/// \ingroup Misc
+/// 與 fon9_LOG() 相同的用法(但不支援 fon9::Fmt{}), 寫入 LogBin 檔.
+#define fon9_LOGB(level, ...) do {                                                     \
+   if (fon9_UNLIKELY(level >= fon9::LogLevel_)) {                                      \
+      static const fon9::LogBinSiteId siteId_ = fon9::LogBinRegisterSite(__FILE__, __LINE__, __func__); \
+      fon9::LogBinWrite(level, siteId_, __VA_ARGS__);                                  \
+   }                                                                                   \
+} while(0)
+
+#ifdef fon9_NOLOG_TRACE
+#define fon9_LOGB_TRACE(...)  do{}while(0)
+#else
+#define fon9_LOGB_TRACE(...)  fon9_LOGB(fon9::LogLevel::Trace, __VA_ARGS__)
+#endif
+
+#ifdef fon9_NOLOG_DEBUG
+#define fon9_LOGB_DEBUG(...)  do{}while(0)
+#else
+#define fon9_LOGB_DEBUG(...)  fon9_LOGB(fon9::LogLevel::Debug, __VA_ARGS__)
+#endif
+
+#ifdef fon9_NOLOG_INFO
+#define fon9_LOGB_INFO(...)   do{}while(0)
+#else
+#define fon9_LOGB_INFO(...)   fon9_LOGB(fon9::LogLevel::Info, __VA_ARGS__)
+#endif
+
+#define fon9_LOGB_IMP(...)    fon9_LOGB(fon9::LogLevel::Important, __VA_ARGS__)
+#define fon9_LOGB_WARN(...)   fon9_LOGB(fon9::LogLevel::Warn, __VA_ARGS__)
+#define fon9_LOGB_ERROR(...)  fon9_LOGB(fon9::LogLevel::Error, __VA_ARGS__)
+#define fon9_LOGB_FATAL(...)  fon9_LOGB(fon9::LogLevel::Fatal, __VA_ARGS__)
+
+//--------------------------------------------------------------------------//
+
+fon9_WARN_DISABLE_PADDING;
+struct LogBinSite {
+   std::string FileName_;
+   unsigned    Line_{0};
+   std::string FuncName_;
+};
+
+/// LogBinDecoder 解出的一筆 log.
+struct LogBinRec {
+   TimeStamp            UtcTime_;
+   LogLevel             Level_;
+   uint32_t             ThreadId_;
+   LogBinSiteId         SiteId_;
+   /// SiteId_ == 0 或找不到 SiteId_ 時為 nullptr.
+   const LogBinSite*    Site_;
+   /// 將參數依序轉成文字後的結果.
+   std::string          Text_;
+};
+
+/// \ingroup Misc
+/// 解析 LogBin 檔的內容.
+/// - 可分段餵入資料, 例: 持續讀取(tail)正在寫入的檔案.
+class fon9_API LogBinDecoder {
+   fon9_NON_COPY_NON_MOVE(LogBinDecoder);
+   std::vector<LogBinSite> Sites_;
+   std::string             Pending_;
+   TimeZoneOffset          TimeZone_;
+   LogBinRec               Rec_;
+   uint64_t                BadRecCount_{0};
+
+   bool ParseRec(LogBinRecKind kind, const char* pbeg, const char* pend);
+
+public:
+   using FnOnLogRec = std::function<void(const LogBinRec& rec)>;
+   FnOnLogRec  OnLogRec_;
+
+   LogBinDecoder() = default;
+   LogBinDecoder(FnOnLogRec fn) : OnLogRec_{std::move(fn)} {
+   }
+
+   /// 解析 [mem, mem+size) 之中完整的記錄, 剩餘不完整的部分, 會保留到下次 Feed();
+   /// 返回解析的 log 筆數.
+   size_t Feed(const void* mem, size_t size);
+   /// 尚未解析的資料量(不完整的最後一筆).
+   size_t GetPendingSize() const {
+      return this->Pending_.size();
+   }
+   /// 無法解析的記錄數量.
+   uint64_t GetBadRecCount() const {
+      return this->BadRecCount_;
+   }
+   /// 檔案標頭記錄的時區.
+   TimeZoneOffset GetTimeZone() const {
+      return this->TimeZone_;
+   }
+   const LogBinSite* GetSite(LogBinSiteId siteId) const {
+      return (0 < siteId && siteId <= this->Sites_.size() && !this->Sites_[siteId - 1].FileName_.empty())
+         ? &this->Sites_[siteId - 1] : nullptr;
+   }
+
+   /// 將 rec 轉成與文字 log 相同的格式:
+   /// `YYYYMMDD-HHMMSS.uuuuuu thrid[LEVEL]Text_`; 若 isShowSite, 則在尾端加上 `|@FileName:Line`;
+   /// 不含換行字元.
+   std::string ToText(const LogBinRec& rec, bool isShowSite) const;
+};
+fon9_WARN_POP;
+
+/// \ingroup Misc
+/// 將 buf 的一個 Bitv 值(任意型別), 轉成文字之後加到 out 尾端.
+/// - 數值(整數、Decimal)、字串、char、bool、TimeStamp(fon9_BitvT_TimeStamp_Orig7);
+/// - 不支援 Container, 拋出 BitvTypeNotMatch;
+fon9_API void BitvToTextAppend(DcQueue& buf, std::string& out);
+
+} // namespaces
+#endif//__fon9_LogBin_hpp__
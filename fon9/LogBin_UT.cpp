@@ -0,0 +1,223 @@
+﻿// \file fon9/LogBin_UT.cpp
+// \author fonwinz@gmail.com
+#define _CRT_SECURE_NO_WARNINGS
+#include "fon9/TestTools.hpp"
+#include "fon9/LogBin.hpp"
+#include "fon9/LogRing.hpp"
+#include "fon9/LogFile.hpp"
+#include "fon9/ThreadTools.hpp"
+#include "fon9/buffer/DcQueueList.hpp"
+#include <mutex>
+
+//--------------------------------------------------------------------------//
+static std::mutex    UtLogMutex_;
+static std::string   UtLogText_;
+static void UtLogWriter(const fon9::LogArgs&, fon9::BufferList&& buf) {
+   std::string str = fon9::BufferTo<std::string>(buf);
+   fon9::BufferListConsumeErr(std::move(buf), std::errc::bad_message);
+   std::lock_guard<std::mutex> lk{UtLogMutex_};
+   UtLogText_.append(str);
+}
+static std::string UtLogTakeText() {
+   std::lock_guard<std::mutex> lk{UtLogMutex_};
+   std::string res;
+   res.swap(UtLogText_);
+   return res;
+}
+static std::string ReadFileContent(const std::string& fname) {
+   fon9::File fd;
+   std::string res;
+   if (!fd.Open(fname, fon9::FileMode::Read))
+      return res;
+   auto fsz = fd.GetFileSize();
+   if (!fsz)
+      return res;
+   res.resize(fsz.GetResult());
+   auto rdsz = fd.Read(0, &*res.begin(), res.size());
+   res.resize(rdsz ? rdsz.GetResult() : 0);
+   return res;
+}
+
+struct UtRec {
+   fon9::LogBinRec   Rec_;
+   std::string       SiteFileName_;
+   unsigned          SiteLine_;
+   std::string       TextLine_;
+};
+using UtRecs = std::vector<UtRec>;
+static UtRecs DecodeAll(const std::string& content, size_t chunkSize) {
+   UtRecs               recs;
+   fon9::LogBinDecoder  dec;
+   dec.OnLogRec_ = [&recs, &dec](const fon9::LogBinRec& rec) {
+      recs.emplace_back();
+      UtRec& back = recs.back();
+      back.Rec_ = rec;
+      back.SiteLine_ = 0;
+      if (rec.Site_) {
+         back.SiteFileName_ = rec.Site_->FileName_;
+         back.SiteLine_ = rec.Site_->Line_;
+      }
+      back.TextLine_ = dec.ToText(rec, false);
+   };
+   size_t count = 0;
+   for (size_t pos = 0; pos < content.size(); pos += chunkSize)
+      count += dec.Feed(content.data() + pos, std::min(chunkSize, content.size() - pos));
+   if (count != recs.size() || dec.GetPendingSize() != 0 || dec.GetBadRecCount() != 0)
+      recs.clear();
+   return recs;
+}
+static const UtRec* FindRec(const UtRecs& recs, fon9::StrView text) {
+   for (const UtRec& rec : recs) {
+      if (fon9::ToStrView(rec.Rec_.Text_) == text)
+         return &rec;
+   }
+   return nullptr;
+}
+
+//--------------------------------------------------------------------------//
+void TestLogBin(const std::string& fname) {
+   fon9::SetLogWriter(&UtLogWriter, fon9::TimeZoneOffset{});
+   fon9_LOGB_INFO("NotOpened|v=", 123);
+   fon9_CheckTestResult("Not opened: write text log.", UtLogTakeText().find("[INFO ]NotOpened|v=123\n") != std::string::npos);
+
+   remove(fname.c_str());
+   const fon9::TimeStamp tmBeg = fon9::UtcNow();
+   fon9_CheckTestResult("InitLogBinWriteToFile()", !!fon9::InitLogBinWriteToFile(fname, fon9::TimeChecker::TimeScale::No, 0, 0, true));
+
+   std::string      str{"std::string"};
+   char             cstr[] = "char[]";
+   const unsigned   lnArgs = __LINE__; fon9_LOGB_INFO("Args|str=", str, "|cstr=", cstr, "|sv=", fon9::StrView{"StrView"}, "|ch=", 'K',
+                  "|dec=", fon9::Decimal<int64_t, 6>(-42.42), "|u=", 123u, "|i=", -5, "|zero=", 0, "|b=", true);
+   fon9_LOGB_WARN("Empty|", std::string{}, "|null=", fon9::Decimal<int64_t, 2>::Null(), "|end");
+   fon9_LOG_ERROR("Redirect|v=", 456);
+   fon9::LogRingStart(fon9::LogRingArgs{});
+   fon9_LOGR_WARN("Redirect|ring=", 789);
+   fon9::LogRingStop();
+
+   // 多個 thread 同時寫入: 每個 thread 的順序不變, 不遺失.
+   static const unsigned kThreadCount = 4;
+   static const unsigned kLogCount = 10000;
+   std::vector<std::thread> thrs;
+   for (unsigned T = 0; T < kThreadCount; ++T) {
+      thrs.emplace_back([T]() {
+         for (unsigned L = 0; L < kLogCount; ++L)
+            fon9_LOGB_INFO("Seq|thr=", T, "|seq=", L);
+      });
+   }
+   fon9::JoinThreads(thrs);
+   fon9::WaitLogBinFileFlushed();
+   const fon9::TimeStamp tmEnd = fon9::UtcNow();
+
+   const std::string content = ReadFileContent(fname);
+   UtRecs recs = DecodeAll(content, content.size());
+   fon9_CheckTestResult("Decode.", !recs.empty());
+
+   const UtRec* rec = FindRec(recs, "Args|str=std::string|cstr=char[]|sv=StrView|ch=K|dec=-42.42|u=123|i=-5|zero=0|b=Y");
+   fon9_CheckTestResult("Args: to text.", rec != nullptr);
+   fon9_CheckTestResult("Args: call-site.", rec->SiteLine_ == lnArgs
+                        && rec->SiteFileName_.find("LogBin_UT.cpp") != std::string::npos);
+   fon9_CheckTestResult("Args: header.", rec->Rec_.Level_ == fon9::LogLevel::Info
+                        && rec->Rec_.ThreadId_ == fon9::ThisThread_.ThreadId_
+                        && tmBeg <= rec->Rec_.UtcTime_ && rec->Rec_.UtcTime_ <= tmEnd
+                        && rec->TextLine_.find(fon9::ThisThread_.GetThreadIdStr().begin()) == fon9::kDateTimeStrWidth + 1);
+   rec = FindRec(recs, "Empty||null=|end");
+   fon9_CheckTestResult("Empty & null.", rec != nullptr && rec->Rec_.Level_ == fon9::LogLevel::Warn);
+   rec = FindRec(recs, "Redirect|v=456");
+   fon9_CheckTestResult("Redirect fon9_LOG().", rec != nullptr && rec->Rec_.SiteId_ == 0 && rec->Rec_.Site_ == nullptr
+                        && rec->Rec_.Level_ == fon9::LogLevel::Error
+                        && rec->Rec_.ThreadId_ == fon9::ThisThread_.ThreadId_
+                        && tmBeg <= rec->Rec_.UtcTime_ && rec->Rec_.UtcTime_ <= tmEnd);
+   rec = FindRec(recs, "Redirect|ring=789");
+   fon9_CheckTestResult("Redirect fon9_LOGR().", rec != nullptr && rec->Rec_.SiteId_ == 0
+                        && rec->Rec_.Level_ == fon9::LogLevel::Warn
+                        && rec->Rec_.ThreadId_ == fon9::ThisThread_.ThreadId_);
+
+   std::vector<unsigned> seqs(kThreadCount, 0);
+   bool isOK = true;
+   for (const UtRec& r : recs) {
+      fon9::StrView ctx{&r.Rec_.Text_};
+      if (ctx.size() < 8 || memcmp(ctx.begin(), "Seq|thr=", 8) != 0)
+         continue;
+      ctx.SetBegin(ctx.begin() + 8);
+      const unsigned thr = fon9::StrTo(fon9::StrFetchNoTrim(ctx, '|'), 0u);
+      fon9::StrFetchNoTrim(ctx, '=');
+      const unsigned seq = fon9::StrTo(ctx, 0u);
+      if (thr >= kThreadCount || seqs[thr] != seq)
+         isOK = false;
+      else
+         ++seqs[thr];
+   }
+   for (unsigned seq : seqs)
+      isOK = isOK && (seq == kLogCount);
+   fon9_CheckTestResult("Threads: in order, no loss.", isOK);
+
+   // 分段餵入: 例如 tail 正在寫入的檔案.
+   for (size_t chunkSize : {1u, 7u, 100u, 4096u}) {
+      UtRecs parts = DecodeAll(content, chunkSize);
+      isOK = (parts.size() == recs.size());
+      for (size_t idx = 0; isOK && idx < parts.size(); ++idx)
+         isOK = (parts[idx].TextLine_ == recs[idx].TextLine_);
+      std::string msg = "Feed: chunkSize=" + std::to_string(chunkSize);
+      fon9_CheckTestResult(msg.c_str(), isOK);
+   }
+}
+
+//--------------------------------------------------------------------------//
+// 比較 fon9_LOG() 文字 log 檔, 與 fon9_LOGB() 的 LogBin 檔: 呼叫端的耗時 & 檔案大小.
+template <class Function>
+double BenchLog(const char* name, Function&& fn, unsigned count, void (*fnFlush)()) {
+   fon9::StopWatch stopWatch;
+   for (unsigned L = 0; L < count; ++L)
+      fn(L);
+   const double span = stopWatch.StopTimer();
+   fnFlush();
+   std::cout << name << ": " << (span * 1e9 / count) << " ns/log" << std::endl;
+   return span;
+}
+void BenchLogBin(unsigned count) {
+   const std::string fnameText{"./logs/LogBin_UT.log"};
+   const std::string fnameBin{"./logs/LogBin_UT.bench.f9lb"};
+   remove(fnameText.c_str());
+   remove(fnameBin.c_str());
+
+   fon9::InitLogWriteToFile(fnameText, fon9::TimeChecker::TimeScale::No, 0, 0);
+   BenchLog("fon9_LOG ", [](unsigned L) {
+      fon9_LOG_INFO("Bench|seq=", L, "|px=", fon9::Decimal<int64_t, 6>(123.45), "|qty=", 1000u, "|side=", 'B', "|", "symbol");
+   }, count, []() { fon9::WaitLogFileFlushed(); });
+   // 重新開啟新的 LogBin 檔: 新檔必須有全部的 Sites, 才能獨立解碼.
+   fon9::InitLogBinWriteToFile(fnameBin, fon9::TimeChecker::TimeScale::No, 0, 0, true);
+   BenchLog("fon9_LOGB", [](unsigned L) {
+      fon9_LOGB_INFO("Bench|seq=", L, "|px=", fon9::Decimal<int64_t, 6>(123.45), "|qty=", 1000u, "|side=", 'B', "|", "symbol");
+   }, count, []() { fon9::WaitLogBinFileFlushed(); });
+
+   const std::string content = ReadFileContent(fnameBin);
+   const UtRecs      recs = DecodeAll(content, 1024 * 64);
+   size_t textSize = 0;
+   size_t benchCount = 0;
+   for (const UtRec& r : recs) {
+      if (r.Rec_.Text_.compare(0, 6, "Bench|") != 0)
+         continue;
+      ++benchCount;
+      textSize += r.TextLine_.size() + 1;
+      if (r.SiteLine_ == 0)
+         benchCount = 0;
+   }
+   std::cout << "TextFileSize=" << ReadFileContent(fnameText).size()
+             << "|LogBinFileSize=" << content.size()
+             << "|DecodedTextSize=" << textSize << std::endl;
+   fon9_CheckTestResult("Bench: decode the reopened file.", benchCount == count);
+   fon9_CheckTestResult("Bench: LogBin file is smaller.", content.size() < textSize);
+}
+
+//--------------------------------------------------------------------------//
+int main(int argc, char** argv) {
+#if defined(_MSC_VER) && defined(_DEBUG)
+   _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+#endif
+   fon9::AutoPrintTestInfo utinfo{"LogBin"};
+   TestLogBin("./logs/LogBin_UT.f9lb");
+
+   utinfo.PrintSplitter();
+   const unsigned count = (argc > 1 ? static_cast<unsigned>(atoi(argv[1])) : 0u);
+   BenchLogBin(count ? count : 100 * 1000);
+}
@@ -0,0 +1,372 @@
+﻿// \file fon9/LogRing.cpp
+// \author fonwinz@gmail.com
+#include "fon9/LogRing.hpp"
+#include "fon9/ThreadId.hpp"
+#include "fon9/ThreadTools.hpp"
+
+fon9_BEFORE_INCLUDE_STD;
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <algorithm>
+fon9_AFTER_INCLUDE_STD;
+
+namespace fon9 {
+namespace impl {
+
+fon9_API std::atomic<bool> IsLogRingRunning_{false};
+
+fon9_WARN_DISABLE_PADDING;
+struct LogRingRecHead {
+   /// 包含 LogRingRecHead 的大小, 8 bytes 對齊.
+   uint32_t          RecSize_;
+   LogLevel          Level_;
+   TimeStamp         UtcTime_;
+   /// nullptr 表示: 此筆為 ring 尾端的填充, 下一筆從 ring 開頭開始.
+   FnLogRingFormat   FnFormat_;
+};
+fon9_WARN_POP;
+static_assert(sizeof(LogRingRecHead) % 8 == 0, "sizeof(LogRingRecHead) must be a multiple of 8.");
+
+/// 單一 thread 寫入(producer), 由 writer thread 讀出(consumer).
+/// - 位置(Tail_, Head_...) 為持續累加的 bytes 數, 實際位置 = (pos & Mask_);
+/// - 一筆記錄不會跨越 ring 的尾端:
+///   - 若尾端剩餘空間 < sizeof(LogRingRecHead): 直接從 ring 開頭開始;
+///   - 否則在尾端放一筆 FnFormat_ == nullptr 的填充記錄.
+class LogRing {
+   fon9_NON_COPY_NON_MOVE(LogRing);
+   std::vector<uint64_t>   Buffer_;
+public:
+   const uint32_t          Size_;
+   const uint32_t          Mask_;
+
+   // producer 使用.
+   char                    PaddingP___[64];
+   std::atomic<uint64_t>   Tail_{0};
+   uint64_t                HeadCache_{0};
+   uint64_t                PendingTail_{0};
+   /// 只有 producer 會改變.
+   std::atomic<uint64_t>   DroppedCount_{0};
+
+   // consumer 使用.
+   char                    PaddingC___[64 - sizeof(uint64_t) * 2];
+   std::atomic<uint64_t>   Head_{0};
+   /// writer thread 已取出的位置, 格式化並寫入 log 之後, 才會更新 Head_;
+   uint64_t                ReadPos_{0};
+   uint64_t                TailSnapshot_{0};
+   uint64_t                DroppedReported_{0};
+   /// writer thread 取出, 尚未寫入 log 的記錄.
+   const LogRingRecHead*   Peeked_{nullptr};
+
+   std::atomic<bool>       IsThreadEnded_{false};
+   uint8_t                 ThreadIdStrWidth_;
+   char                    ThreadIdStr_[sizeof(ThreadId::ThreadIdStr_)];
+   char                    Padding___[5];
+   const ThreadId::IdType  ThreadId_{ThisThread_.ThreadId_};
+
+   LogRing(uint32_t size)
+      : Buffer_(size / sizeof(uint64_t))
+      , Size_{size}
+      , Mask_{size - 1} {
+      const StrView thrid = ThisThread_.GetThreadIdStr();
+      this->ThreadIdStrWidth_ = static_cast<uint8_t>(thrid.size());
+      memcpy(this->ThreadIdStr_, thrid.begin(), thrid.size());
+   }
+   StrView GetThreadIdStr() const {
+      return StrView{this->ThreadIdStr_, this->ThreadIdStrWidth_};
+   }
+   LogRingRecHead* Ptr(uint64_t pos) {
+      return reinterpret_cast<LogRingRecHead*>(reinterpret_cast<char*>(this->Buffer_.data()) + (pos & this->Mask_));
+   }
+   /// 在 writer thread 取出下一筆記錄(不超過 TailSnapshot_), 跳過填充的部分.
+   const LogRingRecHead* Peek() {
+      if (this->Peeked_)
+         return this->Peeked_;
+      while (this->ReadPos_ < this->TailSnapshot_) {
+         const uint32_t rem = this->Size_ - static_cast<uint32_t>(this->ReadPos_ & this->Mask_);
+         if (rem < sizeof(LogRingRecHead)) {
+            this->ReadPos_ += rem;
+            continue;
+         }
+         const LogRingRecHead* rec = this->Ptr(this->ReadPos_);
+         this->ReadPos_ += rec->RecSize_;
+         if (rec->FnFormat_)
+            return this->Peeked_ = rec;
+      }
+      return nullptr;
+   }
+};
+
+//--------------------------------------------------------------------------//
+
+class LogRingMgr {
+   fon9_NON_COPY_NON_MOVE(LogRingMgr);
+   /// 每次格式化後, 呼叫一次 LogWrite() 的最多筆數.
+   enum { kBatchCount = 256 };
+
+   std::mutex              RingsMutex_;
+   std::vector<LogRing*>   Rings_;
+
+   std::mutex              StartStopMutex_;
+   std::thread             Thread_;
+
+   std::mutex              Mutex_;
+   std::condition_variable CondWriter_;
+   std::condition_variable CondFlushed_;
+   uint64_t                FlushReqId_{0};
+   uint64_t                FlushDoneId_{0};
+   TimeInterval            PollInterval_;
+   bool                    IsStopRequested_{false};
+   bool                    IsWriterRunning_{false};
+
+   // 以下僅在 writer thread 使用.
+   std::vector<LogRing*>               DrainRings_;
+   std::vector<const LogRingRecHead*>  Batch_;
+   std::vector<LogRing*>               BatchRings_;
+
+   /// 將 Batch_ 的記錄格式化後(由後往前), 透過 LogWrite() 寫入, 然後更新 ring 的 Head_;
+   /// 若有 SetLogBodyWriter(), 則依序(由前往後)逐筆格式化, 不加文字頭部, 直接透過 FnLogBodyWriter 寫入.
+   void FlushBatch() {
+      if (this->Batch_.empty())
+         return;
+      if (FnLogBodyWriter fnBodyWriter = GetLogBodyWriter()) {
+         for (size_t idx = 0; idx < this->Batch_.size(); ++idx) {
+            const LogRingRecHead* rec = this->Batch_[idx];
+            RevBufferList rbuf{kLogBlockNodeSize};
+            RevPutChar(rbuf, '\n');
+            rec->FnFormat_(rbuf, reinterpret_cast<const char*>(rec + 1));
+            fnBodyWriter(LogArgs{rec->Level_, rec->UtcTime_}, this->BatchRings_[idx]->ThreadId_, rbuf.MoveOut());
+         }
+      }
+      else {
+         RevBufferList rbuf{kLogBlockNodeSize};
+         for (size_t idx = this->Batch_.size(); idx > 0;) {
+            const LogRingRecHead* rec = this->Batch_[--idx];
+            RevPutChar(rbuf, '\n');
+            rec->FnFormat_(rbuf, reinterpret_cast<const char*>(rec + 1));
+            AddLogHeader(rbuf, rec->UtcTime_, rec->Level_, this->BatchRings_[idx]->GetThreadIdStr());
+         }
+         const LogRingRecHead* first = this->Batch_.front();
+         LogWrite(LogArgs{first->Level_, first->UtcTime_}, rbuf.MoveOut());
+      }
+      this->Batch_.clear();
+      this->BatchRings_.clear();
+      for (LogRing* ring : this->DrainRings_)
+         ring->Head_.store(ring->ReadPos_ - (ring->Peeked_ ? ring->Peeked_->RecSize_ : 0u),
+                           std::memory_order_release);
+   }
+   /// 依照時間順序, 合併全部 ring 的記錄後寫入 log.
+   /// 只處理到 ring 在此時的 Tail_, 返回處理的筆數.
+   size_t DrainAll() {
+      {
+         std::lock_guard<std::mutex> lk{this->RingsMutex_};
+         this->DrainRings_ = this->Rings_;
+      }
+      for (LogRing* ring : this->DrainRings_)
+         ring->TailSnapshot_ = ring->Tail_.load(std::memory_order_acquire);
+      size_t count = 0;
+      for (;;) {
+         LogRing*              minRing = nullptr;
+         const LogRingRecHead* minRec = nullptr;
+         for (LogRing* ring : this->DrainRings_) {
+            if (const LogRingRecHead* rec = ring->Peek()) {
+               if (minRec == nullptr || rec->UtcTime_ < minRec->UtcTime_) {
+                  minRec = rec;
+                  minRing = ring;
+               }
+            }
+         }
+         if (minRec == nullptr)
+            break;
+         minRing->Peeked_ = nullptr;
+         this->Batch_.push_back(minRec);
+         this->BatchRings_.push_back(minRing);
+         ++count;
+         if (this->Batch_.size() >= kBatchCount)
+            this->FlushBatch();
+      }
+      this->FlushBatch();
+      for (LogRing* ring : this->DrainRings_) {
+         const uint64_t dropped = ring->DroppedCount_.load(std::memory_order_relaxed);
+         if (fon9_UNLIKELY(dropped != ring->DroppedReported_)) {
+            fon9_LOG_WARN("LogRing.Dropped|thrid=", ring->GetThreadIdStr(),
+                          "|count=", dropped - ring->DroppedReported_, "|total=", dropped);
+            ring->DroppedReported_ = dropped;
+         }
+         if (ring->IsThreadEnded_.load(std::memory_order_acquire)
+             && ring->Head_.load(std::memory_order_relaxed) == ring->Tail_.load(std::memory_order_acquire)) {
+            {
+               std::lock_guard<std::mutex> lk{this->RingsMutex_};
+               this->Rings_.erase(std::find(this->Rings_.begin(), this->Rings_.end(), ring));
+            }
+            delete ring;
+         }
+      }
+      return count;
+   }
+   void ThrRun() {
+      SetCurrentThreadName("fon9.LogRing");
+      for (;;) {
+         std::unique_lock<std::mutex> lk{this->Mutex_};
+         const uint64_t     flushReqId = this->FlushReqId_;
+         const bool         isStopRequested = this->IsStopRequested_;
+         const TimeInterval pollInterval = this->PollInterval_;
+         lk.unlock();
+
+         const size_t count = this->DrainAll();
+         lk.lock();
+         if (this->FlushDoneId_ < flushReqId) {
+            this->FlushDoneId_ = flushReqId;
+            this->CondFlushed_.notify_all();
+         }
+         if (isStopRequested)
+            break;
+         if (count == 0 && this->FlushReqId_ == flushReqId && !this->IsStopRequested_)
+            this->CondWriter_.wait_for(lk, pollInterval.ToDuration());
+      }
+      std::lock_guard<std::mutex> lk{this->Mutex_};
+      this->IsWriterRunning_ = false;
+      this->FlushDoneId_ = this->FlushReqId_;
+      this->CondFlushed_.notify_all();
+   }
+
+public:
+   std::atomic<uint32_t>          RingSize_{0};
+   std::atomic<LogRingFullPolicy> FullPolicy_{LogRingFullPolicy::Drop};
+
+   LogRingMgr() = default;
+   ~LogRingMgr() {
+      this->Stop();
+      // 仍在執行的 thread 可能還會使用 ring, 所以只刪除已結束 thread 的 ring.
+      for (LogRing* ring : this->Rings_) {
+         if (ring->IsThreadEnded_.load(std::memory_order_acquire))
+            delete ring;
+      }
+   }
+
+   LogRing* MakeRing() {
+      LogRing* ring = new LogRing{this->RingSize_.load(std::memory_order_relaxed)};
+      std::lock_guard<std::mutex> lk{this->RingsMutex_};
+      this->Rings_.push_back(ring);
+      return ring;
+   }
+   bool Start(const LogRingArgs& args) {
+      uint32_t ringSize = 4096;
+      while (ringSize < args.RingSize_ && ringSize < 0x80000000u)
+         ringSize <<= 1;
+      this->RingSize_.store(ringSize, std::memory_order_relaxed);
+      this->FullPolicy_.store(args.FullPolicy_, std::memory_order_relaxed);
+      std::lock_guard<std::mutex> lkStart{this->StartStopMutex_};
+      {
+         std::lock_guard<std::mutex> lk{this->Mutex_};
+         this->PollInterval_ = args.PollInterval_;
+         if (this->Thread_.joinable())
+            return false;
+         this->IsStopRequested_ = false;
+         this->IsWriterRunning_ = true;
+      }
+      this->Thread_ = std::thread{&LogRingMgr::ThrRun, this};
+      IsLogRingRunning_.store(true, std::memory_order_relaxed);
+      return true;
+   }
+   void Stop() {
+      std::lock_guard<std::mutex> lkStart{this->StartStopMutex_};
+      if (!this->Thread_.joinable())
+         return;
+      IsLogRingRunning_.store(false, std::memory_order_relaxed);
+      {
+         std::lock_guard<std::mutex> lk{this->Mutex_};
+         this->IsStopRequested_ = true;
+         this->CondWriter_.notify_one();
+      }
+      this->Thread_.join();
+   }
+   void Flush() {
+      {
+         std::unique_lock<std::mutex> lk{this->Mutex_};
+         if (this->IsWriterRunning_) {
+            const uint64_t id = ++this->FlushReqId_;
+            this->CondWriter_.notify_one();
+            this->CondFlushed_.wait(lk, [this, id]() { return this->FlushDoneId_ >= id; });
+         }
+      }
+      WaitLogFlush();
+   }
+};
+static LogRingMgr LogRingMgr_;
+
+struct LogRingHolder {
+   LogRing* Ring_{nullptr};
+   ~LogRingHolder() {
+      if (this->Ring_)
+         this->Ring_->IsThreadEnded_.store(true, std::memory_order_release);
+   }
+};
+static thread_local LogRingHolder ThisThreadRing_;
+
+fon9_API char* LogRingAlloc(LogLevel level, size_t argsz, FnLogRingFormat fnFormat, bool& isFallback) {
+   LogRing* ring = ThisThreadRing_.Ring_;
+   if (fon9_UNLIKELY(ring == nullptr))
+      ring = ThisThreadRing_.Ring_ = LogRingMgr_.MakeRing();
+   const uint32_t need = static_cast<uint32_t>(sizeof(LogRingRecHead) + ((argsz + 7) & ~static_cast<size_t>(7)));
+   if (fon9_UNLIKELY(argsz > ring->Size_ / 2 || need > ring->Size_ / 2)) {
+      isFallback = true;
+      return nullptr;
+   }
+   uint64_t       pos = ring->Tail_.load(std::memory_order_relaxed);
+   const uint32_t rem = ring->Size_ - static_cast<uint32_t>(pos & ring->Mask_);
+   const uint32_t skip = (rem < need ? rem : 0u);
+   const uint64_t end = pos + skip + need;
+   if (fon9_UNLIKELY(end - ring->HeadCache_ > ring->Size_)) {
+      for (;;) {
+         ring->HeadCache_ = ring->Head_.load(std::memory_order_acquire);
+         if (end - ring->HeadCache_ <= ring->Size_)
+            break;
+         if (LogRingMgr_.FullPolicy_.load(std::memory_order_relaxed) == LogRingFullPolicy::Drop) {
+            ring->DroppedCount_.store(ring->DroppedCount_.load(std::memory_order_relaxed) + 1,
+                                      std::memory_order_relaxed);
+            isFallback = false;
+            return nullptr;
+         }
+         if (!IsLogRingRunning_.load(std::memory_order_relaxed)) {
+            isFallback = true;
+            return nullptr;
+         }
+         std::this_thread::yield();
+      }
+   }
+   if (skip) {
+      if (skip >= sizeof(LogRingRecHead)) {
+         LogRingRecHead* filler = ring->Ptr(pos);
+         filler->RecSize_ = skip;
+         filler->FnFormat_ = nullptr;
+      }
+      pos += skip;
+   }
+   LogRingRecHead* rec = ring->Ptr(pos);
+   rec->RecSize_ = need;
+   rec->Level_ = level;
+   rec->UtcTime_ = UtcNow();
+   rec->FnFormat_ = fnFormat;
+   ring->PendingTail_ = end;
+   return reinterpret_cast<char*>(rec + 1);
+}
+fon9_API void LogRingCommit() {
+   LogRing* ring = ThisThreadRing_.Ring_;
+   ring->Tail_.store(ring->PendingTail_, std::memory_order_release);
+}
+
+} // namespace impl
+
+fon9_API bool LogRingStart(const LogRingArgs& args) {
+   return impl::LogRingMgr_.Start(args);
+}
+fon9_API void LogRingStop() {
+   impl::LogRingMgr_.Stop();
+}
+fon9_API void LogRingFlush() {
+   impl::LogRingMgr_.Flush();
+}
+
+} // namespaces
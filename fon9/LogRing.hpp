@@ -0,0 +1,296 @@
+﻿/// \file fon9/LogRing.hpp
+///
+/// 每個 thread 一個 SPSC ring 的 log 機制:
+/// - 呼叫端(feed/order thread) 只記錄: 時間、LogLevel、格式化函式、參數的原始內容;
+/// - 在 writer thread 才執行 RevPrint() 格式化, 然後透過 LogWrite() 寫入 log.
+/// - 使用 fon9_LOGR_INFO(...) 等; 若 LogRing 尚未啟動, 則與 fon9_LOG_INFO(...) 相同, 立即格式化後寫入.
+///
+/// \author fonwinz@gmail.com
+#ifndef __fon9_LogRing_hpp__
+#define __fon9_LogRing_hpp__
+#include "fon9/Log.hpp"
+#include "fon9/TimeInterval.hpp"
+
+fon9_BEFORE_INCLUDE_STD;
+#include <string>
+#include <atomic>
+fon9_AFTER_INCLUDE_STD;
+
+namespace fon9 {
+
+/// \ingroup Misc
+/// 當 ring 已滿時的處理方式.
+enum class LogRingFullPolicy : uint8_t {
+   /// 丟棄此筆 log, 累計丟棄的數量, 由 writer thread 輸出 [WARN] 訊息.
+   Drop,
+   /// 等候 writer thread 消化 ring 之後再寫入.
+   Block,
+};
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup Misc
+/// LogRingStart() 的參數.
+struct LogRingArgs {
+   /// 每個 thread 的 ring 大小(bytes), 會調整為 2 的 n 次方, 最少 4K.
+   /// 超過 RingSize_ / 2 的單筆 log, 會直接格式化後寫入(與 fon9_LOG() 相同).
+   uint32_t          RingSize_{1024 * 256};
+   LogRingFullPolicy FullPolicy_{LogRingFullPolicy::Drop};
+   /// writer thread 沒有 log 時的休息時間.
+   TimeInterval      PollInterval_{TimeInterval_Millisecond(1)};
+};
+fon9_WARN_POP;
+
+/// \ingroup Misc
+/// 啟動 LogRing 的 writer thread, 格式化後的 log 透過 LogWrite() 寫入.
+/// - 已啟動的 thread ring 大小不會改變, 新的 RingSize_ 只影響之後建立的 ring.
+/// - 若已啟動, 則僅更新 FullPolicy_, PollInterval_; 並返回 false;
+fon9_API bool LogRingStart(const LogRingArgs& args);
+/// \ingroup Misc
+/// 將全部 ring 的內容寫入 log 之後, 結束 writer thread.
+/// 返回後 fon9_LOGR() 改成立即格式化後寫入.
+/// 在 LogRingStop() 執行時, 仍在寫入 ring 的 log 可能會遺失.
+fon9_API void LogRingStop();
+/// \ingroup Misc
+/// 等候在 LogRingFlush() 之前寫入 ring 的 log, 都已透過 LogWrite() 寫入,
+/// 然後呼叫 WaitLogFlush();
+fon9_API void LogRingFlush();
+
+namespace impl {
+using FnLogRingFormat = void (*)(RevBufferList& rbuf, const char* args);
+
+/// 是否已啟動 LogRing 的 writer thread.
+extern fon9_API std::atomic<bool> IsLogRingRunning_;
+
+/// 在 this_thread 的 ring 分配一筆記錄的空間.
+/// - 返回 nullptr:
+///   - isFallback == true:  LogRing 尚未啟動, 或 argsz 太大; 此時應直接格式化後寫入.
+///   - isFallback == false: ring 已滿, 已丟棄此筆 log.
+/// - 返回非 nullptr: 填入參數內容(argsz bytes)之後, 必須呼叫 LogRingCommit();
+fon9_API char* LogRingAlloc(LogLevel level, size_t argsz, FnLogRingFormat fnFormat, bool& isFallback);
+fon9_API void LogRingCommit();
+
+//--------------------------------------------------------------------------//
+
+/// 直接複製數值的參數(trivially copyable), 例: 整數, Decimal, TimeStamp...
+/// 若其中包含指標, 則指標所指的內容, 必須在格式化時仍有效(例: 字串常數).
+template <class T>
+struct LogRingArgPod {
+   const T& Value_;
+   size_t Size() const {
+      return sizeof(T);
+   }
+   char* Put(char* pout) const {
+      memcpy(pout, &this->Value_, sizeof(T));
+      return pout + sizeof(T);
+   }
+};
+/// 複製字串內容的參數: 長度(uint32_t) + 字串內容.
+struct LogRingArgStr {
+   StrView  Value_;
+   size_t Size() const {
+      return sizeof(uint32_t) + this->Value_.size();
+   }
+   char* Put(char* pout) const {
+      const uint32_t len = static_cast<uint32_t>(this->Value_.size());
+      memcpy(pout, &len, sizeof(len));
+      memcpy(pout += sizeof(len), this->Value_.begin(), len);
+      return pout + len;
+   }
+   static const char* Get(const char* pin, StrView& v) {
+      uint32_t len;
+      memcpy(&len, pin, sizeof(len));
+      pin += sizeof(len);
+      v.Reset(pin, pin + len);
+      return pin + len;
+   }
+};
+/// 無法直接複製的參數, 在呼叫端先轉成字串.
+struct LogRingArgText : public LogRingArgStr {
+   std::string Text_;
+   template <class T>
+   LogRingArgText(const T& v) : LogRingArgStr{StrView{}}, Text_{RevPrintTo<std::string>(v)} {
+      this->Value_ = ToStrView(this->Text_);
+   }
+   LogRingArgText(LogRingArgText&& rhs) : LogRingArgStr{StrView{}}, Text_{std::move(rhs.Text_)} {
+      this->Value_ = ToStrView(this->Text_);
+   }
+};
+
+/// 參數的打包(Prepare, 在呼叫端) 及 解包(Get, 在 writer thread).
+template <class T, bool isPod = std::is_trivially_copyable<T>::value>
+struct LogRingArg {
+   using Prepared = LogRingArgPod<T>;
+   static Prepared Prepare(const T& v) {
+      return Prepared{v};
+   }
+   using Holder = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+   static const char* Get(const char* pin, Holder& h) {
+      memcpy(&h, pin, sizeof(T));
+      return pin + sizeof(T);
+   }
+   static const T& Value(const Holder& h) {
+      return *reinterpret_cast<const T*>(&h);
+   }
+};
+template <class T>
+struct LogRingArg<T, false> {
+   using Prepared = LogRingArgText;
+   static Prepared Prepare(const T& v) {
+      return Prepared{v};
+   }
+   using Holder = StrView;
+   static const char* Get(const char* pin, Holder& h) {
+      return LogRingArgStr::Get(pin, h);
+   }
+   static StrView Value(const Holder& h) {
+      return h;
+   }
+};
+struct LogRingArgStrView {
+   using Prepared = LogRingArgStr;
+   using Holder = StrView;
+   static const char* Get(const char* pin, Holder& h) {
+      return LogRingArgStr::Get(pin, h);
+   }
+   static StrView Value(const Holder& h) {
+      return h;
+   }
+};
+template <>
+struct LogRingArg<StrView, true> : public LogRingArgStrView {
+   static Prepared Prepare(const StrView& v) {
+      return Prepared{v};
+   }
+};
+template <>
+struct LogRingArg<std::string, false> : public LogRingArgStrView {
+   static Prepared Prepare(const std::string& v) {
+      return Prepared{ToStrView(v)};
+   }
+};
+template <>
+struct LogRingArg<const char*, true> : public LogRingArgStrView {
+   static Prepared Prepare(const char* v) {
+      return Prepared{StrView_cstr(v)};
+   }
+};
+template <>
+struct LogRingArg<char*, true> : public LogRingArg<const char*, true> {
+};
+template <>
+struct LogRingArg<Fmt, false> : public LogRingArgStrView {
+   static Prepared Prepare(const Fmt& v) {
+      return Prepared{v.GetFmtStr()};
+   }
+   static Fmt Value(const Holder& h) {
+      return Fmt{h};
+   }
+};
+template <>
+struct LogRingArg<Fmt, true> : public LogRingArg<Fmt, false> {
+};
+
+//--------------------------------------------------------------------------//
+
+inline size_t LogRingArgsSize() {
+   return 0;
+}
+template <class P, class... Ps>
+inline size_t LogRingArgsSize(const P& p, const Ps&... ps) {
+   return p.Size() + LogRingArgsSize(ps...);
+}
+inline void LogRingArgsPut(char*) {
+}
+template <class P, class... Ps>
+inline void LogRingArgsPut(char* pout, const P& p, const Ps&... ps) {
+   LogRingArgsPut(p.Put(pout), ps...);
+}
+
+/// 在 writer thread 依序取出參數, 然後呼叫 RevPrint(rbuf, 全部參數...);
+template <class... Ts>
+struct LogRingUnpacker;
+template <>
+struct LogRingUnpacker<> {
+   template <class... Vs>
+   static void Run(RevBufferList& rbuf, const char*, const Vs&... vs) {
+      RevPrint(rbuf, vs...);
+   }
+};
+template <class T, class... Ts>
+struct LogRingUnpacker<T, Ts...> {
+   template <class... Vs>
+   static void Run(RevBufferList& rbuf, const char* pin, const Vs&... vs) {
+      typename LogRingArg<T>::Holder h;
+      pin = LogRingArg<T>::Get(pin, h);
+      LogRingUnpacker<Ts...>::Run(rbuf, pin, vs..., LogRingArg<T>::Value(h));
+   }
+};
+template <class... Ts>
+void LogRingFormat(RevBufferList& rbuf, const char* args) {
+   LogRingUnpacker<Ts...>::Run(rbuf, args);
+}
+
+/// 返回 false 表示: 無法使用 LogRing, 必須直接格式化後寫入.
+template <class... Ps>
+inline bool LogRingWriteImpl(LogLevel level, FnLogRingFormat fnFormat, const Ps&... ps) {
+   bool  isFallback;
+   char* pout = LogRingAlloc(level, LogRingArgsSize(ps...), fnFormat, isFallback);
+   if (pout) {
+      LogRingArgsPut(pout, ps...);
+      LogRingCommit();
+      return true;
+   }
+   return !isFallback;
+}
+} // namespace impl
+
+/// \ingroup Misc
+/// 將 args 的原始內容放入 this_thread 的 ring, 在 writer thread 才會格式化.
+/// - 字串(const char*, std::string, StrView, Fmt) 會複製字串內容;
+/// - trivially copyable 的型別, 直接複製數值;
+/// - 其他型別, 在呼叫端先透過 RevPrint() 轉成字串.
+template <class... ArgsT>
+inline void LogRingWrite(LogLevel level, ArgsT&&... args) {
+   if (fon9_LIKELY(impl::IsLogRingRunning_.load(std::memory_order_relaxed))) {
+      if (fon9_LIKELY(impl::LogRingWriteImpl(level, &impl::LogRingFormat<decay_t<ArgsT>...>,
+                                             impl::LogRingArg<decay_t<ArgsT>>::Prepare(args)...)))
+         return;
+   }
+   RevBufferList rbuf{kLogBlockNodeSize};
+   RevPutChar(rbuf, '\n');
+   RevPrint(rbuf, std::forward<ArgsT>(args)...);
+   LogWrite(level, std::move(rbuf));
+}
+
+/// \ingroup Misc
+/// 與 fon9_LOG() 相同的用法, 但使用 LogRingWrite(): 延遲到 writer thread 才格式化.
+#define fon9_LOGR(level, ...) do {                          \
+   if (fon9_UNLIKELY(level >= fon9::LogLevel_))             \
+      fon9::LogRingWrite(level, __VA_ARGS__);               \
+} while(0)
+
+#ifdef fon9_NOLOG_TRACE
+#define fon9_LOGR_TRACE(...)  do{}while(0)
+#else
+#define fon9_LOGR_TRACE(...)  fon9_LOGR(fon9::LogLevel::Trace, __VA_ARGS__)
+#endif
+
+#ifdef fon9_NOLOG_DEBUG
+#define fon9_LOGR_DEBUG(...)  do{}while(0)
+#else
+#define fon9_LOGR_DEBUG(...)  fon9_LOGR(fon9::LogLevel::Debug, __VA_ARGS__)
+#endif
+
+#ifdef fon9_NOLOG_INFO
+#define fon9_LOGR_INFO(...)   do{}while(0)
+#else
+#define fon9_LOGR_INFO(...)   fon9_LOGR(fon9::LogLevel::Info, __VA_ARGS__)
+#endif
+
+#define fon9_LOGR_IMP(...)    fon9_LOGR(fon9::LogLevel::Important, __VA_ARGS__)
+#define fon9_LOGR_WARN(...)   fon9_LOGR(fon9::LogLevel::Warn, __VA_ARGS__)
+#define fon9_LOGR_ERROR(...)  fon9_LOGR(fon9::LogLevel::Error, __VA_ARGS__)
+#define fon9_LOGR_FATAL(...)  fon9_LOGR(fon9::LogLevel::Fatal, __VA_ARGS__)
+
+} // namespaces
+#endif//__fon9_LogRing_hpp__
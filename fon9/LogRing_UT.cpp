@@ -0,0 +1,214 @@
+﻿// \file fon9/LogRing_UT.cpp
+// \author fonwinz@gmail.com
+#define _CRT_SECURE_NO_WARNINGS
+#include "fon9/TestTools.hpp"
+#include "fon9/LogRing.hpp"
+#include "fon9/LogFile.hpp"
+#include "fon9/ThreadTools.hpp"
+#include "fon9/CharVector.hpp"
+#include "fon9/StrTo.hpp"
+#include "fon9/buffer/DcQueueList.hpp"
+#include <mutex>
+
+//--------------------------------------------------------------------------//
+static std::mutex    UtLogMutex_;
+static std::string   UtLogText_;
+static void UtLogWriter(const fon9::LogArgs&, fon9::BufferList&& buf) {
+   std::string str = fon9::BufferTo<std::string>(buf);
+   fon9::BufferListConsumeErr(std::move(buf), std::errc::bad_message);
+   std::lock_guard<std::mutex> lk{UtLogMutex_};
+   UtLogText_.append(str);
+}
+static std::string UtLogTakeText() {
+   std::lock_guard<std::mutex> lk{UtLogMutex_};
+   std::string res;
+   res.swap(UtLogText_);
+   return res;
+}
+/// 取出每行 log 的內容(第一個 ']' 之後).
+static fon9::StrView UtLogContent(fon9::StrView ln) {
+   const char* pspl = ln.Find(']');
+   return pspl ? fon9::StrView{pspl + 1, ln.end()} : ln;
+}
+
+//--------------------------------------------------------------------------//
+void TestLogRing() {
+   fon9::SetLogWriter(&UtLogWriter, fon9::TimeZoneOffset{});
+   fon9_LOGR_INFO("NotStarted|v=", 123);
+   fon9_CheckTestResult("Not started: write immediately.", UtLogTakeText().find("[INFO ]NotStarted|v=123\n") != std::string::npos);
+
+   fon9::LogRingArgs args;
+   args.RingSize_ = 1024 * 64;
+   args.FullPolicy_ = fon9::LogRingFullPolicy::Block;
+   fon9_CheckTestResult("LogRingStart()", fon9::LogRingStart(args));
+
+   // 參數在 fon9_LOGR() 返回後就被釋放: LogRing 必須複製內容.
+   {
+      std::string      str{"std::string"};
+      char             cstr[] = "char[]";
+      fon9::CharVector cv{fon9::StrView{"CharVector"}};
+      fon9_LOGR_INFO("Args|str=", str, "|cstr=", cstr, "|sv=", fon9::StrView{"StrView"}, "|cv=", cv,
+                     "|ch=", 'K', "|dec=", fon9::Decimal<int64_t, 6>(-42.42), "|u=", 123u);
+      fon9_LOGR_WARN(fon9::Fmt{"Fmt|{0}|{1:x}|{2}"}, str, 255, cstr);
+      str.assign("xxxxxxxxxxx");
+      memset(cstr, 'y', sizeof(cstr) - 1);
+      cv.assign("zzzzzzzzzz");
+   }
+   fon9::LogRingFlush();
+   std::string text = UtLogTakeText();
+   fon9_CheckTestResult("Args: copy values.",
+                        text.find("[INFO ]Args|str=std::string|cstr=char[]|sv=StrView|cv=CharVector|ch=K|dec=-42.42|u=123\n") != std::string::npos
+                        && text.find("[WARN ]Fmt|std::string|ff|char[]\n") != std::string::npos);
+
+   // 多個 thread 同時寫入: 每個 thread 的順序不變, 不遺失, 輸出依照時間排序.
+   static const unsigned kThreadCount = 4;
+   static const unsigned kLogCount = 20000;
+   std::vector<std::thread> thrs;
+   for (unsigned T = 0; T < kThreadCount; ++T) {
+      thrs.emplace_back([T]() {
+         for (unsigned L = 0; L < kLogCount; ++L)
+            fon9_LOGR_INFO("Seq|thr=", T, "|seq=", L, "|", std::string(L % 50, 'a'));
+      });
+   }
+   fon9::JoinThreads(thrs);
+   fon9::LogRingFlush();
+   text = UtLogTakeText();
+   std::vector<unsigned> seqs(kThreadCount, 0);
+   fon9::StrView     txt{&text};
+   std::string       prevTime;
+   bool              isOK = true;
+   while (!txt.empty() && isOK) {
+      fon9::StrView ln = fon9::StrFetchNoTrim(txt, '\n');
+      if (ln.size() < 22)
+         continue;
+      std::string tm(ln.begin(), 22);
+      if (tm < prevTime)
+         isOK = false;
+      prevTime = tm;
+      fon9::StrView ctx = UtLogContent(ln);
+      if (!ctx.begin() || memcmp(ctx.begin(), "Seq|thr=", 8) != 0)
+         continue;
+      ctx.SetBegin(ctx.begin() + 8);
+      const unsigned thr = fon9::StrTo(fon9::StrFetchNoTrim(ctx, '|'), 0u);
+      fon9::StrFetchNoTrim(ctx, '=');
+      const unsigned seq = fon9::StrTo(fon9::StrFetchNoTrim(ctx, '|'), 0u);
+      if (thr >= kThreadCount || seqs[thr] != seq || ctx.size() != seq % 50)
+         isOK = false;
+      else
+         ++seqs[thr];
+   }
+   for (unsigned seq : seqs)
+      isOK = isOK && (seq == kLogCount);
+   fon9_CheckTestResult("Threads: in order, no loss, sorted by time.", isOK);
+
+   // 小的 ring + Drop: 放不下的被丟棄, 並輸出 LogRing.Dropped.
+   fon9::LogRingStop();
+   args.RingSize_ = 1024 * 4;
+   args.FullPolicy_ = fon9::LogRingFullPolicy::Drop;
+   args.PollInterval_ = fon9::TimeInterval_Second(1);
+   fon9_CheckTestResult("LogRingStart(Drop)", fon9::LogRingStart(args));
+   std::thread{[]() {
+      for (unsigned L = 0; L < 1000; ++L)
+         fon9_LOGR_INFO("Drop|seq=", L, "|", std::string(60, 'd'));
+   }}.join();
+   fon9::LogRingFlush();
+   text = UtLogTakeText();
+   unsigned received = 0;
+   uint64_t dropped = 0;
+   txt = fon9::StrView{&text};
+   while (!txt.empty()) {
+      fon9::StrView ctx = UtLogContent(fon9::StrFetchNoTrim(txt, '\n'));
+      if (fon9::StrView{ctx.begin(), std::min(ctx.size(), size_t{5})} == "Drop|")
+         ++received;
+      else if (fon9::StrView{ctx.begin(), std::min(ctx.size(), size_t{16})} == "LogRing.Dropped|") {
+         const char* pcount = ctx.Find('=');
+         pcount = pcount ? fon9::StrView{pcount, ctx.end()}.Find('|') : nullptr;
+         if (pcount && (pcount = fon9::StrView{pcount, ctx.end()}.Find('=')) != nullptr)
+            dropped += fon9::StrTo(fon9::StrView{pcount + 1, ctx.end()}, 0u);
+      }
+   }
+   std::cout << "received=" << received << "|dropped=" << dropped << std::endl;
+   fon9_CheckTestResult("Drop: received + dropped == 1000.", dropped > 0 && received + dropped == 1000);
+   fon9::LogRingStop();
+   fon9::UnsetLogWriter(&UtLogWriter);
+}
+
+//--------------------------------------------------------------------------//
+// 測試方法與 ext/logvs 相同: 每個 thread 寫入 iterations 筆, 計算每次呼叫的延遲.
+static void NopLogWriter(const fon9::LogArgs&, fon9::BufferList&& buf) {
+   fon9::BufferListConsumeErr(std::move(buf), std::errc::bad_message);
+}
+uint64_t timestamp_now() {
+   return static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch() / std::chrono::nanoseconds(1));
+}
+template <class Function>
+void run_log_benchmark(Function& fn, unsigned iterations, std::vector<uint64_t>& latencies) {
+   latencies.reserve(iterations);
+   char const * const cstrBenchmark = "benchmark";
+   for (unsigned i = 0; i < iterations; ++i) {
+      uint64_t begin = timestamp_now();
+      fn(i, cstrBenchmark);
+      uint64_t end = timestamp_now();
+      latencies.push_back(end - begin);
+   }
+}
+template <class Function>
+void run_benchmark(Function&& fn, unsigned threadCount, unsigned iterations, const char* loggerName) {
+   std::vector<std::thread>            threads;
+   std::vector<std::vector<uint64_t>>  results(threadCount);
+   for (unsigned i = 0; i < threadCount; ++i)
+      threads.emplace_back(run_log_benchmark<Function>, std::ref(fn), iterations, std::ref(results[i]));
+   fon9::JoinThreads(threads);
+   fon9::LogRingFlush();
+
+   std::vector<uint64_t> latencies;
+   for (auto& r : results)
+      latencies.insert(latencies.end(), r.begin(), r.end());
+   std::sort(latencies.begin(), latencies.end());
+   uint64_t sum = 0; for (auto v : latencies) { sum += v; }
+   const size_t sz = latencies.size();
+   fon9::RevBufferFixedSize<1024> rbuf;
+   rbuf.RewindEOS();
+   fon9::RevFormat(rbuf, "{0:-10}|{1:3}|{2:,8}|{3:,8}|{4:,8}|{5:,8}|{6:,10}|{7:,8.0}|\n",
+                   loggerName, threadCount,
+                   latencies[sz * 500 / 1000],
+                   latencies[sz * 900 / 1000],
+                   latencies[sz * 990 / 1000],
+                   latencies[sz * 999 / 1000],
+                   latencies[sz - 1],
+                   fon9::Decimal<int64_t, 6>(static_cast<double>(sum) / static_cast<double>(sz)));
+   std::cout << rbuf.GetCurrent();
+}
+void BenchLatency(unsigned iterations) {
+   fon9::SetLogWriter(&NopLogWriter, fon9::TimeZoneOffset{});
+   std::cout << "logger    |thr|    50th|    90th|    99th|  99.9th|     Worst| Average|" << std::endl;
+   auto fnLog = [](unsigned i, char const * const cstr) {
+      fon9_LOG_INFO("Logging ", cstr, i, 0, 'K', fon9::Decimal<int64_t, 6>(-42.42));
+   };
+   auto fnLogR = [](unsigned i, char const * const cstr) {
+      fon9_LOGR_INFO("Logging ", cstr, i, 0, 'K', fon9::Decimal<int64_t, 6>(-42.42));
+   };
+   fon9::LogRingArgs args;
+   args.FullPolicy_ = fon9::LogRingFullPolicy::Block;
+   args.RingSize_ = 1024 * 1024 * 4;
+   for (unsigned threadCount : {1u, 2u, 4u, 8u}) {
+      run_benchmark(fnLog, threadCount, iterations, "fon9_LOG");
+      fon9::LogRingStart(args);
+      run_benchmark(fnLogR, threadCount, iterations, "fon9_LOGR");
+      fon9::LogRingStop();
+   }
+   fon9::UnsetLogWriter(&NopLogWriter);
+}
+
+//--------------------------------------------------------------------------//
+int main(int argc, char** argv) {
+#if defined(_MSC_VER) && defined(_DEBUG)
+   _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+#endif
+   fon9::AutoPrintTestInfo utinfo{"LogRing"};
+   TestLogRing();
+
+   utinfo.PrintSplitter();
+   const unsigned iterations = (argc > 1 ? static_cast<unsigned>(atoi(argv[1])) : 0u);
+   BenchLatency(iterations ? iterations : 100 * 1000);
+}
@@ -103,6 +103,9 @@ public:
    ConstLocker Lock() const { return ConstLocker{*this}; }
    ConstLocker ConstLock() const { return ConstLocker{*this}; }
 
+   /// 若使用特殊的 Mutex(例: SeqLockMutex), 則可能需要在不鎖定的情況下使用 Mutex_;
+   const MutexT& GetMutex() const { return this->Mutex_; }
+
    static MustLock& StaticCast(BaseT& pbase) {
       return ContainerOf(pbase, &MustLock::Base_);
    }
@@ -1,6 +1,7 @@
 ﻿// \file fon9/PkCont.cpp
 // \author fonwinz@gmail.com
 #include "fon9/PkCont.hpp"
+#include "fon9/LatencyHist.hpp"
 #include "fon9/Log.hpp"
 
 namespace fon9 {
@@ -35,6 +36,7 @@ void PkContFeeder::PkContOnDropped(const void* pk, unsigned pksz, SeqT seq) {
    (void)pk; (void)pksz; (void)seq;
 }
 void PkContFeeder::FeedPacket(const void* pk, unsigned pksz, SeqT seq) {
+   fon9_LATENCY_SCOPE("PkContFeeder.FeedPacket");
    {  // lock this->PkPendings_;
       PkPendings::Locker pks{this->PkPendings_};
       if (fon9_LIKELY(seq == this->NextSeq_)) {
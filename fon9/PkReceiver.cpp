@@ -1,14 +1,194 @@
 ﻿// \file fon9/PkReceiver.cpp
 // \author fonwinz@gmail.com
 #include "fon9/PkReceiver.hpp"
+#include "fon9/LatencyHist.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define fon9_PK_XOR_X64
+fon9_BEFORE_INCLUDE_STD;
+#include <immintrin.h>
+#ifdef _MSC_VER
+#  include <intrin.h>
+#endif
+fon9_AFTER_INCLUDE_STD;
+#ifdef _MSC_VER
+#  define fon9_PK_XOR_AVX2_TARGET
+#else
+#  define fon9_PK_XOR_AVX2_TARGET   __attribute__((target("avx2")))
+#endif
+#endif
 
 namespace fon9 {
 
+static byte CalcPkXor_Byte(const byte* mem, size_t sz) {
+   byte cks = 0;
+   while (sz > 0) {
+      cks = static_cast<byte>(cks ^ *mem++);
+      --sz;
+   }
+   return cks;
+}
+/// 將 8 bytes 的 XOR 結果, 再合併成 1 byte.
+static inline byte FoldXor64(uint64_t v) {
+   v ^= (v >> 32);
+   v ^= (v >> 16);
+   v ^= (v >> 8);
+   return static_cast<byte>(v);
+}
+static byte CalcPkXor_Word64(const byte* mem, size_t sz) {
+   uint64_t acc = 0;
+   for (; sz >= sizeof(acc); sz -= sizeof(acc), mem += sizeof(acc)) {
+      uint64_t v;
+      memcpy(&v, mem, sizeof(v));
+      acc ^= v;
+   }
+   return static_cast<byte>(FoldXor64(acc) ^ CalcPkXor_Byte(mem, sz));
+}
+#ifdef fon9_PK_XOR_X64
+static inline byte FoldXor128(__m128i acc) {
+   const uint64_t lo = static_cast<uint64_t>(_mm_cvtsi128_si64(acc));
+   const uint64_t hi = static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc)));
+   return FoldXor64(lo ^ hi);
+}
+static byte CalcPkXor_Sse2(const byte* mem, size_t sz) {
+   __m128i acc = _mm_setzero_si128();
+   for (; sz >= sizeof(acc); sz -= sizeof(acc), mem += sizeof(acc))
+      acc = _mm_xor_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(mem)));
+   return static_cast<byte>(FoldXor128(acc) ^ CalcPkXor_Word64(mem, sz));
+}
+fon9_PK_XOR_AVX2_TARGET static byte CalcPkXor_Avx2(const byte* mem, size_t sz) {
+   __m256i acc = _mm256_setzero_si256();
+   for (; sz >= sizeof(acc); sz -= sizeof(acc), mem += sizeof(acc))
+      acc = _mm256_xor_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mem)));
+   __m128i acc128 = _mm_xor_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+   // 剩餘不足 32 bytes 的部分, 可能還有一個 16 bytes 的區塊.
+   // 不可呼叫 CalcPkXor_Sse2(): 在 YMM 尚未清除前執行 non-VEX 的 SSE 指令, 會有 AVX-SSE 轉換的延遲.
+   if (sz >= sizeof(acc128)) {
+      acc128 = _mm_xor_si128(acc128, _mm_loadu_si128(reinterpret_cast<const __m128i*>(mem)));
+      sz -= sizeof(acc128);
+      mem += sizeof(acc128);
+   }
+   return static_cast<byte>(FoldXor128(acc128) ^ CalcPkXor_Word64(mem, sz));
+}
+static bool IsCpuSupportAvx2() {
+#ifdef _MSC_VER
+   int regs[4];
+   __cpuid(regs, 0);
+   if (regs[0] < 7)
+      return false;
+   __cpuid(regs, 1);
+   // OSXSAVE(bit27) + AVX(bit28), 且 OS 有啟用 YMM 狀態保存.
+   if ((regs[2] & (3 << 27)) != (3 << 27) || (_xgetbv(0) & 6) != 6)
+      return false;
+   __cpuidex(regs, 7, 0);
+   return (regs[1] & (1 << 5)) != 0;
+#else
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+using FnCalcPkXor = byte (*)(const byte* mem, size_t sz);
+static FnCalcPkXor   FnCalcPkXor_{&CalcPkXor_Word64};
+static PkXorImpl     PkXorImpl_{PkXorImpl::Word64};
+static const PkXorImpl kPkXorImplAuto = SetPkXorImpl(PkXorImpl::Auto);
+
+fon9_API PkXorImpl SetPkXorImpl(PkXorImpl impl) {
+   switch (impl) {
+   case PkXorImpl::Auto:
+   #ifdef fon9_PK_XOR_X64
+      return SetPkXorImpl(IsCpuSupportAvx2() ? PkXorImpl::Avx2 : PkXorImpl::Sse2);
+   #else
+      return SetPkXorImpl(PkXorImpl::Word64);
+   #endif
+   case PkXorImpl::Byte:
+      FnCalcPkXor_ = &CalcPkXor_Byte;
+      break;
+   case PkXorImpl::Word64:
+      FnCalcPkXor_ = &CalcPkXor_Word64;
+      break;
+#ifdef fon9_PK_XOR_X64
+   case PkXorImpl::Sse2:
+      FnCalcPkXor_ = &CalcPkXor_Sse2;
+      break;
+   case PkXorImpl::Avx2:
+      if (!IsCpuSupportAvx2())
+         return PkXorImpl_;
+      FnCalcPkXor_ = &CalcPkXor_Avx2;
+      break;
+#else
+   case PkXorImpl::Sse2:
+   case PkXorImpl::Avx2:
+#endif
+   default:
+      return PkXorImpl_;
+   }
+   return PkXorImpl_ = impl;
+}
+fon9_API PkXorImpl GetPkXorImpl() {
+   return PkXorImpl_;
+}
+fon9_API byte CalcPkXor(const void* mem, size_t sz) {
+   return FnCalcPkXor_(reinterpret_cast<const byte*>(mem), sz);
+}
+//--------------------------------------------------------------------------//
 PkReceiver::~PkReceiver() {
 }
+bool PkReceiver::FeedCurrBlock(DcQueue& rxbuf) {
+   const auto        blk = rxbuf.PeekCurrBlock();
+   const char* const pbeg = reinterpret_cast<const char*>(blk.first);
+   const char* const pend = pbeg + blk.second;
+   const char*       pcur = pbeg;
+   bool              retval = true;
+   while (static_cast<size_t>(pend - pcur) >= this->PkHeadSize_) {
+      if (fon9_UNLIKELY(*pcur != this->kPkHeadLeader)) {
+         // 搜尋下一個 kPkHeadLeader.
+         const char* pnext = static_cast<const char*>(memchr(pcur, this->kPkHeadLeader, static_cast<size_t>(pend - pcur)));
+         if (pnext == nullptr)
+            pnext = pend;
+         this->DroppedBytes_ += static_cast<size_t>(pnext - pcur);
+         pcur = pnext;
+         continue;
+      }
+      const unsigned pksz = this->GetPkSize(pcur);
+      if (fon9_LIKELY(this->PkHeadSize_ + 2 < pksz && pksz < kMaxPacketSize)) {
+         if (fon9_UNLIKELY(static_cast<size_t>(pend - pcur) < pksz))
+            break; // 封包跨越區塊, 由 FeedBuffer() 使用 Peek() 處理.
+         if (fon9_LIKELY(pcur[pksz - 2] == 0x0d && pcur[pksz - 1] == 0x0a)) {
+            if (fon9_LIKELY(CalcCheckSum(pcur, pksz + 1) == 0)) {
+               ++this->ReceivedCount_;
+               if (!this->OnPkReceived(pcur, pksz)) {
+                  pcur += pksz;
+                  retval = false;
+                  break;
+               }
+            }
+            else {
+               ++this->ChkSumErrCount_;
+            }
+            pcur += pksz;
+            continue;
+         }
+      }
+      // 長度不合理, 或尾碼不是 0x0d, 0x0a: 繼續搜尋下一個 kPkHeadLeader.
+      ++pcur;
+      ++this->DroppedBytes_;
+   }
+   if (pcur != pbeg)
+      rxbuf.PopConsumed(static_cast<size_t>(pcur - pbeg));
+   return retval;
+}
 bool PkReceiver::FeedBuffer(DcQueue& rxbuf) {
+   fon9_LATENCY_SCOPE("PkReceiver.FeedBuffer");
    char  peekbuf[kMaxPacketSize];
-   while (const void* pkptr = rxbuf.Peek(peekbuf, this->PkHeadSize_)) {
+   for (;;) {
+      if (!this->FeedCurrBlock(rxbuf))
+         return false;
+      // 剩餘的資料: 跨越區塊的封包, 或不足一個 PkHead, 使用 Peek() 處理一個封包之後, 再回到 FeedCurrBlock().
+      const void* pkptr = rxbuf.Peek(peekbuf, this->PkHeadSize_);
+      if (pkptr == nullptr)
+         break;
       if (fon9_LIKELY(*static_cast<const char*>(pkptr) == this->kPkHeadLeader)) {
          const unsigned  pksz = this->GetPkSize(pkptr);
          if (fon9_LIKELY(this->PkHeadSize_ + 2 < pksz && pksz < kMaxPacketSize)) {
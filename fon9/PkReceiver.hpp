@@ -6,6 +6,29 @@
 
 namespace fon9 {
 
+/// \ingroup Misc.
+/// 計算 XOR CheckSum 的方式.
+enum class PkXorImpl : uint8_t {
+   /// 執行時偵測 CPU, 選擇最快的方式.
+   Auto,
+   /// 每次處理 1 byte.
+   Byte,
+   /// 每次處理 8 bytes, 適用於非 x86 的環境.
+   Word64,
+   /// x86-64: 每次處理 16 bytes.
+   Sse2,
+   /// x86-64: 每次處理 32 bytes, 需要 CPU 支援 AVX2.
+   Avx2,
+};
+/// 設定 CalcPkXor() 使用的方式, 通常僅用於測試效率.
+/// - 必須在沒有 PkReceiver 運作時設定.
+/// - 若 CPU 不支援 impl, 則不改變.
+/// - 返回設定後使用的方式.
+fon9_API PkXorImpl SetPkXorImpl(PkXorImpl impl);
+fon9_API PkXorImpl GetPkXorImpl();
+/// 計算 [mem..mem+sz) 每個 byte 的 XOR.
+fon9_API byte CalcPkXor(const void* mem, size_t sz);
+
 /// \ingroup Misc.
 /// 用來解析簡易的封包格式框架(例: 交易所行情格式: 台灣證交所、台灣期交所):
 /// - kPkHeadLeader(EscCode:27) ... CheckSum + TerminalCode(0x0d,0x0a).
@@ -14,6 +37,8 @@ namespace fon9 {
 /// - 每個資訊來源(io Session)對應一個 PkReceiver.
 /// - io Device 收到資料時, 丟到 PkReceiver::FeedBuffer()
 /// - 當收到一個封包時透過 PkReceiver::OnPkReceived() 通知衍生者處理.
+/// - 在 rxbuf 的連續記憶體區塊之中的封包, 直接在區塊內解析, 最後才一次 PopConsumed();
+///   只有跨越區塊的封包, 才需要使用 Peek() 複製到暫存區.
 class fon9_API PkReceiver {
    fon9_NON_COPY_NON_MOVE(PkReceiver);
 
@@ -43,14 +68,8 @@ public:
    bool FeedBuffer(DcQueue& rxbuf);
 
    static char CalcCheckSum(const char* pkL, unsigned pksz) {
-      const char* pkend = pkL + pksz - 4; // -4 = 排除 kPkHeadLeader, CheckSum, 0x0d, 0x0a.
-      char        cks = *++pkL; // ++pk = 排除 kPkHeadLeader.
-      while (pkL != pkend) {
-         fon9_GCC_WARN_DISABLE("-Wconversion");
-         cks ^= *++pkL;
-         fon9_GCC_WARN_POP;
-      }
-      return cks;
+      // +1 = 排除 kPkHeadLeader; -4 = 排除 kPkHeadLeader, CheckSum, 0x0d, 0x0a.
+      return static_cast<char>(CalcPkXor(pkL + 1, pksz - 4));
    }
 
    void ClearStatus() {
@@ -77,6 +96,12 @@ protected:
    /// \retval false 結束 FeedBuffer();
    /// \retval true  繼續 FeedBuffer();
    virtual bool OnPkReceived(const void* pk, unsigned pksz) = 0;
+
+private:
+   /// 解析 rxbuf 目前連續區塊裡面的完整封包.
+   /// 返回前會移除已處理的資料, 剩餘: 跨越區塊的封包, 或不足一個 PkHead 的資料.
+   /// \retval false 呼叫 OnPkReceived() 時返回 false.
+   bool FeedCurrBlock(DcQueue& rxbuf);
 };
 //--------------------------------------------------------------------------//
 
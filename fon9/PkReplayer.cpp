@@ -0,0 +1,354 @@
+﻿// \file fon9/PkReplayer.cpp
+// \author fonwinz@gmail.com
+#include "fon9/PkReplayer.hpp"
+#include "fon9/PkReceiver.hpp"
+#include "fon9/TsReceiver.hpp"
+#include "fon9/ThreadTools.hpp"
+#include "fon9/StrTo.hpp"
+#include "fon9/Log.hpp"
+
+fon9_BEFORE_INCLUDE_STD;
+#include <condition_variable>
+#include <deque>
+#include <string>
+fon9_AFTER_INCLUDE_STD;
+
+namespace fon9 {
+
+bool PkReplayArgs::SetTagValue(StrView tag, StrView value) {
+   if (tag == "Ts")
+      this->IsTsFile_ = (toupper(static_cast<unsigned char>(value.Get1st())) == 'Y');
+   else if (tag == "Shards")
+      this->ShardCount_ = StrTo(value, this->ShardCount_);
+   else if (tag == "Speed")
+      this->Speed_ = static_cast<double>(StrToDec(value, 3, static_cast<uint64_t>(this->Speed_ * 1000))) / 1000;
+   else if (tag == "From")
+      this->From_ = StrTo(value, this->From_);
+   else if (tag == "To")
+      this->To_ = StrTo(value, this->To_);
+   else
+      return false;
+   return true;
+}
+//--------------------------------------------------------------------------//
+enum : size_t {
+   /// 每個批次的封包數量.
+   kBatchPkCount = 1024,
+   /// 佇列中最多的批次數量, 超過時生產者等候, 避免佔用過多記憶體.
+   kQueueCapacity = 64,
+   /// 沒有 mmap 時, 每次 File::Read() 的資料量.
+   kReadBlockSize = 4 * 1024 * 1024,
+   /// 區塊結尾不完整的封包, 與下一個區塊合併時, 從下一個區塊取出的最大資料量.
+   /// 必須大於最大封包: PkReceiver::kMaxPacketSize 及 TsReceiver 的 (0xffff + kHeadSize).
+   kCarryMore = 0x10000 + 64,
+};
+struct PkReplayer::Batch {
+   struct Item {
+      /// nullptr 表示封包內容在 Data_[Offset_];
+      const void* Pk_;
+      size_t      Offset_;
+      unsigned    PkSize_;
+      char        Padding___[4];
+      TimeStamp   Time_;
+   };
+   std::vector<Item> Items_;
+   std::vector<char> Data_;
+
+   Batch() {
+      this->Items_.reserve(kBatchPkCount);
+   }
+   bool IsFull() const {
+      return this->Items_.size() >= kBatchPkCount;
+   }
+   void Add(const void* pk, unsigned pksz, TimeStamp pktm, bool isMemStable) {
+      this->Items_.emplace_back();
+      Item& item = this->Items_.back();
+      item.PkSize_ = pksz;
+      item.Time_ = pktm;
+      if (isMemStable)
+         item.Pk_ = pk;
+      else {
+         item.Pk_ = nullptr;
+         item.Offset_ = this->Data_.size();
+         this->Data_.insert(this->Data_.end(), static_cast<const char*>(pk), static_cast<const char*>(pk) + pksz);
+      }
+   }
+   PkReplayPk GetPk(const Item& item) const {
+      PkReplayPk pk;
+      pk.Pk_ = (item.Pk_ ? item.Pk_ : this->Data_.data() + item.Offset_);
+      pk.PkSize_ = item.PkSize_;
+      pk.Time_ = item.Time_;
+      return pk;
+   }
+};
+/// 有容量限制的批次佇列: 一個(或多個)生產者, 一個消費者.
+class PkReplayer::BatchQueue {
+   fon9_NON_COPY_NON_MOVE(BatchQueue);
+   std::mutex              Mutex_;
+   std::condition_variable CvNotEmpty_;
+   std::condition_variable CvNotFull_;
+   std::deque<BatchUP>     Batches_;
+   bool                    IsClosed_{false};
+public:
+   BatchQueue() = default;
+   void Push(BatchUP&& batch) {
+      std::unique_lock<std::mutex> lk{this->Mutex_};
+      while (this->Batches_.size() >= kQueueCapacity)
+         this->CvNotFull_.wait(lk);
+      this->Batches_.push_back(std::move(batch));
+      this->CvNotEmpty_.notify_one();
+   }
+   /// 返回 nullptr 表示已 Close() 且已取完.
+   BatchUP Pop() {
+      std::unique_lock<std::mutex> lk{this->Mutex_};
+      while (this->Batches_.empty()) {
+         if (this->IsClosed_)
+            return BatchUP{};
+         this->CvNotEmpty_.wait(lk);
+      }
+      BatchUP retval = std::move(this->Batches_.front());
+      this->Batches_.pop_front();
+      this->CvNotFull_.notify_one();
+      return retval;
+   }
+   void Close() {
+      std::unique_lock<std::mutex> lk{this->Mutex_};
+      this->IsClosed_ = true;
+      this->CvNotEmpty_.notify_all();
+   }
+};
+struct PkReplayer::Shard {
+   BatchUP     Curr_;
+   BatchQueue  Queue_;
+   std::thread Thread_;
+};
+//--------------------------------------------------------------------------//
+class PkReplayer::TsFramer : public TsReceiver {
+   fon9_NON_COPY_NON_MOVE(TsFramer);
+   PkReplayer& Owner_;
+public:
+   bool  IsMemStable_{false};
+   TsFramer(PkReplayer& owner) : Owner_(owner) {
+   }
+   bool OnPkReceived(TimeStamp pktm, const void* pk, PkszT pksz) override {
+      this->Owner_.OnFramed(pk, pksz, pktm, this->IsMemStable_);
+      return !this->Owner_.IsStopRequested_.load(std::memory_order_relaxed);
+   }
+};
+class PkReplayer::RawFramer : public PkReceiver {
+   fon9_NON_COPY_NON_MOVE(RawFramer);
+   PkReplayer& Owner_;
+public:
+   bool  IsMemStable_{false};
+   RawFramer(PkReplayer& owner) : PkReceiver{owner.PkHeadSize_}, Owner_(owner) {
+   }
+   unsigned GetPkSize(const void* pkptr) override {
+      return this->Owner_.OnReplayGetPkSize(pkptr);
+   }
+   bool OnPkReceived(const void* pk, unsigned pksz) override {
+      this->Owner_.OnFramed(pk, pksz, TimeStamp::Null(), this->IsMemStable_);
+      return !this->Owner_.IsStopRequested_.load(std::memory_order_relaxed);
+   }
+};
+//--------------------------------------------------------------------------//
+PkReplayer::PkReplayer(unsigned pkHeadSize) : PkHeadSize_{pkHeadSize} {
+}
+PkReplayer::~PkReplayer() {
+}
+unsigned PkReplayer::OnReplayGetPkSize(const void* pkptr) {
+   (void)pkptr;
+   return 0;
+}
+void PkReplayer::OnReplaySequenceEnd() {
+}
+
+File::Result PkReplayer::Run(std::string fname, const PkReplayArgs& args) {
+   File  fd;
+   auto  res = fd.Open(fname, FileMode::Read);
+   if (!res)
+      return res;
+   this->Args_ = args;
+   this->IsStopRequested_.store(false, std::memory_order_relaxed);
+   this->FramedCount_ = this->DispatchedCount_ = this->DroppedBytes_ = 0;
+   this->PaceFirstTime_.AssignNull();
+   this->ReaderBatch_.reset(new Batch);
+   this->SeqQueue_.reset(new BatchQueue);
+   this->Shards_.clear();
+   this->Shards_.reserve(args.ShardCount_);
+   for (unsigned L = 0; L < args.ShardCount_; ++L) {
+      this->Shards_.emplace_back(new Shard);
+      this->Shards_.back()->Curr_.reset(new Batch);
+   }
+   // 全部的 shard 建立完畢後, 才啟動 thread, 避免 thread 執行期間 Shards_ 仍在異動.
+   for (unsigned L = 0; L < args.ShardCount_; ++L)
+      this->Shards_[L]->Thread_ = std::thread(&PkReplayer::ShardRun, this, L, this->Shards_[L].get());
+   std::thread seqThread(&PkReplayer::SequencerRun, this);
+
+   // 在 sequencer 及 shard 結束前, fmap 映射的記憶體都有效, 所以 reader 批次裡面的封包, 可直接使用 fmap 的記憶體.
+   FileMap fmap;
+   res = this->ReadAll(fd, fmap.Open(std::move(fname)).HasResult() ? &fmap : nullptr);
+
+   this->PushReaderBatch();
+   this->SeqQueue_->Close();
+   seqThread.join();
+   for (ShardUP& shard : this->Shards_) {
+      if (shard->Thread_.joinable())
+         shard->Thread_.join();
+   }
+   this->Shards_.clear();
+   this->SeqQueue_.reset();
+   this->ReaderBatch_.reset();
+   if (res)
+      res = File::Result{this->FramedCount_};
+   return res;
+}
+File::Result PkReplayer::ReadAll(File& fd, FileMap* fmap) {
+   auto fsize = fd.GetFileSize();
+   if (!fsize)
+      return fsize;
+   const File::PosType  endPos = (this->Args_.To_ && this->Args_.To_ < fsize.GetResult())
+                                 ? this->Args_.To_ : fsize.GetResult();
+   std::vector<byte>    rdbuf;
+   if (fmap == nullptr)
+      rdbuf.resize(kReadBlockSize);
+
+   TsFramer       tsFramer{*this};
+   RawFramer      rawFramer{*this};
+   auto feed = [this, &tsFramer, &rawFramer](const void* mem, size_t sz, bool isMemStable) -> size_t {
+      DcQueueFixedMem dcq{mem, sz};
+      if (this->Args_.IsTsFile_) {
+         tsFramer.IsMemStable_ = isMemStable;
+         tsFramer.FeedBuffer(dcq);
+      }
+      else {
+         rawFramer.IsMemStable_ = isMemStable;
+         rawFramer.FeedBuffer(dcq);
+      }
+      return dcq.CalcSize();
+   };
+   std::string    carry; // 上一個區塊結尾不完整的封包.
+   File::PosType  pos = this->Args_.From_;
+   File::Result   res{0};
+   while (pos < endPos && !this->IsStopRequested_.load(std::memory_order_relaxed)) {
+      const byte*       mem;
+      File::SizeType    sz = endPos - pos;
+      bool              isMemStable;
+      if (fmap) {
+         File::SizeType viewsz;
+         if ((mem = fmap->Peek(pos, viewsz)) == nullptr) {
+            res = File::Result{std::errc::bad_address};
+            break;
+         }
+         if (sz > viewsz)
+            sz = viewsz;
+         isMemStable = true;
+      }
+      else {
+         if (sz > rdbuf.size())
+            sz = rdbuf.size();
+         res = fd.Read(pos, rdbuf.data(), sz);
+         if (!res || res.GetResult() == 0)
+            break;
+         sz = res.GetResult();
+         mem = rdbuf.data();
+         isMemStable = false;
+      }
+      size_t ofs = 0;
+      if (!carry.empty()) {
+         // 上一個區塊結尾的不完整封包, 與此區塊的開頭合併後解析.
+         const size_t carrySize = carry.size();
+         const size_t more = (sz < kCarryMore ? static_cast<size_t>(sz) : static_cast<size_t>(kCarryMore));
+         carry.append(reinterpret_cast<const char*>(mem), more);
+         const size_t used = carry.size() - feed(carry.data(), carry.size(), false);
+         if (used > carrySize)
+            ofs = used - carrySize;
+         else // 無法解析的資料, 拋棄.
+            this->DroppedBytes_ += carrySize;
+         carry.clear();
+      }
+      if (const size_t remain = feed(mem + ofs, static_cast<size_t>(sz) - ofs, isMemStable))
+         carry.assign(reinterpret_cast<const char*>(mem) + sz - remain, remain);
+      pos += sz;
+   }
+   this->DroppedBytes_ += carry.size();
+   this->DroppedBytes_ += rawFramer.GetDroppedBytes();
+   return res;
+}
+void PkReplayer::OnFramed(const void* pk, unsigned pksz, TimeStamp pktm, bool isMemStable) {
+   if (this->Args_.Speed_ > 0 && !pktm.IsNull())
+      this->PaceWait(pktm);
+   ++this->FramedCount_;
+   this->ReaderBatch_->Add(pk, pksz, pktm, isMemStable);
+   if (this->ReaderBatch_->IsFull())
+      this->PushReaderBatch();
+}
+void PkReplayer::PushReaderBatch() {
+   if (this->ReaderBatch_->Items_.empty())
+      return;
+   this->SeqQueue_->Push(std::move(this->ReaderBatch_));
+   this->ReaderBatch_.reset(new Batch);
+}
+void PkReplayer::PaceWait(TimeStamp pktm) {
+   const auto now = std::chrono::steady_clock::now();
+   if (this->PaceFirstTime_.IsNull()) {
+      this->PaceFirstTime_ = pktm;
+      this->PaceStart_ = now;
+      return;
+   }
+   const double secs = (pktm - this->PaceFirstTime_).To<double>() / this->Args_.Speed_;
+   const auto   target = this->PaceStart_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(secs));
+   if (target <= now)
+      return;
+   // 等候前, 先將已收到的封包送出, 避免封包在批次中延遲.
+   this->PushReaderBatch();
+   std::this_thread::sleep_until(target);
+}
+//--------------------------------------------------------------------------//
+void PkReplayer::Dispatch(const PkReplayPk& pk, size_t shardKey) {
+   std::lock_guard<std::mutex> lk{this->DispatchMutex_};
+   ++this->DispatchedCount_;
+   if (this->Shards_.empty()) {
+      this->OnReplayPacket(0, pk);
+      return;
+   }
+   Shard& shard = *this->Shards_[shardKey % this->Shards_.size()];
+   shard.Curr_->Add(pk.Pk_, pk.PkSize_, pk.Time_, false);
+   if (shard.Curr_->IsFull()) {
+      shard.Queue_.Push(std::move(shard.Curr_));
+      shard.Curr_.reset(new Batch);
+   }
+}
+void PkReplayer::FlushShards() {
+   std::lock_guard<std::mutex> lk{this->DispatchMutex_};
+   for (ShardUP& shard : this->Shards_) {
+      if (!shard->Curr_->Items_.empty()) {
+         shard->Queue_.Push(std::move(shard->Curr_));
+         shard->Curr_.reset(new Batch);
+      }
+   }
+}
+void PkReplayer::SequencerRun() {
+   SetCurrentThreadName("PkReplay.Seq");
+   while (BatchUP batch = this->SeqQueue_->Pop()) {
+      for (const Batch::Item& item : batch->Items_)
+         this->OnReplaySequence(batch->GetPk(item));
+      // 每處理完一個 reader 批次, 就將 shard 的批次送出, 避免在播放速度較慢時, 封包滯留在 shard 的批次中.
+      this->FlushShards();
+   }
+   this->OnReplaySequenceEnd();
+   this->FlushShards();
+   for (ShardUP& shard : this->Shards_)
+      shard->Queue_.Close();
+}
+void PkReplayer::ShardRun(unsigned shardIdx, Shard* shard) {
+   std::string thrName = RevPrintTo<std::string>("PkReplay.Shard", shardIdx);
+   SetCurrentThreadName(thrName.c_str());
+   BatchQueue& queue = shard->Queue_;
+   while (BatchUP batch = queue.Pop()) {
+      for (const Batch::Item& item : batch->Items_)
+         this->OnReplayPacket(shardIdx, batch->GetPk(item));
+   }
+}
+
+} // namespaces
@@ -0,0 +1,130 @@
+﻿// \file fon9/PkReplayer.hpp
+// \author fonwinz@gmail.com
+#ifndef __fon9_PkReplayer_hpp__
+#define __fon9_PkReplayer_hpp__
+#include "fon9/FileMap.hpp"
+#include "fon9/TimeStamp.hpp"
+
+fon9_BEFORE_INCLUDE_STD;
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+fon9_AFTER_INCLUDE_STD;
+
+namespace fon9 {
+
+struct fon9_API PkReplayArgs {
+   /// true: 檔案為 TsAppend() 的格式(每個封包前有收到的時間), 可依照原始時間播放.
+   /// false: 檔案為 PkReceiver 的封包框架格式(例: 交易所行情原始檔).
+   bool           IsTsFile_{false};
+   char           Padding___[3];
+   /// 執行 OnReplayPacket() 的 thread(shard) 數量.
+   /// 0 = 不使用 shard thread, 直接在 sequencer thread 執行 OnReplayPacket();
+   uint32_t       ShardCount_{4};
+   /// 播放速度(僅在 IsTsFile_ 時有效): 0 = 盡快; 1 = 原始速度; 2 = 2 倍速...
+   double         Speed_{0};
+   File::PosType  From_{0};
+   /// 0 = 到檔尾.
+   File::PosType  To_{0};
+
+   /// - "Ts=Y|Shards=n|Speed=n|From=pos|To=pos"
+   /// - 不認識的 tag 返回 false;
+   bool SetTagValue(StrView tag, StrView value);
+};
+
+/// 要播放的封包.
+struct PkReplayPk {
+   const void* Pk_;
+   unsigned    PkSize_;
+   char        Padding___[4];
+   /// 收到封包的時間, 僅在 PkReplayArgs::IsTsFile_ 時有效.
+   TimeStamp   Time_;
+};
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup Misc
+/// 多 thread 的管線式(pipelined)封包播放引擎, 用於: 從錄製的行情檔重建狀態、回歸測試 handler...
+/// - 播放分成 3 個階段, 每個階段使用各自的 thread, 階段之間以批次(batch)傳遞封包:
+///   - reader(呼叫 Run() 的 thread): 使用 FileMap(mmap) 讀檔, 解析封包框架(TsReceiver 或 PkReceiver),
+///     若有設定播放速度, 則在此依照封包時間等候.
+///   - sequencer(1 thread): 依序呼叫 OnReplaySequence(); 衍生者在此處理各 channel 的序號連續性(例: PkContFeeder),
+///     然後呼叫 Dispatch(pk, shardKey); 將封包分派給 shard.
+///   - shard(ShardCount_ threads): 呼叫 OnReplayPacket(shardIdx, pk); 衍生者在此執行 handler.
+/// - 相同 shardKey(例: 商品代號的 hash)的封包, 必定在同一個 shard 依序處理, 所以可確保同一商品的處理順序.
+/// - 若無法使用 mmap, 則改用 File::Read();
+class fon9_API PkReplayer {
+   fon9_NON_COPY_NON_MOVE(PkReplayer);
+public:
+   /// pkHeadSize: 若不是 TsFile, 則解析封包框架需要的 PkHead 大小, 請參考 PkReceiver.
+   PkReplayer(unsigned pkHeadSize = 0);
+   virtual ~PkReplayer();
+
+   /// 播放 fname, 在全部封包處理完畢後返回.
+   /// \retval 成功: 播放的封包數量(通過封包框架檢查的數量).
+   /// \retval 失敗: 開檔或讀檔失敗的原因.
+   File::Result Run(std::string fname, const PkReplayArgs& args);
+   /// 在 Run() 執行期間, 可從其他 thread 呼叫, 要求提前結束播放.
+   void RequestStop() {
+      this->IsStopRequested_.store(true, std::memory_order_relaxed);
+   }
+
+   /// 將 pk 分派給 (shardKey % ShardCount_) 的 shard;
+   /// - pk 的內容會被複製, 返回後 pk 就可以釋放.
+   /// - 可在 OnReplaySequence() 或 PkContFeeder 的 timer 裡面呼叫.
+   void Dispatch(const PkReplayPk& pk, size_t shardKey);
+
+   uint64_t GetFramedCount() const { return this->FramedCount_; }
+   uint64_t GetDispatchedCount() const { return this->DispatchedCount_; }
+   /// 封包框架錯誤(CheckSum錯誤, 無法解析...)而拋棄的資料量.
+   uint64_t GetDroppedBytes() const { return this->DroppedBytes_; }
+
+protected:
+   /// 若不是 TsFile, 則由衍生者計算封包大小, 請參考 PkReceiver::GetPkSize();
+   virtual unsigned OnReplayGetPkSize(const void* pkptr);
+   /// 在 sequencer thread 依照檔案中的順序呼叫.
+   virtual void OnReplaySequence(const PkReplayPk& pk) = 0;
+   /// 在 sequencer thread 處理完全部封包後呼叫, 衍生者可在此處理尚未分派的封包.
+   virtual void OnReplaySequenceEnd();
+   /// 在 shard thread 呼叫, 同一個 shardIdx 必定在同一個 thread 依序呼叫.
+   virtual void OnReplayPacket(unsigned shardIdx, const PkReplayPk& pk) = 0;
+
+private:
+   struct Batch;
+   using BatchUP = std::unique_ptr<Batch>;
+   class BatchQueue;
+   class TsFramer;
+   class RawFramer;
+   struct Shard;
+   using ShardUP = std::unique_ptr<Shard>;
+
+   const unsigned          PkHeadSize_;
+   std::atomic<bool>       IsStopRequested_{false};
+   uint64_t                FramedCount_{0};
+   uint64_t                DispatchedCount_{0};
+   uint64_t                DroppedBytes_{0};
+   PkReplayArgs            Args_;
+   /// reader 目前正在填入的批次.
+   BatchUP                 ReaderBatch_;
+   std::unique_ptr<BatchQueue> SeqQueue_;
+   std::mutex              DispatchMutex_;
+   std::vector<ShardUP>    Shards_;
+   std::chrono::steady_clock::time_point PaceStart_;
+   TimeStamp               PaceFirstTime_;
+
+   /// reader: 收到一個封包.
+   /// isMemStable = pk 的記憶體是否在 Run() 結束前都有效(mmap), 若為 false, 則需要複製.
+   void OnFramed(const void* pk, unsigned pksz, TimeStamp pktm, bool isMemStable);
+   void PushReaderBatch();
+   void PaceWait(TimeStamp pktm);
+   File::Result ReadAll(File& fd, FileMap* fmap);
+   void FlushShards();
+   void SequencerRun();
+   void ShardRun(unsigned shardIdx, Shard* shard);
+};
+fon9_WARN_POP;
+
+} // namespaces
+#endif//__fon9_PkReplayer_hpp__
@@ -0,0 +1,220 @@
+﻿// \file fon9/PkReplayer_UT.cpp
+// \author fonwinz@gmail.com
+#define _CRT_SECURE_NO_WARNINGS
+#include "fon9/PkReplayer.hpp"
+#include "fon9/PkCont.hpp"
+#include "fon9/TestTools.hpp"
+#include "fon9/Endian.hpp"
+#include "fon9/BitvFixedInt.hpp"
+#include "fon9/TsReceiver.hpp"
+
+static const char kTsFileName[] = "PkReplayer_UT.ts";
+static const char kRawFileName[] = "PkReplayer_UT.raw";
+
+// 封包內容: Channel(1) + ChannelSeq(8) + SymbolId(4) + SymbolSeq(4) + Filler;
+enum : unsigned {
+   kChannelCount = 4,
+   kSymbolCount = 1000,
+   kBodySize = 1 + 8 + 4 + 4,
+   // Raw 封包框架: 0x1b + Size(2, BigEndian) + Body + Filler + CheckSum + 0x0d + 0x0a
+   kRawHeadSize = 3,
+};
+struct PkBody {
+   uint8_t  Channel_;
+   uint64_t ChannelSeq_;
+   uint32_t SymbolId_;
+   uint32_t SymbolSeq_;
+
+   void Put(char* pk) const {
+      *pk = static_cast<char>(this->Channel_);
+      fon9::PutBigEndian(pk + 1, this->ChannelSeq_);
+      fon9::PutBigEndian(pk + 1 + 8, this->SymbolId_);
+      fon9::PutBigEndian(pk + 1 + 8 + 4, this->SymbolSeq_);
+   }
+   void Get(const void* pkptr) {
+      const char* pk = static_cast<const char*>(pkptr);
+      this->Channel_ = static_cast<uint8_t>(*pk);
+      this->ChannelSeq_ = fon9::GetBigEndian<uint64_t>(pk + 1);
+      this->SymbolId_ = fon9::GetBigEndian<uint32_t>(pk + 1 + 8);
+      this->SymbolSeq_ = fon9::GetBigEndian<uint32_t>(pk + 1 + 8 + 4);
+   }
+};
+
+/// 建立測試檔, 返回封包數量.
+uint64_t MakeTestFile(uint64_t pkCount, fon9::TimeInterval tmStep) {
+   remove(kTsFileName);
+   remove(kRawFileName);
+   fon9::File  fdTs, fdRaw;
+   if (!fdTs.Open(kTsFileName, fon9::FileMode::Append | fon9::FileMode::OpenAlways)
+       || !fdRaw.Open(kRawFileName, fon9::FileMode::Append | fon9::FileMode::OpenAlways)) {
+      std::cout << "[ERROR] Open test file." << std::endl;
+      abort();
+   }
+   std::vector<uint64_t>   chSeqs(kChannelCount, 0);
+   std::vector<uint32_t>   symbSeqs(kSymbolCount, 0);
+   fon9::TimeStamp         pktm = fon9::UtcNow();
+   std::string             bufTs, bufRaw;
+   uint32_t                rnd = 12345;
+   char                    pk[256];
+   for (uint64_t L = 0; L < pkCount; ++L) {
+      rnd = rnd * 1103515245u + 12345u;
+      PkBody body;
+      body.SymbolId_ = (rnd >> 8) % kSymbolCount;
+      body.Channel_ = static_cast<uint8_t>(body.SymbolId_ % kChannelCount);
+      body.ChannelSeq_ = ++chSeqs[body.Channel_];
+      body.SymbolSeq_ = ++symbSeqs[body.SymbolId_];
+      const uint16_t bodysz = static_cast<uint16_t>(kBodySize + (rnd >> 24) % 100);
+      memset(pk, 'x', sizeof(pk));
+      body.Put(pk + kRawHeadSize);
+      // Ts: 0xe0 + Time(7) + Size(2) + Body;
+      pktm += tmStep;
+      char head[fon9::TsReceiver::kHeadSize];
+      head[0] = static_cast<char>(fon9_BitvT_TimeStamp_Orig7);
+      fon9::ToBitvFixedRev<sizeof(pktm) - 1>(head + sizeof(pktm), pktm.GetOrigValue());
+      fon9::PutBigEndian(head + sizeof(pktm), bodysz);
+      bufTs.append(head, sizeof(head));
+      bufTs.append(pk + kRawHeadSize, bodysz);
+      // Raw:
+      const uint16_t pksz = static_cast<uint16_t>(kRawHeadSize + bodysz + 3);
+      pk[0] = '\x1b';
+      fon9::PutBigEndian(pk + 1, pksz);
+      char chk = 0;
+      for (unsigned i = 1; i < pksz - 3u; ++i)
+         chk = static_cast<char>(chk ^ pk[i]);
+      pk[pksz - 3] = chk;
+      pk[pksz - 2] = '\x0d';
+      pk[pksz - 1] = '\x0a';
+      bufRaw.append(pk, pksz);
+      // 加入一些無法解析的資料, 測試 DroppedBytes.
+      if (L % 1000 == 999)
+         bufRaw.append("garbage");
+      if (bufTs.size() > 1024 * 1024) {
+         fdTs.Append(bufTs.data(), bufTs.size());
+         fdRaw.Append(bufRaw.data(), bufRaw.size());
+         bufTs.clear();
+         bufRaw.clear();
+      }
+   }
+   fdTs.Append(bufTs.data(), bufTs.size());
+   fdRaw.Append(bufRaw.data(), bufRaw.size());
+   return pkCount;
+}
+//--------------------------------------------------------------------------//
+class UtReplayer : public fon9::PkReplayer {
+   fon9_NON_COPY_NON_MOVE(UtReplayer);
+   using base = fon9::PkReplayer;
+
+   struct ChFeeder : public fon9::PkContFeeder {
+      fon9_NON_COPY_NON_MOVE(ChFeeder);
+      UtReplayer& Owner_;
+      fon9::TimeStamp PkTime_;
+      ChFeeder(UtReplayer& owner) : Owner_(owner) {
+      }
+      ~ChFeeder() {
+         this->Clear();
+      }
+      void PkContOnReceived(const void* pk, unsigned pksz, SeqT seq) override {
+         (void)seq;
+         PkBody body;
+         body.Get(pk);
+         fon9::PkReplayPk rpk;
+         rpk.Pk_ = pk;
+         rpk.PkSize_ = pksz;
+         rpk.Time_ = this->PkTime_;
+         this->Owner_.Dispatch(rpk, body.SymbolId_);
+      }
+   };
+   std::vector<std::unique_ptr<ChFeeder>> Feeders_;
+   // 每個商品只會在同一個 shard 處理, 所以不用鎖定.
+   std::vector<uint32_t> SymbSeqs_;
+   std::atomic<uint64_t> ErrCount_{0};
+   std::atomic<uint64_t> HandledCount_{0};
+   std::atomic<uint64_t> HandlerResult_{0};
+
+   unsigned OnReplayGetPkSize(const void* pkptr) override {
+      return fon9::GetBigEndian<uint16_t>(static_cast<const char*>(pkptr) + 1);
+   }
+   void OnReplaySequence(const fon9::PkReplayPk& pk) override {
+      const char* body = static_cast<const char*>(pk.Pk_) + this->BodyOffset_;
+      PkBody hdr;
+      hdr.Get(body);
+      ChFeeder& feeder = *this->Feeders_[hdr.Channel_];
+      feeder.PkTime_ = pk.Time_;
+      feeder.FeedPacket(body, pk.PkSize_ - this->BodyOffset_, hdr.ChannelSeq_);
+   }
+   void OnReplayPacket(unsigned shardIdx, const fon9::PkReplayPk& pk) override {
+      (void)shardIdx;
+      PkBody body;
+      body.Get(pk.Pk_);
+      if (++this->SymbSeqs_[body.SymbolId_] != body.SymbolSeq_)
+         ++this->ErrCount_;
+      // 模擬 handler 的工作量.
+      uint64_t h = body.SymbolSeq_;
+      for (unsigned L = this->HandlerWork_; L > 0; --L)
+         h = h * 6364136223846793005u + 1442695040888963407u;
+      this->HandlerResult_ += h;
+      ++this->HandledCount_;
+   }
+public:
+   unsigned BodyOffset_{0};
+   unsigned HandlerWork_{0};
+   UtReplayer() : base{kRawHeadSize}, SymbSeqs_(kSymbolCount, 0) {
+      for (unsigned L = 0; L < kChannelCount; ++L)
+         this->Feeders_.emplace_back(new ChFeeder{*this});
+   }
+
+   /// minSpan: 依照封包時間播放時, 最少需要的時間.
+   void Run(const char* testName, const char* fname, fon9::PkReplayArgs args, uint64_t pkCount, double minSpan) {
+      this->BodyOffset_ = (args.IsTsFile_ ? 0u : static_cast<unsigned>(kRawHeadSize));
+      std::cout << "[TEST ] " << testName << "|Shards=" << args.ShardCount_ << "|Speed=" << args.Speed_
+         << "|Work=" << this->HandlerWork_ << "|";
+      fon9::StopWatch   stopWatch;
+      auto              res = base::Run(fname, args);
+      const double      span = stopWatch.StopTimer();
+      stopWatch.PrintResultNoEOL(span, "Replay", pkCount);
+      std::cout << "|Dropped=" << this->GetDroppedBytes() << "|ErrCount=" << this->ErrCount_;
+      if (!res || res.GetResult() != pkCount || this->GetDispatchedCount() != pkCount
+          || this->HandledCount_ != pkCount || this->ErrCount_ != 0 || span < minSpan) {
+         std::cout << "|res=" << (res ? res.GetResult() : 0)
+            << "|Dispatched=" << this->GetDispatchedCount()
+            << "|Handled=" << this->HandledCount_
+            << "\r[ERROR]" << std::endl;
+         abort();
+      }
+      std::cout << "\r[OK   ]" << std::endl;
+   }
+};
+
+void TestReplay(const char* testName, const char* fname, bool isTsFile, uint32_t shards, unsigned work,
+                uint64_t pkCount, double speed = 0, double minSpan = 0) {
+   fon9::PkReplayArgs args;
+   args.IsTsFile_ = isTsFile;
+   args.ShardCount_ = shards;
+   args.Speed_ = speed;
+   UtReplayer replayer;
+   replayer.HandlerWork_ = work;
+   replayer.Run(testName, fname, args, pkCount, minSpan);
+}
+
+int main(int argc, char* argv[]) {
+   (void)argc; (void)argv;
+   fon9::AutoPrintTestInfo utinfo{"PkReplayer"};
+
+   // 每個封包間隔 10us, 1000 個封包共 10ms, 測試依照時間播放.
+   uint64_t pkCount = MakeTestFile(1000, fon9::TimeInterval_Microsecond(10));
+   TestReplay("Ts.Paced", kTsFileName, true, 4, 0, pkCount, 1, 0.00999);
+   TestReplay("Ts.Paced", kTsFileName, true, 4, 0, pkCount, 2, 0.00499);
+   utinfo.PrintSplitter();
+
+   pkCount = MakeTestFile(1000 * 1000 * 2, fon9::TimeInterval_Microsecond(1));
+   for (unsigned work : {0u, 500u}) {
+      for (uint32_t shards : {0u, 1u, 2u, 4u})
+         TestReplay("Ts", kTsFileName, true, shards, work, pkCount);
+      utinfo.PrintSplitter();
+   }
+   for (uint32_t shards : {0u, 4u})
+      TestReplay("Raw", kRawFileName, false, shards, 0, pkCount);
+
+   remove(kTsFileName);
+   remove(kRawFileName);
+}
@@ -109,6 +109,9 @@ class Fmt : public StopRevPrint {
 public:
    explicit Fmt(StrView fmt) : FmtStr_{fmt} {
    }
+   StrView GetFmtStr() const {
+      return this->FmtStr_;
+   }
    template <class... ArgsT>
    void operator()(RevBuffer& rbuf, ArgsT&&... args) {
       RevFormat(rbuf, this->FmtStr_, std::forward<ArgsT>(args)...);
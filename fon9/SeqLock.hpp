@@ -0,0 +1,105 @@
+﻿/// \file fon9/SeqLock.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_SeqLock_hpp__
+#define __fon9_SeqLock_hpp__
+#include "fon9/Utility.hpp"
+fon9_BEFORE_INCLUDE_STD;
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+fon9_AFTER_INCLUDE_STD;
+
+namespace fon9 {
+
+/// \ingroup Thrs
+/// 循序鎖(sequence lock): 讓讀取者不須鎖定, 即可取得一致的資料複本.
+/// - 寫入者(必須已經互斥, 例: 在 mutex 保護下): WriteBegin(); 修改資料; WriteEnd();
+/// - 讀取者: 複製資料, 若複製期間有寫入(序號改變), 則重新複製.
+/// - 僅適用於 trivially copyable 的資料, 因為複製時可能讀到寫入中的資料(之後會重試).
+class SeqLock {
+   fon9_NON_COPY_NON_MOVE(SeqLock);
+   std::atomic<uint32_t>   Seq_{0};
+public:
+   SeqLock() = default;
+
+   void WriteBegin() {
+      this->Seq_.store(this->Seq_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+   }
+   void WriteEnd() {
+      this->Seq_.store(this->Seq_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+   }
+
+   /// 返回的序號若為奇數, 表示正在寫入, 此時讀到的資料無效.
+   uint32_t ReadBegin() const {
+      return this->Seq_.load(std::memory_order_acquire);
+   }
+   /// 返回 true 表示: 從 ReadBegin() 到現在, 資料有異動(或 ReadBegin() 時正在寫入), 必須重新讀取.
+   bool ReadRetry(uint32_t seq) const {
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return (seq & 1) || this->Seq_.load(std::memory_order_relaxed) != seq;
+   }
+
+   enum : unsigned {
+      kDefaultReadRetry = 100,
+   };
+   /// 將 src 複製到 dst, 確保複製到的是一致的資料.
+   /// 若持續有寫入, 超過 maxRetry 次仍無法取得一致的資料, 則返回 false, 此時 dst 的內容無效,
+   /// 呼叫端應改用鎖定的方式讀取.
+   template <class T>
+   bool ReadCopy(const T& src, T& dst, unsigned maxRetry = kDefaultReadRetry) const {
+      static_assert(std::is_trivially_copyable<T>::value, "SeqLock::ReadCopy() requires trivially copyable T.");
+      do {
+         const uint32_t seq = this->ReadBegin();
+         if (fon9_LIKELY((seq & 1) == 0)) {
+            memcpy(static_cast<void*>(&dst), &src, sizeof(T));
+            if (fon9_LIKELY(!this->ReadRetry(seq)))
+               return true;
+         }
+      } while (maxRetry-- > 0);
+      return false;
+   }
+};
+
+/// \ingroup Thrs
+/// 在 MutexT 鎖定期間, 序號為奇數.
+/// - 可用於 MustLock<BaseT, SeqLockMutex<>>: 原本鎖定後的寫入, 不用做任何修改;
+///   讀取者則可透過 SeqLock::ReadCopy() 取得一致的資料, 不須鎖定 mutex.
+/// - 因為在 mutex 鎖定期間都視為寫入, 所以若有其他鎖定後的讀取, 也會造成 ReadCopy() 重試.
+template <class MutexT = std::mutex>
+class SeqLockMutex : public SeqLock {
+   fon9_NON_COPY_NON_MOVE(SeqLockMutex);
+   MutexT   Mutex_;
+public:
+   SeqLockMutex() = default;
+
+   void lock() {
+      this->Mutex_.lock();
+      this->WriteBegin();
+   }
+   bool try_lock() {
+      if (!this->Mutex_.try_lock())
+         return false;
+      this->WriteBegin();
+      return true;
+   }
+   void unlock() {
+      this->WriteEnd();
+      this->Mutex_.unlock();
+   }
+};
+
+/// 若 MutexT 衍生自 SeqLock, 則返回 &mx; 否則返回 nullptr;
+template <class MutexT>
+inline enable_if_t<std::is_base_of<SeqLock, MutexT>::value, const SeqLock*> GetSeqLock(const MutexT& mx) {
+   return &mx;
+}
+template <class MutexT>
+inline enable_if_t<!std::is_base_of<SeqLock, MutexT>::value, const SeqLock*> GetSeqLock(const MutexT& mx) {
+   (void)mx;
+   return nullptr;
+}
+
+} // namespaces
+#endif//__fon9_SeqLock_hpp__
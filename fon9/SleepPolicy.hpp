@@ -51,5 +51,22 @@ public:
    }
 };
 
+/// \ingroup Thrs
+/// 用 std::this_thread::sleep_for() 睡覺, 沉睡時間在執行時決定(例: 由設定檔提供).
+class MicroSleepPolicy {
+   uint32_t SleepUS_;
+public:
+   /// \param us  沉睡時間(10^-6 秒)
+   explicit MicroSleepPolicy(uint32_t us) : SleepUS_{us} {
+   }
+   /// 沉睡 SleepUS_ (10^-6 秒), 然後返回, 睡醒前無法中斷.
+   void Sleep() const {
+      std::this_thread::sleep_for(std::chrono::microseconds(this->SleepUS_));
+   }
+   /// 等時間到自然會醒, 沒有喚醒功能: do nothing.
+   static void WakeUp() {
+   }
+};
+
 } // namespaces
 #endif//__fon9_SleepPolicy_hpp__
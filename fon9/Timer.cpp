@@ -25,13 +25,13 @@ TimerThreadSP GetDefaultTimerThread() {
 //--------------------------------------------------------------------------//
 TimerEntry::~TimerEntry() {
    if (this->TimerThread_->TimerController_.IsThreadEnding())
-      TimerThread::Locker{this->TimerThread_->TimerController_}->Erase(this->Key_);
+      TimerThread::Locker{this->TimerThread_->TimerController_}->Erase(*this);
 }
 void TimerEntry::DisposeAndWait() {
    while(!this->TimerThread_->TimerController_.IsThreadEnding()) {
       TimerThread::Locker   timerThread{this->TimerThread_->TimerController_};
       if (IsTimerWaitInLine(this->Key_.SeqNo_)) {
-         timerThread->Erase(this->Key_);
+         timerThread->Erase(*this);
          this->Key_.SeqNo_ = TimerSeqNo::Disposed;
          this->Key_.EmitTime_.AssignNull();
       }
@@ -44,7 +44,7 @@ void TimerEntry::StopAndWait() {
       TimerThread::Locker   timerThread{this->TimerThread_->TimerController_};
       if (this->Key_.SeqNo_ == TimerSeqNo::Disposed)
          break;
-      timerThread->Erase(this->Key_);
+      timerThread->Erase(*this);
       this->Key_.SeqNo_ = TimerSeqNo::NoWaiting;
       this->Key_.EmitTime_.AssignNull();
       if (!this->TimerThread_->CheckCurrEmit(timerThread, *this))
@@ -56,7 +56,7 @@ void TimerEntry::DisposeNoWait() {
    if (this->TimerThread_->TimerController_.IsThreadEnding())
       return;
    if (IsTimerWaitInLine(this->Key_.SeqNo_))
-      timerThread->Erase(this->Key_);
+      timerThread->Erase(*this);
    this->Key_.SeqNo_ = TimerSeqNo::Disposed;
 }
 void TimerEntry::StopNoWait() {
@@ -64,7 +64,7 @@ void TimerEntry::StopNoWait() {
    if (this->TimerThread_->TimerController_.IsThreadEnding())
       return;
    if (IsTimerWaitInLine(this->Key_.SeqNo_)) {
-      timerThread->Erase(this->Key_);
+      timerThread->Erase(*this);
       this->Key_.SeqNo_ = TimerSeqNo::NoWaiting;
    }
 }
@@ -75,7 +75,7 @@ void TimerEntry::SetupRun(TimeStamp atTimePoint, const TimeInterval* after) {
    if (this->Key_.SeqNo_ == TimerSeqNo::Disposed)
       return;
    if (IsTimerWaitInLine(this->Key_.SeqNo_))
-      timerThread->Erase(this->Key_);
+      timerThread->Erase(*this);
 
    this->Key_.EmitTime_ = atTimePoint;
    timerThread->LastSeqNo_ = static_cast<TimerSeqNo>(cast_to_underlying(timerThread->LastSeqNo_) + 1);
@@ -83,6 +83,14 @@ void TimerEntry::SetupRun(TimeStamp atTimePoint, const TimeInterval* after) {
       timerThread->LastSeqNo_ = TimerSeqNo::WaitInLine;
    this->Key_.SeqNo_ = timerThread->LastSeqNo_;
 
+   if (TimerWheel* wheel = timerThread->Wheel_.get()) {
+      const uint64_t tick = wheel->Insert(*this);
+      if (fon9_LIKELY(tick >= timerThread->WheelWakeTick_))
+         return;
+      timerThread->WheelWakeTick_ = tick;
+      this->TimerThread_->TimerController_.NotifyOne(timerThread);
+      return;
+   }
    auto ifind = timerThread->Timers_.insert(TimerThread::TimerThreadData::Timers::value_type{this->Key_, this}).first;
    if (fon9_LIKELY(ifind != timerThread->Timers_.end() - 1))
       return;
@@ -114,7 +122,129 @@ void DataMemberTimer::OnTimerEntryReleased() {
 
 //--------------------------------------------------------------------------//
 
-TimerThread::TimerThread(std::string timerName) {
+TimerWheel::TimerWheel(TimeInterval tick, TimeStamp now)
+   : TickUS_{std::max(tick.GetOrigValue(), TimeInterval::OrigType{1})} {
+   static_assert(TimeInterval::Scale == 6, "TimeInterval unit is not microseconds?");
+   memset(this->Slots_, 0, sizeof(this->Slots_));
+   this->CurrTick_ = static_cast<uint64_t>(std::max(now.GetOrigValue(), TimeInterval::OrigType{0}))
+                   / static_cast<uint64_t>(this->TickUS_);
+}
+TimerWheel::~TimerWheel() {
+   for (TimerEntry*& head : this->Slots_) {
+      while (TimerEntry* entry = head) {
+         this->Unlink(*entry);
+         intrusive_ptr_release(entry);
+      }
+   }
+}
+uint64_t TimerWheel::ToTick(TimeStamp tm) const {
+   const TimeInterval::OrigType us = tm.GetOrigValue();
+   if (us <= 0)
+      return 0;
+   return static_cast<uint64_t>((us + this->TickUS_ - 1) / this->TickUS_);
+}
+void TimerWheel::Link(TimerEntry& entry, uint64_t tick) {
+   if (tick < this->CurrTick_)
+      tick = this->CurrTick_;
+   uint64_t delta = tick - this->CurrTick_;
+   unsigned idx;
+   if (delta < kL0Size)
+      idx = static_cast<unsigned>(tick & kL0Mask);
+   else {
+      if (fon9_UNLIKELY(delta > kMaxTicks))
+         tick = this->CurrTick_ + (delta = kMaxTicks);
+      unsigned lv = 0, shift = kL0Bits;
+      while (delta >= (uint64_t{1} << (shift + kLnBits))) {
+         ++lv;
+         shift += kLnBits;
+      }
+      idx = kL0Size + lv * kLnSize + static_cast<unsigned>((tick >> shift) & kLnMask);
+   }
+   TimerEntry*& head = this->Slots_[idx];
+   if ((entry.WheelNext_ = head) != nullptr)
+      head->WheelPPrev_ = &entry.WheelNext_;
+   entry.WheelPPrev_ = &head;
+   head = &entry;
+}
+void TimerWheel::Unlink(TimerEntry& entry) {
+   assert(entry.WheelPPrev_ != nullptr);
+   if ((*entry.WheelPPrev_ = entry.WheelNext_) != nullptr)
+      entry.WheelNext_->WheelPPrev_ = entry.WheelPPrev_;
+   entry.WheelNext_ = nullptr;
+   entry.WheelPPrev_ = nullptr;
+   --this->Count_;
+}
+void TimerWheel::Cascade(unsigned lv) {
+   const unsigned shift = kL0Bits + lv * kLnBits;
+   TimerEntry*&   head = this->Slots_[kL0Size + lv * kLnSize + ((this->CurrTick_ >> shift) & kLnMask)];
+   TimerEntry*    entry = head;
+   head = nullptr;
+   while (entry) {
+      TimerEntry* next = entry->WheelNext_;
+      this->Link(*entry, this->ToTick(entry->Key_.EmitTime_));
+      entry = next;
+   }
+}
+uint64_t TimerWheel::Insert(TimerEntry& entry) {
+   assert(entry.WheelPPrev_ == nullptr);
+   intrusive_ptr_add_ref(&entry);
+   ++this->Count_;
+   const uint64_t tick = std::max(this->ToTick(entry.Key_.EmitTime_), this->CurrTick_);
+   this->Link(entry, tick);
+   return tick;
+}
+void TimerWheel::Erase(TimerEntry& entry) {
+   if (entry.WheelPPrev_ == nullptr)
+      return;
+   this->Unlink(entry);
+   intrusive_ptr_release(&entry);
+}
+TimerEntry* TimerWheel::PopExpired(TimeStamp now) {
+   const TimeInterval::OrigType us = now.GetOrigValue();
+   const uint64_t nowTick = (us <= 0 ? 0 : static_cast<uint64_t>(us / this->TickUS_));
+   while (this->CurrTick_ <= nowTick) {
+      if (TimerEntry* entry = this->Slots_[this->CurrTick_ & kL0Mask]) {
+         this->Unlink(*entry);
+         return entry;
+      }
+      // 跳過第0層空的 slots, 最多跳到需要 cascade 的 tick.
+      uint64_t next = (this->CurrTick_ | kL0Mask) + 1;
+      for (unsigned idx = static_cast<unsigned>(this->CurrTick_ & kL0Mask) + 1; idx < kL0Size; ++idx) {
+         if (this->Slots_[idx]) {
+            next = (this->CurrTick_ & ~static_cast<uint64_t>(kL0Mask)) + idx;
+            break;
+         }
+      }
+      this->CurrTick_ = std::min(next, nowTick + 1);
+      if ((this->CurrTick_ & kL0Mask) != 0)
+         continue;
+      for (unsigned lv = 0; lv < kLnCount; ++lv) {
+         this->Cascade(lv);
+         if (((this->CurrTick_ >> (kL0Bits + lv * kLnBits)) & kLnMask) != 0)
+            break;
+      }
+   }
+   return nullptr;
+}
+uint64_t TimerWheel::NextCheckTick() const {
+   if (this->Count_ == 0)
+      return UINT64_MAX;
+   for (unsigned idx = static_cast<unsigned>(this->CurrTick_ & kL0Mask); idx < kL0Size; ++idx) {
+      if (this->Slots_[idx])
+         return (this->CurrTick_ & ~static_cast<uint64_t>(kL0Mask)) + idx;
+   }
+   return (this->CurrTick_ | kL0Mask) + 1;
+}
+
+//--------------------------------------------------------------------------//
+
+TimerThread::TimerThread(std::string timerName)
+   : TimerThread{std::move(timerName), TimerQueueKind::SortedVector} {
+}
+TimerThread::TimerThread(std::string timerName, TimerQueueKind kind, TimeInterval wheelTick)
+   : QueueKind_{kind} {
+   if (kind == TimerQueueKind::TimingWheel)
+      Locker{this->TimerController_}->Wheel_.reset(new TimerWheel{wheelTick, UtcNow()});
    this->TimerController_.OnBeforeThreadStart(1);
    this->Thread_ = std::thread(&TimerThread::ThrRun, this, std::move(timerName));
 }
@@ -136,6 +266,8 @@ bool TimerThread::CheckCurrEmit(Locker& timerThread, TimerEntry& timer) {
 }
 
 bool TimerThread::RunTimer(Locker& timerThread) {
+   if (timerThread->Wheel_)
+      return this->RunTimerWheel(timerThread);
    while (this->TimerController_.GetState(timerThread) == ThreadState::ExecutingOrWaiting) {
       if (timerThread->Timers_.empty()) {
          timerThread->CvWaitSecs_ = TimeInterval_Second(-1);
@@ -161,6 +293,31 @@ bool TimerThread::RunTimer(Locker& timerThread) {
    return false;
 }
 
+bool TimerThread::RunTimerWheel(Locker& timerThread) {
+   while (this->TimerController_.GetState(timerThread) == ThreadState::ExecutingOrWaiting) {
+      TimerWheel&    wheel = *timerThread->Wheel_;
+      TimeStamp      now = UtcNow();
+      TimerEntry*    timer = wheel.PopExpired(now);
+      if (timer == nullptr) {
+         const uint64_t tick = timerThread->WheelWakeTick_ = wheel.NextCheckTick();
+         if (tick == UINT64_MAX)
+            timerThread->CvWaitSecs_ = TimeInterval_Second(-1);
+         else
+            timerThread->CvWaitSecs_ = wheel.ToTimeStamp(tick) - now;
+         return true;
+      }
+      timer->Key_.SeqNo_ = TimerSeqNo::NoWaiting;
+      timerThread->CurrEntry_ = timer;
+      timerThread.unlock();
+      // callback in unlock...
+      // 時間輪取出的 timer 仍保有 ref, 在 EmitOnTimer() 裡面 intrusive_ptr_release(timer);
+      timer->EmitOnTimer(now);
+      timerThread.lock();
+      timerThread->CurrEntry_ = nullptr;
+   }
+   return false;
+}
+
 void TimerThread::ThrRun(std::string timerName) {
    SetCurrentThreadName(timerName.c_str());
    if (gWaitLogSystemReady)
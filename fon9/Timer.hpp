@@ -39,6 +39,21 @@ struct TimerEntryKey {
    }
 };
 
+/// \ingroup Thrs
+/// TimerThread 使用的計時佇列.
+enum class TimerQueueKind : uint8_t {
+   /// 依照觸發時間排序的 SortedVector.
+   /// - 觸發時間精確.
+   /// - RunAt(), RunAfter(), StopNoWait()... 為 O(n), 適合計時器數量不多的情況.
+   SortedVector,
+   /// 階層式時間輪(Hierarchical timing wheel).
+   /// - RunAt(), RunAfter(), StopNoWait()... 為 O(1), 適合有大量計時器的情況.
+   /// - 觸發時間會延後到 tick 的整數倍(不會提前觸發).
+   TimingWheel,
+};
+
+class TimerWheel;
+
 /// \ingroup Thrs
 /// - 每個 TimerThread 擁有一個自己的 thread.
 /// - 每個 timer 啟動時, 不論設定的是 [間隔時間] or [絕對時間], 都會使用 TimeStamp_ 來處理.
@@ -95,7 +110,11 @@ class fon9_API TimerEntry : public intrusive_ref_counter<TimerEntry> {
    }
 
    friend class TimerThread;
+   friend class TimerWheel;
    TimerEntryKey  Key_;
+   /// 使用 TimerQueueKind::TimingWheel 時, 在時間輪 slot 裡面的雙向鏈結.
+   TimerEntry*    WheelNext_{};
+   TimerEntry**   WheelPPrev_{};
 
    void SetupRun(TimeStamp atTimePoint, const TimeInterval* after);
 public:
@@ -225,6 +244,69 @@ public:
    }
 };
 
+/// \ingroup Thrs
+/// 階層式時間輪(Hierarchical timing wheel), 提供 TimerThread 使用.
+/// - 第0層有 256 個 slot, 每個 slot 1 tick;
+///   之後 3 層各有 64 個 slot, 每個 slot 分別為 256, 256*64, 256*64*64 ticks.
+/// - 超過 2^26 ticks 的 entry 先放在最高層, 在 cascade 時重新計算位置.
+/// - 每個 slot 使用 TimerEntry::WheelNext_, WheelPPrev_ 串成雙向鏈結, 所以加入、移除都是 O(1).
+/// - 在時間輪裡面的 entry 會持有一個 ref (intrusive_ptr_add_ref).
+/// - 不提供 thread safe, 由 TimerThread 負責保護.
+class TimerWheel {
+   fon9_NON_COPY_NON_MOVE(TimerWheel);
+   enum : unsigned {
+      kL0Bits = 8,
+      kLnBits = 6,
+      kLnCount = 3,
+      kL0Size = 1u << kL0Bits,
+      kLnSize = 1u << kLnBits,
+      kL0Mask = kL0Size - 1,
+      kLnMask = kLnSize - 1,
+      kSlotCount = kL0Size + kLnSize * kLnCount,
+   };
+   static constexpr uint64_t  kMaxTicks = (uint64_t{1} << (kL0Bits + kLnBits * kLnCount)) - 1;
+
+   const TimeInterval::OrigType  TickUS_;
+   uint64_t                      CurrTick_;
+   size_t                        Count_{0};
+   TimerEntry*                   Slots_[kSlotCount];
+
+   void Link(TimerEntry& entry, uint64_t tick);
+   void Unlink(TimerEntry& entry);
+   void Cascade(unsigned lv);
+
+public:
+   /// tick 最小為 1 us.
+   TimerWheel(TimeInterval tick, TimeStamp now);
+   /// 釋放仍在時間輪裡面的 entries.
+   ~TimerWheel();
+
+   bool empty() const {
+      return this->Count_ == 0;
+   }
+   size_t size() const {
+      return this->Count_;
+   }
+
+   /// 無條件進位, 確保不會提早觸發.
+   uint64_t ToTick(TimeStamp tm) const;
+   TimeStamp ToTimeStamp(uint64_t tick) const {
+      return TimeStamp{TimeInterval_Microsecond(static_cast<TimeInterval::OrigType>(tick) * this->TickUS_)};
+   }
+
+   /// 將 entry 依照 entry.Key_.EmitTime_ 加入時間輪, 並 intrusive_ptr_add_ref(&entry);
+   /// 傳回 entry 放入的 tick, 若 EmitTime_ 已過, 則放在目前的 tick.
+   uint64_t Insert(TimerEntry& entry);
+   /// 若 entry 在時間輪裡面, 則移除並 intrusive_ptr_release(&entry);
+   void Erase(TimerEntry& entry);
+   /// 取出一個已到期的 entry, 並將它從時間輪移除, 但保留 ref, 由呼叫端負責釋放.
+   /// 若沒有已到期的 entry, 則傳回 nullptr.
+   TimerEntry* PopExpired(TimeStamp now);
+   /// 下次需要檢查的 tick: 第0層最近有 entry 的 tick, 或需要 cascade 的 tick.
+   /// 若時間輪為空, 則傳回 UINT64_MAX.
+   uint64_t NextCheckTick() const;
+};
+
 fon9_WARN_DISABLE_PADDING;
 /// \ingroup Thrs
 /// 實際的 TimerEntry 放在 TimerThread 裡面執行.
@@ -233,10 +315,14 @@ class fon9_API TimerThread : public intrusive_ref_counter<TimerThread> {
    friend class TimerEntry;
 
    struct TimerThreadData {
-      void Erase(TimerEntryKey& key) {
-         if (key.SeqNo_ == TimerSeqNo::NoWaiting)
+      void Erase(TimerEntry& timer) {
+         if (timer.Key_.SeqNo_ == TimerSeqNo::NoWaiting)
+            return;
+         if (this->Wheel_) {
+            this->Wheel_->Erase(timer);
             return;
-         auto ifind = this->Timers_.find(key);
+         }
+         auto ifind = this->Timers_.find(timer.Key_);
          if (ifind != this->Timers_.end())
             this->Timers_.erase(ifind);
       }
@@ -244,6 +330,11 @@ class fon9_API TimerThread : public intrusive_ref_counter<TimerThread> {
       using Timers = SortedVector<TimerEntryKey, TimerEntrySP>;
       TimerSeqNo        LastSeqNo_{TimerSeqNo::WaitInLine};
       Timers            Timers_;
+      /// 使用 TimerQueueKind::TimingWheel 時, 用此取代 Timers_;
+      std::unique_ptr<TimerWheel> Wheel_;
+      /// 使用 Wheel_ 時, TimerThread 預計醒來的 tick;
+      /// 新加入的 entry 若早於此 tick, 則需要喚醒 TimerThread.
+      uint64_t          WheelWakeTick_{UINT64_MAX};
       TimeInterval      CvWaitSecs_;
       /// 如果在 TimerThread 正在觸發, 則會設定此值.
       /// 讓另一 thread 呼叫 TimerEntry::StopAndWait() 時, 可以等到 OnTimer() 真的結束後才返回.
@@ -251,11 +342,13 @@ class fon9_API TimerThread : public intrusive_ref_counter<TimerThread> {
    };
    using TimerController = ThreadController<TimerThreadData, WaitPolicy_CV>;
    using Locker = TimerController::Locker;
-   TimerController   TimerController_;
-   std::thread       Thread_;
+   TimerController      TimerController_;
+   std::thread          Thread_;
+   const TimerQueueKind QueueKind_;
 
    bool CheckCurrEmit(Locker& timerThread, TimerEntry& timer);
    bool RunTimer(Locker&);
+   bool RunTimerWheel(Locker&);
 
 protected:
    void ThrRun(std::string timerName);
@@ -265,10 +358,17 @@ protected:
 
 public:
    TimerThread(std::string timerName);
+   /// \param wheelTick 使用 TimerQueueKind::TimingWheel 時的 tick 大小, 也就是觸發時間的精確度.
+   TimerThread(std::string timerName, TimerQueueKind kind,
+               TimeInterval wheelTick = TimeInterval_Millisecond(1));
    virtual ~TimerThread();
 
    void WaitForEndNow();
 
+   TimerQueueKind GetQueueKind() const {
+      return this->QueueKind_;
+   }
+
    bool InThisThread() const {
       return (this->Thread_.get_id() == std::this_thread::get_id());
    }
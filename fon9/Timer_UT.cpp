@@ -3,6 +3,7 @@
 #include "fon9/Timer.hpp"
 #include "fon9/TestTools.hpp"
 #include "fon9/RevPrint.hpp"
+#include "fon9/Random.hpp"
 
 // 壓力測試方法:
 // - 建立4個 thread
@@ -118,8 +119,9 @@ fon9_WARN_POP;
 
 //--------------------------------------------------------------------------//
 
-void TestTimerThread() {
-   fon9::TimerThreadSP timerThread{new fon9::TimerThread{"TestTimerThread"}};
+void TestTimerThread(fon9::TimerQueueKind kind) {
+   gOnTimerTimes = gSessionCount = gSessionDtor = gUnderOnTimer = gOverOnTimer = gOverBegin = gDtorInTimerThread = 0;
+   fon9::TimerThreadSP timerThread{new fon9::TimerThread{"TestTimerThread", kind}};
    gTimerThread = timerThread.get();
 
    std::thread thrs[4];
@@ -179,9 +181,57 @@ void TestTimerThread() {
 
 //--------------------------------------------------------------------------//
 
+// 測量在已有 timerCount 個計時器等候中的情況下, RunAfter()、StopNoWait() 的負擔.
+void BenchTimerQueue(fon9::TimerQueueKind kind, size_t timerCount) {
+   const size_t         kOpTimes = 1000;
+   fon9::TimerThreadSP  timerThread{new fon9::TimerThread{"BenchTimerQueue", kind}};
+   std::vector<fon9::TimerEntrySP>  timers(timerCount);
+   // 觸發時間由後往前建立, 讓 SortedVector 每次都加在尾端, 避免建立過程就花費太多時間.
+   const fon9::TimeStamp            tmBase = fon9::UtcNow() + fon9::TimeInterval_Second(60);
+   for (size_t L = timerCount; L > 0;) {
+      --L;
+      timers[L].reset(new fon9::TimerEntry{timerThread});
+      timers[L]->RunAt(tmBase + fon9::TimeInterval_Microsecond(static_cast<fon9::TimeInterval::OrigType>(L * 10)));
+   }
+   std::vector<size_t> idxs(kOpTimes);
+   std::uniform_int_distribution<size_t> rnd{0, timerCount - 1};
+   for (size_t& idx : idxs)
+      idx = rnd(fon9::GetRandomEngine());
+
+   const std::string msgHead = std::string{kind == fon9::TimerQueueKind::TimingWheel ? "TimingWheel " : "SortedVector"}
+                             + "|timers=" + std::to_string(timerCount);
+   fon9::StopWatch stopWatch;
+   for (size_t idx : idxs)
+      timers[idx]->RunAfter(fon9::TimeInterval_Second(60) + fon9::TimeInterval_Microsecond(static_cast<fon9::TimeInterval::OrigType>(idx * 10 + 5)));
+   stopWatch.PrintResult((msgHead + "|RunAfter  ").c_str(), kOpTimes);
+   for (size_t idx : idxs)
+      timers[idx]->StopNoWait();
+   stopWatch.PrintResult((msgHead + "|StopNoWait").c_str(), kOpTimes);
+
+   // 依照觸發時間由先到後移除, 讓 SortedVector 每次都從尾端移除.
+   std::sort(timers.begin(), timers.end(), [](const fon9::TimerEntrySP& lhs, const fon9::TimerEntrySP& rhs) {
+      return rhs->GetKey() < lhs->GetKey();
+   });
+   for (fon9::TimerEntrySP& timer : timers)
+      timer->StopNoWait();
+}
+void BenchTimerQueue() {
+   for (size_t timerCount : {1000, 100 * 1000, 1000 * 1000}) {
+      BenchTimerQueue(fon9::TimerQueueKind::SortedVector, timerCount);
+      BenchTimerQueue(fon9::TimerQueueKind::TimingWheel, timerCount);
+   }
+}
+
+//--------------------------------------------------------------------------//
+
 int main() {
    fon9::AutoPrintTestInfo utinfo{"Timer"};
-   TestTimerThread();
+   BenchTimerQueue();
+
+   std::cout << "--- TimerQueueKind::SortedVector ---" << std::endl;
+   TestTimerThread(fon9::TimerQueueKind::SortedVector);
+   std::cout << "--- TimerQueueKind::TimingWheel ---" << std::endl;
+   TestTimerThread(fon9::TimerQueueKind::TimingWheel);
 
    // 測試在 main() 結束後, DefaultTimerThread 是否能正常結束.
    fon9::GetDefaultTimerThread();
@@ -12,11 +12,20 @@ fon9_API void FreeNode(BufferNode* node) {
    case BufferNodeType::Data:
       break;
    case BufferNodeType::Virtual:
-      BufferNodeVirtual* vnode = static_cast<BufferNodeVirtual*>(node);
-      auto               blksz = vnode->BlockSize_;
-      vnode->~BufferNodeVirtual();
-      // 有 vtbl, 所以 free 的對象必須是: vnode (而不是 node); (void*)node 不一定與 (void*)vnode 相等.
-      MemBlock::FreeBlock(vnode, blksz);
+      {
+         BufferNodeVirtual* vnode = static_cast<BufferNodeVirtual*>(node);
+         auto               blksz = vnode->BlockSize_;
+         vnode->~BufferNodeVirtual();
+         // 有 vtbl, 所以 free 的對象必須是: vnode (而不是 node); (void*)node 不一定與 (void*)vnode 相等.
+         MemBlock::FreeBlock(vnode, blksz);
+      }
+      return;
+   case BufferNodeType::SharedRef:
+      {
+         auto blksz = node->BlockSize_;
+         static_cast<BufferNodeSharedRef*>(node)->~BufferNodeSharedRef();
+         MemBlock::FreeBlock(node, blksz);
+      }
       return;
    }
    MemBlock::FreeBlock(node, node->BlockSize_);
@@ -16,6 +16,8 @@ fon9_API void FreeNode(BufferNode* node);
 enum class BufferNodeType : BufferNodeSize {
    Data,
    Virtual,
+   /// 資料不在節點內, 而是參考 BufferShared 的共用資料, 請參考 BufferNodeSharedRef.
+   SharedRef,
 };
 
 /// \ingroup Buffer
@@ -97,23 +99,18 @@ public:
    fon9_API friend void FreeNode(BufferNode* node);
 
    /// 取得此節點「有效資料」的開始位置.
+   /// 若為 BufferNodeType::SharedRef, 則資料為共用且不可變, 不可透過傳回值修改內容.
    byte* GetDataBegin() {
-      return reinterpret_cast<byte*>(this) + this->DataBeginOffset_;
-   }
-   const byte* GetDataBegin() const {
-      return reinterpret_cast<const byte*>(this) + this->DataBeginOffset_;
+      return const_cast<byte*>(static_cast<const BufferNode*>(this)->GetDataBegin());
    }
+   inline const byte* GetDataBegin() const;
    /// 取得此節點「有效資料」的結束位置.
    byte* GetDataEnd() {
-      return reinterpret_cast<byte*>(this) + this->DataEndOffset_;
-   }
-   const byte* GetDataEnd() const {
-      return reinterpret_cast<const byte*>(this) + this->DataEndOffset_;
+      return const_cast<byte*>(static_cast<const BufferNode*>(this)->GetDataEnd());
    }
+   inline const byte* GetDataEnd() const;
    /// 取得此節點「有效資料」的資料量(bytes).
-   BufferNodeSize GetDataSize() const {
-      return this->DataEndOffset_ - this->DataBeginOffset_;
-   }
+   inline BufferNodeSize GetDataSize() const;
    /// 取得此節點前方剩餘空間(無資料的).
    BufferNodeSize GetFrontSpaces() const {
       return static_cast<BufferNodeSize>(this->GetDataBegin() - this->GetMemBegin());
@@ -141,15 +138,70 @@ public:
       }
    }
    /// 直接設定資料開始位置(偏移量).
-   /// - 必須是 data node.
+   /// - 必須是 data node 或 BufferNodeType::SharedRef.
    /// - offset = 移動多少bytes
-   void MoveDataBeginOffset(BufferNodeSize offset) {
-      assert(this->GetNodeType() == BufferNodeType::Data);
-      this->DataBeginOffset_ += offset;
-      assert(this->DataBeginOffset_ <= this->DataEndOffset_);
+   inline void MoveDataBeginOffset(BufferNodeSize offset);
+};
+
+class fon9_API BufferShared;
+/// \ingroup Buffer
+/// 參考 BufferShared 共用資料的節點.
+/// - 透過 BufferShared::MakeRefNode() 建立, 可放入任意 BufferList(例: 多個 io::Device 的傳送佇列).
+/// - 節點本身不存放資料, 僅記錄共用資料的範圍, 所以不會與前後的 data node 合併.
+/// - 透過 FreeNode() 歸還時, 才會釋放對 BufferShared 的參考.
+class fon9_API BufferNodeSharedRef : public BufferNode {
+   fon9_NON_COPY_NON_MOVE(BufferNodeSharedRef);
+   using base = BufferNode;
+   friend class BufferNode;
+   friend class BufferShared;
+   const BufferShared* const Shared_;
+   const byte*          DataBegin_;
+   const byte* const    DataEnd_;
+
+   BufferNodeSharedRef(BufferNodeSize blockSize, const BufferShared& shared, const byte* beg, const byte* end);
+   ~BufferNodeSharedRef();
+   static BufferNodeSharedRef* Alloc(const BufferShared& shared, const byte* beg, const byte* end);
+public:
+   const BufferShared& GetShared() const {
+      return *this->Shared_;
    }
+   /// node 必須是 BufferNodeSharedRef 才會轉型成功.
+   static const BufferNodeSharedRef* CastFrom(const BufferNode* node) {
+      return (node && node->GetNodeType() == BufferNodeType::SharedRef)
+         ? static_cast<const BufferNodeSharedRef*>(node) : nullptr;
+   }
+
+   fon9_API friend void FreeNode(BufferNode* node);
 };
 
+inline const byte* BufferNode::GetDataBegin() const {
+   if (fon9_LIKELY(this->DataBeginOffset_ != static_cast<BufferNodeSize>(BufferNodeType::SharedRef)))
+      return reinterpret_cast<const byte*>(this) + this->DataBeginOffset_;
+   return static_cast<const BufferNodeSharedRef*>(this)->DataBegin_;
+}
+inline const byte* BufferNode::GetDataEnd() const {
+   if (fon9_LIKELY(this->DataEndOffset_ != static_cast<BufferNodeSize>(BufferNodeType::SharedRef)))
+      return reinterpret_cast<const byte*>(this) + this->DataEndOffset_;
+   return static_cast<const BufferNodeSharedRef*>(this)->DataEnd_;
+}
+inline BufferNodeSize BufferNode::GetDataSize() const {
+   if (fon9_LIKELY(this->DataBeginOffset_ != static_cast<BufferNodeSize>(BufferNodeType::SharedRef)))
+      return this->DataEndOffset_ - this->DataBeginOffset_;
+   const BufferNodeSharedRef* ref = static_cast<const BufferNodeSharedRef*>(this);
+   return static_cast<BufferNodeSize>(ref->DataEnd_ - ref->DataBegin_);
+}
+inline void BufferNode::MoveDataBeginOffset(BufferNodeSize offset) {
+   if (fon9_UNLIKELY(this->DataBeginOffset_ == static_cast<BufferNodeSize>(BufferNodeType::SharedRef))) {
+      BufferNodeSharedRef* ref = static_cast<BufferNodeSharedRef*>(this);
+      ref->DataBegin_ += offset;
+      assert(ref->DataBegin_ <= ref->DataEnd_);
+      return;
+   }
+   assert(this->GetNodeType() == BufferNodeType::Data);
+   this->DataBeginOffset_ += offset;
+   assert(this->DataBeginOffset_ <= this->DataEndOffset_);
+}
+
 /// \ingroup Buffer
 /// 計算從 front 開始的資料量(包含front).
 inline size_t CalcDataSize(const BufferNode* front) {
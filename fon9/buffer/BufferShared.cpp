@@ -0,0 +1,51 @@
+﻿// \file fon9/buffer/BufferShared.cpp
+// \author fonwinz@gmail.com
+#include "fon9/buffer/BufferShared.hpp"
+
+namespace fon9 {
+
+static BufferNodeSize CheckSharedSize(size_t size) {
+   const BufferNodeSize retval = static_cast<BufferNodeSize>(size);
+   if (fon9_UNLIKELY(retval != size))
+      Raise<std::length_error>("BufferShared");
+   return retval;
+}
+
+BufferShared::BufferShared(const void* src, size_t size) : Size_{CheckSharedSize(size)} {
+   if (size) {
+      if (this->Mem_.Alloc(this->Size_) == nullptr)
+         Raise<std::bad_alloc>();
+      memcpy(this->Mem_.begin(), src, size);
+   }
+}
+BufferShared::BufferShared(const BufferNode* front) : Size_{CheckSharedSize(CalcDataSize(front))} {
+   if (this->Size_) {
+      if (this->Mem_.Alloc(this->Size_) == nullptr)
+         Raise<std::bad_alloc>();
+      byte* pout = this->Mem_.begin();
+      for (; front; front = front->GetNext()) {
+         const BufferNodeSize sz = front->GetDataSize();
+         memcpy(pout, front->GetDataBegin(), sz);
+         pout += sz;
+      }
+   }
+}
+BufferNode* BufferShared::MakeRefNode() const {
+   return BufferNodeSharedRef::Alloc(*this, this->begin(), this->end());
+}
+//--------------------------------------------------------------------------//
+BufferNodeSharedRef::BufferNodeSharedRef(BufferNodeSize blockSize, const BufferShared& shared, const byte* beg, const byte* end)
+   : base(blockSize, BufferNodeType::SharedRef)
+   , Shared_{&shared}
+   , DataBegin_{beg}
+   , DataEnd_{end} {
+   intrusive_ptr_add_ref(this->Shared_);
+}
+BufferNodeSharedRef::~BufferNodeSharedRef() {
+   intrusive_ptr_release(this->Shared_);
+}
+BufferNodeSharedRef* BufferNodeSharedRef::Alloc(const BufferShared& shared, const byte* beg, const byte* end) {
+   return base::Alloc<BufferNodeSharedRef>(0, shared, beg, end);
+}
+
+} // namespaces
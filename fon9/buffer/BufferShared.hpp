@@ -0,0 +1,49 @@
+﻿/// \file fon9/buffer/BufferShared.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_buffer_BufferShared_hpp__
+#define __fon9_buffer_BufferShared_hpp__
+#include "fon9/buffer/BufferList.hpp"
+#include "fon9/intrusive_ref_counter.hpp"
+
+namespace fon9 {
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup Buffer
+/// 可被多個 BufferList 共用的「不可變」資料.
+/// - 例: 發行一筆訂閱資料, 只要打包一次,
+///   就可透過 MakeRefNode() 加入每個訂閱者的傳送佇列, 不用為每個訂閱者複製一次.
+/// - 建構時複製一次資料, 之後內容不會再改變, 所以可在多個 thread 同時使用.
+/// - 在全部的 BufferNodeSharedRef 歸還前, 不會被刪除.
+class fon9_API BufferShared : public intrusive_ref_counter<BufferShared> {
+   fon9_NON_COPY_NON_MOVE(BufferShared);
+   MemBlock       Mem_;
+   BufferNodeSize Size_;
+public:
+   BufferShared(const void* src, size_t size);
+   /// 複製從 front 開始(包含front)的全部資料.
+   explicit BufferShared(const BufferNode* front);
+   explicit BufferShared(const BufferList& buf) : BufferShared{buf.cfront()} {
+   }
+
+   const byte* begin() const {
+      return this->Mem_.begin();
+   }
+   const byte* end() const {
+      return this->Mem_.begin() + this->Size_;
+   }
+   BufferNodeSize size() const {
+      return this->Size_;
+   }
+   bool empty() const {
+      return this->Size_ == 0;
+   }
+
+   /// 建立一個參考全部資料的節點, 可加入任意 BufferList.
+   /// 必須透過 FreeNode() 歸還(通常由 DcQueueList 在消費完畢後歸還).
+   BufferNode* MakeRefNode() const;
+};
+fon9_WARN_POP;
+using BufferSharedSP = intrusive_ptr<const BufferShared>;
+
+} // namespaces
+#endif//__fon9_buffer_BufferShared_hpp__
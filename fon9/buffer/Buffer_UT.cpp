@@ -3,6 +3,7 @@
 #define _CRT_SECURE_NO_WARNINGS
 #include "fon9/TestTools.hpp"
 #include "fon9/buffer/DcQueueList.hpp"
+#include "fon9/buffer/BufferShared.hpp"
 #include "fon9/Log.hpp"
 #include "fon9/ThreadId.hpp"
 
@@ -102,6 +103,66 @@ __TEST_ERROR:
    abort();
 }
 
+//--------------------------------------------------------------------------//
+fon9::BufferList MakeSharedRefList(const fon9::BufferShared& shared, unsigned head) {
+   fon9::RevBufferList rbuf{16};
+   fon9::RevPrint(rbuf, "Tail");
+   rbuf.PushFront(shared.MakeRefNode());
+   fon9::RevPrint(rbuf, "Head", head, '|');
+   return rbuf.MoveOut();
+}
+void TestBufferShared() {
+   std::cout << "[TEST ] BufferShared";
+   const std::string          msg = fon9::BufferTo<std::string>(InitTestData().MoveOut());
+   fon9::BufferSharedSP       shared{new fon9::BufferShared{InitTestData().MoveOut()}};
+   const char*                errmsg = nullptr;
+   std::vector<fon9::BufferList> lists;
+   for (unsigned L = 0; L < 3; ++L)
+      lists.emplace_back(MakeSharedRefList(*shared, L));
+   if (std::string(reinterpret_cast<const char*>(shared->begin()), shared->size()) != msg)
+      errmsg = "|shared content not match!";
+   else if (shared->use_count() != 1 + lists.size())
+      errmsg = "|use_count not match!";
+   else {
+      for (unsigned L = 0; L < lists.size(); ++L) {
+         const fon9::BufferNode* node = lists[L].cfront();
+         while (node && fon9::BufferNodeSharedRef::CastFrom(node) == nullptr)
+            node = node->GetNext();
+         if (node == nullptr || node->GetDataBegin() != shared->begin()) {
+            errmsg = "|data copied!";
+            break;
+         }
+         const std::string expected = "Head" + std::to_string(L) + "|" + msg + "Tail";
+         if (fon9::BufferTo<std::string>(lists[L]) != expected) {
+            errmsg = "|list content not match!";
+            break;
+         }
+         // 部分消費之後, 剩餘的資料仍應正確.
+         const size_t consumed = 10 + L * 50;
+         fon9::DcQueueList dcq{std::move(lists[L])};
+         dcq.PopConsumed(consumed);
+         if (fon9::BufferTo<std::string>(dcq.MoveOutToList()) != expected.substr(consumed)) {
+            errmsg = "|partial consumed not match!";
+            break;
+         }
+         if (TestRead(fon9::DcQueueList{MakeSharedRefList(*shared, L)}, expected.size(), L + 3) != expected) {
+            errmsg = "|DcQueue.Read() not match!";
+            break;
+         }
+      }
+   }
+   if (errmsg == nullptr) {
+      lists.clear();
+      if (shared->use_count() != 1)
+         errmsg = "|ref not released!";
+   }
+   if (errmsg) {
+      std::cout << errmsg << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
 //--------------------------------------------------------------------------//
 
 int main() {
@@ -143,4 +204,5 @@ int main() {
 
    utinfo.PrintSplitter();
    TestBuffer();
+   TestBufferShared();
 }
@@ -117,11 +117,8 @@ void DcQueueList::ConsumeErr(const ErrC& errc) {
    if (node == nullptr)
       return;
    this->NodeConsumed(node, errc, static_cast<BufferNodeSize>(this->MemCurrent_ - node->GetDataBegin()));
-   while ((node = this->BlockList_.pop_front()) != nullptr) {
-      if (BufferNodeVirtual* vnode = BufferNodeVirtual::CastFrom(node))
-         vnode->OnBufferConsumedErr(errc);
+   while ((node = this->BlockList_.pop_front()) != nullptr)
       this->NodeConsumed(node, errc, node->GetDataSize());
-   }
    assert(this->BlockList_.empty());
    this->ClearCurrBlock();
 }
@@ -3,6 +3,18 @@
 #include "fon9/buffer/MemBlockImpl.hpp"
 #include "fon9/StaticPtr.hpp"
 
+fon9_BEFORE_INCLUDE_STD;
+#include <algorithm>
+#include <vector>
+#ifdef fon9_WINDOWS
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+fon9_AFTER_INCLUDE_STD;
+
 namespace fon9 {
 
 static std::array<size_t, kMemBlockLevelCount> MemBlockLevelMaxNodeCount_{
@@ -17,37 +29,233 @@ static std::array<size_t, kMemBlockLevelCount> MemBlockLevelMaxNodeCount_{
 
 //--------------------------------------------------------------------------//
 namespace impl {
+static MemBlockLevelSt  MemBlockLevelSt_[kMemBlockLevelCount];
+/// thread cache 累積的 HitCount_ 達到此數量, 才加入 MemBlockLevelSt::Hit_;
+static const uint32_t   kMemBlockSt_HitFlushCount = 1024;
+/// MemBlockCenter 沒有可用串列時, thread 自行從 slab 切出的數量上限.
+static const size_t     kMemSlab_RefillCount = 32;
+
+static inline void FlushHitCount(unsigned lvidx, TCacheLevelPool& lv) {
+   if (lv.HitCount_) {
+      MemBlockLevelSt_[lvidx].Hit_.fetch_add(lv.HitCount_, std::memory_order_relaxed);
+      lv.HitCount_ = 0;
+   }
+}
+
+//--------------------------------------------------------------------------//
+unsigned GetThisNumaNode() {
+#if defined(fon9_WINDOWS) || !defined(SYS_getcpu)
+   return 0;
+#else
+   unsigned cpu = 0, node = 0;
+   if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+      return 0;
+   return node;
+#endif
+}
+
+static const uintptr_t kMemSlabChunkMask = ~(static_cast<uintptr_t>(kMemSlabChunkSize) - 1);
+enum : unsigned {
+   kMemSlabChunkBits = 21,
+   kMemSlabAddrBits = (sizeof(void*) >= 8 ? 48 : 32),
+   kMemSlabLeafBits = (kMemSlabAddrBits - kMemSlabChunkBits) / 2,
+   kMemSlabRootBits = kMemSlabAddrBits - kMemSlabChunkBits - kMemSlabLeafBits,
+};
+static_assert(kMemSlabChunkSize == (static_cast<size_t>(1) << kMemSlabChunkBits), "kMemSlabChunkBits error.");
+/// 超過 kMemSlabAddrBits 的位址, 無法放入 MemSlabChunkMap, 所以不能當作 slab chunk.
+static inline bool IsMemSlabAddrOverflow(uintptr_t addr) {
+   return ((addr >> (kMemSlabAddrBits - 1)) >> 1) != 0;
+}
+
+static byte* MemSlabAllocChunk(unsigned numaNode) {
+#ifdef fon9_WINDOWS
+   (void)numaNode;
+   void* chunk = _aligned_malloc(kMemSlabChunkSize, kMemSlabChunkSize);
+   if (chunk && IsMemSlabAddrOverflow(reinterpret_cast<uintptr_t>(chunk))) {
+      _aligned_free(chunk);
+      return nullptr;
+   }
+   return static_cast<byte*>(chunk);
+#else
+   // 多取一個 chunk 的大小, 對齊後再把前後多餘的部分還給系統.
+   void* pmap = mmap(nullptr, kMemSlabChunkSize * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (pmap == MAP_FAILED)
+      return nullptr;
+   const uintptr_t addr = reinterpret_cast<uintptr_t>(pmap);
+   const uintptr_t base = (addr + kMemSlabChunkSize - 1) & kMemSlabChunkMask;
+   if (base > addr)
+      munmap(pmap, base - addr);
+   if (const uintptr_t tail = (addr + kMemSlabChunkSize * 2) - (base + kMemSlabChunkSize))
+      munmap(reinterpret_cast<void*>(base + kMemSlabChunkSize), tail);
+   void* chunk = reinterpret_cast<void*>(base);
+   if (IsMemSlabAddrOverflow(base)) {
+      munmap(chunk, kMemSlabChunkSize);
+      return nullptr;
+   }
+#ifdef MADV_HUGEPAGE
+   madvise(chunk, kMemSlabChunkSize, MADV_HUGEPAGE);
+#endif
+#ifdef SYS_mbind
+   if (numaNode < sizeof(unsigned long) * 8) {
+      // 不使用 libnuma: 直接呼叫 mbind(MPOL_PREFERRED);
+      // 不支援 NUMA 的系統會失敗, 此時就使用系統預設的配置方式(first touch).
+      const int            kMPOL_PREFERRED = 1;
+      const unsigned long  nodemask = (1ul << numaNode);
+      syscall(SYS_mbind, chunk, kMemSlabChunkSize, kMPOL_PREFERRED, &nodemask, sizeof(nodemask) * 8, 0);
+   }
+#else
+   (void)numaNode;
+#endif
+   return static_cast<byte*>(chunk);
+#endif
+}
+
+/// slab chunk 的對照表: 依照 chunk 位址(>> kMemSlabChunkBits)存放在 2 層的表格, 查詢時不用鎖定.
+/// - 每個 chunk 一個 byte: 0 = 不是 slab chunk; 否則為 (NumaNode * kMemBlockLevelCount + LvIdx + 1);
+/// - chunk 不會歸還給系統, 所以表格只會增加, 不會移除.
+static_assert(kMemSlabNumaMax * kMemBlockLevelCount < 0xff, "MemSlabChunkMap: tag overflow.");
+using MemSlabChunkTag = std::atomic<uint8_t>;
+struct MemSlabChunkMap {
+   std::atomic<MemSlabChunkTag*> Root_[1u << kMemSlabRootBits];
+   uint8_t Find(uintptr_t addr) const {
+      if (fon9_UNLIKELY(IsMemSlabAddrOverflow(addr)))
+         return 0;
+      const uintptr_t   idx = (addr >> kMemSlabChunkBits);
+      MemSlabChunkTag*  leaf = this->Root_[idx >> kMemSlabLeafBits].load(std::memory_order_acquire);
+      return leaf ? leaf[idx & ((1u << kMemSlabLeafBits) - 1)].load(std::memory_order_acquire) : uint8_t{0};
+   }
+   void Insert(uintptr_t base, uint8_t tag) {
+      assert(!IsMemSlabAddrOverflow(base));
+      const uintptr_t                  idx = (base >> kMemSlabChunkBits);
+      std::atomic<MemSlabChunkTag*>&   root = this->Root_[idx >> kMemSlabLeafBits];
+      MemSlabChunkTag*                 leaf = root.load(std::memory_order_acquire);
+      if (leaf == nullptr) {
+         MemSlabChunkTag* newLeaf = new MemSlabChunkTag[1u << kMemSlabLeafBits]();
+         if (root.compare_exchange_strong(leaf, newLeaf, std::memory_order_acq_rel))
+            leaf = newLeaf;
+         else // 其他 thread 已經建立了 leaf, 此時 leaf = 其他 thread 建立的.
+            delete[] newLeaf;
+      }
+      leaf[idx & ((1u << kMemSlabLeafBits) - 1)].store(tag, std::memory_order_release);
+   }
+};
+struct MemSlabArenaImpl {
+   byte*       Curr_{nullptr};
+   byte*       End_{nullptr};
+   /// MemSlabRecycle() 放回的節點, 下次 MemSlabCarve() 優先使用.
+   FreeMemList Spare_;
+};
+/// 每個 (NumaNode, Level) 各自鎖定, 不同 size 或不同 NUMA node 的 FreeNode() 不會互相等候.
+using MemSlabArena = MustLock<MemSlabArenaImpl, SpinBusy>;
+struct MemSlabs {
+   MemSlabChunkMap   ChunkMap_;
+   MemSlabArena      Arenas_[kMemSlabNumaMax][kMemBlockLevelCount];
+};
+static MemSlabs& GetMemSlabs() {
+   // 不解構: 程式結束時, 其他 static 物件解構時, 仍可能透過 FreeNode() 呼叫 MemSlabRecycle();
+   static MemSlabs* MemSlabs_ = new MemSlabs{};
+   return *MemSlabs_;
+}
+
+fon9_API bool MemSlabRecycle(void* mem) {
+   MemSlabs&      slabs = GetMemSlabs();
+   const uint8_t  tag = slabs.ChunkMap_.Find(reinterpret_cast<uintptr_t>(mem));
+   if (tag == 0)
+      return false;
+   MemSlabArena::Locker arena{slabs.Arenas_[(tag - 1u) / kMemBlockLevelCount][(tag - 1u) % kMemBlockLevelCount]};
+   arena->Spare_.push_front(InplaceNew<FreeMemNode>(mem));
+   return true;
+}
+
+void MemSlabCarve(unsigned lvidx, unsigned numaNode, size_t count, FreeMemList& out) {
+   assert(lvidx < kMemBlockLevelCount);
+   numaNode %= kMemSlabNumaMax;
+   const size_t   blksz = MemBlockLevelSize_[lvidx];
+   MemSlabs&      slabs = GetMemSlabs();
+   while (out.size() < count) {
+      byte* pbeg;
+      byte* pend;
+      {
+         MemSlabArena::Locker arena{slabs.Arenas_[numaNode][lvidx]};
+         while (out.size() < count) {
+            if (FreeMemNode* mnode = arena->Spare_.pop_front())
+               out.push_front(mnode);
+            else
+               break;
+         }
+         if (out.size() >= count)
+            return;
+         if (arena->Curr_ == arena->End_) {
+            // kMemSlabChunkSize 可被每個 level 的大小整除, 所以用完時必定剛好 Curr_ == End_;
+            byte* chunk = MemSlabAllocChunk(numaNode);
+            if (chunk == nullptr)
+               return;
+            slabs.ChunkMap_.Insert(reinterpret_cast<uintptr_t>(chunk),
+                                   static_cast<uint8_t>(numaNode * kMemBlockLevelCount + lvidx + 1));
+            arena->Curr_ = chunk;
+            arena->End_ = chunk + kMemSlabChunkSize;
+         }
+         const size_t need = std::min(count - out.size(), static_cast<size_t>(arena->End_ - arena->Curr_) / blksz);
+         pbeg = arena->Curr_;
+         pend = arena->Curr_ += need * blksz;
+      }
+      MemBlockLevelSt_[lvidx].SlabBytes_.fetch_add(static_cast<uint64_t>(pend - pbeg), std::memory_order_relaxed);
+      // 在 lock 之外建立節點: 第一次存取 slab 可能會有 page fault.
+      for (; pbeg != pend; pbeg += blksz)
+         out.push_front(InplaceNew<FreeMemNode>(pbeg));
+   }
+}
+
+//--------------------------------------------------------------------------//
 // kMemBlockCenter_CheckInterval: MemBlock 整理間隔。
 // 不用太頻繁，因為若瞬間有大用量，則應暫時保留較多的緩衝。若用量不大，也沒必要頻繁的整理。
 static const TimeInterval  kMemBlockCenter_CheckInterval{TimeInterval_Millisecond(2000)};
 
-MemBlockCenter::MemBlockCenter() : Timer_{GetDefaultTimerThread()} {
+MemBlockCenter::MemBlockCenter() : Timer_{GetDefaultTimerThread()}, RefillTimer_{GetDefaultTimerThread()} {
    Timer_.RunAfter(TimeInterval{});
 }
 MemBlockCenter::~MemBlockCenter() {
+   this->RefillTimer_.DisposeAndWait();
    this->Timer_.DisposeAndWait();
 }
 
-byte* MemBlockCenter::Alloc(unsigned lvidx, TCacheLevelPool& lv) {
+bool MemBlockCenter::CheckLowWater(CenterLevel::Locker& lvCenter) {
+   if (lvCenter->IsRefillPending_)
+      return false;
+   if (lvCenter->Reserved_.size() * 2 >= lvCenter->ReservedCount_ + lvCenter->RequiredCount_)
+      return false;
+   return lvCenter->IsRefillPending_ = true;
+}
+byte* MemBlockCenter::Alloc(unsigned lvidx, TCacheLevelPool& lv, unsigned numaNode) {
    assert(lv.FreeMemCurr_.empty() && lv.FreeMemNext_.empty());
+   MemBlockLevelSt_[lvidx].Miss_.fetch_add(1, std::memory_order_relaxed);
+   FlushHitCount(lvidx, lv);
    CenterLevel::Locker  lvCenter{this->Levels_[lvidx]};
    if (!IsEnumContains(lv.Flags_, TCacheLevelFlag::Registered)) {
       lv.Flags_ |= TCacheLevelFlag::Registered;
       ++lvCenter->RequiredCount_;
    }
+   lvCenter->NumaNode_ = numaNode;
    CenterLevelNode* cnode = lvCenter->Reserved_.pop_front();
    if (cnode == nullptr)
       cnode = lvCenter->Recycle_.pop_front();
+   const bool isLowWater = CheckLowWater(lvCenter);
    lvCenter.unlock();
+   /// 平時採用 [定時檢查] 的方式補充 CenterLevelList;
+   /// 只有在低於 low-water 時才觸發一次 RefillTimer_, 補充完成前(IsRefillPending_)不會重複觸發.
+   /// 這樣可避免: 大用量(無歸還or在另一thread歸還)時, 此處會不斷的觸發[喚醒檢查this->Levels_], 反而造成效率問題!
+   if (isLowWater) {
+      MemBlockLevelSt_[lvidx].AsyncRefill_.fetch_add(1, std::memory_order_relaxed);
+      this->RefillTimer_.RunAfter(TimeInterval{});
+   }
    if (cnode == nullptr)
       return nullptr;
-   /// 由於採用 [定時檢查] 的方式補充 CenterLevelList, 所以這裡不用再觸發任何通知.
-   /// 這樣可避免: 大用量(無歸還or在另一thread歸還)時, 此處會不斷的觸發[喚醒檢查this->Levels_], 反而造成效率問題!
    lv.FreeMemCurr_ = CenterLevelNode::ToFreeMemList(cnode);
    return reinterpret_cast<byte*>(lv.FreeMemCurr_.pop_front());
 }
 void MemBlockCenter::FreeFull(unsigned lvidx, FreeMemList&& fmlist) {
    if (CenterLevelNode* cnode = CenterLevelNode::FromFreeMemList(std::move(fmlist))) {
+      MemBlockLevelSt_[lvidx].FreeBatch_.fetch_add(1, std::memory_order_relaxed);
       CenterLevel::Locker lvCenter{this->Levels_[lvidx]};
       lvCenter->Reserved_.push_front(cnode);
    }
@@ -55,6 +263,7 @@ void MemBlockCenter::FreeFull(unsigned lvidx, FreeMemList&& fmlist) {
 void MemBlockCenter::Recycle(TCacheLevelPools& levels) {
    unsigned lvidx = 0;
    for (TCacheLevelPool& lv : levels) {
+      FlushHitCount(lvidx, lv);
       if (IsEnumContains(lv.Flags_, TCacheLevelFlag::Registered)) {
          lv.Flags_ -= TCacheLevelFlag::Registered;
          CenterLevelNode*    cnode1 = CenterLevelNode::FromFreeMemList(std::move(lv.FreeMemCurr_));
@@ -85,6 +294,8 @@ void MemBlockCenter::InitLevel(unsigned lvidx, CenterLevel::Locker& lvCenter) {
    size_t   count = (lvCenter->ReservedCount_ + lvCenter->RequiredCount_);
    size_t   curr = lvCenter->Reserved_.size();
    CenterLevelList recycle = std::move(lvCenter->Recycle_);
+   const unsigned numaNode = lvCenter->NumaNode_;
+   lvCenter->IsRefillPending_ = false;
    if (curr > count) {
       CenterLevelList r2 = lvCenter->Reserved_.pop_front(curr - count);
       lvCenter.unlock();
@@ -98,9 +309,14 @@ void MemBlockCenter::InitLevel(unsigned lvidx, CenterLevel::Locker& lvCenter) {
    for (; curr < count; ++curr) {
       FreeMemList fmlist2{CenterLevelNode::ToFreeMemList(recycle.pop_front())};
       if (!FreeMemListMerge(fmlist, fmlist2, maxNodeCount)) {
-         do {
-            fmlist.push_front(InplaceNew<FreeMemNode>(malloc(MemBlockLevelSize_[lvidx])));
-         } while (fmlist.size() < maxNodeCount);
+         // 從 slab 切出連續的節點, 取代逐一 malloc(); slab 無法分配時才使用 malloc().
+         MemSlabCarve(lvidx, numaNode, maxNodeCount, fmlist);
+         if (fmlist.size() < maxNodeCount) {
+            MemBlockLevelSt_[lvidx].MallocFallback_.fetch_add(maxNodeCount - fmlist.size(), std::memory_order_relaxed);
+            do {
+               fmlist.push_front(InplaceNew<FreeMemNode>(malloc(MemBlockLevelSize_[lvidx])));
+            } while (fmlist.size() < maxNodeCount);
+         }
       }
       CenterLevelNode* cnode = CenterLevelNode::FromFreeMemList(std::move(fmlist));
       fmlist = std::move(fmlist2);
@@ -119,6 +335,11 @@ void MemBlockCenter::InitLevel(unsigned lvidx, const size_t* reserveFreeListCoun
       lvCenter->ReservedCount_ = *reserveFreeListCount;
    this->InitLevel(lvidx, lvCenter);
 }
+void MemBlockCenter::GetLevelLists(unsigned lvidx, size_t& reservedLists, size_t& requiredLists) {
+   CenterLevel::Locker lvCenter{this->Levels_[lvidx]};
+   reservedLists = lvCenter->Reserved_.size();
+   requiredLists = lvCenter->ReservedCount_ + lvCenter->RequiredCount_;
+}
 
 void MemBlockCenter::EmitOnTimer(TimerEntry* timer, TimeStamp) {
    MemBlockCenter& rthis = ContainerOf(*static_cast<decltype(MemBlockCenter::Timer_)*>(timer), &MemBlockCenter::Timer_);
@@ -126,6 +347,14 @@ void MemBlockCenter::EmitOnTimer(TimerEntry* timer, TimeStamp) {
       rthis.InitLevel(lvidx, nullptr);
    timer->RunAfter(kMemBlockCenter_CheckInterval);
 }
+void MemBlockCenter::EmitOnRefill(TimerEntry* timer, TimeStamp) {
+   MemBlockCenter& rthis = ContainerOf(*static_cast<decltype(MemBlockCenter::RefillTimer_)*>(timer), &MemBlockCenter::RefillTimer_);
+   for (unsigned lvidx = 0; lvidx < kMemBlockLevelCount; ++lvidx) {
+      CenterLevel::Locker lvCenter{rthis.Levels_[lvidx]};
+      if (lvCenter->IsRefillPending_)
+         rthis.InitLevel(lvidx, lvCenter);
+   }
+}
 
 using MemBlockCenterSP = intrusive_ptr<MemBlockCenter>;
 static MemBlockCenterSP GetMemBlockCenter() {
@@ -143,24 +372,58 @@ fon9_API bool MemBlockInit(MemBlockSize size, size_t reserveFreeListCount, size_
    GetMemBlockCenter()->InitLevel(lvidx, &reserveFreeListCount);
    return true;
 }
+fon9_API bool MemBlockGetLevelSt(unsigned lvidx, MemBlockLevelStInfo& st) {
+   if (lvidx >= kMemBlockLevelCount)
+      return false;
+   const MemBlockLevelSt& src = MemBlockLevelSt_[lvidx];
+   st.BlockSize_ = MemBlockLevelSize_[lvidx];
+   st.Hit_ = src.Hit_.load(std::memory_order_relaxed);
+   st.Miss_ = src.Miss_.load(std::memory_order_relaxed);
+   st.SlabRefill_ = src.SlabRefill_.load(std::memory_order_relaxed);
+   st.MallocFallback_ = src.MallocFallback_.load(std::memory_order_relaxed);
+   st.FreeBatch_ = src.FreeBatch_.load(std::memory_order_relaxed);
+   st.AsyncRefill_ = src.AsyncRefill_.load(std::memory_order_relaxed);
+   st.SlabBytes_ = src.SlabBytes_.load(std::memory_order_relaxed);
+   if (MemBlockCenterSP center = GetMemBlockCenter())
+      center->GetLevelLists(lvidx, st.ReservedLists_, st.RequiredLists_);
+   else
+      st.ReservedLists_ = st.RequiredLists_ = 0;
+   return true;
+}
 } // namespace impl
 using namespace impl;
 
 //--------------------------------------------------------------------------//
 
+fon9_WARN_DISABLE_PADDING;
 class MemBlock::TCache {
    fon9_NON_COPY_NON_MOVE(TCache);
    TCacheLevelPools        Levels_;
+
+   /// MemBlockCenter 也沒有可用的串列: 從此 thread 所在 NUMA node 的 slab 切出一小批.
+   byte* SlabRefill(unsigned lvidx, TCacheLevelPool& lv) {
+      MemSlabCarve(lvidx, this->NumaNode_, std::min(MemBlockLevelMaxNodeCount_[lvidx], kMemSlab_RefillCount), lv.FreeMemCurr_);
+      byte* pmem = reinterpret_cast<byte*>(lv.FreeMemCurr_.pop_front());
+      if (pmem)
+         MemBlockLevelSt_[lvidx].SlabRefill_.fetch_add(1, std::memory_order_relaxed);
+      return pmem;
+   }
 public:
    const MemBlockCenterSP  Center_;
-   TCache() : Center_{GetMemBlockCenter()} {
+   const unsigned          NumaNode_;
+   TCache() : Center_{GetMemBlockCenter()}, NumaNode_{GetThisNumaNode()} {
    }
    ~TCache() {
       this->Center_->Recycle(this->Levels_);
    }
+   /// 沒有 TCache 時的釋放: mem 可能是從 slab 切出來的.
+   static void FreeNoCache(void* mem) {
+      if (!MemSlabRecycle(mem))
+         free(mem);
+   }
    static byte* UseMalloc(MemBlock& mblk, MemBlockSize sz) {
       if (fon9_UNLIKELY(mblk.MemPtr_))
-         free(mblk.MemPtr_);
+         FreeNoCache(mblk.MemPtr_);
       if (fon9_LIKELY((mblk.Size_ = -static_cast<SSizeT>(sz)) <= 0))
          if (fon9_LIKELY((mblk.MemPtr_ = reinterpret_cast<byte*>(malloc(sz))) != nullptr))
             return mblk.MemPtr_;
@@ -182,12 +445,17 @@ public:
          lv.FreeMemCurr_ = std::move(lv.FreeMemNext_);
       byte* pmem = reinterpret_cast<byte*>(lv.FreeMemCurr_.pop_front());
       if (fon9_UNLIKELY(pmem == nullptr)) {
-         if ((pmem = this->Center_->Alloc(lvidx, lv)) == nullptr) {
+         if ((pmem = this->Center_->Alloc(lvidx, lv, this->NumaNode_)) == nullptr) {
             ++lv.EmptyCount_;
-            if ((pmem = static_cast<byte*>(malloc(newsz))) == nullptr)
-               return nullptr;
+            if ((pmem = this->SlabRefill(lvidx, lv)) == nullptr) {
+               MemBlockLevelSt_[lvidx].MallocFallback_.fetch_add(1, std::memory_order_relaxed);
+               if ((pmem = static_cast<byte*>(malloc(newsz))) == nullptr)
+                  return nullptr;
+            }
          }
       }
+      else if (fon9_UNLIKELY(++lv.HitCount_ >= kMemBlockSt_HitFlushCount))
+         FlushHitCount(lvidx, lv);
       mblk.Size_ = static_cast<SSizeT>(newsz);
       return mblk.MemPtr_ = pmem;
    }
@@ -204,8 +472,11 @@ public:
       FreeMemNode*      node = InplaceNew<FreeMemNode>(ptr);
       const size_t      maxNodeCount = MemBlockLevelMaxNodeCount_[lvidx];
       TCacheLevelPool&  lv = this->Levels_[lvidx];
+      // 只負責歸還的 thread(例: 在 A thread 分配, 在 B thread 釋放), 不使用 FreeMemNext_:
+      // 滿一整串就立即交給 MemBlockCenter, 讓分配端能盡快取回, 也避免在 B thread 累積 2 倍的量.
       FreeMemList*      fmlist = (lv.FreeMemCurr_.size() < maxNodeCount ? &lv.FreeMemCurr_
-                                  : lv.FreeMemNext_.size() < maxNodeCount ? &lv.FreeMemNext_
+                                  : (lv.FreeMemNext_.size() < maxNodeCount
+                                     && IsEnumContains(lv.Flags_, TCacheLevelFlag::Registered)) ? &lv.FreeMemNext_
                                   : nullptr);
       if (fon9_LIKELY(fmlist)) {
          fmlist->push_front(node);
@@ -215,6 +486,7 @@ public:
       lv.FreeMemCurr_.push_front(node);
    }
 };
+fon9_WARN_POP;
 static thread_local StaticPtr<MemBlock::TCache> TlsTCache_;
 
 //--------------------------------------------------------------------------//
@@ -236,10 +508,19 @@ __TCACHE_READY:
 void MemBlock::FreeBlock(void* mem, MemBlockSize sz) {
    if (fon9_LIKELY(mem)) {
       auto* TCache_ = TlsTCache_.get();
-      if (fon9_LIKELY(TCache_))
+      if (fon9_LIKELY(TCache_)) {
+__TCACHE_READY:
          TCache_->Free(mem, sz);
-      else
-         free(mem);
+         return;
+      }
+      // 只負責釋放的 thread(例: 在 A thread 分配, 在 B thread 釋放), 也需要 TCache, 才能整批歸還給 MemBlockCenter.
+      if (MemBlockSizeToIndex(sz) < kMemBlockLevelCount && !TlsTCache_.IsDisposed()) {
+         TlsTCache_.reset(TCache_ = new MemBlock::TCache);
+         if (TCache_->Center_)
+            goto __TCACHE_READY;
+         TlsTCache_.dispose();
+      }
+      TCache::FreeNoCache(mem);
    }
 }
 
@@ -35,7 +35,9 @@ public:
       this->Alloc(sz);
    }
 
-   MemBlock(MemBlock&& r) : MemPtr_(r.Release()), Size_(r.Size_) {
+   MemBlock(MemBlock&& r) : MemPtr_(r.MemPtr_), Size_(r.Size_) {
+      // 不能在初始化列表使用 r.Release(): 會先清除 r.Size_, 造成 this->Size_ 為 0.
+      r.Release();
    }
    MemBlock& operator=(MemBlock&& r) {
       if (this->MemPtr_ != r.MemPtr_) {
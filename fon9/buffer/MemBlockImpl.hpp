@@ -7,6 +7,7 @@
 #include "fon9/SpinMutex.hpp"
 #include "fon9/Timer.hpp"
 #include <array>
+#include <atomic>
 
 namespace fon9 {
 
@@ -46,17 +47,38 @@ constexpr std::array<MemBlockSize, kMemBlockLevelCount> MemBlockLevelSize_{
 //--------------------------------------------------------------------------//
 
 namespace impl {
+/// 若 mem 是從 slab 切出來的, 則放回 slab 的備用串列, 返回 true; 否則返回 false, 由呼叫端 free(mem);
+fon9_API bool MemSlabRecycle(void* mem);
+
 struct FreeMemNode : public SinglyLinkedListNode<FreeMemNode> {
    fon9_NON_COPY_NON_MOVE(FreeMemNode);
    FreeMemNode() = default;
    inline friend void FreeNode(FreeMemNode* mnode) {
-      ::free(mnode);
+      if (!MemSlabRecycle(mnode))
+         ::free(mnode);
    }
 };
 using FreeMemList = SinglyLinkedList<FreeMemNode>;
 
 //--------------------------------------------------------------------------//
 
+enum : size_t {
+   /// 每次從系統取得的 slab 大小, 也是 slab 的對齊方式: 配合 huge page(2M).
+   kMemSlabChunkSize = 1024 * 1024 * 2,
+   /// 支援的 NUMA node 數量, 超過的 node 使用 (node % kMemSlabNumaMax).
+   kMemSlabNumaMax = 8,
+};
+/// 取得目前 thread 所在的 NUMA node; 不支援時返回 0.
+unsigned GetThisNumaNode();
+/// 從 numaNode 的 slab 切出節點, 加入 out, 直到 out.size() >= count 或 slab 無法再分配.
+/// - 優先使用 MemSlabRecycle() 的備用節點.
+/// - Linux: slab 使用 mmap() 取得, 並設定 MADV_HUGEPAGE 及 mbind(MPOL_PREFERRED, numaNode),
+///   所以不論哪個 thread 第一次存取, 實體記憶體都會優先配置在 numaNode.
+/// - slab 不會歸還給系統.
+void MemSlabCarve(unsigned lvidx, unsigned numaNode, size_t count, FreeMemList& out);
+
+//--------------------------------------------------------------------------//
+
 enum class TCacheLevelFlag {
    Registered = 0x01,
 };
@@ -69,6 +91,8 @@ struct TCacheLevelPool {
    FreeMemList       FreeMemCurr_;
    FreeMemList       FreeMemNext_;
    size_t            EmptyCount_{0};
+   /// 尚未加到 MemBlockLevelSt::Hit_ 的次數, 累積一定數量(或 Miss)時才加入, 避免每次 Alloc 都使用 atomic.
+   uint32_t          HitCount_{0};
    TCacheLevelFlag   Flags_{};
 };
 using TCacheLevelPools = std::array<TCacheLevelPool, kMemBlockLevelCount>;
@@ -129,6 +153,8 @@ class MemBlockCenter : public intrusive_ref_counter<MemBlockCenter> {
       CenterLevelList   Recycle_;  // 尚未整理的歸還, 每個 FreeMemList 數量不定.
       size_t            ReservedCount_{4}; // 預設 or 透過 MemBlockInit() 設定的最少串列保留數量.
       size_t            RequiredCount_{0}; // 每個 thread 會要求增加一個保留數量.
+      unsigned          NumaNode_{0};      // 最後一次 Alloc() 的 thread 所在的 NUMA node, 補充時從這裡的 slab 分配.
+      bool              IsRefillPending_{false}; // 已要求 RefillTimer_ 補充, 尚未執行.
    };
    using CenterLevel = MustLock<CenterLevelImpl, SpinBusy>;
 
@@ -137,20 +163,57 @@ class MemBlockCenter : public intrusive_ref_counter<MemBlockCenter> {
 
    static void EmitOnTimer(TimerEntry* timer, TimeStamp now);
    DataMemberEmitOnTimer<&MemBlockCenter::EmitOnTimer> Timer_;
+   /// Reserved_ 低於 low-water 時, 不用等 Timer_ 定時整理, 立即補充.
+   static void EmitOnRefill(TimerEntry* timer, TimeStamp now);
+   DataMemberEmitOnTimer<&MemBlockCenter::EmitOnRefill> RefillTimer_;
 
    void InitLevel(unsigned lvidx, CenterLevel::Locker& lvCenter);
+   /// 檢查 low-water: Reserved_ 少於需求量的一半, 則要求 RefillTimer_ 補充.
+   /// 返回 true 表示需要呼叫 this->RefillTimer_.RunAfter(); 在 lvCenter.unlock() 之後呼叫.
+   static bool CheckLowWater(CenterLevel::Locker& lvCenter);
 public:
    MemBlockCenter();
    ~MemBlockCenter();
 
-   byte* Alloc(unsigned lvidx, TCacheLevelPool& lv);
+   byte* Alloc(unsigned lvidx, TCacheLevelPool& lv, unsigned numaNode);
    void FreeFull(unsigned lvidx, FreeMemList&& fmlist);
    void Recycle(TCacheLevelPools& levels);
    void InitLevel(unsigned lvidx, const size_t* reserveFreeListCount);
+   void GetLevelLists(unsigned lvidx, size_t& reservedLists, size_t& requiredLists);
 };
 fon9_WARN_POP;
 
 fon9_API bool MemBlockInit(MemBlockSize size, size_t reserveFreeListCount, size_t maxNodeCount);
+
+/// 每個 level 的使用統計.
+struct MemBlockLevelSt {
+   std::atomic<uint64_t>   Hit_{0};       ///< 從 thread cache 取得.
+   std::atomic<uint64_t>   Miss_{0};      ///< thread cache 用完, 向 MemBlockCenter 取得串列.
+   std::atomic<uint64_t>   SlabRefill_{0};///< MemBlockCenter 也沒有, thread 自行從 slab 切出串列.
+   std::atomic<uint64_t>   MallocFallback_{0}; ///< slab 無法分配, 改用 malloc() 的節點數量.
+   std::atomic<uint64_t>   FreeBatch_{0}; ///< thread cache 已滿, 整串歸還給 MemBlockCenter 的次數.
+   std::atomic<uint64_t>   AsyncRefill_{0}; ///< 低於 low-water, 觸發非同步補充的次數.
+   std::atomic<uint64_t>   SlabBytes_{0}; ///< 從 slab 切出的記憶體量.
+};
+fon9_WARN_DISABLE_PADDING;
+struct MemBlockLevelStInfo {
+   MemBlockSize   BlockSize_;
+   uint64_t       Hit_;
+   uint64_t       Miss_;
+   uint64_t       SlabRefill_;
+   uint64_t       MallocFallback_;
+   uint64_t       FreeBatch_;
+   uint64_t       AsyncRefill_;
+   uint64_t       SlabBytes_;
+   /// MemBlockCenter 目前保留的串列數量.
+   size_t         ReservedLists_;
+   /// MemBlockCenter 需要保留的串列數量 = MemBlockInit() 設定的數量 + 使用此 level 的 thread 數量.
+   size_t         RequiredLists_;
+};
+fon9_WARN_POP;
+/// 取得 lvidx 的統計資料; lvidx >= kMemBlockLevelCount 則返回 false.
+/// Hit_ 由各 thread 累積一定數量後才加入, 所以可能會少算最近的數量.
+fon9_API bool MemBlockGetLevelSt(unsigned lvidx, MemBlockLevelStInfo& st);
 } // namespace impl
 } // namespace fon9
 #endif//__fon9_buffer_MemBlockImpl_hpp__
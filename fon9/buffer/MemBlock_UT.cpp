@@ -126,6 +126,32 @@ fon9_WARN_POP;
 
 //--------------------------------------------------------------------------//
 
+void PrintMemBlockLevelSt() {
+   bool isOK = true;
+   for (unsigned lvidx = 0; lvidx < fon9::kMemBlockLevelCount; ++lvidx) {
+      fon9::impl::MemBlockLevelStInfo st;
+      fon9::impl::MemBlockGetLevelSt(lvidx, st);
+      std::cout << "size=" << std::setw(7) << st.BlockSize_
+         << "|hit=" << st.Hit_ << "|miss=" << st.Miss_
+         << "|slabRefill=" << st.SlabRefill_ << "|mallocFallback=" << st.MallocFallback_
+         << "|freeBatch=" << st.FreeBatch_ << "|asyncRefill=" << st.AsyncRefill_
+         << "|slabBytes=" << st.SlabBytes_
+         << "|lists=" << st.ReservedLists_ << '/' << st.RequiredLists_ << std::endl;
+      // slab 可以分配時, 不應該使用 malloc();
+      if (st.MallocFallback_ != 0)
+         isOK = false;
+      // 測試使用 MemBlock(256).
+      if (st.BlockSize_ == 256 && (st.Hit_ == 0 || st.SlabBytes_ == 0))
+         isOK = false;
+   }
+   if (!isOK) {
+      std::cout << "ERROR: MemBlockLevelSt." << std::endl;
+      abort();
+   }
+}
+
+//--------------------------------------------------------------------------//
+
 int main() {
 #if defined(_MSC_VER) && defined(_DEBUG)
    _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
@@ -185,4 +211,7 @@ int main() {
    std::cout << "--- ThrA:Alloc => ThrB:Free ---\n";
    TestMemThread<fon9::MemBlock>(kTimes, "MemBlock.Thread:");
    TestMemThread<MemAuto>       (kTimes, "malloc.Thread:  ");
+
+   utinfo.PrintSplitter();
+   PrintMemBlockLevelSt();
 }
@@ -4,6 +4,16 @@
 
 namespace fon9 { namespace fix {
 
+void FixBuilder::Start(const FixMsgTemplate& tmpl) {
+   const StrView  flds = tmpl.GetFields();
+   char* const    pend = this->Buffer_.AllocPrefix(kFixTailWidth + flds.size());
+   this->TimeFIXMS_ = nullptr;
+   this->CheckSumPos_ = pend - kFixTailWidth;
+   char* const    pflds = this->CheckSumPos_ - flds.size();
+   memcpy(pflds, flds.begin(), flds.size());
+   this->Buffer_.SetPrefixUsed(pflds);
+}
+
 void FixBuilder::PutUtcTime(TimeStamp now) {
    RevPut_TimeFIXMS(this->Buffer_, this->Time_ = now);
    this->TimeFIXMS_ = this->Buffer_.GetCurrent();
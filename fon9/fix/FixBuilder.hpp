@@ -8,6 +8,33 @@
 
 namespace fon9 { namespace fix {
 
+/// \ingroup fix
+/// 預先編碼的 FIX 固定欄位, 例: 每筆下單都相同的 Account, HandlInst, TimeInForce...
+/// - 使用 FixBuilder{tmpl} 開始建立訊息, 固定欄位會一次複製到訊息尾端,
+///   之後再用 RevPrint() 加入變動欄位(在固定欄位之前).
+/// \code
+///   static const FixMsgTemplate kNewOrderFields{f9fix_SPLTAGEQ(HandlInst) "1"
+///                                               f9fix_SPLTAGEQ(Account) "12345"};
+///   FixBuilder fixb{kNewOrderFields};
+///   RevPrint(fixb.GetBuffer(), f9fix_SPLTAGEQ(ClOrdID), clOrdId);
+///   fixSender.Send(f9fix_SPLFLDMSGTYPE(NewOrderSingle), std::move(fixb));
+/// \endcode
+class fon9_API FixMsgTemplate {
+   std::string Fields_;
+public:
+   /// fields: "|tag=value|tag=value..." 這裡不檢查格式是否正確!
+   explicit FixMsgTemplate(StrView fields = StrView{}) {
+      this->Reset(fields);
+   }
+   void Reset(StrView fields) {
+      this->Fields_.assign(fields.begin(), fields.end());
+   }
+
+   StrView GetFields() const {
+      return ToStrView(this->Fields_);
+   }
+};
+
 /// \ingroup fix
 /// FIX Message 產生器.
 /// - 緩衝區在 Final() 之後就會被取出, 所以此物件沒有額外的負擔,
@@ -41,10 +68,15 @@ class fon9_API FixBuilder {
       this->CheckSumPos_ = this->Buffer_.AllocPrefix(kFixTailWidth);
       this->Buffer_.SetPrefixUsed(this->CheckSumPos_ -= kFixTailWidth);
    }
+   void Start(const FixMsgTemplate& tmpl);
 public:
    FixBuilder() {
       this->Start();
    }
+   /// 開始建立 FIX Message, 並在尾端放入 tmpl 的固定欄位.
+   explicit FixBuilder(const FixMsgTemplate& tmpl) {
+      this->Start(tmpl);
+   }
    explicit FixBuilder(bool isManualStart) {
       if (isManualStart) {
          this->CheckSumPos_ = nullptr;
@@ -89,6 +121,10 @@ public:
       assert(this->CheckSumPos_ == nullptr);
       return this->Start();
    }
+   void Restart(const FixMsgTemplate& tmpl) {
+      assert(this->CheckSumPos_ == nullptr);
+      return this->Start(tmpl);
+   }
    /// 訊息建立完畢, 最終填入 BeginString, BodyLength, 計算 CheckSum.
    /// \param beginHeader "8=FIX.4.x|9=" 這裡不檢查 header 是否正確!
    /// \return 傳回建立好的 FIX Message: 包含 beginHeader + body + checksum.
@@ -2,9 +2,62 @@
 // \author fonwinz@gmail.com
 #include "fon9/fix/FixParser.hpp"
 #include "fon9/StrTo.hpp"
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define f9fix_PARSER_SSE2
+fon9_BEFORE_INCLUDE_STD;
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+fon9_AFTER_INCLUDE_STD;
+#endif
 
 namespace fon9 { namespace fix {
 
+#ifdef f9fix_PARSER_SSE2
+static inline unsigned FirstBitIndex(unsigned mask) {
+#ifdef _MSC_VER
+   unsigned long idx;
+   _BitScanForward(&idx, mask);
+   return static_cast<unsigned>(idx);
+#else
+   return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+#endif
+/// 返回 [pbeg, pend) 全部字元的累加值.
+static inline byte SumBytes(const char* pbeg, const char* const pend) {
+   unsigned sum = 0;
+#ifdef f9fix_PARSER_SSE2
+   // _mm_sad_epu8(v, 0): 每 8 bytes 的累加值, 放在 2 個 64 bits 的 lane.
+   __m128i vsum = _mm_setzero_si128();
+   for (; pend - pbeg >= 16; pbeg += 16)
+      vsum = _mm_add_epi64(vsum, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pbeg)), _mm_setzero_si128()));
+   sum = static_cast<unsigned>(_mm_cvtsi128_si32(vsum)) + static_cast<unsigned>(_mm_cvtsi128_si32(_mm_srli_si128(vsum, 8)));
+#endif
+   while (pbeg < pend)
+      sum += static_cast<byte>(*pbeg++);
+   return static_cast<byte>(sum);
+}
+/// 返回 [pbeg, pend) 第一個 f9fix_kCHAR_SPL 的位置, 若沒找到則返回 pend.
+static inline const char* FindSPL(const char* pbeg, const char* const pend) {
+#ifdef f9fix_PARSER_SSE2
+   const __m128i spl = _mm_set1_epi8(f9fix_kCHAR_SPL);
+   for (; pend - pbeg >= 16; pbeg += 16) {
+      const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+         _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pbeg)), spl)));
+      if (mask)
+         return pbeg + FirstBitIndex(mask);
+   }
+#endif
+   while (pbeg < pend && *pbeg != f9fix_kCHAR_SPL)
+      ++pbeg;
+   return pbeg;
+}
+//--------------------------------------------------------------------------//
+
 FixParser::FixParser() {
    // 預先分配必用(常用)的欄位: 1..511.
    // 0..0xff(255)
@@ -16,6 +69,7 @@ void FixParser::Clear() {
    this->MsgSeqNum_ = 0;
    this->ExpectSize_ = 0;
    this->MIndexNext_ = 0;
+   this->ClearLazyFields();
    if (this->FieldList_.empty())
       return;
    for (FixField* fld : this->FieldList_)
@@ -80,10 +134,8 @@ FixParser::Result FixParser::Verify(StrView& fixmsg, VerifyItem vitem) {
           || pend[2] != '0'
           || pend[3] != '=')
          return EFormat;
-      byte cks = Pic9StrTo<3, byte>(pend + 4);// static_cast<byte>(((pend[4] - '0') * 10 + (pend[5] - '0')) * 10 + (pend[6] - '0'));
-      while (pbeg < pend)
-         cks = static_cast<byte>(cks - static_cast<byte>(*pbeg++));
-      if (cks != f9fix_kCHAR_SPL) {
+      const byte cks = Pic9StrTo<3, byte>(pend + 4);// static_cast<byte>(((pend[4] - '0') * 10 + (pend[5] - '0')) * 10 + (pend[6] - '0'));
+      if (static_cast<byte>(cks - SumBytes(pbeg, pend)) != f9fix_kCHAR_SPL) {
          this->Clear();
          this->ExpectSize_ = static_cast<ExpectSize>(expsz);
          return ECheckSum;
@@ -99,7 +151,9 @@ FixParser::Result FixParser::Parse(StrView& fixmsg, Until until) {
    this->Clear();
    if (rcode < NeedsMore)
       return rcode;
-   Result pcode = this->ParseFields(fixmsg, until);
+   Result pcode = ((until == Until::FullMessage && this->IsLazyParse_)
+                   ? this->IndexFields(fixmsg)
+                   : this->ParseFields(fixmsg, until));
    if (pcode < 0) // 發生錯誤, 傳回錯誤代碼.
       return pcode;
    return rcode;
@@ -113,23 +167,10 @@ FixParser::Result FixParser::ParseFields(StrView& fixmsg, Until until) {
       fixmsg.SetBegin(fixmsg.begin() + 1); //移除 '='
 
       FixField& fld = this->FieldArray_[tag];
-      if (fon9_UNLIKELY(fld.ValueCount_ >= kMaxDupFieldCount + 1))
+      StrView*  pValue = this->AllocValue(fld);
+      if (fon9_UNLIKELY(pValue == nullptr))
          return EDupField;
       fld.Tag_ = tag;
-      StrView* pValue;
-      if (fon9_LIKELY(fld.ValueCount_ == 0))
-         pValue = &fld.Value_;
-      else {
-         if (fld.ValueCount_ == 1) {
-            fld.MIndex_ = this->MIndexNext_;
-            fon9_GCC_WARN_DISABLE("-Wconversion"); // warning: conversion to ‘uint16_t’ from ‘int’ may alter its value[-Wconversion]
-            this->MIndexNext_ += kMaxDupFieldCount;
-            fon9_GCC_WARN_POP;
-            if (this->MFields_.size() < this->MIndexNext_)
-               this->MFields_.resize(this->MIndexNext_ + kMaxDupFieldCount * 4u);
-         }
-         pValue = &this->MFields_[fld.MIndex_ + (fld.ValueCount_ - 1u)];
-      }
 
       if (fon9_LIKELY(tag != f9fix_kTAG_RawData))
          *pValue = StrFetchNoTrim(fixmsg, f9fix_kCHAR_SPL);
@@ -169,6 +210,119 @@ FixParser::Result FixParser::ParseFields(StrView& fixmsg, Until until) {
    this->MsgSeqNum_ = (fldMsgSeqNum ? StrTo(fldMsgSeqNum->Value_, 0u) : 0);
    return ParseEnd;
 }
+inline StrView* FixParser::AllocValue(FixField& fld) {
+   if (fon9_LIKELY(fld.ValueCount_ == 0))
+      return &fld.Value_;
+   if (fon9_UNLIKELY(fld.ValueCount_ >= kMaxDupFieldCount + 1))
+      return nullptr;
+   if (fld.ValueCount_ == 1) {
+      fld.MIndex_ = this->MIndexNext_;
+      fon9_GCC_WARN_DISABLE("-Wconversion"); // warning: conversion to ‘uint16_t’ from ‘int’ may alter its value[-Wconversion]
+      this->MIndexNext_ += kMaxDupFieldCount;
+      fon9_GCC_WARN_POP;
+      if (this->MFields_.size() < this->MIndexNext_)
+         this->MFields_.resize(this->MIndexNext_ + kMaxDupFieldCount * 4u);
+   }
+   return &this->MFields_[fld.MIndex_ + (fld.ValueCount_ - 1u)];
+}
+FixParser::Result FixParser::IndexFields(StrView& fixmsg) {
+   const char* const msgend = fixmsg.end();
+   const char*       pbeg = fixmsg.begin();
+   size_t            rawDataLengthIdx = 0; // RawDataLength 在 LazyFields_ 的位置 + 1;
+   while (pbeg < msgend) {
+      // tag: 使用簡單的迴圈, 比 StrTo() 快, 結果相同: 不允許空白, 必須由 '=' 結束.
+      FixTag tag = 0;
+      const char* ptag = pbeg;
+      for (; ptag < msgend && static_cast<unsigned char>(*ptag - '0') <= 9; ++ptag) {
+         const FixTag digit = static_cast<FixTag>(*ptag - '0');
+         if (fon9_UNLIKELY(tag > (std::numeric_limits<FixTag>::max() - digit) / 10)) {
+            fixmsg.SetBegin(pbeg);
+            return EFormat;
+         }
+         tag = tag * 10 + digit;
+      }
+      if (fon9_UNLIKELY(tag == 0 || ptag >= msgend || *ptag != '=')) {
+         fixmsg.SetBegin(ptag);
+         return EFormat;
+      }
+      const char* const pval = ptag + 1;
+      if (fon9_LIKELY(tag != f9fix_kTAG_RawData || rawDataLengthIdx == 0))
+         pbeg = FindSPL(pval, msgend);
+      else { // RawData 可包含任意字元, 所以要用 RawDataLength 來判斷長度.
+         const uint32_t rawsz = StrTo(this->LazyFields_[rawDataLengthIdx - 1].Value_, static_cast<uint32_t>(-1));
+         if (fon9_UNLIKELY(rawsz > static_cast<size_t>(msgend - pval)))
+            goto __RAW_DATA_ERROR;
+         pbeg = pval + rawsz;
+         if (fon9_UNLIKELY(pbeg != msgend && *pbeg != f9fix_kCHAR_SPL)) {
+         __RAW_DATA_ERROR:
+            fixmsg.SetBegin(pval);
+            return ERawData;
+         }
+      }
+      this->LazyFields_.push_back(LazyField{tag, 0, FixValue{pval, pbeg}});
+      const uint32_t lfno = static_cast<uint32_t>(this->LazyFields_.size());
+      const uint32_t bucket = LazyHash(tag);
+      if (this->LazyHead_[bucket] == 0)
+         this->LazyHead_[bucket] = lfno;
+      else
+         this->LazyFields_[this->LazyTail_[bucket] - 1].Next_ = lfno;
+      this->LazyTail_[bucket] = lfno;
+      if (tag == f9fix_kTAG_RawDataLength)
+         rawDataLengthIdx = lfno;
+      if (pbeg < msgend)
+         ++pbeg; // 移除 f9fix_kCHAR_SPL;
+   }
+   fixmsg.SetBegin(msgend);
+   const FixField* fldMsgSeqNum = this->GetField(f9fix_kTAG_MsgSeqNum);
+   this->MsgSeqNum_ = (fldMsgSeqNum ? StrTo(fldMsgSeqNum->Value_, 0u) : 0);
+   return ParseEnd;
+}
+void FixParser::ClearLazyFields() {
+   if (this->LazyFields_.empty())
+      return;
+   this->LazyFields_.clear();
+   memset(this->LazyHead_, 0, sizeof(this->LazyHead_));
+}
+const FixParser::FixField* FixParser::MaterializeField(FixTag tag) {
+   FixField* fld = nullptr;
+   for (uint32_t lfno = this->LazyHead_[LazyHash(tag)]; lfno != 0;) {
+      const LazyField& lf = this->LazyFields_[lfno - 1];
+      lfno = lf.Next_;
+      if (lf.Tag_ != tag)
+         continue;
+      if (fld == nullptr) {
+         fld = &this->FieldArray_[tag];
+         fld->Tag_ = tag;
+      }
+      StrView* pValue = this->AllocValue(*fld);
+      if (fon9_UNLIKELY(pValue == nullptr))
+         break;
+      *pValue = lf.Value_;
+      ++fld->ValueCount_;
+      this->FieldList_.push_back(fld);
+   }
+   return fld;
+}
+void FixParser::MaterializeAll() {
+   if (this->LazyFields_.empty())
+      return;
+   // 清除已建立的欄位, 然後依照訊息內的順序重建.
+   for (FixField* fld : this->FieldList_)
+      fld->ValueCount_ = 0;
+   this->FieldList_.clear();
+   this->MIndexNext_ = 0;
+   for (const LazyField& lf : this->LazyFields_) {
+      FixField& fld = this->FieldArray_[lf.Tag_];
+      StrView*  pValue = this->AllocValue(fld);
+      if (fon9_UNLIKELY(pValue == nullptr))
+         continue;
+      fld.Tag_ = lf.Tag_;
+      *pValue = lf.Value_;
+      ++fld.ValueCount_;
+      this->FieldList_.push_back(&fld);
+   }
+   this->ClearLazyFields();
+}
 StrView FixParser::GetValue(const FixField& fld, unsigned index) const {
    return index >= fld.ValueCount_ ? StrView{nullptr}
       : index == 0 ? fld.Value_
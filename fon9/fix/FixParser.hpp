@@ -21,6 +21,7 @@ namespace fon9 { namespace fix {
 ///   - 通常一個 FixSession 擁有一個 FixParser 處理解析後的結果.
 ///   - 直到 FixSession 結束後釋放 FixParser.
 /// - 不解析 "8=BeginString" 及 "9=BodyLength", 所以 GetField(8) 及 GetField(9) 都傳回 nullptr.
+/// - 可透過 SetLazyParse(true) 設定 lazy 模式, 只在 GetField() 需要時才建立 FixField.
 class fon9_API FixParser {
    fon9_NON_COPY_NON_MOVE(FixParser);
 public:
@@ -58,6 +59,23 @@ public:
    const CharVector& GetExpectHeader() const {
       return this->ExpectHeader_;
    }
+
+   /// 設定 Parse(fixmsg, Until::FullMessage) 是否使用 lazy 模式:
+   /// - 仍會檢查 header, BodyLength, CheckSum, 及每個欄位的 "tag=" 格式.
+   /// - 解析時只建立欄位索引(tag + value 的位置), 在 GetField() 時才建立該欄位的 FixField.
+   ///   適用於: 欄位很多, 但只會用到少數欄位的訊息, 例: 交易所回報.
+   /// - 不檢查 EDupField, 超過 kMaxDupFieldCount 的重複欄位會被忽略.
+   /// - begin(), end(), count() 只包含已建立的欄位, 若需要全部欄位, 請先呼叫 MaterializeAll();
+   /// - 直接呼叫 ParseFields() 不受影響, 仍會立即解析全部欄位.
+   void SetLazyParse(bool isLazy) {
+      this->IsLazyParse_ = isLazy;
+   }
+   bool IsLazyParse() const {
+      return this->IsLazyParse_;
+   }
+   /// 在 lazy 模式的 Parse() 之後, 依照訊息內的順序建立全部的 FixField.
+   /// 之後的 begin(), end(), count() 與非 lazy 模式相同.
+   void MaterializeAll();
    /// 期望的訊息長度, 包含 header & body & tailer.
    /// - 在 Clear() 時清為 0.
    /// - 在 Verify() 時設定正確的長度.
@@ -161,7 +179,11 @@ public:
    /// \retval !nullptr 在 Clear() 之後的 ParseFields() 欄位至少出現過一次.
    const FixField* GetField(FixTag tag) const {
       const FixField& fld = this->FieldArray_[tag];
-      return(fld.ValueCount_ > 0 ? &fld : nullptr);
+      if (fon9_LIKELY(fld.ValueCount_ > 0))
+         return &fld;
+      if (fon9_UNLIKELY(!this->LazyFields_.empty()))
+         return const_cast<FixParser*>(this)->MaterializeField(tag);
+      return nullptr;
    }
    /// 當同一個欄位重複出現, 則透過此處找後續出現的 values.
    /// - 若 index >= fld.ValueCount_ 則返回 nullptr;
@@ -197,6 +219,37 @@ private:
    uint16_t    MIndexNext_{0};
    using MFields = std::vector<StrView>;
    MFields     MFields_;
+
+   /// lazy 模式的欄位索引, 尚未建立 FixField 的欄位.
+   struct LazyField {
+      FixTag   Tag_;
+      /// 相同 LazyHash_ bucket 的下一個欄位在 LazyFields_ 的位置 + 1, 0 表示沒有下一個.
+      uint32_t Next_;
+      FixValue Value_;
+   };
+   using LazyFields = std::vector<LazyField>;
+   LazyFields  LazyFields_;
+   /// 在 IndexFields() 建立的 tag hash 索引(依照出現順序串接), 讓 MaterializeField() 不用掃描全部的欄位.
+   /// LazyHead_[bucket] = 第一個欄位在 LazyFields_ 的位置 + 1; LazyTail_[bucket] 僅在 LazyHead_[bucket] != 0 時有效.
+   enum : uint32_t {
+      kLazyHashBits = 7,
+      kLazyHashSize = (1u << kLazyHashBits),
+   };
+   static uint32_t LazyHash(FixTag tag) {
+      return (tag ^ (tag >> kLazyHashBits)) & (kLazyHashSize - 1);
+   }
+   uint32_t    LazyHead_[kLazyHashSize] = {0};
+   uint32_t    LazyTail_[kLazyHashSize];
+   bool        IsLazyParse_{false};
+   char        Padding___[7];
+
+   void ClearLazyFields();
+
+   /// 取得 fld 下一個 value 的存放位置, 若重複次數太多, 則返回 nullptr;
+   StrView* AllocValue(FixField& fld);
+   /// lazy 模式: 建立欄位索引.
+   Result IndexFields(StrView& fixmsg);
+   const FixField* MaterializeField(FixTag tag);
 };
 fon9_ENABLE_ENUM_BITWISE_OP(FixParser::Until);
 fon9_ENABLE_ENUM_BITWISE_OP(FixParser::VerifyItem);
@@ -4,6 +4,7 @@
 #include "fon9/TestTools.hpp"
 #include "fon9/fix/FixParser.hpp"
 #include "fon9/fix/FixBuilder.hpp"
+#include "fon9/fix/FixApDef.hpp"
 #include "fon9/Timer.hpp"
 
 namespace f9fix = fon9::fix;
@@ -42,6 +43,17 @@ f9fix::FixParser::Result TestFixParser(const char* testName,
          << "\r" "[ERROR]" << std::endl;
       abort();
    }
+   if (fixpr.IsLazyParse()) {
+      // lazy: 先用 GetField() 取得欄位(此時才建立 FixField), 然後再建立全部欄位, 檢查順序.
+      for (size_t L = 0; L < valueCount; ++L) {
+         const f9fix::FixParser::FixField* fld = fixpr.GetField(values[L].Tag_);
+         if (fld == nullptr || values[L].Value_ != fixpr.GetValue(*fld, values[L].Index_)) {
+            std::cout << "lazy GetField() error|index=" << L << "|tag=" << values[L].Tag_ << std::endl;
+            abort();
+         }
+      }
+      fixpr.MaterializeAll();
+   }
    if (fixpr.count() != valueCount) {
       std::cout << "field count error|expect=" << valueCount << "|result=" << fixpr.count() << std::endl;
       abort();
@@ -78,8 +90,10 @@ f9fix::FixParser::Result TestFixParser(const char* testName,
    return res;
 }
 
-int main(int argc, char** args) {
-   (void)argc; (void)args;
+void TestFixParserCases(bool isLazy);
+void BenchParseCaseFile(const char* fname);
+
+int main(int argc, char** argv) {
 
 #if defined(_MSC_VER) && defined(_DEBUG)
    _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
@@ -89,7 +103,17 @@ int main(int argc, char** args) {
    fon9::GetDefaultTimerThread();
    std::this_thread::sleep_for(std::chrono::milliseconds{10});
 
+   TestFixParserCases(false);
+   utinfo.PrintSplitter();
+   TestFixParserCases(true);
+   utinfo.PrintSplitter();
+   BenchParseCaseFile(argc > 1 ? argv[1] : nullptr);
+}
+//--------------------------------------------------------------------------//
+void TestFixParserCases(bool isLazy) {
+   std::cout << "LazyParse=" << (isLazy ? "Y" : "N") << std::endl;
    f9fix::FixParser   fixpr;
+   fixpr.SetLazyParse(isLazy);
    #define _   f9fix_kCSTR_SPL
 
    // 一般訊息.
@@ -140,7 +164,8 @@ int main(int argc, char** args) {
    // Test: 超過可重複次數.
    fixmsg = fon9::StrView{"8=FIX.4.4" _ "9=95" _ "35=A" _ "49=Client" _ "56=Server" _ "34=6" _ "52=20170426-08:49:28" _ "108=3000" _ "98=0" _
                           "99=A" _ "99=B" _ "99=C" _ "99=D" _ "99=E" _ "99=F" _ "10=059" _};
-   if (fixpr.Parse(fixmsg) != f9fix::FixParser::EDupField) {
+   // lazy 模式不檢查 EDupField.
+   if (!isLazy && fixpr.Parse(fixmsg) != f9fix::FixParser::EDupField) {
       std::cout << "Unexpected EDupField." << std::endl;
       abort();
    }
@@ -153,4 +178,85 @@ int main(int argc, char** args) {
                  "98=0" _ "98=1" _ "98=2" _ "98=3" _ "98=4" _
                  "99=A" _ "99=B" _ "99=C" _ "99=D" _ "99=E" _ "10=240" _,
                  vs7, fon9::numofele(vs7));
+
+   // Test: tag 數值溢位, 不可 wrap 成為其他 tag.
+   if (isLazy) {
+      const std::string body{"35=A" _ "49=Client" _ "56=Server" _ "34=8" _ "4294967297=X" _};
+      std::string msg = "8=FIX.4.4" _ "9=" + std::to_string(body.size()) + _ + body;
+      unsigned    cks = 0;
+      for (char ch : msg)
+         cks += static_cast<unsigned char>(ch);
+      char strCks[8];
+      sprintf(strCks, "10=%03u" _, cks % 256);
+      msg.append(strCks);
+      fixmsg = fon9::StrView{&msg};
+      if (fixpr.Parse(fixmsg) != f9fix::FixParser::EFormat || !fixmsg.begin() || memcmp(fixmsg.begin(), "4294967297=", 11) != 0) {
+         std::cout << "Unexpected tag overflow result." << std::endl;
+         abort();
+      }
+   }
+}
+//--------------------------------------------------------------------------//
+// 使用 FixReceiver_UT_Case.txt 裡面的訊息, 比較一般模式與 lazy 模式的解析速度.
+// 模擬應用層: 解析後只取用少數欄位.
+uint64_t BenchParseMessages(const std::vector<std::string>& msgs, bool isLazy, unsigned times, size_t& chkValue) {
+   f9fix::FixParser fixpr;
+   fixpr.SetLazyParse(isLazy);
+   fon9::StopWatch stopWatch;
+   uint64_t        okCount = 0;
+   for (unsigned L = 0; L < times; ++L) {
+      for (const std::string& msg : msgs) {
+         fon9::StrView fixmsg{&msg};
+         if (fixpr.Parse(fixmsg) > f9fix::FixParser::NeedsMore) {
+            ++okCount;
+            if (const f9fix::FixParser::FixField* fld = fixpr.GetField(f9fix_kTAG_MsgType))
+               chkValue += fld->Value_.size();
+            if (const f9fix::FixParser::FixField* fld = fixpr.GetField(f9fix_kTAG_ClOrdID))
+               chkValue += fld->Value_.size();
+            if (const f9fix::FixParser::FixField* fld = fixpr.GetField(f9fix_kTAG_OrderQty))
+               chkValue += fld->Value_.size();
+         }
+         fixpr.Clear();
+      }
+   }
+   const double span = stopWatch.StopTimer();
+   const uint64_t msgCount = static_cast<uint64_t>(times) * msgs.size();
+   stopWatch.PrintResultNoEOL(span, isLazy ? "Parse(Lazy)" : "Parse     ", msgCount)
+      << "|msgs/sec=" << static_cast<uint64_t>(static_cast<double>(msgCount) / span)
+      << "|ok=" << okCount << std::endl;
+   return okCount;
+}
+void BenchParseCaseFile(const char* fname) {
+   std::string defaultName;
+   if (fname == nullptr) {
+      // 預設使用與此原始檔相同路徑的 FixReceiver_UT_Case.txt
+      defaultName = __FILE__;
+      defaultName.erase(defaultName.find_last_of("/\\") + 1);
+      defaultName.append("FixReceiver_UT_Case.txt");
+      fname = defaultName.c_str();
+   }
+   FILE* fd = fopen(fname, "rt");
+   if (fd == nullptr) {
+      std::cout << "[SKIP ] Bench parse|fileName=" << fname << "|err=open file fail." << std::endl;
+      return;
+   }
+   std::vector<std::string> msgs;
+   char strbuf[1024 * 4];
+   while (fgets(strbuf, sizeof(strbuf), fd)) {
+      if (strbuf[0] != '8' || strbuf[1] != '=')
+         continue;
+      std::string msg{strbuf};
+      while (!msg.empty() && (msg.back() == '\n' || msg.back() == '\r'))
+         msg.pop_back();
+      msgs.push_back(std::move(msg));
+   }
+   fclose(fd);
+   std::cout << "Bench parse|fileName=" << fname << "|msgs=" << msgs.size() << std::endl;
+   const unsigned kTimes = 1000 * 10;
+   size_t chkValue = 0, chkLazy = 0;
+   const uint64_t okCount = BenchParseMessages(msgs, false, kTimes, chkValue);
+   if (BenchParseMessages(msgs, true, kTimes, chkLazy) != okCount || chkValue != chkLazy) {
+      std::cout << "[ERROR] Lazy parse result not match." << std::endl;
+      abort();
+   }
 }
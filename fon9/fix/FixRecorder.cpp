@@ -1,58 +1,132 @@
 ﻿// \file fon9/fix/FixRecorder.cpp
 // \author fonwinz@gmail.com
 #include "fon9/fix/FixRecorder_Searcher.hpp"
+#include "fon9/fix/FixRecorder_SeqIndex.hpp"
 
 namespace fon9 { namespace fix {
 
+FixRecorder::FixRecorder(const StrView& beginHeader, CompIDs&& compIDs)
+   : BeginHeader_{beginHeader}
+   , CompIDs_(std::move(compIDs)) {
+}
 FixRecorder::~FixRecorder() {
    this->DisposeAsync();
    RevBufferList rbuf{256 + sizeof(NumOutBuf)};
    RevPrint(rbuf, f9fix_kCSTR_HdrInfo, UtcNow(), " f9fix.FixRecorder dtor.\n\n"); // 尾端多一個換行,可以比較容易區分重啟.
-   auto lk{this->Worker_.Lock()};
-   WorkContentController* app = static_cast<WorkContentController*>(&WorkContentController::StaticCast(*lk));
-   app->AddWork(std::move(lk), rbuf.MoveOut());
-   this->Worker_.TakeCallLocked(std::move(lk));
+   BufferList wbuf{rbuf.MoveOut()};
+   const auto wsz = CalcDataSize(wbuf.cfront());
+   this->AddWorkIndexed(this->Worker_.Lock(), std::move(wbuf), wsz, 0, false);
+   this->Worker_.TakeCall();
 }
 
 File::Result FixRecorder::Initialize(std::string fileName, FileMode fileMode) {
    if (this->GetStorage().IsOpened())
       return File::Result{std::errc::text_file_busy};
+   std::string idxFileName = fileName + ".sidx";
    auto res = this->OpenImmediately(std::move(fileName), fileMode | FileMode::Read);
    if (!res)
       return res;
-   FixParser fixParser;
-   fixParser.ResetExpectHeader(ToStrView(this->BeginHeader_));
-   LastSeqSearcher   seqSearcher{fixParser};
-   File&             file = this->GetStorage();
-   res = seqSearcher.Start(file);
-   if (!res)
+   File& file = this->GetStorage();
+   if (!(res = file.GetFileSize())) {
       file.Close();
+      return res;
+   }
+   const PosType  logFileSize = res.GetResult();
+   std::unique_ptr<SeqIndex> seqIndex{new SeqIndex{}};
+   if (!(res = seqIndex->Open(idxFileName, fileMode))) {
+      file.Close();
+      return res;
+   }
+   SeqIndex::Rec  lastRec;
+   bool           isIndexed = seqIndex->CheckLast(logFileSize, lastRec);
+   if (!isIndexed && seqIndex->IsStale(logFileSize)) {
+      // 記錄檔已被移除或截短: 舊的索引已無用, 清空後重建, 避免索引檔無限增長.
+      seqIndex.reset(new SeqIndex{});
+      if (!(res = seqIndex->Open(std::move(idxFileName), fileMode | FileMode::Trunc))) {
+         file.Close();
+         return res;
+      }
+      isIndexed = seqIndex->CheckLast(logFileSize, lastRec);
+   }
+   if (isIndexed) {
+      this->NextSendSeq_ = lastRec.NextSendSeq_;
+      this->NextRecvSeq_ = lastRec.NextRecvSeq_;
+   }
    else {
-      if ((this->NextSendSeq_ = seqSearcher.NextSendSeq_) == 0)
-         this->NextSendSeq_ = 1;
-      if ((this->NextRecvSeq_ = seqSearcher.NextRecvSeq_) == 0)
-         this->NextRecvSeq_ = 1;
-      this->IdxInfoSizeInterval_ = 0;
-      this->Write(f9fix_kCSTR_HdrInfo,
-                  "f9fix.FixRecorder Initialized"
-                  "|NextSendSeq=", this->NextSendSeq_,
-                  "|NextRecvSeq=", this->NextRecvSeq_);
+      FixParser fixParser;
+      fixParser.ResetExpectHeader(ToStrView(this->BeginHeader_));
+      LastSeqSearcher seqSearcher{fixParser};
+      if (!(res = seqSearcher.Start(file))) {
+         file.Close();
+         return res;
+      }
+      this->NextSendSeq_ = seqSearcher.NextSendSeq_;
+      this->NextRecvSeq_ = seqSearcher.NextRecvSeq_;
    }
+   if (this->NextSendSeq_ == 0)
+      this->NextSendSeq_ = 1;
+   if (this->NextRecvSeq_ == 0)
+      this->NextRecvSeq_ = 1;
+   this->WritePos_ = logFileSize;
+   if (!isIndexed)
+      seqIndex->Rebase(logFileSize, this->NextSendSeq_, this->NextRecvSeq_);
+   this->SeqIndex_ = std::move(seqIndex);
+   this->IdxInfoSizeInterval_ = 0;
+   this->Write(f9fix_kCSTR_HdrInfo,
+               "f9fix.FixRecorder Initialized"
+               "|NextSendSeq=", this->NextSendSeq_,
+               "|NextRecvSeq=", this->NextRecvSeq_,
+               "|SeqIndex=", isIndexed ? StrView{"Y"} : StrView{"Rebase"});
    return res;
 }
 
-void FixRecorder::WriteBuffer(Locker&& lk, RevBufferList&& rbuf) {
+void FixRecorder::AddWorkIndexed(WorkContentLocker&& lk, BufferList&& wbuf, size_t wsz, FixSeqNum sentSeq, bool isSendSeqReset) {
+   if (fon9_LIKELY(this->SeqIndex_)) {
+      SeqIndex::Rec rec;
+      rec.Pos_ = this->WritePos_;
+      rec.Size_ = static_cast<uint32_t>(wsz);
+      rec.SentSeq_ = sentSeq;
+      rec.NextSendSeq_ = this->NextSendSeq_;
+      rec.NextRecvSeq_ = this->NextRecvSeq_;
+      rec.Flags_ = (isSendSeqReset ? SeqIndex::FlagSendSeqReset : 0u);
+      this->SeqIndex_->Append(rec);
+   }
+   this->WritePos_ += wsz;
+   WorkContentController* app = static_cast<WorkContentController*>(&WorkContentController::StaticCast(*lk));
+   app->AddWork(std::move(lk), std::move(wbuf));
+}
+static BufferList MoveOutWithIdxInfo(RevBufferList&& rbuf, size_t& wsz, size_t& idxInfoSizeInterval,
+                                     FixSeqNum nextSendSeq, FixSeqNum nextRecvSeq) {
    BufferList wbuf = rbuf.MoveOut();
-   if (fon9_UNLIKELY((this->IdxInfoSizeInterval_ += CalcDataSize(wbuf.cfront())) > kIdxInfoSizeInterval)) {
-      this->IdxInfoSizeInterval_ = 0;
+   wsz = CalcDataSize(wbuf.cfront());
+   if (fon9_UNLIKELY((idxInfoSizeInterval += wsz) > FixRecorder::kIdxInfoSizeInterval)) {
+      idxInfoSizeInterval = 0;
       RevPrint(rbuf, f9fix_kCSTR_HdrIdx
-               f9fix_kCSTR_HdrNextSendSeq, this->NextSendSeq_,
-               f9fix_kCSTR_HdrNextRecvSeq, this->NextRecvSeq_,
+               f9fix_kCSTR_HdrNextSendSeq, nextSendSeq,
+               f9fix_kCSTR_HdrNextRecvSeq, nextRecvSeq,
                '\n');
-      wbuf.push_back(rbuf.MoveOut());
+      BufferList idxbuf = rbuf.MoveOut();
+      wsz += CalcDataSize(idxbuf.cfront());
+      wbuf.push_back(std::move(idxbuf));
    }
-   WorkContentController* app = static_cast<WorkContentController*>(&WorkContentController::StaticCast(*lk));
-   app->AddWork(std::move(lk), std::move(wbuf));
+   return wbuf;
+}
+void FixRecorder::WriteBuffer(Locker&& lk, RevBufferList&& rbuf) {
+   size_t     wsz;
+   BufferList wbuf = MoveOutWithIdxInfo(std::move(rbuf), wsz, this->IdxInfoSizeInterval_, this->NextSendSeq_, this->NextRecvSeq_);
+   this->AddWorkIndexed(std::move(lk), std::move(wbuf), wsz, 0, false);
+}
+void FixRecorder::WriteAfterSend(Locker&& lk, RevBufferList&& lineMessage, FixSeqNum nextSendSeq) {
+   // 送出的訊息序號, 必定為 GetNextSendSeq(): 請參考 FixSender::Send();
+   // 若沒有 "S timestamp FIX Message" 則為 FixSender::ResetNextSendSeq();
+   const BufferNode* front = lineMessage.cfront();
+   const FixSeqNum   sentSeq = (front && front->GetDataSize() > 0 && *front->GetDataBegin() == f9fix_kCSTR_HdrSend[0])
+                               ? this->NextSendSeq_ : 0;
+   const bool        isSendSeqReset = (sentSeq == 0 || nextSendSeq != sentSeq + 1);
+   this->NextSendSeq_ = nextSendSeq;
+   size_t     wsz;
+   BufferList wbuf = MoveOutWithIdxInfo(std::move(lineMessage), wsz, this->IdxInfoSizeInterval_, this->NextSendSeq_, this->NextRecvSeq_);
+   this->AddWorkIndexed(std::move(lk), std::move(wbuf), wsz, sentSeq, isSendSeqReset);
 }
 void FixRecorder::WriteInputSeqReset(const StrView& fixmsg, FixSeqNum newSeqNo, bool isGapFill) {
    RevBufferList rbuf{static_cast<BufferNodeSize>(fixmsg.size() + 64)};
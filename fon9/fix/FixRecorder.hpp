@@ -38,17 +38,35 @@ fon9_WARN_DISABLE_PADDING;
 ///               FIX 有 Sequence Reset 機制, 當發生此情況時, 必定會跟隨一個 RST 訊息.
 ///        其他 = 額外資訊, 參考 f9fix_kCSTR_Hdr*
 ///   \endcode
+/// - 另有序號索引檔: 記錄檔名 + ".sidx", 每次寫入記錄檔時附加一筆索引,
+///   讓啟動時取得序號、回補時尋找送出的訊息, 不用從記錄檔尾端往前掃描.
+///   請參考 fon9/fix/FixRecorder_SeqIndex.hpp
 class fon9_API FixRecorder : protected AsyncFileAppender {
    fon9_NON_COPY_NON_MOVE(FixRecorder);
    using base = AsyncFileAppender;
    FixSeqNum   NextSendSeq_{0};
    FixSeqNum   NextRecvSeq_{0};
    size_t      IdxInfoSizeInterval_;
-   
+   /// 下一次寫入在記錄檔的位置.
+   File::PosType  WritePos_{0};
+
    struct FixRevSercher;
    struct LastSeqSearcher;
    struct SentMessageSearcher;
+   struct SeqIndex;
+   std::unique_ptr<SeqIndex> SeqIndex_;
+   enum class SeqIndexFindResult {
+      Found,
+      /// 最後一次重設送出序號之後, 沒有 >= seqFrom 的訊息.
+      NotFound,
+      /// 索引不包含 seqFrom, 必須使用 SentMessageSearcher 尋找.
+      Unknown,
+   };
    friend intrusive_ptr<FixRecorder>;
+
+   /// 寫入 wbuf(資料量=wsz), 並在序號索引檔附加一筆記錄.
+   /// sentSeq: 若 wbuf 為送出的訊息("S timestamp FIX Message\n"...), 則為該訊息的序號, 否則為 0.
+   void AddWorkIndexed(WorkContentLocker&& lk, BufferList&& wbuf, size_t wsz, FixSeqNum sentSeq, bool isSendSeqReset);
 public:
    using Locker = base::WorkContentLocker;
 
@@ -70,10 +88,7 @@ public:
       kIdxInfoSizeInterval = kReloadSentBufferSize - 1024 * 2,
    };
 
-   FixRecorder(const StrView& beginHeader, CompIDs&& compIDs)
-      : BeginHeader_{beginHeader}
-      , CompIDs_(std::move(compIDs)) {
-   }
+   FixRecorder(const StrView& beginHeader, CompIDs&& compIDs);
    virtual ~FixRecorder();
 
    using base::WaitFlushed;
@@ -126,10 +141,7 @@ public:
    /// lineMessage 必須為一行完整的訊息: "S " + timestamp + ' ' + FIX Message + '\n';
    /// 請參考 FixSender::Send()
    /// 返回前 lk 可能已被解鎖!
-   void WriteAfterSend(Locker&& lk, RevBufferList&& lineMessage, FixSeqNum nextSendSeq) {
-      this->NextSendSeq_ = nextSendSeq;
-      this->WriteBuffer(std::move(lk), std::move(lineMessage));
-   }
+   void WriteAfterSend(Locker&& lk, RevBufferList&& lineMessage, FixSeqNum nextSendSeq);
 
    /// 寫入依正常順序收到的 FIX Message.
    /// 返回前 ++this->NextRecvSeq_;
@@ -146,9 +158,9 @@ public:
    /// 寫入 buf, 前後都不加料.
    /// 返回前 lk 可能已被解鎖!
    void Append(Locker&& lk, BufferList&& buf) {
-      this->IdxInfoSizeInterval_ += CalcDataSize(buf.cfront());
-      WorkContentController* app = static_cast<WorkContentController*>(&WorkContentController::StaticCast(*lk));
-      app->AddWork(std::move(lk), std::move(buf));
+      const size_t sz = CalcDataSize(buf.cfront());
+      this->IdxInfoSizeInterval_ += sz;
+      this->AddWorkIndexed(std::move(lk), std::move(buf), sz, 0, false);
    }
 
    using PosType = File::PosType;
@@ -161,6 +173,9 @@ public:
       const char* FoundDataEnd_;
       friend struct SentMessageSearcher;
       bool InitStart(FixRecorder& fixRecorder, FixSeqNum seqFrom);
+      /// 使用 fixRecorder.SeqIndex_ 尋找, 若找到則載入該筆訊息, 並設定 CurMsg_.
+      /// isExactSeq = true: 訊息序號必須 == seqFrom.
+      SeqIndexFindResult FindByIndex(FixRecorder& fixRecorder, FixSeqNum seqFrom, bool isExactSeq);
 
    public:
       FixParser  FixParser_;
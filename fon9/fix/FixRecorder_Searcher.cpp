@@ -1,6 +1,7 @@
 ﻿// \file fon9/fix/FixRecorder_Searcher.cpp
 // \author fonwinz@gmail.com
 #include "fon9/fix/FixRecorder_Searcher.hpp"
+#include "fon9/fix/FixRecorder_SeqIndex.hpp"
 
 namespace fon9 { namespace fix {
 
@@ -12,6 +13,8 @@ namespace fon9 { namespace fix {
 //   - ~FixRecorder() 關檔前.
 // - 每次從尾端往前讀取 n KB, 然後用 memrchr() 尋找 f9fix_kCHAR_HdrCtrlMsgSeqNum.
 //   - 直到找到所需的序號為止
+// - 若有序號索引檔(FixRecorder::SeqIndex), 則優先使用索引檔直接定位,
+//   索引檔無法確定時(例: 要找的訊息在 FlagRebase 之前), 才從檔案尾端往前尋找.
 
 //--------------------------------------------------------------------------//
 // pbeg = 一行的開頭.
@@ -203,9 +206,45 @@ bool FixRecorder::ReloadSent::InitStart(FixRecorder& fixRecorder, FixSeqNum seqF
    fixRecorder.WaitFlushed();
    return true;
 }
+FixRecorder::SeqIndexFindResult FixRecorder::ReloadSent::FindByIndex(FixRecorder& fixRecorder, FixSeqNum seqFrom, bool isExactSeq) {
+   SeqIndex::Rec  rec;
+   auto           fres = fixRecorder.SeqIndex_->FindSent(fixRecorder, seqFrom, rec);
+   if (fres != SeqIndex::FindResult::Found)
+      return fres;
+   if (isExactSeq && rec.SentSeq_ != seqFrom)
+      return SeqIndex::FindResult::NotFound;
+   // 從記錄檔載入 rec.Pos_ 開始的資料, 第一行必定為 "S timestamp FIX Message".
+   File::Result res = fixRecorder.GetStorage().Read(rec.Pos_, this->Buffer_, kReloadSentBufferSize);
+   if (!res)
+      return SeqIndex::FindResult::Unknown;
+   const char* const pend = this->Buffer_ + res.GetResult();
+   const char*       pbeg = this->Buffer_;
+   const char* const lnEnd = reinterpret_cast<const char*>(memchr(pbeg, '\n', res.GetResult()));
+   if (lnEnd == nullptr || *pbeg != f9fix_kCSTR_HdrSend[0] || (pbeg = SkipTimestamp(pbeg, lnEnd)) == nullptr)
+      return SeqIndex::FindResult::Unknown;
+   StrView fixmsg{pbeg, lnEnd};
+   this->FixParser_.Clear();
+   this->FixParser_.ParseFields(fixmsg, FixParser::Until::MsgSeqNum);
+   if (this->FixParser_.GetMsgSeqNum() != rec.SentSeq_)
+      return SeqIndex::FindResult::Unknown;
+   this->CurBufferPos_ = rec.Pos_;
+   this->FoundDataEnd_ = pend;
+   this->CurMsg_.Reset(pbeg, lnEnd);
+   return SeqIndex::FindResult::Found;
+}
 StrView FixRecorder::ReloadSent::Find(FixRecorder& fixRecorder, FixSeqNum seq) {
    if (!this->InitStart(fixRecorder, seq))
       return StrView{};
+   if (fixRecorder.SeqIndex_) {
+      switch (this->FindByIndex(fixRecorder, seq, true)) {
+      case SeqIndex::FindResult::Found:
+         return this->CurMsg_;
+      case SeqIndex::FindResult::NotFound:
+         return this->CurMsg_ = nullptr;
+      case SeqIndex::FindResult::Unknown:
+         break;
+      }
+   }
    SentMessageSearcher  searcher{*this};
    File::Result         res = searcher.Start(*this, seq, fixRecorder.GetStorage());
    if (fon9_LIKELY(res && !searcher.FoundLine_.empty())) {
@@ -217,6 +256,22 @@ StrView FixRecorder::ReloadSent::Find(FixRecorder& fixRecorder, FixSeqNum seq) {
 StrView FixRecorder::ReloadSent::Start(FixRecorder& fixRecorder, FixSeqNum seqFrom) {
    if (!this->InitStart(fixRecorder, seqFrom))
       return StrView{};
+   if (fixRecorder.SeqIndex_) {
+      switch (this->FindByIndex(fixRecorder, seqFrom, false)) {
+      case SeqIndex::FindResult::Found:
+         fixRecorder.Write(f9fix_kCSTR_HdrInfo,
+                           "ReloadSent:"
+                           "|seq=", seqFrom,
+                           "|idxFoundAt=", this->CurBufferPos_,
+                           "|foundSeq=", this->FixParser_.GetMsgSeqNum());
+         return this->CurMsg_;
+      case SeqIndex::FindResult::NotFound:
+         return this->CurMsg_ = nullptr;
+      case SeqIndex::FindResult::Unknown:
+         this->CurMsg_.Reset(nullptr);
+         break;
+      }
+   }
    SentMessageSearcher  searcher{*this};
    File::Result         res = searcher.Start(*this, seqFrom, fixRecorder.GetStorage());
    if (!res)
@@ -0,0 +1,160 @@
+﻿// \file fon9/fix/FixRecorder_SeqIndex.cpp
+// \author fonwinz@gmail.com
+#include "fon9/fix/FixRecorder_SeqIndex.hpp"
+#include "fon9/Endian.hpp"
+
+namespace fon9 { namespace fix {
+
+void FixRecorder::SeqIndex::PutRec(byte* pout, const Rec& rec) {
+   PutBigEndian(pout, static_cast<uint64_t>(rec.Pos_));
+   PutBigEndian(pout + 8, rec.Size_);
+   PutBigEndian(pout + 12, rec.SentSeq_);
+   PutBigEndian(pout + 16, rec.NextSendSeq_);
+   PutBigEndian(pout + 20, rec.NextRecvSeq_);
+   PutBigEndian(pout + 24, rec.Flags_);
+   PutBigEndian(pout + 28, static_cast<uint32_t>(0));
+}
+void FixRecorder::SeqIndex::GetRec(const byte* pbuf, Rec& rec) {
+   rec.Pos_ = static_cast<File::PosType>(GetBigEndian<uint64_t>(pbuf));
+   rec.Size_ = GetBigEndian<uint32_t>(pbuf + 8);
+   rec.SentSeq_ = GetBigEndian<FixSeqNum>(pbuf + 12);
+   rec.NextSendSeq_ = GetBigEndian<FixSeqNum>(pbuf + 16);
+   rec.NextRecvSeq_ = GetBigEndian<FixSeqNum>(pbuf + 20);
+   rec.Flags_ = GetBigEndian<uint32_t>(pbuf + 24);
+}
+//--------------------------------------------------------------------------//
+FixRecorder::SeqIndex::~SeqIndex() {
+   this->Map_.Close();
+   if (this->Appender_)
+      this->Appender_->Close();
+}
+File::Result FixRecorder::SeqIndex::Open(std::string fname, FileMode fmode) {
+   this->Appender_ = AsyncFileAppender::Make();
+   auto res = this->Appender_->OpenImmediately(fname, fmode | FileMode::Read);
+   if (!res)
+      return res;
+   if (!(res = this->Appender_->GetFileSize()))
+      return res;
+   this->RecCount_ = this->RecCountAtOpen_ = res.GetResult() / kRecSize;
+   this->PartialSize_ = static_cast<size_t>(res.GetResult() % kRecSize);
+   // 若不支援 mmap, 則使用 File::Read() 讀取.
+   this->Map_.Open(std::move(fname));
+   return res;
+}
+bool FixRecorder::SeqIndex::ReadRec(RecNo recNo, Rec& rec) {
+   File::SizeType sz;
+   if (const byte* pbuf = this->Map_.Peek(recNo * kRecSize, sz)) {
+      GetRec(pbuf, rec);
+      return true;
+   }
+   byte buf[kRecSize];
+   auto res = this->Appender_->Read(recNo * kRecSize, buf, kRecSize);
+   if (!res || res.GetResult() != kRecSize)
+      return false;
+   GetRec(buf, rec);
+   return true;
+}
+bool FixRecorder::SeqIndex::CheckLast(PosType logFileSize, Rec& rec) {
+   if (this->PartialSize_ != 0)
+      return false;
+   if (this->RecCount_ == 0) {
+      memset(&rec, 0, sizeof(rec));
+      return logFileSize == 0;
+   }
+   return this->ReadRec(this->RecCount_ - 1, rec)
+      && rec.Pos_ + rec.Size_ == logFileSize;
+}
+bool FixRecorder::SeqIndex::IsStale(PosType logFileSize) {
+   if (this->RecCount_ == 0)
+      return false;
+   Rec rec;
+   return !this->ReadRec(this->RecCount_ - 1, rec)
+      || rec.Pos_ + rec.Size_ > logFileSize;
+}
+void FixRecorder::SeqIndex::Rebase(PosType pos, FixSeqNum nextSendSeq, FixSeqNum nextRecvSeq) {
+   if (this->PartialSize_ != 0) {
+      // 補齊尾端不完整的記錄, 讓之後的記錄可以對齊.
+      const byte zeros[kRecSize] = {0};
+      this->Appender_->Append(zeros, kRecSize - this->PartialSize_);
+      this->PartialSize_ = 0;
+      ++this->RecCount_;
+   }
+   Rec rec;
+   rec.Pos_ = pos;
+   rec.Size_ = 0;
+   rec.SentSeq_ = 0;
+   rec.NextSendSeq_ = nextSendSeq;
+   rec.NextRecvSeq_ = nextRecvSeq;
+   rec.Flags_ = FlagRebase;
+   this->Append(rec);
+}
+void FixRecorder::SeqIndex::Append(const Rec& rec) {
+   byte buf[kRecSize];
+   PutRec(buf, rec);
+   this->Appender_->Append(buf, kRecSize);
+   if (rec.Flags_ & FlagRebase)
+      this->SendSegBegin_ = this->RecCount_;
+   else if (rec.Flags_ & FlagSendSeqReset)
+      this->SendSegBegin_ = this->RecCount_ + 1;
+   ++this->RecCount_;
+}
+FixRecorder::SeqIndex::RecNo FixRecorder::SeqIndex::FindSendSegBegin() {
+   // 開檔後, 尚未有 FlagRebase 或 FlagSendSeqReset 的記錄,
+   // 所以僅需從開檔時的記錄(必定已寫入索引檔)往前找.
+   Rec rec;
+   for (RecNo recNo = this->RecCountAtOpen_; recNo > 0;) {
+      if (!this->ReadRec(--recNo, rec))
+         break;
+      if (rec.Flags_ & FlagRebase)
+         return recNo;
+      if (rec.Flags_ & FlagSendSeqReset)
+         return recNo + 1;
+   }
+   return 0;
+}
+FixRecorder::SeqIndex::FindResult FixRecorder::SeqIndex::FindSent(FixRecorder& owner, FixSeqNum seqFrom, Rec& rec) {
+   // 不可在 owner 鎖定時等候索引檔寫入(或讀取索引檔),
+   // 因為 owner 的寫檔工作, 可能與索引檔的寫檔工作, 在同一個 thread pool 排隊.
+   RecNo segBegin, recEnd;
+   {
+      auto lk{owner.Lock()};
+      segBegin = this->SendSegBegin_;
+      recEnd = this->RecCount_;
+   }
+   if (segBegin == kUnknownRecNo) {
+      // 此時 [RecCountAtOpen_, recEnd) 之間, 必定沒有 FlagRebase 或 FlagSendSeqReset;
+      segBegin = this->FindSendSegBegin();
+      auto lk{owner.Lock()};
+      if (this->SendSegBegin_ == kUnknownRecNo)
+         this->SendSegBegin_ = segBegin;
+   }
+   this->Appender_->WaitFlushed();
+   // 在 [segBegin, recEnd) 之間, NextSendSeq_ 必定不會遞減:
+   // 二元搜尋第一筆 NextSendSeq_ > seqFrom 的記錄, 也就是送出 seqFrom(或之後最接近的)訊息的記錄.
+   RecNo lo = segBegin, hi = recEnd;
+   while (lo < hi) {
+      const RecNo mid = lo + (hi - lo) / 2;
+      if (!this->ReadRec(mid, rec))
+         return FindResult::Unknown;
+      if (rec.NextSendSeq_ > seqFrom)
+         hi = mid;
+      else
+         lo = mid + 1;
+   }
+   if (lo >= recEnd)
+      return FindResult::NotFound;
+   if (!this->ReadRec(lo, rec))
+      return FindResult::Unknown;
+   if (lo == segBegin && (rec.Flags_ & FlagRebase))
+      return FindResult::Unknown;
+   for (;;) {
+      if (rec.SentSeq_ >= seqFrom)
+         return FindResult::Found;
+      if (++lo >= recEnd)
+         return FindResult::NotFound;
+      if (!this->ReadRec(lo, rec))
+         return FindResult::Unknown;
+   }
+}
+
+} } // namespaces
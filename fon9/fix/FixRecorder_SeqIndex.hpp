@@ -0,0 +1,90 @@
+﻿// \file fon9/fix/FixRecorder_SeqIndex.hpp
+// \author fonwinz@gmail.com
+#ifndef __fon9_fix_FixRecorder_SeqIndex_hpp__
+#define __fon9_fix_FixRecorder_SeqIndex_hpp__
+#include "fon9/fix/FixRecorder.hpp"
+#include "fon9/FileMap.hpp"
+
+namespace fon9 { namespace fix {
+
+fon9_WARN_DISABLE_PADDING;
+/// FixRecorder 的序號索引檔: FixRecorder 記錄檔名 + ".sidx";
+/// - 每次寫入 FixRecorder 記錄檔, 就附加一筆固定大小(kRecSize)的記錄, 只會附加, 不會修改.
+/// - 可透過 FileMap(mmap) 讀取:
+///   - 啟動時, 只要讀最後一筆記錄, 就能取得 NextSendSeq, NextRecvSeq.
+///   - 回補時, 依照序號二元搜尋, 直接取得送出訊息在記錄檔的位置, 不用從記錄檔尾端往前掃描.
+/// - 記錄內容(BigEndian):
+///   \code
+///   Pos(8) + Size(4) + SentSeq(4) + NextSendSeq(4) + NextRecvSeq(4) + Flags(4) + Reserved(4)
+///   \endcode
+///   - Pos, Size: 此次寫入在記錄檔的位置及資料量.
+///   - SentSeq: 若此次寫入為送出的訊息("S timestamp FIX Message"), 則為該訊息的 MsgSeqNum, 否則為 0.
+///   - NextSendSeq, NextRecvSeq: 寫入後的序號.
+/// - 若索引檔與記錄檔不一致(例: 舊版建立的記錄檔、異常結束), 則啟動時:
+///   - 使用 LastSeqSearcher 從記錄檔尾端往前掃描.
+///   - 然後寫入一筆 FlagRebase 記錄, 在此之前的訊息, 仍使用 SentMessageSearcher 尋找.
+///   - 若索引檔記錄的位置超過記錄檔的大小(記錄檔已被移除或截短), 則捨棄(清空)索引檔.
+struct FixRecorder::SeqIndex {
+   fon9_NON_COPY_NON_MOVE(SeqIndex);
+   enum : uint32_t {
+      /// 從此筆記錄開始, 索引才與記錄檔一致.
+      FlagRebase = 0x01,
+      /// 此次寫入有重設 NextSendSeq(例: "RST|S=n"), 之後的送出序號不一定與之前連續.
+      FlagSendSeqReset = 0x02,
+   };
+   enum : size_t {
+      kRecSize = 32,
+   };
+   static_assert(FileMap::kViewSize % kRecSize == 0, "FileMap::kViewSize must be a multiple of kRecSize.");
+   using RecNo = uint64_t;
+   static constexpr RecNo kUnknownRecNo = static_cast<RecNo>(-1);
+
+   struct Rec {
+      PosType     Pos_;
+      uint32_t    Size_;
+      FixSeqNum   SentSeq_;
+      FixSeqNum   NextSendSeq_;
+      FixSeqNum   NextRecvSeq_;
+      uint32_t    Flags_;
+   };
+
+   SeqIndex() = default;
+   ~SeqIndex();
+
+   File::Result Open(std::string fname, FileMode fmode);
+
+   /// 若索引檔與 logFileSize 一致, 則取出最後一筆記錄, 並返回 true;
+   bool CheckLast(PosType logFileSize, Rec& rec);
+   /// 索引檔記錄的位置超過 logFileSize(例: 記錄檔已被移除或截短), 則此索引檔已無效, 返回 true;
+   bool IsStale(PosType logFileSize);
+   /// 在 CheckLast() 失敗後, 寫入一筆 FlagRebase 記錄.
+   void Rebase(PosType pos, FixSeqNum nextSendSeq, FixSeqNum nextRecvSeq);
+   /// 必須在 FixRecorder 鎖定的情況下呼叫.
+   void Append(const Rec& rec);
+
+   using FindResult = SeqIndexFindResult;
+   /// 尋找最後一次重設送出序號之後, 第一筆 MsgSeqNum >= seqFrom 的送出訊息.
+   FindResult FindSent(FixRecorder& owner, FixSeqNum seqFrom, Rec& rec);
+
+private:
+   AsyncFileAppenderSP  Appender_;
+   FileMap              Map_;
+   /// 包含 Append() 之後尚未寫入索引檔的記錄.
+   RecNo                RecCount_{0};
+   /// 開檔時的記錄數量, 這些記錄必定已在索引檔內.
+   RecNo                RecCountAtOpen_{0};
+   /// 開檔時索引檔尾端不完整記錄的大小.
+   size_t               PartialSize_{0};
+   /// 最後一次重設送出序號(或 FlagRebase)之後的第一筆記錄;
+   /// kUnknownRecNo 表示尚未從索引檔取得, 在第一次 FindSent() 時才尋找.
+   RecNo                SendSegBegin_{kUnknownRecNo};
+
+   static void PutRec(byte* pout, const Rec& rec);
+   static void GetRec(const byte* pbuf, Rec& rec);
+   bool ReadRec(RecNo recNo, Rec& rec);
+   RecNo FindSendSegBegin();
+};
+fon9_WARN_POP;
+
+} } // namespaces
+#endif//__fon9_fix_FixRecorder_SeqIndex_hpp__
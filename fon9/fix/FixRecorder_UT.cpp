@@ -63,6 +63,45 @@ void CheckReloadSent(f9fix::FixRecorder& fixr, f9fix::FixSeqNum seqFrom, f9fix::
       abort();
    }
 }
+void CheckReloadSentAll(f9fix::FixRecorder& fixr, const char* testName, f9fix::FixSeqNum lastSeq) {
+   std::cout << "[TEST ] Reload sent: " << testName;
+   unsigned pers = 0;
+   for (f9fix::FixSeqNum L = 0; L < lastSeq; ++L) {
+      CheckReloadSent(fixr, L + 1, lastSeq - L);
+      unsigned p = static_cast<unsigned>((L + 1) * 100 / lastSeq);
+      if (pers != p) {
+         pers = p;
+         fprintf(stdout, "%3u%%\b\b\b\b", pers);
+         fflush(stdout);
+      }
+   }
+   std::cout << "\r" "[OK   ]" << std::endl;
+}
+void ReopenFixRecorder(f9fix::FixRecorderSP& fixr, const f9fix::CompIDs& compIds, const char* fixrFileName,
+                       f9fix::FixSeqNum expectNextSendSeq, f9fix::FixSeqNum expectNextRecvSeq) {
+   if (fixr)
+      fixr->WaitFlushed();
+   fixr.reset(new f9fix::FixRecorder(f9fix_BEGIN_HEADER_V42, f9fix::CompIDs{compIds}));
+   fon9::File::Result res;
+   int count = 100;
+   while (!(res = fixr->Initialize(fixrFileName))) {
+      if (--count <= 0) {
+         std::cout << "Reopen FixRecorder|fileName=" << fixrFileName
+            << "|err=" << fon9::RevPrintTo<std::string>(res) << std::endl;
+         abort();
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+   }
+   if (fixr->GetNextRecvSeq() != expectNextRecvSeq || fixr->GetNextSendSeq(fixr->Lock()) != expectNextSendSeq) {
+      std::cout << "Reopen FixRecorder|fileName=" << fixrFileName
+         << "|err=Unexpected NextSeq|expectNextRecvSeq=" << expectNextRecvSeq
+         << "|nextRecvSeq=" << fixr->GetNextRecvSeq()
+         << "|expectNextSendSeq=" << expectNextSendSeq
+         << "|nextSendSeq=" << fixr->GetNextSendSeq(fixr->Lock())
+         << std::endl;
+      abort();
+   }
+}
 //--------------------------------------------------------------------------//
 
 int main(int argc, char** argv) {
@@ -78,7 +117,9 @@ int main(int argc, char** argv) {
    f9fix::CompIDs       compIds{"SenderCoId", "SenderSubId", "TargetCoId", "TargetSubId"};
    f9fix::FixRecorderSP fixr{new f9fix::FixRecorder(f9fix_BEGIN_HEADER_V42, f9fix::CompIDs{compIds})};
    const char           fixrFileName[] = "FixRecorder_UT.log";
+   const char           fixrIdxFileName[] = "FixRecorder_UT.log.sidx";
    remove(fixrFileName);
+   remove(fixrIdxFileName);
    auto res = fixr->Initialize(fixrFileName);
    if (!res) {
       std::cout << "Open FixRecorder|fileName=" << fixrFileName
@@ -93,47 +134,49 @@ int main(int argc, char** argv) {
    TestFixRecorder(*fixr, kTimes);
    stopWatch.PrintResult("FixRecorder(recv + send)", kTimes);
 
-   std::cout << "[TEST ] Reload sent.";
-   unsigned pers = 0;
-   for (unsigned L = 0; L < kTimes; ++L) {
-      CheckReloadSent(*fixr, L + 1, kTimes - L);
-      unsigned p = (L + 1) * 100 / kTimes;
-      if (pers != p) {
-         pers = p;
-         fprintf(stdout, "%3u%%\b\b\b\b", pers);
-         fflush(stdout);
-      }
-   }
-   std::cout << "\r" "[OK   ]" << std::endl;
+   CheckReloadSentAll(*fixr, "SeqIndex.", kTimes);
 
    // Test: 檔案已存在, NextSendSeq, NextRecvSeq 是否正確.
    // 再寫入一筆 recv, 讓 NextRecvSeq != NextSendSeq
    f9fix::FixBuilder fixb;
    BuildTestMessage(fixb, ToStrView(fixr->CompIDs_.Header_), kTimes + 1, fixr->GetNextRecvSeq());
    fixr->WriteInputConform(fon9::ToStrView(fon9::BufferTo<std::string>(fixb.Final(ToStrView(fixr->BeginHeader_)))));
+   // 索引檔與記錄檔一致: 從索引檔取得序號.
+   ReopenFixRecorder(fixr, compIds, fixrFileName, kTimes + 1, kTimes + 2);
+   CheckReloadSentAll(*fixr, "Reopen.", kTimes);
+
+   // Test: 索引檔遺失, 從記錄檔取得序號, 並重建索引(FlagRebase).
+   // FlagRebase 之前的訊息, 使用 SentMessageSearcher 尋找.
    fixr->WaitFlushed();
-   fixr.reset(new f9fix::FixRecorder(f9fix_BEGIN_HEADER_V42, f9fix::CompIDs{compIds}));
-   int count = 100;
-   do {
-      if (--count <= 0) {
-         std::cout << "Reopen FixRecorder|fileName=" << fixrFileName
-            << "|err=" << fon9::RevPrintTo<std::string>(res) << std::endl;
-         abort();
-      }
-      std::this_thread::sleep_for(std::chrono::milliseconds{10});
-   } while (!fixr->Initialize(fixrFileName));
-   if (fixr->GetNextRecvSeq() != kTimes + 2 || fixr->GetNextSendSeq(fixr->Lock()) != kTimes + 1) {
-      std::cout << "Reopen FixRecorder|fileName=" << fixrFileName
-         << "|err=Unexpected NextSeq|expectNextRecvSeq=" << kTimes + 2
-         << "|nextRecvSeq=" << fixr->GetNextRecvSeq()
-         << "|expectNextSendSeq=" << kTimes + 1
-         << "|nextSendSeq=" << fixr->GetNextSendSeq(fixr->Lock())
-         << std::endl;
+   fixr.reset();
+   fon9::WaitRemoveFile(fixrIdxFileName);
+   ReopenFixRecorder(fixr, compIds, fixrFileName, kTimes + 1, kTimes + 2);
+   TestFixRecorder(*fixr, kTimes);
+   CheckReloadSentAll(*fixr, "Rebase.", kTimes * 2);
+   ReopenFixRecorder(fixr, compIds, fixrFileName, kTimes * 2 + 1, kTimes * 2 + 2);
+
+   // Test: 記錄檔遺失, 索引檔仍在: 捨棄舊的索引檔, 不可繼續附加.
+   fixr->WaitFlushed();
+   fixr.reset();
+   fon9::WaitRemoveFile(fixrFileName);
+   ReopenFixRecorder(fixr, compIds, fixrFileName, 1, 1);
+   fixr->WaitFlushed();
+   fixr.reset();
+   fon9::File  fdIdx;
+   fdIdx.Open(fixrIdxFileName, fon9::FileMode::Read);
+   const auto  idxSize = fdIdx.GetFileSize();
+   fdIdx.Close();
+   std::cout << "[TEST ] Stale SeqIndex|size=" << (idxSize ? idxSize.GetResult() : 0u);
+   if (!idxSize || idxSize.GetResult() > 32 * 2) {
+      std::cout << "\r" "[ERROR]" << std::endl;
       abort();
    }
+   std::cout << "\r" "[OK   ]" << std::endl;
 
    // 結束前刪除測試檔.
    fixr.reset();
-   if (!fon9::IsKeepTestFiles(argc, argv))
+   if (!fon9::IsKeepTestFiles(argc, argv)) {
       fon9::WaitRemoveFile(fixrFileName);
+      fon9::WaitRemoveFile(fixrIdxFileName);
+   }
 }
@@ -6,6 +6,7 @@
 #include "fon9/fix/FixAdminDef.hpp"
 #include "fon9/fix/FixConfig.hpp"
 #include "fon9/fix/FixFeeder.hpp"
+#include "fon9/fix/FixApDef.hpp"
 #include "fon9/Timer.hpp"
 #include "fon9/DefaultThreadPool.hpp"
 
@@ -42,6 +43,80 @@ void TestFixSenderWrite2(f9fix::FixSender& fixSender, unsigned count, const fon9
    }
 }
 
+//--------------------------------------------------------------------------//
+// 每筆下單都相同的欄位.
+#define kBenchStaticFields          \
+   f9fix_SPLTAGEQ(Account)     "1234567" \
+   f9fix_SPLTAGEQ(HandlInst)   "1"       \
+   f9fix_SPLTAGEQ(OrdType)     "2"       \
+   f9fix_SPLTAGEQ(TimeInForce) "0"       \
+   f9fix_SPLTAGEQ(Text)        "FixSender benchmark static fields."
+
+void RevPrintBenchVarFields(f9fix::FixBuilder& fixb, unsigned n) {
+   RevPrint(fixb.GetBuffer(),
+            f9fix_SPLTAGEQ(ClOrdID),  "A", n,
+            f9fix_SPLTAGEQ(Symbol),   "2330",
+            f9fix_SPLTAGEQ(Side),     (n & 1) ? '1' : '2',
+            f9fix_SPLTAGEQ(OrderQty), 1000u + n % 10,
+            f9fix_SPLTAGEQ(Price),    500u + n % 100);
+}
+void TestFixSenderWriteTmpl(f9fix::FixSender& fixSender, unsigned count, const fon9::StrView& fldMsgType) {
+   const f9fix::FixMsgTemplate tmpl{kBenchStaticFields};
+   for (unsigned L = 0; L < count; ++L) {
+      f9fix::FixBuilder fixb{tmpl};
+      RevPrintBenchVarFields(fixb, L);
+      fixSender.Send(fldMsgType, std::move(fixb));
+   }
+}
+unsigned CountBufferNodes(const fon9::BufferList& buf) {
+   unsigned count = 0;
+   for (const fon9::BufferNode* node = buf.cfront(); node; node = node->GetNext())
+      ++count;
+   return count;
+}
+void BenchFixBuilder(const unsigned kTimes) {
+   const f9fix::FixMsgTemplate   tmpl{kBenchStaticFields};
+   // 先確定: 使用 FixMsgTemplate 與直接填入, 產生的訊息相同.
+   for (unsigned n = 0; n < 1000; ++n) {
+      f9fix::FixBuilder fixb;
+      RevPrint(fixb.GetBuffer(), kBenchStaticFields);
+      RevPrintBenchVarFields(fixb, n);
+      f9fix::FixBuilder fixt{tmpl};
+      RevPrintBenchVarFields(fixt, n);
+      const std::string msgb = fon9::BufferTo<std::string>(fixb.Final(f9fix_BEGIN_HEADER_V44));
+      const std::string msgt = fon9::BufferTo<std::string>(fixt.Final(f9fix_BEGIN_HEADER_V44));
+      if (msgb != msgt) {
+         std::cout << "[ERROR] FixMsgTemplate|n=" << n
+            << "\n" "builder =" << msgb
+            << "\n" "template=" << msgt << std::endl;
+         abort();
+      }
+   }
+   fon9::StopWatch stopWatch;
+   unsigned        nodes = 0;
+   for (unsigned n = 0; n < kTimes; ++n) {
+      f9fix::FixBuilder fixb;
+      RevPrint(fixb.GetBuffer(), kBenchStaticFields);
+      RevPrintBenchVarFields(fixb, n);
+      nodes += CountBufferNodes(fixb.Final(f9fix_BEGIN_HEADER_V44));
+   }
+   double span = stopWatch.StopTimer();
+   stopWatch.PrintResultNoEOL(span, "FixBuilder    ", kTimes)
+      << "|msgs/sec=" << static_cast<uint64_t>(kTimes / span)
+      << "|nodes/msg=" << static_cast<double>(nodes) / kTimes << std::endl;
+
+   nodes = 0;
+   stopWatch.ResetTimer();
+   for (unsigned n = 0; n < kTimes; ++n) {
+      f9fix::FixBuilder fixb{tmpl};
+      RevPrintBenchVarFields(fixb, n);
+      nodes += CountBufferNodes(fixb.Final(f9fix_BEGIN_HEADER_V44));
+   }
+   span = stopWatch.StopTimer();
+   stopWatch.PrintResultNoEOL(span, "FixMsgTemplate", kTimes)
+      << "|msgs/sec=" << static_cast<uint64_t>(kTimes / span)
+      << "|nodes/msg=" << static_cast<double>(nodes) / kTimes << std::endl;
+}
 //--------------------------------------------------------------------------//
 
 fon9_WARN_DISABLE_PADDING;
@@ -56,7 +131,9 @@ int main(int argc, char** argv) {
    std::this_thread::sleep_for(std::chrono::milliseconds{10});
 
    const char  fixrFileName[] = "FixSender_UT.log";
+   const char  fixrIdxFileName[] = "FixSender_UT.log.sidx";
    remove(fixrFileName);
+   remove(fixrIdxFileName);
 
    struct FixSender : public f9fix::FixSender {
       fon9_NON_COPY_NON_MOVE(FixSender);
@@ -108,6 +185,7 @@ int main(int argc, char** argv) {
    TestFixSenderWrite2(*fixSender, 100, f9fix_SPLFLDMSGTYPE(NewOrderSingle),  f9fix_SPLTAGEQ(Text) "NewOrderSingle2");
    TestFixSenderWrite2(*fixSender,   1, f9fix_SPLFLDMSGTYPE(Heartbeat),       f9fix_SPLTAGEQ(Text) "Heartbeat2");
    TestFixSenderWrite2(*fixSender, 100, f9fix_SPLFLDMSGTYPE(ExecutionReport), f9fix_SPLTAGEQ(Text) "ExecutionReport2");
+   TestFixSenderWriteTmpl(*fixSender, 100, f9fix_SPLFLDMSGTYPE(NewOrderSingle));
    std::cout << "\r[OK   ]\n";
 
    struct FixFeeder : public f9fix::FixFeeder {
@@ -189,9 +267,14 @@ int main(int argc, char** argv) {
    fixFeeder.CheckReplayDone(nextSendSeq);
    std::cout << "|count(Include SeqReset)=" << fixFeeder.Count_ << "\r[OK   ]\n";
 
+   utinfo.PrintSplitter();
+   BenchFixBuilder(1000 * 1000);
+
    // 結束前刪除測試檔.
    fixSender.reset();
-   if (!fon9::IsKeepTestFiles(argc, argv))
+   if (!fon9::IsKeepTestFiles(argc, argv)) {
       fon9::WaitRemoveFile(fixrFileName);
+      fon9::WaitRemoveFile(fixrIdxFileName);
+   }
 }
 fon9_WARN_POP;
@@ -26,6 +26,8 @@ fon9::StrView fgetstr(char* strbuf, int bufsz, FILE* fin) {
 static const uint32_t   kHeartBtInt = 5;
 static const char       kFixTestInitiatorRecorderFileName[] = "./FixTestI.log";
 static const char       kFixTestAcceptorRecorderFileName[] = "./FixTestA.log";
+static const char       kFixTestInitiatorRecorderIdxFileName[] = "./FixTestI.log.sidx";
+static const char       kFixTestAcceptorRecorderIdxFileName[] = "./FixTestA.log.sidx";
 enum class ConnectionType : char {
    Initiator = 'I',
    Acceptor = 'A'
@@ -142,6 +144,8 @@ int main(int argc, char** args) {
 
    std::remove(kFixTestInitiatorRecorderFileName);
    std::remove(kFixTestAcceptorRecorderFileName);
+   std::remove(kFixTestInitiatorRecorderIdxFileName);
+   std::remove(kFixTestAcceptorRecorderIdxFileName);
    for (;;) {
       printf("Connection type(A:Acceptor or I:Initiator or q:quit) = ");
       char  strbuf[f9fix::FixRecorder::kMaxFixMsgBufferSize];
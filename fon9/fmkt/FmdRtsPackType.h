@@ -39,6 +39,9 @@ fon9_ENUM(f9sv_MdRtsKind, uint32_t) {
    /// 如果有此旗標, 表示無法藉此封包判斷回補起始時間.
    f9sv_MdRtsKind_NoInfoTime = 0x100,
 
+   /// K 線(OHLCV): f9sv_RtsPackType_BarClosed, f9sv_RtsPackType_BarUpdate;
+   f9sv_MdRtsKind_Bar = 0x200,
+
    /// 當某訊息需要提供給所有訂閱者, 不論訂閱時 Kind filter.
    /// e.g. 暫停交易(BreakSt).
    f9sv_MdRtsKind_All_NoInfoTime = 0xffffffff,
@@ -157,6 +160,43 @@ fon9_ENUM(f9sv_RtsPackType, uint8_t) {
    /// 漲跌停價異動.
    f9sv_RtsPackType_PriLmts,
 
+   /// 深度委託簿快照, 不一定會填滿檔位, 接收端必須清除未提供的檔位.
+   /// - InfoTime(Bitv: Null = MdRtsDecoder.InfoTime)
+   /// - 若有 BS.MktSeq 則在此提供 MktSeq(Bitv)
+   /// - bsFlags(uint8_t): f9sv_BSFlag_Calculated, f9sv_BSFlag_OrderSell, f9sv_BSFlag_OrderBuy;
+   /// - IsEnumContains(bsFlags, f9sv_BSFlag_OrderSell): Count(Bitv), 接著提供「第1檔..第Count檔」的賣出 Pri(Bitv), Qty(Bitv);
+   /// - IsEnumContains(bsFlags, f9sv_BSFlag_OrderBuy):  Count(Bitv), 接著提供「第1檔..第Count檔」的買進 Pri(Bitv), Qty(Bitv);
+   /// - 若沒有 OrderSell 或 OrderBuy 旗標, 則表示該邊沒有任何報價.
+   f9sv_RtsPackType_SnapshotBook,
+   /// 深度委託簿異動, 與 UpdateBS 類似, 但 Level 使用 Bitv, 所以不受 16 檔的限制.
+   /// - InfoTime(Bitv: Null = MdRtsDecoder.InfoTime)
+   /// - 若有 BS.MktSeq 則在此提供 MktSeq(Bitv)
+   /// - count(1 byte): 與 UpdateBS 相同.
+   ///   - MSB 1 bit = (count & 0x80) = Calculated?
+   ///   - Count 7 bits = (count & 7f) + 1; 底下的資料重複次數.
+   /// - type(1 byte)
+   ///   - (type & RtBSType::Mask) : RtBSType::OrderBuy, OrderSell;
+   ///   - (type & RtBSAction::Mask) : RtBSAction::ChangePQ, ChangeQty, Delete, New;
+   ///   - (type & 0x0f): 保留, 目前為 0;
+   /// - Level(Bitv): 0 = 最佳一檔.
+   /// - Action == RtBSAction::New, ChangePQ: 接著提供該檔位的 Pri(Bitv), Qty(Bitv);
+   /// - Action == RtBSAction::ChangeQty: 接著提供該檔位的 Qty(Bitv);
+   /// - Action == RtBSAction::New: 先將原本檔位往後移動, 然後填入該檔位的 Pri, Qty;
+   /// - Action == RtBSAction::Delete: 後續檔位往前移動, 最後一檔清除;
+   ///   若發行端還有更深的檔位, 則會接著提供最後一檔的 ChangePQ.
+   f9sv_RtsPackType_UpdateBook,
+
+   /// 已完成的 K 線, 會儲存在 RtStorage, 回補時可取得 K 線歷史.
+   /// - InfoTime(Bitv: Null = MdRtsDecoder.InfoTime)
+   /// - 底下內容重複 1..N 次(N = 此次完成的週期數量):
+   ///   - 週期索引(uint8_t): 對應 Bars tab 的第 n 組欄位, 從 Fields_.Get(n * kSymbBarFieldCount) 開始;
+   ///   - Time(Bitv:DayTime), Open(Bitv), High(Bitv), Low(Bitv), Close(Bitv), Volume(Bitv), DealCount(Bitv);
+   f9sv_RtsPackType_BarClosed,
+   /// 尚未完成的 K 線異動, 僅發行給即時訂閱者, 不會儲存.
+   /// - InfoTime(Bitv): 此封包不影響 MdRtsDecoder.InfoTime, 也不會使用 MdRtsDecoder.InfoTime;
+   /// - 後續內容與 f9sv_RtsPackType_BarClosed 相同.
+   f9sv_RtsPackType_BarUpdate,
+
    f9sv_RtsPackType_Count,
 };
 
@@ -0,0 +1,412 @@
+﻿// \file fon9/fmkt/MdRtRecoverSch.cpp
+// \author fonwinz@gmail.com
+#include "fon9/fmkt/MdRtRecoverSch.hpp"
+#include "fon9/fmkt/MdRtStreamInn.hpp"
+#include "fon9/seed/FieldMaker.hpp"
+#include "fon9/seed/TreeLockContainerT.hpp"
+#include "fon9/seed/MaTree.hpp"
+#include "fon9/seed/Plugins.hpp"
+#include "fon9/ThreadTools.hpp"
+
+namespace fon9 { namespace fmkt {
+
+static constexpr unsigned kRecoverClassCount = cast_to_underlying(MdRtRecoverClass::Count);
+
+bool MdRtRecoverSchArgs::SetTagValue(StrView tag, StrView value) {
+   if (tag == "Workers")
+      this->WorkerCount_ = StrTo(value, 0u);
+   else if (tag == "ClientWorkers")
+      this->ClientWorkers_ = StrTo(value, 0u);
+   else if (tag == "RecentSecs")
+      this->RecentSecs_ = StrTo(value, 0u);
+   else if (tag == "RecentBurst")
+      this->RecentBurst_ = StrTo(value, 0u);
+   else
+      return false;
+   return true;
+}
+//--------------------------------------------------------------------------//
+MdRtRecoverSch::Impl::Impl() {
+   this->Stats_[cast_to_underlying(MdRtRecoverClass::Recent)].Name_.assign("Recent");
+   this->Stats_[cast_to_underlying(MdRtRecoverClass::Replay)].Name_.assign("Replay");
+}
+MdRtRecoverSch::Impl::iterator MdRtRecoverSch::Impl::find(StrView name) {
+   for (MdRtRecoverStat& st : this->Stats_) {
+      if (ToStrView(st.Name_) == name)
+         return &st;
+   }
+   return this->end();
+}
+
+MdRtRecoverSch::MdRtRecoverSch(const MdRtRecoverSchArgs& args, StrView name)
+   : Args_(args)
+   , TimerThread_{new TimerThread{RevPrintTo<std::string>(name, ".Timer")}}
+   , StatTimer_{TimerThread_} {
+   MdRtRecoverSchArgs& cfg = *const_cast<MdRtRecoverSchArgs*>(&this->Args_);
+   if (cfg.WorkerCount_ <= 0)
+      cfg.WorkerCount_ = 1;
+   if (cfg.ClientWorkers_ <= 0)
+      cfg.ClientWorkers_ = 1;
+   this->Controller_.OnBeforeThreadStart(cfg.WorkerCount_);
+   this->Workers_.reserve(cfg.WorkerCount_);
+   for (unsigned id = 0; id < cfg.WorkerCount_;)
+      this->Workers_.emplace_back(&ThrRun, RevPrintTo<std::string>(name, "|indexInPool=", ++id), this);
+   this->StatTimer_.RunAfter(TimeInterval_Second(1));
+}
+MdRtRecoverSch::~MdRtRecoverSch() {
+   this->StatTimer_.DisposeAndWait();
+   this->Controller_.WaitForEndNow();
+   JoinThreads(this->Workers_);
+   this->TimerThread_->WaitForEndNow();
+}
+void MdRtRecoverSch::EmitOnStatTimer(TimerEntry* timer, TimeStamp now) {
+   (void)now;
+   MdRtRecoverSch& rthis = ContainerOf(*static_cast<StatTimer*>(timer), &MdRtRecoverSch::StatTimer_);
+   {
+      Locker impl{rthis.Controller_};
+      for (MdRtRecoverStat& st : impl->Stats_) {
+         st.BytesPerSec_ = st.Bytes_ - st.PrevBytes_;
+         st.PrevBytes_ = st.Bytes_;
+      }
+   }
+   timer->RunAfter(TimeInterval_Second(1));
+}
+//--------------------------------------------------------------------------//
+static inline MdRtRecoverStat& GetStat(MdRtRecoverStat* stats, const MdRtRecover& rec) {
+   return stats[cast_to_underlying(rec.SchClass_)];
+}
+static void SetSchSt(MdRtRecoverStat* stats, MdRtRecover& rec, MdRtRecover::SchSt st) {
+   MdRtRecoverStat& stat = GetStat(stats, rec);
+   switch (rec.SchSt_) {
+   case MdRtRecover::SchSt::None:
+   case MdRtRecover::SchSt::Done:      break;
+   case MdRtRecover::SchSt::Ready:     --stat.Ready_;    break;
+   case MdRtRecover::SchSt::Running:   --stat.Running_;  break;
+   case MdRtRecover::SchSt::Waiting:   --stat.Waiting_;  break;
+   }
+   switch (rec.SchSt_ = st) {
+   case MdRtRecover::SchSt::None:      break;
+   case MdRtRecover::SchSt::Ready:     ++stat.Ready_;    break;
+   case MdRtRecover::SchSt::Running:   ++stat.Running_;  break;
+   case MdRtRecover::SchSt::Waiting:   ++stat.Waiting_;  break;
+   case MdRtRecover::SchSt::Done:      ++stat.Finished_; break;
+   }
+}
+
+void MdRtRecoverSch::Start(MdRtRecoverSP rec, DayTime lastInfoTime) {
+   // 判斷是否為近期資料的回補: 從頭回補(!IsStarted_) 必定為 Replay;
+   rec->SchClass_ = MdRtRecoverClass::Replay;
+   if (!rec->IsStarted_ && !lastInfoTime.IsNull()) {
+      // 資料時間若小於 DailyClearTime, 表示已跨日, 需加上一日後再比較.
+      const DayTime  clearTime = rec->Mgr_.DailyClearTime();
+      DayTime        reqTime = rec->StartInfoTime_;
+      if (reqTime < clearTime)
+         reqTime += TimeInterval_Day(1);
+      if (lastInfoTime < clearTime)
+         lastInfoTime += TimeInterval_Day(1);
+      if (reqTime + TimeInterval_Second(this->Args_.RecentSecs_) >= lastInfoTime)
+         rec->SchClass_ = MdRtRecoverClass::Recent;
+   }
+   rec->SchStartTime_ = UtcNow();
+   Locker impl{this->Controller_};
+   if (this->Controller_.IsThreadEnding())
+      return;
+   ++GetStat(impl->Stats_, *rec).Started_;
+   impl->Recovers_.insert(rec.get());
+   this->PushReady(impl, *rec);
+}
+void MdRtRecoverSch::OnRecoverTimer(MdRtRecover& rec) {
+   Locker impl{this->Controller_};
+   if (rec.SchSt_ != MdRtRecover::SchSt::Waiting)
+      return;
+   if (rec.SchIsDisposed_ || this->Controller_.IsThreadEnding()) {
+      this->SetRecoverDone(impl, rec);
+      return;
+   }
+   this->PushReady(impl, rec);
+}
+void MdRtRecoverSch::PushReady(Locker& impl, MdRtRecover& rec) {
+   // 訂閱者若沒有提供 client key, 則每個回補要求視為一個 client.
+   rec.SchClientKey_ = (rec.ClientKey_ ? rec.ClientKey_ : &rec);
+   Client&        cli = impl->Clients_[rec.SchClientKey_];
+   cli.Key_ = rec.SchClientKey_;
+   const unsigned cls = cast_to_underlying(rec.SchClass_);
+   SetSchSt(impl->Stats_, rec, MdRtRecover::SchSt::Ready);
+   cli.Ready_[cls].emplace_back(&rec);
+   if (!cli.IsInReadyList_[cls] && cli.Running_ < this->Args_.ClientWorkers_) {
+      cli.IsInReadyList_[cls] = true;
+      impl->ReadyList_[cls].push_back(&cli);
+      this->Controller_.NotifyOne(impl);
+   }
+}
+void MdRtRecoverSch::CheckReadyList(Locker& impl, Client& cli) {
+   bool isIdle = (cli.Running_ == 0);
+   for (unsigned cls = 0; cls < kRecoverClassCount; ++cls) {
+      if (cli.IsInReadyList_[cls])
+         isIdle = false;
+      else if (!cli.Ready_[cls].empty()) {
+         isIdle = false;
+         if (cli.Running_ < this->Args_.ClientWorkers_) {
+            cli.IsInReadyList_[cls] = true;
+            impl->ReadyList_[cls].push_back(&cli);
+            this->Controller_.NotifyOne(impl);
+         }
+      }
+   }
+   if (isIdle)
+      impl->Clients_.erase(cli.Key_);
+}
+MdRtRecoverSP MdRtRecoverSch::PopReady(Locker& impl) {
+   constexpr unsigned kRecent = cast_to_underlying(MdRtRecoverClass::Recent);
+   constexpr unsigned kReplay = cast_to_underlying(MdRtRecoverClass::Replay);
+   // 優先處理 Recent, 但連續 RecentBurst_ 次之後, 若有 Replay, 則處理一次 Replay.
+   unsigned cls = kRecent;
+   if (impl->ReadyList_[kRecent].empty()
+       || (impl->RecentBurstCount_ >= this->Args_.RecentBurst_ && !impl->ReadyList_[kReplay].empty()))
+      cls = kReplay;
+   for (unsigned L = 0; L < kRecoverClassCount; ++L, cls = (cls == kRecent ? kReplay : kRecent)) {
+      auto& rlist = impl->ReadyList_[cls];
+      while (!rlist.empty()) {
+         Client& cli = *rlist.front();
+         rlist.pop_front();
+         cli.IsInReadyList_[cls] = false;
+         if (cli.Running_ >= this->Args_.ClientWorkers_)
+            continue; // 等該 client 的時間片結束後, 再透過 CheckReadyList() 放回.
+         if (cli.Ready_[cls].empty()) { // 佇列中的回補要求已被 DisposeRecovers() 移除.
+            this->CheckReadyList(impl, cli);
+            continue;
+         }
+         MdRtRecoverSP rec{std::move(cli.Ready_[cls].front())};
+         cli.Ready_[cls].pop_front();
+         ++cli.Running_;
+         // 同一個 client 還有其他回補要求, 排到尾端, 讓其他 client 優先.
+         if (!cli.Ready_[cls].empty() && cli.Running_ < this->Args_.ClientWorkers_) {
+            cli.IsInReadyList_[cls] = true;
+            rlist.push_back(&cli);
+         }
+         if (cls == kRecent)
+            ++impl->RecentBurstCount_;
+         else
+            impl->RecentBurstCount_ = 0;
+         SetSchSt(impl->Stats_, *rec, MdRtRecover::SchSt::Running);
+         return rec;
+      }
+   }
+   return nullptr;
+}
+void MdRtRecoverSch::OnSliceDone(Locker& impl, MdRtRecover& rec, TimeInterval next) {
+   MdRtRecoverStat& stat = GetStat(impl->Stats_, rec);
+   stat.Bytes_ += rec.SliceBytes_;
+   rec.SliceBytes_ = 0;
+   if (!rec.SchIsTtfbCounted_ && !rec.FirstNotifyTime_.IsNullOrZero()) {
+      rec.SchIsTtfbCounted_ = true;
+      stat.TtfbLast_ = rec.FirstNotifyTime_ - rec.SchStartTime_;
+      if (stat.TtfbMax_ < stat.TtfbLast_)
+         stat.TtfbMax_ = stat.TtfbLast_;
+      ++stat.TtfbCount_;
+      stat.TtfbAvg_.SetOrigValue(stat.TtfbAvg_.GetOrigValue()
+         + (stat.TtfbLast_.GetOrigValue() - stat.TtfbAvg_.GetOrigValue()) / static_cast<TimeInterval::OrigType>(stat.TtfbCount_));
+   }
+   auto icli = impl->Clients_.find(rec.SchClientKey_);
+   assert(icli != impl->Clients_.end() && icli->second.Running_ > 0);
+   Client& cli = icli->second;
+   --cli.Running_;
+
+   if (rec.SchIsDisposed_ || next.IsNull() || this->Controller_.IsThreadEnding())
+      this->SetRecoverDone(impl, rec);
+   else if (next.IsZero())
+      this->PushReady(impl, rec);
+   else {
+      SetSchSt(impl->Stats_, rec, MdRtRecover::SchSt::Waiting);
+      rec.RunAfter(next);
+   }
+   // rec 可能已移到其他 client(訂閱者提供了新的 client key), 所以需要檢查原本的 client.
+   this->CheckReadyList(impl, cli);
+}
+void MdRtRecoverSch::SetRecoverDone(Locker& impl, MdRtRecover& rec) {
+   SetSchSt(impl->Stats_, rec, MdRtRecover::SchSt::Done);
+   impl->Recovers_.erase(&rec);
+   if (rec.SchIsDisposed_)
+      this->DisposedCV_.notify_all();
+}
+void MdRtRecoverSch::ThrRun(std::string thrName, MdRtRecoverSch* pthis) {
+   SetCurrentThreadName(thrName.c_str());
+   fon9_LOG_ThrRun("MdRtRecoverSch.ThrRun|name=", thrName);
+   {
+      Locker impl{pthis->Controller_};
+      while (!pthis->Controller_.IsThreadEnding()) {
+         MdRtRecoverSP rec = pthis->PopReady(impl);
+         if (!rec) {
+            pthis->Controller_.Wait(impl);
+            continue;
+         }
+         impl.unlock();
+         const TimeInterval next = rec->RunSlice();
+         impl.lock();
+         pthis->OnSliceDone(impl, *rec, next);
+         if (rec->SchSt_ == MdRtRecover::SchSt::Done) {
+            // 回補結束, 在 unlock 狀態下釋放, 避免在 lock 狀態下執行訂閱者的解構.
+            impl.unlock();
+            rec.reset();
+            impl.lock();
+         }
+      }
+      pthis->Controller_.OnBeforeThreadEnd(impl);
+   }
+   fon9_LOG_ThrRun("MdRtRecoverSch.ThrRun.End|name=", thrName);
+}
+//--------------------------------------------------------------------------//
+void MdRtRecoverSch::DisposeRecovers(MdRtStreamInnMgr& mgr) {
+   std::vector<MdRtRecoverSP> waits, removed;
+   Locker impl{this->Controller_};
+   for (MdRtRecover* rec : impl->Recovers_) {
+      if (&rec->Mgr_ != &mgr)
+         continue;
+      rec->SchIsDisposed_ = true;
+      if (rec->SchSt_ == MdRtRecover::SchSt::Waiting)
+         waits.emplace_back(rec);
+   }
+   // 移除還在佇列中的回補要求.
+   for (auto& icli : impl->Clients_) {
+      for (auto& rqu : icli.second.Ready_) {
+         for (auto irec = rqu.begin(); irec != rqu.end();) {
+            MdRtRecover& rec = **irec;
+            if (!rec.SchIsDisposed_)
+               ++irec;
+            else {
+               this->SetRecoverDone(impl, rec);
+               removed.emplace_back(std::move(*irec));
+               irec = rqu.erase(irec);
+            }
+         }
+      }
+   }
+   impl.unlock();
+   // 等候流量管制的計時器: 若已觸發 OnTimer(), 則會在 OnRecoverTimer() 移除.
+   for (MdRtRecoverSP& rec : waits)
+      rec->StopAndWait();
+   impl.lock();
+   for (MdRtRecoverSP& rec : waits) {
+      if (rec->SchSt_ == MdRtRecover::SchSt::Waiting)
+         this->SetRecoverDone(impl, *rec);
+   }
+   // 等候執行中的時間片結束: 在 OnSliceDone() 呼叫 SetRecoverDone() 時通知.
+   this->DisposedCV_.wait(impl, [&impl, &mgr]() {
+      for (MdRtRecover* rec : impl->Recovers_) {
+         if (&rec->Mgr_ == &mgr)
+            return false;
+      }
+      return true;
+   });
+}
+//--------------------------------------------------------------------------//
+class MdRtRecoverSch::StatTree : public seed::Tree {
+   fon9_NON_COPY_NON_MOVE(StatTree);
+   using base = seed::Tree;
+   using PodOp = seed::PodOpLockerNoWrite<MdRtRecoverStat, Locker>;
+   struct TreeOp : public seed::TreeOp {
+      fon9_NON_COPY_NON_MOVE(TreeOp);
+      using base = seed::TreeOp;
+      using base::base;
+      static void MakeRecordView(Impl::iterator ivalue, seed::Tab* tab, RevBuffer& rbuf) {
+         if (tab)
+            FieldsCellRevPrint(tab->Fields_, seed::SimpleRawRd{*ivalue}, rbuf);
+         RevPrint(rbuf, ivalue->Name_);
+      }
+      void GridView(const seed::GridViewRequest& req, seed::FnGridViewOp fnCallback) override {
+         seed::TreeOp_GridView_MustLock(*this, static_cast<StatTree*>(&this->Tree_)->Sch_->Controller_,
+                                        req, std::move(fnCallback), &MakeRecordView);
+      }
+      void Get(StrView strKeyText, seed::FnPodOp fnCallback) override {
+         seed::TreeOp_Get_MustLock<PodOp>(*this, static_cast<StatTree*>(&this->Tree_)->Sch_->Controller_,
+                                          strKeyText, std::move(fnCallback));
+      }
+   };
+   static seed::LayoutSP MakeLayout() {
+      seed::Fields fields;
+      fields.Add(fon9_MakeField2_const(MdRtRecoverStat, Ready));
+      fields.Add(fon9_MakeField2_const(MdRtRecoverStat, Running));
+      fields.Add(fon9_MakeField2_const(MdRtRecoverStat, Waiting));
+      fields.Add(fon9_MakeField2_const(MdRtRecoverStat, Started));
+      fields.Add(fon9_MakeField2_const(MdRtRecoverStat, Finished));
+      fields.Add(fon9_MakeField2_const(MdRtRecoverStat, Bytes));
+      fields.Add(fon9_MakeField2_const(MdRtRecoverStat, BytesPerSec));
+      fields.Add(fon9_MakeField2_const(MdRtRecoverStat, TtfbLast));
+      fields.Add(fon9_MakeField2_const(MdRtRecoverStat, TtfbAvg));
+      fields.Add(fon9_MakeField2_const(MdRtRecoverStat, TtfbMax));
+      return new seed::Layout1(fon9_MakeField(MdRtRecoverStat, Name_, "Class"),
+                               new seed::Tab{Named{"Stat"}, std::move(fields), seed::TabFlag::NoSapling},
+                               seed::TreeFlag{});
+   }
+public:
+   const MdRtRecoverSchSP  Sch_;
+   StatTree(MdRtRecoverSchSP sch) : base{MakeLayout()}, Sch_{std::move(sch)} {
+   }
+   void OnTreeOp(seed::FnTreeOp fnCallback) override {
+      TreeOp op{*this};
+      fnCallback(seed::TreeOpResult{this, seed::OpResult::no_error}, &op);
+   }
+};
+seed::TreeSP MdRtRecoverSch::MakeStatTree() {
+   return new StatTree{this};
+}
+//--------------------------------------------------------------------------//
+/// setSch == nullptr: 取得預設值, 若尚未設定, 則建立一個.
+/// setSch != nullptr: 設定預設值, 若已有預設值, 則返回 nullptr;
+static MdRtRecoverSchSP DefaultMdRtRecoverSch(MdRtRecoverSchSP* setSch) {
+   static std::mutex       Mutex_;
+   static MdRtRecoverSchSP Sch_;
+   std::lock_guard<std::mutex> lk{Mutex_};
+   if (setSch) {
+      if (Sch_)
+         return nullptr;
+      Sch_ = std::move(*setSch);
+   }
+   else if (!Sch_)
+      Sch_.reset(new MdRtRecoverSch{MdRtRecoverSchArgs{}, "MdRtRecoverSch"});
+   return Sch_;
+}
+fon9_API MdRtRecoverSchSP GetDefaultMdRtRecoverSch() {
+   return DefaultMdRtRecoverSch(nullptr);
+}
+fon9_API bool SetDefaultMdRtRecoverSch(MdRtRecoverSchSP sch) {
+   return DefaultMdRtRecoverSch(&sch).get() != nullptr;
+}
+//--------------------------------------------------------------------------//
+/// args = "Name=MdRtRecoverSch|Workers=2|ClientWorkers=1|RecentSecs=60|RecentBurst=4"
+/// - 設定預設的回補排程, 並在 holder.Root_ 加入 Name 的回補統計.
+static bool MdRtRecoverSch_Start(seed::PluginsHolder& holder, StrView args) {
+   MdRtRecoverSchArgs   schArgs;
+   std::string          name{"MdRtRecoverSch"};
+   StrView              tag, value;
+   while (SbrFetchTagValue(args, tag, value)) {
+      if (tag == "Name")
+         name = value.ToString();
+      else if (!schArgs.SetTagValue(tag, value)) {
+         holder.SetPluginsSt(LogLevel::Error, "Unknown tag=", tag);
+         return false;
+      }
+   }
+   MdRtRecoverSchSP sch{new MdRtRecoverSch{schArgs, ToStrView(name)}};
+   if (!SetDefaultMdRtRecoverSch(sch)) {
+      holder.SetPluginsSt(LogLevel::Error, "err=Default MdRtRecoverSch has been used");
+      return false;
+   }
+   if (!holder.Root_->AddNamedSapling(sch->MakeStatTree(), name)) {
+      holder.SetPluginsSt(LogLevel::Error, "Name=", name, "|err=Name is dup");
+      return false;
+   }
+   return true;
+}
+
+} } // namespaces
+
+extern "C" fon9_API fon9::seed::PluginsDesc f9p_MdRtRecoverSch;
+static fon9::seed::PluginsPark f9pAutoPluginsReg{"MdRtRecoverSch", &f9p_MdRtRecoverSch};
+
+fon9::seed::PluginsDesc f9p_MdRtRecoverSch{
+   "",
+   &fon9::fmkt::MdRtRecoverSch_Start,
+   nullptr,
+   nullptr,
+};
@@ -0,0 +1,180 @@
+﻿// \file fon9/fmkt/MdRtRecoverSch.hpp
+// \author fonwinz@gmail.com
+#ifndef __fon9_fmkt_MdRtRecoverSch_hpp__
+#define __fon9_fmkt_MdRtRecoverSch_hpp__
+#include "fon9/seed/Tree.hpp"
+#include "fon9/ThreadController.hpp"
+#include "fon9/Timer.hpp"
+#include "fon9/CharVector.hpp"
+fon9_BEFORE_INCLUDE_STD;
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+fon9_AFTER_INCLUDE_STD;
+
+namespace fon9 { namespace fmkt {
+
+class fon9_API MdRtStreamInnMgr;
+struct MdRtRecover;
+using MdRtRecoverSP = intrusive_ptr<MdRtRecover>;
+
+/// 回補要求的分類, 排程時優先處理 Recent.
+enum class MdRtRecoverClass : uint8_t {
+   /// 要求的開始時間, 在「最後資料時間」的 RecentSecs_ 秒之內.
+   Recent,
+   /// 從頭開始回補, 或要求的開始時間較早.
+   Replay,
+   Count,
+};
+
+struct fon9_API MdRtRecoverSchArgs {
+   /// 執行回補的 thread 數量.
+   uint32_t WorkerCount_{2};
+   /// 每個 client 同時可使用的 worker 數量.
+   /// 同一個 client 的多個回補要求, 輪流使用這些 worker.
+   uint32_t ClientWorkers_{1};
+   /// 要求的開始時間, 在最後資料時間的 RecentSecs_ 秒之內, 視為 MdRtRecoverClass::Recent;
+   uint32_t RecentSecs_{60};
+   /// 連續處理 RecentBurst_ 個 Recent 時間片之後,
+   /// 若有等候中的 Replay, 則處理一個 Replay 時間片, 避免 Replay 飢餓.
+   uint32_t RecentBurst_{4};
+
+   /// - "Workers=n|ClientWorkers=n|RecentSecs=n|RecentBurst=n"
+   /// - 不認識的 tag 返回 false;
+   bool SetTagValue(StrView tag, StrView value);
+};
+
+/// 回補的統計資料, 在 MdRtRecoverSch 鎖定的狀態下異動.
+struct MdRtRecoverStat {
+   CharVector     Name_;
+   /// 等候 worker 執行的數量(queue depth).
+   uint32_t       Ready_{0};
+   uint32_t       Running_{0};
+   /// 等候流量管制解除的數量.
+   uint32_t       Waiting_{0};
+   char           Padding___[4];
+   uint64_t       Started_{0};
+   uint64_t       Finished_{0};
+   uint64_t       Bytes_{0};
+   uint64_t       BytesPerSec_{0};
+   /// time-to-first-byte: 從要求回補, 到第一次送出回補訊息的時間.
+   TimeInterval   TtfbLast_{};
+   TimeInterval   TtfbAvg_{};
+   TimeInterval   TtfbMax_{};
+   uint64_t       TtfbCount_{0};
+   uint64_t       PrevBytes_{0};
+
+   MdRtRecoverStat& GetSeedRW(seed::Tab&) {
+      return *this;
+   }
+   seed::TreeSP HandleGetSapling(seed::Tab&) {
+      return seed::TreeSP{};
+   }
+   template <class Locker>
+   void HandleSeedCommand(Locker&, seed::SeedOpResult& res, StrView, seed::FnCommandResultHandler&& resHandler) {
+      res.OpResult_ = seed::OpResult::not_supported_cmd;
+      resHandler(res, nullptr);
+   }
+};
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup fmkt
+/// MdRtStream 的歷史回補排程.
+/// - 使用 WorkerCount_ 個 thread 執行回補, 每次執行一個回補要求的一個時間片(slice),
+///   執行完畢後排到佇列尾端, 讓其他回補要求有機會執行.
+/// - 依 client 公平分配: 訂閱者可透過 seed::SeedNotifyStreamRecoverArgs::FlowControlKey_ 告知回補的歸屬,
+///   同一個 client 的回補要求, 同時最多使用 ClientWorkers_ 個 worker;
+///   例: RcSeedVisitorServer 使用 RcSession 當作 client;
+/// - 頻寬限制由訂閱者處理(例: RcSession 的 FcRecover), 透過 FlowControlWait_ 告知延遲,
+///   延遲期間不佔用 worker, 時間到後再放回佇列.
+/// - Recent 優先於 Replay, 但每 RecentBurst_ 個 Recent 時間片, 至少執行一個 Replay 時間片.
+class fon9_API MdRtRecoverSch : public intrusive_ref_counter<MdRtRecoverSch> {
+   fon9_NON_COPY_NON_MOVE(MdRtRecoverSch);
+public:
+   const MdRtRecoverSchArgs   Args_;
+   const TimerThreadSP        TimerThread_;
+
+private:
+   struct Client {
+      const void*                Key_{};
+      std::deque<MdRtRecoverSP>  Ready_[cast_to_underlying(MdRtRecoverClass::Count)];
+      uint32_t                   Running_{0};
+      bool                       IsInReadyList_[cast_to_underlying(MdRtRecoverClass::Count)]{};
+   };
+   struct Impl {
+      using Stats = MdRtRecoverStat[cast_to_underlying(MdRtRecoverClass::Count)];
+      using iterator = MdRtRecoverStat*;
+      using const_iterator = const MdRtRecoverStat*;
+
+      Stats                                     Stats_;
+      std::unordered_map<const void*, Client>   Clients_;
+      /// 有 Ready_ 的 client, 依序輪流執行.
+      std::deque<Client*>                       ReadyList_[cast_to_underlying(MdRtRecoverClass::Count)];
+      /// 全部尚未結束的回補, 用於 DisposeRecovers();
+      std::unordered_set<MdRtRecover*>          Recovers_;
+      uint32_t                                  RecentBurstCount_{0};
+
+      Impl();
+      /// 提供給 seed::TreeOp 使用: 查找統計資料.
+      iterator find(StrView name);
+      iterator lower_bound(StrView name) {
+         return this->find(name);
+      }
+      iterator begin() { return this->Stats_; }
+      iterator end() { return this->Stats_ + numofele(this->Stats_); }
+      const_iterator begin() const { return this->Stats_; }
+      const_iterator end() const { return this->Stats_ + numofele(this->Stats_); }
+   };
+   using Controller = ThreadController<Impl, WaitPolicy_CV>;
+   using Locker = Controller::Locker;
+   Controller                 Controller_;
+   std::vector<std::thread>   Workers_;
+   /// 已 dispose 的回補結束時通知, 讓 DisposeRecovers() 等候執行中的時間片結束.
+   std::condition_variable    DisposedCV_;
+
+   static void EmitOnStatTimer(TimerEntry* timer, TimeStamp now);
+   using StatTimer = DataMemberEmitOnTimer<&MdRtRecoverSch::EmitOnStatTimer>;
+   StatTimer StatTimer_;
+
+   class StatTree;
+   friend struct MdRtRecover;
+
+   static void ThrRun(std::string thrName, MdRtRecoverSch* pthis);
+   MdRtRecoverSP PopReady(Locker& impl);
+   void PushReady(Locker& impl, MdRtRecover& rec);
+   void CheckReadyList(Locker& impl, Client& cli);
+   void OnSliceDone(Locker& impl, MdRtRecover& rec, TimeInterval next);
+   /// 回補結束: 設定 Done, 並從 Recovers_ 移除.
+   void SetRecoverDone(Locker& impl, MdRtRecover& rec);
+   /// 由 MdRtRecover::OnTimer() 呼叫: 流量管制的延遲時間到.
+   void OnRecoverTimer(MdRtRecover& rec);
+
+public:
+   MdRtRecoverSch(const MdRtRecoverSchArgs& args, StrView name);
+   ~MdRtRecoverSch();
+
+   /// 開始回補.
+   /// - lastInfoTime = 最後資料時間, 用來判斷是否為 MdRtRecoverClass::Recent;
+   void Start(MdRtRecoverSP rec, DayTime lastInfoTime);
+
+   /// 在 mgr 解構前呼叫: 放棄屬於 mgr 的回補要求, 並等候執行中的時間片結束.
+   void DisposeRecovers(MdRtStreamInnMgr& mgr);
+
+   /// 建立回補統計的 seed tree;
+   seed::TreeSP MakeStatTree();
+};
+fon9_WARN_POP;
+using MdRtRecoverSchSP = intrusive_ptr<MdRtRecoverSch>;
+
+/// 取得預設的回補排程.
+/// - 若尚未設定, 則使用 MdRtRecoverSchArgs 的預設值建立.
+fon9_API MdRtRecoverSchSP GetDefaultMdRtRecoverSch();
+/// 設定預設的回補排程.
+/// - 必須在首次 GetDefaultMdRtRecoverSch() 之前設定, 否則返回 false;
+fon9_API bool SetDefaultMdRtRecoverSch(MdRtRecoverSchSP sch);
+
+} } // namespaces
+#endif//__fon9_fmkt_MdRtRecoverSch_hpp__
@@ -5,6 +5,7 @@
 #include "fon9/fmkt/SymbBS.hpp"
 #include "fon9/seed/FieldMaker.hpp"
 #include "fon9/Log.hpp"
+#include "fon9/LatencyHist.hpp"
 
 namespace fon9 { namespace fmkt {
 
@@ -21,14 +22,25 @@ seed::OpResult MdRtStream::SubscribeStream(SubConn*           pSubConn,
                                            SymbPodOp&         op,
                                            StrView            args,
                                            seed::FnSeedSubr&& subr) {
-   // args = "MdRts:F:F,RecoverTime"
+   // args = "MdRts:F:F,RecoverTime" or "MdRts:F/C:F,RecoverTime"
    // 1st F(hex) is MdRtsKind MdRtSubr.RtFilter_;
+   // /C(hex) is MdRtsKind MdRtConflate.Kinds_;
    // 2nd F(hex) is MdRtsKind MdRtRecover.Filter_;
    const StrView decoderName = StrFetchTrim(args, ':');
    if (decoderName != "MdRts")
       return seed::OpResult::bad_subscribe_stream_args;
 
    MdRtSubrSP  psub{new MdRtSubr{std::move(subr), &args}};
+   // 合併模式: "MdRts:F/C:F,RecoverTime"
+   // C(hex) 為可合併的 MdRtsKind, empty() or 0 表示 BS|Deal;
+   if (StrTrimHead(&args).Get1st() == '/') {
+      StrTrimHead(&args, args.begin() + 1);
+      auto kinds = static_cast<f9sv_MdRtsKind>(HexStrTo(&args));
+      if (kinds == f9sv_MdRtsKind{})
+         kinds = kMdRtConflatableKinds;
+      if ((kinds &= kMdRtConflatableKinds) != f9sv_MdRtsKind{})
+         psub->Conflate_.reset(new MdRtConflate{kinds, *op.Symb_});
+   }
    // 必須先加入訂閱, 因為 psub(SubscribeStreamOK{}) 呼叫時, 可能會取消訂閱!
    // 如果在 psub(SubscribeStreamOK{}) 之後才加入訂閱, 這樣的取消就無效了!
    this->UnsafeSubj_.Subscribe(pSubConn, psub);
@@ -86,7 +98,7 @@ seed::OpResult MdRtStream::SubscribeStream(SubConn*           pSubConn,
    if (StrTrimHead(&args).Get1st() == ',')
       StrTrimHead(&args, args.begin() + 1);
    recover->SetStartInfoTime(StrTo(&args, DayTime::Null()));
-   recover->RunAfter(TimeInterval{});
+   this->InnMgr_.RecoverSch().Start(std::move(recover), this->InfoTime_);
    return seed::OpResult::no_error;
 }
 //--------------------------------------------------------------------------//
@@ -132,9 +144,7 @@ void MdRtStream::PublishUpdateBS(const StrView& keyText, SymbBSData& symbBS, Rev
    // 每秒儲存一次 SnapshotBS, 回補時才不會在沒有「參考報價」的情況下收到 UpdateBS.
    PackMktSeq(rts, flags, symbBS.MarketSeq_);
    this->Publish(keyText, f9sv_RtsPackType_UpdateBS, f9sv_MdRtsKind_BS, symbBS.InfoTime_, std::move(rts));
-   const auto bstm = static_cast<uint32_t>(symbBS.InfoTime_.GetIntPart());
-   if (this->LastTimeSnapshotBS_ != bstm) {
-      this->LastTimeSnapshotBS_ = bstm;
+   if (this->CheckSnapshotBSTime(symbBS.InfoTime_)) {
       rts.MoveOut();
       symbBS.Flags_ |= f9sv_BSFlag_OrderBuy | f9sv_BSFlag_OrderSell | f9sv_BSFlag_DerivedBuy | f9sv_BSFlag_DerivedSell;
       MdRtsPackSnapshotBS(rts, symbBS);
@@ -159,6 +169,7 @@ void MdRtStream::Publish(const StrView& keyText, f9sv_RtsPackType pkType, f9sv_M
    }
    *rts.AllocPacket<uint8_t>() = cast_to_underlying(pkType);
    // -----
+   this->IsSnapshotDirty_ = true;
    MdRtsNotifyArgs e{this->InnMgr_.MdSymbs_, keyText, pkKind, rts};
    this->UnsafeSubj_.Publish(e);
    this->InnMgr_.MdSymbs_.UnsafePublish(pkType, e);
@@ -167,10 +178,12 @@ void MdRtStream::Publish(const StrView& keyText, f9sv_RtsPackType pkType, f9sv_M
       fon9_WARN_DISABLE_SWITCH;
       switch (pkType) {
       case f9sv_RtsPackType_UpdateBS:
-         // 由 this->PublishUpdateBS() 決定如何儲存.
+      case f9sv_RtsPackType_UpdateBook:
+         // 由 this->PublishUpdateBS(), this->PublishUpdateBook() 決定如何儲存.
          return;
       case f9sv_RtsPackType_SnapshotBS:
       case f9sv_RtsPackType_CalculatedBS:
+      case f9sv_RtsPackType_SnapshotBook:
          this->LastTimeSnapshotBS_ = static_cast<uint32_t>(infoTime.GetIntPart());
          break;
       }
@@ -178,9 +191,20 @@ void MdRtStream::Publish(const StrView& keyText, f9sv_RtsPackType pkType, f9sv_M
    }
    this->Save(std::move(rts), pkKind);
 }
+void MdRtStream::PublishRtOnly(const StrView& keyText, f9sv_RtsPackType pkType, f9sv_MdRtsKind pkKind, DayTime infoTime, RevBufferList&& rts) {
+   ToBitv(rts, infoTime);
+   *rts.AllocPacket<uint8_t>() = cast_to_underlying(pkType);
+   this->IsSnapshotDirty_ = true;
+   MdRtsNotifyArgs e{this->InnMgr_.MdSymbs_, keyText, pkKind, rts};
+   this->UnsafeSubj_.Publish(e);
+   this->InnMgr_.MdSymbs_.UnsafePublish(pkType, e);
+}
 void MdRtStream::PublishAndSave(const StrView& keyText, f9sv_RtsPackType pkType, f9sv_MdRtsKind pkKind, RevBufferList&& rts) {
+   fon9_LATENCY_SCOPE("MdRtStream.PublishAndSave");
+   fon9_LATENCY_SINCE_ORIGIN("TickToPublish");
    *rts.AllocPacket<uint8_t>() = cast_to_underlying(pkType);
 
+   this->IsSnapshotDirty_ = true;
    MdRtsNotifyArgs e(this->InnMgr_.MdSymbs_, keyText, pkKind, rts);
    this->UnsafeSubj_.Publish(e);
    this->InnMgr_.MdSymbs_.UnsafePublish(pkType, e);
@@ -203,8 +227,131 @@ void MdRtStream::Save(RevBufferList&& rts, f9sv_MdRtsKind pkKind) {
    }
 }
 //--------------------------------------------------------------------------//
+// 合併模式的異動種類, 對應到需要送出最新狀態的 tab.
+static const char* const   kConflateTabNamesBS[] = {fon9_kCSTR_TabName_BS, nullptr};
+static const char* const   kConflateTabNamesDeal[] = {fon9_kCSTR_TabName_Deal,
+                                                      fon9_kCSTR_TabName_High,
+                                                      fon9_kCSTR_TabName_Low, nullptr};
+static void PackConflateTabs(RevBuffer& rbuf, seed::Layout& layout, Symb& symb, const char* const* tabNames) {
+   for (; *tabNames; ++tabNames) {
+      if (seed::Tab* tab = layout.GetTab(StrView_cstr(*tabNames))) {
+         if (const SymbData* dat = symb.GetSymbData(static_cast<int>(tab->GetIndex())))
+            MdRtsPackTabValues(rbuf, *tab, *dat);
+      }
+   }
+}
+// 訂閱者仍忙碌時, 下次嘗試送出最新狀態的時間.
+static const TimeInterval  kConflateFlushInterval = TimeInterval_Millisecond(50);
+
+/// 訂閱者忙碌期間, 每個 tick 最多建立一次最新狀態, 嘗試送出.
+struct MdRtConflateFlush : public TimerEntry {
+   fon9_NON_COPY_NON_MOVE(MdRtConflateFlush);
+   /// 在 timer 結束前, 保留 MdSymbs, 避免 OnTimer() 時 MdSymbs 已經解構.
+   const intrusive_ptr<MdSymbsBase> MdSymbs_;
+   const MdRtSubrSP                 Subr_;
+   MdRtConflateFlush(MdSymbsBase& mdSymbs, MdRtSubrSP subr)
+      : TimerEntry{GetDefaultTimerThread()}
+      , MdSymbs_{&mdSymbs}
+      , Subr_{std::move(subr)} {
+   }
+   static void Schedule(MdRtSubr& subr, seed::Tree& tree) {
+      MdRtConflate& conflate = *subr.Conflate_;
+      if (conflate.IsFlushScheduled_)
+         return;
+      conflate.IsFlushScheduled_ = true;
+      intrusive_ptr<MdRtConflateFlush> timer{new MdRtConflateFlush(*static_cast<MdSymbsBase*>(&tree), &subr)};
+      timer->RunAfter(kConflateFlushInterval);
+   }
+   void OnTimer(TimeStamp now) override {
+      (void)now;
+      MdRtConflate&  conflate = *this->Subr_->Conflate_;
+      auto           symbsLk = this->MdSymbs_->GetSymbShard(ToStrView(conflate.SymbId_)).ConstLock();
+      if (!this->Subr_->IsUnsubscribed()) {
+         // 商品可能已被移除(或移除後重新加入), 此時就不用再送出了.
+         auto ifind = symbsLk->find(ToStrView(conflate.SymbId_));
+         if (ifind != symbsLk->end() && ifind->second.get() == conflate.Symb_) {
+            if (!this->Subr_->FlushConflated(*this->MdSymbs_, ToStrView(conflate.SymbId_))) {
+               symbsLk.unlock();
+               this->RunAfter(kConflateFlushInterval);
+               return;
+            }
+         }
+      }
+      conflate.IsFlushScheduled_ = false;
+   }
+};
+
+void MdRtSubr::ConflateNotify(const seed::SeedNotifyArgs& e) {
+   MdRtConflate&        conflate = *this->Conflate_;
+   const f9sv_MdRtsKind pkKind = static_cast<f9sv_MdRtsKind>(e.StreamDataKind_);
+   // 僅有 StreamData 且「全部」的種類都可合併, 才可以合併;
+   // 例: f9sv_RtsPackType_TradingSessionId 使用 f9sv_MdRtsKind_All_AndInfoTime, 則必須送出.
+   if (e.NotifyKind_ != seed::SeedNotifyKind::StreamData
+       || (pkKind - conflate.Kinds_) != f9sv_MdRtsKind{} || pkKind == f9sv_MdRtsKind{}) {
+      this->Callback_(e);
+      return;
+   }
+   if (IsEnumContainsAny(conflate.PendingKinds_, pkKind)) {
+      // 訂閱者尚未取得此種類的最新狀態, 不能送出此次異動(例: UpdateBS 必須依賴先前的狀態),
+      // 此時 symb 已包含此次異動, 由 MdRtConflateFlush 在下次 tick 建立最新狀態並送出,
+      // 避免訂閱者忙碌時, 每次異動都建立一次最新狀態.
+      conflate.PendingKinds_ |= pkKind;
+      ++conflate.MergedCount_;
+      ++conflate.PendingCount_;
+      MdRtConflateFlush::Schedule(*this, e.Tree_);
+      return;
+   }
+   e.Conflate_ = seed::StreamDataConflate::Allowed;
+   this->Callback_(e);
+   const bool isBusy = (e.Conflate_ == seed::StreamDataConflate::Busy);
+   e.Conflate_ = seed::StreamDataConflate::None;
+   if (!isBusy) {
+      if (conflate.PendingKinds_ != f9sv_MdRtsKind{})
+         this->FlushConflated(e.Tree_, e.KeyText_);
+      return;
+   }
+   conflate.PendingKinds_ |= pkKind;
+   ++conflate.MergedCount_;
+   ++conflate.PendingCount_;
+   MdRtConflateFlush::Schedule(*this, e.Tree_);
+}
+bool MdRtSubr::FlushConflated(seed::Tree& tree, const StrView& keyText) {
+   MdRtConflate& conflate = *this->Conflate_;
+   if (conflate.PendingKinds_ == f9sv_MdRtsKind{})
+      return true;
+   MdSymbsBase&  mdSymbs = *static_cast<MdSymbsBase*>(&tree);
+   assert(mdSymbs.IsSymbLocked(keyText));
+   seed::Layout& layout = *mdSymbs.LayoutSP_;
+   RevBufferList rts{256};
+   if (IsEnumContains(conflate.PendingKinds_, f9sv_MdRtsKind_BS))
+      PackConflateTabs(rts, layout, *conflate.Symb_, kConflateTabNamesBS);
+   if (IsEnumContains(conflate.PendingKinds_, f9sv_MdRtsKind_Deal))
+      PackConflateTabs(rts, layout, *conflate.Symb_, kConflateTabNamesDeal);
+   // 訂閱者可能沒收到最後的 InfoTime, 所以必須送出 InfoTime;
+   // 之後的異動若 InfoTime 使用 Null(沒變), 訂閱者才能取得正確的 InfoTime.
+   DayTime infoTime = DayTime::Null();
+   if (mdSymbs.RtTab_) {
+      if (auto* rt = static_cast<MdRtStream*>(conflate.Symb_->GetSymbData(static_cast<int>(mdSymbs.RtTab_->GetIndex()))))
+         infoTime = rt->InfoTime();
+   }
+   ToBitv(rts, infoTime);
+   *rts.AllocPacket<uint8_t>() = cast_to_underlying(f9sv_RtsPackType_TabValues_AndInfoTime);
+   MdRtsNotifyArgs e{mdSymbs, keyText, conflate.PendingKinds_, rts};
+   e.Conflate_ = seed::StreamDataConflate::Allowed;
+   this->Callback_(e);
+   if (e.Conflate_ == seed::StreamDataConflate::Busy)
+      return false;
+   conflate.PendingKinds_ = f9sv_MdRtsKind{};
+   conflate.PendingCount_ = 0;
+   ++conflate.FlushedCount_;
+   return true;
+}
+//--------------------------------------------------------------------------//
 void MdRtsNotifyArgs::MakeGridView() const {
    this->CacheGV_ = BufferTo<std::string>(this->RtsForGvStr_);
 }
+void MdRtsNotifyArgs::MakeGridViewShared() const {
+   this->CacheGvShared_.reset(new BufferShared{this->RtsForGvStr_});
+}
 
 } } // namespaces
@@ -18,8 +18,20 @@ class fon9_API MdRtStream : public SymbData {
    DayTime           InfoTime_{DayTime::Null()};
    f9sv_MdRtsKind    InfoTimeKind_{};
    uint32_t          LastTimeSnapshotBS_{};
+   /// 發行後設為 true, 表示商品需要加入 MdSymbsBase::SaveSnapshot() 的增量快照;
+   /// 在商品所在的 shard 鎖定時設定, 由 SaveSnapshot() 在 AllSymbsLocker 鎖定時檢查並清除.
+   bool              IsSnapshotDirty_{false};
+   friend class MdSymbsBase;
 
    void Save(RevBufferList&& rts, f9sv_MdRtsKind pkKind);
+   /// 若 infoTime 的秒數與 this->LastTimeSnapshotBS_ 不同, 則更新 LastTimeSnapshotBS_ 並返回 true;
+   bool CheckSnapshotBSTime(DayTime infoTime) {
+      const auto bstm = static_cast<uint32_t>(infoTime.GetIntPart());
+      if (this->LastTimeSnapshotBS_ == bstm)
+         return false;
+      this->LastTimeSnapshotBS_ = bstm;
+      return true;
+   }
 
    seed::OpResult SubscribeStream(SubConn* pSubConn, seed::Tab& tabRt, SymbPodOp& op, StrView args, seed::FnSeedSubr&& subr);
    seed::OpResult UnsubscribeStream(SubConn* pSubConn) {
@@ -76,10 +88,35 @@ public:
    /// 打包並發行:
    /// pkType + infoTime(Bitv,Null表示InfoTime沒變) + rts;
    void Publish(const StrView& keyText, f9sv_RtsPackType pkType, f9sv_MdRtsKind pkKind, DayTime infoTime, RevBufferList&& rts);
+   /// 打包並發行, 但不儲存, 回補時不會有此封包, 例: f9sv_RtsPackType_BarUpdate;
+   /// - pkType + infoTime(Bitv) + rts;
+   /// - 因為不儲存, 為了不影響回補時的 InfoTime, 所以不使用也不改變 this->InfoTime_, 必定打包 infoTime;
+   void PublishRtOnly(const StrView& keyText, f9sv_RtsPackType pkType, f9sv_MdRtsKind pkKind, DayTime infoTime, RevBufferList&& rts);
+   /// 是否沒有此商品的即時訂閱者, 不包含整棵樹的訂閱者.
+   bool IsSubjEmpty() const {
+      return this->UnsafeSubj_.IsEmpty();
+   }
    /// 若 flags 包含 MdSymbsCtrlFlag::HasMarketDataSeq, 則會將 symbBS.MarketSeq_ 打包到 rts 之後再發行.
    /// - 儲存時, 若秒數與 this->LastTimeSnapshotBS_ 不同, 則會儲存 f9sv_RtsPackType_SnapshotBS or f9sv_RtsPackType_CalculatedBS;
    ///   這樣回補時才能正確解析後續的 UpdateBS.
    void PublishUpdateBS(const StrView& keyText, SymbBSData& symbBS, RevBufferList&& rts, MdSymbsCtrlFlag flags);
+   /// 發行由 MdRtsBookPacker 打包的深度委託簿異動(f9sv_RtsPackType_UpdateBook);
+   /// - 若 flags 包含 MdSymbsCtrlFlag::HasMarketDataSeq, 則會將 book.MarketSeq_ 打包到 rts 之後再發行.
+   /// - 儲存方式與 PublishUpdateBS() 相同, 但儲存的快照為 f9sv_RtsPackType_SnapshotBook;
+   template <class SymbBookDataT>
+   void PublishUpdateBook(const StrView& keyText, SymbBookDataT& book, RevBufferList&& rts, MdSymbsCtrlFlag flags) {
+      PackMktSeq(rts, flags, book.MarketSeq_);
+      this->Publish(keyText, f9sv_RtsPackType_UpdateBook, f9sv_MdRtsKind_BS, book.InfoTime_, std::move(rts));
+      if (this->CheckSnapshotBSTime(book.InfoTime_)) {
+         rts.MoveOut();
+         MdRtsPackSnapshotBook(rts, book.Flags_ | f9sv_BSFlag_OrderBuy | f9sv_BSFlag_OrderSell,
+                               book.Sells_, book.Buys_, book.kDepth);
+         PackMktSeq(rts, flags, book.MarketSeq_);
+         ToBitv(rts, book.InfoTime_);
+         *rts.AllocPacket<uint8_t>() = cast_to_underlying(f9sv_RtsPackType_SnapshotBook);
+      }
+      this->Save(std::move(rts), f9sv_MdRtsKind_BS);
+   }
 
    /// 先把 pkType 打包進 rts: *rts.AllocPacket<uint8_t>() = cast_to_underlying(pkType);
    /// 然後: 發行 & 儲存.
@@ -96,6 +133,8 @@ public:
       , RtsForGvStr_{rts.cfront()} {
    }
    void MakeGridView() const override;
+   /// 直接從 RtsForGvStr_ 建立, 不經過 CacheGV_;
+   void MakeGridViewShared() const override;
 };
 
 } } // namespaces
@@ -5,22 +5,31 @@
 #include "fon9/TimedFileName.hpp"
 #include "fon9/Log.hpp"
 #include "fon9/BitvDecode.hpp"
+#include "fon9/buffer/FwdBufferList.hpp"
 
 namespace fon9 { namespace fmkt {
 
 MdRtSubr::~MdRtSubr() {
+   if (const MdRtConflate* conflate = this->Conflate_.get()) {
+      if (conflate->MergedCount_)
+         fon9_LOG_INFO("MdRtSubr.Conflate"
+                       "|symbid=", conflate->SymbId_,
+                       "|merged=", conflate->MergedCount_,
+                       "|flushed=", conflate->FlushedCount_,
+                       "|dropped=", conflate->PendingCount_);
+   }
 }
 //--------------------------------------------------------------------------//
 MdRtStreamInnMgr::MdRtStreamInnMgr(MdSymbsBase& symbs, std::string rtiPathFmt)
-   : RecoverThread_(rtiPathFmt.empty()
-                    ? nullptr
-                    : new TimerThread{RevPrintTo<std::string>("MdRtsInnMgr:", rtiPathFmt)})
-   , MdSymbs_(symbs)
+   : MdSymbs_(symbs)
    , RtiPathFmt_{std::move(rtiPathFmt)} {
 }
 MdRtStreamInnMgr::~MdRtStreamInnMgr() {
-   if (this->RecoverThread_)
-      this->RecoverThread_->WaitForEndNow();
+   this->DisposeRecovers();
+}
+void MdRtStreamInnMgr::DisposeRecovers() {
+   if (this->RecoverSch_)
+      this->RecoverSch_->DisposeRecovers(*this);
 }
 void MdRtStreamInnMgr::DailyClear(const unsigned tdayYYYYMMDD) {
    assert(this->TDayYYYYMMDD_ < tdayYYYYMMDD);
@@ -71,24 +80,76 @@ static inline bool IsStartTime(DayTime infoTime, DayTime reqTime, DayTime dailyC
    return infoTime >= reqTime;
 }
 
+static void MdRtRecover_OnNotified(MdRtRecover& rec, const seed::SeedNotifyStreamRecoverArgs& e, size_t sz) {
+   if (e.FlowControlKey_)
+      rec.ClientKey_ = e.FlowControlKey_;
+   if (e.FlowControlWait_.GetOrigValue() < 0) // 訂閱者沒有處理此次的回補訊息.
+      return;
+   rec.SliceBytes_ += sz;
+   if (rec.FirstNotifyTime_.IsNullOrZero())
+      rec.FirstNotifyTime_ = UtcNow();
+}
 void MdRtRecover::OnTimer(TimeStamp now) {
    (void)now;
+   this->Mgr_.RecoverSch().OnRecoverTimer(*this);
+}
+TimeInterval MdRtRecover::RunSlice() {
    if (this->RtSubr_->IsUnsubscribed())
-      return;
+      return TimeInterval::Null();
    struct NotifyArgs : public seed::SeedNotifyStreamRecoverArgs {
       fon9_NON_COPY_NON_MOVE(NotifyArgs);
       using base = seed::SeedNotifyStreamRecoverArgs;
       using base::base;
-      using base::CacheGV_;
       PosT  Pos_;
+      /// 回補的封包直接從 Reader(映射的記憶體) 複製到這裡,
+      /// 訂閱者可透過 GetGridViewBuffer() 取走, 不用再經過 std::string 複製.
+      /// 不使用參考映射記憶體的節點(零複製), 因為:
+      /// - 儲存的每個封包前面都有 ChkHeader, 且需依 Filter_ 篩選, 所以要送出的資料並不連續,
+      ///   每個封包(通常只有數十 bytes)都需要一個參考節點, 分配節點的成本高於複製.
+      /// - BufferNodeSharedRef 參考的是 BufferShared(自有的不可變資料), 不是外部的映射記憶體.
+      mutable BufferList   Buffer_;
+      /// 已加入 Buffer_ 的資料量, 即使 Buffer_ 已被取走, 在 Clear() 之前, 此值不變.
+      size_t               BufferSize_{0};
+
+      bool empty() const {
+         return this->BufferSize_ == 0;
+      }
+      void Append(const char* pbeg, const char* pend) {
+         const size_t   sz = static_cast<size_t>(pend - pbeg);
+         FwdBufferNode* back = FwdBufferNode::CastFrom(this->Buffer_.back());
+         if (back == nullptr || back->GetRemainSize() < sz) {
+            back = FwdBufferNode::Alloc(sz < 1024 * 2 ? 1024 * 2 : sz);
+            this->Buffer_.push_back(back);
+         }
+         memcpy(back->GetDataEnd(), pbeg, sz);
+         back->SetDataEnd(back->GetDataEnd() + sz);
+         this->BufferSize_ += sz;
+      }
+      void Clear() {
+         BufferList{std::move(this->Buffer_)};
+         this->CacheGV_.clear();
+         this->BufferSize_ = 0;
+      }
+      BufferList GetGridViewBuffer(const std::string** gv) const override {
+         if (gv)
+            *gv = nullptr;
+         return std::move(this->Buffer_);
+      }
+      void MakeGridView() const override {
+         this->CacheGV_ = BufferTo<std::string>(this->Buffer_);
+      }
    };
    NotifyArgs  nargs(this->Mgr_.MdSymbs_, nullptr/*tab*/,
                      ToStrView(this->Reader_->Key()),
                      nullptr/*rd*/, seed::SeedNotifyKind::StreamRecover);
+   if (!this->IsMapReaderChecked_) {
+      this->IsMapReaderChecked_ = true;
+      this->MapReader_.Open(*this->Reader_, this->EndPos_);
+   }
 
-   // 在沒有流量管制的情況下,
-   // 預設: this->RunAfter(TimeInterval_Millisecond(1)); 大約 1 秒 1000 次回補;
-   // 所以一個回補要求, 沒流量管制時, 最大回補流量 = sizeof(rdbuf) * 1000 bytes / 每秒.
+   // 每個時間片最多處理 sizeof(rdbuf) 的資料量, 然後返回 MdRtRecoverSch 排到佇列尾端.
+   // 若使用 MapReader_, 則每次可處理一個 room 的剩餘資料量(可能大於 sizeof(rdbuf)).
+   // 在沒有流量管制的情況下, 回補流量由 MdRtRecoverSch 的 worker 數量及公平分配決定.
    char     rdbuf[4 * 1024];
    PosT     nextReadPos = nargs.Pos_ = (this->IsStarted_ ? this->LastPos_ : 0);
    size_t   bufofs = 0, errlen = 0;
@@ -104,13 +165,27 @@ void MdRtRecover::OnTimer(TimeStamp now) {
          assert(bufofs == 0);
          break;
       }
-      size_t rdsz = sizeof(rdbuf) - bufofs;
-      assert(rdsz > 0);
-      if (rdsz > szToEnd)
-         rdsz = szToEnd;
       if (this->RtSubr_->IsUnsubscribed())
-         return;
-      rdsz = this->Reader_->Read(nextReadPos, rdbuf + bufofs, rdsz);
+         return TimeInterval::Null();
+      const char* rdbeg = rdbuf;
+      size_t      rdsz;
+      if (bufofs == 0 && this->MapReader_.IsReady()) {
+         // 沒有上次剩餘的資料, 直接使用映射的記憶體, 不用複製.
+         const void* pmem = nullptr;
+         rdsz = this->MapReader_.Peek(nextReadPos, pmem);
+         if (rdsz > szToEnd)
+            rdsz = szToEnd;
+         rdbeg = static_cast<const char*>(pmem);
+      }
+      else {
+         rdsz = sizeof(rdbuf) - bufofs;
+         assert(rdsz > 0);
+         if (rdsz > szToEnd)
+            rdsz = szToEnd;
+         rdsz = (this->MapReader_.IsReady()
+                 ? this->MapReader_.Read(nextReadPos, rdbuf + bufofs, rdsz)
+                 : this->Reader_->Read(nextReadPos, rdbuf + bufofs, rdsz));
+      }
       if (rdsz <= 0) {
          fon9_LOG_ERROR("MdRtStream.Read|key=", nargs.KeyText_,
                         "|err=Read 0"
@@ -120,8 +195,8 @@ void MdRtRecover::OnTimer(TimeStamp now) {
       }
       nextReadPos += rdsz;
 
-      const char* const rdend = rdbuf + bufofs + rdsz;
-      DcQueueFixedMem   dcq{rdbuf, rdend};
+      const char* const rdend = rdbeg + bufofs + rdsz;
+      DcQueueFixedMem   dcq{rdbeg, rdend};
       // ChkHeader 儲存的內容, 請參考 MdRtStream::Save();
       constexpr auto    kChkHeaderSize = sizeof(MdRtStreamInn_ChkValueType) + sizeof(f9sv_MdRtsKind);
       const char*       pchk;
@@ -185,35 +260,34 @@ void MdRtRecover::OnTimer(TimeStamp now) {
             dcq.PopConsumed(1);
             continue;
          }
-         if (nargs.CacheGV_.empty()) // 保留 pos, 若訂閱者流量管制, 則從 pos 開始.
+         if (nargs.empty()) // 保留 pos, 若訂閱者流量管制, 則從 pos 開始.
             nargs.Pos_ = currChkPos;
-         // 包含長度的完整封包訊息, 加入到 nargs.CacheGV_;
-         nargs.CacheGV_.append(pchk + kChkHeaderSize, reinterpret_cast<const char*>(dcq.Peek1() + pksz));
+         // 包含長度的完整封包訊息, 加入到 nargs.Buffer_;
+         nargs.Append(pchk + kChkHeaderSize, reinterpret_cast<const char*>(dcq.Peek1() + pksz));
          // 回補通知. 多筆打包一次(增加回補效率).
-         if (nargs.CacheGV_.size() > 1024) { // MTU = 1500?
-            {  // lock tree: 確保可以安全的使用 this->RtSubr_;
-               auto  treelk{this->Mgr_.MdSymbs_.SymbMap_.ConstLock()};
+         if (nargs.BufferSize_ > 1024) { // MTU = 1500?
+            {  // lock tree(商品所在的 shard): 確保可以安全的使用 this->RtSubr_;
+               auto  treelk{this->Mgr_.MdSymbs_.GetSymbShard(nargs.KeyText_).ConstLock()};
                if (this->RtSubr_->IsUnsubscribed())
-                  return;
+                  return TimeInterval::Null();
                this->RtSubr_(nargs);
             }  // unlock tree.
+            MdRtRecover_OnNotified(*this, nargs, nargs.BufferSize_);
             if (fon9_UNLIKELY(!nargs.FlowControlWait_.IsNullOrZero())) {
                if (nargs.FlowControlWait_.GetOrigValue() < 0) {
                   // 強制流量管制, 結束此次回補, 設定下次回補時間.
                   nargs.FlowControlWait_.SetOrigValue(-nargs.FlowControlWait_.GetOrigValue());
                   this->LastPos_ = nargs.Pos_;
-                  this->RunAfter(nargs.FlowControlWait_);
-                  return;
+                  return nargs.FlowControlWait_;
                }
                // 返回 nargs.FlowControlWait_.GetOrigValue() > 0;
                // 不接受流量管制的建議, 每次從 this->Reader_ 讀入的資料, 必須優先處理完.
                // else {
                //    this->LastPos_ = currChkPos + (reinterpret_cast<const char*>(dcq.Peek1()) - pchk);
-               //    this->RunAfter(nargs.FlowControlWait_);
-               //    return;
+               //    return nargs.FlowControlWait_;
                // }
             }
-            nargs.CacheGV_.clear();
+            nargs.Clear();
             nargs.StreamDataKind_ = 0;
             nargs.Pos_ = currChkPos;
          }
@@ -222,7 +296,8 @@ void MdRtRecover::OnTimer(TimeStamp now) {
          dcq.PopConsumed(pksz);
       }
       bufofs = dcq.CalcSize();
-      if (this->IsStarted_) {
+      // 若映射記憶體(room)的尾端, 剩餘不足一個封包, 則必須複製到 rdbuf, 與下一個 room 的資料合併.
+      if (this->IsStarted_ && (rdbeg == rdbuf || bufofs == 0)) {
          // 一旦已經找到開始位置, 且已處理了 block: sizeof(rdbuf);
          // 則暫時離開回補迴圈:
          // - 讓其他回補要求有機會執行.
@@ -243,43 +318,42 @@ void MdRtRecover::OnTimer(TimeStamp now) {
                      "|len=", errlen);
    }
    // 回補完畢通知, 訂閱者需注意:
-   // - e.CacheGV_ 可能還有一些「未使用 StreamRecover 通知」的回補訊息,
+   // - e.GetGridViewBuffer() 可能還有一些「未使用 StreamRecover 通知」的回補訊息,
    //   在此會使用 StreamRecoverEnd 送出.
    // - 可參考 fon9/rc/RcMdRtsDecoder.cpp: DecodeStreamRecoverEnd() 的做法.
-   { // lock tree: 確保可以安全的使用 this->RtSubr_;
-      auto  treelk{this->Mgr_.MdSymbs_.SymbMap_.ConstLock()};
+   { // lock tree(商品所在的 shard): 確保可以安全的使用 this->RtSubr_;
+      auto  treelk{this->Mgr_.MdSymbs_.GetSymbShard(nargs.KeyText_).ConstLock()};
       if (this->RtSubr_->IsUnsubscribed())
-         return;
+         return TimeInterval::Null();
       if (nextReadPos >= this->EndPos_) {
          nargs.NotifyKind_ = seed::SeedNotifyKind::StreamRecoverEnd;
          // 必須設定 StreamDataKind_, 避免 RtFilter_ 濾掉, 而沒有通知 StreamRecoverEnd;
          nargs.StreamDataKind_ = f9sv_MdRtsKind_Full;
       }
-      else if (nargs.CacheGV_.empty()) {
-         treelk.unlock();
-         this->RunAfter(TimeInterval_Millisecond(1));
-         return;
+      else if (nargs.empty()) {
+         return TimeInterval{};
       }
       this->RtSubr_(nargs);
    } // unlock tree.
+   MdRtRecover_OnNotified(*this, nargs, nargs.BufferSize_);
 
    if (fon9_LIKELY(nargs.FlowControlWait_.IsNullOrZero())) {
       if (nargs.NotifyKind_ != seed::SeedNotifyKind::StreamRecoverEnd)
-         this->RunAfter(TimeInterval_Millisecond(1));
-      return;
+         return TimeInterval{};
+      return TimeInterval::Null();
    }
    // 有流量管制, 設定下次回補時間.
    if (nargs.FlowControlWait_.GetOrigValue() < 0) {
       nargs.FlowControlWait_.SetOrigValue(-nargs.FlowControlWait_.GetOrigValue());
       this->LastPos_ = ((nargs.NotifyKind_ == seed::SeedNotifyKind::StreamRecoverEnd
-                         && nargs.CacheGV_.empty())
+                         && nargs.empty())
                         ? this->EndPos_ : nargs.Pos_);
    }
    else { // 有流量管制, 但 nargs 的內容已處理.
       if (nargs.NotifyKind_ == seed::SeedNotifyKind::StreamRecoverEnd)
-         return;
+         return TimeInterval::Null();
    }
-   this->RunAfter(nargs.FlowControlWait_);
+   return nargs.FlowControlWait_;
 }
 
 } } // namespaces
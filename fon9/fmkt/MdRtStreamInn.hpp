@@ -3,6 +3,7 @@
 #ifndef __fon9_fmkt_MdRtStreamInn_hpp__
 #define __fon9_fmkt_MdRtStreamInn_hpp__
 #include "fon9/fmkt/MdRtsTypes.hpp"
+#include "fon9/fmkt/MdRtRecoverSch.hpp"
 #include "fon9/fmkt/SymbTree.hpp"
 #include "fon9/buffer/RevBufferList.hpp"
 #include "fon9/InnApf.hpp"
@@ -11,6 +12,10 @@
 namespace fon9 { namespace fmkt {
 
 class fon9_API MdSymbsBase;
+#ifndef NDEBUG
+/// 用於 assert(): tree 必須是 MdSymbsBase, 檢查 symbid 所在的 shard 是否已鎖定.
+fon9_API bool MdSymbs_IsSymbLocked(seed::Tree& tree, const StrView& symbid);
+#endif
 
 // MdRts 封包儲存到 Inn 時.
 // 在封包前端放 4 bytes(uint32_t, big endian) = 實際的位置, 當成檢查碼.
@@ -27,9 +32,10 @@ class fon9_API MdRtStreamInnMgr {
    char     Padding______[4];
    InnApfSP RtInn_;
    DayTime  DailyClearTime_;
+   /// 在首次回補時取得: GetDefaultMdRtRecoverSch();
+   MdRtRecoverSchSP  RecoverSch_;
 
 public:
-   const TimerThreadSP  RecoverThread_;
    MdSymbsBase&         MdSymbs_;
    const std::string    RtiPathFmt_;
 
@@ -39,6 +45,10 @@ public:
    MdRtStreamInnMgr(MdSymbsBase& symbs, std::string rtiPathFmt);
    ~MdRtStreamInnMgr();
 
+   /// 放棄尚未完成的回補, 並等候執行中的時間片結束.
+   /// 回補時會鎖定 MdSymbs_ 的 shard, 所以 MdSymbs 必須在 shards 解構前呼叫.
+   void DisposeRecovers();
+
    unsigned TDayYYYYMMDD() const {
       return this->TDayYYYYMMDD_;
    }
@@ -53,11 +63,53 @@ public:
    }
 
    InnApf::OpenResult RtOpen(InnApf::StreamRW& rw, const Symb& symb);
+
+   /// 若尚未取得回補排程, 則使用 GetDefaultMdRtRecoverSch();
+   MdRtRecoverSch& RecoverSch() {
+      if (fon9_UNLIKELY(!this->RecoverSch_))
+         this->RecoverSch_ = GetDefaultMdRtRecoverSch();
+      return *this->RecoverSch_;
+   }
 };
 //--------------------------------------------------------------------------//
+/// 合併模式(conflate)的訂閱狀態: 訂閱者忙碌時, 可合併的異動不送出,
+/// 每個 symbol 的每個 tab 最多保留 1 筆待送的異動(僅記錄種類),
+/// 等訂閱者不忙碌時, 再送出該 tab 的最新狀態(f9sv_RtsPackType_TabValues_AndInfoTime).
+/// 所有的操作 symb tree 必定處在 lock 狀態.
+struct MdRtConflate {
+   fon9_NON_COPY_NON_MOVE(MdRtConflate);
+   /// 可合併的異動種類, 目前僅支援 f9sv_MdRtsKind_BS, f9sv_MdRtsKind_Deal;
+   const f9sv_MdRtsKind Kinds_;
+   /// 等候送出最新狀態的異動種類.
+   f9sv_MdRtsKind       PendingKinds_{};
+   /// 是否已啟動 timer, 在訂閱者不忙碌時送出最新狀態.
+   bool                 IsFlushScheduled_{false};
+   char                 Padding___[3];
+   /// 用來確認 timer 觸發時, 商品是否仍是訂閱時的商品.
+   Symb* const          Symb_;
+   const CharVector     SymbId_;
+   /// 被合併(沒有單獨送出)的異動數量.
+   uint64_t             MergedCount_{0};
+   /// 尚未送出最新狀態的合併數量, 若取消訂閱時仍有, 則視為 Dropped.
+   uint64_t             PendingCount_{0};
+   /// 送出最新狀態的次數.
+   uint64_t             FlushedCount_{0};
+
+   MdRtConflate(f9sv_MdRtsKind kinds, Symb& symb)
+      : Kinds_{kinds}
+      , Symb_{&symb}
+      , SymbId_{symb.SymbId_} {
+   }
+};
+using MdRtConflateUP = std::unique_ptr<MdRtConflate>;
+/// 合併模式可合併的異動種類.
+constexpr f9sv_MdRtsKind kMdRtConflatableKinds = f9sv_MdRtsKind_BS | f9sv_MdRtsKind_Deal;
+
 struct fon9_API MdRtSubr : public intrusive_ref_counter<MdRtSubr> {
    f9sv_MdRtsKind    RtFilter_{f9sv_MdRtsKind_Full};
    seed::FnSeedSubr  Callback_;
+   /// 訂閱參數有要求合併模式時才會建立, 請參考 MdRtStream::SubscribeStream();
+   MdRtConflateUP    Conflate_;
    /// 從 args 取出 RtFiller_ = f9sv_MdRtsKind(hex): empty() or 0 表示訂閱全部的即時訊息;
    /// 並移動 args->begin() 到後面的參數位置.
    MdRtSubr(seed::FnSeedSubr&& sub, StrView* args)
@@ -72,16 +124,27 @@ struct fon9_API MdRtSubr : public intrusive_ref_counter<MdRtSubr> {
    void SetUnsubscribed() {
       this->RtFilter_ = f9sv_MdRtsKind{};
    }
+
+   /// 合併模式的通知, 由 MdRtSubrSP::operator() 呼叫.
+   /// - 可合併的異動: 若訂閱者忙碌, 則記錄在 Conflate_->PendingKinds_, 並啟動 timer;
+   /// - 若已有相同種類的待送異動, 則直接送出最新狀態(取代此次異動).
+   void ConflateNotify(const seed::SeedNotifyArgs& e);
+   /// 送出 Conflate_->PendingKinds_ 的最新狀態, 若訂閱者仍忙碌則返回 false;
+   bool FlushConflated(seed::Tree& tree, const StrView& keyText);
 };
 struct MdRtSubrSP : public intrusive_ptr<MdRtSubr> {
    using base = intrusive_ptr<MdRtSubr>;
    using base::base;
    /// 呼叫前必須: lock tree, 檢查 IsUnsubscribed();
    void operator()(const seed::SeedNotifyArgs& e) const {
-      assert(static_cast<MdSymbTree*>(&e.Tree_)->SymbMap_.IsLocked());
+      assert(MdSymbs_IsSymbLocked(e.Tree_, e.KeyText_));
       assert(!this->get()->IsUnsubscribed());
-      if (IsEnumContainsAny(this->get()->RtFilter_, static_cast<f9sv_MdRtsKind>(e.StreamDataKind_)))
-         this->get()->Callback_(e);
+      if (IsEnumContainsAny(this->get()->RtFilter_, static_cast<f9sv_MdRtsKind>(e.StreamDataKind_))) {
+         if (fon9_LIKELY(!this->get()->Conflate_))
+            this->get()->Callback_(e);
+         else
+            this->get()->ConflateNotify(e);
+      }
    }
 };
 using MdRtUnsafeSubj = seed::UnsafeSeedSubjT<MdRtSubrSP>;
@@ -105,9 +168,33 @@ struct MdRtRecover : public TimerEntry {
    const MdRtSubrSP  RtSubr_;
    const StreamSP    Reader_;
    f9sv_MdRtsKind    Filter_{};
-   char              Padding___[3];
+   bool              IsMapReaderChecked_{false};
    bool              IsStarted_{false};
 
+   // 底下的 Sch* 由 MdRtRecoverSch 在 lock 狀態下使用.
+   enum class SchSt : uint8_t {
+      None,
+      Ready,
+      Running,
+      Waiting,
+      Done,
+   };
+   SchSt             SchSt_{SchSt::None};
+   MdRtRecoverClass  SchClass_{MdRtRecoverClass::Replay};
+   bool              SchIsDisposed_{false};
+   bool              SchIsTtfbCounted_{false};
+   /// 目前排程使用的 client key;
+   const void*       SchClientKey_{};
+   TimeStamp         SchStartTime_;
+
+   // 底下的資料由 RunSlice() 設定, 在時間片結束後由 MdRtRecoverSch 取用.
+   /// 訂閱者透過 SeedNotifyStreamRecoverArgs::FlowControlKey_ 告知的 client key;
+   const void*       ClientKey_{};
+   /// 首次送出回補訊息的時間.
+   TimeStamp         FirstNotifyTime_;
+   /// 此次時間片送出的資料量.
+   uint64_t          SliceBytes_{0};
+
    /// IsStarted_ == false 使用 StartInfoTime_;
    /// IsStarted_ == true 使用 LastPos_;
    union {
@@ -125,6 +212,10 @@ struct MdRtRecover : public TimerEntry {
    /// 訂閱者必須能處理「回補與即時」交錯回報的情況.
    PosT  EndPos_{};
 
+   /// 若可使用 FileMap, 則直接從映射的記憶體取得回補資料, 不用經過 Reader_->Read();
+   /// 在首次 OnTimer() 時, 載入 [0..EndPos_) 在檔案中的位置.
+   InnApf::StreamMapReader MapReader_;
+
    using MdRtRecoverSP = intrusive_ptr<MdRtRecover>;
    inline static MdRtRecoverSP Make(MdRtStreamInnMgr& mgr, MdRtSubrSP subr, StreamSP reader) {
       if (reader.get() == nullptr)
@@ -146,7 +237,7 @@ struct MdRtRecover : public TimerEntry {
 private:
    fon9_MSC_WARN_DISABLE(4582) // 'StartInfoTime_' : constructor is not implicitly called
    MdRtRecover(MdRtStreamInnMgr& mgr, MdRtSubrSP subr, StreamSP reader)
-      : TimerEntry{mgr.RecoverThread_}
+      : TimerEntry{mgr.RecoverSch().TimerThread_}
       , Mgr_(mgr)
       , RtSubr_{std::move(subr)}
       , Reader_{std::move(reader)} {
@@ -154,7 +245,15 @@ private:
    }
    fon9_MSC_WARN_POP;
 
+   /// 流量管制的延遲時間到, 交給 MdRtRecoverSch 排入佇列.
    void OnTimer(TimeStamp now) override;
+
+   friend class MdRtRecoverSch;
+   /// 由 MdRtRecoverSch 的 worker 呼叫, 執行一個時間片.
+   /// - 返回 TimeInterval::Null(): 回補結束(或已取消訂閱);
+   /// - 返回 TimeInterval{}: 尚未結束, 排到佇列尾端, 等候下一個時間片;
+   /// - 返回 > 0: 流量管制, 延遲指定時間後再排入佇列.
+   TimeInterval RunSlice();
 };
 using MdRtRecoverSP = intrusive_ptr<MdRtRecover>;
 
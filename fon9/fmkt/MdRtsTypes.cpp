@@ -45,6 +45,27 @@ fon9_API void MdRtsPackSnapshotBS(RevBuffer& rbuf, const SymbBSData& symbBS) {
       MdRtsPackOrderBS(rbuf, RtBSType::OrderBuy, symbBS.Buys_);
 }
 
+/// 將委託簿「買方 or 賣方」的 pqs[depth] 依照 f9sv_RtsPackType_SnapshotBook 的格式填入 rbuf;
+static void MdRtsPackBookSide(RevBuffer& rbuf, const PriQty* pqs, unsigned depth) {
+   unsigned count = 0;
+   while (count < depth && pqs[count].Qty_ != 0)
+      ++count;
+   for (unsigned idx = count; idx > 0;) {
+      --idx;
+      ToBitv(rbuf, pqs[idx].Qty_);
+      ToBitv(rbuf, pqs[idx].Pri_);
+   }
+   ToBitv(rbuf, count);
+}
+fon9_API void MdRtsPackSnapshotBook(RevBuffer& rbuf, f9sv_BSFlag bsFlags,
+                                    const PriQty* sells, const PriQty* buys, unsigned depth) {
+   if (IsEnumContains(bsFlags, f9sv_BSFlag_OrderBuy))
+      MdRtsPackBookSide(rbuf, buys, depth);
+   if (IsEnumContains(bsFlags, f9sv_BSFlag_OrderSell))
+      MdRtsPackBookSide(rbuf, sells, depth);
+   *rbuf.AllocPacket<uint8_t>() = static_cast<uint8_t>(bsFlags & (f9sv_BSFlag_Calculated | f9sv_BSFlag_OrderBuy | f9sv_BSFlag_OrderSell));
+}
+
 fon9_API void MdRtsPackTabValues(RevBuffer& rbuf, const seed::Tab& tab, const SymbData& dat) {
    assert(unsigned_cast(tab.GetIndex()) <= 0xff);
    seed::SimpleRawRd rd{dat};
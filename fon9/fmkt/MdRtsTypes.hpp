@@ -4,6 +4,7 @@
 #define __fon9_fmkt_MdRtsTypes_hpp__
 #include "fon9/fmkt/FmktTypes.hpp"
 #include "fon9/fmkt/FmdRtsPackType.h"
+#include "fon9/fmkt/FmdTypes.h"
 #include "fon9/seed/Tab.hpp"
 #include "fon9/TimeStamp.hpp"
 
@@ -62,6 +63,12 @@ struct SymbBSData;
 
 fon9_API void MdRtsPackSnapshotBS(RevBuffer& rbuf, const SymbBSData& symbBS);
 
+/// 用 f9sv_RtsPackType_SnapshotBook 格式打包 bsFlags, sells[depth], buys[depth];
+/// - 從 bsFlags 取出 Calculated, OrderSell, OrderBuy 旗標;
+/// - 「不包含」最後的 MktSeq, InfoTime, f9sv_RtsPackType_SnapshotBook;
+fon9_API void MdRtsPackSnapshotBook(RevBuffer& rbuf, f9sv_BSFlag bsFlags,
+                                    const PriQty* sells, const PriQty* buys, unsigned depth);
+
 /// 用 f9sv_RtsPackType_TabValues 格式打包 dat.
 /// - 「不包含」最後的 *rbuf.AllocPacket<uint8_t>() = cast_to_underlying(f9sv_RtsPackType_TabValues);
 /// - 可以呼叫多次 MdRtsPackTabValues() 打包不同的 tab;
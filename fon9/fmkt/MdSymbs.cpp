@@ -1,11 +1,15 @@
 ﻿// \file fon9/fmkt/MdSymbs.cpp
 // \author fonwinz@gmail.com
 #include "fon9/fmkt/MdSymbs.hpp"
-#include "fon9/FileReadAll.hpp"
+#include "fon9/DefaultThreadPool.hpp"
 #include "fon9/Log.hpp"
 #include "fon9/BitvDecode.hpp"
 #include "fon9/seed/RawWr.hpp"
 
+fon9_BEFORE_INCLUDE_STD;
+#include <thread>
+fon9_AFTER_INCLUDE_STD;
+
 namespace fon9 { namespace fmkt {
 
 void fon9_API SymbCellsToBitv(RevBuffer& rbuf, seed::Layout& layout, Symb& symb) {
@@ -57,8 +61,8 @@ struct MdSymbsBase::Recover : public TimerEntry {
             return this->AckBuf_.MoveOut();
          }
       };
-      NotifyArgs  nargs(this->MdSymbs_);
-      auto        symbsLk = this->MdSymbs_.SymbMap_.ConstLock();
+      NotifyArgs     nargs(this->MdSymbs_);
+      AllSymbsLocker symbsLk{this->MdSymbs_};
       auto&       symbsRe = this->Subr_->SymbsRecovering_;
       SymbSP      keeps[100];
       unsigned    keepi = 0;
@@ -109,13 +113,54 @@ struct MdSymbsBase::Recover : public TimerEntry {
    }
 };
 //--------------------------------------------------------------------------//
+#ifndef NDEBUG
+fon9_API bool MdSymbs_IsSymbLocked(seed::Tree& tree, const StrView& symbid) {
+   return static_cast<MdSymbsBase*>(&tree)->IsSymbLocked(symbid);
+}
+#endif
+MdSymbsBase::AllSymbsLocker::AllSymbsLocker(MdSymbsBase& owner) : Owner_(owner) {
+   this->Lockers_.reserve(owner.SymbShardCount_);
+   for (unsigned L = 0; L < owner.SymbShardCount_; ++L)
+      this->Lockers_.emplace_back(owner.GetSymbShardAt(L).Lock());
+}
+MdSymbsBase::AllSymbsLocker::~AllSymbsLocker() {
+   this->unlock();
+}
+void MdSymbsBase::AllSymbsLocker::unlock() {
+   for (size_t L = this->Lockers_.size(); L > 0;) {
+      Locker& lk = this->Lockers_[--L];
+      if (lk.owns_lock())
+         lk.unlock();
+   }
+}
+size_t MdSymbsBase::AllSymbsLocker::size() const {
+   size_t retval = 0;
+   for (const Locker& lk : this->Lockers_)
+      retval += lk->size();
+   return retval;
+}
+Symb* MdSymbsBase::AllSymbsLocker::GetSymb(const StrView& symbid) const {
+   const Locker& lk = this->Lockers_[this->Owner_.GetSymbShardIndex(symbid)];
+   auto          ifind = lk->find(symbid);
+   return ifind == lk->end() ? nullptr : &GetSymbValue(*ifind);
+}
+SymbSP MdSymbsBase::AllSymbsLocker::FetchSymb(const StrView& symbid) {
+   const Locker& lk = this->Lockers_[this->Owner_.GetSymbShardIndex(symbid)];
+   auto          ifind = lk->find(symbid);
+   if (ifind != lk->end())
+      return SymbSP{&GetSymbValue(*ifind)};
+   return InsertSymb(*lk, this->Owner_.MakeSymbBeforeInsert(symbid, &lk));
+}
+//--------------------------------------------------------------------------//
 MdSymbsBase::~MdSymbsBase() {
 }
 void MdSymbsBase::DailyClear(unsigned tdayYYYYMMDD) {
-   auto symbs = this->SymbMap_.Lock();
+   AllSymbsLocker symbs{*this};
+   this->IsSnapshotAllDirty_ = true;
    this->IsDailyClearing_ = true;
    this->RtInnMgr_.DailyClear(tdayYYYYMMDD);
-   this->LockedDailyClear(symbs, tdayYYYYMMDD);
+   for (unsigned L = 0; L < this->SymbShardCount_; ++L)
+      MdSymbMapDailyClear(*this, *symbs[L], tdayYYYYMMDD);
    this->IsDailyClearing_ = false;
    if (this->UnsafeSubj_.IsEmpty())
       return;
@@ -127,10 +172,36 @@ void MdSymbsBase::DailyClear(unsigned tdayYYYYMMDD) {
    RevPutBitv(rts, fon9_BitvV_NumberNull); // DayTime::Null();
    *rts.AllocPacket<uint8_t>() = cast_to_underlying(f9sv_RtsPackType_TradingSessionId);
    MdRtsNotifyArgs  e{*this, fon9_kCSTR_SubrTree, f9sv_MdRtsKind_All_AndInfoTime, rts};
+   // 已鎖定全部的 shards, 不會有其他 thread 同時發行, 所以不用鎖定 TreeMutex_;
    this->UnsafeSubj_.Publish(e);
 }
+void MdSymbsBase::UnsafeUpdateBars(Symb& symb, const SymbDealData& deal) {
+   assert(this->IsSymbLocked(ToStrView(symb.SymbId_)));
+   if (this->BarsTab_ == nullptr || this->BarsTab_->Intervals_.Count_ == 0 || this->RtTab_ == nullptr)
+      return;
+   auto* bars = static_cast<SymbBars*>(symb.GetSymbData(static_cast<int>(this->BarsTab_->GetIndex())));
+   auto* rts = static_cast<MdRtStream*>(symb.GetSymbData(static_cast<int>(this->RtTab_->GetIndex())));
+   unsigned closedMask;
+   if (bars == nullptr || rts == nullptr || !bars->OnDeal(this->BarsTab_->Intervals_, deal, closedMask))
+      return;
+   const StrView keyText = ToStrView(symb.SymbId_);
+   if (closedMask) {
+      RevBufferList rbuf{128};
+      MdRtsPackBars(rbuf, *bars, closedMask, true);
+      rts->Publish(keyText, f9sv_RtsPackType_BarClosed, f9sv_MdRtsKind_Bar, deal.InfoTime_, std::move(rbuf));
+   }
+   if (rts->IsSubjEmpty() && this->UnsafeSubj_.IsEmpty())
+      return;
+   RevBufferList rbuf{128};
+   MdRtsPackBars(rbuf, *bars, (1u << this->BarsTab_->Intervals_.Count_) - 1, false);
+   rts->PublishRtOnly(keyText, f9sv_RtsPackType_BarUpdate, f9sv_MdRtsKind_Bar, deal.InfoTime_, std::move(rbuf));
+}
 void MdSymbsBase::UnsafePublish(f9sv_RtsPackType pkType, seed::SeedNotifyArgs& e) {
-   assert(this->SymbMap_.IsLocked());
+   assert(this->IsSymbLocked(e.KeyText_));
+   // 商品的異動已由 MdRtStream 設定 IsSnapshotDirty_; 這裡只需記錄移除.
+   // 在 IsBlockPublish_ 檢查之前記錄, 因為 BlockPublish 期間各商品的異動仍會來到此處.
+   if (pkType == f9sv_RtsPackType_Count && e.NotifyKind_ == seed::SeedNotifyKind::PodRemoved)
+      this->UnsafeMarkSnapshotRemoved(e.KeyText_);
    // IsDailyClearing_ 時, 有可能 f9sv_RtsPackType_TradingSessionId 或 PodRemoved(商品過期被移除)
    // 所以這裡要讓 PodRemoved 送給 tree 的訂閱者,
    // 但 TradingSessionId 由 MdSymbsBase::DailyClear() 送出一次, 不要每個商品都送一次.
@@ -145,7 +216,12 @@ void MdSymbsBase::UnsafePublish(f9sv_RtsPackType pkType, seed::SeedNotifyArgs& e
    //   - f9sv_RtsPackType_DealBS, f9sv_RtsPackType_DealPack 一般情況不包含 TotalQty;
    //   - 在沒有 TotalQtyLost 的情況下, TotalQty 由 Client 自行計算.
    // - f9sv_RtsPackType_UpdateBS
-   this->UnsafeSubj_.Publish(e);
+   if (fon9_LIKELY(this->SymbShardCount_ == 1))
+      this->UnsafeSubj_.Publish(e);
+   else {
+      std::lock_guard<std::mutex> lk{this->TreeMutex_};
+      this->UnsafeSubj_.Publish(e);
+   }
 }
 seed::OpResult MdSymbsBase::SubscribeStream(SubConn* pSubConn, seed::Tab& tab, StrView args, seed::FnSeedSubr&& fnSubr) {
    if (!IsEnumContains(this->CtrlFlags_, MdSymbsCtrlFlag::AllowSubrTree) || &tab != this->RtTab_)
@@ -168,15 +244,22 @@ seed::OpResult MdSymbsBase::SubscribeStream(SubConn* pSubConn, seed::Tab& tab, S
    else if (!args.empty())
       return seed::OpResult::bad_subscribe_stream_args;
    // -----
-   auto  symbslk = this->SymbMap_.ConstLock();
+   AllSymbsLocker symbslk{*this};
    this->UnsafeSubj_.Subscribe(pSubConn, psub);
    // -----
    // 訂閱成功的通知.
    psub(seed::SeedNotifySubscribeOK{*this, nullptr/*tab*/, seed::TextBegin(), nullptr/*rd*/, seed::SeedNotifyKind::SubscribeStreamOK});
    if (isSubrGetAll) {
       TimeStamp tmbeg = UtcNow();
-      psub->SymbsRecovering_ = *symbslk;
-      fon9_LOG_INFO("MdSymbs.SubrTree|spend=", UtcNow() - tmbeg, "|symbCount=", symbslk->size());
+      if (this->SymbShardCount_ == 1)
+         psub->SymbsRecovering_ = *symbslk[0];
+      else {
+         auto& symbsRe = psub->SymbsRecovering_;
+         symbsRe.reserve(symbslk.size());
+         for (unsigned L = 0; L < this->SymbShardCount_; ++L)
+            symbsRe.insert(symbslk[L]->begin(), symbslk[L]->end());
+      }
+      fon9_LOG_INFO("MdSymbs.SubrTree|spend=", UtcNow() - tmbeg, "|symbCount=", psub->SymbsRecovering_.size());
       intrusive_ptr<Recover>  recover{new Recover(*this, psub)};
       symbslk.unlock();
       recover->RunAfter(TimeInterval{});
@@ -186,30 +269,148 @@ seed::OpResult MdSymbsBase::SubscribeStream(SubConn* pSubConn, seed::Tab& tab, S
 seed::OpResult MdSymbsBase::UnsubscribeStream(SubConn* pSubConn, seed::Tab& tab) {
    if (&tab != this->RtTab_)
       return seed::OpResult::not_supported_subscribe_stream;
-   auto   symbslk = this->SymbMap_.ConstLock();
+   AllSymbsLocker symbslk{*this};
    return MdRtUnsafeSubj_UnsubscribeStream(this->UnsafeSubj_, pSubConn);
 }
 //--------------------------------------------------------------------------//
+/// 每次鎖定商品表處理的商品數量.
+static constexpr size_t kSnapshotBatchSize = 256;
+
+/// 記錄格式: ByteArraySize + SymbId + 全部欄位;
+/// symb == nullptr 表示「移除」記錄: ByteArraySize + SymbId;
+static void AppendSymbRecord(std::string& wrbuf, seed::Layout& layout, const StrView& symbid, Symb* symb) {
+   RevBufferFixedSize<2048> rbuf;
+   if (symb)
+      SymbCellsToBitv(rbuf, layout, *symb);
+   ToBitv(rbuf, symbid);
+   ByteArraySizeToBitvT(rbuf, rbuf.GetUsedSize());
+   wrbuf.append(rbuf.GetCurrent(), rbuf.GetMemEnd());
+}
 void MdSymbsBase::SaveTo(std::string fname) {
+   this->SaveSnapshotImpl(std::move(fname), false);
+}
+File::Result MdSymbsBase::SaveSnapshotImpl(std::string fname, bool isIncremental) {
+   std::lock_guard<std::mutex> saveLk{this->SnapshotSaveMutex_};
+   const TimeStamp            tmbeg = UtcNow();
+   std::vector<SymbSP>        symbs;
+   std::vector<std::string>   removed;
+   bool                       isFull = true;
+   {
+      AllSymbsLocker symbsLk{*this};
+      if (isIncremental) {
+         this->IsSnapshotTracking_ = true;
+         isFull = (this->IsSnapshotAllDirty_
+                   || this->RtTab_ == nullptr
+                   || this->SnapshotFileName_ != fname
+                   || this->SnapshotAppended_ > symbsLk.size());
+         if (!isFull)
+            removed.swap(this->SnapshotRemoved_);
+         else
+            this->SnapshotRemoved_.clear();
+         this->IsSnapshotAllDirty_ = false;
+      }
+      // 已鎖定全部的 shards, 可以直接檢查並清除 MdRtStream::IsSnapshotDirty_;
+      // SaveTo() 不影響增量快照, 所以不清除.
+      const int rtTabIdx = (this->RtTab_ && isIncremental ? static_cast<int>(this->RtTab_->GetIndex()) : -1);
+      if (isFull)
+         symbs.reserve(symbsLk.size());
+      symbsLk.ForEachSymb([&symbs, isFull, rtTabIdx](Symb& symb) {
+         bool isDirty = isFull;
+         if (rtTabIdx >= 0) {
+            if (auto* rts = static_cast<MdRtStream*>(symb.GetSymbData(rtTabIdx))) {
+               isDirty |= rts->IsSnapshotDirty_;
+               rts->IsSnapshotDirty_ = false;
+            }
+         }
+         if (isDirty)
+            symbs.emplace_back(&symb);
+      });
+   }
    File fd;
-   auto res = fd.Open(fname, FileMode::CreatePath | FileMode::Trunc | FileMode::Append);
+   auto res = fd.Open(fname, isFull ? (FileMode::CreatePath | FileMode::Trunc | FileMode::Append)
+                                    : (FileMode::CreatePath | FileMode::OpenAlways | FileMode::Append));
+   const size_t   recCount = symbs.size() + removed.size();
+   std::string    wrbuf;
+   for (size_t ibeg = 0; !res.IsError() && ibeg < recCount; ibeg += kSnapshotBatchSize) {
+      const size_t iend = std::min(ibeg + kSnapshotBatchSize, recCount);
+      wrbuf.clear();
+      {
+         AllSymbsLocker symbsLk{*this};
+         for (size_t L = ibeg; L < iend; ++L) {
+            if (L < symbs.size())
+               AppendSymbRecord(wrbuf, *this->LayoutSP_, ToStrView(symbs[L]->SymbId_), symbs[L].get());
+            else {
+               // 移除後可能又再次加入, 所以要用現在的商品表判斷.
+               const StrView  symbid{&removed[L - symbs.size()]};
+               AppendSymbRecord(wrbuf, *this->LayoutSP_, symbid, symbsLk.GetSymb(symbid));
+            }
+         }
+      }
+      res = fd.Append(ToStrView(wrbuf));
+   }
    if (res.IsError()) {
       fon9_LOG_ERROR("MdSymbs.SaveTo|fname=", fname, '|', res);
-      return;
+      if (isIncremental) {
+         AllSymbsLocker symbsLk{*this};
+         this->IsSnapshotAllDirty_ = true;
+      }
+      return res;
    }
-   std::string                wrbuf;
-   RevBufferFixedSize<2048>   rbuf;
-   auto symbs = this->SymbMap_.ConstLock();
-   for (const auto& isymb : *symbs) {
-      rbuf.Rewind();
-      SymbCellsToBitv(rbuf, *this->LayoutSP_, *isymb.second);
-      ToBitv(rbuf, isymb.first); // SymbId;
-      ByteArraySizeToBitvT(rbuf, rbuf.GetUsedSize());
-      wrbuf.append(rbuf.GetCurrent(), rbuf.GetMemEnd());
+   if (isIncremental) {
+      this->SnapshotAppended_ = (isFull ? 0 : this->SnapshotAppended_ + recCount);
+      this->SnapshotFileName_ = std::move(fname);
+      fon9_LOG_INFO("MdSymbs.SaveSnapshot|fname=", this->SnapshotFileName_,
+                    "|mode=", isFull ? StrView{"Full"} : StrView{"Incremental"},
+                    "|records=", recCount, "|spend=", UtcNow() - tmbeg);
    }
-   fd.Append(ToStrView(wrbuf));
+   return File::Result{recCount};
 }
-void MdSymbsBase::LoadFrom(std::string fname) {
+bool MdSymbsBase::SaveSnapshotAsync(std::string fname) {
+   if (this->IsSnapshotRunning_.exchange(true))
+      return false;
+   intrusive_ptr<MdSymbsBase> pthis{this};
+   GetDefaultThreadPool().EmplaceMessage([pthis, fname]() {
+      pthis->SaveSnapshot(fname);
+      std::lock_guard<std::mutex> lk{pthis->SnapshotMutex_};
+      pthis->IsSnapshotRunning_.store(false);
+      pthis->SnapshotCV_.notify_all();
+   });
+   return true;
+}
+void MdSymbsBase::WaitSnapshot() {
+   std::unique_lock<std::mutex> lk{this->SnapshotMutex_};
+   this->SnapshotCV_.wait(lk, [this]() { return !this->IsSnapshotRunning_.load(); });
+}
+//--------------------------------------------------------------------------//
+/// LoadFrom() 使用: 要載入的商品, 及其欄位資料(不含 SymbId).
+struct LoadSymbRec {
+   SymbSP   Symb_;
+   StrView  Cells_;
+};
+/// 解析 recs 的欄位資料, 可能在多個 thread 同時執行, 但每個 thread 處理的商品不同.
+/// \retval 解析失敗的數量.
+static size_t LoadSymbCells(seed::Layout& layout, const LoadSymbRec* ibeg, const LoadSymbRec* iend, std::string& errmsg) {
+   size_t      errCount = 0;
+   const auto  tabCount = layout.GetTabCount();
+   for (; ibeg != iend; ++ibeg) {
+      DcQueueFixedMem rds{ibeg->Cells_};
+      try {
+         for (size_t tabidx = 0; tabidx < tabCount; ++tabidx) {
+            auto* tab = layout.GetTab(tabidx);
+            seed::SimpleRawWr wr{*ibeg->Symb_->GetSymbData(static_cast<int>(tabidx))};
+            const auto fldCount = tab->Fields_.size();
+            for (size_t fldidx = 0; fldidx < fldCount; ++fldidx)
+               tab->Fields_.Get(fldidx)->BitvToCell(wr, rds);
+         }
+      }
+      catch (std::runtime_error& e) {
+         if (errCount++ == 0)
+            errmsg = e.what();
+      }
+   }
+   return errCount;
+}
+void MdSymbsBase::LoadFrom(std::string fname, unsigned threadCount) {
    File fd;
    auto res = fd.Open(fname, FileMode::Read);
    if (res.IsError()) {
@@ -217,37 +418,107 @@ void MdSymbsBase::LoadFrom(std::string fname) {
          fon9_LOG_ERROR("MdSymbs.LoadFrom|fname=", fname, '|', res);
       return;
    }
-   auto  symbsLk = this->SymbMap_.Lock();
+   std::string fbuf;
+   res = fd.GetFileSize();
+   if (!res.IsError() && res.GetResult() > 0) {
+      fbuf.resize(res.GetResult());
+      res = fd.Read(0, &*fbuf.begin(), fbuf.size());
+      if (!res.IsError() && res.GetResult() != fbuf.size())
+         fbuf.resize(res.GetResult());
+   }
+   if (res.IsError()) {
+      fon9_LOG_ERROR("MdSymbs.LoadFrom|fname=", fname, "|Read.err=", res);
+      return;
+   }
+   // 切割記錄, 同一個商品以最後一筆為準; 此時不用鎖定商品表;
+   std::unordered_map<std::string, StrView> lastRecs;
    try {
-      File::PosType fpos = 0;
-      CharVector    rdbuf;
-      CharVector    keyText;
-      FileReadAll(fd, fpos, [&rdbuf, &keyText, this, &symbsLk](DcQueueList& dcq, File::Result&) -> bool {
-         size_t barySize;
-         while (PopBitvByteArraySize(dcq, barySize)) {
-            dcq.Read(rdbuf.alloc(barySize), barySize);
-            DcQueueFixedMem rds{rdbuf.begin(), barySize};
-            BitvTo(rds, keyText);
-            Symb&       symb = *this->FetchSymb(symbsLk, ToStrView(keyText));
-            const auto  tabCount = this->LayoutSP_->GetTabCount();
-            for(size_t tabidx = 0; tabidx < tabCount; ++tabidx) {
-               auto* tab = this->LayoutSP_->GetTab(tabidx);
-               seed::SimpleRawWr wr{*symb.GetSymbData(static_cast<int>(tabidx))};
-               const auto fldCount = tab->Fields_.size();
-               for (size_t fldidx = 0; fldidx < fldCount; ++fldidx)
-                  tab->Fields_.Get(fldidx)->BitvToCell(wr, rds);
-            }
+      DcQueueFixedMem   dcq{fbuf};
+      size_t            barySize;
+      CharVector        keyText;
+      while (PopBitvByteArraySize(dcq, barySize)) {
+         if (dcq.GetCurrBlockSize() < barySize) {
+            // 可能是寫入快照時程式結束, 拋棄不完整的最後一筆.
+            fon9_LOG_WARN("MdSymbs.LoadFrom|fname=", fname, "|err=Incomplete last record.");
+            break;
          }
-         return true;
-      });
+         DcQueueFixedMem rds{dcq.Peek1(), barySize};
+         BitvTo(rds, keyText);
+         lastRecs[keyText.ToString()] = StrView{reinterpret_cast<const char*>(rds.Peek1()), rds.GetCurrBlockSize()};
+         dcq.PopConsumed(barySize);
+      }
    }
    catch (std::runtime_error& e) {
       fon9_LOG_ERROR("MdSymbs.LoadFrom|fname=", fname, "|Read.err=", e.what());
    }
+   AllSymbsLocker symbsLk{*this};
+   std::vector<LoadSymbRec> recs;
+   recs.reserve(lastRecs.size());
+   for (const auto& irec : lastRecs) {
+      if (irec.second.empty()) // 「移除」記錄.
+         continue;
+      recs.push_back(LoadSymbRec{symbsLk.FetchSymb(&irec.first), irec.second});
+   }
+   // 每個 thread 至少處理 kSnapshotBatchSize 個商品, 呼叫端的 thread 也參與解析.
+   if (threadCount == 0)
+      threadCount = std::thread::hardware_concurrency();
+   threadCount = static_cast<unsigned>(std::max(std::min(size_t{threadCount}, recs.size() / kSnapshotBatchSize), size_t{1}));
+   const LoadSymbRec* const      pbeg = recs.data();
+   const size_t                  recsPerThr = (recs.size() + threadCount - 1) / threadCount;
+   std::vector<std::string>      errmsgs(threadCount);
+   std::vector<size_t>           errCounts(threadCount);
+   std::vector<std::thread>      thrs;
+   for (unsigned L = 1; L < threadCount; ++L) {
+      const size_t ibeg = std::min(recsPerThr * L, recs.size());
+      const size_t iend = std::min(ibeg + recsPerThr, recs.size());
+      thrs.emplace_back([this, pbeg, ibeg, iend, L, &errmsgs, &errCounts]() {
+         errCounts[L] = LoadSymbCells(*this->LayoutSP_, pbeg + ibeg, pbeg + iend, errmsgs[L]);
+      });
+   }
+   errCounts[0] = LoadSymbCells(*this->LayoutSP_, pbeg, pbeg + std::min(recsPerThr, recs.size()), errmsgs[0]);
+   for (auto& thr : thrs)
+      thr.join();
+   for (unsigned L = 0; L < threadCount; ++L) {
+      if (errCounts[L])
+         fon9_LOG_ERROR("MdSymbs.LoadFrom|fname=", fname, "|errCount=", errCounts[L], "|err=", errmsgs[L]);
+   }
+   this->IsSnapshotAllDirty_ = true;
    this->OnAfterLoadFrom(std::move(symbsLk));
 }
-void MdSymbsBase::OnAfterLoadFrom(Locker&& symbsLk) {
+void MdSymbsBase::OnAfterLoadFrom(AllSymbsLocker&& symbsLk) {
    (void)symbsLk;
 }
+//--------------------------------------------------------------------------//
+MdSymbsTreeBase::~MdSymbsTreeBase() {
+   // SymbMap_ 在此之後解構, 所以必須先結束回補.
+   this->RtInnMgr_.DisposeRecovers();
+}
+unsigned MdSymbsTreeBase::GetSymbShardIndex(const StrView& symbid) const {
+   (void)symbid;
+   return 0;
+}
+MdSymbsTreeBase::SymbMap& MdSymbsTreeBase::GetSymbShardAt(unsigned shardIndex) {
+   (void)shardIndex; assert(shardIndex == 0);
+   return this->SymbMap_;
+}
+void MdSymbsTreeBase::OnAfterPodOpWrite(Symb& symb, seed::Tab& tab, const Locker& symbs) {
+   this->UnsafeMarkSnapshotDirty(symb);
+   base::OnAfterPodOpWrite(symb, tab, symbs);
+}
+//--------------------------------------------------------------------------//
+MdSymbsShardedBase::~MdSymbsShardedBase() {
+   // Shards_ 在此之後解構, 所以必須先結束回補.
+   this->RtInnMgr_.DisposeRecovers();
+}
+unsigned MdSymbsShardedBase::GetSymbShardIndex(const StrView& symbid) const {
+   return GetShardIndex(symbid);
+}
+MdSymbsShardedBase::SymbMap& MdSymbsShardedBase::GetSymbShardAt(unsigned shardIndex) {
+   return this->GetShardAt(shardIndex);
+}
+void MdSymbsShardedBase::OnAfterPodOpWrite(Symb& symb, seed::Tab& tab, const Locker& symbs) {
+   this->UnsafeMarkSnapshotDirty(symb);
+   base::OnAfterPodOpWrite(symb, tab, symbs);
+}
 
 } } // namespaces
@@ -2,31 +2,78 @@
 // \author fonwinz@gmail.com
 #ifndef __fon9_fmkt_MdSymbs_hpp__
 #define __fon9_fmkt_MdSymbs_hpp__
-#include "fon9/fmkt/SymbTree.hpp"
+#include "fon9/fmkt/SymbTreeSharded.hpp"
 #include "fon9/fmkt/MdRtStream.hpp"
+#include "fon9/fmkt/SymbBars.hpp"
 #include "fon9/fmkt/FmdTypes.hpp"
 #include "fon9/fmkt/SymbTabNames.h"
+#include "fon9/File.hpp"
+#include <condition_variable>
 
 namespace fon9 { namespace fmkt {
 
 void fon9_API SymbCellsToBitv(RevBuffer& rbuf, seed::Layout& layout, Symb& symb);
 //--------------------------------------------------------------------------//
-class fon9_API MdSymbsBase : public MdSymbTree {
+/// \ingroup fmkt
+/// MdSymbs 的共用部分, 與商品表的鎖定方式無關:
+/// - MdSymbsTreeBase: 單一 mutex 的商品表(同 MdSymbTree).
+/// - MdSymbsShardedBase: 依照商品Id分散到多個 shard 的商品表(同 MdSymbTreeSharded),
+///   適合多個行情來源(thread)同時更新不同的商品.
+/// - 單一商品的操作(MdRtStream, UnsafeUpdateBars()...), 必須鎖定該商品所在的 shard: GetSymbShard(symbid);
+/// - 整棵樹的操作(DailyClear, SaveSnapshot, LoadFrom, 訂閱整棵樹...), 使用 AllSymbsLocker 鎖定全部的 shards.
+class fon9_API MdSymbsBase : public SymbTree {
    fon9_NON_COPY_NON_MOVE(MdSymbsBase);
-   using base = MdSymbTree;
+   using base = SymbTree;
    struct Recover;
 
+public:
+   using SymbMap = MustLock<MdSymbMap, SeqLockMutex<std::mutex>>;
+   using Locker = SymbMap::Locker;
+
+   /// 依照 shard 的順序, 鎖定全部的 shards; MdSymbsTreeBase 只有一個 shard(SymbMap_).
+   /// 已鎖定某個 shard 時, 不可再使用 AllSymbsLocker, 否則可能死結.
+   class fon9_API AllSymbsLocker {
+      fon9_NON_COPY_NON_MOVE(AllSymbsLocker);
+      MdSymbsBase&         Owner_;
+      std::vector<Locker>  Lockers_;
+   public:
+      AllSymbsLocker(MdSymbsBase& owner);
+      ~AllSymbsLocker();
+
+      /// 反向解鎖.
+      void unlock();
+      Locker& operator[](unsigned shardIndex) {
+         assert(shardIndex < this->Lockers_.size());
+         return this->Lockers_[shardIndex];
+      }
+      /// 全部 shards 的商品數量.
+      size_t size() const;
+      /// 到 symbid 所在的 shard 尋找商品, 找不到則返回 nullptr;
+      Symb* GetSymb(const StrView& symbid) const;
+      /// 到 symbid 所在的 shard 尋找商品, 找不到則建立.
+      SymbSP FetchSymb(const StrView& symbid);
+      /// fnSymb(Symb&); 依照 shard 的順序, 列舉全部的商品.
+      template <class FnSymb>
+      void ForEachSymb(FnSymb&& fnSymb) const {
+         for (const Locker& lk : this->Lockers_) {
+            for (const auto& isymb : *lk)
+               fnSymb(GetSymbValue(isymb));
+         }
+      }
+   };
+
+private:
    struct SymbsSubr : public MdRtSubr {
       fon9_NON_COPY_NON_MOVE(SymbsSubr);
       using MdRtSubr::MdRtSubr;
-      SymbMapImpl SymbsRecovering_;
+      MdSymbMap   SymbsRecovering_;
    };
    struct SymbsSubrSP : public intrusive_ptr<SymbsSubr> {
       using base = intrusive_ptr<SymbsSubr>;
       using base::base;
       /// 呼叫前必須: lock tree, 檢查 IsUnsubscribed();
       void operator()(const seed::SeedNotifyArgs& e) const {
-         assert(static_cast<MdSymbTree*>(&e.Tree_)->SymbMap_.IsLocked());
+         assert(static_cast<MdSymbsBase*>(&e.Tree_)->IsSymbLocked(e.KeyText_));
          assert(!this->get()->IsUnsubscribed());
          auto& symbs = this->get()->SymbsRecovering_;
          if (symbs.empty() || symbs.find(e.KeyText_) == symbs.end())
@@ -35,32 +82,78 @@ class fon9_API MdSymbsBase : public MdSymbTree {
    };
    using UnsafeSubj = seed::UnsafeSeedSubjT<SymbsSubrSP>;
    UnsafeSubj  UnsafeSubj_;
+   /// 使用多個 shards 時, 不同 shard 的商品可能在不同 thread 同時發行,
+   /// 此時使用 TreeMutex_ 保護 UnsafeSubj_.Publish() 及 SnapshotRemoved_;
+   /// 訂閱者的加入、移除, 及 tree 的其他狀態, 則在 AllSymbsLocker 的保護下異動.
+   std::mutex  TreeMutex_;
 
    /// 在 LoadFrom() 成功開啟, 且檔案載入完畢後的通知.
    /// 預設 do nothing.
-   virtual void OnAfterLoadFrom(Locker&& symbsLk);
+   virtual void OnAfterLoadFrom(AllSymbsLocker&& symbsLk);
+
+   /// SaveSnapshot() 使用: 異動過的商品記錄在 MdRtStream::IsSnapshotDirty_;
+   /// 這裡只記錄已移除的商品(SymbId), 必須在商品所在的 shard 鎖定的狀態下使用.
+   std::vector<std::string>         SnapshotRemoved_;
+   /// SaveTo(), SaveSnapshot(), SaveSnapshotAsync() 都在 SnapshotSaveMutex_ 的保護下執行,
+   /// 避免同時寫入同一個檔案, 或同時清除 MdRtStream::IsSnapshotDirty_ 造成增量快照不完整.
+   /// SnapshotFileName_, SnapshotAppended_ 也由 SnapshotSaveMutex_ 保護.
+   std::mutex                       SnapshotSaveMutex_;
+   /// SaveSnapshot() 上次寫入的檔名, 若檔名改變則必須建立完整快照.
+   std::string                      SnapshotFileName_;
+   /// 上次完整快照之後, 附加到快照檔的記錄數量.
+   size_t                           SnapshotAppended_{0};
+   /// WaitSnapshot() 使用 SnapshotCV_ 等候 IsSnapshotRunning_ 變成 false;
+   std::mutex                       SnapshotMutex_;
+   std::condition_variable          SnapshotCV_;
+   std::atomic<bool>                IsSnapshotRunning_{false};
+   char                             Padding___[7];
+
+   File::Result SaveSnapshotImpl(std::string fname, bool isIncremental);
+
+   /// symbid 所在的 shard 序號.
+   virtual unsigned GetSymbShardIndex(const StrView& symbid) const = 0;
 
 protected:
    bool  IsDailyClearing_{false};
    bool  IsBlockPublish_{false};
-   char  Padding____[2];
+   /// 在第一次 SaveSnapshot() 之後, 才開始記錄異動過的商品.
+   bool  IsSnapshotTracking_{false};
+   /// 全部的商品都需要寫入快照: 尚未建立過快照、DailyClear()、LoadFrom()...
+   bool  IsSnapshotAllDirty_{true};
 
 public:
    const MdSymbsCtrlFlag   CtrlFlags_;
+   /// shard 的數量: MdSymbsTreeBase 為 1;
+   const unsigned          SymbShardCount_;
    seed::Tab* const        RtTab_;
+   /// 若 layout 有 Bars tab(SymbBarsTab), 則可透過 UnsafeUpdateBars() 彙總 K 線.
+   SymbBarsTab* const      BarsTab_;
    MdRtStreamInnMgr        RtInnMgr_;
 
    fon9_MSC_WARN_DISABLE(4355); // 'this': used in base member initializer list
-   MdSymbsBase(seed::LayoutSP layout, std::string rtiPathFmt, MdSymbsCtrlFlag flags = MdSymbsCtrlFlag{})
+   MdSymbsBase(seed::LayoutSP layout, std::string rtiPathFmt, MdSymbsCtrlFlag flags, unsigned symbShardCount)
       : base{std::move(layout)}
       , CtrlFlags_{flags}
+      , SymbShardCount_{symbShardCount}
       , RtTab_{LayoutSP_->GetTab(fon9_kCSTR_TabName_Rt)}
+      , BarsTab_{dynamic_cast<SymbBarsTab*>(LayoutSP_->GetTab(fon9_kCSTR_TabName_Bars))}
       , RtInnMgr_(*this, std::move(rtiPathFmt)) {
    }
    fon9_MSC_WARN_POP;
 
    ~MdSymbsBase();
 
+   virtual SymbMap& GetSymbShardAt(unsigned shardIndex) = 0;
+   /// symbid 所在的 shard, 操作單一商品(例: MdRtStream)時, 必須鎖定此處.
+   SymbMap& GetSymbShard(const StrView& symbid) {
+      return this->GetSymbShardAt(this->GetSymbShardIndex(symbid));
+   }
+#ifndef NDEBUG
+   bool IsSymbLocked(const StrView& symbid) {
+      return this->GetSymbShard(symbid).IsLocked();
+   }
+#endif
+
    void SetDailyClearHHMMSS(unsigned hhmmss) {
       this->RtInnMgr_.SetDailyClearHHMMSS(hhmmss);
    }
@@ -68,21 +161,76 @@ public:
    /// 訂閱整棵樹, 建構時必須提供 MdSymbsCtrlFlag::AllowSubrTree 旗標.
    seed::OpResult SubscribeStream(SubConn* pSubConn, seed::Tab&, StrView args, seed::FnSeedSubr&&);
    seed::OpResult UnsubscribeStream(SubConn* pSubConn, seed::Tab&);
-   /// - 此處會檢查 assert(this->SymbMap_.IsLocked()); 未鎖定的呼叫, 必定為設計上的問題.
+   /// - 此處會檢查 assert(this->IsSymbLocked(e.KeyText_)); 未鎖定的呼叫, 必定為設計上的問題.
    /// - 若 pkType == f9sv_RtsPackType_Count; 則必須從 e.NotifyKind_ 取得通知種類.
    void UnsafePublish(f9sv_RtsPackType pkType, seed::SeedNotifyArgs& e);
 
    void DailyClear(unsigned tdayYYYYMMDD);
 
+   /// 使用成交明細更新 K 線, 通常在發行成交(f9sv_RtsPackType_DealPack...)之後呼叫.
+   /// - 若沒有 BarsTab_, 或 symb 沒有 Bars 或 Rt 資料, 則不做任何事;
+   /// - 若有 K 線完成: 發行並儲存 f9sv_RtsPackType_BarClosed;
+   /// - 若有即時訂閱者: 發行(不儲存) f9sv_RtsPackType_BarUpdate;
+   void UnsafeUpdateBars(Symb& symb, const SymbDealData& deal);
+
    /// 儲存現在的全部商品資料, 通常在程式結束前呼叫.
+   /// 每次鎖定商品表只處理一批商品, 並逐批寫入檔案.
    void SaveTo(std::string fname);
    /// 載入商品資料, 通常在程式啟動時呼叫.
-   void LoadFrom(std::string fname);
+   /// - 同一個商品若有多筆資料(SaveSnapshot() 附加的), 以最後一筆為準;
+   ///   若最後一筆為「移除」記錄, 則不載入該商品.
+   /// - 載入期間會鎖定商品表, 但欄位的解析使用 threadCount 個 thread 同時處理;
+   ///   threadCount == 0 表示依照 CPU 數量決定.
+   void LoadFrom(std::string fname, unsigned threadCount = 0);
+
+   /// 增量快照(checkpoint), 不會長時間鎖住整棵樹:
+   /// - 第一次呼叫、檔名改變、DailyClear()、LoadFrom() 之後、或附加的記錄數量超過商品數量:
+   ///   建立完整快照(覆蓋 fname).
+   /// - 否則只將異動過的商品(MdRtStream 發行、PodOp 寫入、UnsafeMarkSnapshotDirty())附加到 fname 尾端,
+   ///   已移除的商品(UnsafeMarkSnapshotRemoved())則附加「移除」記錄, LoadFrom() 時以最後一筆為準.
+   /// - 異動過的商品, 在此鎖定全部的 shards 時, 掃描 MdRtStream::IsSnapshotDirty_ 取得;
+   ///   若沒有 RtTab_(MdRtStream), 則每次都建立完整快照.
+   /// - 每次鎖定商品表只處理 kSnapshotBatchSize 個商品, 解鎖後再寫檔.
+   /// - 在呼叫端的 thread 執行; 若要在背景執行, 請使用 SaveSnapshotAsync();
+   /// - 若有其他的 SaveTo(), SaveSnapshot() 正在執行, 則會等候其完成後才執行.
+   /// - 返回寫入的記錄數量(包含「移除」記錄).
+   File::Result SaveSnapshot(std::string fname) {
+      return this->SaveSnapshotImpl(std::move(fname), true);
+   }
+   /// 在 GetDefaultThreadPool() 執行 SaveSnapshot(fname);
+   /// 若前一次的快照尚未完成, 則返回 false, 不會執行這次的快照.
+   bool SaveSnapshotAsync(std::string fname);
+   /// 等候 SaveSnapshotAsync() 完成.
+   void WaitSnapshot();
+   /// 必須在 symb 所在的 shard 鎖定的狀態下呼叫:
+   /// 若商品的異動沒有透過 MdRtStream 發行, 則可透過此處加入下次的增量快照.
+   void UnsafeMarkSnapshotDirty(Symb& symb) {
+      assert(this->IsSymbLocked(ToStrView(symb.SymbId_)));
+      if (this->RtTab_ == nullptr)
+         return;
+      if (auto* rts = static_cast<MdRtStream*>(symb.GetSymbData(static_cast<int>(this->RtTab_->GetIndex()))))
+         rts->IsSnapshotDirty_ = true;
+   }
+   /// 必須在 symbid 所在的 shard 鎖定的狀態下呼叫:
+   /// 商品已從商品表移除, 在下次的增量快照附加「移除」記錄.
+   /// MdRtStream::BeforeRemove() 會自動呼叫此處.
+   void UnsafeMarkSnapshotRemoved(const StrView& symbid) {
+      assert(this->IsSymbLocked(symbid));
+      if (!this->IsSnapshotTracking_ || symbid.empty())
+         return;
+      if (fon9_LIKELY(this->SymbShardCount_ == 1))
+         this->SnapshotRemoved_.emplace_back(symbid.begin(), symbid.end());
+      else {
+         std::lock_guard<std::mutex> lk{this->TreeMutex_};
+         this->SnapshotRemoved_.emplace_back(symbid.begin(), symbid.end());
+      }
+   }
 
    /// 在某些情況下, 可以先暫停「整棵樹」的發行.
    /// 例如: 行情資料來源一個封包, 包含多筆商品資料,
    ///       此時可以先暫停, 避免每個商品都發行一次,
    ///       統一在整個封包都處理完畢後發行一次即可.
+   /// 僅支援單一 mutex 的商品表(MdSymbsTreeBase), 因為 sharded 無法在一次鎖定期間處理全部的商品.
    struct BlockPublish {
       fon9_NON_COPY_NON_MOVE(BlockPublish);
       MdSymbsBase&   Owner_;
@@ -90,59 +238,106 @@ public:
       BlockPublish(MdSymbsBase& owner, BufferNodeSize newAllocReserved)
          : Owner_(owner)
          , AckBuf_{newAllocReserved} {
-         assert(owner.SymbMap_.IsLocked() && owner.IsBlockPublish_ == false);
+         assert(owner.SymbShardCount_ == 1 && owner.GetSymbShardAt(0).IsLocked() && owner.IsBlockPublish_ == false);
          owner.IsBlockPublish_ = true;
       }
       ~BlockPublish() {
-         assert(this->Owner_.SymbMap_.IsLocked());
+         assert(this->Owner_.GetSymbShardAt(0).IsLocked());
          this->Owner_.IsBlockPublish_ = false;
       }
       RevBufferList* GetPublishBuffer() {
          return this->Owner_.UnsafeSubj_.IsEmpty() ? nullptr : &this->AckBuf_;
       }
       void UnsafePublish(f9sv_RtsPackType pkType, seed::SeedNotifyArgs& e) {
-         assert(this->Owner_.SymbMap_.IsLocked());
+         assert(this->Owner_.GetSymbShardAt(0).IsLocked());
          this->Owner_.IsBlockPublish_ = false;
          this->Owner_.UnsafePublish(pkType, e);
       }
    };
 };
 //--------------------------------------------------------------------------//
+/// \ingroup fmkt
+/// 單一 mutex 的商品表(同 MdSymbTree), 一般行情系統使用.
+class fon9_API MdSymbsTreeBase : public SymbTreeT<MdSymbMap, SeqLockMutex<std::mutex>, MdSymbsBase> {
+   fon9_NON_COPY_NON_MOVE(MdSymbsTreeBase);
+   using base = SymbTreeT<MdSymbMap, SeqLockMutex<std::mutex>, MdSymbsBase>;
+
+   unsigned GetSymbShardIndex(const StrView& symbid) const override;
+
+protected:
+   void OnAfterPodOpWrite(Symb& symb, seed::Tab& tab, const Locker& symbs) override;
+
+public:
+   MdSymbsTreeBase(seed::LayoutSP layout, std::string rtiPathFmt, MdSymbsCtrlFlag flags = MdSymbsCtrlFlag{})
+      : base{std::move(layout), std::move(rtiPathFmt), flags, 1u} {
+   }
+   ~MdSymbsTreeBase();
+
+   SymbMap& GetSymbShardAt(unsigned shardIndex) override;
+};
+
+/// \ingroup fmkt
+/// 依照商品Id分散到多個 shard 的商品表(同 MdSymbTreeSharded), 多個行情來源(thread)同時更新時使用.
+/// - 單一商品使用 LockShard(symbid) 鎖定, 不同 shard 的商品可同時更新.
+/// - 不支援 BlockPublish.
+class fon9_API MdSymbsShardedBase : public SymbTreeShardedT<MdSymbMap, SeqLockMutex<std::mutex>, 4, MdSymbsBase> {
+   fon9_NON_COPY_NON_MOVE(MdSymbsShardedBase);
+   using base = SymbTreeShardedT<MdSymbMap, SeqLockMutex<std::mutex>, 4, MdSymbsBase>;
+
+   unsigned GetSymbShardIndex(const StrView& symbid) const override;
+
+protected:
+   void OnAfterPodOpWrite(Symb& symb, seed::Tab& tab, const Locker& symbs) override;
+
+public:
+   MdSymbsShardedBase(seed::LayoutSP layout, std::string rtiPathFmt, MdSymbsCtrlFlag flags = MdSymbsCtrlFlag{})
+      : base{std::move(layout), std::move(rtiPathFmt), flags, kShardCount} {
+      // 不同 shard 的商品可能同時提出首次回補要求, 所以在此先取得回補排程.
+      this->RtInnMgr_.RecoverSch();
+   }
+   ~MdSymbsShardedBase();
+
+   SymbMap& GetSymbShardAt(unsigned shardIndex) override;
+};
+//--------------------------------------------------------------------------//
 /// MdSymbs 提供:
 /// - 協助訂閱即時資料.
 /// - 協助使用 RtInnMgr_ 提供儲存即時資料.
 /// - 協助 DailyClear;
 /// - MdSymbT 必須提供:
 ///   - fon9::fmkt::MdRtStream  MdRtStream_;
-template <class MdSymbT>
-class MdSymbsT : public MdSymbsBase {
+/// - MdSymbsBaseT: MdSymbsTreeBase 或 MdSymbsShardedBase;
+template <class MdSymbT, class MdSymbsBaseT = MdSymbsTreeBase>
+class MdSymbsT : public MdSymbsBaseT {
    fon9_NON_COPY_NON_MOVE(MdSymbsT);
-   using base = MdSymbsBase;
+   using base = MdSymbsBaseT;
 
 public:
    using base::base;
+   using Locker = typename base::Locker;
 
    //-----------------------------//
-   struct MdSymOp : public PodOp {
+   struct MdSymOp : public base::PodOp {
       fon9_NON_COPY_NON_MOVE(MdSymOp);
-      using base = PodOp;
-      using base::base;
+      using PodOp = typename MdSymbsBaseT::PodOp;
+      using PodOp::PodOp;
       seed::OpResult SubscribeStream(SubConn* pSubConn, seed::Tab& tab, StrView args, seed::FnSeedSubr subr) override {
          if (static_cast<MdSymbsT*>(this->Sender_)->RtTab_ != &tab)
             return seed::SubscribeStreamUnsupported(pSubConn);
          return static_cast<MdSymbT*>(this->Symb_.get())->MdRtStream_.SubscribeStream(
-            this->LockedMap_, pSubConn, tab, *this, args, std::move(subr));
+            this->LockMap(), pSubConn, tab, *this, args, std::move(subr));
       }
       seed::OpResult UnsubscribeStream(SubConn* pSubConn, seed::Tab& tab) override {
          if (static_cast<MdSymbsT*>(this->Sender_)->RtTab_ != &tab)
             return seed::OpResult::not_supported_subscribe_stream;
          return static_cast<MdSymbT*>(this->Symb_.get())->MdRtStream_.UnsubscribeStream(
-            this->LockedMap_, pSubConn);
+            this->LockMap(), pSubConn);
       }
    };
    //-----------------------------//
-   struct MdSymbsOp : public TreeOp {
+   struct MdSymbsOp : public base::TreeOp {
       fon9_NON_COPY_NON_MOVE(MdSymbsOp);
+      using TreeOp = typename MdSymbsBaseT::TreeOp;
       using TreeOp::TreeOp;
       void OnSymbPodOp(const StrView& strKeyText, SymbSP&& symb, seed::FnPodOp&& fnCallback, const Locker& lockedMap) override {
          MdSymOp op(this->Tree_, strKeyText, std::move(symb), lockedMap);
@@ -161,6 +356,9 @@ public:
       fnCallback(seed::TreeOpResult{this, fon9::seed::OpResult::no_error}, &op);
    }
 };
+/// 使用 MdSymbsShardedBase 的 MdSymbsT;
+template <class MdSymbT>
+using MdSymbsShardedT = MdSymbsT<MdSymbT, MdSymbsShardedBase>;
 
 } } // namespaces
 #endif//__fon9_fmkt_MdSymbs_hpp__
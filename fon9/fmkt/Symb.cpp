@@ -8,6 +8,10 @@ namespace fon9 { namespace fmkt {
 
 SymbData::~SymbData() {
 }
+bool SymbData::ReadSnapshot(const SeqLock& seqLock, const FnSnapshotRead& fnRead) const {
+   (void)seqLock; (void)fnRead;
+   return false;
+}
 //--------------------------------------------------------------------------//
 Symb::~Symb() {
 }
@@ -8,8 +8,10 @@
 #include "fon9/Trie.hpp"
 #include "fon9/SortedVector.hpp"
 #include "fon9/seed/Tab.hpp"
+#include "fon9/SeqLock.hpp"
 
 #include <unordered_map>
+#include <functional>
 
 namespace fon9 { namespace fmkt {
 
@@ -34,6 +36,13 @@ public:
    /// 在 Symb::SessionClear() 填妥相關欄位之後,
    /// 會觸發該 Symb 所有的 SymbData 的 OnSymbSessionClear() 事件.
    virtual void OnSymbSessionClear(SymbTree& tree, const Symb& symb) = 0;
+
+   using FnSnapshotRead = std::function<void(const SymbData& snapshot)>;
+   /// 在不鎖定 SymbTree 的情況下, 透過 seqLock(SymbTree 的 SeqLockMutex) 取得一致的資料快照,
+   /// 然後呼叫 fnRead(snapshot); snapshot 僅在 fnRead() 期間有效.
+   /// - 返回 false 表示: 不支援快照(預設), 或持續有寫入而無法取得快照, 此時不會呼叫 fnRead();
+   ///   呼叫端應鎖定 SymbTree 之後再讀取.
+   virtual bool ReadSnapshot(const SeqLock& seqLock, const FnSnapshotRead& fnRead) const;
 };
 
 template <class DataT>
@@ -54,6 +63,22 @@ public:
       (void)tree; (void)symb;
       this->Data_.Clear();
    }
+   /// 若 DataT 為 trivially copyable, 則支援快照: 複製一份 Data_ 到暫時的 SimpleSymbData;
+   bool ReadSnapshot(const SeqLock& seqLock, const FnSnapshotRead& fnRead) const override {
+      return this->ReadSnapshotImpl(seqLock, fnRead, std::is_trivially_copyable<DataT>{});
+   }
+
+private:
+   bool ReadSnapshotImpl(const SeqLock& seqLock, const FnSnapshotRead& fnRead, std::true_type) const {
+      SimpleSymbData snapshot;
+      if (!seqLock.ReadCopy(this->Data_, snapshot.Data_))
+         return false;
+      fnRead(snapshot);
+      return true;
+   }
+   bool ReadSnapshotImpl(const SeqLock&, const FnSnapshotRead&, std::false_type) const {
+      return false;
+   }
 };
 
 
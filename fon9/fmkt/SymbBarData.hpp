@@ -0,0 +1,82 @@
+﻿// \file fon9/fmkt/SymbBarData.hpp
+// \author fonwinz@gmail.com
+#ifndef __fon9_fmkt_SymbBarData_hpp__
+#define __fon9_fmkt_SymbBarData_hpp__
+#include "fon9/fmkt/FmktTypes.hpp"
+#include "fon9/TimeStamp.hpp"
+
+namespace fon9 { namespace fmkt {
+
+enum : unsigned {
+   /// 每個商品最多可設定的 K 線週期數量.
+   kMdBarIntervalMax = 4,
+   /// 每個 K 線週期, 在 Bars tab 的欄位數量.
+   /// 欄位順序: Time, Open, High, Low, Close, Volume, DealCount;
+   /// 第 n 個週期的欄位從 Fields_.Get(n * kSymbBarFieldCount) 開始.
+   kSymbBarFieldCount = 7,
+};
+
+/// \ingroup fmkt
+/// 一根 K 線(OHLCV).
+struct SymbBarData {
+   /// 此 K 線的起始時間(依照週期對齊).
+   DayTime  Time_{DayTime::Null()};
+   Pri      Open_{Pri::Null()};
+   Pri      High_{Pri::Null()};
+   Pri      Low_{Pri::Null()};
+   Pri      Close_{Pri::Null()};
+   /// 此 K 線期間的成交量.
+   Qty      Volume_{0};
+   /// 此 K 線期間的成交筆數.
+   uint32_t DealCount_{0};
+   char     Padding___[4];
+
+   void Clear() {
+      ForceZeroNonTrivial(this);
+      this->Time_.AssignNull();
+      this->Open_.AssignNull();
+      this->High_.AssignNull();
+      this->Low_.AssignNull();
+      this->Close_.AssignNull();
+   }
+   bool IsNull() const {
+      return this->Time_.IsNull();
+   }
+   /// 使用第一筆成交建立新的 K 線.
+   void Start(DayTime barTime, Pri pri, Qty vol) {
+      this->Time_ = barTime;
+      this->Open_ = this->High_ = this->Low_ = this->Close_ = pri;
+      this->Volume_ = vol;
+      this->DealCount_ = 1;
+   }
+   void Update(Pri pri, Qty vol) {
+      if (this->High_ < pri)
+         this->High_ = pri;
+      if (this->Low_ > pri)
+         this->Low_ = pri;
+      this->Close_ = pri;
+      this->Volume_ += vol;
+      ++this->DealCount_;
+   }
+};
+
+/// \ingroup fmkt
+/// K 線週期設定, 單位=秒, 例: {60, 300} 表示 1 分K, 5 分K.
+struct fon9_API MdBarIntervals {
+   uint32_t Secs_[kMdBarIntervalMax];
+   unsigned Count_{0};
+
+   MdBarIntervals() {
+      ZeroStruct(this->Secs_);
+   }
+   /// cfg = "1s,1m,5m,1h" 或 "1,60,300"; 沒有單位時為秒.
+   /// - 超過 kMdBarIntervalMax 的設定、週期為 0、或超過一日, 視為錯誤;
+   /// - 返回錯誤的位置, 成功則返回 nullptr;
+   const char* Parse(StrView cfg);
+
+   /// 週期的名稱, 例: 1s, 1m, 5m, 1h; 用在 Bars tab 的欄位名稱.
+   static std::string MakeName(uint32_t secs);
+};
+
+} } // namespaces
+#endif//__fon9_fmkt_SymbBarData_hpp__
@@ -0,0 +1,134 @@
+﻿// \file fon9/fmkt/SymbBars.cpp
+// \author fonwinz@gmail.com
+#include "fon9/fmkt/SymbBars.hpp"
+#include "fon9/seed/FieldMaker.hpp"
+#include "fon9/BitvEncode.hpp"
+#include "fon9/StrTo.hpp"
+
+namespace fon9 { namespace fmkt {
+
+const char* MdBarIntervals::Parse(StrView cfg) {
+   this->Count_ = 0;
+   ZeroStruct(this->Secs_);
+   while (!StrTrimHead(&cfg).empty()) {
+      StrView     item = StrFetchTrim(cfg, ',');
+      const char* pend;
+      uint32_t    secs = StrTo(item, uint32_t{0}, &pend);
+      switch (pend == item.end() ? '\0' : *pend++) {
+      case '\0': case 's': case 'S':               break;
+      case 'm': case 'M':  secs *= 60;             break;
+      case 'h': case 'H':  secs *= 60 * 60;        break;
+      default:             return item.begin();
+      }
+      if (pend != item.end() || secs == 0 || secs > 24 * 60 * 60 || this->Count_ >= kMdBarIntervalMax)
+         return item.begin();
+      this->Secs_[this->Count_++] = secs;
+   }
+   return nullptr;
+}
+std::string MdBarIntervals::MakeName(uint32_t secs) {
+   char unit = 's';
+   if (secs % (60 * 60) == 0) {
+      secs /= 60 * 60;
+      unit = 'h';
+   }
+   else if (secs % 60 == 0) {
+      secs /= 60;
+      unit = 'm';
+   }
+   std::string res = RevPrintTo<std::string>(secs);
+   res.push_back(unit);
+   return res;
+}
+//--------------------------------------------------------------------------//
+bool SymbBars::OnDeal(const MdBarIntervals& intervals, const SymbDealData& deal, unsigned& closedMask) {
+   closedMask = 0;
+   if (IsEnumContains(deal.Flags_, f9sv_DealFlag_Calculated))
+      return false;
+   const DayTime dealTime = deal.DealTime();
+   if (dealTime.IsNull() || deal.Deal_.Pri_.IsNull())
+      return false;
+   // 優先使用累計成交量計算, 這樣即使行情有漏, K 線的成交量仍正確;
+   // 若累計成交量沒有增加, 則視為重複的成交, 不列入 K 線.
+   Qty vol = deal.Deal_.Qty_;
+   if (deal.TotalQty_ != 0) {
+      if (deal.TotalQty_ <= this->Data_.LastTotalQty_)
+         return false;
+      if (this->Data_.LastTotalQty_ != 0)
+         vol = deal.TotalQty_ - this->Data_.LastTotalQty_;
+      this->Data_.LastTotalQty_ = deal.TotalQty_;
+   }
+   const auto dealSecs = static_cast<uint32_t>(dealTime.GetIntPart());
+   for (unsigned idx = 0; idx < intervals.Count_; ++idx) {
+      SymbBarData&   curr = this->Data_.Curr_[idx];
+      const uint32_t barSecs = dealSecs - (dealSecs % intervals.Secs_[idx]);
+      if (fon9_LIKELY(!curr.IsNull())) {
+         if (fon9_LIKELY(barSecs <= static_cast<uint32_t>(curr.Time_.GetIntPart()))) {
+            curr.Update(deal.Deal_.Pri_, vol);
+            continue;
+         }
+         this->LastClosed_[idx] = curr;
+         closedMask |= (1u << idx);
+      }
+      curr.Start(TimeInterval_Second(barSecs), deal.Deal_.Pri_, vol);
+   }
+   return true;
+}
+void SymbBars::Clear() {
+   this->Data_.Clear();
+   for (SymbBarData& bar : this->LastClosed_)
+      bar.Clear();
+}
+void SymbBars::OnSymbDailyClear(SymbTree& tree, const Symb& symb) {
+   (void)tree; (void)symb;
+   this->Clear();
+}
+void SymbBars::OnSymbSessionClear(SymbTree& tree, const Symb& symb) {
+   (void)tree; (void)symb;
+   this->Clear();
+}
+bool SymbBars::ReadSnapshot(const SeqLock& seqLock, const FnSnapshotRead& fnRead) const {
+   // Bars tab 的欄位只有 Data_.Curr_[], 所以快照只需要複製 Data_;
+   SymbBars snapshot;
+   if (!seqLock.ReadCopy(this->Data_, snapshot.Data_))
+      return false;
+   fnRead(snapshot);
+   return true;
+}
+//--------------------------------------------------------------------------//
+seed::Fields SymbBars_MakeFields(const MdBarIntervals& intervals) {
+   seed::Fields flds;
+   for (unsigned idx = 0; idx < intervals.Count_; ++idx) {
+      const std::string name = MdBarIntervals::MakeName(intervals.Secs_[idx]);
+      const int32_t     ofsadj = static_cast<int32_t>(idx * sizeof(SymbBarData));
+      flds.Add(fon9_MakeField_OfsAdj(ofsadj, SymbBars, Data_.Curr_[0].Time_,      "Time" + name));
+      flds.Add(fon9_MakeField_OfsAdj(ofsadj, SymbBars, Data_.Curr_[0].Open_,      "Open" + name));
+      flds.Add(fon9_MakeField_OfsAdj(ofsadj, SymbBars, Data_.Curr_[0].High_,      "High" + name));
+      flds.Add(fon9_MakeField_OfsAdj(ofsadj, SymbBars, Data_.Curr_[0].Low_,       "Low" + name));
+      flds.Add(fon9_MakeField_OfsAdj(ofsadj, SymbBars, Data_.Curr_[0].Close_,     "Close" + name));
+      flds.Add(fon9_MakeField_OfsAdj(ofsadj, SymbBars, Data_.Curr_[0].Volume_,    "Volume" + name));
+      flds.Add(fon9_MakeField_OfsAdj(ofsadj, SymbBars, Data_.Curr_[0].DealCount_, "DealCount" + name));
+   }
+   return flds;
+}
+//--------------------------------------------------------------------------//
+fon9_API void MdRtsPackBars(RevBuffer& rbuf, const SymbBars& bars, unsigned mask, bool isClosed) {
+   for (unsigned idx = kMdBarIntervalMax; idx > 0;) {
+      if ((mask & (1u << --idx)) == 0)
+         continue;
+      const SymbBarData* bar = (isClosed ? bars.GetLastClosed(idx) : &bars.Data_.Curr_[idx]);
+      if (bar == nullptr)
+         continue;
+      // 與 SymbBars_MakeFields() 的欄位順序相同, 接收端可直接使用欄位的 BitvToCell() 解析.
+      ToBitv(rbuf, bar->DealCount_);
+      ToBitv(rbuf, bar->Volume_);
+      ToBitv(rbuf, bar->Close_);
+      ToBitv(rbuf, bar->Low_);
+      ToBitv(rbuf, bar->High_);
+      ToBitv(rbuf, bar->Open_);
+      ToBitv(rbuf, bar->Time_);
+      *rbuf.AllocPacket<uint8_t>() = static_cast<uint8_t>(idx);
+   }
+}
+
+} } // namespaces
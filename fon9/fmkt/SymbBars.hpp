@@ -0,0 +1,85 @@
+﻿// \file fon9/fmkt/SymbBars.hpp
+// \author fonwinz@gmail.com
+#ifndef __fon9_fmkt_SymbBars_hpp__
+#define __fon9_fmkt_SymbBars_hpp__
+#include "fon9/fmkt/SymbDy.hpp"
+#include "fon9/fmkt/SymbBarData.hpp"
+#include "fon9/fmkt/SymbDealData.hpp"
+#include "fon9/fmkt/SymbTabNames.h"
+
+namespace fon9 { namespace fmkt {
+
+/// SymbBars 的資料: 可在 ReadSnapshot() 直接複製.
+struct SymbBarsData {
+   /// 各週期尚未完成的 K 線, 對應到 MdBarIntervals::Secs_[];
+   SymbBarData Curr_[kMdBarIntervalMax];
+   /// 上次成交的累計成交量, 用來計算 K 線的成交量.
+   Qty         LastTotalQty_{0};
+
+   void Clear() {
+      for (SymbBarData& bar : this->Curr_)
+         bar.Clear();
+      this->LastTotalQty_ = 0;
+   }
+};
+
+/// \ingroup fmkt
+/// 商品資料的擴充: 由成交明細(SymbDealData)彙總的 K 線(OHLCV).
+/// - 週期設定由 SymbBarsTab::Intervals_ 提供, 通常在 MdSymbsBase::UnsafeUpdateBars() 呼叫 OnDeal();
+/// - 試算成交(f9sv_DealFlag_Calculated)不列入 K 線.
+/// - 成交時間早於現在 K 線起始時間(亂序), 則併入現在的 K 線.
+/// - 期間若沒有成交, 則不會產生空的 K 線.
+/// - 只保留各週期最後完成的 K 線(用來打包 f9sv_RtsPackType_BarClosed);
+///   歷史 K 線由 MdRtStream 儲存的 BarClosed 提供, 訂閱端透過 f9sv_MdRtsKind_Bar 回補取得.
+class fon9_API SymbBars : public SymbData {
+   fon9_NON_COPY_NON_MOVE(SymbBars);
+public:
+   SymbBarsData   Data_;
+   /// 各週期最後完成的 K 線, IsNull() 表示尚未有完成的 K 線.
+   SymbBarData    LastClosed_[kMdBarIntervalMax];
+
+   SymbBars() = default;
+
+   /// 加入一筆成交.
+   /// - 返回 false 表示此筆成交不列入 K 線(試算、重複、沒有價格或時間), 此時 K 線沒有異動;
+   /// - closedMask = 此次已完成的 K 線週期: (1u << 週期索引);
+   ///   已完成的 K 線可透過 GetLastClosed(idx) 取得.
+   bool OnDeal(const MdBarIntervals& intervals, const SymbDealData& deal, unsigned& closedMask);
+
+   /// 取得週期 idx 最後完成的 K 線, 若沒有則返回 nullptr;
+   const SymbBarData* GetLastClosed(unsigned idx) const {
+      assert(idx < kMdBarIntervalMax);
+      return this->LastClosed_[idx].IsNull() ? nullptr : &this->LastClosed_[idx];
+   }
+
+   void Clear();
+   void OnSymbDailyClear(SymbTree& tree, const Symb& symb) override;
+   void OnSymbSessionClear(SymbTree& tree, const Symb& symb) override;
+   bool ReadSnapshot(const SeqLock& seqLock, const FnSnapshotRead& fnRead) const override;
+};
+
+/// 依照 intervals 建立 Bars tab 的欄位, 每個週期 kSymbBarFieldCount 個欄位,
+/// 欄位名稱 = 欄位 + 週期名稱, 例: Time1m, Open1m, High1m, Low1m, Close1m, Volume1m, DealCount1m;
+fon9_API seed::Fields SymbBars_MakeFields(const MdBarIntervals& intervals);
+
+/// \ingroup fmkt
+/// Bars tab: 提供 K 線週期設定, 欄位內容為各週期尚未完成的 K 線.
+class fon9_API SymbBarsTab : public seed::Tab {
+   fon9_NON_COPY_NON_MOVE(SymbBarsTab);
+   using base = seed::Tab;
+public:
+   const MdBarIntervals Intervals_;
+
+   SymbBarsTab(const MdBarIntervals& intervals, seed::TabFlag flags = seed::TabFlag::NoSapling_NoSeedCommand_Writable)
+      : base{Named{fon9_kCSTR_TabName_Bars}, SymbBars_MakeFields(intervals), flags}
+      , Intervals_(intervals) {
+   }
+};
+
+/// 打包 f9sv_RtsPackType_BarClosed 或 f9sv_RtsPackType_BarUpdate 的內容(不含 pkType, InfoTime):
+/// - 依照 mask 的週期順序, 重複打包: 週期索引(uint8_t), Time, Open, High, Low, Close, Volume, DealCount(Bitv);
+/// - isClosed: 打包 GetLastClosed(idx); 否則打包 Data_.Curr_[idx];
+fon9_API void MdRtsPackBars(RevBuffer& rbuf, const SymbBars& bars, unsigned mask, bool isClosed);
+
+} } // namespaces
+#endif//__fon9_fmkt_SymbBars_hpp__
@@ -0,0 +1,82 @@
+﻿// \file fon9/fmkt/SymbBook.cpp
+// \author fonwinz@gmail.com
+#include "fon9/fmkt/SymbBook.hpp"
+#include "fon9/seed/FieldMaker.hpp"
+#include "fon9/BitvEncode.hpp"
+
+namespace fon9 { namespace fmkt {
+
+// 每筆異動最多使用: type(1) + Level(Bitv) + Pri(Bitv) + Qty(Bitv);
+static constexpr size_t kBookEntryMaxSize = 1 + (1 + sizeof(unsigned)) + (sizeof(PriQty) + 4);
+
+MdRtsBookPacker::MdRtsBookPacker(RevBufferList& rts)
+   : Rts_(rts)
+   // 前方保留一小塊記憶體, Finish() 時可直接在前方填入 count.
+   , Node_{FwdBufferNode::AllocReserveFront(kMaxCount * kBookEntryMaxSize, 64)}
+   , NodeEnd_{Node_->GetDataEnd()} {
+   rts.PushFront(this->Node_);
+}
+void MdRtsBookPacker::Add(RtBSType bsType, RtBSAction act, unsigned lv, const PriQty& pq) {
+   assert(this->Count_ < kMaxCount);
+   // Bitv 必須反向填入, 所以先暫時填入 xbuf, 然後再依序複製到 Node_;
+   RevBufferFixedSize<kBookEntryMaxSize> xbuf;
+   switch (act) {
+   case RtBSAction::New:
+   case RtBSAction::ChangePQ:
+      ToBitv(xbuf, pq.Qty_);
+      ToBitv(xbuf, pq.Pri_);
+      break;
+   case RtBSAction::ChangeQty:
+      ToBitv(xbuf, pq.Qty_);
+      break;
+   case RtBSAction::Delete:
+      break;
+   default: // RtBSAction::Mask
+      assert(!"MdRtsBookPacker.Add|err=Unknown RtBSAction");
+      return;
+   }
+   ToBitv(xbuf, lv);
+   *this->NodeEnd_ = static_cast<byte>(cast_to_underlying(bsType) | cast_to_underlying(act));
+   const auto sz = xbuf.GetUsedSize();
+   memcpy(this->NodeEnd_ + 1, xbuf.GetCurrent(), sz);
+   this->NodeEnd_ += sz + 1;
+   ++this->Count_;
+}
+bool MdRtsBookPacker::Finish(bool isCalculated) {
+   if (this->Count_ <= 0)
+      return false;
+   this->Node_->SetDataEnd(this->NodeEnd_);
+   *this->Rts_.AllocPacket<uint8_t>() = static_cast<uint8_t>((this->Count_ - 1) | (isCalculated ? 0x80u : 0u));
+   return true;
+}
+//--------------------------------------------------------------------------//
+static void SymbBook_AddPQ(seed::Fields& flds, int ofs, char bs, unsigned lv) {
+   // bs + lv + ('P' or 'Q'); e.g. "S10P", "B1Q";
+   NumOutBuf   nbuf;
+   char* const pend = nbuf.end();
+   char*       pbeg = ToStrRev(pend - 1, lv + 1);
+   *--pbeg = bs;
+   *(pend - 1) = 'P';
+   flds.Add(fon9_MakeField_OfsAdj(ofs, PriQty, Pri_, std::string(pbeg, pend)));
+   *(pend - 1) = 'Q';
+   flds.Add(fon9_MakeField_OfsAdj(ofs, PriQty, Qty_, std::string(pbeg, pend)));
+}
+fon9_API seed::Fields SymbBook_MakeFields(int ofsData, int ofsSells, int ofsBuys, unsigned depth, bool isAddMarketSeq) {
+   seed::Fields flds;
+   flds.Add(fon9_MakeField_OfsAdj(ofsData, SymbBookHead, InfoTime_, "InfoTime"));
+   if (isAddMarketSeq)
+      flds.Add(fon9_MakeField_OfsAdj(ofsData, SymbBookHead, MarketSeq_, "MktSeq"));
+   for (unsigned idx = depth; idx > 0;) {
+      --idx;
+      SymbBook_AddPQ(flds, ofsData + ofsSells + static_cast<int>(idx * sizeof(PriQty)), 'S', idx);
+   }
+   for (unsigned idx = 0; idx < depth; ++idx)
+      SymbBook_AddPQ(flds, ofsData + ofsBuys + static_cast<int>(idx * sizeof(PriQty)), 'B', idx);
+   flds.Add(seed::FieldSP{new seed::FieldIntHx<underlying_type_t<f9sv_BSFlag>>(
+      Named("Flags"), ofsData + fon9_OffsetOfRawPointer(SymbBookHead, Flags_))});
+   flds.Add(seed::FieldSP{new seed::FieldIntHx<underlying_type_t<f9sv_BSLmtFlag>>(
+      Named("LmtFlags"), ofsData + fon9_OffsetOfRawPointer(SymbBookHead, LmtFlags_))});
+   return flds;
+}
+
+} } // namespaces
@@ -0,0 +1,547 @@
+﻿// \file fon9/fmkt/SymbBook.hpp
+// \author fonwinz@gmail.com
+#ifndef __fon9_fmkt_SymbBook_hpp__
+#define __fon9_fmkt_SymbBook_hpp__
+#include "fon9/fmkt/SymbDy.hpp"
+#include "fon9/fmkt/FmktTools.hpp"
+#include "fon9/fmkt/MdRtsTypes.hpp"
+#include "fon9/fmkt/FmdTypes.hpp"
+#include "fon9/buffer/RevBufferList.hpp"
+#include "fon9/buffer/FwdBufferList.hpp"
+#include <vector>
+#include <algorithm>
+
+namespace fon9 { namespace fmkt {
+
+/// \ingroup fmkt
+/// 委託簿單邊某價位異動後的結果.
+struct BookLvChg {
+   enum : unsigned {
+      /// 沒有異動: 例如: 數量相同, 或刪除不存在的價位.
+      kNoChange = ~0u,
+   };
+   /// 異動的檔位, 0 = 最佳價.
+   /// 若檔位超過 lvLimit, 則為 lvLimit.
+   unsigned    Level_{kNoChange};
+   /// 只會是 New, Delete, ChangeQty;
+   RtBSAction  Action_{};
+   char        Padding___[3];
+
+   bool IsChanged() const {
+      return this->Level_ != kNoChange;
+   }
+};
+
+/// \ingroup fmkt
+/// 委託簿單邊: 使用排序的 vector 儲存價格檔位.
+/// - 最差價在 [0], 最佳價在 back(); 大部分異動發生在最佳價附近, 這樣搬移的資料量較少.
+template <bool isBuyT>
+class BookSideSorted {
+   std::vector<PriQty>  Levels_;
+
+   /// lhs 是否比 rhs 差?
+   static bool IsWorse(Pri lhs, Pri rhs) {
+      return isBuyT ? (lhs < rhs) : (rhs < lhs);
+   }
+
+public:
+   bool empty() const {
+      return this->Levels_.empty();
+   }
+   size_t size() const {
+      return this->Levels_.size();
+   }
+   void Clear() {
+      this->Levels_.clear();
+   }
+   const PriQty* Best() const {
+      return this->Levels_.empty() ? nullptr : &this->Levels_.back();
+   }
+   /// lv = 0 為最佳價, 若 lv 超過現有檔位數量, 則傳回 PriQty{};
+   PriQty GetLevel(unsigned lv) const {
+      return lv < this->Levels_.size() ? this->Levels_[this->Levels_.size() - lv - 1] : PriQty{};
+   }
+   /// 設定 pri 的數量, qty == 0 表示刪除該價位.
+   BookLvChg Set(Pri pri, Qty qty, unsigned lvLimit) {
+      BookLvChg chg;
+      auto      ifind = std::lower_bound(this->Levels_.begin(), this->Levels_.end(), pri,
+                                         [](const PriQty& lv, Pri p) { return IsWorse(lv.Pri_, p); });
+      if (ifind != this->Levels_.end() && ifind->Pri_ == pri) {
+         if (ifind->Qty_ == qty)
+            return chg;
+         chg.Level_ = static_cast<unsigned>(this->Levels_.end() - ifind - 1);
+         if (qty == 0) {
+            chg.Action_ = RtBSAction::Delete;
+            this->Levels_.erase(ifind);
+         }
+         else {
+            chg.Action_ = RtBSAction::ChangeQty;
+            ifind->Qty_ = qty;
+         }
+      }
+      else {
+         if (qty == 0)
+            return chg;
+         chg.Level_ = static_cast<unsigned>(this->Levels_.end() - ifind);
+         chg.Action_ = RtBSAction::New;
+         ifind = this->Levels_.insert(ifind, PriQty{});
+         ifind->Pri_ = pri;
+         ifind->Qty_ = qty;
+      }
+      if (chg.Level_ > lvLimit)
+         chg.Level_ = lvLimit;
+      return chg;
+   }
+   /// 依序(最佳價 => 最差價)填入 [ibeg..iend), 清除原有資料.
+   template <class Iterator>
+   void AssignBestFirst(Iterator ibeg, Iterator iend) {
+      this->Levels_.assign(ibeg, iend);
+      std::reverse(this->Levels_.begin(), this->Levels_.end());
+   }
+   /// 從最佳價開始, 依序呼叫 fn(const PriQty&), 若 fn() 返回 false 則停止.
+   template <class FnT>
+   void ForEachLevel(FnT&& fn) const {
+      for (auto i = this->Levels_.crbegin(); i != this->Levels_.crend(); ++i) {
+         if (!fn(*i))
+            break;
+      }
+   }
+};
+
+/// \ingroup fmkt
+/// 委託簿單邊: 使用固定的價格階梯(每個 tick 一個 slot)儲存價格檔位.
+/// - 價格 => slot 的位置: 只需要在少數的 Tier(相同 tick size 的價格區間) 之中尋找, 然後直接計算.
+/// - 最佳價: Slots_[BestIdx_];
+/// - 計算檔位: 從最佳價開始往較差價的方向計算, 最多算到 lvLimit.
+template <bool isBuyT>
+class BookSideLadder {
+   struct Tier {
+      Pri      From_;
+      Pri      Step_;
+      uint32_t IdxFrom_;
+      char     Padding___[4];
+   };
+   std::vector<Tier>    Tiers_;
+   /// 依價格由低到高排列, Qty_ == 0 表示該價位沒有委託.
+   std::vector<PriQty>  Slots_;
+   int32_t              BestIdx_{-1};
+   uint32_t             Count_{0};
+
+   /// 從 idx 往「較差價」方向的移動量.
+   static constexpr int32_t WorseStep() {
+      return isBuyT ? -1 : 1;
+   }
+   static bool IsBetterIdx(int32_t lhs, int32_t rhs) {
+      return isBuyT ? (lhs > rhs) : (lhs < rhs);
+   }
+   bool IsValidIdx(int32_t idx) const {
+      return 0 <= idx && static_cast<size_t>(idx) < this->Slots_.size();
+   }
+   /// 計算 idx 的檔位, 最多計算到 lvLimit.
+   unsigned IndexToLevel(int32_t idx, unsigned lvLimit) const {
+      if (this->BestIdx_ < 0 || !IsBetterIdx(this->BestIdx_, idx))
+         return 0;
+      unsigned lv = 0;
+      for (int32_t i = this->BestIdx_; i != idx; i += WorseStep()) {
+         if (this->Slots_[static_cast<size_t>(i)].Qty_ != 0 && ++lv >= lvLimit)
+            break;
+      }
+      return lv;
+   }
+
+public:
+   bool IsReady() const {
+      return !this->Slots_.empty();
+   }
+   bool empty() const {
+      return this->Count_ == 0;
+   }
+   size_t size() const {
+      return this->Count_;
+   }
+   size_t SlotCount() const {
+      return this->Slots_.size();
+   }
+   const PriQty* Best() const {
+      return this->BestIdx_ < 0 ? nullptr : &this->Slots_[static_cast<size_t>(this->BestIdx_)];
+   }
+
+   /// 依照 steps 建立 [priLo..priHi] 之間的價格階梯, 會清除原有資料.
+   /// \retval false steps == nullptr; 或 priLo > priHi; 或 slot 數量超過 maxSlots;
+   bool Reset(const LvPriStep* steps, Pri priLo, Pri priHi, uint32_t maxSlots) {
+      this->Tiers_.clear();
+      this->Slots_.clear();
+      this->BestIdx_ = -1;
+      this->Count_ = 0;
+      if (steps == nullptr || priHi < priLo)
+         return false;
+      Pri pri = MoveTicksUp(steps, priLo, 0, priHi);
+      for (;;) {
+         if (this->Slots_.size() >= maxSlots) {
+            this->Tiers_.clear();
+            this->Slots_.clear();
+            return false;
+         }
+         this->Slots_.emplace_back();
+         this->Slots_.back().Pri_ = pri;
+         if (pri >= priHi)
+            break;
+         const Pri next = MoveTicksUp(steps, pri, 1, priHi);
+         if (next <= pri)
+            break;
+         const Pri step = next - pri;
+         if (this->Tiers_.empty() || this->Tiers_.back().Step_ != step) {
+            Tier tier;
+            tier.From_ = pri;
+            tier.Step_ = step;
+            tier.IdxFrom_ = static_cast<uint32_t>(this->Slots_.size() - 1);
+            this->Tiers_.push_back(tier);
+         }
+         pri = next;
+      }
+      return true;
+   }
+   /// 清除全部的委託數量, 保留價格階梯.
+   void Clear() {
+      if (this->Count_ > 0) {
+         for (PriQty& slot : this->Slots_)
+            slot.Qty_ = 0;
+      }
+      this->BestIdx_ = -1;
+      this->Count_ = 0;
+   }
+   /// \retval <0 pri 不在價格階梯上.
+   int32_t PriToIndex(Pri pri) const {
+      if (this->Tiers_.empty())
+         return (!this->Slots_.empty() && this->Slots_[0].Pri_ == pri) ? 0 : -1;
+      auto itier = std::upper_bound(this->Tiers_.begin(), this->Tiers_.end(), pri,
+                                    [](Pri p, const Tier& t) { return p < t.From_; });
+      if (itier == this->Tiers_.begin())
+         return -1;
+      --itier;
+      const Pri ofs = pri - itier->From_;
+      if (!(ofs % itier->Step_).IsZero())
+         return -1;
+      const auto idx = itier->IdxFrom_ + static_cast<uint64_t>(ofs.GetOrigValue() / itier->Step_.GetOrigValue());
+      return idx < this->Slots_.size() ? static_cast<int32_t>(idx) : -1;
+   }
+   /// lv = 0 為最佳價, 若 lv 超過現有檔位數量, 則傳回 PriQty{};
+   PriQty GetLevel(unsigned lv) const {
+      if (lv < this->Count_) {
+         for (int32_t idx = this->BestIdx_; this->IsValidIdx(idx); idx += WorseStep()) {
+            const PriQty& slot = this->Slots_[static_cast<size_t>(idx)];
+            if (slot.Qty_ != 0 && lv-- == 0)
+               return slot;
+         }
+      }
+      return PriQty{};
+   }
+   /// 設定 pri 的數量, qty == 0 表示刪除該價位.
+   /// \retval false pri 不在價格階梯上(且 qty != 0), 此時不會改變任何資料.
+   bool Set(Pri pri, Qty qty, unsigned lvLimit, BookLvChg& chg) {
+      const int32_t idx = this->PriToIndex(pri);
+      if (fon9_UNLIKELY(idx < 0))
+         return qty == 0;
+      PriQty& slot = this->Slots_[static_cast<size_t>(idx)];
+      if (slot.Qty_ == qty)
+         return true;
+      chg.Level_ = this->IndexToLevel(idx, lvLimit);
+      if (slot.Qty_ == 0) {
+         chg.Action_ = RtBSAction::New;
+         ++this->Count_;
+         if (this->BestIdx_ < 0 || IsBetterIdx(idx, this->BestIdx_))
+            this->BestIdx_ = idx;
+      }
+      else if (qty == 0) {
+         chg.Action_ = RtBSAction::Delete;
+         if (--this->Count_ == 0)
+            this->BestIdx_ = -1;
+         else if (idx == this->BestIdx_) {
+            int32_t inext = idx + WorseStep();
+            while (this->Slots_[static_cast<size_t>(inext)].Qty_ == 0)
+               inext += WorseStep();
+            this->BestIdx_ = inext;
+         }
+      }
+      else {
+         chg.Action_ = RtBSAction::ChangeQty;
+      }
+      slot.Qty_ = qty;
+      return true;
+   }
+   /// 從最佳價開始, 依序呼叫 fn(const PriQty&), 若 fn() 返回 false 則停止.
+   template <class FnT>
+   void ForEachLevel(FnT&& fn) const {
+      unsigned count = this->Count_;
+      for (int32_t idx = this->BestIdx_; count > 0; idx += WorseStep()) {
+         const PriQty& slot = this->Slots_[static_cast<size_t>(idx)];
+         if (slot.Qty_ != 0) {
+            if (!fn(slot))
+               break;
+            --count;
+         }
+      }
+   }
+};
+
+/// \ingroup fmkt
+/// 價格階梯的 slot 數量上限, 超過此數量則使用排序 vector.
+enum : uint32_t {
+   kBookLadderMaxSlots = 64 * 1024,
+};
+
+/// \ingroup fmkt
+/// 委託簿單邊: 優先使用價格階梯, 若無法使用(沒有設定, 或價格不在階梯上)則使用排序 vector.
+template <bool isBuyT>
+class BookSide {
+   BookSideLadder<isBuyT>  Ladder_;
+   BookSideSorted<isBuyT>  Sorted_;
+   bool                    IsLadder_{false};
+   char                    Padding___[7];
+
+   void MoveLadderToSorted() {
+      std::vector<PriQty> lvs;
+      lvs.reserve(this->Ladder_.size());
+      this->Ladder_.ForEachLevel([&lvs](const PriQty& pq) {
+         lvs.push_back(pq);
+         return true;
+      });
+      this->Sorted_.AssignBestFirst(lvs.begin(), lvs.end());
+      this->Ladder_.Clear();
+      this->IsLadder_ = false;
+   }
+
+public:
+   /// 使用 steps 建立 [priLo..priHi] 之間的價格階梯, 若無法建立則使用排序 vector.
+   /// 會清除全部的檔位.
+   void Reset(const LvPriStep* steps, Pri priLo, Pri priHi, uint32_t maxSlots = kBookLadderMaxSlots) {
+      this->Sorted_.Clear();
+      this->IsLadder_ = this->Ladder_.Reset(steps, priLo, priHi, maxSlots);
+   }
+   /// 清除全部的檔位, 若有價格階梯則會保留.
+   void Clear() {
+      this->Sorted_.Clear();
+      if (this->Ladder_.IsReady()) {
+         this->Ladder_.Clear();
+         this->IsLadder_ = true;
+      }
+   }
+   bool IsLadder() const {
+      return this->IsLadder_;
+   }
+   bool empty() const {
+      return this->IsLadder_ ? this->Ladder_.empty() : this->Sorted_.empty();
+   }
+   size_t size() const {
+      return this->IsLadder_ ? this->Ladder_.size() : this->Sorted_.size();
+   }
+   const PriQty* Best() const {
+      return this->IsLadder_ ? this->Ladder_.Best() : this->Sorted_.Best();
+   }
+   PriQty GetLevel(unsigned lv) const {
+      return this->IsLadder_ ? this->Ladder_.GetLevel(lv) : this->Sorted_.GetLevel(lv);
+   }
+   /// 設定 pri 的數量, qty == 0 表示刪除該價位.
+   /// 傳回的 BookLvChg.Level_ 最大為 lvLimit, 表示異動的檔位 >= lvLimit;
+   BookLvChg Set(Pri pri, Qty qty, unsigned lvLimit) {
+      if (fon9_LIKELY(this->IsLadder_)) {
+         BookLvChg chg;
+         if (fon9_LIKELY(this->Ladder_.Set(pri, qty, lvLimit, chg)))
+            return chg;
+         // pri 不在價格階梯上(例: 超出漲跌停範圍, 或不符合 tick size), 改用排序 vector.
+         this->MoveLadderToSorted();
+      }
+      return this->Sorted_.Set(pri, qty, lvLimit);
+   }
+   template <class FnT>
+   void ForEachLevel(FnT&& fn) const {
+      if (this->IsLadder_)
+         this->Ladder_.ForEachLevel(std::forward<FnT>(fn));
+      else
+         this->Sorted_.ForEachLevel(std::forward<FnT>(fn));
+   }
+};
+//--------------------------------------------------------------------------//
+/// \ingroup fmkt
+/// 打包 f9sv_RtsPackType_UpdateBook 的內容(不含 InfoTime, MktSeq, RtsPackType).
+/// \code
+///   RevBufferList   rts{16};
+///   MdRtsBookPacker pk{rts};
+///   book.Flags_ = f9sv_BSFlag{};
+///   book.Set(RtBSType::OrderBuy, pri, qty, &pk);
+///   ...
+///   if (pk.Finish(false))
+///      symb.MdRtStream_.PublishUpdateBook(ToStrView(symb.SymbId_), book, std::move(rts), ctrlFlags);
+/// \endcode
+class fon9_API MdRtsBookPacker {
+   fon9_NON_COPY_NON_MOVE(MdRtsBookPacker);
+   RevBufferList& Rts_;
+   FwdBufferNode* Node_;
+   byte*          NodeEnd_;
+   unsigned       Count_{0};
+public:
+   enum : unsigned {
+      /// 一個 UpdateBook 封包, 最多可以打包的異動數量.
+      kMaxCount = 0x80,
+   };
+   MdRtsBookPacker(RevBufferList& rts);
+
+   unsigned Count() const {
+      return this->Count_;
+   }
+   bool IsFull() const {
+      return this->Count_ >= kMaxCount;
+   }
+   void Add(RtBSType bsType, RtBSAction act, unsigned lv, const PriQty& pq);
+   /// 在 rts 前端加上 count(1 byte: MSB = isCalculated);
+   /// \retval false 沒有任何異動, 不需要發行.
+   bool Finish(bool isCalculated);
+};
+//--------------------------------------------------------------------------//
+/// \ingroup fmkt
+/// SymbBookData 不含檔位的部分, 欄位與 SymbBSData 相同.
+struct SymbBookHead {
+   /// 報價時間.
+   DayTime        InfoTime_{DayTime::Null()};
+   /// 市場行情序號.
+   MarketDataSeq  MarketSeq_{0};
+   f9sv_BSFlag    Flags_{};
+   /// 由資訊來源提供, 若沒提供則為 0.
+   f9sv_BSLmtFlag LmtFlags_{};
+   char           Padding___[2];
+};
+
+/// \ingroup fmkt
+/// 深度委託簿.
+/// - 每一邊(買/賣)使用 BookSide 保存全部價格檔位:
+///   - 價格階梯: 依照 LvPriStep 在 [dnLmt..upLmt] 之間, 每個 tick 一個 slot, 異動時直接用價格計算位置.
+///   - 排序 vector: 沒有檔位設定, 或價格不在階梯上時使用.
+/// - SellSide_, BuySide_ 保存全部的價格檔位;
+/// - Sells_[], Buys_[] 為前 kDepthT 檔, 提供給 seed 欄位及訂閱者使用;
+template <unsigned kDepthT>
+struct SymbBookData : public SymbBookHead {
+   enum : unsigned {
+      /// 提供給 seed 欄位及訂閱者的檔位數量.
+      kDepth = kDepthT,
+   };
+   static_assert(kDepthT > 0, "SymbBookData: kDepthT must > 0");
+
+   /// 賣出價量列表, [0]=最佳賣出價量.
+   PriQty            Sells_[kDepth];
+   /// 買進價量列表, [0]=最佳買進價量.
+   PriQty            Buys_[kDepth];
+   BookSide<false>   SellSide_;
+   BookSide<true>    BuySide_;
+
+   /// 清除全部檔位, 保留價格階梯.
+   void Clear(DayTime tm = DayTime::Null()) {
+      this->InfoTime_ = tm;
+      this->MarketSeq_ = 0;
+      this->Flags_ = f9sv_BSFlag{};
+      this->LmtFlags_ = f9sv_BSLmtFlag{};
+      ForceZeroNonTrivial(&this->Sells_);
+      ForceZeroNonTrivial(&this->Buys_);
+      this->SellSide_.Clear();
+      this->BuySide_.Clear();
+   }
+   /// 使用 steps 在 [dnLmt..upLmt] 建立價格階梯, 會清除全部檔位.
+   /// 通常在取得今日漲跌停價之後呼叫, 若 steps == nullptr, 則使用排序 vector.
+   void ResetPriLadder(const LvPriStep* steps, Pri dnLmt, Pri upLmt) {
+      this->Clear(this->InfoTime_);
+      this->SellSide_.Reset(steps, dnLmt, upLmt);
+      this->BuySide_.Reset(steps, dnLmt, upLmt);
+   }
+   /// 設定 bsType(OrderBuy or OrderSell) 的 pri 價位數量為 qty(0 表示刪除該價位).
+   /// - 若異動影響前 kDepth 檔, 則更新 Sells_[] 或 Buys_[], 並將異動加入 pk(若 pk != nullptr);
+   /// - 若刪除可見的檔位, 且還有更深的檔位, 則將新露出的第 kDepth 檔用 ChangePQ 加入 pk;
+   /// \retval false 沒有影響前 kDepth 檔.
+   bool Set(RtBSType bsType, Pri pri, Qty qty, MdRtsBookPacker* pk) {
+      if (bsType == RtBSType::OrderBuy) {
+         this->Flags_ |= f9sv_BSFlag_OrderBuy;
+         return SetSide(this->BuySide_, this->Buys_, bsType, pri, qty, pk);
+      }
+      assert(bsType == RtBSType::OrderSell);
+      this->Flags_ |= f9sv_BSFlag_OrderSell;
+      return SetSide(this->SellSide_, this->Sells_, bsType, pri, qty, pk);
+   }
+
+private:
+   template <class SideT>
+   static bool SetSide(SideT& side, PriQty* lvs, RtBSType bsType, Pri pri, Qty qty, MdRtsBookPacker* pk) {
+      const BookLvChg chg = side.Set(pri, qty, kDepth);
+      if (chg.Level_ >= kDepth) // 沒異動, 或異動不在可見檔位.
+         return false;
+      PriQty* const dst = lvs + chg.Level_;
+      switch (chg.Action_) {
+      case RtBSAction::New:
+         if (auto mvc = kDepth - chg.Level_ - 1)
+            memmove(dst + 1, dst, mvc * sizeof(*dst));
+         dst->Pri_ = pri;
+         dst->Qty_ = qty;
+         break;
+      case RtBSAction::ChangeQty:
+         dst->Qty_ = qty;
+         break;
+      case RtBSAction::Delete:
+         if (auto mvc = kDepth - chg.Level_ - 1)
+            memmove(dst, dst + 1, mvc * sizeof(*dst));
+         lvs[kDepth - 1] = side.GetLevel(kDepth - 1);
+         if (pk) {
+            pk->Add(bsType, RtBSAction::Delete, chg.Level_, *dst);
+            if (lvs[kDepth - 1].Qty_ != 0)
+               pk->Add(bsType, RtBSAction::ChangePQ, kDepth - 1, lvs[kDepth - 1]);
+         }
+         return true;
+      case RtBSAction::ChangePQ:
+      default:
+         assert(!"SymbBookData.SetSide|err=Unknown RtBSAction");
+         return false;
+      }
+      if (pk)
+         pk->Add(bsType, chg.Action_, chg.Level_, *dst);
+      return true;
+   }
+};
+
+/// \ingroup fmkt
+/// 建立 SymbBookData 的欄位, 欄位名稱與 SymbTwsBS 相同("S1P", "B1Q"...), 所以 RcMdRtsDecoder 可直接使用.
+/// - ofsData = SymbBookHead 在 SymbData 裡面的位置.
+/// - ofsSells, ofsBuys = Sells_, Buys_ 在 SymbBookHead 衍生者裡面的位置.
+fon9_API seed::Fields SymbBook_MakeFields(int ofsData, int ofsSells, int ofsBuys, unsigned depth, bool isAddMarketSeq);
+
+/// \ingroup fmkt
+/// 商品資料的擴充: 深度委託簿.
+template <unsigned kDepthT>
+class SymbBook : public SimpleSymbData<SymbBookData<kDepthT>> {
+   fon9_NON_COPY_NON_MOVE(SymbBook);
+   using base = SimpleSymbData<SymbBookData<kDepthT>>;
+public:
+   using base::base;
+   SymbBook() = default;
+
+   static seed::Fields MakeFields(bool isAddMarketSeq) {
+      using Data = SymbBookData<kDepthT>;
+      return SymbBook_MakeFields(static_cast<int>(fon9_OffsetOf(SymbBook, Data_)),
+                                 static_cast<int>(fon9_OffsetOf(Data, Sells_)),
+                                 static_cast<int>(fon9_OffsetOf(Data, Buys_)),
+                                 kDepthT, isAddMarketSeq);
+   }
+};
+
+/// \ingroup fmkt
+/// 若 tab 名稱使用 fon9_kCSTR_TabName_BS, 則 RcMdRtsDecoder 可以解析 UpdateBook, SnapshotBook;
+template <unsigned kDepthT>
+class SymbBookTabDy : public SymbDataTab {
+   fon9_NON_COPY_NON_MOVE(SymbBookTabDy);
+   using base = SymbDataTab;
+public:
+   SymbBookTabDy(Named&& named, bool isAddMarketSeq = true)
+      : base{std::move(named), SymbBook<kDepthT>::MakeFields(isAddMarketSeq), seed::TabFlag::NoSapling_NoSeedCommand_Writable} {
+   }
+   SymbDataSP FetchSymbData(Symb&) override {
+      return SymbDataSP{new SymbBook<kDepthT>{}};
+   }
+};
+
+} } // namespaces
+#endif//__fon9_fmkt_SymbBook_hpp__
@@ -0,0 +1,259 @@
+﻿// \file fon9/fmkt/SymbBook_UT.cpp
+// \author fonwinz@gmail.com
+#include "fon9/fmkt/SymbBook.hpp"
+#include "fon9/TestTools.hpp"
+#include "fon9/BitvDecode.hpp"
+#include "fon9/buffer/DcQueueList.hpp"
+#include "fon9/Random.hpp"
+#include <map>
+
+namespace f9fmkt = fon9::fmkt;
+using Pri = f9fmkt::Pri;
+using Qty = f9fmkt::Qty;
+using PriQty = f9fmkt::PriQty;
+static const unsigned kDepth = 10;
+using TestBook = f9fmkt::SymbBookData<kDepth>;
+//--------------------------------------------------------------------------//
+/// 模擬訂閱端(RcMdRtsDecoder): 只有 kDepth 檔.
+struct ClientBook {
+   PriQty   Sells_[kDepth];
+   PriQty   Buys_[kDepth];
+
+   ClientBook() {
+      fon9::ForceZeroNonTrivial(this);
+   }
+   PriQty* GetSide(uint8_t bsType) {
+      return (bsType & fon9::cast_to_underlying(f9fmkt::RtBSType::Mask)) == fon9::cast_to_underlying(f9fmkt::RtBSType::OrderBuy)
+         ? this->Buys_ : this->Sells_;
+   }
+   void DecodeUpdateBook(fon9::DcQueue& rxbuf) {
+      const uint8_t* first = static_cast<const uint8_t*>(rxbuf.Peek1());
+      unsigned count = (*first & 0x7fu) + 1;
+      rxbuf.PopConsumed(1);
+      for (; count > 0; --count) {
+         const uint8_t bsType = *static_cast<const uint8_t*>(rxbuf.Peek1());
+         rxbuf.PopConsumed(1);
+         unsigned lv{};
+         fon9::BitvTo(rxbuf, lv);
+         PriQty* lvs = this->GetSide(bsType);
+         if (lv >= kDepth) {
+            std::cout << "[ERROR] UpdateBook: Level=" << lv << std::endl;
+            abort();
+         }
+         switch (static_cast<f9fmkt::RtBSAction>(bsType & fon9::cast_to_underlying(f9fmkt::RtBSAction::Mask))) {
+         case f9fmkt::RtBSAction::New:
+            memmove(lvs + lv + 1, lvs + lv, (kDepth - lv - 1) * sizeof(*lvs));
+            /* fall through */
+         case f9fmkt::RtBSAction::ChangePQ:
+            fon9::BitvTo(rxbuf, lvs[lv].Pri_);
+            fon9::BitvTo(rxbuf, lvs[lv].Qty_);
+            break;
+         case f9fmkt::RtBSAction::ChangeQty:
+            fon9::BitvTo(rxbuf, lvs[lv].Qty_);
+            break;
+         case f9fmkt::RtBSAction::Delete:
+            memmove(lvs + lv, lvs + lv + 1, (kDepth - lv - 1) * sizeof(*lvs));
+            fon9::ForceZeroNonTrivial(lvs + kDepth - 1);
+            break;
+         }
+      }
+      if (!rxbuf.empty()) {
+         std::cout << "[ERROR] UpdateBook: remain data." << std::endl;
+         abort();
+      }
+   }
+   void DecodeSnapshotSide(fon9::DcQueue& rxbuf, PriQty* lvs) {
+      fon9::ForceZeroNonTrivial(reinterpret_cast<PriQty(*)[kDepth]>(lvs));
+      unsigned count{};
+      fon9::BitvTo(rxbuf, count);
+      for (unsigned L = 0; L < count; ++L) {
+         fon9::BitvTo(rxbuf, lvs[L].Pri_);
+         fon9::BitvTo(rxbuf, lvs[L].Qty_);
+      }
+   }
+   void DecodeSnapshotBook(fon9::DcQueue& rxbuf) {
+      const auto bsFlags = static_cast<f9sv_BSFlag>(*static_cast<const uint8_t*>(rxbuf.Peek1()));
+      rxbuf.PopConsumed(1);
+      if (IsEnumContains(bsFlags, f9sv_BSFlag_OrderSell))
+         this->DecodeSnapshotSide(rxbuf, this->Sells_);
+      if (IsEnumContains(bsFlags, f9sv_BSFlag_OrderBuy))
+         this->DecodeSnapshotSide(rxbuf, this->Buys_);
+   }
+};
+//--------------------------------------------------------------------------//
+static bool IsSamePQs(const PriQty* lhs, const PriQty* rhs) {
+   for (unsigned L = 0; L < kDepth; ++L) {
+      if (lhs[L].Qty_ != rhs[L].Qty_)
+         return false;
+      if (lhs[L].Qty_ != 0 && lhs[L].Pri_ != rhs[L].Pri_)
+         return false;
+   }
+   return true;
+}
+template <class MapT>
+static void MakeExpected(const MapT& map, PriQty* lvs) {
+   fon9::ForceZeroNonTrivial(reinterpret_cast<PriQty(*)[kDepth]>(lvs));
+   unsigned lv = 0;
+   for (auto i = map.begin(); i != map.end() && lv < kDepth; ++i, ++lv) {
+      lvs[lv].Pri_ = i->first;
+      lvs[lv].Qty_ = i->second;
+   }
+}
+static void CheckResult(const char* msg, bool isOK, unsigned step) {
+   if (isOK)
+      return;
+   std::cout << "[ERROR] " << msg << "|step=" << step << std::endl;
+   abort();
+}
+//--------------------------------------------------------------------------//
+void TestRandomUpdate(const char* testName, const f9fmkt::LvPriStep* steps, Pri dnLmt, Pri upLmt, bool isTestOutOfLadder) {
+   std::cout << "[TEST ] " << testName;
+   std::vector<Pri> pris;
+   if (steps) {
+      for (Pri pri = f9fmkt::MoveTicksUp(steps, dnLmt, 0, upLmt);; pri = f9fmkt::MoveTicksUp(steps, pri, 1, upLmt)) {
+         pris.push_back(pri);
+         if (pri >= upLmt)
+            break;
+      }
+   }
+   else {
+      for (Pri pri = dnLmt; pri <= upLmt; pri += Pri{1, 2})
+         pris.push_back(pri);
+   }
+   TestBook book;
+   book.ResetPriLadder(steps, dnLmt, upLmt);
+   CheckResult("IsLadder", book.SellSide_.IsLadder() == (steps != nullptr)
+                        && book.BuySide_.IsLadder() == (steps != nullptr), 0);
+
+   ClientBook                          cli;
+   std::map<Pri, Qty>                  refSells;
+   std::map<Pri, Qty, std::greater<Pri>> refBuys;
+   PriQty                              expected[kDepth];
+   std::uniform_int_distribution<size_t>  rndPri{0, pris.size() - 1};
+   std::uniform_int_distribution<unsigned> rndQty{0, 3};
+   const unsigned kSteps = 100 * 1000;
+   for (unsigned step = 1; step <= kSteps; ++step) {
+      const bool  isBuy = ((step & 1) == 0);
+      const bool  isOutOfLadder = (isTestOutOfLadder && step == kSteps / 2);
+      const Pri   pri = isOutOfLadder ? (upLmt + Pri{1,0}) : pris[rndPri(fon9::GetRandomEngine())];
+      // 超出 ladder 的價格必須是「新增」, 若 qty == 0 則為刪除不存在的價位, 不會改成 sorted.
+      const Qty   qty = isOutOfLadder ? Qty{1} : rndQty(fon9::GetRandomEngine());
+      if (isBuy) {
+         if (qty == 0)
+            refBuys.erase(pri);
+         else
+            refBuys[pri] = qty;
+      }
+      else {
+         if (qty == 0)
+            refSells.erase(pri);
+         else
+            refSells[pri] = qty;
+      }
+      fon9::RevBufferList     rts{16};
+      f9fmkt::MdRtsBookPacker pk{rts};
+      book.Set(isBuy ? f9fmkt::RtBSType::OrderBuy : f9fmkt::RtBSType::OrderSell, pri, qty, &pk);
+      if (pk.Finish(false)) {
+         fon9::DcQueueList dcq{rts.MoveOut()};
+         cli.DecodeUpdateBook(dcq);
+      }
+      if (isBuy) {
+         MakeExpected(refBuys, expected);
+         CheckResult("Buys", IsSamePQs(book.Buys_, expected), step);
+         CheckResult("BuySide.size", book.BuySide_.size() == refBuys.size(), step);
+         CheckResult("BuySide.Best", refBuys.empty() ? book.BuySide_.Best() == nullptr
+                     : (book.BuySide_.Best()->Pri_ == refBuys.begin()->first), step);
+      }
+      else {
+         MakeExpected(refSells, expected);
+         CheckResult("Sells", IsSamePQs(book.Sells_, expected), step);
+         CheckResult("SellSide.size", book.SellSide_.size() == refSells.size(), step);
+         CheckResult("SellSide.Best", refSells.empty() ? book.SellSide_.Best() == nullptr
+                     : (book.SellSide_.Best()->Pri_ == refSells.begin()->first), step);
+      }
+      CheckResult("Client.Sells", IsSamePQs(cli.Sells_, book.Sells_), step);
+      CheckResult("Client.Buys", IsSamePQs(cli.Buys_, book.Buys_), step);
+   }
+   if (isTestOutOfLadder)
+      CheckResult("OutOfLadder", book.SellSide_.IsLadder() && !book.BuySide_.IsLadder(), kSteps);
+
+   // 快照.
+   fon9::RevBufferList rts{128};
+   f9fmkt::MdRtsPackSnapshotBook(rts, f9sv_BSFlag_OrderBuy | f9sv_BSFlag_OrderSell, book.Sells_, book.Buys_, kDepth);
+   ClientBook snapshot;
+   fon9::DcQueueList dcq{rts.MoveOut()};
+   snapshot.DecodeSnapshotBook(dcq);
+   CheckResult("Snapshot.Sells", IsSamePQs(snapshot.Sells_, book.Sells_), kSteps);
+   CheckResult("Snapshot.Buys", IsSamePQs(snapshot.Buys_, book.Buys_), kSteps);
+   CheckResult("Snapshot.remain", dcq.empty(), kSteps);
+   std::cout << "|sells=" << refSells.size() << "|buys=" << refBuys.size() << "\r[OK   ]" << std::endl;
+}
+//--------------------------------------------------------------------------//
+void TestLadderIndex(const f9fmkt::LvPriStep* steps, Pri dnLmt, Pri upLmt) {
+   std::cout << "[TEST ] LadderIndex";
+   f9fmkt::BookSideLadder<true> ladder;
+   CheckResult("Reset", ladder.Reset(steps, dnLmt, upLmt, f9fmkt::kBookLadderMaxSlots), 0);
+   unsigned idx = 0;
+   for (Pri pri = f9fmkt::MoveTicksUp(steps, dnLmt, 0, upLmt);; pri = f9fmkt::MoveTicksUp(steps, pri, 1, upLmt)) {
+      CheckResult("PriToIndex", ladder.PriToIndex(pri) == static_cast<int32_t>(idx), idx);
+      ++idx;
+      if (pri >= upLmt)
+         break;
+   }
+   CheckResult("SlotCount", ladder.SlotCount() == idx, idx);
+   CheckResult("Under dnLmt", ladder.PriToIndex(dnLmt - Pri{1,0}) < 0, idx);
+   CheckResult("Over upLmt", ladder.PriToIndex(upLmt + Pri{1,0}) < 0, idx);
+   CheckResult("Bad tick", ladder.PriToIndex(Pri{5001, 2}) < 0, idx);
+   CheckResult("Too many slots", !ladder.Reset(steps, dnLmt, upLmt, 10), idx);
+   std::cout << "|slots=" << idx << "\r[OK   ]" << std::endl;
+}
+//--------------------------------------------------------------------------//
+template <class SideT>
+void BenchSide(const char* msg, SideT& side, const std::vector<Pri>& pris) {
+   const unsigned kTimes = 1000 * 1000;
+   std::vector<uint32_t> idxs(kTimes);
+   // 模擬行情: 大部分的異動集中在最佳價附近.
+   std::normal_distribution<double> rnd{static_cast<double>(pris.size()) / 2, 10};
+   for (uint32_t& idx : idxs) {
+      double v = rnd(fon9::GetRandomEngine());
+      idx = static_cast<uint32_t>(v < 0 ? 0 : v >= static_cast<double>(pris.size()) ? static_cast<double>(pris.size() - 1) : v);
+   }
+   fon9::StopWatch stopWatch;
+   for (unsigned L = 0; L < kTimes; ++L)
+      side.Set(pris[idxs[L]], L % 5, kDepth);
+   stopWatch.PrintResult(msg, kTimes);
+}
+void BenchBookSide(const f9fmkt::LvPriStep* steps, Pri dnLmt, Pri upLmt) {
+   std::vector<Pri> pris;
+   for (Pri pri = f9fmkt::MoveTicksUp(steps, dnLmt, 0, upLmt);; pri = f9fmkt::MoveTicksUp(steps, pri, 1, upLmt)) {
+      pris.push_back(pri);
+      if (pri >= upLmt)
+         break;
+   }
+   f9fmkt::BookSide<true> ladder;
+   ladder.Reset(steps, dnLmt, upLmt);
+   f9fmkt::BookSide<true> sorted;
+   sorted.Reset(nullptr, dnLmt, upLmt);
+   BenchSide("BookSide.Ladder", ladder, pris);
+   BenchSide("BookSide.Sorted", sorted, pris);
+}
+//--------------------------------------------------------------------------//
+int main(int argc, char** argv) {
+   (void)argc; (void)argv;
+   #if defined(_MSC_VER) && defined(_DEBUG)
+      _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+   #endif
+   fon9::AutoPrintTestInfo utinfo{"SymbBook"};
+
+   // 台灣證券的升降單位.
+   f9fmkt::LvPriStepVect lvSteps;
+   lvSteps.FromStr("10=0.01|50=0.05|100=0.1|500=0.5|1000=1|5");
+   const Pri dnLmt{45,0}, upLmt{55,0};
+   TestLadderIndex(lvSteps.Get(), dnLmt, upLmt);
+   TestRandomUpdate("Ladder", lvSteps.Get(), dnLmt, upLmt, false);
+   TestRandomUpdate("Sorted", nullptr, dnLmt, upLmt, false);
+   TestRandomUpdate("Ladder=>Sorted", lvSteps.Get(), dnLmt, upLmt, true);
+
+   utinfo.PrintSplitter();
+   BenchBookSide(lvSteps.Get(), Pri{900,0}, Pri{1100,0});
+}
@@ -19,6 +19,7 @@ extern "C" {
 #define fon9_kCSTR_TabName_DynBand  "DynBand"
 #define fon9_kCSTR_TabName_QuoteReq "QuoteReq"
 #define fon9_kCSTR_TabName_Rt       "Rt"
+#define fon9_kCSTR_TabName_Bars     "Bars"
 
 #ifdef __cplusplus
 }
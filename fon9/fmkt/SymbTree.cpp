@@ -1,6 +1,7 @@
 ﻿// \file fon9/fmkt/SymbTree.cpp
 // \author fonwinz@gmail.com
 #include "fon9/fmkt/SymbTree.hpp"
+#include "fon9/fmkt/SymbTreeSharded.hpp"
 #include "fon9/seed/RawWr.hpp"
 #include "fon9/RevPrint.hpp"
 
@@ -33,19 +34,29 @@ SymbTree::~SymbTree() {
 //--------------------------------------------------------------------------//
 MdSymbTree::~MdSymbTree() {
 }
-void MdSymbTree::LockedDailyClear(Locker& symbs, unsigned tdayYYYYMMDD) {
-   auto iend = symbs->end();
-   for (auto ibeg = symbs->begin(); ibeg != iend;) {
+fon9_API void MdSymbMapDailyClear(SymbTree& tree, MdSymbMap& symbs, unsigned tdayYYYYMMDD) {
+   auto iend = symbs.end();
+   for (auto ibeg = symbs.begin(); ibeg != iend;) {
       auto& symb = *ibeg->second;
       if (!symb.IsExpired(tdayYYYYMMDD)) {
-         symb.DailyClear(*this, tdayYYYYMMDD);
+         symb.DailyClear(tree, tdayYYYYMMDD);
          ++ibeg;
       }
       else { // 移除已下市商品, 移除時需觸發 PodRemoved 事件.
-         symb.OnBeforeRemove(*this, tdayYYYYMMDD);
-         ibeg = symbs->erase(ibeg);
+         symb.OnBeforeRemove(tree, tdayYYYYMMDD);
+         ibeg = symbs.erase(ibeg);
       }
    }
 }
+void MdSymbTree::LockedDailyClear(Locker& symbs, unsigned tdayYYYYMMDD) {
+   MdSymbMapDailyClear(*this, *symbs, tdayYYYYMMDD);
+}
+//--------------------------------------------------------------------------//
+MdSymbTreeSharded::~MdSymbTreeSharded() {
+}
+void MdSymbTreeSharded::LockedDailyClear(AllLocker& symbs, unsigned tdayYYYYMMDD) {
+   for (unsigned L = 0; L < kShardCount; ++L)
+      MdSymbMapDailyClear(*this, *symbs[L], tdayYYYYMMDD);
+}
 
 } } // namespaces
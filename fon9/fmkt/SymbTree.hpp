@@ -9,6 +9,21 @@
 
 namespace fon9 { namespace fmkt {
 
+/// \ingroup fmkt
+/// 讀取 dat(symbMap 裡面商品的資料), fnRead(const SymbData& rd);
+/// - 若 symbMap 使用 SeqLockMutex, 且 dat 支援快照(SymbData::ReadSnapshot()), 則不鎖定 symbMap, rd = 快照.
+/// - 否則鎖定 symbMap 之後, 呼叫 fnRead(dat);
+/// - 呼叫前, symbMap 必須在解鎖狀態.
+template <class SymbMap, class FnRead>
+inline void ReadSymbDataSnapshot(SymbMap& symbMap, const SymbData& dat, FnRead&& fnRead) {
+   if (const SeqLock* seqLock = GetSeqLock(symbMap.GetMutex())) {
+      if (dat.ReadSnapshot(*seqLock, std::ref(fnRead)))
+         return;
+   }
+   typename SymbMap::Locker lk{symbMap};
+   fnRead(dat);
+}
+
 class fon9_API SymbPodOp : public seed::PodOpDefault {
    fon9_NON_COPY_NON_MOVE(SymbPodOp);
    using base = seed::PodOpDefault;
@@ -23,6 +38,25 @@ public:
 
    void BeginRead(seed::Tab& tab, seed::FnReadOp fnCallback) override;
    void BeginWrite(seed::Tab& tab, seed::FnWriteOp fnCallback) override;
+
+protected:
+   /// 在 symbMap 解鎖狀態下的 BeginRead(): 使用 ReadSymbDataSnapshot() 讀取.
+   template <class SymbMap>
+   void BeginReadSnapshot(SymbMap& symbMap, seed::Tab& tab, seed::FnReadOp&& fnCallback) {
+      SymbData* dat;
+      {  // Symb::GetSymbData() 可能會存取 Symb 的動態資料(例: SymbDy), 所以仍需要鎖定.
+         typename SymbMap::Locker lk{symbMap};
+         dat = this->Symb_->GetSymbData(tab.GetIndex());
+      }
+      if (dat == nullptr) {
+         this->OpResult_ = seed::OpResult::not_found_seed;
+         fnCallback(*this, nullptr);
+         return;
+      }
+      ReadSymbDataSnapshot(symbMap, *dat, [this, &tab, &fnCallback](const SymbData& rd) {
+         this->BeginRW(tab, std::move(fnCallback), seed::SimpleRawRd{rd});
+      });
+   }
 };
 
 class SymbTreeOp : public seed::TreeOp {
@@ -51,6 +85,60 @@ public:
       seed::MakeGridViewUnordered(c, c.end(), req, res, &MakeRowView<typename Container::const_iterator>);
    }
 
+   /// 使用快照的 GridView, 一筆資料.
+   template <class SymbMap>
+   struct SnapshotRow {
+      StrView     Key_;
+      /// 保留商品, 避免在解鎖後商品被移除.
+      SymbSP      Symb_;
+      SymbData*   Dat_;
+      SymbMap*    SymbMap_;
+   };
+   template <class SymbMap>
+   using SnapshotRows = std::vector<SnapshotRow<SymbMap>>;
+
+   /// 使用 SeqLockMutex 的 unordered SymbMap(req.OrigKey_ = "key list"), 避免查詢期間長時間鎖定 SymbMap:
+   /// - 先在鎖定狀態下呼叫 FetchSnapshotRows(): 取出 key list 的商品及資料位置;
+   ///   SymbMap* fnFind(const StrView& key, SymbSP& symb); 返回 key 所在的 SymbMap, 找不到商品則 symb 為 nullptr;
+   /// - 解鎖後再呼叫 MakeSnapshotGridView(): 使用 ReadSymbDataSnapshot() 讀取資料, 建立 res.GridView_;
+   template <class SymbMap, class FnFind>
+   static bool FetchSnapshotRows(const seed::GridViewRequest& req, seed::GridViewResult& res,
+                                 SnapshotRows<SymbMap>& rows, FnFind&& fnFind) {
+      if (req.OrigKey_.Get1st() != seed::GridViewResult::kCellSplitter) {
+         res.OpResult_ = seed::OpResult::not_supported_grid_view;
+         return false;
+      }
+      // 與 seed::MakeGridViewUnordered() 相同, 從最後一個 key 開始, 因為 RevBuffer 是從尾端往前填.
+      StrView keys{req.OrigKey_.begin() + 1, req.OrigKey_.end()};
+      for (;;) {
+         const char* pkey = static_cast<const char*>(memrchr(keys.begin(), seed::GridViewResult::kCellSplitter, keys.size()));
+         rows.emplace_back();
+         SnapshotRow<SymbMap>& row = rows.back();
+         row.Key_.Reset(pkey ? (pkey + 1) : keys.begin(), keys.end());
+         row.SymbMap_ = fnFind(row.Key_, row.Symb_);
+         row.Dat_ = (row.Symb_ && res.Tab_) ? row.Symb_->GetSymbData(res.Tab_->GetIndex()) : nullptr;
+         if (pkey == nullptr)
+            return true;
+         keys.SetEnd(pkey);
+      }
+   }
+   template <class SymbMap>
+   static void MakeSnapshotGridView(const SnapshotRows<SymbMap>& rows, seed::GridViewResult& res) {
+      RevBufferList rbuf{256};
+      for (auto irow = rows.begin(); irow != rows.end(); ++irow) {
+         if (irow != rows.begin())
+            RevPrint(rbuf, seed::GridViewResult::kRowSplitter);
+         if (irow->Dat_) {
+            const seed::Fields& flds = res.Tab_->Fields_;
+            ReadSymbDataSnapshot(*irow->SymbMap_, *irow->Dat_, [&flds, &rbuf](const SymbData& rd) {
+               FieldsCellRevPrint(flds, seed::SimpleRawRd{rd}, rbuf, seed::GridViewResult::kCellSplitter);
+            });
+         }
+         RevPrint(rbuf, irow->Key_);
+      }
+      res.GridView_ = BufferTo<std::string>(rbuf.MoveOut());
+   }
+
    template <class Container>
    static void GetHasher(...);
 
@@ -94,10 +182,11 @@ public:
    ~SymbTree();
 };
 //--------------------------------------------------------------------------//
-template <class SymbMapImplT, class MutexT>
-class SymbTreeT : public SymbTree {
+/// TreeBaseT 必須衍生自 SymbTree, 例: MdSymbsBase;
+template <class SymbMapImplT, class MutexT, class TreeBaseT = SymbTree>
+class SymbTreeT : public TreeBaseT {
    fon9_NON_COPY_NON_MOVE(SymbTreeT);
-   using base = SymbTree;
+   using base = TreeBaseT;
 
 public:
    using SymbMapImpl = SymbMapImplT;
@@ -147,13 +236,30 @@ protected:
       using base = SymbPodOp;
    public:
       const Locker&  LockedMap_;
-      PodOp(Tree& sender, const StrView& keyText, SymbSP&& symb, const Locker& lockedMap)
+      PodOp(seed::Tree& sender, const StrView& keyText, SymbSP&& symb, const Locker& lockedMap)
          : base(sender, keyText, std::move(symb))
          , LockedMap_(lockedMap) {
       }
       void OnAfterPodOpWrite(seed::Tab& tab) override {
          static_cast<SymbTreeT*>(this->Sender_)->OnAfterPodOpWrite(*this->Symb_, tab, this->LockedMap_);
       }
+      /// 若 SymbMap 使用 SeqLockMutex, 則 TreeOp::Get() 在找到商品後就會解鎖;
+      /// 需要鎖定的操作(寫入、訂閱...), 必須先透過此處重新鎖定, 在 PodOp 結束後才會解鎖.
+      const Locker& LockMap() {
+         // LockedMap_ 為 TreeOp 建立的 Locker, 並非 const 物件, 所以可以安全的 const_cast.
+         const_cast<Locker*>(&this->LockedMap_)->Relock(*this->LockedMap_.GetOwner());
+         return this->LockedMap_;
+      }
+      void BeginRead(seed::Tab& tab, seed::FnReadOp fnCallback) override {
+         if (this->LockedMap_.owns_lock())
+            base::BeginRead(tab, std::move(fnCallback));
+         else
+            this->BeginReadSnapshot(*this->LockedMap_.GetOwner(), tab, std::move(fnCallback));
+      }
+      void BeginWrite(seed::Tab& tab, seed::FnWriteOp fnCallback) override {
+         this->LockMap();
+         base::BeginWrite(tab, std::move(fnCallback));
+      }
    };
    class TreeOp : public SymbTreeOp {
       fon9_NON_COPY_NON_MOVE(TreeOp);
@@ -164,8 +270,25 @@ protected:
 
       void GridView(const seed::GridViewRequest& req, seed::FnGridViewOp fnCallback) override {
          seed::GridViewResult res{this->Tree_, req.Tab_};
-         {
-            Locker lockedMap{static_cast<SymbTreeT*>(&this->Tree_)->SymbMap_};
+         SymbMap& symbMap = static_cast<SymbTreeT*>(&this->Tree_)->SymbMap_;
+         if (GetSeqLock(symbMap.GetMutex()) && TestHasHasher<SymbMapImpl>::HasHasher) {
+            SnapshotRows<SymbMap> rows;
+            bool isFetched;
+            {
+               Locker lockedMap{symbMap};
+               res.SetContainerSize(lockedMap.get());
+               isFetched = FetchSnapshotRows(req, res, rows, [&lockedMap, &symbMap](const StrView& key, SymbSP& symb) {
+                  auto ifind = seed::GetIteratorForPod(*lockedMap, key);
+                  if (ifind != lockedMap->end())
+                     symb.reset(&GetSymbValue(*ifind));
+                  return &symbMap;
+               });
+            } // unlock map.
+            if (isFetched)
+               MakeSnapshotGridView(rows, res);
+         }
+         else {
+            Locker lockedMap{symbMap};
             this->MakeGridView(*lockedMap, req, res);
          } // unlock map.
          fnCallback(res);
@@ -184,6 +307,9 @@ protected:
       void Get(StrView strKeyText, seed::FnPodOp fnCallback) override {
          Locker lockedMap{static_cast<SymbTreeT*>(&this->Tree_)->SymbMap_};
          SymbSP symb = static_cast<SymbTreeT*>(&this->Tree_)->GetSymb(lockedMap, strKeyText);
+         // 使用 SeqLockMutex: 讀取時使用快照, 所以找到商品後就可以解鎖, 需要時再由 PodOp::LockMap() 鎖定.
+         if (GetSeqLock(lockedMap.GetOwner()->GetMutex()))
+            lockedMap.unlock();
          this->OnPodOp(strKeyText, std::move(symb), std::move(fnCallback), lockedMap);
       }
       void Add(StrView strKeyText, seed::FnPodOp fnCallback) override {
@@ -213,9 +339,11 @@ protected:
 
 /// \ingroup fmkt
 /// 商品資料表, 一般行情系統使用: multi thread(mutex) + unordered
-class fon9_API MdSymbTree : public SymbTreeT<MdSymbMap, std::mutex> {
+/// - 使用 SeqLockMutex: 查詢(Get, GridView)時, 支援快照的商品資料(SimpleSymbData), 不須鎖定即可讀取,
+///   避免大量查詢時, 造成行情更新(鎖定 SymbMap_)的延遲.
+class fon9_API MdSymbTree : public SymbTreeT<MdSymbMap, SeqLockMutex<std::mutex>> {
    fon9_NON_COPY_NON_MOVE(MdSymbTree);
-   using base = SymbTreeT<MdSymbMap, std::mutex>;
+   using base = SymbTreeT<MdSymbMap, SeqLockMutex<std::mutex>>;
 public:
    using base::base;
    ~MdSymbTree();
@@ -223,7 +351,11 @@ public:
    void LockedDailyClear(Locker& symbs, unsigned tdayYYYYMMDD);
 };
 // 使用 fon9_API_TEMPLATE_CLASS 造成 VS 2015 Debug build 失敗?!
-// fon9_API_TEMPLATE_CLASS(MdSymbTree, SymbTreeT, MdSymbMap, std::mutex);
+// fon9_API_TEMPLATE_CLASS(MdSymbTree, SymbTreeT, MdSymbMap, SeqLockMutex<std::mutex>);
+
+/// 商品表的 DailyClear: 移除已下市的商品(觸發 OnBeforeRemove()), 其餘的商品呼叫 symb.DailyClear();
+/// 呼叫前 symbs 必須在鎖定狀態.
+fon9_API void MdSymbMapDailyClear(SymbTree& tree, MdSymbMap& symbs, unsigned tdayYYYYMMDD);
 
 } } // namespaces
 #endif//__fon9_fmkt_SymbTree_hpp__
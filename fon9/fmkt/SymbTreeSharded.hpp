@@ -0,0 +1,303 @@
+﻿// \file fon9/fmkt/SymbTreeSharded.hpp
+// \author fonwinz@gmail.com
+#ifndef __fon9_fmkt_SymbTreeSharded_hpp__
+#define __fon9_fmkt_SymbTreeSharded_hpp__
+#include "fon9/fmkt/SymbTree.hpp"
+
+namespace fon9 { namespace fmkt {
+
+/// \ingroup fmkt
+/// 依照商品Id的 hash, 將商品分散到 (1 << kShardBitsT) 個 shard, 每個 shard 有自己的 mutex.
+/// - 不同 thread 處理不同商品(e.g. 不同行情頻道), 大多不會在同一個 mutex 上排隊.
+/// - 處理單一商品: 使用 LockShard(symbid) 取得該商品所在 shard 的 Locker;
+///   此 Locker 與 SymbTreeT::Locker 為相同型別, 所以 Symb 相關的函式(例: MdRtStream)可直接使用.
+/// - 處理整棵樹(e.g. GridView, SaveTo, DailyClear): 使用 AllLocker, 依序鎖定全部的 shards,
+///   在 AllLocker 解構前, 看到的是一致的全部商品.
+/// - 鎖定順序: 已鎖定某個 shard 時, 不可再鎖定其他 shard, 也不可使用 AllLocker, 否則可能死結.
+/// TreeBaseT 必須衍生自 SymbTree, 例: MdSymbsBase;
+template <class SymbMapImplT, class MutexT, unsigned kShardBitsT = 4, class TreeBaseT = SymbTree>
+class SymbTreeShardedT : public TreeBaseT {
+   fon9_NON_COPY_NON_MOVE(SymbTreeShardedT);
+   using base = TreeBaseT;
+
+public:
+   using SymbMapImpl = SymbMapImplT;
+   using SymbMap = MustLock<SymbMapImpl, MutexT>;
+   using Locker = typename SymbMap::Locker;
+   using ConstLocker = typename SymbMap::ConstLocker;
+   static constexpr unsigned kShardCount = (1u << kShardBitsT);
+
+private:
+   /// 避免相鄰 shard 的 mutex 在同一個 cache line, 造成不同 thread 之間的 false sharing.
+   /// 使用補齊大小的方式, 讓相鄰 shard 的相同欄位至少相隔 64 bytes;
+   /// 不使用 alignas(64): 在 C++11 的 new 不保證超過 alignof(std::max_align_t) 的對齊.
+   struct Shard : public SymbMap {
+      char  Padding___[64 - sizeof(SymbMap) % 64];
+   };
+   Shard Shards_[kShardCount];
+
+public:
+   using base::base;
+
+   static unsigned GetShardIndex(const StrView& symbid) {
+      // 因為 SymbMapImpl 若為 unordered_map, 也是使用 std::hash<StrView>,
+      // 所以這裡取用 hash 的高位元, 避免與 shard 內部的 bucket 分布相關.
+      const uint64_t h = static_cast<uint64_t>(std::hash<StrView>{}(symbid)) * UINT64_C(0x9E3779B97F4A7C15);
+      return static_cast<unsigned>(h >> (64 - kShardBitsT));
+   }
+   SymbMap& GetShard(const StrView& symbid) {
+      return this->Shards_[GetShardIndex(symbid)];
+   }
+   SymbMap& GetShardAt(unsigned shardIndex) {
+      assert(shardIndex < kShardCount);
+      return this->Shards_[shardIndex];
+   }
+   /// 鎖定 symbid 所在的 shard.
+   Locker LockShard(const StrView& symbid) {
+      return this->GetShard(symbid).Lock();
+   }
+
+   /// 依照 shard 的順序, 鎖定全部的 shards.
+   class AllLocker {
+      fon9_NON_COPY_NON_MOVE(AllLocker);
+      Locker   Lockers_[kShardCount];
+   public:
+      AllLocker(SymbTreeShardedT& tree) {
+         for (unsigned L = 0; L < kShardCount; ++L)
+            this->Lockers_[L] = tree.Shards_[L].Lock();
+      }
+      /// 反向解鎖.
+      void unlock() {
+         for (unsigned L = kShardCount; L > 0;) {
+            Locker& lk = this->Lockers_[--L];
+            if (lk.owns_lock())
+               lk.unlock();
+         }
+      }
+      Locker& operator[](unsigned shardIndex) {
+         assert(shardIndex < kShardCount);
+         return this->Lockers_[shardIndex];
+      }
+      /// 全部 shards 的商品數量.
+      size_t size() const {
+         size_t retval = 0;
+         for (const Locker& lk : this->Lockers_)
+            retval += lk->size();
+         return retval;
+      }
+      /// fnSymb(Symb&); 依照 shard 的順序, 列舉全部的商品.
+      template <class FnSymb>
+      void ForEachSymb(FnSymb&& fnSymb) const {
+         for (const Locker& lk : this->Lockers_) {
+            for (const auto& isymb : *lk)
+               fnSymb(GetSymbValue(isymb));
+         }
+      }
+   };
+   void OnTreeOp(seed::FnTreeOp fnCallback) override {
+      TreeOp op{*this};
+      fnCallback(seed::TreeOpResult{this, seed::OpResult::no_error}, &op);
+   }
+   void OnParentSeedClear() override {
+      for (SymbMap& shard : this->Shards_) {
+         SymbMapImpl symbs{std::move(*shard.Lock())};
+         // unlock 後, symbs 解構時, 自動清除.
+      }
+   }
+
+   /// PodOp 操作資料異動後通知, symbs = 商品所在 shard 的 Locker.
+   /// 預設: do nothing.
+   virtual void OnAfterPodOpWrite(Symb& symb, seed::Tab& tab, const Locker& symbs) {
+      (void)symb; (void)tab; (void)symbs;
+   }
+
+   /// symbs 必須是 LockShard(symbid) 的結果.
+   SymbSP FetchSymb(const Locker& symbs, const StrView& symbid) {
+      assert(symbs.GetOwner() == &this->GetShard(symbid));
+      auto ifind = symbs->find(symbid);
+      if (ifind != symbs->end())
+         return SymbSP{&GetSymbValue(*ifind)};
+      return InsertSymb(*symbs, this->MakeSymbBeforeInsert(symbid, &symbs));
+   }
+   SymbSP FetchSymb(const StrView& symbid) {
+      return this->FetchSymb(this->LockShard(symbid), symbid);
+   }
+   /// symbs 必須是 LockShard(symbid) 的結果.
+   SymbSP GetSymb(const Locker& symbs, const StrView& symbid) {
+      assert(symbs.GetOwner() == &this->GetShard(symbid));
+      auto ifind = symbs->find(symbid);
+      return ifind == symbs->end() ? SymbSP{nullptr} : SymbSP{&GetSymbValue(*ifind)};
+   }
+   SymbSP GetSymb(const StrView& symbid) {
+      return this->GetSymb(this->LockShard(symbid), symbid);
+   }
+
+protected:
+   class PodOp : public SymbPodOp {
+      fon9_NON_COPY_NON_MOVE(PodOp);
+      using base = SymbPodOp;
+   public:
+      const Locker&  LockedMap_;
+      PodOp(seed::Tree& sender, const StrView& keyText, SymbSP&& symb, const Locker& lockedMap)
+         : base(sender, keyText, std::move(symb))
+         , LockedMap_(lockedMap) {
+      }
+      void OnAfterPodOpWrite(seed::Tab& tab) override {
+         static_cast<SymbTreeShardedT*>(this->Sender_)->OnAfterPodOpWrite(*this->Symb_, tab, this->LockedMap_);
+      }
+      /// 同 SymbTreeT::PodOp::LockMap(); 鎖定商品所在的 shard.
+      const Locker& LockMap() {
+         const_cast<Locker*>(&this->LockedMap_)->Relock(*this->LockedMap_.GetOwner());
+         return this->LockedMap_;
+      }
+      void BeginRead(seed::Tab& tab, seed::FnReadOp fnCallback) override {
+         if (this->LockedMap_.owns_lock())
+            base::BeginRead(tab, std::move(fnCallback));
+         else
+            this->BeginReadSnapshot(*this->LockedMap_.GetOwner(), tab, std::move(fnCallback));
+      }
+      void BeginWrite(seed::Tab& tab, seed::FnWriteOp fnCallback) override {
+         this->LockMap();
+         base::BeginWrite(tab, std::move(fnCallback));
+      }
+   };
+   class TreeOp : public SymbTreeOp {
+      fon9_NON_COPY_NON_MOVE(TreeOp);
+      using base = SymbTreeOp;
+
+      template <class Container>
+      static enable_if_t<TestHasHasher<Container>::HasHasher>
+         MakeShardedGridView(AllLocker& symbs, const seed::GridViewRequest& req, seed::GridViewResult& res) {
+         if (req.OrigKey_.Get1st() != seed::GridViewResult::kCellSplitter) {
+            res.OpResult_ = seed::OpResult::not_supported_grid_view;
+            return;
+         }
+         // req.OrigKey_ = "key list"; 依序到各個 key 所在的 shard 尋找.
+         StrView        keys{req.OrigKey_.begin() + 1, req.OrigKey_.end()};
+         RevBufferList  rbuf{256};
+         for (;;) {
+            const char* pkey = static_cast<const char*>(memrchr(keys.begin(), seed::GridViewResult::kCellSplitter, keys.size()));
+            StrView     key{pkey ? (pkey + 1) : keys.begin(), keys.end()};
+            const auto& shard = *symbs[GetShardIndex(key)];
+            auto        ifind = shard.find(key);
+            if (ifind == shard.end() || !MakeRowView(ifind, res.Tab_, rbuf))
+               RevPrint(rbuf, key);
+            if (pkey == nullptr)
+               break;
+            keys.SetEnd(pkey);
+            RevPrint(rbuf, seed::GridViewResult::kRowSplitter);
+         }
+         res.ContainerSize_ = symbs.size();
+         res.GridView_ = BufferTo<std::string>(rbuf.MoveOut());
+      }
+      /// 有序的容器: 將全部 shards 的商品合併排序之後, 再使用一般的 GridView.
+      /// 需要複製全部商品的 SymbSP, 所以僅適合管理介面使用.
+      template <class Container>
+      static enable_if_t<!TestHasHasher<Container>::HasHasher>
+         MakeShardedGridView(AllLocker& symbs, const seed::GridViewRequest& req, seed::GridViewResult& res) {
+         std::vector<SymbSP> merged;
+         merged.reserve(symbs.size());
+         symbs.ForEachSymb([&merged](Symb& symb) {
+            merged.emplace_back(&symb);
+         });
+         std::sort(merged.begin(), merged.end(), SymbSP_Comparer{});
+         const std::vector<SymbSP>& cmerged = merged;
+         auto istart = cmerged.begin();
+         if (!seed::GetIteratorForGv(cmerged, istart, req.OrigKey_.begin()))
+            istart = std::lower_bound(cmerged.begin(), cmerged.end(), req.OrigKey_, SymbSP_Comparer{});
+         seed::MakeGridView(cmerged, istart, req, res, &MakeRowView<std::vector<SymbSP>::const_iterator>);
+      }
+
+   public:
+      TreeOp(SymbTreeShardedT& tree) : base{tree} {
+      }
+
+      void GridView(const seed::GridViewRequest& req, seed::FnGridViewOp fnCallback) override {
+         seed::GridViewResult res{this->Tree_, req.Tab_};
+         auto* tree = static_cast<SymbTreeShardedT*>(&this->Tree_);
+         if (GetSeqLock(tree->Shards_[0].GetMutex()) && TestHasHasher<SymbMapImpl>::HasHasher) {
+            // 在鎖定狀態下, 只取出商品及資料位置; 解鎖後再使用快照建立 GridView.
+            SnapshotRows<SymbMap> rows;
+            bool isFetched;
+            {
+               AllLocker symbs{*tree};
+               res.ContainerSize_ = symbs.size();
+               isFetched = FetchSnapshotRows(req, res, rows, [&symbs, tree](const StrView& key, SymbSP& symb) {
+                  const unsigned shardIndex = GetShardIndex(key);
+                  const auto&    shard = *symbs[shardIndex];
+                  auto           ifind = shard.find(key);
+                  if (ifind != shard.end())
+                     symb.reset(&GetSymbValue(*ifind));
+                  return &tree->GetShardAt(shardIndex);
+               });
+            } // unlock all shards.
+            if (isFetched)
+               MakeSnapshotGridView(rows, res);
+         }
+         else {
+            AllLocker symbs{*tree};
+            MakeShardedGridView<SymbMapImpl>(symbs, req, res);
+         } // unlock all shards.
+         fnCallback(res);
+      }
+
+      virtual void OnSymbPodOp(const StrView& strKeyText, SymbSP&& symb, seed::FnPodOp&& fnCallback, const Locker& lockedMap) {
+         PodOp op(this->Tree_, strKeyText, std::move(symb), lockedMap);
+         fnCallback(op, &op);
+      }
+      void OnPodOp(const StrView& strKeyText, SymbSP&& symb, seed::FnPodOp&& fnCallback, const Locker& lockedMap) {
+         if (symb)
+            this->OnSymbPodOp(strKeyText, std::move(symb), std::move(fnCallback), lockedMap);
+         else
+            fnCallback(seed::PodOpResult{this->Tree_, seed::OpResult::not_found_key, strKeyText}, nullptr);
+      }
+      void Get(StrView strKeyText, seed::FnPodOp fnCallback) override {
+         auto*  tree = static_cast<SymbTreeShardedT*>(&this->Tree_);
+         Locker lockedMap{tree->LockShard(strKeyText)};
+         SymbSP symb = tree->GetSymb(lockedMap, strKeyText);
+         // 使用 SeqLockMutex: 讀取時使用快照, 所以找到商品後就可以解鎖, 需要時再由 PodOp::LockMap() 鎖定.
+         if (GetSeqLock(lockedMap.GetOwner()->GetMutex()))
+            lockedMap.unlock();
+         this->OnPodOp(strKeyText, std::move(symb), std::move(fnCallback), lockedMap);
+      }
+      void Add(StrView strKeyText, seed::FnPodOp fnCallback) override {
+         if (seed::IsTextBeginOrEnd(strKeyText))
+            fnCallback(seed::PodOpResult{this->Tree_, seed::OpResult::not_found_key, strKeyText}, nullptr);
+         else {
+            auto*  tree = static_cast<SymbTreeShardedT*>(&this->Tree_);
+            Locker lockedMap{tree->LockShard(strKeyText)};
+            SymbSP symb = tree->FetchSymb(lockedMap, strKeyText);
+            this->OnPodOp(strKeyText, std::move(symb), std::move(fnCallback), lockedMap);
+         }
+      }
+      void Remove(StrView strKeyText, seed::Tab* tab, seed::FnPodRemoved fnCallback) override {
+         seed::PodRemoveResult res{this->Tree_, seed::OpResult::not_found_key, strKeyText, tab};
+         {
+            Locker lockedMap{static_cast<SymbTreeShardedT*>(&this->Tree_)->LockShard(strKeyText)};
+            auto   ifind = lockedMap->find(strKeyText);
+            if (ifind != lockedMap->end()) {
+               lockedMap->erase(ifind);
+               res.OpResult_ = seed::OpResult::removed_pod;
+            }
+         }
+         fnCallback(res);
+      }
+   };
+};
+//--------------------------------------------------------------------------//
+
+/// \ingroup fmkt
+/// 商品資料表, 多個行情來源(thread)同時更新時使用: multi thread(sharded mutex) + unordered
+/// - 與 MdSymbTree 相同, 使用 SeqLockMutex, 查詢時使用快照.
+class fon9_API MdSymbTreeSharded : public SymbTreeShardedT<MdSymbMap, SeqLockMutex<std::mutex>> {
+   fon9_NON_COPY_NON_MOVE(MdSymbTreeSharded);
+   using base = SymbTreeShardedT<MdSymbMap, SeqLockMutex<std::mutex>>;
+public:
+   using base::base;
+   ~MdSymbTreeSharded();
+
+   void LockedDailyClear(AllLocker& symbs, unsigned tdayYYYYMMDD);
+};
+
+} } // namespaces
+#endif//__fon9_fmkt_SymbTreeSharded_hpp__
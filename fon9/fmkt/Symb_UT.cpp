@@ -32,8 +32,15 @@
 //
 // \author fonwinz@gmail.com
 #include "fon9/fmkt/Symb.hpp"
+#include "fon9/fmkt/SymbTreeSharded.hpp"
+#include "fon9/fmkt/SymbDeal.hpp"
+#include "fon9/fmkt/MdSymbs.hpp"
+#include "fon9/seed/FieldMaker.hpp"
+#include "fon9/seed/RawWr.hpp"
+#include "fon9/BitvDecode.hpp"
 #include "fon9/TestTools.hpp"
 #include "fon9/TestTools_MemUsed.hpp"
+#include "fon9/ThreadTools.hpp"
 #include "fon9/File.hpp"
 
 #include "fon9/Trie.hpp"
@@ -41,6 +48,14 @@
 #include "fon9/DummyMutex.hpp"
 #include <map>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <random>
+#include <algorithm>
+#include <chrono>
 
 //--------------------------------------------------------------------------//
 
@@ -84,12 +99,938 @@ static void Benchmark(const char* benchFor, const SymbList& symbs, const char* m
 
 //--------------------------------------------------------------------------//
 
+// 模擬多個行情頻道(thread)同時更新各自的商品: 單一 mutex(MdSymbTree) vs MdSymbTreeSharded.
+template <class TreeT>
+class BenchSymbTree : public TreeT {
+   fon9_NON_COPY_NON_MOVE(BenchSymbTree);
+   fon9::fmkt::SymbSP MakeSymb(const fon9::StrView& symbid) override {
+      return new fon9::fmkt::Symb{symbid};
+   }
+public:
+   BenchSymbTree() : TreeT{nullptr} {
+   }
+};
+struct LockTree {
+   template <class TreeT>
+   static auto Lock(TreeT& tree, const fon9::StrView&) -> decltype(tree.SymbMap_.Lock()) {
+      return tree.SymbMap_.Lock();
+   }
+};
+struct LockShard {
+   template <class TreeT>
+   static auto Lock(TreeT& tree, const fon9::StrView& symbid) -> decltype(tree.LockShard(symbid)) {
+      return tree.LockShard(symbid);
+   }
+};
+template <class TreeT, class LockPolicy>
+static void BenchmarkThreads(const char* benchFor, const SymbList& symbs, unsigned thrCount) {
+   const unsigned       kRounds = 20;
+   BenchSymbTree<TreeT> tree;
+   for (const auto& symb : symbs)
+      tree.FetchSymb(fon9::ToStrView(symb->SymbId_));
+
+   std::vector<std::thread> thrs;
+   fon9::StopWatch          stopWatch;
+   for (unsigned thrIdx = 0; thrIdx < thrCount; ++thrIdx) {
+      thrs.emplace_back([&tree, &symbs, thrIdx, thrCount, kRounds]() {
+         for (unsigned r = 0; r < kRounds; ++r) {
+            for (size_t L = thrIdx; L < symbs.size(); L += thrCount) {
+               const fon9::StrView symbid = fon9::ToStrView(symbs[L]->SymbId_);
+               auto  symblk = LockPolicy::Lock(tree, symbid);
+               auto  symb = tree.GetSymb(symblk, symbid);
+               // 模擬在鎖定狀態下: 解析行情、更新商品資料、發行.
+               for (unsigned w = 0; w < 50; ++w)
+                  ++symb->TDayYYYYMMDD_;
+            }
+         }
+      });
+   }
+   fon9::JoinThreads(thrs);
+   stopWatch.PrintResultNoEOL(benchFor, symbs.size() * kRounds) << "|threads=" << thrCount << std::endl;
+}
+template <class TreeT>
+static void TestShardedGridView(const char* testName, const fon9::StrView& origKey, const std::string& expected) {
+   std::cout << "[TEST ] " << testName;
+   BenchSymbTree<TreeT> tree;
+   char symbid[16];
+   for (unsigned L = 0; L < 100; ++L) {
+      sprintf(symbid, "S%05u", L);
+      tree.FetchSymb(fon9::StrView_cstr(symbid));
+   }
+   std::string gv;
+   tree.OnTreeOp([&origKey, &gv](const fon9::seed::TreeOpResult&, fon9::seed::TreeOp* op) {
+      fon9::seed::GridViewRequest req{origKey};
+      req.MaxRowCount_ = 3;
+      op->GridView(req, [&gv](fon9::seed::GridViewResult& res) {
+         gv = res.GridView_;
+      });
+   });
+   for (char& ch : gv) {
+      if (ch == fon9::seed::GridViewResult::kRowSplitter)
+         ch = ',';
+   }
+   if (gv == expected) {
+      std::cout << "\r[OK   ]" << std::endl;
+      return;
+   }
+   std::cout << "|gv=" << gv << "|expected=" << expected << "\r[ERROR]" << std::endl;
+   abort();
+}
+static void MakeTestSymbs(SymbList& symbs) {
+   if (symbs.empty()) {
+      char symbid[16];
+      for (unsigned L = 0; L < 30000; ++L) {
+         sprintf(symbid, "S%05u", L);
+         symbs.emplace_back(new fon9::fmkt::Symb{fon9::StrView_cstr(symbid)});
+      }
+   }
+}
+static void TestShardedGridView() {
+   TestShardedGridView<fon9::fmkt::SymbTreeShardedT<fon9::fmkt::SymbSortedVector, std::mutex>>(
+      "Sharded.GridView.Ordered", "S00010", "S00010,S00011,S00012");
+   const char kKeyList[] = {fon9::seed::GridViewResult::kCellSplitter, 'S','0','0','0','9','9',
+                            fon9::seed::GridViewResult::kCellSplitter, 'X',
+                            fon9::seed::GridViewResult::kCellSplitter, 'S','0','0','0','0','1'};
+   TestShardedGridView<fon9::fmkt::MdSymbTreeSharded>(
+      "Sharded.GridView.Unordered", fon9::StrView{kKeyList, sizeof(kKeyList)}, "S00099,X,S00001");
+   TestShardedGridView<fon9::fmkt::MdSymbTree>(
+      "MdSymbTree.GridView.Snapshot", fon9::StrView{kKeyList, sizeof(kKeyList)}, "S00099,X,S00001");
+}
+static void BenchmarkSharded(SymbList& symbs) {
+   MakeTestSymbs(symbs);
+   // 行情封包的商品順序是散亂的, 若依照建立順序存取, 則 hash map 的存取位置會過於集中.
+   SymbList randSymbs{symbs};
+   std::shuffle(randSymbs.begin(), randSymbs.end(), std::mt19937{});
+   std::cout << "===== MdSymbTree vs MdSymbTreeSharded =====\n";
+   for (unsigned thrCount : {1u, 2u, 4u, 8u}) {
+      BenchmarkThreads<fon9::fmkt::MdSymbTree, LockTree>       ("MdSymbTree:        ", randSymbs, thrCount);
+      BenchmarkThreads<fon9::fmkt::MdSymbTreeSharded, LockShard>("MdSymbTreeSharded: ", randSymbs, thrCount);
+   }
+}
+
+//--------------------------------------------------------------------------//
+
+// 查詢(Get+BeginRead, GridView) 與行情更新(鎖定 SymbMap_) 的競爭:
+// - Locked:   SymbTreeT<MdSymbMap, std::mutex>; 查詢期間鎖定 SymbMap_.
+// - Snapshot: MdSymbTree(SeqLockMutex); 查詢時使用 SymbData::ReadSnapshot(), 讀取資料時不鎖定 SymbMap_.
+class DealSymb : public fon9::fmkt::Symb {
+   fon9_NON_COPY_NON_MOVE(DealSymb);
+   using base = fon9::fmkt::Symb;
+public:
+   fon9::fmkt::SymbDeal Deal_;
+   using base::base;
+   fon9::fmkt::SymbData* GetSymbData(int tabid) override {
+      return tabid == 1 ? &this->Deal_ : base::GetSymbData(tabid);
+   }
+   fon9::fmkt::SymbData* FetchSymbData(int tabid) override {
+      return this->GetSymbData(tabid);
+   }
+   static fon9::seed::LayoutSP MakeLayout() {
+      using namespace fon9::seed;
+      return LayoutSP{new LayoutN(fon9_MakeField(Symb, SymbId_, "Id"), TreeFlag::Unordered,
+         TabSP{new Tab{fon9::Named{"Base"}, Symb::MakeFields()}},
+         TabSP{new Tab{fon9::Named{"Deal"}, fon9::fmkt::SymbTwsDeal_MakeFields(true)}})};
+   }
+};
+template <class TreeT>
+class SnapshotTree : public TreeT {
+   fon9_NON_COPY_NON_MOVE(SnapshotTree);
+   fon9::fmkt::SymbSP MakeSymb(const fon9::StrView& symbid) override {
+      return new DealSymb{symbid};
+   }
+public:
+   SnapshotTree() : TreeT{DealSymb::MakeLayout()} {
+   }
+};
+using LockedMdSymbTree = fon9::fmkt::SymbTreeT<fon9::fmkt::MdSymbMap, std::mutex>;
+
+template <class TreeT>
+static void BenchmarkSnapshot(const char* benchFor, const SymbList& symbs, unsigned readerCount) {
+   const unsigned       kRounds = 20;
+   SnapshotTree<TreeT>  tree;
+   for (const auto& symb : symbs)
+      tree.FetchSymb(fon9::ToStrView(symb->SymbId_));
+   fon9::seed::Tab*          tabDeal = tree.LayoutSP_->GetTab(1);
+   const fon9::seed::Field*  fldPri = tabDeal->Fields_.Get("DealPri");
+   const fon9::seed::Field*  fldQty = tabDeal->Fields_.Get("DealQty");
+   const fon9::seed::Field*  fldTotalQty = tabDeal->Fields_.Get("TotalQty");
+   // GridView 查詢 20 個商品.
+   std::string gvKeys;
+   for (unsigned L = 0; L < 20; ++L) {
+      gvKeys.push_back(fon9::seed::GridViewResult::kCellSplitter);
+      gvKeys.append(symbs[L * 97 % symbs.size()]->SymbId_.begin(), symbs[L * 97 % symbs.size()]->SymbId_.end());
+   }
+
+   std::atomic<bool>       isWriting{true};
+   std::atomic<uint64_t>   readCount{0}, gvCount{0}, errCount{0};
+   std::vector<std::thread> readers;
+   for (unsigned thrIdx = 0; thrIdx < readerCount; ++thrIdx) {
+      readers.emplace_back([&, thrIdx]() {
+         uint64_t nRead = 0;
+         for (size_t L = thrIdx; isWriting.load(std::memory_order_relaxed); L += readerCount) {
+            const fon9::StrView symbid = fon9::ToStrView(symbs[L % symbs.size()]->SymbId_);
+            tree.OnTreeOp([&](const fon9::seed::TreeOpResult&, fon9::seed::TreeOp* op) {
+               op->Get(symbid, [&](const fon9::seed::PodOpResult&, fon9::seed::PodOp* pod) {
+                  if (pod == nullptr) {
+                     ++errCount;
+                     return;
+                  }
+                  pod->BeginRead(*tabDeal, [&](const fon9::seed::SeedOpResult&, const fon9::seed::RawRd* rd) {
+                     // 寫入時 3 個欄位填入相同的值, 若讀到不一致的資料, 則為錯誤.
+                     if (rd == nullptr
+                         || fldPri->GetNumber(*rd, 0, 0) != fldQty->GetNumber(*rd, 0, 0)
+                         || fldQty->GetNumber(*rd, 0, 0) != fldTotalQty->GetNumber(*rd, 0, 0))
+                        ++errCount;
+                  });
+               });
+               if (++nRead % 64 == 0) {
+                  fon9::seed::GridViewRequest req{fon9::ToStrView(gvKeys)};
+                  req.Tab_ = tabDeal;
+                  op->GridView(req, [&](fon9::seed::GridViewResult& res) {
+                     if (res.OpResult_ != fon9::seed::OpResult::no_error || res.GridView_.empty())
+                        ++errCount;
+                  });
+                  ++gvCount;
+               }
+            });
+            ++readCount;
+         }
+      });
+   }
+   // 行情更新: 記錄每次更新(包含等候鎖定)的時間.
+   std::vector<uint32_t> spans;
+   spans.reserve(symbs.size() * kRounds);
+   fon9::StopWatch stopWatch;
+   for (unsigned r = 1; r <= kRounds; ++r) {
+      for (const auto& isymb : symbs) {
+         const auto     tmBeg = std::chrono::steady_clock::now();
+         const auto     symbid = fon9::ToStrView(isymb->SymbId_);
+         auto           symblk = tree.SymbMap_.Lock();
+         auto           symb = tree.GetSymb(symblk, symbid);
+         auto&          deal = static_cast<DealSymb*>(symb.get())->Deal_.Data_;
+         const uint64_t val = r * 1000000u + static_cast<uint64_t>(&isymb - &*symbs.begin());
+         deal.Deal_.Pri_.Assign<0>(val);
+         deal.Deal_.Qty_ = val;
+         deal.TotalQty_ = val;
+         symblk.unlock();
+         spans.push_back(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - tmBeg).count()));
+      }
+   }
+   const double span = stopWatch.StopTimer();
+   isWriting = false;
+   fon9::JoinThreads(readers);
+
+   std::sort(spans.begin(), spans.end());
+   uint64_t total = 0;
+   for (uint32_t v : spans)
+      total += v;
+   stopWatch.PrintResultNoEOL(span, benchFor, spans.size())
+      << "|readers=" << readerCount
+      << "|avg=" << (total / spans.size())
+      << "|p99=" << spans[spans.size() * 99 / 100]
+      << "|p999=" << spans[spans.size() * 999 / 1000]
+      << "|max=" << spans.back()
+      << "|reads=" << readCount
+      << "|gv=" << gvCount
+      << std::endl;
+   if (errCount != 0) {
+      std::cout << "[ERROR] " << benchFor << "|errCount=" << errCount << std::endl;
+      abort();
+   }
+}
+static void BenchmarkSnapshot(SymbList& symbs) {
+   MakeTestSymbs(symbs);
+   SymbList randSymbs{symbs};
+   std::shuffle(randSymbs.begin(), randSymbs.end(), std::mt19937{});
+   std::cout << "===== Locked read vs Snapshot read =====\n";
+   for (unsigned rdCount : {0u, 1u, 2u, 4u}) {
+      BenchmarkSnapshot<LockedMdSymbTree>    ("Locked:   ", randSymbs, rdCount);
+      BenchmarkSnapshot<fon9::fmkt::MdSymbTree>("Snapshot: ", randSymbs, rdCount);
+   }
+}
+
+//--------------------------------------------------------------------------//
+
+// MdRtStream 的合併模式訂閱: "MdRts:F/";
+class ConflateSymb : public DealSymb {
+   fon9_NON_COPY_NON_MOVE(ConflateSymb);
+   using base = DealSymb;
+public:
+   fon9::fmkt::MdRtStream MdRtStream_;
+   ConflateSymb(const fon9::StrView& symbid, fon9::fmkt::MdRtStreamInnMgr& innMgr)
+      : base{symbid}
+      , MdRtStream_{innMgr} {
+   }
+   fon9::fmkt::SymbData* GetSymbData(int tabid) override {
+      return tabid == 2 ? &this->MdRtStream_ : base::GetSymbData(tabid);
+   }
+   fon9::fmkt::SymbData* FetchSymbData(int tabid) override {
+      return this->GetSymbData(tabid);
+   }
+   static fon9::seed::LayoutSP MakeLayout() {
+      using namespace fon9::seed;
+      return LayoutSP{new LayoutN(fon9_MakeField(Symb, SymbId_, "Id"), TreeFlag::Unordered,
+         TabSP{new Tab{fon9::Named{fon9_kCSTR_TabName_Base}, Symb::MakeFields()}},
+         TabSP{new Tab{fon9::Named{fon9_kCSTR_TabName_Deal}, fon9::fmkt::SymbTwsDeal_MakeFields(true)}},
+         TabSP{new Tab{fon9::Named{fon9_kCSTR_TabName_Rt}, fon9::fmkt::MdRtStream::MakeFields()}})};
+   }
+};
+class ConflateSymbs : public fon9::fmkt::MdSymbsT<ConflateSymb> {
+   fon9_NON_COPY_NON_MOVE(ConflateSymbs);
+   using base = fon9::fmkt::MdSymbsT<ConflateSymb>;
+   fon9::fmkt::SymbSP MakeSymb(const fon9::StrView& symbid) override {
+      return new ConflateSymb{symbid, this->RtInnMgr_};
+   }
+public:
+   ConflateSymbs() : base{ConflateSymb::MakeLayout(), std::string{}} {
+   }
+};
+static void TestConflate() {
+   std::cout << "[TEST ] MdRtStream.Conflate";
+   fon9::intrusive_ptr<ConflateSymbs> tree{new ConflateSymbs};
+   const fon9::StrView  symbid{"2330"};
+   auto* const          symb = static_cast<ConflateSymb*>(tree->FetchSymb(symbid).get());
+   fon9::seed::Tab&     tabRt = *tree->RtTab_;
+   // 在 tree 鎖定的狀態下存取.
+   bool                 isBusy = false;
+   unsigned             busyCount = 0;
+   std::vector<uint8_t> pkTypes;
+   fon9::SubConn        subConn{};
+   tree->OnTreeOp([&](const fon9::seed::TreeOpResult&, fon9::seed::TreeOp* op) {
+      op->Get(symbid, [&](const fon9::seed::PodOpResult&, fon9::seed::PodOp* pod) {
+         pod->SubscribeStream(&subConn, tabRt, "MdRts:F/", [&](const fon9::seed::SeedNotifyArgs& e) {
+            if (e.NotifyKind_ != fon9::seed::SeedNotifyKind::StreamData)
+               return;
+            if (isBusy && e.Conflate_ == fon9::seed::StreamDataConflate::Allowed) {
+               e.Conflate_ = fon9::seed::StreamDataConflate::Busy;
+               ++busyCount;
+               return;
+            }
+            pkTypes.push_back(static_cast<uint8_t>(e.GetGridView()[0]));
+         });
+      });
+   });
+   auto publish = [&](f9sv_RtsPackType pkType, f9sv_MdRtsKind pkKind) {
+      auto lk = tree->SymbMap_.Lock();
+      symb->Deal_.Data_.TotalQty_ += 1;
+      symb->MdRtStream_.Publish(symbid, pkType, pkKind, fon9::DayTime{}, fon9::RevBufferList{64});
+   };
+   auto check = [&](const char* step, std::vector<uint8_t> expected) {
+      auto lk = tree->SymbMap_.Lock();
+      if (pkTypes == expected)
+         return;
+      std::cout << "|step=" << step << "|count=" << pkTypes.size() << "|expected=" << expected.size()
+         << "\r[ERROR]" << std::endl;
+      abort();
+   };
+   const uint8_t kDeal = f9sv_RtsPackType_DealPack;
+   const uint8_t kBase = f9sv_RtsPackType_BaseInfoTw;
+   const uint8_t kTabValues = f9sv_RtsPackType_TabValues_AndInfoTime;
+   publish(f9sv_RtsPackType_DealPack, f9sv_MdRtsKind_Deal);
+   check("NotBusy", {kDeal});
+   // 忙碌時: Deal 被合併; Base 不可合併, 必須送出.
+   isBusy = true;
+   for (unsigned L = 0; L < 3; ++L)
+      publish(f9sv_RtsPackType_DealPack, f9sv_MdRtsKind_Deal);
+   publish(f9sv_RtsPackType_BaseInfoTw, f9sv_MdRtsKind_Base);
+   check("Busy", {kDeal, kBase});
+   // 不忙碌後的 Deal: 仍有待送的 Deal, 所以合併, 由 timer 的下次 tick 送出最新狀態.
+   isBusy = false;
+   publish(f9sv_RtsPackType_DealPack, f9sv_MdRtsKind_Deal);
+   std::this_thread::sleep_for(std::chrono::milliseconds(200));
+   check("Flush", {kDeal, kBase, kTabValues});
+   publish(f9sv_RtsPackType_DealPack, f9sv_MdRtsKind_Deal);
+   check("Resume", {kDeal, kBase, kTabValues, kDeal});
+   // 沒有後續異動: 由 timer 送出最新狀態.
+   isBusy = true;
+   publish(f9sv_RtsPackType_DealPack, f9sv_MdRtsKind_Deal);
+   isBusy = false;
+   std::this_thread::sleep_for(std::chrono::milliseconds(200));
+   check("Timer", {kDeal, kBase, kTabValues, kDeal, kTabValues});
+
+   tree->OnTreeOp([&](const fon9::seed::TreeOpResult&, fon9::seed::TreeOp* op) {
+      op->Get(symbid, [&](const fon9::seed::PodOpResult&, fon9::seed::PodOp* pod) {
+         pod->UnsubscribeStream(&subConn, tabRt);
+      });
+   });
+   std::cout << "|busyCount=" << busyCount << "\r[OK   ]" << std::endl;
+}
+//--------------------------------------------------------------------------//
+
+// MdSymbsShardedT: 多個行情頻道(thread)同時更新各自的商品, 並發行給「整棵樹」及「單一商品」的訂閱者.
+class ShardedSymbs : public fon9::fmkt::MdSymbsShardedT<ConflateSymb> {
+   fon9_NON_COPY_NON_MOVE(ShardedSymbs);
+   using base = fon9::fmkt::MdSymbsShardedT<ConflateSymb>;
+   fon9::fmkt::SymbSP MakeSymb(const fon9::StrView& symbid) override {
+      return new ConflateSymb{symbid, this->RtInnMgr_};
+   }
+public:
+   ShardedSymbs(std::string rtiPathFmt = std::string{})
+      : base{ConflateSymb::MakeLayout(), std::move(rtiPathFmt), fon9::fmkt::MdSymbsCtrlFlag::AllowSubrTree} {
+   }
+};
+static void TestMdSymbsSharded() {
+   std::cout << "[TEST ] MdSymbsSharded";
+   const unsigned kSymbCount = 1000;
+   const unsigned kThrCount = 4;
+   const unsigned kRounds = 100;
+   fon9::intrusive_ptr<ShardedSymbs> tree{new ShardedSymbs};
+   std::vector<std::string> symbids;
+   char symbid[16];
+   for (unsigned L = 0; L < kSymbCount; ++L) {
+      sprintf(symbid, "S%05u", L);
+      symbids.emplace_back(symbid);
+      tree->FetchSymb(fon9::StrView_cstr(symbid));
+   }
+   fon9::seed::Tab&  tabRt = *tree->RtTab_;
+   fon9::SubConn     subrTree{}, subrSymb{};
+   // 整棵樹的訂閱者: 不同 shard 的發行, 在 MdSymbsBase 裡面已經序列化, 所以不用額外保護.
+   size_t            treeCount = 0, symbCount = 0;
+   tree->SubscribeStream(&subrTree, tabRt, "MdRts:F", [&treeCount](const fon9::seed::SeedNotifyArgs& e) {
+      if (e.NotifyKind_ == fon9::seed::SeedNotifyKind::StreamData)
+         ++treeCount;
+   });
+   tree->OnTreeOp([&](const fon9::seed::TreeOpResult&, fon9::seed::TreeOp* op) {
+      op->Get(&symbids[0], [&](const fon9::seed::PodOpResult&, fon9::seed::PodOp* pod) {
+         pod->SubscribeStream(&subrSymb, tabRt, "MdRts:F", [&symbCount](const fon9::seed::SeedNotifyArgs& e) {
+            if (e.NotifyKind_ == fon9::seed::SeedNotifyKind::StreamData)
+               ++symbCount;
+         });
+      });
+   });
+   std::vector<std::thread> thrs;
+   for (unsigned thrIdx = 0; thrIdx < kThrCount; ++thrIdx) {
+      thrs.emplace_back([&tree, &symbids, thrIdx]() {
+         for (unsigned r = 0; r < kRounds; ++r) {
+            for (size_t L = thrIdx; L < symbids.size(); L += kThrCount) {
+               const fon9::StrView id{&symbids[L]};
+               auto  symblk = tree->LockShard(id);
+               auto* symb = static_cast<ConflateSymb*>(tree->GetSymb(symblk, id).get());
+               symb->Deal_.Data_.TotalQty_ += 1;
+               symb->MdRtStream_.Publish(id, f9sv_RtsPackType_DealPack, f9sv_MdRtsKind_Deal,
+                                         fon9::DayTime{}, fon9::RevBufferList{64});
+            }
+         }
+      });
+   }
+   fon9::JoinThreads(thrs);
+   {
+      fon9::fmkt::MdSymbsBase::AllSymbsLocker symbs{*tree};
+      if (treeCount != kSymbCount * kRounds || symbCount != kRounds || symbs.size() != kSymbCount) {
+         std::cout << "|treeCount=" << treeCount << "|symbCount=" << symbCount
+                   << "|symbs=" << symbs.size() << "\r[ERROR]" << std::endl;
+         abort();
+      }
+   }
+   // DailyClear: 每個商品的盤別異動不會送給整棵樹的訂閱者, 只由 DailyClear() 送出一次.
+   treeCount = 0;
+   tree->DailyClear(20260102);
+   if (treeCount != 1) {
+      std::cout << "|DailyClear.treeCount=" << treeCount << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   tree->UnsubscribeStream(&subrTree, tabRt);
+   tree->OnTreeOp([&](const fon9::seed::TreeOpResult&, fon9::seed::TreeOp* op) {
+      op->Get(&symbids[0], [&](const fon9::seed::PodOpResult&, fon9::seed::PodOp* pod) {
+         pod->UnsubscribeStream(&subrSymb, tabRt);
+      });
+   });
+   std::cout << "|shards=" << tree->SymbShardCount_ << "|publish=" << kSymbCount * kRounds << "\r[OK   ]" << std::endl;
+}
+
+//--------------------------------------------------------------------------//
+
+// MdRtRecoverSch: 使用 1 個 worker, 由 gate 回補的第一次通知卡住 worker,
+// 在此期間加入其他回補要求, 放開 gate 之後, 檢查回補的執行順序.
+class RecoverTester {
+   fon9_NON_COPY_NON_MOVE(RecoverTester);
+   struct Ev {
+      char  Tag_;
+      bool  IsEnd_;
+   };
+   std::mutex              Mx_;
+   std::condition_variable CV_;
+   std::vector<Ev>         Evs_;
+   char                    GateTag_{};
+   bool                    IsGateBlocked_{false};
+   std::deque<fon9::SubConn> SubConns_;
+public:
+   static constexpr unsigned  kPkCount = 2000;
+   static constexpr unsigned  kStartSecs = 9 * 60 * 60;
+   fon9::intrusive_ptr<ShardedSymbs> Tree_;
+   std::string                GateId_{"G"};
+
+   RecoverTester(const char* rtiPathFmt) : Tree_{new ShardedSymbs{rtiPathFmt}} {
+      this->Tree_->SetDailyClearHHMMSS(60000);
+      this->Tree_->FetchSymb(&this->GateId_);
+   }
+   /// 取得與 GateId_ 不同 shard 的商品, 在 gate 卡住 worker 時, 才能訂閱.
+   std::string FetchSymbId(unsigned& seq) {
+      char symbid[16];
+      for (;;) {
+         sprintf(symbid, "S%04u", ++seq);
+         const fon9::StrView id = fon9::StrView_cstr(symbid);
+         if (&this->Tree_->GetSymbShard(id) != &this->Tree_->GetSymbShard(&this->GateId_)) {
+            this->Tree_->FetchSymb(id);
+            return symbid;
+         }
+      }
+   }
+   /// 在 DailyClear() 開啟 rti 之後, 每個商品寫入 kPkCount 個封包, 每個封包的 InfoTime 間隔 1 秒.
+   void Publish(unsigned tday, const std::vector<std::string>& symbids) {
+      this->Tree_->DailyClear(tday);
+      for (const std::string& symbid : symbids) {
+         const fon9::StrView id{&symbid};
+         auto  symblk = this->Tree_->LockShard(id);
+         auto* symb = static_cast<ConflateSymb*>(this->Tree_->GetSymb(symblk, id).get());
+         for (unsigned L = 0; L < kPkCount; ++L) {
+            fon9::RevBufferList rts{128};
+            fon9::RevPutFill(rts, 100, 'x');
+            symb->MdRtStream_.Publish(id, f9sv_RtsPackType_DealPack, f9sv_MdRtsKind_Deal,
+                                      fon9::DayTime{fon9::TimeInterval_Second(kStartSecs + L)}, std::move(rts));
+         }
+      }
+   }
+   /// - startSecs = 0: 從頭回補(Replay);
+   /// - flowWait: 首次通知時要求延遲(不佔用 worker);
+   void Subscribe(const std::string& symbid, char tag, const void* clientKey, unsigned startSecs = 0,
+                  fon9::TimeInterval flowWait = fon9::TimeInterval{}) {
+      std::string args{"MdRts:F:F"};
+      if (startSecs)
+         args += "," + std::to_string(startSecs);
+      this->SubConns_.emplace_back();
+      fon9::SubConn* subConn = &this->SubConns_.back();
+      this->Tree_->OnTreeOp([&](const fon9::seed::TreeOpResult&, fon9::seed::TreeOp* op) {
+         op->Get(&symbid, [&](const fon9::seed::PodOpResult&, fon9::seed::PodOp* pod) {
+            pod->SubscribeStream(subConn, *this->Tree_->RtTab_, &args,
+                                 [this, tag, clientKey, flowWait](const fon9::seed::SeedNotifyArgs& e) {
+               if (e.NotifyKind_ != fon9::seed::SeedNotifyKind::StreamRecover
+                   && e.NotifyKind_ != fon9::seed::SeedNotifyKind::StreamRecoverEnd)
+                  return;
+               auto& rargs = *static_cast<const fon9::seed::SeedNotifyStreamRecoverArgs*>(&e);
+               rargs.FlowControlKey_ = clientKey;
+               if (!flowWait.IsZero()) // 強制流量管制: 此次的通知不算, 延遲 flowWait 之後再回補.
+                  rargs.FlowControlWait_.SetOrigValue(-flowWait.GetOrigValue());
+               std::unique_lock<std::mutex> lk{this->Mx_};
+               this->Evs_.push_back(Ev{tag, e.NotifyKind_ == fon9::seed::SeedNotifyKind::StreamRecoverEnd});
+               this->CV_.notify_all();
+               if (this->GateTag_ == tag) {
+                  this->IsGateBlocked_ = true;
+                  this->CV_.wait(lk, [this]() { return this->GateTag_ == '\0'; });
+               }
+            });
+         });
+      });
+   }
+   void WaitEvCount(char tag, size_t count) {
+      std::unique_lock<std::mutex> lk{this->Mx_};
+      this->CV_.wait(lk, [this, tag, count]() { return this->GetEvCount(tag, false) >= count; });
+   }
+   void WaitEndCount(size_t count) {
+      std::unique_lock<std::mutex> lk{this->Mx_};
+      this->CV_.wait(lk, [this, count]() { return this->GetEvCount('\0', true) >= count; });
+   }
+   /// tag == '\0' 表示全部.
+   size_t GetEvCount(char tag, bool isEndOnly) const {
+      size_t count = 0;
+      for (const Ev& ev : this->Evs_) {
+         if ((tag == '\0' || ev.Tag_ == tag) && (!isEndOnly || ev.IsEnd_))
+            ++count;
+      }
+      return count;
+   }
+   /// 下一個 tag 的通知卡住 worker, 返回前會等到 worker 卡住.
+   void CloseGate(char tag, std::function<void()> fnSubscribe) {
+      {
+         std::unique_lock<std::mutex> lk{this->Mx_};
+         this->GateTag_ = tag;
+         this->IsGateBlocked_ = false;
+      }
+      fnSubscribe();
+      std::unique_lock<std::mutex> lk{this->Mx_};
+      this->CV_.wait(lk, [this]() { return this->IsGateBlocked_; });
+   }
+   /// 返回放開 gate 時的通知數量.
+   size_t OpenGate() {
+      std::unique_lock<std::mutex> lk{this->Mx_};
+      this->GateTag_ = '\0';
+      this->CV_.notify_all();
+      return this->Evs_.size();
+   }
+   /// 在 from 之後, 第一個不是 excludeTag 的通知.
+   char FirstTagAfter(size_t from, char excludeTag) {
+      std::unique_lock<std::mutex> lk{this->Mx_};
+      for (size_t L = from; L < this->Evs_.size(); ++L) {
+         if (this->Evs_[L].Tag_ != excludeTag)
+            return this->Evs_[L].Tag_;
+      }
+      return '\0';
+   }
+   /// tag 回補結束時, 已結束的 otherTag 回補數量.
+   size_t EndCountBefore(char tag, const char* otherTags) {
+      std::unique_lock<std::mutex> lk{this->Mx_};
+      size_t count = 0;
+      for (const Ev& ev : this->Evs_) {
+         if (!ev.IsEnd_)
+            continue;
+         if (ev.Tag_ == tag)
+            break;
+         if (strchr(otherTags, ev.Tag_))
+            ++count;
+      }
+      return count;
+   }
+   size_t GetEvCountLocked(char tag) {
+      std::unique_lock<std::mutex> lk{this->Mx_};
+      return this->GetEvCount(tag, false);
+   }
+};
+static void TestRecoverSch() {
+   std::cout << "[TEST ] MdRtRecoverSch";
+   fon9::fmkt::MdRtRecoverSchArgs schArgs;
+   schArgs.WorkerCount_ = 1;
+   schArgs.ClientWorkers_ = 1;
+   schArgs.RecentSecs_ = 60;
+   schArgs.RecentBurst_ = 4;
+   if (!fon9::fmkt::SetDefaultMdRtRecoverSch(new fon9::fmkt::MdRtRecoverSch{schArgs, "Symb_UT.Recover"})) {
+      std::cout << "|err=SetDefaultMdRtRecoverSch()\r[ERROR]" << std::endl;
+      abort();
+   }
+   const char* const kRtiPathFmt = "Symb_UT_Recover_{0:f}";
+   const char* const kRtiFileName = "Symb_UT_Recover_20260105.rti";
+   remove(kRtiFileName);
+   RecoverTester  tester{kRtiPathFmt};
+   unsigned       seq = 0;
+   const std::string idA2 = tester.FetchSymbId(seq), idA3 = tester.FetchSymbId(seq);
+   const std::string idB = tester.FetchSymbId(seq), idR = tester.FetchSymbId(seq);
+   const std::string idW = tester.FetchSymbId(seq), idP = tester.FetchSymbId(seq);
+   tester.Publish(20260105, {tester.GateId_, idA2, idA3, idB, idR, idW, idP});
+   const char keyA = 'A', keyB = 'B', keyR = 'R';
+   // -----
+   // client A(a1 卡住 worker, a2, a3) 與 client B(b) 輪流使用 worker;
+   // Recent(r) 優先於 Replay.
+   tester.CloseGate('1', [&]() { tester.Subscribe(tester.GateId_, '1', &keyA); });
+   tester.Subscribe(idA2, '2', &keyA);
+   tester.Subscribe(idA3, '3', &keyA);
+   tester.Subscribe(idB, 'b', &keyB);
+   tester.Subscribe(idR, 'r', &keyR, RecoverTester::kStartSecs + RecoverTester::kPkCount - 2);
+   const size_t gateEvs = tester.OpenGate();
+   tester.WaitEndCount(5);
+   const char   firstTag = tester.FirstTagAfter(gateEvs, '1');
+   const size_t endA = tester.EndCountBefore('b', "123");
+   const size_t evsB = tester.GetEvCountLocked('b');
+   if (firstTag != 'r' || endA != 0) {
+      std::cout << "|firstAfterGate=" << firstTag << "|endA.beforeB=" << endA << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   // -----
+   // 在 gate 卡住 worker 時解構 tree:
+   // - 等候流量管制(w)的回補, 不用等到延遲時間到;
+   // - 佇列中(p)的回補, 不會再執行;
+   // - 必須等候執行中(g)的時間片結束.
+   const fon9::TimeInterval kFlowWait = fon9::TimeInterval_Second(10);
+   tester.Subscribe(idW, 'w', &keyB, 0, kFlowWait);
+   tester.WaitEvCount('w', 1);
+   tester.CloseGate('g', [&]() { tester.Subscribe(tester.GateId_, 'g', &keyA); });
+   tester.Subscribe(idP, 'p', &keyB);
+   tester.Subscribe(idA2, 'p', &keyR);
+   std::atomic<bool> isDisposed{false};
+   fon9::StopWatch   stopWatch;
+   std::thread thr{[&tester, &isDisposed]() {
+      tester.Tree_.reset();
+      isDisposed = true;
+   }};
+   std::this_thread::sleep_for(std::chrono::milliseconds(100));
+   const bool isDisposedBeforeOpen = isDisposed;
+   tester.OpenGate();
+   thr.join();
+   const double disposeSecs = stopWatch.StopTimer();
+   if (isDisposedBeforeOpen || disposeSecs >= 5
+       || tester.GetEvCountLocked('w') != 1 || tester.GetEvCountLocked('p') != 0) {
+      std::cout << "|isDisposedBeforeOpen=" << isDisposedBeforeOpen << "|disposeSecs=" << disposeSecs
+         << "|w=" << tester.GetEvCountLocked('w') << "|p=" << tester.GetEvCountLocked('p') << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   remove(kRtiFileName);
+   std::cout << "|b.evs=" << evsB << "|disposeSecs=" << disposeSecs << "\r[OK   ]" << std::endl;
+}
+
+//--------------------------------------------------------------------------//
+
+// 由成交彙總 K 線: MdSymbsBase::UnsafeUpdateBars();
+class BarsSymb : public ConflateSymb {
+   fon9_NON_COPY_NON_MOVE(BarsSymb);
+   using base = ConflateSymb;
+public:
+   fon9::fmkt::SymbBars Bars_;
+   using base::base;
+   fon9::fmkt::SymbData* GetSymbData(int tabid) override {
+      return tabid == 3 ? &this->Bars_ : base::GetSymbData(tabid);
+   }
+   fon9::fmkt::SymbData* FetchSymbData(int tabid) override {
+      return this->GetSymbData(tabid);
+   }
+   static fon9::seed::LayoutSP MakeLayout(const fon9::fmkt::MdBarIntervals& intervals) {
+      using namespace fon9::seed;
+      return LayoutSP{new LayoutN(fon9_MakeField(Symb, SymbId_, "Id"), TreeFlag::Unordered,
+         TabSP{new Tab{fon9::Named{fon9_kCSTR_TabName_Base}, Symb::MakeFields()}},
+         TabSP{new Tab{fon9::Named{fon9_kCSTR_TabName_Deal}, fon9::fmkt::SymbTwsDeal_MakeFields(true)}},
+         TabSP{new Tab{fon9::Named{fon9_kCSTR_TabName_Rt}, fon9::fmkt::MdRtStream::MakeFields()}},
+         TabSP{new fon9::fmkt::SymbBarsTab{intervals}})};
+   }
+};
+class BarsSymbs : public fon9::fmkt::MdSymbsT<BarsSymb> {
+   fon9_NON_COPY_NON_MOVE(BarsSymbs);
+   using base = fon9::fmkt::MdSymbsT<BarsSymb>;
+   fon9::fmkt::SymbSP MakeSymb(const fon9::StrView& symbid) override {
+      return new BarsSymb{symbid, this->RtInnMgr_};
+   }
+public:
+   BarsSymbs(const fon9::fmkt::MdBarIntervals& intervals)
+      : base{BarsSymb::MakeLayout(intervals), std::string{}} {
+   }
+};
+static void CheckBar(const char* step, const fon9::fmkt::SymbBarData* bar,
+                     unsigned hhmmss, int64_t o, int64_t h, int64_t l, int64_t c, fon9::fmkt::Qty v, uint32_t n) {
+   if (bar && bar->Time_ == fon9::DayTime{fon9::TimeInterval_HHMMSS(hhmmss)}
+       && bar->Open_.GetOrigValue() == o * fon9::fmkt::Pri::Divisor
+       && bar->High_.GetOrigValue() == h * fon9::fmkt::Pri::Divisor
+       && bar->Low_.GetOrigValue() == l * fon9::fmkt::Pri::Divisor
+       && bar->Close_.GetOrigValue() == c * fon9::fmkt::Pri::Divisor
+       && bar->Volume_ == v && bar->DealCount_ == n)
+      return;
+   std::cout << "|step=" << step << "|expected=" << hhmmss << ":" << o << "," << h << "," << l << "," << c << "," << v << "," << n;
+   if (bar)
+      std::cout << "|bar=" << fon9::RevPrintTo<std::string>(bar->Time_, ':', bar->Open_, ',', bar->High_, ',',
+                  bar->Low_, ',', bar->Close_, ',', bar->Volume_, ',', bar->DealCount_);
+   std::cout << "\r[ERROR]" << std::endl;
+   abort();
+}
+static void TestBars() {
+   std::cout << "[TEST ] MdSymbs.Bars";
+   fon9::fmkt::MdBarIntervals intervals;
+   if (intervals.Parse("1m,5m,1,2h,3d") == nullptr || intervals.Parse("1m,0") == nullptr
+       || intervals.Parse("1m,5m") != nullptr || intervals.Count_ != 2
+       || fon9::fmkt::MdBarIntervals::MakeName(90) != "90s" || fon9::fmkt::MdBarIntervals::MakeName(3600) != "1h") {
+      std::cout << "|err=MdBarIntervals.Parse\r[ERROR]" << std::endl;
+      abort();
+   }
+   fon9::intrusive_ptr<BarsSymbs> tree{new BarsSymbs{intervals}};
+   const fon9::StrView  symbid{"2330"};
+   auto* const          symb = static_cast<BarsSymb*>(tree->FetchSymb(symbid).get());
+   fon9::seed::Tab&     tabBars = *tree->BarsTab_;
+   if (tabBars.Fields_.size() != intervals.Count_ * fon9::fmkt::kSymbBarFieldCount
+       || tabBars.Fields_.Get("Close5m") == nullptr) {
+      std::cout << "|err=Bars fields\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::vector<uint8_t>       pkTypes;
+   std::vector<std::string>   closedPks;
+   fon9::SubConn              subConn{};
+   tree->OnTreeOp([&](const fon9::seed::TreeOpResult&, fon9::seed::TreeOp* op) {
+      op->Get(symbid, [&](const fon9::seed::PodOpResult&, fon9::seed::PodOp* pod) {
+         pod->SubscribeStream(&subConn, *tree->RtTab_, "MdRts:204", [&](const fon9::seed::SeedNotifyArgs& e) {
+            if (e.NotifyKind_ != fon9::seed::SeedNotifyKind::StreamData)
+               return;
+            pkTypes.push_back(static_cast<uint8_t>(e.GetGridView()[0]));
+            if (pkTypes.back() == f9sv_RtsPackType_BarClosed)
+               closedPks.push_back(e.GetGridView());
+         });
+      });
+   });
+   auto deal = [&](unsigned hhmmss, int64_t pri, fon9::fmkt::Qty totalQty, f9sv_DealFlag flags) {
+      auto  lk = tree->SymbMap_.Lock();
+      auto& dat = symb->Deal_.Data_;
+      dat.InfoTime_ = fon9::TimeInterval_HHMMSS(hhmmss);
+      dat.Deal_.Pri_.Assign<0>(pri);
+      dat.Deal_.Qty_ = totalQty - dat.TotalQty_;
+      if (flags == f9sv_DealFlag{})
+         dat.TotalQty_ = totalQty;
+      dat.Flags_ = flags;
+      tree->UnsafeUpdateBars(*symb, dat);
+   };
+   const uint8_t kUpd = f9sv_RtsPackType_BarUpdate;
+   const uint8_t kClosed = f9sv_RtsPackType_BarClosed;
+   deal(90005, 100, 1, f9sv_DealFlag{});
+   deal(90030, 102, 3, f9sv_DealFlag{});
+   deal(90010,  99, 4, f9sv_DealFlag{});          // 亂序: 併入現在的 K 線.
+   deal(90031, 120, 4, f9sv_DealFlag{});          // TotalQty 沒變: 重複的成交.
+   deal(90032, 130, 9, f9sv_DealFlag_Calculated); // 試算.
+   CheckBar("1m.Curr", &symb->Bars_.Data_.Curr_[0], 90000, 100, 102, 99, 99, 4, 3);
+   deal(90100, 101, 10, f9sv_DealFlag{});
+   CheckBar("1m.Closed", symb->Bars_.GetLastClosed(0), 90000, 100, 102, 99, 99, 4, 3);
+   CheckBar("1m.Next", &symb->Bars_.Data_.Curr_[0], 90100, 101, 101, 101, 101, 6, 1);
+   deal(90500, 98, 15, f9sv_DealFlag{});
+   CheckBar("5m.Closed", symb->Bars_.GetLastClosed(1), 90000, 100, 102, 99, 101, 10, 4);
+   CheckBar("1m.Closed.Last", symb->Bars_.GetLastClosed(0), 90100, 101, 101, 101, 101, 6, 1);
+   if (pkTypes != std::vector<uint8_t>{kUpd, kUpd, kUpd, kClosed, kUpd, kClosed, kUpd} || closedPks.size() != 2) {
+      std::cout << "|err=pkTypes|count=" << pkTypes.size() << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   // 使用 Bars tab 的欄位解析 BarClosed: 09:05 同時完成 1m, 5m 兩根 K 線.
+   fon9::DcQueueFixedMem dcq{closedPks.back()};
+   dcq.PopConsumed(1); // pkType.
+   fon9::DayTime infoTime;
+   fon9::BitvTo(dcq, infoTime);
+   fon9::fmkt::SymbBars rxBars;
+   fon9::seed::SimpleRawWr wr{rxBars};
+   while (!dcq.empty()) {
+      const unsigned fldidx = *static_cast<const uint8_t*>(dcq.Peek1()) * fon9::fmkt::kSymbBarFieldCount;
+      dcq.PopConsumed(1);
+      for (unsigned L = 0; L < fon9::fmkt::kSymbBarFieldCount; ++L)
+         tabBars.Fields_.Get(fldidx + L)->BitvToCell(wr, dcq);
+   }
+   CheckBar("Rx.1m", &rxBars.Data_.Curr_[0], 90100, 101, 101, 101, 101, 6, 1);
+   CheckBar("Rx.5m", &rxBars.Data_.Curr_[1], 90000, 100, 102, 99, 101, 10, 4);
+
+   tree->DailyClear(20261019);
+   if (!symb->Bars_.Data_.Curr_[0].IsNull() || symb->Bars_.GetLastClosed(0) != nullptr) {
+      std::cout << "|err=DailyClear\r[ERROR]" << std::endl;
+      abort();
+   }
+   tree->OnTreeOp([&](const fon9::seed::TreeOpResult&, fon9::seed::TreeOp* op) {
+      op->Get(symbid, [&](const fon9::seed::PodOpResult&, fon9::seed::PodOp* pod) {
+         pod->UnsubscribeStream(&subConn, *tree->RtTab_);
+      });
+   });
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+//--------------------------------------------------------------------------//
+
+// MdSymbs 的增量快照: SaveSnapshot(), LoadFrom();
+using ConflateSymbsSP = fon9::intrusive_ptr<ConflateSymbs>;
+static const char kSnapshotFileName[] = "Symb_UT.mds";
+
+static ConflateSymbsSP MakeSnapshotSymbs(unsigned symbCount) {
+   ConflateSymbsSP tree{new ConflateSymbs};
+   char            symbid[16];
+   auto            lk = tree->SymbMap_.Lock();
+   for (unsigned L = 0; L < symbCount; ++L) {
+      sprintf(symbid, "S%05u", L);
+      auto* symb = static_cast<ConflateSymb*>(tree->FetchSymb(lk, fon9::StrView_cstr(symbid)).get());
+      symb->Deal_.Data_.TotalQty_ = L;
+      symb->Deal_.Data_.Deal_.Pri_.Assign<2>(L);
+   }
+   return tree;
+}
+static void CheckSnapshotLoaded(const char* testName, ConflateSymbs& src, unsigned threadCount) {
+   std::cout << "[TEST ] " << testName << "|threads=" << threadCount;
+   ConflateSymbsSP   dst{new ConflateSymbs};
+   fon9::StopWatch   stopWatch;
+   dst->LoadFrom(kSnapshotFileName, threadCount);
+   const double span = stopWatch.StopTimer();
+   stopWatch.PrintResultNoEOL(span, "|LoadFrom", src.SymbMap_.Lock()->size());
+   auto srcLk = src.SymbMap_.Lock();
+   auto dstLk = dst->SymbMap_.Lock();
+   bool isOK = (srcLk->size() == dstLk->size());
+   for (const auto& isymb : *srcLk) {
+      auto* ssymb = static_cast<ConflateSymb*>(isymb.second.get());
+      auto* dsymb = static_cast<ConflateSymb*>(dst->GetSymb(dstLk, isymb.first).get());
+      if (dsymb == nullptr
+          || dsymb->Deal_.Data_.TotalQty_ != ssymb->Deal_.Data_.TotalQty_
+          || dsymb->Deal_.Data_.Deal_.Pri_ != ssymb->Deal_.Data_.Deal_.Pri_) {
+         isOK = false;
+         break;
+      }
+   }
+   if (isOK) {
+      std::cout << "\r[OK   ]" << std::endl;
+      return;
+   }
+   std::cout << "|srcCount=" << srcLk->size() << "|dstCount=" << dstLk->size() << "\r[ERROR]" << std::endl;
+   abort();
+}
+static void CheckSnapshotResult(const char* testName, fon9::File::Result res, size_t expected) {
+   std::cout << "[TEST ] " << testName << "|records=" << (res ? res.GetResult() : 0);
+   if (res && res.GetResult() == expected) {
+      std::cout << "\r[OK   ]" << std::endl;
+      return;
+   }
+   std::cout << "|expected=" << expected << "\r[ERROR]" << std::endl;
+   abort();
+}
+static void TestMdSymbsSnapshot(unsigned symbCount) {
+   remove(kSnapshotFileName);
+   ConflateSymbsSP   tree = MakeSnapshotSymbs(symbCount);
+   CheckSnapshotResult("SaveSnapshot.Full", tree->SaveSnapshot(kSnapshotFileName), symbCount);
+   CheckSnapshotLoaded("Snapshot.Full", *tree, 1);
+   CheckSnapshotResult("SaveSnapshot.NoChanged", tree->SaveSnapshot(kSnapshotFileName), 0);
+   // 異動 10 個商品(透過發行), 移除 1 個商品.
+   {
+      char symbid[16];
+      auto lk = tree->SymbMap_.Lock();
+      for (unsigned L = 0; L < 10; ++L) {
+         sprintf(symbid, "S%05u", L * 7);
+         auto& isymb = *lk->find(fon9::StrView_cstr(symbid));
+         auto* symb = static_cast<ConflateSymb*>(isymb.second.get());
+         symb->Deal_.Data_.TotalQty_ += 1000;
+         symb->MdRtStream_.Publish(isymb.first, f9sv_RtsPackType_DealPack, f9sv_MdRtsKind_Deal,
+                                   fon9::DayTime{}, fon9::RevBufferList{64});
+      }
+      lk->erase("S00001");
+      tree->UnsafeMarkSnapshotRemoved("S00001");
+   }
+   CheckSnapshotResult("SaveSnapshot.Incremental", tree->SaveSnapshot(kSnapshotFileName), 11);
+   CheckSnapshotLoaded("Snapshot.Incremental", *tree, 4);
+   // 背景快照.
+   {
+      auto lk = tree->SymbMap_.Lock();
+      auto* symb = static_cast<ConflateSymb*>(lk->find("S00002")->second.get());
+      symb->Deal_.Data_.TotalQty_ += 1000;
+      tree->UnsafeMarkSnapshotDirty(*symb);
+   }
+   // 背景快照執行時, 同時呼叫 SaveSnapshot(): 依序執行, 不可破壞快照檔.
+   tree->SaveSnapshotAsync(kSnapshotFileName);
+   tree->SaveSnapshot(kSnapshotFileName);
+   tree->WaitSnapshot();
+   CheckSnapshotLoaded("Snapshot.Async", *tree, 0);
+   // DailyClear() 之後, 必須建立完整快照.
+   tree->DailyClear(20261018);
+   const size_t symbsSize = tree->SymbMap_.Lock()->size();
+   CheckSnapshotResult("SaveSnapshot.AfterDailyClear", tree->SaveSnapshot(kSnapshotFileName), symbsSize);
+   CheckSnapshotLoaded("Snapshot.AfterDailyClear", *tree, 0);
+}
+static void BenchmarkMdSymbsSnapshot(unsigned symbCount) {
+   std::cout << "===== MdSymbs.Snapshot: symbCount=" << symbCount << " =====\n";
+   remove(kSnapshotFileName);
+   ConflateSymbsSP   tree = MakeSnapshotSymbs(symbCount);
+   fon9::StopWatch   stopWatch;
+   tree->SaveTo(kSnapshotFileName);
+   stopWatch.PrintResultNoEOL(stopWatch.StopTimer(), "SaveTo          ", symbCount) << std::endl;
+   tree->SaveSnapshot(kSnapshotFileName);
+   stopWatch.PrintResultNoEOL(stopWatch.StopTimer(), "SaveSnapshot.1st", symbCount) << std::endl;
+   {
+      char symbid[16];
+      auto lk = tree->SymbMap_.Lock();
+      for (unsigned L = 0; L < symbCount; L += 100) {
+         sprintf(symbid, "S%05u", L);
+         tree->UnsafeMarkSnapshotDirty(*lk->find(fon9::StrView_cstr(symbid))->second);
+      }
+   }
+   stopWatch.ResetTimer();
+   tree->SaveSnapshot(kSnapshotFileName);
+   stopWatch.PrintResultNoEOL(stopWatch.StopTimer(), "SaveSnapshot.1% ", symbCount / 100) << std::endl;
+   for (unsigned thrCount : {1u, 2u, 4u, 0u})
+      CheckSnapshotLoaded("LoadFrom", *tree, thrCount);
+   remove(kSnapshotFileName);
+}
+//--------------------------------------------------------------------------//
+
 int main(int argc, char** argv) {
 #if defined(_MSC_VER) && defined(_DEBUG)
    _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
    fon9::AutoPrintTestInfo utinfo{"Symb"};
+   TestConflate();
+   // 必須在首次使用 GetDefaultMdRtRecoverSch() 之前執行.
+   TestRecoverSch();
+   TestMdSymbsSharded();
+   TestShardedGridView();
+   TestBars();
+   TestMdSymbsSnapshot(3000);
    const char* iname = nullptr;
    const char* mx = nullptr;
    SymbList    symbs;
@@ -150,6 +1091,12 @@ int main(int argc, char** argv) {
             Benchmark<SymbHashMap>("std::unordered_map", symbs, mx);
          else if (strcmp(iname, "svect") == 0)
             Benchmark<SymbSvectMap>("fon9::SortedVector", symbs, mx);
+         else if (strcmp(iname, "shard") == 0)
+            BenchmarkSharded(symbs);
+         else if (strcmp(iname, "snapshot") == 0)
+            BenchmarkSnapshot(symbs);
+         else if (strcmp(iname, "mds") == 0)
+            BenchmarkMdSymbsSnapshot(30000);
          else
             goto __USAGE;
       }
@@ -160,10 +1107,11 @@ int main(int argc, char** argv) {
       Benchmark<SymbStdMap>("std::map", symbs, mx);
       Benchmark<SymbHashMap>("std::unordered_map", symbs, mx);
       Benchmark<SymbSvectMap>("fon9::SortedVector", symbs, mx);
+      BenchmarkSharded(symbs);
    }
    return 0;
 
 __USAGE:
-   std::cout << "Usage: RecSize,SymbIdSize,SymbFileName [trie] [map] [hash] [svect]\n";
+   std::cout << "Usage: RecSize,SymbIdSize,SymbFileName [trie] [map] [hash] [svect] [shard] [snapshot] [mds]\n";
    return 3;
 }
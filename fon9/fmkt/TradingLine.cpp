@@ -4,6 +4,10 @@
 #include "fon9/TimedFileName.hpp"
 #include "fon9/FilePath.hpp"
 
+fon9_BEFORE_INCLUDE_STD;
+#include <thread>
+fon9_AFTER_INCLUDE_STD;
+
 namespace fon9 { namespace fmkt {
 
 /// 預設為 No; 當設為 EnabledYN::Yes, 則盡量使用同一條線路.
@@ -16,6 +20,9 @@ bool TradingLine::IsOrigSender(const TradingRequest& req) const {
    (void)req;
    return false;
 }
+bool TradingLine::IsConcurrentSendable() const {
+   return false;
+}
 //--------------------------------------------------------------------------//
 TradingLineHelper::~TradingLineHelper() {
 }
@@ -77,6 +84,7 @@ void TradingLineManager::TradingSvrImpl::SendReqQueue(void* tsvr) {
          break;
       }
    } while (!this->ReqQueue_.empty());
+   owner.IsFastBlocked_.store(false);
    if (res != SendRequestResult::NoReadyLine) {
       if (this->EvHandler_)
          this->EvHandler_->OnSendReqQueueEmpty(*static_cast<Locker*>(tsvr));
@@ -98,12 +106,38 @@ void TradingLineManager::TradingSvrImpl::SendReqQueueByOffer(void* tsvrSelf, FnH
          break;
       }
    } while (!this->ReqQueue_.empty());
+   this->GetOwner().IsFastBlocked_.store(false);
    if (this->EvHandler_)
       this->EvHandler_->OnSendReqQueueEmpty(*static_cast<Locker*>(tsvrSelf));
 }
 //--------------------------------------------------------------------------//
+/// 在 TradingSvr_ 鎖定期間取出 FastRetired_, 解構時(此時已解鎖 TradingSvr_), 等候讀取者離開後刪除.
+class TradingLineManager::FastRetired {
+   fon9_NON_COPY_NON_MOVE(FastRetired);
+   TradingLineManager&           Mgr_;
+   bool                          IsMustWait_;
+   std::vector<const FastLines*> Lines_;
+public:
+   FastRetired(TradingLineManager& mgr, bool isMustWait) : Mgr_(mgr), IsMustWait_{isMustWait} {
+   }
+   ~FastRetired() {
+      if (!this->IsMustWait_ && this->Lines_.empty())
+         return;
+      this->Mgr_.WaitFastReaders();
+      for (const FastLines* old : this->Lines_)
+         delete old;
+   }
+   void Fetch(const TradingLines& tsvr) {
+      (void)tsvr;
+      this->Lines_.insert(this->Lines_.end(), this->Mgr_.FastRetired_.begin(), this->Mgr_.FastRetired_.end());
+      this->Mgr_.FastRetired_.clear();
+   }
+};
 TradingLineManager::~TradingLineManager() {
    this->OnBeforeDestroy();
+   delete this->FastLines_.exchange(nullptr);
+   for (const FastLines* old : this->FastRetired_)
+      delete old;
 }
 void TradingLineManager::OnBeforeDestroy() {
    this->FlowControlTimer_.DisposeAndWait();
@@ -113,7 +147,12 @@ void TradingLineManager::OnBeforeDestroy() {
    this->ClearReqQueue(std::move(tsvr), "TradingLineManager.dtor");
 }
 void TradingLineManager::OnTradingLineBroken(TradingLine& src) {
+   // retired 必須在 tsvr 之前建構, 才能在 tsvr 解鎖後, 等候讀取者離開.
+   // src 可能已在 SendRequest_ByLinesOnly() 被移除, 此時舊的線路表可能正由其他 thread 等候中,
+   // 所以只要 src 是快速線路, 就必須等候讀取者離開, 返回後才能確保不會再使用 src.
+   FastRetired        retired{*this, src.IsConcurrentSendable()};
    TradingSvr::Locker tsvr{this->TradingSvr_};
+   retired.Fetch(*tsvr);
    auto ibeg = tsvr->Lines_.begin();
    auto ifind = std::find(tsvr->Lines_.begin(), tsvr->Lines_.end(), &src);
    if (ifind == tsvr->Lines_.end())
@@ -121,6 +160,10 @@ void TradingLineManager::OnTradingLineBroken(TradingLine& src) {
    if (tsvr->LastIndex_ > static_cast<unsigned>(ifind - ibeg))
       --tsvr->LastIndex_;
    tsvr->Lines_.erase(ifind);
+   if (src.IsConcurrentSendable()) {
+      this->PublishFastLines(*tsvr);
+      retired.Fetch(*tsvr);
+   }
    this->OnTradingLineBroken(src, std::move(tsvr));
 }
 void TradingLineManager::OnTradingLineBroken(TradingLine& src, Locker&& tsvr) {
@@ -140,6 +183,7 @@ void TradingLineManager::OnHelperBroken(Locker&& tsvr) {
 void TradingLineManager::ClearReqQueue(Locker&& tsvr, StrView cause) {
    assert(&tsvr->GetOwner() == this);
    Reqs reqs = std::move(tsvr->ReqQueue_);
+   this->IsFastBlocked_.store(false);
    tsvr.unlock();
    for (const TradingRequestSP& r : reqs)
       this->NoReadyLineReject(*r, cause);
@@ -151,11 +195,16 @@ SendRequestResult TradingLineManager::RequestPushToQueue(TradingRequest& req, co
 }
 //--------------------------------------------------------------------------//
 void TradingLineManager::OnTradingLineReady(TradingLine& src) {
+   FastRetired        retired{*this, false};
    TradingSvr::Locker tsvr{this->TradingSvr_};
    auto ifind = std::find(tsvr->Lines_.begin(), tsvr->Lines_.end(), &src);
    if (ifind == tsvr->Lines_.end()) {
       tsvr->LastIndex_ = static_cast<unsigned>(tsvr->Lines_.size());
       tsvr->Lines_.push_back(&src);
+      if (src.IsConcurrentSendable()) {
+         this->PublishFastLines(*tsvr);
+         retired.Fetch(*tsvr);
+      }
    }
    else {
       tsvr->LastIndex_ = static_cast<unsigned>(ifind - tsvr->Lines_.begin());
@@ -278,7 +327,10 @@ SendRequestResult TradingLineManager::SendRequest_ByLinesOnly(TradingRequest& re
          hasBusyLine = true;
       else {
          assert(resSend == LineSendResult::Broken);
+         const bool isFastLine = tsvr.Lines_[tsvr.LastIndex_]->IsConcurrentSendable();
          tsvr.Lines_.erase(tsvr.Lines_.begin() + tsvr.LastIndex_);
+         if (isFastLine)
+            this->PublishFastLines(tsvr);
          if (L < --lineCount)
             goto __RETRY_SAME_INDEX;
          if (lineCount == 0)
@@ -326,6 +378,105 @@ SendRequestResult TradingLineManager::NoReadyLineReject(TradingRequest& req, Str
    return SendRequestResult::NoReadyLine;
 }
 //--------------------------------------------------------------------------//
+/// 每個 thread 使用固定的 FastReaders_ slot.
+static unsigned GetFastReaderSlot() {
+   static std::atomic<unsigned> NextSlot_{0};
+   static thread_local unsigned TlsSlot_ = NextSlot_.fetch_add(1, std::memory_order_relaxed);
+   return TlsSlot_;
+}
+/// 進入快速路徑時, 在 FastReaders_[epoch][slot] 計數, 離開時扣除.
+/// 計數之後才取得「快速線路表」, 所以 WaitFastReaders() 返回後, 舊的線路表不會再被使用.
+class TradingLineManager::FastReader {
+   fon9_NON_COPY_NON_MOVE(FastReader);
+   std::atomic<unsigned>& Counter_;
+public:
+   const FastLines* const Lines_;
+   FastReader(TradingLineManager& mgr)
+      : Counter_(mgr.FastReaders_[mgr.FastEpoch_.load() & 1][GetFastReaderSlot() % kFastReaderSlots].Count_)
+      , Lines_{(this->Counter_.fetch_add(1), mgr.FastLines_.load())} {
+   }
+   ~FastReader() {
+      this->Counter_.fetch_sub(1, std::memory_order_release);
+   }
+};
+SendRequestResult TradingLineManager::SendRequest_ByFastLines(TradingRequest& req) {
+   SendRequestResult res = SendRequestResult::Queuing;
+   TradingLine*      brokenLine = nullptr;
+   {  // 快速路徑的讀取範圍, 離開後才能鎖定 TradingSvr_;
+      FastReader  reader{*this};
+      if (fon9_UNLIKELY(reader.Lines_ == nullptr))
+         return SendRequestResult::Queuing;
+      const unsigned lineCount = static_cast<unsigned>(reader.Lines_->size());
+      const bool     isTryLast = (gTradingLineSelect_TryLastLine_YN == EnabledYN::Yes);
+      // 游標不使用 fetch_add(): 同時下單時可能會選到相同的線路, 但只影響均分的程度, 不影響正確性,
+      // 如此可避免每筆下單都多一次 lock 指令.
+      unsigned       idx = this->FastCursor_.load(std::memory_order_relaxed);
+      if (!isTryLast)
+         this->FastCursor_.store(++idx, std::memory_order_relaxed);
+      for (unsigned L = 0; L < lineCount; ++L, ++idx) {
+         TradingLine* line = (*reader.Lines_)[idx % lineCount];
+         const TradingLine::SendResult resSend = line->SendRequest(req);
+         if (fon9_LIKELY(resSend == TradingLine::SendResult::Sent)) {
+            if (isTryLast && L > 0)
+               this->FastCursor_.store(idx, std::memory_order_relaxed);
+            res = SendRequestResult::Sent;
+            break;
+         }
+         if (resSend == TradingLine::SendResult::RejectRequest) {
+            res = SendRequestResult::RejectRequest;
+            break;
+         }
+         if (resSend == TradingLine::SendResult::Broken)
+            brokenLine = line;
+         // FlowControl, Busy, NotSupport, Broken: 試下一條線路,
+         // 若全部都無法送出, 則由呼叫端鎖定後處理: 啟動流量管制計時器、放入 Queue...
+      }
+   }
+   if (fon9_UNLIKELY(brokenLine != nullptr)) {
+      // 與 SendRequest_ByLinesOnly() 相同: 斷線的線路直接從可用線路表移除.
+      // 舊的線路表留在 FastRetired_, 等 brokenLine 通知 OnTradingLineBroken() 時再等候讀取者離開,
+      // 如此可避免下單的 thread 等候其他讀取者.
+      Locker tsvr{this->TradingSvr_};
+      auto   ifind = std::find(tsvr->Lines_.begin(), tsvr->Lines_.end(), brokenLine);
+      if (ifind != tsvr->Lines_.end()) {
+         if (tsvr->LastIndex_ > static_cast<unsigned>(ifind - tsvr->Lines_.begin()))
+            --tsvr->LastIndex_;
+         tsvr->Lines_.erase(ifind);
+         this->PublishFastLines(*tsvr);
+      }
+   }
+   return res;
+}
+void TradingLineManager::PublishFastLines(const TradingLines& tsvr) {
+   FastLines* lines = nullptr;
+   for (TradingLine* ln : tsvr.Lines_) {
+      if (!ln->IsConcurrentSendable())
+         continue;
+      if (lines == nullptr)
+         lines = new FastLines;
+      lines->push_back(ln);
+   }
+   if (const FastLines* old = this->FastLines_.exchange(lines))
+      this->FastRetired_.push_back(old);
+}
+void TradingLineManager::WaitFastReaders() {
+   // 與 userspace RCU 相同: 需要切換 2 次 epoch,
+   // 才能確保「讀到舊 epoch 之後, 才增加計數」的讀取者也已離開.
+   // 讀取者停留的時間很短, 所以先 yield(), 若仍未離開, 再改用 sleep 退讓.
+   std::lock_guard<std::mutex> lk{this->FastWaitMutex_};
+   for (unsigned phase = 0; phase < 2; ++phase) {
+      const unsigned prev = this->FastEpoch_.fetch_xor(1) & 1;
+      for (FastReaderCounter& c : this->FastReaders_[prev]) {
+         for (unsigned spin = 0; c.Count_.load() != 0; ++spin) {
+            if (spin < 64)
+               std::this_thread::yield();
+            else
+               std::this_thread::sleep_for(std::chrono::microseconds(50));
+         }
+      }
+   }
+}
+//--------------------------------------------------------------------------//
 TradingLineLogPathMaker::~TradingLineLogPathMaker() {
 }
 TimeStamp TradingLineLogPathMaker::GetTDay() {
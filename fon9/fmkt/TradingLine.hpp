@@ -6,6 +6,7 @@
 #include "fon9/Timer.hpp"
 #include "fon9/ConfigUtils.hpp"
 #include <deque>
+#include <atomic>
 
 namespace fon9 { namespace fmkt {
 
@@ -39,8 +40,16 @@ public:
    /// 設計衍生者請注意:
    /// 透過 TradingLineManager 來的下單要求, 必定已經鎖住「可用線路表」,
    /// 因此不可再呼叫 TradingLineManager 的相關函式, 會造成死結!
+   /// 若 this->IsConcurrentSendable() 返回 true, 則可能在沒鎖住「可用線路表」的情況下,
+   /// 由多個 thread 同時呼叫, 此時一樣不可呼叫 TradingLineManager 的相關函式.
    virtual SendResult SendRequest(TradingRequest& req) = 0;
 
+   /// this->SendRequest() 是否可以同時被多個 thread 呼叫? (由線路自行保護: 流量管制、序號...)
+   /// - 若返回 true, TradingLineManager 會將此線路放入「快速線路表」, 下單時不用鎖住「可用線路表」.
+   /// - 在線路加入 TradingLineManager 時判斷, 線路加入後不應改變.
+   /// - 預設傳回 false;
+   virtual bool IsConcurrentSendable() const;
+
    /// 判斷 this 是否為 req 的原始傳送者.
    /// 預設傳回 false;
    virtual bool IsOrigSender(const TradingRequest& req) const;
@@ -129,6 +138,7 @@ public:
       }
       void ReqQueueMoveTo(Reqs& out) {
          out = std::move(this->ReqQueue_);
+         this->GetOwner().IsFastBlocked_.store(false);
       }
       bool IsHelperReady() const;
       bool IsSendable() const;
@@ -173,12 +183,21 @@ public:
    /// 不包含: 流量管制, 線路忙碌.
    void OnTradingLineBroken(TradingLine& src);
 
+   /// - 若有「快速線路表」且沒有排隊中的要求, 則先嘗試不鎖定的快速送出.
+   /// - 若快速線路都無法送出(流量管制、忙碌...), 則鎖定後使用一般的方式處理(可能放入 Queue).
    SendRequestResult SendRequest(TradingRequest& req) {
+      if (this->FastLines_.load(std::memory_order_relaxed) != nullptr && !this->IsFastBlocked_.load()) {
+         const SendRequestResult res = this->SendRequest_ByFastLines(req);
+         if (fon9_LIKELY(res != SendRequestResult::Queuing))
+            return res;
+      }
       return this->SendRequest(req, Locker{this->TradingSvr_});
    }
    SendRequestResult SendRequest(TradingRequest& req, const Locker& tsvr) {
       SendRequestResult res;
       if (fon9_LIKELY(tsvr->ReqQueue_.empty())) {
+         if (fon9_UNLIKELY(this->IsFastBlocked_.load(std::memory_order_relaxed)))
+            this->IsFastBlocked_.store(false);
          res = this->SendRequest_ByLinesOrHelper(req, tsvr);
       }
       else {
@@ -186,6 +205,8 @@ public:
       }
       if (fon9_LIKELY(res != SendRequestResult::Queuing))
          return res;
+      // 在放入 Queue 之前設定, 讓快速路徑在 Queue 有資料時, 改用鎖定的方式排隊.
+      this->IsFastBlocked_.store(true);
       return this->RequestPushToQueue(req, tsvr);
    }
 
@@ -277,6 +298,46 @@ protected:
    SendRequestResult SendRequest_ByLinesOnly(TradingRequest& req, TradingLines& tsvr);
 
 private:
+   /// 「快速線路表」: 由 tsvr->Lines_ 裡面 IsConcurrentSendable() 的線路建立, 建立後不再改變(RCU).
+   /// - 線路異動時, 建立新的線路表後替換, 等候全部的讀取者離開後, 才刪除舊的線路表.
+   /// - 讀取者使用 FastReaders_[FastEpoch_ & 1][thread slot] 計數, 分散計數器可避免讀取者之間爭用同一個 cache line.
+   using FastLines = std::vector<TradingLine*>;
+   struct FastReaderCounter {
+      std::atomic<unsigned>   Count_{0};
+      char                    Padding___[64 - sizeof(std::atomic<unsigned>)];
+   };
+   enum : unsigned {
+      kFastReaderSlots = 8,
+   };
+   class FastReader;
+   class FastRetired;
+   std::atomic<const FastLines*> FastLines_{nullptr};
+   /// 輪流使用快速線路的游標.
+   std::atomic<unsigned>         FastCursor_{0};
+   std::atomic<unsigned>         FastEpoch_{0};
+   /// 當 tsvr->ReqQueue_ 有排隊中的要求時為 true, 此時不使用快速路徑, 避免插隊.
+   std::atomic<bool>             IsFastBlocked_{false};
+   /// 不論 this 的開始位置為何, 讓 FastReaders_[0][0] 與前面的成員(例: 每次下單都會異動的 FastCursor_)
+   /// 距離至少 64 bytes, 不會在同一個 cache line;
+   /// 每個 FastReaderCounter 的 Count_ 都在 64 bytes 的開頭, 所以計數器之間(及與後面的成員)也不會在同一個 cache line.
+   char                          Padding___[64];
+   FastReaderCounter             FastReaders_[2][kFastReaderSlots];
+   /// 已被替換, 但尚未刪除的「快速線路表」, 必須在鎖定 TradingSvr_ 的情況下存取.
+   std::vector<const FastLines*> FastRetired_;
+   /// 避免多個 thread 同時切換 FastEpoch_; 讀取者不會用到此 mutex.
+   std::mutex                    FastWaitMutex_;
+
+   /// 使用「快速線路表」送出 req, 不鎖定 TradingSvr_;
+   /// - 若無法送出(流量管制、忙碌、線路斷線...), 則返回 SendRequestResult::Queuing, 由呼叫端改用鎖定的方式處理.
+   SendRequestResult SendRequest_ByFastLines(TradingRequest& req);
+   /// 必須在鎖定 TradingSvr_ 的情況下呼叫: 用 tsvr.Lines_ 重建「快速線路表」;
+   /// 舊的線路表放入 this->FastRetired_, 不在此等候讀取者離開,
+   /// 由 FastRetired 在解鎖 TradingSvr_ 之後等候, 然後刪除.
+   void PublishFastLines(const TradingLines& tsvr);
+   /// 等候在此之前進入快速路徑的讀取者全部離開(grace period).
+   /// 不可在鎖定 TradingSvr_ 的情況下呼叫.
+   void WaitFastReaders();
+
    /// 用 Lines 或 Helper 送出 req, 若無法送出, 則透過 retval 告知原因, 不會放入 Queue;
    /// - 透過 this->SendRequest_ByLinesOnly() 送出 req;
    /// - 若有可用線路, 但暫時無法送出(需要 Queuing) 則:
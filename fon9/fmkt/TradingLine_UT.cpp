@@ -0,0 +1,171 @@
+﻿// \file fon9/fmkt/TradingLine_UT.cpp
+// \author fonwinz@gmail.com
+#include "fon9/fmkt/TradingLine.hpp"
+#include "fon9/TestTools.hpp"
+
+namespace f9fmkt = fon9::fmkt;
+//--------------------------------------------------------------------------//
+class UtRequest : public f9fmkt::TradingRequest {
+   fon9_NON_COPY_NON_MOVE(UtRequest);
+public:
+   const unsigned Id_;
+   UtRequest(unsigned id) : Id_{id} {
+   }
+};
+using UtRequestSP = fon9::intrusive_ptr<UtRequest>;
+
+class UtLine : public f9fmkt::TradingLine {
+   fon9_NON_COPY_NON_MOVE(UtLine);
+   const bool IsConcurrent_;
+public:
+   std::atomic<uint64_t>   SentCount_{0};
+   std::atomic<SendResult> NextResult_{SendResult::Sent};
+   /// 僅在單一 thread 的測試使用: 記錄送出的順序.
+   std::vector<unsigned>   SentIds_;
+   bool                    IsRecordIds_{false};
+   char                    Padding___[6];
+
+   UtLine(bool isConcurrent) : IsConcurrent_{isConcurrent} {
+   }
+   SendResult SendRequest(f9fmkt::TradingRequest& req) override {
+      const SendResult res = this->NextResult_.load(std::memory_order_relaxed);
+      if (res == SendResult::Sent) {
+         this->SentCount_.fetch_add(1, std::memory_order_relaxed);
+         if (this->IsRecordIds_)
+            this->SentIds_.push_back(static_cast<UtRequest*>(&req)->Id_);
+      }
+      return res;
+   }
+   bool IsConcurrentSendable() const override {
+      return this->IsConcurrent_;
+   }
+};
+using UtLineUP = std::unique_ptr<UtLine>;
+using UtLines = std::vector<UtLineUP>;
+
+class UtLineMgr : public f9fmkt::TradingLineManager {
+   fon9_NON_COPY_NON_MOVE(UtLineMgr);
+public:
+   UtLineMgr() = default;
+   ~UtLineMgr() {
+      this->OnBeforeDestroy();
+   }
+   bool IsReqQueueEmpty() {
+      return this->Lock()->IsReqQueueEmpty();
+   }
+};
+
+//--------------------------------------------------------------------------//
+void TestFastLines() {
+   UtLineMgr mgr;
+   UtLines   lines;
+   for (unsigned L = 0; L < 3; ++L) {
+      lines.emplace_back(new UtLine{true});
+      mgr.OnTradingLineReady(*lines.back());
+   }
+   UtRequestSP req{new UtRequest{0}};
+   for (unsigned L = 0; L < 300; ++L) {
+      if (mgr.SendRequest(*req) != f9fmkt::SendRequestResult::Sent)
+         fon9_CheckTestResult("RoundRobin: SendRequest() != Sent", false);
+   }
+   fon9_CheckTestResult("RoundRobin: each line sent 100.",
+                        lines[0]->SentCount_ == 100 && lines[1]->SentCount_ == 100 && lines[2]->SentCount_ == 100);
+
+   // 其中一條線路忙碌: 快速路徑改用其他線路.
+   lines[1]->NextResult_ = UtLine::SendResult::Busy;
+   for (unsigned L = 0; L < 100; ++L)
+      mgr.SendRequest(*req);
+   fon9_CheckTestResult("Busy line: skipped.",
+                        lines[0]->SentCount_ + lines[2]->SentCount_ == 300 && lines[1]->SentCount_ == 100);
+
+   // 全部忙碌: 進入 Queue, 之後的要求不可插隊.
+   for (auto& ln : lines) {
+      ln->NextResult_ = UtLine::SendResult::Busy;
+      ln->IsRecordIds_ = true;
+   }
+   std::vector<UtRequestSP> reqs;
+   for (unsigned L = 1; L <= 3; ++L)
+      reqs.emplace_back(new UtRequest{L});
+   bool isQueuing = (mgr.SendRequest(*reqs[0]) == f9fmkt::SendRequestResult::Queuing);
+   lines[0]->NextResult_ = UtLine::SendResult::Sent;
+   isQueuing = isQueuing && (mgr.SendRequest(*reqs[1]) == f9fmkt::SendRequestResult::Queuing);
+   fon9_CheckTestResult("All busy: Queuing, and no queue jumping.", isQueuing && lines[0]->SentIds_.empty());
+
+   mgr.OnTradingLineReady(*lines[0]);
+   fon9_CheckTestResult("Line ready: queue sent.", mgr.IsReqQueueEmpty()
+                        && lines[0]->SentIds_ == (std::vector<unsigned>{1, 2}));
+   mgr.SendRequest(*reqs[2]);
+   fon9_CheckTestResult("Queue empty: fast path again.", lines[0]->SentIds_ == (std::vector<unsigned>{1, 2, 3}));
+
+   // 線路斷線: 從快速線路表移除.
+   lines[0]->NextResult_ = UtLine::SendResult::Broken;
+   lines[2]->NextResult_ = UtLine::SendResult::Sent;
+   lines[2]->IsRecordIds_ = false;
+   const uint64_t sent2 = lines[2]->SentCount_;
+   for (unsigned L = 0; L < 10; ++L)
+      mgr.SendRequest(*req);
+   lines[0]->NextResult_ = UtLine::SendResult::Sent;
+   for (unsigned L = 0; L < 10; ++L)
+      mgr.SendRequest(*req);
+   fon9_CheckTestResult("Broken line: removed.", lines[0]->SentIds_.size() == 3 && lines[2]->SentCount_ == sent2 + 20);
+
+   mgr.OnTradingLineBroken(*lines[1]);
+   mgr.OnTradingLineBroken(*lines[2]);
+   fon9_CheckTestResult("No ready line.", mgr.SendRequest(*req) == f9fmkt::SendRequestResult::NoReadyLine);
+}
+//--------------------------------------------------------------------------//
+/// 多 thread 同時下單, 測試每秒可送出的下單要求數量.
+/// - isConcurrent=false: 每筆下單都需要鎖住 TradingSvr_;
+/// - isConcurrent=true:  使用快速線路表.
+void BenchSendRequest(bool isConcurrent, unsigned threadCount, unsigned lineCount, uint64_t reqCount) {
+   UtLineMgr mgr;
+   UtLines   lines;
+   for (unsigned L = 0; L < lineCount; ++L) {
+      lines.emplace_back(new UtLine{isConcurrent});
+      mgr.OnTradingLineReady(*lines.back());
+   }
+   std::atomic<uint64_t>    errCount{0};
+   std::vector<std::thread> thrs;
+   fon9::StopWatch          stopWatch;
+   for (unsigned T = 0; T < threadCount; ++T) {
+      thrs.emplace_back([&mgr, &errCount, reqCount]() {
+         UtRequestSP req{new UtRequest{0}};
+         for (uint64_t L = 0; L < reqCount; ++L) {
+            if (mgr.SendRequest(*req) != f9fmkt::SendRequestResult::Sent)
+               errCount.fetch_add(1, std::memory_order_relaxed);
+         }
+      });
+   }
+   for (auto& t : thrs)
+      t.join();
+   const double   span = stopWatch.StopTimer();
+   const uint64_t total = reqCount * threadCount;
+   uint64_t       sent = 0;
+   for (auto& ln : lines)
+      sent += ln->SentCount_;
+   std::cout << "[TEST ] " << (isConcurrent ? "FastLines" : "Locked   ")
+      << "|threads=" << threadCount << "|lines=" << lineCount << "|";
+   stopWatch.PrintResultNoEOL(span, "SendRequest", total)
+      << "|rate=" << static_cast<uint64_t>(static_cast<double>(total) / span) << "/s";
+   if (errCount != 0 || sent != total) {
+      std::cout << "|err=" << errCount << "|sent=" << sent << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+//--------------------------------------------------------------------------//
+int main(int argc, char** argv) {
+   #if defined(_MSC_VER) && defined(_DEBUG)
+      _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+   #endif
+   fon9::AutoPrintTestInfo utinfo{"TradingLine"};
+
+   TestFastLines();
+   utinfo.PrintSplitter();
+
+   const uint64_t reqCount = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 0u);
+   for (unsigned threadCount : {1u, 2u, 4u, 8u}) {
+      for (bool isConcurrent : {false, true})
+         BenchSendRequest(isConcurrent, threadCount, 4, reqCount ? reqCount : 1000 * 1000);
+   }
+}
@@ -109,6 +109,15 @@ io::FdrServiceSP IoManager::GetFdrService() {
 }
 #endif
 
+void IoManager::GetIoServiceStInfo(RevBuffer& rbuf) {
+#ifdef __fon9_io_FdrService_hpp__
+   if (this->FdrService_)
+      this->FdrService_->GetStInfo(rbuf);
+#else
+   (void)rbuf;
+#endif
+}
+
 //--------------------------------------------------------------------------//
 //
 // 在 Device 還活著時, 不能把 DeviceMap 清除,
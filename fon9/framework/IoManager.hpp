@@ -94,6 +94,10 @@ public:
 
    void OnSession_StateUpdated(io::Device& dev, StrView stmsg, LogLevel lv) override;
 
+   /// 取得 io service 的執行統計: 例如 FdrThread 的 loops, idle ratio, events per wakeup.
+   /// 若 io service 尚未建立, 則不會填入任何資料.
+   void GetIoServiceStInfo(RevBuffer& rbuf);
+
    /// 在首次有需要時(GetIocpService() or GetFdrService()), 才會將該 io service 建立起來.
 #ifdef __fon9_io_win_IocpService_hpp__
    private:
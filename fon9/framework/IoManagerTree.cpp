@@ -7,6 +7,31 @@
 
 namespace fon9 {
 
+IoManagerSeed::~IoManagerSeed() {
+}
+void IoManagerSeed::OnSeedCommand(seed::SeedOpResult& res, StrView cmdln, seed::FnCommandResultHandler resHandler,
+                                  seed::MaTreeBase::Locker&& ulk, seed::SeedVisitor* visitor) {
+   if (cmdln == "?") {
+      res.OpResult_ = seed::OpResult::no_error;
+      resHandler(res,
+         "iost" fon9_kCSTR_CELLSPL "Io service state info"
+      );
+      return;
+   }
+   if (iequals(cmdln, "iost")) {
+      if (auto* iomgr = dynamic_cast<IoManagerTree*>(this->Sapling_.get())) {
+         RevBufferList rbuf{256};
+         iomgr->GetIoServiceStInfo(rbuf);
+         res.OpResult_ = seed::OpResult::no_error;
+         resHandler(res, ToStrView(BufferTo<std::string>(rbuf.MoveOut())));
+         return;
+      }
+   }
+   base::OnSeedCommand(res, cmdln, std::move(resHandler), std::move(ulk), visitor);
+}
+
+//--------------------------------------------------------------------------//
+
 seed::LayoutSP IoManagerTree::MakeLayoutImpl() {
    seed::LayoutSP saplingLayout = IoManager::GetAcceptedClientLayout();
    seed::Fields   fields;
@@ -7,6 +7,18 @@
 
 namespace fon9 {
 
+/// 在 MaTree 裡面放置 IoManagerTree 的 NamedSeed.
+/// 額外提供 "iost" 指令: 取得 io service 的執行統計.
+class fon9_API IoManagerSeed : public seed::NamedSapling {
+   fon9_NON_COPY_NON_MOVE(IoManagerSeed);
+   using base = seed::NamedSapling;
+public:
+   using base::base;
+   ~IoManagerSeed();
+   void OnSeedCommand(seed::SeedOpResult& res, StrView cmdln, seed::FnCommandResultHandler resHandler,
+                      seed::MaTreeBase::Locker&& ulk, seed::SeedVisitor* visitor) override;
+};
+
 fon9_WARN_DISABLE_PADDING;
 class fon9_API IoManagerTree : public seed::Tree, public IoManager {
    fon9_NON_COPY_NON_MOVE(IoManagerTree);
@@ -29,8 +41,8 @@ public:
    template <class IoTree = IoManagerTree, class... ArgsT>
    static intrusive_ptr<IoTree> Plant(seed::MaTree& maTree, const IoManagerArgs& ioargs, ArgsT&&... args) {
       intrusive_ptr<IoTree> retval{new IoTree(ioargs, std::forward<ArgsT>(args)...)};
-      seed::NamedSapling*   seed;
-      if (!maTree.Add(seed = new seed::NamedSapling(retval, ioargs.Name_)))
+      IoManagerSeed*        seed;
+      if (!maTree.Add(seed = new IoManagerSeed(retval, ioargs.Name_)))
          return nullptr;
       seed->SetTitle(ioargs.CfgFileName_);
       seed->SetDescription(ioargs.Result_);
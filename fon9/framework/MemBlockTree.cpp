@@ -0,0 +1,173 @@
+﻿// \file fon9/framework/MemBlockTree.cpp
+// \author fonwinz@gmail.com
+#include "fon9/buffer/MemBlockImpl.hpp"
+#include "fon9/seed/Plugins.hpp"
+#include "fon9/seed/FieldMaker.hpp"
+#include "fon9/seed/TreeLockContainerT.hpp"
+#include "fon9/CharVector.hpp"
+#include "fon9/MustLock.hpp"
+#include "fon9/StrTo.hpp"
+
+namespace fon9 {
+
+//--------------------------------------------------------------------------//
+/// MemBlock 使用統計的 seed tree, 每個 level 一筆, key = BlockSize.
+/// - 每次查詢(GridView, Get)時, 重新取得統計資料.
+struct MemBlockStRow {
+   CharVector  Name_;
+   uint64_t    Hit_{0};
+   uint64_t    Miss_{0};
+   uint64_t    SlabRefill_{0};
+   uint64_t    MallocFallback_{0};
+   uint64_t    FreeBatch_{0};
+   uint64_t    AsyncRefill_{0};
+   uint64_t    SlabBytes_{0};
+   uint64_t    ReservedLists_{0};
+   uint64_t    RequiredLists_{0};
+
+   void Assign(const impl::MemBlockLevelStInfo& src) {
+      this->Hit_ = src.Hit_;
+      this->Miss_ = src.Miss_;
+      this->SlabRefill_ = src.SlabRefill_;
+      this->MallocFallback_ = src.MallocFallback_;
+      this->FreeBatch_ = src.FreeBatch_;
+      this->AsyncRefill_ = src.AsyncRefill_;
+      this->SlabBytes_ = src.SlabBytes_;
+      this->ReservedLists_ = src.ReservedLists_;
+      this->RequiredLists_ = src.RequiredLists_;
+   }
+
+   MemBlockStRow& GetSeedRW(seed::Tab&) {
+      return *this;
+   }
+   seed::TreeSP HandleGetSapling(seed::Tab&) {
+      return seed::TreeSP{};
+   }
+   template <class Locker>
+   void HandleSeedCommand(Locker&, seed::SeedOpResult& res, StrView cmdln, seed::FnCommandResultHandler&& resHandler) {
+      res.OpResult_ = seed::OpResult::not_supported_cmd;
+      resHandler(res, cmdln);
+   }
+};
+struct MemBlockStRows {
+   using iterator = MemBlockStRow*;
+   using const_iterator = const MemBlockStRow*;
+   MemBlockStRow  Rows_[kMemBlockLevelCount];
+
+   MemBlockStRows() {
+      for (unsigned lvidx = 0; lvidx < kMemBlockLevelCount; ++lvidx)
+         this->Rows_[lvidx].Name_ = RevPrintTo<CharVector>(MemBlockLevelSize_[lvidx]);
+   }
+   iterator find(StrView name) {
+      iterator i = this->begin();
+      for (; i != this->end(); ++i) {
+         if (ToStrView(i->Name_) == name)
+            break;
+      }
+      return i;
+   }
+   /// Rows_ 依照 BlockSize 由小到大排列, 所以用數值判斷: 返回第一個 BlockSize >= name 的 row.
+   iterator lower_bound(StrView name) {
+      const size_t   sz = StrTo(name, size_t{0});
+      unsigned       lvidx = 0;
+      while (lvidx < kMemBlockLevelCount && MemBlockLevelSize_[lvidx] < sz)
+         ++lvidx;
+      return this->Rows_ + lvidx;
+   }
+   iterator begin() { return this->Rows_; }
+   iterator end() { return this->Rows_ + kMemBlockLevelCount; }
+   const_iterator begin() const { return this->Rows_; }
+   const_iterator end() const { return this->Rows_ + kMemBlockLevelCount; }
+};
+using MemBlockStRowsMx = MustLock<MemBlockStRows>;
+
+class MemBlockStTree : public seed::Tree {
+   fon9_NON_COPY_NON_MOVE(MemBlockStTree);
+   using base = seed::Tree;
+   using Locker = MemBlockStRowsMx::Locker;
+   using PodOp = seed::PodOpLockerNoWrite<MemBlockStRow, Locker>;
+   MemBlockStRowsMx Rows_;
+
+   void Refresh() {
+      Locker                     rows{this->Rows_};
+      impl::MemBlockLevelStInfo  st;
+      for (unsigned lvidx = 0; lvidx < kMemBlockLevelCount; ++lvidx) {
+         if (impl::MemBlockGetLevelSt(lvidx, st))
+            rows->Rows_[lvidx].Assign(st);
+      }
+   }
+   struct TreeOp : public seed::TreeOp {
+      fon9_NON_COPY_NON_MOVE(TreeOp);
+      using base = seed::TreeOp;
+      using base::base;
+      static void MakeRecordView(MemBlockStRows::iterator ivalue, seed::Tab* tab, RevBuffer& rbuf) {
+         if (tab)
+            FieldsCellRevPrint(tab->Fields_, seed::SimpleRawRd{*ivalue}, rbuf);
+         RevPrint(rbuf, ivalue->Name_);
+      }
+      void GridView(const seed::GridViewRequest& req, seed::FnGridViewOp fnCallback) override {
+         MemBlockStTree& tree = *static_cast<MemBlockStTree*>(&this->Tree_);
+         tree.Refresh();
+         seed::TreeOp_GridView_MustLock(*this, tree.Rows_, req, std::move(fnCallback), &MakeRecordView);
+      }
+      void Get(StrView strKeyText, seed::FnPodOp fnCallback) override {
+         MemBlockStTree& tree = *static_cast<MemBlockStTree*>(&this->Tree_);
+         tree.Refresh();
+         seed::TreeOp_Get_MustLock<PodOp>(*this, tree.Rows_, strKeyText, std::move(fnCallback));
+      }
+   };
+   static seed::LayoutSP MakeLayout() {
+      seed::Fields fields;
+      fields.Add(fon9_MakeField2_const(MemBlockStRow, Hit));
+      fields.Add(fon9_MakeField2_const(MemBlockStRow, Miss));
+      fields.Add(fon9_MakeField2_const(MemBlockStRow, SlabRefill));
+      fields.Add(fon9_MakeField2_const(MemBlockStRow, MallocFallback));
+      fields.Add(fon9_MakeField2_const(MemBlockStRow, FreeBatch));
+      fields.Add(fon9_MakeField2_const(MemBlockStRow, AsyncRefill));
+      fields.Add(fon9_MakeField2_const(MemBlockStRow, SlabBytes));
+      fields.Add(fon9_MakeField2_const(MemBlockStRow, ReservedLists));
+      fields.Add(fon9_MakeField2_const(MemBlockStRow, RequiredLists));
+      return new seed::Layout1(fon9_MakeField(MemBlockStRow, Name_, "BlockSize"),
+                               new seed::Tab{Named{"St", "MemBlock level statistics"}, std::move(fields), seed::TabFlag::NoSapling},
+                               seed::TreeFlag{});
+   }
+public:
+   MemBlockStTree() : base{MakeLayout()} {
+   }
+   void OnTreeOp(seed::FnTreeOp fnCallback) override {
+      TreeOp op{*this};
+      fnCallback(seed::TreeOpResult{this, seed::OpResult::no_error}, &op);
+   }
+};
+//--------------------------------------------------------------------------//
+/// args = "Name=MemBlock"
+/// - 在 holder.Root_ 加入 MemBlock 的使用統計.
+static bool MemBlockSt_Start(seed::PluginsHolder& holder, StrView args) {
+   std::string name{"MemBlock"};
+   StrView     tag, value;
+   while (SbrFetchTagValue(args, tag, value)) {
+      if (tag == "Name")
+         name = value.ToString();
+      else {
+         holder.SetPluginsSt(LogLevel::Error, "Unknown tag=", tag);
+         return false;
+      }
+   }
+   if (!holder.Root_->AddNamedSapling(new MemBlockStTree, name)) {
+      holder.SetPluginsSt(LogLevel::Error, "Name=", name, "|err=Name is dup");
+      return false;
+   }
+   return true;
+}
+
+} // namespace fon9
+
+extern "C" fon9_API fon9::seed::PluginsDesc f9p_MemBlockSt;
+static fon9::seed::PluginsPark f9pAutoPluginsReg{"MemBlockSt", &f9p_MemBlockSt};
+
+fon9::seed::PluginsDesc f9p_MemBlockSt{
+   "",
+   &fon9::MemBlockSt_Start,
+   nullptr,
+   nullptr,
+};
@@ -29,6 +29,11 @@ namespace fon9 { namespace io {
 //       Loopback=Y or N
 //       TTL=hops    必須有提供 Loopback 選項.
 //
+// 接收的額外選項(目前僅 Linux 支援):
+//    RecvBatch=n       使用 recvmmsg() 一次最多接收 n 個封包,
+//                      然後在一次 OnDevice_Recv() 事件裡面, 提供這批封包, 每個封包為一個獨立的區塊.
+//    RecvTimestamp=Y   在批次接收時, 取得 kernel 記錄的封包接收時間(SO_TIMESTAMPNS).
+//
 
 bool DgramBase::CreateSocket(Socket& so, const SocketAddress& addr, SocketResult& soRes) {
    this->Config_.Options_.TCP_NODELAY_ = 0;
@@ -75,6 +80,15 @@ bool DgramBase::CreateSocket(Socket& so, const SocketAddress& addr, SocketResult
          return false;
       }
    }
+#ifdef SO_TIMESTAMPNS
+   if (this->IsRecvTimestamp_) {
+      int optval = 1;
+      if (setsockopt(so.GetSocketHandle(), SOL_SOCKET, SO_TIMESTAMPNS, reinterpret_cast<char*>(&optval), sizeof(optval)) != 0) {
+         soRes = SocketResult{"SO_TIMESTAMPNS"};
+         return false;
+      }
+   }
+#endif
    return true;
 }
 void DgramBase::OpImpl_Open(std::string cfgstr) {
@@ -82,6 +96,11 @@ void DgramBase::OpImpl_Open(std::string cfgstr) {
    this->Interface_.Addr_.sa_family = AF_UNSPEC;
    this->TTL_ = 0;
    this->Loopback_ = -1;
+   this->RecvBatch_ = 0;
+   this->IsRecvTimestamp_ = false;
+   this->RecvBatchPackets_.store(0, std::memory_order_relaxed);
+   this->RecvBatchSyscalls_.store(0, std::memory_order_relaxed);
+   this->LastRecvKernelTime_.AssignNull();
    base::OpImpl_Open(std::move(cfgstr));
 }
 ConfigParser::Result DgramBase::OpImpl_SetProperty(StrView tag, StrView& value) {
@@ -103,6 +122,14 @@ ConfigParser::Result DgramBase::OpImpl_SetProperty(StrView tag, StrView& value)
       this->Loopback_ = (toupper(value.Get1st()) == 'Y');
       return ConfigParser::Result::Success;
    }
+   if (iequals(tag, "RecvBatch")) {
+      this->RecvBatch_ = StrTo(value, this->RecvBatch_);
+      return ConfigParser::Result::Success;
+   }
+   if (iequals(tag, "RecvTimestamp")) {
+      this->IsRecvTimestamp_ = (toupper(value.Get1st()) == 'Y');
+      return ConfigParser::Result::Success;
+   }
    return base::OpImpl_SetProperty(tag, value);
 }
 
@@ -114,6 +141,11 @@ void DgramBase::OpImpl_Connected(Socket::socket_t) {
    StrView  uidstr = MakeTcpConnectionUID(uidbuf, GetAddrOrNull(this->RemoteAddress_), GetAddrOrNull(this->Config_.AddrBind_));
    this->OpImpl_SetConnected(uidstr.ToString());
 }
+void DgramBase::OpImpl_AppendDeviceInfo(std::string& info) {
+   base::OpImpl_AppendDeviceInfo(info);
+   if (const uint64_t syscalls = this->RecvBatchSyscalls_.load(std::memory_order_relaxed))
+      RevPrintAppendTo(info, "RecvBatch=", this->RecvBatchPackets_.load(std::memory_order_relaxed), '/', syscalls);
+}
 void DgramBase::OpImpl_OnAddrListEmpty() {
    this->AddrList_.resize(1);
    this->AddrList_[0].SetAddrAny(AddressFamily::INET4, 0);
@@ -20,6 +20,15 @@ protected:
    SocketAddress  Interface_;
    int            Loopback_;
    uint8_t        TTL_;
+   /// 是否要求 kernel 提供封包的接收時間(SO_TIMESTAMPNS), 僅在批次接收時有效.
+   bool           IsRecvTimestamp_;
+   /// 批次接收(Linux: recvmmsg()) 一次最多接收的封包數量, 0 or 1 = 不使用批次接收.
+   uint16_t       RecvBatch_;
+
+   /// 批次接收的統計, 在 io thread 更新, 在 OpImpl_AppendDeviceInfo() 顯示.
+   std::atomic<uint64_t>   RecvBatchPackets_{0};
+   std::atomic<uint64_t>   RecvBatchSyscalls_{0};
+   TimeStamp               LastRecvKernelTime_;
 
 protected:
    void OpImpl_Open(std::string cfgstr) override;
@@ -27,6 +36,8 @@ protected:
    bool CreateSocket(Socket& so, const SocketAddress& addr, SocketResult& soRes) override;
    void OpImpl_Connected(Socket::socket_t so);
    void OpImpl_OnAddrListEmpty() override;
+   /// 若有使用批次接收, 則加上 "RecvBatch=packets/syscalls".
+   void OpImpl_AppendDeviceInfo(std::string& info) override;
 
 public:
    DgramBase(SessionSP ses, ManagerSP mgr)
@@ -37,6 +48,20 @@ public:
    const SocketAddress& Interface() const { return this->Interface_; }
    int                  Loopback()  const { return this->Loopback_;  }
    uint8_t              TTL()       const { return this->TTL_;       }
+   uint16_t             RecvBatch() const { return this->RecvBatch_; }
+   bool           IsRecvTimestamp() const { return this->IsRecvTimestamp_; }
+
+   /// 批次接收: 在 io thread 完成一次系統呼叫後, 累計收到的封包數量.
+   void AddRecvBatchCount(unsigned packetCount, TimeStamp kernelTime) {
+      this->RecvBatchPackets_.fetch_add(packetCount, std::memory_order_relaxed);
+      this->RecvBatchSyscalls_.fetch_add(1, std::memory_order_relaxed);
+      this->LastRecvKernelTime_ = kernelTime;
+   }
+   /// 在 OnDevice_Recv() 事件裡面, 可取得此次批次接收的第一個封包, 由 kernel 記錄的接收時間.
+   /// 若沒有設定 "RecvTimestamp=Y", 則傳回 TimeStamp::Null();
+   TimeStamp LastRecvKernelTime() const {
+      return this->LastRecvKernelTime_;
+   }
 };
 fon9_WARN_POP;
 
@@ -3,9 +3,19 @@
 #include "fon9/sys/Config.h"
 #ifdef fon9_POSIX
 #include "fon9/io/FdrDgram.hpp"
+#include "fon9/LatencyHist.hpp"
 
 namespace fon9 { namespace io {
 
+FdrDgramImpl::~FdrDgramImpl() {
+#ifdef __linux__
+   for (FwdBufferNode* node : this->BatchNodes_) {
+      if (node)
+         FreeNode(node);
+   }
+#endif
+}
+
 bool FdrDgramImpl::OpImpl_ConnectTo(const SocketAddress& addr, SocketResult& soRes) {
    this->State_ = State::Connecting;
    if (!addr.IsEmpty()) {
@@ -20,12 +30,115 @@ bool FdrDgramImpl::OpImpl_ConnectTo(const SocketAddress& addr, SocketResult& soR
    return true;
 }
 
+bool FdrDgramImpl::CheckRead(Device& dev, bool (*fnIsRecvBufferAlive)(Device& dev, RecvBuffer& rbuf)) {
+#ifdef __linux__
+   unsigned batchCount = this->Owner_->RecvBatch();
+   if (batchCount > 1 && this->RecvSize_ >= RecvBufferSize::Default)
+      return this->CheckRecvBatch(dev, batchCount > kMaxRecvBatch ? kMaxRecvBatch : batchCount, fnIsRecvBufferAlive);
+#endif
+   return base::CheckRead(dev, fnIsRecvBufferAlive);
+}
+
+#ifdef __linux__
+bool FdrDgramImpl::CheckRecvBatch(Device& dev, unsigned batchCount, bool (*fnIsRecvBufferAlive)(Device& dev, RecvBuffer& rbuf)) {
+   struct mmsghdr msgs[kMaxRecvBatch];
+   struct iovec   iovs[kMaxRecvBatch];
+   // 每個封包的 cmsg 空間, 用來取得 SO_TIMESTAMPNS.
+   using CtrlBuf = char[64];
+   CtrlBuf        ctrls[kMaxRecvBatch];
+   const bool     isRecvTimestamp = this->Owner_->IsRecvTimestamp();
+   size_t         totrd = 0;
+   for (;;) {
+      const size_t expectSize = (this->RecvSize_ == RecvBufferSize::Default
+                                 ? 1024 * 4 // 與 FdrSocket::CheckRead() 相同; 超過的部分會被丟棄(MSG_TRUNC).
+                                 : static_cast<size_t>(this->RecvSize_));
+      for (unsigned L = 0; L < batchCount; ++L) {
+         FwdBufferNode*& node = this->BatchNodes_[L];
+         if (node && node->GetRemainSize() < expectSize) {
+            FreeNode(node);
+            node = nullptr;
+         }
+         if (node == nullptr)
+            node = FwdBufferNode::Alloc(expectSize);
+         fon9_PutIoVectorElement(&iovs[L], node->GetDataEnd(), node->GetRemainSize());
+         memset(&msgs[L], 0, sizeof(msgs[L]));
+         msgs[L].msg_hdr.msg_iov = &iovs[L];
+         msgs[L].msg_hdr.msg_iovlen = 1;
+         if (isRecvTimestamp) {
+            msgs[L].msg_hdr.msg_control = ctrls[L];
+            msgs[L].msg_hdr.msg_controllen = sizeof(ctrls[L]);
+         }
+      }
+      const int pkCount = recvmmsg(this->GetFD(), msgs, batchCount, MSG_DONTWAIT, nullptr);
+      if (fon9_UNLIKELY(pkCount <= 0)) {
+         if (pkCount == 0)
+            break;
+         if (int eno = ErrorCannotRetry(errno)) {
+            this->SocketError("Recv", eno);
+            return false;
+         }
+         return true;
+      }
+      TimeStamp kernelTime;
+      if (isRecvTimestamp) {
+         fon9_GCC_WARN_DISABLE("-Wold-style-cast");
+         for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs[0].msg_hdr); cmsg; cmsg = CMSG_NXTHDR(&msgs[0].msg_hdr, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+               struct timespec ts;
+               memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+               kernelTime = ToTimeStamp(ts);
+               break;
+            }
+         }
+         fon9_GCC_WARN_POP;
+      }
+      for (int L = 0; L < pkCount; ++L) {
+         FwdBufferNode* node = this->BatchNodes_[L];
+         node->SetDataEnd(node->GetDataEnd() + msgs[L].msg_len);
+         totrd += msgs[L].msg_len;
+      }
+      this->Owner_->AddRecvBatchCount(static_cast<unsigned>(pkCount), kernelTime);
+      fon9_LATENCY_SCOPE("Io.RecvReady");
+      DcQueueList&   rxbuf = this->RecvBuffer_.SetBatchReceived(this->BatchNodes_, static_cast<size_t>(pkCount));
+      CheckReadAux   aux{fnIsRecvBufferAlive};
+      DeviceRecvBufferReady(dev, rxbuf, aux);
+
+      // 實際取出的封包數量, 比要求的少 => 資料已全部取出, 所以結束 Recv.
+      if (fon9_LIKELY(static_cast<unsigned>(pkCount) < batchCount))
+         return true;
+      // 避免一次占用太久, 所以先結束.
+      if (totrd > 1024 * 256)
+         return true;
+      // 關閉 readable 偵測: 需要到 op thread 處理 Recv 事件, 所以結束 Recv.
+      if (fon9_UNLIKELY(aux.IsNeedsUpdateFdrEvent_))
+         return true;
+      // Session 決定不要再處理 OnDevice_Recv() 事件, 由 FdrSocket::CheckRead() 拋棄已收到的資料.
+      if (fon9_UNLIKELY(this->RecvSize_ < RecvBufferSize::Default))
+         return base::CheckRead(dev, fnIsRecvBufferAlive);
+   }
+   return true;
+}
+#endif
+
 void FdrDgramImpl::OnFdrEvent_Handling(FdrEventFlag evs) {
    FdrEventProcessor(this, *this->Owner_, evs);
 }
 void FdrDgramImpl::OnFdrEvent_StartSend() {
    this->StartSend(*this->Owner_);
 }
+void FdrDgramImpl::OnFdrEvent_RingReadDone(FwdBufferNode*& node, int res) {
+   RingReadDoneProcessor(this, *this->Owner_, node, res);
+}
+void FdrDgramImpl::OnFdrEvent_RingWriteDone(int res) {
+   RingWriteDoneProcessor(this, *this->Owner_, res);
+}
+size_t FdrDgramImpl::OnFdrEvent_GetRingReadSize() {
+#ifdef __linux__
+   if (this->Owner_->RecvBatch() > 1)
+      return 0;
+#endif
+   return base::OnFdrEvent_GetRingReadSize();
+}
 void FdrDgramImpl::OnFdrSocket_Error(std::string errmsg) {
    this->Owner_->OnSocketError(this, std::move(errmsg));
 }
@@ -12,9 +12,22 @@ struct FdrDgramImpl : public FdrSocketClientImpl {
    using base = FdrSocketClientImpl;
    virtual void OnFdrEvent_Handling(FdrEventFlag evs) override;
    virtual void OnFdrEvent_StartSend() override;
+   virtual void OnFdrEvent_RingReadDone(FwdBufferNode*& node, int res) override;
+   virtual void OnFdrEvent_RingWriteDone(int res) override;
+   /// 若有設定 "RecvBatch=n", 則使用 Readable 事件 + recvmmsg(), 不使用完成式讀取.
+   virtual size_t OnFdrEvent_GetRingReadSize() override;
    virtual void OnFdrSocket_Error(std::string errmsg) override;
    virtual void SocketError(StrView fnName, int eno) override;
 
+#ifdef __linux__
+   /// 批次接收(recvmmsg) 一次最多的封包數量.
+   enum : unsigned { kMaxRecvBatch = 64 };
+   /// 批次接收使用的緩衝區, 沒用到的(未收到資料)保留到下次使用.
+   FwdBufferNode* BatchNodes_[kMaxRecvBatch];
+   /// 使用 recvmmsg() 一次取出多個封包, 然後在一次 OnDevice_Recv() 事件提供這批封包.
+   bool CheckRecvBatch(Device& dev, unsigned batchCount, bool (*fnIsRecvBufferAlive)(Device& dev, RecvBuffer& rbuf));
+#endif
+
 public:
    using OwnerDevice = DgramT<FdrServiceSP, FdrDgramImpl>;
    using OwnerDeviceSP = intrusive_ptr<OwnerDevice>;
@@ -23,8 +36,15 @@ public:
    FdrDgramImpl(OwnerDevice* owner, Socket&& so, SocketResult&)
       : base{*owner->IoService_, std::move(so)}
       , Owner_{owner} {
+   #ifdef __linux__
+      memset(this->BatchNodes_, 0, sizeof(this->BatchNodes_));
+   #endif
    }
+   ~FdrDgramImpl();
    bool OpImpl_ConnectTo(const SocketAddress& addr, SocketResult& soRes);
+
+   /// 若有設定 "RecvBatch=n" 則使用批次接收, 否則使用 FdrSocket::CheckRead();
+   bool CheckRead(Device& dev, bool (*fnIsRecvBufferAlive)(Device& dev, RecvBuffer& rbuf));
 };
 
 //--------------------------------------------------------------------------//
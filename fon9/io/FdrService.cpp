@@ -4,6 +4,7 @@
 #ifdef fon9_POSIX
 #include "fon9/io/FdrService.hpp"
 #include "fon9/Log.hpp"
+#include <sys/socket.h>
 
 namespace fon9 { namespace io {
 
@@ -19,6 +20,13 @@ FdrService::~FdrService() {
 FdrThreadSP FdrService::AllocFdrThread(Fdr::fdr_t fd) {
    return this->FdrThreads_[static_cast<size_t>(fd) % this->FdrThreads_.size()];
 }
+void FdrService::GetStInfo(RevBuffer& rbuf) const {
+   for (size_t L = this->FdrThreads_.size(); L > 0; --L) {
+      RevPutChar(rbuf, '\n');
+      this->FdrThreads_[L - 1]->GetStInfo(rbuf);
+      RevPrint(rbuf, "FdrThread.", L, '|');
+   }
+}
 
 //--------------------------------------------------------------------------//
 
@@ -29,24 +37,39 @@ void intrusive_ptr_deleter(const FdrThread* p) {
       delete p;
 }
 
+FdrThread::PendingReqs::~PendingReqs() {
+   this->ConsumeAll([](FdrEventHandlerSP&) {});
+}
 FdrThread::~FdrThread() {
 }
-void FdrThread::CancelReqs(PendingReqsImpl reqs) {
-   for (FdrEventHandlerSP& r : reqs)
+void FdrThread::GetStInfo(RevBuffer& rbuf) const {
+   const uint64_t loops = this->LoopStat_.Loops_.load(std::memory_order_relaxed);
+   const uint64_t idles = this->LoopStat_.Idles_.load(std::memory_order_relaxed);
+   const uint64_t wakeups = this->LoopStat_.Wakeups_.load(std::memory_order_relaxed);
+   const uint64_t events = this->LoopStat_.Events_.load(std::memory_order_relaxed);
+   using Ratio = Decimal<int64_t, 2>;
+   RevPrint(rbuf, "loops=", loops,
+            "|idle=", Ratio(loops ? static_cast<double>(idles) * 100 / static_cast<double>(loops) : 0.0), '%',
+            "|evPerWakeup=", Ratio(wakeups ? static_cast<double>(events) / static_cast<double>(wakeups) : 0.0));
+}
+void FdrThread::CancelReqs(PendingReqs& reqs) {
+   reqs.ConsumeAll([](FdrEventHandlerSP& r) {
       r->OnFdrEvent_Handling(FdrEventFlag::OperationCanceled);
+   });
 }
 void FdrThread::ThrRun(ServiceThreadArgs args) {
    args.OnThrRunBegin("FdrThread");
    this->ThreadId_ = ThisThread_.ThreadId_;
+   this->BusyPollUS_ = args.BusyPollUS_;
    this->ThrRunImpl(args);
    if (this->use_count() != 0) {
       // select(), poll(), epoll_wait()... error.
       fon9_LOG_FATAL("FdrThread.ThrRun.CancelMode|name=", args.Name_);
       while (this->use_count() > 0) {
          // 拒絕全部的要求, 直到沒有任何人擁有 this 的 FdrThreadSP 為止.
-         this->CancelReqs(MoveOutPendingImpl(this->PendingSends_));
-         this->CancelReqs(MoveOutPendingImpl(this->PendingUpdates_));
-         MoveOutPendingImpl(this->PendingRemoves_);
+         CancelReqs(this->PendingSends_);
+         CancelReqs(this->PendingUpdates_);
+         this->PendingRemoves_.ConsumeAll([](FdrEventHandlerSP&) {});
          std::this_thread::yield();
       }
    }
@@ -54,17 +77,29 @@ void FdrThread::ThrRun(ServiceThreadArgs args) {
    fon9_LOG_ThrRun("FdrThread.ThrRun.End|name=", args.Name_);
    delete this;
 }
+void FdrThread::SetSockBusyPoll(FdrEventHandler* hdr) {
+#ifdef SO_BUSY_POLL
+   if (this->BusyPollUS_ <= 0)
+      return;
+   int busyPoll = static_cast<int>(this->BusyPollUS_);
+   if (setsockopt(hdr->GetFD(), SOL_SOCKET, SO_BUSY_POLL, &busyPoll, sizeof(busyPoll)) != 0) {
+      int eno = errno;
+      if (eno != ENOTSOCK) { // 不是 socket 的 fd(e.g. FileIO), 不用設定 SO_BUSY_POLL.
+         fon9_LOG_WARN("FdrThread.SO_BUSY_POLL|fd=", hdr->GetFD(), "|err=", GetSysErrC(eno));
+         this->BusyPollUS_ = 0;
+      }
+   }
+#else
+   (void)hdr;
+#endif
+}
 void FdrThread::ProcessPendingSends() {
-   PendingReqsImpl reqs = this->MoveOutPendingImpl(this->PendingSends_);
-   for (FdrEventHandlerSP& sender : reqs)
+   this->PendingSends_.ConsumeAll([](FdrEventHandlerSP& sender) {
       sender->OnFdrEvent_StartSend();
+   });
 }
-void FdrThread::PushToPendingReqs(PendingReqs& reqs, FdrEventHandlerSP&& handler) {
-   {
-      PendingReqs::Locker lk{reqs};
-      lk->emplace_back(std::move(handler));
-   }
-   this->WakeupThread();
+bool FdrThread::StartRingWrite(FdrEventHandler*, const struct iovec*, size_t) {
+   return false;
 }
 void FdrThread::WakeupThread() {
    if (this->WakeupRequests_.fetch_add(1, std::memory_order_relaxed) == 0)
@@ -76,6 +111,13 @@ void FdrThread::WakeupThread() {
 
 FdrEventHandler::~FdrEventHandler() {
 }
+size_t FdrEventHandler::OnFdrEvent_GetRingReadSize() {
+   return 0;
+}
+void FdrEventHandler::OnFdrEvent_RingReadDone(FwdBufferNode*&, int) {
+}
+void FdrEventHandler::OnFdrEvent_RingWriteDone(int) {
+}
 
 } } // namespaces
 #endif//fon9_POSIX
@@ -11,7 +11,11 @@
 #include <thread>
 #include <vector>
 
-namespace fon9 { namespace io {
+struct iovec;
+
+namespace fon9 {
+class FwdBufferNode;
+namespace io {
 
 class FdrService;
 class FdrEventHandler;
@@ -42,12 +46,63 @@ fon9_ENABLE_ENUM_BITWISE_OP(FdrEventFlag);
 /// - 在 FdrEventHandler 建構時, 由 FdrService 決定該 handler 由哪個 FdrThread 服務
 /// - 只有在全部的 FdrEventHandler 死亡後, 才會結束 thread.
 class FdrThread : public intrusive_ref_counter<FdrThread> {
+public:
+   /// fdr thread 的執行統計.
+   /// - 只在 fdr thread 更新, 其他 thread 讀取時可能略有落差.
+   struct LoopStat {
+      /// 進入事件偵測(e.g. epoll_wait())的次數.
+      std::atomic<uint64_t>   Loops_{0};
+      /// 事件偵測沒有任何事件的次數.
+      std::atomic<uint64_t>   Idles_{0};
+      /// 事件偵測有事件的次數.
+      std::atomic<uint64_t>   Wakeups_{0};
+      /// 累計的事件數量.
+      std::atomic<uint64_t>   Events_{0};
+
+      /// 只有 fdr thread 會更新, 所以不用 fetch_add();
+      static void Add(std::atomic<uint64_t>& counter, uint64_t n) {
+         counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+      }
+   };
+   /// 輸出格式: "loops=n|idle=percent%|evPerWakeup=n"
+   void GetStInfo(RevBuffer& rbuf) const;
+
 protected:
-   using PendingReqsImpl = std::vector<FdrEventHandlerSP>;
-   using PendingReqs = MustLock<PendingReqsImpl>;
-   PendingReqs       PendingUpdates_;
-   PendingReqs       PendingSends_;
-   PendingReqs       PendingRemoves_;
+   LoopStat          LoopStat_;
+
+   enum PendingKind : uint8_t {
+      PendingKind_Update,
+      PendingKind_Send,
+      PendingKind_Remove,
+      PendingKind_Count,
+   };
+   /// 等候 fdr thread 處理的要求.
+   /// - lock-free 的 multi-producer / single-consumer queue.
+   /// - 使用 FdrEventHandler 內部的欄位串接, 加入時不用分配記憶體.
+   /// - 在 fdr thread 取出之前, 同一個 handler 重複的要求只會保留一個.
+   class PendingReqs {
+      fon9_NON_COPY_NON_MOVE(PendingReqs);
+      std::atomic<FdrEventHandler*> Head_{nullptr};
+   public:
+      const PendingKind Kind_;
+      PendingReqs(PendingKind kind) : Kind_{kind} {
+      }
+      /// 釋放尚未處理的要求.
+      ~PendingReqs();
+
+      /// \retval true  handler 已加入, 並增加 handler 的參考計數.
+      /// \retval false handler 已在等候處理, 此次要求被合併.
+      bool Push(FdrEventHandler* handler);
+
+      /// 依照加入的順序取出全部的要求, 並逐一呼叫 fn(FdrEventHandlerSP&);
+      /// - 僅能在 consumer(fdr thread) 呼叫.
+      /// - 在呼叫 fn() 之前, 就已允許 handler 再次加入.
+      template <class FnHandler>
+      void ConsumeAll(FnHandler&& fn);
+   };
+   PendingReqs       PendingUpdates_{PendingKind_Update};
+   PendingReqs       PendingSends_{PendingKind_Send};
+   PendingReqs       PendingRemoves_{PendingKind_Remove};
    FdrNotify         WakeupFdr_;
    ThreadId::IdType  ThreadId_;
    std::atomic_uint_fast32_t  WakeupRequests_{0};
@@ -60,14 +115,19 @@ protected:
 
    static void OnFdrEvent_Emit(FdrEventFlag evs, FdrEventHandler* handler);
    static void SetFdrEventHandlerBookmark(FdrEventHandler* handler, uint64_t bookmark);
-
-   static PendingReqsImpl MoveOutPendingImpl(PendingReqs& impl) {
-      PendingReqs::Locker lk{impl};
-      return std::move(*lk);
-   }
+   /// 提供給支援完成式讀寫(e.g. io_uring)的衍生者使用.
+   static size_t GetRingReadSize(FdrEventHandler* handler);
+   static void OnFdrEvent_RingReadDone(FdrEventHandler* handler, FwdBufferNode*& node, int res);
+   static void OnFdrEvent_RingWriteDone(FdrEventHandler* handler, int res);
 
    void ProcessPendingSends();
 
+   /// 在 ThrRun() 開始時, 從 ServiceThreadArgs 取得.
+   /// 若設定 SO_BUSY_POLL 失敗(e.g. 權限不足), 則設為 0, 不再嘗試.
+   uint32_t BusyPollUS_{0};
+   /// 若 this->BusyPollUS_ > 0, 則在 hdr 加入 fdr thread 時呼叫, 設定 SO_BUSY_POLL.
+   void SetSockBusyPoll(FdrEventHandler* hdr);
+
 public:
    virtual ~FdrThread();
 
@@ -89,20 +149,27 @@ private:
    /// \endcode
    virtual void ThrRunImpl(const ServiceThreadArgs& args) = 0;
    void ThrRun(ServiceThreadArgs args);
-   void CancelReqs(PendingReqsImpl);
+   static void CancelReqs(PendingReqs& reqs);
 
    friend class FdrEventHandler;
    void WakeupThread();
-   void PushToPendingReqs(PendingReqs& reqs, FdrEventHandlerSP&& handler);
-   void UpdateFdrEvent(FdrEventHandlerSP handler) {
-      this->PushToPendingReqs(this->PendingUpdates_, std::move(handler));
+   /// 只有在 handler 首次加入 reqs 時, 才需要喚醒 fdr thread;
+   /// 且 WakeupThread() 只有在上次 ClearWakeup() 之後的第一次, 才會寫入 WakeupFdr_.
+   void PushToPendingReqs(PendingReqs& reqs, FdrEventHandler* handler) {
+      if (reqs.Push(handler))
+         this->WakeupThread();
    }
-   void RemoveFdrEvent(FdrEventHandlerSP handler) {
-      this->PushToPendingReqs(this->PendingRemoves_, std::move(handler));
+   void UpdateFdrEvent(FdrEventHandler* handler) {
+      this->PushToPendingReqs(this->PendingUpdates_, handler);
    }
-   void StartSendInFdrThread(FdrEventHandlerSP handler) {
-      this->PushToPendingReqs(this->PendingSends_, std::move(handler));
+   void RemoveFdrEvent(FdrEventHandler* handler) {
+      this->PushToPendingReqs(this->PendingRemoves_, handler);
    }
+   void StartSendInFdrThread(FdrEventHandler* handler) {
+      this->PushToPendingReqs(this->PendingSends_, handler);
+   }
+   /// 預設不支援完成式寫入, 傳回 false.
+   virtual bool StartRingWrite(FdrEventHandler* handler, const struct iovec* iov, size_t count);
 };
 using FdrThreadSP = intrusive_ptr<FdrThread>;
 extern void intrusive_ptr_deleter(const FdrThread* p);
@@ -123,6 +190,9 @@ public:
    /// 預設使用 [fd % thrCount] 決定使用哪個 fdr thread.
    virtual FdrThreadSP AllocFdrThread(Fdr::fdr_t fd);
 
+   /// 每個 fdr thread 一行: "FdrThread.index|loops=n|idle=percent%|evPerWakeup=n\n"
+   void GetStInfo(RevBuffer& rbuf) const;
+
 private:
    const FdrThreads  FdrThreads_;
 };
@@ -130,6 +200,7 @@ using FdrServiceSP = intrusive_ptr<FdrService>;
 
 /// \ingroup io
 /// 各個 OS 有它自己的預設 FdrService: 例如 Linux = FdrServiceEpoll.
+/// - Linux: 若 ioArgs.Engine_ == IoEngine::Uring, 則優先使用 FdrServiceUring, 若無法建立, 則改用 FdrServiceEpoll.
 fon9_API FdrServiceSP MakeDefaultFdrService(const IoServiceArgs& ioArgs, const std::string& thrName, Result2& err);
 
 //--------------------------------------------------------------------------//
@@ -177,6 +248,14 @@ public:
    bool InFdrThread() const {
       return this->FdrThread_->IsThisThread();
    }
+   /// 若 fdr thread 支援完成式寫入(e.g. io_uring WRITEV), 且現在就在 fdr thread, 則將 iov 交給 fdr thread 送出.
+   /// - 送出的結果透過 OnFdrEvent_RingWriteDone() 通知, 在此之前 iov 指向的資料必須保持有效,
+   ///   且不可再次呼叫 StartRingWrite().
+   /// - count 可能超過 fdr thread 一次可送出的數量, 此時只會送出前面的部分.
+   /// \retval false 不支援完成式寫入, 由呼叫端自行 writev().
+   bool StartRingWrite(const struct iovec* iov, size_t count) {
+      return this->FdrThread_->StartRingWrite(this, iov, count);
+   }
    uint64_t GetFdrEventHandlerBookmark() const {
       return this->FdrThreadBookmark_;
    }
@@ -191,10 +270,14 @@ public:
 
 private:
    friend class FdrThread;
+   friend class FdrThread::PendingReqs;
    // 在建構時就決定了要使用哪個 FdrThread & 處理哪個 fd 的事件.
    const FdrThreadSP FdrThread_;
    const FdrAuto     Fdr_;
    uint64_t          FdrThreadBookmark_{0};
+   /// 用於 FdrThread::PendingReqs 的串接, 及是否已在等候處理的旗標(bit = 1 << PendingKind).
+   FdrEventHandler*     PendingNext_[FdrThread::PendingKind_Count];
+   std::atomic<uint8_t> PendingFlags_{0};
 
    /// 可能同時有多種事件通知.
    /// 只會在 fdr thread 裡面呼叫.
@@ -203,6 +286,18 @@ private:
    /// 透過 StartSendInFdrThread() 啟動在 fdr thread 的傳送.
    virtual void OnFdrEvent_StartSend() = 0;
 
+   /// 若 fdr thread 支援完成式讀取(e.g. io_uring READV), 在需要 Readable 時, 透過這裡取得讀取緩衝區的大小.
+   /// - 傳回 0(預設) 表示不使用完成式讀取, 改用 Readable 事件通知, 由 OnFdrEvent_Handling() 自行讀取.
+   /// - 只會在 fdr thread 裡面呼叫.
+   virtual size_t OnFdrEvent_GetRingReadSize();
+   /// 完成式讀取的結果, 只會在 fdr thread 裡面呼叫.
+   /// - res > 0: node 已填入 res bytes; 若取走 node, 則必須設定 node = nullptr; 沒取走的資料會被拋棄.
+   /// - res == 0: 對方已結束連線; res < 0: -errno.
+   virtual void OnFdrEvent_RingReadDone(FwdBufferNode*& node, int res);
+   /// StartRingWrite() 的結果, 只會在 fdr thread 裡面呼叫.
+   /// - res >= 0: 已送出的資料量; res < 0: -errno.
+   virtual void OnFdrEvent_RingWriteDone(int res);
+
    virtual void OnFdrEvent_AddRef() = 0;
    virtual void OnFdrEvent_ReleaseRef() = 0;
 
@@ -222,6 +317,49 @@ inline void FdrThread::OnFdrEvent_Emit(FdrEventFlag evs, FdrEventHandler* handle
 inline void FdrThread::SetFdrEventHandlerBookmark(FdrEventHandler* handler, uint64_t bookmark) {
    handler->FdrThreadBookmark_ = bookmark;
 }
+inline size_t FdrThread::GetRingReadSize(FdrEventHandler* handler) {
+   return handler->OnFdrEvent_GetRingReadSize();
+}
+inline void FdrThread::OnFdrEvent_RingReadDone(FdrEventHandler* handler, FwdBufferNode*& node, int res) {
+   handler->OnFdrEvent_RingReadDone(node, res);
+}
+inline void FdrThread::OnFdrEvent_RingWriteDone(FdrEventHandler* handler, int res) {
+   handler->OnFdrEvent_RingWriteDone(res);
+}
+
+inline bool FdrThread::PendingReqs::Push(FdrEventHandler* handler) {
+   const uint8_t bit = static_cast<uint8_t>(1u << this->Kind_);
+   if (handler->PendingFlags_.fetch_or(bit, std::memory_order_acq_rel) & bit)
+      return false;
+   intrusive_ptr_add_ref(handler);
+   FdrEventHandler* head = this->Head_.load(std::memory_order_relaxed);
+   do {
+      handler->PendingNext_[this->Kind_] = head;
+   } while (!this->Head_.compare_exchange_weak(head, handler, std::memory_order_release, std::memory_order_relaxed));
+   return true;
+}
+template <class FnHandler>
+void FdrThread::PendingReqs::ConsumeAll(FnHandler&& fn) {
+   FdrEventHandler* curr = this->Head_.exchange(nullptr, std::memory_order_acq_rel);
+   if (curr == nullptr)
+      return;
+   // Head_ 為最後加入的, 所以先反轉, 才能依照加入的順序處理.
+   FdrEventHandler* fifo = nullptr;
+   do {
+      FdrEventHandler* next = curr->PendingNext_[this->Kind_];
+      curr->PendingNext_[this->Kind_] = fifo;
+      fifo = curr;
+      curr = next;
+   } while (curr);
+   const uint8_t bit = static_cast<uint8_t>(1u << this->Kind_);
+   do {
+      FdrEventHandlerSP handler{fifo, false}; // 接手在 Push() 時增加的參考計數.
+      // 必須先取出 next, 因為清除旗標後, 其他 thread 可能會再次 Push(handler), 改變 PendingNext_[];
+      fifo = fifo->PendingNext_[this->Kind_];
+      handler->PendingFlags_.fetch_and(static_cast<uint8_t>(~bit), std::memory_order_acq_rel);
+      fn(handler);
+   } while (fifo);
+}
 
 } } // namespaces
 #endif//__fon9_io_FdrService_hpp__
@@ -2,12 +2,19 @@
 /// \author fonwinz@gmail.com
 #ifdef __linux__
 #include "fon9/io/FdrServiceEpoll.hpp"
+#include "fon9/io/FdrServiceUring.hpp"
 #include "fon9/Log.hpp"
 #include <sys/epoll.h>
 
 namespace fon9 { namespace io {
 
 fon9_API FdrServiceSP MakeDefaultFdrService(const IoServiceArgs& ioArgs, const std::string& thrName, Result2& err) {
+   if (ioArgs.Engine_ == IoEngine::Uring) {
+      if (FdrServiceSP retval = FdrServiceUring::MakeService(ioArgs, thrName, err))
+         return retval;
+      fon9_LOG_WARN("MakeDefaultFdrService|name=", thrName, "|engine=uring|err=", err, "|info=Use epoll.");
+      err = Result2{};
+   }
    return FdrServiceEpoll::MakeService(ioArgs, thrName, err);
 }
 FdrServiceSP FdrServiceEpoll::MakeService(const IoServiceArgs& ioArgs, const std::string& thrName, MakeResult& err) {
@@ -59,6 +66,8 @@ void FdrThreadEpoll::ThrRunImpl(const ServiceThreadArgs& args) {
    EvHandlers  evHandlers{args.Capacity_};
    Fdr::fdr_t  epFdr = this->FdrEpoll_.GetFD();
    const int   kEpollWaitMS = (IsBlockWait(args.HowWait_) ? -1 : 0);
+   // 非 Block 模式, 連續 idleCount 次沒有事件, 超過 args.IdleSpin_ 之後, 才開始退讓.
+   uint32_t    idleCount = 0;
    while (this->use_count() > 0) {
       // 再次進入 epoll_wait() 之前, 必須先將 Pending Removes, Updates 處理完,
       // 因為: 在 OnFdrEvent_Emit() 裡面關閉 readable, writable 偵測, 必須確實執行.
@@ -75,7 +84,11 @@ void FdrThreadEpoll::ThrRunImpl(const ServiceThreadArgs& args) {
       }
       struct epoll_event* pEvBeg = &*epEvents.begin();
       int epRes = epoll_wait(epFdr, pEvBeg, static_cast<int>(epEvents.size()), msWait);
+      LoopStat::Add(this->LoopStat_.Loops_, 1);
       if (fon9_LIKELY(epRes > 0)) {
+         idleCount = 0;
+         LoopStat::Add(this->LoopStat_.Wakeups_, 1);
+         LoopStat::Add(this->LoopStat_.Events_, static_cast<uint64_t>(epRes));
          for (int L = 0; L < epRes; ++L, ++pEvBeg) {
             if (FdrEventHandler* hdr = static_cast<FdrEventHandler*>(pEvBeg->data.ptr)) {
                if (fon9_LIKELY(hdr->GetFdrEventHandlerBookmark() > 0)) {
@@ -102,8 +115,8 @@ void FdrThreadEpoll::ThrRunImpl(const ServiceThreadArgs& args) {
          }
       }
       else if (fon9_LIKELY(epRes == 0)) { // 如果 !Block, 則 epRes==0 是常態!
-         if (args.HowWait_ == HowWait::Yield)
-            std::this_thread::yield();
+         LoopStat::Add(this->LoopStat_.Idles_, 1);
+         args.OnIdle(idleCount);
       }
       else if (epRes < 0) {
          if (int eno = ErrorCannotRetry(errno))
@@ -116,12 +129,11 @@ void FdrThreadEpoll::ProcessPendings(Fdr::fdr_t epFdr, EvHandlers& evHandlers) {
    this->ProcessPendingSends();
 
    struct epoll_event evc;
-   PendingReqsImpl reqs = this->MoveOutPendingImpl(this->PendingRemoves_);
-   for (FdrEventHandlerSP& spRemove : reqs) {
+   this->PendingRemoves_.ConsumeAll([this, epFdr, &evHandlers, &evc](FdrEventHandlerSP& spRemove) {
       FdrEventHandler* hdr = spRemove.get();
       auto idx1 = hdr->GetFdrEventHandlerBookmark();
       if (fon9_UNLIKELY(idx1 <= 0))
-         continue;
+         return;
       if (!evHandlers.RemoveObj(idx1 - 1, hdr))
          fon9_LOG_ERROR("FdrServiceEpoll.Remove|fd=", hdr->GetFD(), "|idx=", idx1, "|hdr=", ToPtr{hdr}, "|err=Not found");
       if (fon9_UNLIKELY(epoll_ctl(epFdr, EPOLL_CTL_DEL, hdr->GetFD(), &evc) < 0)) {
@@ -130,9 +142,8 @@ void FdrThreadEpoll::ProcessPendings(Fdr::fdr_t epFdr, EvHandlers& evHandlers) {
       }
       // fon9_LOG_TRACE("FdrServiceEpoll.Remove|fd=", hdr->GetFD(), "|idx=", idx1, "|hdr=", ToPtr{hdr});
       this->SetFdrEventHandlerBookmark(hdr, 0);
-   }
-   reqs = this->MoveOutPendingImpl(this->PendingUpdates_);
-   for (FdrEventHandlerSP& sp : reqs) {
+   });
+   this->PendingUpdates_.ConsumeAll([this, epFdr, &evHandlers, &evc](FdrEventHandlerSP& sp) {
       FdrEventHandler* hdr = sp.get();
       auto idx1 = hdr->GetFdrEventHandlerBookmark();
       int  op;
@@ -140,19 +151,20 @@ void FdrThreadEpoll::ProcessPendings(Fdr::fdr_t epFdr, EvHandlers& evHandlers) {
       if (fon9_LIKELY(idx1 > 0)) {
          EvHandler*  pEvObj = evHandlers.GetObjPtr(idx1 - 1);
          if (fon9_UNLIKELY(pEvObj == nullptr))
-            continue;
+            return;
          if (pEvObj->get() != hdr || pEvObj->Events_ == evs)
-            continue;
+            return;
          pEvObj->Events_ = evs;
          op = EPOLL_CTL_MOD;
       }
       else {
          if (fon9_UNLIKELY(evs == FdrEventFlag::None))
-            continue;
+            return;
          EvHandler evh{hdr};
          evh.Events_ = evs;
          this->SetFdrEventHandlerBookmark(hdr, idx1 = evHandlers.Add(evh) + 1);
          op = EPOLL_CTL_ADD;
+         this->SetSockBusyPoll(hdr);
       }
       // EPOLLET 有其他問題? 莫名的斷線: 收到 events=0x2019? 0x19 = EPOLLHUP(0x10) + EPOLLERR(0x08) + EPOLLIN(0x01)
       evc.events = IsEnumContains(evs, FdrEventFlag::Readable)
@@ -173,7 +185,7 @@ void FdrThreadEpoll::ProcessPendings(Fdr::fdr_t epFdr, EvHandlers& evHandlers) {
                         "|evs=", evs,
                         "|err=", GetSysErrC(eno));
       }
-   }
+   });
 }
 
 } } // namespaces
@@ -0,0 +1,527 @@
+﻿/// \file fon9/io/FdrServiceUring.cpp
+/// \author fonwinz@gmail.com
+#ifdef __linux__
+#include "fon9/io/FdrServiceUring.hpp"
+#include "fon9/Log.hpp"
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define fon9_HAS_IO_URING
+#endif
+
+namespace fon9 { namespace io {
+
+#ifndef fon9_HAS_IO_URING
+FdrServiceSP FdrServiceUring::MakeService(const IoServiceArgs& ioArgs, const std::string& thrName, MakeResult& err) {
+   (void)ioArgs; (void)thrName;
+   err = MakeResult{"io_uring", std::errc::function_not_supported};
+   return FdrServiceSP{};
+}
+#else
+FdrServiceSP FdrServiceUring::MakeService(const IoServiceArgs& ioArgs, const std::string& thrName, MakeResult& err) {
+   size_t thrCount = ioArgs.ThreadCount_;
+   if (thrCount <= 0)
+      thrCount = 1;
+   // 每個 handler 異動時, 通常使用 2 個 SQE(POLL_REMOVE + POLL_ADD, 或 READV + WRITEV);
+   // 若 SQ 已滿, GetSqe() 會先送出已填入的 SQE, 所以這裡只是預估值.
+   unsigned entries = static_cast<unsigned>(ioArgs.Capacity_ * 2);
+   if (entries < 256)
+      entries = 256;
+   else if (entries > 4096)
+      entries = 4096;
+   FdrService::FdrThreads thrs(thrCount);
+   for (size_t L = 0; L < thrCount; ++L) {
+      thrs[L].reset(new FdrThreadUring{err, entries});
+      if (err.IsError())
+         return FdrServiceSP{};
+   }
+   thrs.shrink_to_fit();
+   return FdrServiceSP{new FdrService{std::move(thrs), ioArgs, thrName + ".uring"}};
+}
+
+//--------------------------------------------------------------------------//
+
+// 喚醒 fdr thread 的 POLL_ADD.
+static constexpr uint64_t  kUserData_Wakeup = ~static_cast<uint64_t>(0);
+// 不需要處理的 CQE, 例: POLL_REMOVE 的結果.
+static constexpr uint64_t  kUserData_Ignore = kUserData_Wakeup - 1;
+
+// user_data = (gen << 32) | (RingOp << 28) | idx;
+// READV, WRITEV 的 gen 固定為 0: 尚未完成之前, 不會釋放 idx 的位置, 所以不用 gen 排除.
+enum RingOp : uint32_t {
+   RingOp_Poll = 0,
+   RingOp_Read = 1,
+   RingOp_Write = 2,
+};
+static constexpr uint32_t  kUserData_IdxMask = 0x0fffffff;
+static inline uint64_t MakeUserData(uint32_t idx, uint32_t gen, RingOp op = RingOp_Poll) {
+   return (static_cast<uint64_t>(gen) << 32) | (static_cast<uint64_t>(op) << 28) | idx;
+}
+template <class T>
+static inline T* RingField(void* ringPtr, uint32_t offset) {
+   return reinterpret_cast<T*>(reinterpret_cast<char*>(ringPtr) + offset);
+}
+
+FdrThreadUring::FdrThreadUring(FdrServiceUring::MakeResult& res, unsigned entries) {
+   using Result = FdrServiceUring::MakeResult;
+   struct io_uring_params params;
+   ZeroStruct(params);
+   this->FdrRing_.SetFD(static_cast<Fdr::fdr_t>(syscall(__NR_io_uring_setup, entries, &params)));
+   if (!this->FdrRing_.IsReadyFD()) {
+      res = Result{"io_uring_setup", GetSysErrC()};
+      return;
+   }
+   // 沒有 IORING_FEAT_NODROP: 若 CQ 滿了, 則事件會遺失; 因為已註冊的 handler 數量可能超過 CQ 容量, 所以不支援.
+   if ((params.features & IORING_FEAT_NODROP) == 0) {
+      res = Result{"io_uring.FEAT_NODROP", std::errc::function_not_supported};
+      return;
+   }
+   // 沒有 IORING_FEAT_FAST_POLL: 尚未就緒的 READV/WRITEV 會占用 kernel 的 worker thread, 所以只使用 POLL_ADD.
+   this->IsRingIo_ = ((params.features & IORING_FEAT_FAST_POLL) != 0);
+   const Fdr::fdr_t ringFd = this->FdrRing_.GetFD();
+   this->SqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+   this->CqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+   const bool isSingleMmap = ((params.features & IORING_FEAT_SINGLE_MMAP) != 0);
+   if (isSingleMmap) {
+      if (this->SqRingSize_ < this->CqRingSize_)
+         this->SqRingSize_ = this->CqRingSize_;
+      this->CqRingSize_ = 0;
+   }
+   this->SqRingPtr_ = mmap(nullptr, this->SqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+   if (this->SqRingPtr_ == MAP_FAILED) {
+      this->SqRingPtr_ = nullptr;
+      res = Result{"io_uring.mmap(SQ)", GetSysErrC()};
+      return;
+   }
+   if (isSingleMmap)
+      this->CqRingPtr_ = this->SqRingPtr_;
+   else {
+      this->CqRingPtr_ = mmap(nullptr, this->CqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+      if (this->CqRingPtr_ == MAP_FAILED) {
+         this->CqRingPtr_ = nullptr;
+         res = Result{"io_uring.mmap(CQ)", GetSysErrC()};
+         return;
+      }
+   }
+   this->SqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+   void* sqes = mmap(nullptr, this->SqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+   if (sqes == MAP_FAILED) {
+      res = Result{"io_uring.mmap(SQEs)", GetSysErrC()};
+      return;
+   }
+   this->Sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+   this->SqHead_ = RingField<unsigned>(this->SqRingPtr_, params.sq_off.head);
+   this->SqTail_ = RingField<unsigned>(this->SqRingPtr_, params.sq_off.tail);
+   this->SqArray_ = RingField<unsigned>(this->SqRingPtr_, params.sq_off.array);
+   this->SqMask_ = *RingField<unsigned>(this->SqRingPtr_, params.sq_off.ring_mask);
+   this->SqEntries_ = params.sq_entries;
+   this->SqTailLocal_ = *this->SqTail_;
+   this->CqHead_ = RingField<unsigned>(this->CqRingPtr_, params.cq_off.head);
+   this->CqTail_ = RingField<unsigned>(this->CqRingPtr_, params.cq_off.tail);
+   this->CqMask_ = *RingField<unsigned>(this->CqRingPtr_, params.cq_off.ring_mask);
+   this->Cqes_ = RingField<struct io_uring_cqe>(this->CqRingPtr_, params.cq_off.cqes);
+
+   FdrNotify::Result resEvFd = this->WakeupFdr_.Open();
+   if (resEvFd.IsError()) {
+      res = Result{"WakeupFdr.Open", resEvFd.GetError()};
+      return;
+   }
+}
+FdrThreadUring::~FdrThreadUring() {
+   if (this->Sqes_)
+      munmap(this->Sqes_, this->SqesSize_);
+   if (this->CqRingPtr_ && this->CqRingPtr_ != this->SqRingPtr_)
+      munmap(this->CqRingPtr_, this->CqRingSize_);
+   if (this->SqRingPtr_)
+      munmap(this->SqRingPtr_, this->SqRingSize_);
+}
+
+//--------------------------------------------------------------------------//
+
+struct io_uring_sqe* FdrThreadUring::GetSqe() {
+   // SQ 已滿: 先送出已填入的 SQE.
+   while (this->SqTailLocal_ - __atomic_load_n(this->SqHead_, __ATOMIC_ACQUIRE) >= this->SqEntries_) {
+      if (int eno = this->Enter(0)) {
+         if (ErrorCannotRetry(-eno) && -eno != EBUSY) {
+            fon9_LOG_FATAL("FdrThreadUring.GetSqe|fn=io_uring_enter|err=", GetSysErrC(-eno));
+            return nullptr;
+         }
+      }
+   }
+   const unsigned idx = this->SqTailLocal_ & this->SqMask_;
+   struct io_uring_sqe* sqe = this->Sqes_ + idx;
+   ZeroStruct(*sqe);
+   this->SqArray_[idx] = idx;
+   ++this->SqTailLocal_;
+   return sqe;
+}
+bool FdrThreadUring::IsCqEmpty() const {
+   return *this->CqHead_ == __atomic_load_n(this->CqTail_, __ATOMIC_ACQUIRE);
+}
+int FdrThreadUring::Enter(unsigned minComplete) {
+   __atomic_store_n(this->SqTail_, this->SqTailLocal_, __ATOMIC_RELEASE);
+   const unsigned toSubmit = this->SqTailLocal_ - __atomic_load_n(this->SqHead_, __ATOMIC_ACQUIRE);
+   if (toSubmit == 0 && minComplete == 0 && !this->IsCqEmpty())
+      return 0;
+   if (syscall(__NR_io_uring_enter, this->FdrRing_.GetFD(), toSubmit, minComplete, IORING_ENTER_GETEVENTS, nullptr, 0) < 0)
+      return -errno;
+   return 0;
+}
+void FdrThreadUring::ArmEvents(uint32_t idx, EvHandler& evh) {
+   FdrEventFlag pollEvs = evh.Events_;
+   if (IsEnumContains(pollEvs, FdrEventFlag::Readable) && this->IsRingIo_) {
+      if (evh.IsReading_)
+         pollEvs -= FdrEventFlag::Readable;
+      else if (evh.RingIo_ && evh.RingIo_->ReadNode_ && evh.RingIo_->ReadNode_->GetDataSize() > 0) {
+         // 尚未交給 handler 的資料, 在 ProcessPendings() 交給 handler 之後, 才能再次讀取.
+         pollEvs -= FdrEventFlag::Readable;
+      }
+      else if (const size_t expectSize = GetRingReadSize(evh.Handler_.get())) {
+         if (this->ArmRead(idx, evh, expectSize))
+            pollEvs -= FdrEventFlag::Readable;
+      }
+   }
+   if (evh.IsArmed_) {
+      if (evh.PollEvents_ == pollEvs)
+         return;
+      this->CancelPoll(idx, evh);
+   }
+   if (pollEvs != FdrEventFlag::None)
+      this->ArmPoll(idx, evh, pollEvs);
+}
+void FdrThreadUring::ArmPoll(uint32_t idx, EvHandler& evh, FdrEventFlag evs) {
+   struct io_uring_sqe* sqe = this->GetSqe();
+   if (fon9_UNLIKELY(sqe == nullptr))
+      return;
+   // EPOLLET 有其他問題, 所以 FdrThreadEpoll 使用 level-triggered; 這裡的 one shot + 重新加入, 效果相同.
+   uint32_t events = IsEnumContains(evs, FdrEventFlag::Readable)
+      ? static_cast<uint32_t>(POLLIN | POLLPRI | POLLRDHUP)
+      : 0u;
+   if (IsEnumContains(evs, FdrEventFlag::Writable))
+      events |= POLLOUT;
+   // 不論是否設定 FdrEventFlag::Error, 都要偵測錯誤事件.
+   events |= (POLLHUP | POLLERR);
+   sqe->opcode = IORING_OP_POLL_ADD;
+   sqe->fd = evh.Handler_->GetFD();
+   sqe->poll32_events = events;
+   sqe->user_data = MakeUserData(idx, evh.Gen_);
+   evh.IsArmed_ = true;
+   evh.PollEvents_ = evs;
+}
+void FdrThreadUring::CancelPoll(uint32_t idx, EvHandler& evh) {
+   if (evh.IsArmed_) {
+      if (struct io_uring_sqe* sqe = this->GetSqe()) {
+         sqe->opcode = IORING_OP_POLL_REMOVE;
+         sqe->fd = -1;
+         sqe->addr = MakeUserData(idx, evh.Gen_);
+         sqe->user_data = kUserData_Ignore;
+      }
+      evh.IsArmed_ = false;
+   }
+   ++evh.Gen_;
+}
+bool FdrThreadUring::ArmRead(uint32_t idx, EvHandler& evh, size_t expectSize) {
+   struct io_uring_sqe* sqe = this->GetSqe();
+   if (fon9_UNLIKELY(sqe == nullptr))
+      return false;
+   if (!evh.RingIo_)
+      evh.RingIo_.reset(new RingIo);
+   RingIo&         rio = *evh.RingIo_;
+   FwdBufferNode*& node = rio.ReadNode_;
+   if (node && node->GetRemainSize() < expectSize) {
+      FreeNode(node);
+      node = nullptr;
+   }
+   if (node == nullptr)
+      node = FwdBufferNode::Alloc(expectSize);
+   fon9_PutIoVectorElement(&rio.ReadIov_, node->GetDataEnd(), node->GetRemainSize());
+   sqe->opcode = IORING_OP_READV;
+   sqe->fd = evh.Handler_->GetFD();
+   sqe->addr = reinterpret_cast<uintptr_t>(&rio.ReadIov_);
+   sqe->len = 1;
+   sqe->user_data = MakeUserData(idx, 0, RingOp_Read);
+   evh.IsReading_ = true;
+   return true;
+}
+void FdrThreadUring::CancelRingOp(uint64_t userData) {
+   if (struct io_uring_sqe* sqe = this->GetSqe()) {
+      sqe->opcode = IORING_OP_ASYNC_CANCEL;
+      sqe->fd = -1;
+      sqe->addr = userData;
+      sqe->user_data = kUserData_Ignore;
+   }
+}
+bool FdrThreadUring::StartRingWrite(FdrEventHandler* handler, const struct iovec* iov, size_t count) {
+   if (!this->IsRingIo_ || !this->IsThisThread())
+      return false;
+   const auto idx1 = handler->GetFdrEventHandlerBookmark();
+   if (idx1 <= 0) // 尚未加入 fdr thread, 或已移除.
+      return false;
+   const uint32_t idx = static_cast<uint32_t>(idx1 - 1);
+   if (fon9_UNLIKELY(idx >= this->EvHandlers_.size()))
+      return false;
+   EvHandler& evh = this->EvHandlers_[idx];
+   if (evh.Handler_.get() != handler || evh.IsRemoved_ || evh.IsWriting_)
+      return false;
+   struct io_uring_sqe* sqe = this->GetSqe();
+   if (fon9_UNLIKELY(sqe == nullptr))
+      return false;
+   if (!evh.RingIo_)
+      evh.RingIo_.reset(new RingIo);
+   if (count > kMaxRingWriteIov)
+      count = kMaxRingWriteIov;
+   // 在 io_uring_enter() 送出之前, kernel 尚未取用 iov, 所以必須複製.
+   memcpy(evh.RingIo_->WriteIov_, iov, count * sizeof(*iov));
+   sqe->opcode = IORING_OP_WRITEV;
+   sqe->fd = handler->GetFD();
+   sqe->addr = reinterpret_cast<uintptr_t>(evh.RingIo_->WriteIov_);
+   sqe->len = static_cast<uint32_t>(count);
+   sqe->user_data = MakeUserData(idx, 0, RingOp_Write);
+   evh.IsWriting_ = true;
+   return true;
+}
+void FdrThreadUring::ArmWakeup() {
+   if (struct io_uring_sqe* sqe = this->GetSqe()) {
+      sqe->opcode = IORING_OP_POLL_ADD;
+      sqe->fd = this->WakeupFdr_.GetReadFD();
+      sqe->poll32_events = POLLIN;
+      sqe->user_data = kUserData_Wakeup;
+   }
+}
+
+//--------------------------------------------------------------------------//
+
+void FdrThreadUring::ThrRunImpl(const ServiceThreadArgs& args) {
+   const bool isBlockWait = IsBlockWait(args.HowWait_);
+   // 非 Block 模式, 連續 idleCount 次沒有事件, 超過 args.IdleSpin_ 之後, 才開始退讓.
+   uint32_t   idleCount = 0;
+   this->EvHandlers_.reserve(args.Capacity_);
+   this->ArmWakeup();
+   while (this->use_count() > 0) {
+      // 再次等候事件之前, 必須先將 Pending Removes, Updates 處理完, 理由同 FdrThreadEpoll.
+      unsigned minComplete = isBlockWait ? 1u : 0u;
+      if (fon9_UNLIKELY(this->WakeupRequests_.load(std::memory_order_relaxed) != 0)) {
+         this->ClearWakeup();
+         this->ProcessPendings();
+         if (this->WakeupRequests_.load(std::memory_order_relaxed) != 0)
+            minComplete = 0;
+      }
+      if (int eno = this->Enter(minComplete)) {
+         // EBUSY: CQ 溢位的事件尚未清除, 處理完 CQ 之後再試.
+         if ((eno = ErrorCannotRetry(-eno)) != 0 && eno != EBUSY)
+            fon9_LOG_FATAL("FdrThreadUring.ThrRun|fn=io_uring_enter|err=", GetSysErrC(eno));
+      }
+      LoopStat::Add(this->LoopStat_.Loops_, 1);
+      if (const unsigned evCount = this->ProcessCompletions()) {
+         idleCount = 0;
+         LoopStat::Add(this->LoopStat_.Wakeups_, 1);
+         LoopStat::Add(this->LoopStat_.Events_, evCount);
+      }
+      else {
+         LoopStat::Add(this->LoopStat_.Idles_, 1);
+         if (isBlockWait)
+            continue;
+         args.OnIdle(idleCount);
+      }
+   }
+   this->EvHandlers_.clear();
+}
+
+unsigned FdrThreadUring::ProcessCompletions() {
+   unsigned evCount = 0;
+   unsigned head = *this->CqHead_;
+   for (;;) {
+      if (head == __atomic_load_n(this->CqTail_, __ATOMIC_ACQUIRE))
+         break;
+      const struct io_uring_cqe* cqe = this->Cqes_ + (head & this->CqMask_);
+      const uint64_t userData = cqe->user_data;
+      const int      cqeRes = cqe->res;
+      // 先歸還 CQE, 在 OnFdrEvent_Emit() 期間, kernel 就可以繼續使用.
+      __atomic_store_n(this->CqHead_, ++head, __ATOMIC_RELEASE);
+      if (fon9_UNLIKELY(userData >= kUserData_Ignore)) {
+         if (userData == kUserData_Wakeup) {
+            this->WakeupRequests_.store(1, std::memory_order_relaxed);
+            this->ArmWakeup();
+         }
+         continue;
+      }
+      const uint32_t idx = static_cast<uint32_t>(userData) & kUserData_IdxMask;
+      if (fon9_UNLIKELY(idx >= this->EvHandlers_.size()))
+         continue;
+      EvHandler& evh = this->EvHandlers_[idx];
+      switch (static_cast<RingOp>(static_cast<uint32_t>(userData) >> 28)) {
+      case RingOp_Poll:
+         break;
+      case RingOp_Read:
+         evh.IsReading_ = false;
+         if (fon9_UNLIKELY(evh.IsRemoved_)) {
+            if (!evh.IsWriting_)
+               this->FreeEvHandler(idx, evh);
+            continue;
+         }
+         if (fon9_LIKELY(cqeRes > 0)) {
+            FwdBufferNode* node = evh.RingIo_->ReadNode_;
+            node->SetDataEnd(node->GetDataEnd() + cqeRes);
+         }
+         ++evCount;
+         this->EmitRingRead(idx, evh, cqeRes);
+         continue;
+      case RingOp_Write:
+         evh.IsWriting_ = false;
+         if (fon9_UNLIKELY(evh.IsRemoved_)) {
+            if (!evh.IsReading_)
+               this->FreeEvHandler(idx, evh);
+            continue;
+         }
+         ++evCount;
+         OnFdrEvent_RingWriteDone(evh.Handler_.get(), cqeRes);
+         continue;
+      default:
+         continue;
+      }
+      if (evh.Gen_ != static_cast<uint32_t>(userData >> 32) || !evh.IsArmed_)
+         continue;
+      evh.IsArmed_ = false;
+      ++evCount;
+      // OnFdrEvent_Emit() 若有 UpdateFdrEvent(), RemoveFdrEvent(), 都會在 ProcessPendings() 才處理,
+      // 所以在此期間 EvHandlers_ 不會異動, evh 仍然有效.
+      FdrEventHandler* hdr = evh.Handler_.get();
+      FdrEventFlag     evs;
+      if (fon9_LIKELY(cqeRes >= 0)) {
+         const auto eflags = static_cast<uint32_t>(cqeRes);
+         evs = (eflags & POLLOUT) ? FdrEventFlag::Writable : FdrEventFlag::None;
+         if (eflags & (POLLIN | POLLPRI | POLLRDHUP))
+            evs |= FdrEventFlag::Readable;
+         if (fon9_UNLIKELY(eflags & (POLLHUP | POLLERR | POLLNVAL)))
+            evs |= FdrEventFlag::Error;
+      }
+      else {
+         evs = FdrEventFlag::Error;
+      }
+      if (fon9_UNLIKELY(IsEnumContains(evs, FdrEventFlag::Error))) {
+         // 避免 hdr 處理 error 期間, 這裡會一直觸發 error, 所以一旦 error, 就移除 handler.
+         hdr->RemoveFdrEvent();
+         this->OnFdrEvent_Emit(evs, hdr);
+         continue;
+      }
+      this->OnFdrEvent_Emit(evs, hdr);
+      // one shot: 依照 hdr 目前需要的事件, 重新加入偵測.
+      // 若此時不需要任何事件, 則等 hdr->UpdateFdrEvent() 時, 在 ProcessPendings() 重新加入.
+      evh.Events_ = hdr->GetRequiredFdrEventFlag();
+      this->ArmEvents(idx, evh);
+   }
+   return evCount;
+}
+void FdrThreadUring::EmitRingRead(uint32_t idx, EvHandler& evh, int res) {
+   FdrEventHandler* hdr = evh.Handler_.get();
+   FwdBufferNode*&  node = evh.RingIo_->ReadNode_;
+   if (fon9_LIKELY(res > 0)) {
+      if (fon9_UNLIKELY(!IsEnumContains(hdr->GetRequiredFdrEventFlag(), FdrEventFlag::Readable))) {
+         // handler 已暫停 Readable(e.g. 正在 op thread 處理上次收到的資料):
+         // 保留資料, 等 handler 重新啟用 Readable 時(ProcessPendings()), 再交給 handler.
+         return;
+      }
+   }
+   if (fon9_LIKELY(res != -ECANCELED)) { // ECANCELED: 因 handler 暫停 Readable 而取消.
+      OnFdrEvent_RingReadDone(hdr, node, res);
+      if (node && node->GetDataSize() > 0) { // handler 沒有取走的資料: 拋棄.
+         FreeNode(node);
+         node = nullptr;
+      }
+      // 斷線 or 無法重試的錯誤: handler 已處理(RemoveFdrEvent()), 不用再讀.
+      if (res == 0 || (res < 0 && ErrorCannotRetry(-res)))
+         return;
+   }
+   evh.Events_ = hdr->GetRequiredFdrEventFlag();
+   this->ArmEvents(idx, evh);
+}
+void FdrThreadUring::FreeEvHandler(uint32_t idx, EvHandler& evh) {
+   evh.Handler_.reset();
+   evh.IsRemoved_ = false;
+   if (evh.RingIo_) {
+      FwdBufferNode*& node = evh.RingIo_->ReadNode_;
+      if (node && node->GetDataSize() > 0) {
+         FreeNode(node);
+         node = nullptr;
+      }
+   }
+   this->FreeIndexes_.push_back(idx);
+}
+
+void FdrThreadUring::ProcessPendings() {
+   this->ProcessPendingSends();
+
+   this->PendingRemoves_.ConsumeAll([this](FdrEventHandlerSP& spRemove) {
+      FdrEventHandler* hdr = spRemove.get();
+      auto idx1 = hdr->GetFdrEventHandlerBookmark();
+      if (fon9_UNLIKELY(idx1 <= 0))
+         return;
+      const uint32_t idx = static_cast<uint32_t>(idx1 - 1);
+      if (fon9_UNLIKELY(idx >= this->EvHandlers_.size() || this->EvHandlers_[idx].Handler_.get() != hdr))
+         fon9_LOG_ERROR("FdrServiceUring.Remove|fd=", hdr->GetFD(), "|idx=", idx1, "|hdr=", ToPtr{hdr}, "|err=Not found");
+      else {
+         EvHandler& evh = this->EvHandlers_[idx];
+         this->CancelPoll(idx, evh);
+         evh.Events_ = FdrEventFlag::None;
+         if (evh.IsReading_)
+            this->CancelRingOp(MakeUserData(idx, 0, RingOp_Read));
+         if (evh.IsWriting_)
+            this->CancelRingOp(MakeUserData(idx, 0, RingOp_Write));
+         if (evh.IsReading_ || evh.IsWriting_)
+            evh.IsRemoved_ = true; // 等 READV/WRITEV 完成後, 才能釋放 RingIo_ 的資源.
+         else
+            this->FreeEvHandler(idx, evh);
+      }
+      this->SetFdrEventHandlerBookmark(hdr, 0);
+   });
+   this->PendingUpdates_.ConsumeAll([this](FdrEventHandlerSP& sp) {
+      FdrEventHandler*   hdr = sp.get();
+      auto               idx1 = hdr->GetFdrEventHandlerBookmark();
+      const FdrEventFlag evs = hdr->GetRequiredFdrEventFlag();
+      uint32_t           idx;
+      if (fon9_LIKELY(idx1 > 0)) {
+         idx = static_cast<uint32_t>(idx1 - 1);
+         if (fon9_UNLIKELY(idx >= this->EvHandlers_.size()))
+            return;
+         EvHandler& evh = this->EvHandlers_[idx];
+         if (evh.Handler_.get() != hdr || evh.IsRemoved_)
+            return;
+      }
+      else {
+         if (fon9_UNLIKELY(evs == FdrEventFlag::None))
+            return;
+         if (this->FreeIndexes_.empty()) {
+            idx = static_cast<uint32_t>(this->EvHandlers_.size());
+            this->EvHandlers_.emplace_back();
+         }
+         else {
+            idx = this->FreeIndexes_.back();
+            this->FreeIndexes_.pop_back();
+         }
+         this->EvHandlers_[idx].Handler_.reset(hdr);
+         this->SetFdrEventHandlerBookmark(hdr, idx + 1u);
+         this->SetSockBusyPoll(hdr);
+      }
+      EvHandler& evh = this->EvHandlers_[idx];
+      evh.Events_ = evs;
+      if (IsEnumContains(evs, FdrEventFlag::Readable)) {
+         // 暫停 Readable 期間收到的資料, 現在交給 handler; EmitRingRead() 會重新偵測需要的事件.
+         if (evh.RingIo_ && !evh.IsReading_ && evh.RingIo_->ReadNode_ && evh.RingIo_->ReadNode_->GetDataSize() > 0) {
+            this->EmitRingRead(idx, evh, static_cast<int>(evh.RingIo_->ReadNode_->GetDataSize()));
+            return;
+         }
+      }
+      else if (evh.IsReading_) {
+         // 暫停 Readable: 取消等候中的 READV, 若取消前已收到資料, 則在 EmitRingRead() 保留.
+         this->CancelRingOp(MakeUserData(idx, 0, RingOp_Read));
+      }
+      this->ArmEvents(idx, evh);
+   });
+}
+#endif//fon9_HAS_IO_URING
+
+} } // namespaces
+#endif//__linux__
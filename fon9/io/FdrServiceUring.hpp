@@ -0,0 +1,141 @@
+﻿/// \file fon9/io/FdrServiceUring.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_io_FdrServiceUring_hpp__
+#define __fon9_io_FdrServiceUring_hpp__
+#ifdef __linux__
+#include "fon9/io/FdrService.hpp"
+#include "fon9/buffer/FwdBufferList.hpp"
+#include "fon9/buffer/DcQueueList.hpp" // struct iovec, fon9_PutIoVectorElement();
+#include <memory>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace fon9 { namespace io {
+
+struct FdrServiceUring {
+   using MakeResult = Result2;
+   /// 若系統不支援 io_uring, 則傳回 nullptr, 並在 err 填入失敗原因.
+   static FdrServiceSP MakeService(const IoServiceArgs& ioArgs, const std::string& thrName, MakeResult& err);
+};
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup io
+/// 提供使用 io_uring 處理 non-blocking fd 讀寫事件服務.
+/// - 使用 IORING_OP_POLL_ADD(one shot) 偵測事件, 觸發事件後再重新加入,
+///   所以與 FdrThreadEpoll 相同, 都是 level-triggered.
+/// - 新增、異動、移除偵測, 只是填入 SQE(submission queue entry),
+///   在下次等候事件時, 才透過同一次 io_uring_enter() 送出;
+///   不像 epoll_ctl() 每次異動都需要一次系統呼叫.
+/// - 非 Block 模式, 若 CQ(completion queue) 已有事件, 且沒有需要送出的 SQE, 則不用進入 kernel.
+/// - 若 kernel 支援 IORING_FEAT_FAST_POLL, 則使用完成式讀寫:
+///   - 讀取: handler 需要 Readable 時, 若 handler 提供讀取緩衝區大小(OnFdrEvent_GetRingReadSize() != 0),
+///     則送出 IORING_OP_READV 取代 POLL_ADD(POLLIN); 完成後透過 OnFdrEvent_RingReadDone() 交給 handler.
+///   - 寫入: 在 fdr thread 的傳送(FdrEventHandler::StartRingWrite()) 送出 IORING_OP_WRITEV,
+///     完成後透過 OnFdrEvent_RingWriteDone() 通知 handler 繼續傳送.
+///   - 移除 handler 時, 若仍有 READV/WRITEV 尚未完成, 則送出 IORING_OP_ASYNC_CANCEL,
+///     並保留 handler, 直到全部完成後, 才釋放 handler 及所在的位置.
+/// - 不使用 IORING_REGISTER_BUFFERS(固定緩衝區):
+///   收到的 FwdBufferNode 直接交給 session, 由 session 用 FreeNode() 歸還給 MemBlock;
+///   傳送的區塊則屬於 Device 的傳送佇列. 緩衝區離開固定的註冊表後,
+///   必須再用 IORING_REGISTER_BUFFERS_UPDATE(一次系統呼叫) 補上, 或先複製一次, 成本都高於省下的 page pinning.
+class FdrThreadUring : public FdrThread {
+   fon9_NON_COPY_NON_MOVE(FdrThreadUring);
+   FdrAuto     FdrRing_;
+
+   void*       SqRingPtr_{nullptr};
+   size_t      SqRingSize_{0};
+   void*       CqRingPtr_{nullptr};
+   size_t      CqRingSize_{0};
+   io_uring_sqe* Sqes_{nullptr};
+   size_t      SqesSize_{0};
+
+   unsigned*   SqHead_{nullptr};
+   unsigned*   SqTail_{nullptr};
+   unsigned*   SqArray_{nullptr};
+   unsigned    SqMask_{0};
+   unsigned    SqEntries_{0};
+   /// 已填入, 但尚未通知 kernel 的 SQ tail.
+   unsigned    SqTailLocal_{0};
+   unsigned*   CqHead_{nullptr};
+   unsigned*   CqTail_{nullptr};
+   unsigned    CqMask_{0};
+   io_uring_cqe* Cqes_{nullptr};
+
+   /// kernel 支援 IORING_FEAT_FAST_POLL 時, 才使用完成式讀寫.
+   bool        IsRingIo_{false};
+
+   enum : size_t {
+      /// 一次 WRITEV 最多送出的區塊數量, 剩餘的在完成後繼續送出.
+      kMaxRingWriteIov = 64,
+   };
+   /// 完成式讀寫使用的資源, 在 kernel 完成前必須保持有效,
+   /// 所以另外配置, 不受 EvHandlers_ 擴充(搬移)的影響.
+   struct RingIo {
+      fon9_NON_COPY_NON_MOVE(RingIo);
+      RingIo() = default;
+      ~RingIo() {
+         if (this->ReadNode_)
+            FreeNode(this->ReadNode_);
+      }
+      /// READV 的緩衝區, handler 沒有取走(沒有收到資料), 則保留到下次使用.
+      /// 若有資料, 但 handler 已暫停 Readable, 則保留到 handler 重新啟用 Readable 時再交給 handler.
+      FwdBufferNode* ReadNode_{nullptr};
+      struct iovec   ReadIov_;
+      struct iovec   WriteIov_[kMaxRingWriteIov];
+   };
+   struct EvHandler {
+      FdrEventHandlerSP Handler_;
+      FdrEventFlag      Events_{FdrEventFlag::None};
+      /// 等候中的 POLL_ADD 所偵測的事件.
+      FdrEventFlag      PollEvents_{FdrEventFlag::None};
+      /// 取消偵測時遞增, 用來排除已取消的 POLL_ADD 所產生的 CQE.
+      uint32_t          Gen_{0};
+      /// 是否有 POLL_ADD 等候中.
+      bool              IsArmed_{false};
+      /// 是否有 READV 等候中.
+      bool              IsReading_{false};
+      /// 是否有 WRITEV 等候中.
+      bool              IsWriting_{false};
+      /// 已移除, 但仍有 READV/WRITEV 尚未完成.
+      bool              IsRemoved_{false};
+      std::unique_ptr<RingIo> RingIo_;
+   };
+   using EvHandlers = std::vector<EvHandler>;
+   EvHandlers              EvHandlers_;
+   std::vector<uint32_t>   FreeIndexes_;
+
+   io_uring_sqe* GetSqe();
+   bool IsCqEmpty() const;
+   /// 送出尚未處理的 SQE, 並等候至少 minComplete 個事件.
+   /// \retval <0 errno.
+   int Enter(unsigned minComplete);
+   /// 依照 evh.Events_ 送出需要的 READV 或 POLL_ADD.
+   void ArmEvents(uint32_t idx, EvHandler& evh);
+   void ArmPoll(uint32_t idx, EvHandler& evh, FdrEventFlag evs);
+   void CancelPoll(uint32_t idx, EvHandler& evh);
+   bool ArmRead(uint32_t idx, EvHandler& evh, size_t expectSize);
+   void CancelRingOp(uint64_t userData);
+   /// READV 的結果交給 handler, 然後依照 handler 需要的事件重新偵測.
+   /// res > 0 時, 資料已在 evh.RingIo_->ReadNode_.
+   void EmitRingRead(uint32_t idx, EvHandler& evh, int res);
+   /// 移除 handler 時, 若仍有 READV/WRITEV 尚未完成, 則等全部完成後才呼叫.
+   void FreeEvHandler(uint32_t idx, EvHandler& evh);
+   virtual bool StartRingWrite(FdrEventHandler* handler, const struct iovec* iov, size_t count) override;
+   void ArmWakeup();
+   /// \return 有效的事件數量.
+   unsigned ProcessCompletions();
+   void ProcessPendings();
+   virtual void ThrRunImpl(const ServiceThreadArgs& args) override;
+
+public:
+   /// entries = SQ 的容量, kernel 會調整成 2 的冪次.
+   FdrThreadUring(FdrServiceUring::MakeResult& res, unsigned entries);
+
+   virtual ~FdrThreadUring();
+};
+fon9_WARN_POP;
+
+} } // namespaces
+#endif//__linux__
+#endif//__fon9_io_FdrServiceUring_hpp__
@@ -3,12 +3,18 @@
 #include "fon9/sys/Config.h"
 #ifdef fon9_POSIX
 #include "fon9/io/FdrSocket.hpp"
+#include "fon9/LatencyHist.hpp"
 
 namespace fon9 { namespace io {
 
 FdrEventFlag FdrSocket::GetRequiredFdrEventFlag() const {
    return static_cast<FdrEventFlag>(this->EnabledEvents_.load(std::memory_order_relaxed));
 }
+size_t FdrSocket::OnFdrEvent_GetRingReadSize() {
+   if (fon9_UNLIKELY(this->RecvSize_ < RecvBufferSize::Default))
+      return 0;
+   return this->GetRecvExpectSize();
+}
 
 void FdrSocket::SocketError(StrView fnName, int eno) {
    this->RemoveFdrEvent();
@@ -25,6 +31,8 @@ void FdrSocket::SocketError(StrView fnName, int eno) {
 int FdrSocket::Sendv(DeviceOpLocker& sc, DcQueueList& toSend) {
    struct iovec   bufv[IOV_MAX];
    size_t         bufCount = toSend.PeekBlockVector(bufv);
+   if (bufCount && !this->IsRingWriteDisabled_ && this->StartRingWrite(bufv, bufCount))
+      return 0;
 __RETRY_WRITEV:
    ssize_t        wrsz = (bufCount ? writev(this->GetFD(), bufv, static_cast<int>(bufCount)) : 0);
    if (fon9_LIKELY(wrsz >= 0)) {
@@ -80,28 +88,16 @@ bool FdrSocket::CheckRead(Device& dev, bool (*fnIsRecvBufferAlive)(Device& dev,
    size_t   totrd = 0;
    if (fon9_LIKELY(this->RecvSize_ >= RecvBufferSize::Default)) {
       for (;;) {
-         size_t expectSize = (this->RecvSize_ == RecvBufferSize::Default
-                              ? 1024 * 4
-                              : static_cast<size_t>(this->RecvSize_));
-         if (expectSize < 64)
-            expectSize = 64;
-
+         const size_t   expectSize = this->GetRecvExpectSize();
          struct iovec   bufv[2];
          bufv[1].iov_len = 0;
 
          size_t   bufCount = this->RecvBuffer_.GetRecvBlockVector(bufv, expectSize);
          ssize_t  bytesTransfered = readv(this->GetFD(), bufv, static_cast<int>(bufCount));
          if (fon9_LIKELY(bytesTransfered > 0)) {
+            fon9_LATENCY_SCOPE("Io.RecvReady");
             DcQueueList&   rxbuf = this->RecvBuffer_.SetDataReceived(bytesTransfered);
-
-            struct RecvAux : public FdrRecvAux {
-               bool (*FnIsRecvBufferAlive_)(Device& dev, RecvBuffer& rbuf);
-               bool IsRecvBufferAlive(Device& dev, RecvBuffer& rbuf) const {
-                  return this->FnIsRecvBufferAlive_ == nullptr || this->FnIsRecvBufferAlive_(dev, rbuf);
-               }
-            };
-            RecvAux aux;
-            aux.FnIsRecvBufferAlive_ = fnIsRecvBufferAlive;
+            CheckReadAux   aux{fnIsRecvBufferAlive};
             DeviceRecvBufferReady(dev, rxbuf, aux);
 
             // 實際取出的資料量, 比要求取出的少 => 資料已全部取出, 所以結束 Recv.
@@ -154,6 +150,28 @@ __READ_ERROR:
    return true;
 }
 
+bool FdrSocket::RingReadDone(Device& dev, bool (*fnIsRecvBufferAlive)(Device& dev, RecvBuffer& rbuf), FwdBufferNode*& node, int res) {
+   if (fon9_LIKELY(res > 0)) {
+      // Session 決定不要再處理 OnDevice_Recv() 事件: 不取走 node, 由 fdr thread 拋棄.
+      if (fon9_UNLIKELY(this->RecvSize_ < RecvBufferSize::Default))
+         return true;
+      fon9_LATENCY_SCOPE("Io.RecvReady");
+      DcQueueList&   rxbuf = this->RecvBuffer_.SetBatchReceived(&node, 1);
+      CheckReadAux   aux{fnIsRecvBufferAlive};
+      DeviceRecvBufferReady(dev, rxbuf, aux);
+      return true;
+   }
+   if (res == 0) { // disconnect.
+      this->SocketError("Recv", 0);
+      return false;
+   }
+   if (int eno = ErrorCannotRetry(-res)) {
+      this->SocketError("Recv", eno);
+      return false;
+   }
+   return true;
+}
+
 //--------------------------------------------------------------------------//
 
 SendDirectResult FdrSocket::FdrRecvAux::SendDirect(RecvDirectArgs& e, BufferList&& txbuf) {
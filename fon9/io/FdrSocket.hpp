@@ -16,6 +16,8 @@ protected:
    RecvBufferSize             RecvSize_;
    RecvBuffer                 RecvBuffer_;
    SendBuffer                 SendBuffer_;
+   /// 完成式寫入(io_uring WRITEV)若有非預期的失敗(e.g. EMSGSIZE), 則此 socket 改用 writev() + writable 事件.
+   bool                       IsRingWriteDisabled_{false};
 
    /// 建立錯誤訊息字串, 觸發事件:
    /// `this->OnFdrSocket_Error("fnName:" + GetSocketErrC(eno));`
@@ -23,6 +25,16 @@ protected:
    virtual void OnFdrSocket_Error(std::string errmsg) = 0;
 
    virtual FdrEventFlag GetRequiredFdrEventFlag() const override;
+   /// 若 Session 不處理收到的資料(RecvSize_ < RecvBufferSize::Default), 則傳回 0, 改用 CheckRead() 拋棄資料.
+   virtual size_t OnFdrEvent_GetRingReadSize() override;
+
+   /// 依照 RecvSize_ 決定一次讀取的緩衝區大小.
+   size_t GetRecvExpectSize() const {
+      const size_t expectSize = (this->RecvSize_ == RecvBufferSize::Default
+                                 ? 1024 * 4
+                                 : static_cast<size_t>(this->RecvSize_));
+      return expectSize < 64 ? 64 : expectSize;
+   }
 
    void CheckSocketErrorOrCanceled(FdrEventFlag evs) {
       if (IsEnumContains(evs, FdrEventFlag::Error)) {
@@ -33,6 +45,7 @@ protected:
       }
    }
 
+   /// 若在 fdr thread 且支援完成式寫入, 則交給 StartRingWrite() 送出, 完成後由 RingWriteDone() 繼續傳送.
    /// \retval 0     success;  返回前, 若已無資料則: CheckSendQueueEmpty(); 若仍有資料則: 啟動 writable 偵測.
    /// \retval else  errno;    返回前, 已先呼叫 this->OnFdrSocket_Error("fn=Sendv|err=", retval);
    int Sendv(DeviceOpLocker& sc, DcQueueList& toSend);
@@ -99,11 +112,25 @@ public:
       }
       static SendDirectResult SendDirect(RecvDirectArgs& e, BufferList&& txbuf);
    };
+   struct CheckReadAux : public FdrRecvAux {
+      bool (*FnIsRecvBufferAlive_)(Device& dev, RecvBuffer& rbuf);
+      CheckReadAux(bool (*fnIsRecvBufferAlive)(Device& dev, RecvBuffer& rbuf))
+         : FnIsRecvBufferAlive_{fnIsRecvBufferAlive} {
+      }
+      bool IsRecvBufferAlive(Device& dev, RecvBuffer& rbuf) const {
+         return this->FnIsRecvBufferAlive_ == nullptr || this->FnIsRecvBufferAlive_(dev, rbuf);
+      }
+   };
 
    /// \retval true  成功完成 read.
    /// \retval false read 失敗, 返回前已呼叫 OnFdrSocket_Error();
    bool CheckRead(Device& dev, bool (*fnIsRecvBufferAlive)(Device& dev, RecvBuffer& rbuf));
 
+   /// 完成式讀取(OnFdrEvent_RingReadDone())的處理: 接手 node, 觸發 OnDevice_Recv() 事件.
+   /// \retval true  成功完成 read.
+   /// \retval false read 失敗, 返回前已呼叫 OnFdrSocket_Error();
+   bool RingReadDone(Device& dev, bool (*fnIsRecvBufferAlive)(Device& dev, RecvBuffer& rbuf), FwdBufferNode*& node, int res);
+
    //--------------------------------------------------------------------------//
 
    SendBuffer& GetSendBuffer() {
@@ -129,6 +156,37 @@ public:
       }
    };
 
+   /// 完成式寫入完成後繼續傳送: 與 IOCP 相同, 使用 sbuf.OpImpl_ContinueSend(BytesSent_) 取出剩餘的資料.
+   template <class ContinueSendAuxT>
+   struct RingWriteDoneAux : public ContinueSendAuxT {
+      size_t   BytesSent_;
+      RingWriteDoneAux(size_t bytesSent) : BytesSent_{bytesSent} {
+      }
+      DcQueueList* GetContinueToSend(SendBuffer& sbuf) const {
+         return sbuf.OpImpl_ContinueSend(this->BytesSent_);
+      }
+   };
+   /// 完成式寫入(OnFdrEvent_RingWriteDone())的處理.
+   /// 在此之前 SendBuffer_ 維持在 Sending 狀態, 所以 Sendv() 交給 fdr thread 的資料, 不會被其他 thread 異動.
+   template <class ContinueSendAuxT, class DeviceT>
+   void RingWriteDone(DeviceT& dev, int res) {
+      size_t bytesSent = 0;
+      if (fon9_LIKELY(res >= 0))
+         bytesSent = static_cast<size_t>(res);
+      else {
+         const int eno = ErrorCannotRetry(-res);
+         if (eno && eno != EMSGSIZE) {
+            this->SocketError("Sendv", eno);
+            return;
+         }
+         // EAGAIN(有 FAST_POLL 時不應發生), EMSGSIZE(需要 Sendv() 的分割重送):
+         // 改用 writev() + writable 事件, 重送尚未送出的資料.
+         this->IsRingWriteDisabled_ = true;
+      }
+      RingWriteDoneAux<ContinueSendAuxT> aux{bytesSent};
+      DeviceContinueSend(dev, this->SendBuffer_, aux);
+   }
+
    struct SendASAP_AuxMem : public SendAuxMem {
       using SendAuxMem::SendAuxMem;
 
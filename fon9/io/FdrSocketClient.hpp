@@ -54,6 +54,17 @@ protected:
       impl->CheckSocketErrorOrCanceled(evs);
    }
 
+   template <class Impl, class OwnerDevice>
+   static void RingReadDoneProcessor(Impl* impl, OwnerDevice& owner, FwdBufferNode*& node, int res) {
+      if (fon9_LIKELY(impl->State_ != State::Closing))
+         impl->RingReadDone(owner, &OwnerDevice::OpImpl_IsRecvBufferAlive, node, res);
+   }
+   template <class Impl, class OwnerDevice>
+   static void RingWriteDoneProcessor(Impl* impl, OwnerDevice& owner, int res) {
+      if (fon9_LIKELY(impl->State_ != State::Closing))
+         impl->template RingWriteDone<typename OwnerDevice::ContinueSendAux>(owner, res);
+   }
+
 public:
    FdrSocketClientImpl(FdrService& iosv, Socket&& so)
       : FdrSocket{iosv, std::move(so)} {
@@ -31,6 +31,12 @@ void FdrTcpClientImpl::OnFdrEvent_Handling(FdrEventFlag evs) {
 void FdrTcpClientImpl::OnFdrEvent_StartSend() {
    this->StartSend(*this->Owner_);
 }
+void FdrTcpClientImpl::OnFdrEvent_RingReadDone(FwdBufferNode*& node, int res) {
+   RingReadDoneProcessor(this, *this->Owner_, node, res);
+}
+void FdrTcpClientImpl::OnFdrEvent_RingWriteDone(int res) {
+   RingWriteDoneProcessor(this, *this->Owner_, res);
+}
 
 } } // namespaces
 #endif
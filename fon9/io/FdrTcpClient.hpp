@@ -12,6 +12,8 @@ struct FdrTcpClientImpl : public FdrSocketClientImpl {
    using base = FdrSocketClientImpl;
    virtual void OnFdrEvent_Handling(FdrEventFlag evs) override;
    virtual void OnFdrEvent_StartSend() override;
+   virtual void OnFdrEvent_RingReadDone(FwdBufferNode*& node, int res) override;
+   virtual void OnFdrEvent_RingWriteDone(int res) override;
    virtual void OnFdrSocket_Error(std::string errmsg) override;
 
 public:
@@ -38,6 +38,12 @@ class FdrTcpListener::AcceptedClient : public DeviceAcceptedClient, public FdrSo
       }
       this->CheckSocketErrorOrCanceled(evs);
    }
+   virtual void OnFdrEvent_RingReadDone(FwdBufferNode*& node, int res) override {
+      this->RingReadDone(*this, nullptr, node, res);
+   }
+   virtual void OnFdrEvent_RingWriteDone(int res) override {
+      this->RingWriteDone<ContinueSendAux>(*this, res);
+   }
 
    virtual void OnFdrSocket_Error(std::string errmsg) override {
       this->AsyncDispose(errmsg);
@@ -16,14 +16,26 @@ using Dgram = fon9::io::IocpDgram;
 #else
 #include "fon9/io/FdrTcpClient.hpp"
 #include "fon9/io/FdrTcpServer.hpp"
-#include "fon9/io/FdrServiceEpoll.hpp"
-using IoService = fon9::io::FdrServiceEpoll;
 using IoServiceSP = fon9::io::FdrServiceSP;
+/// 依照 IoServiceArgs 的 "Engine=epoll or uring" 建立 FdrService.
+struct IoService {
+   using MakeResult = fon9::Result2;
+   static IoServiceSP MakeService(const fon9::io::IoServiceArgs& ioArgs, const std::string& thrName, MakeResult& err) {
+      return fon9::io::MakeDefaultFdrService(ioArgs, thrName, err);
+   }
+};
 using TcpClient = fon9::io::FdrTcpClient;
 using TcpServer = fon9::io::FdrTcpServer;
 
 #include "fon9/io/FdrDgram.hpp"
 using Dgram = fon9::io::FdrDgram;
+
+#include "fon9/io/FdrServiceUring.hpp"
+
+#include "fon9/ThreadTools.hpp"
+#include <sys/eventfd.h>
+#include <arpa/inet.h>
+#include <sys/resource.h>
 #endif
 
 using TimeUS = fon9::Decimal<uint64_t, 3>;
@@ -157,7 +169,349 @@ fon9_WARN_POP;
 
 //--------------------------------------------------------------------------//
 
+#ifndef fon9_WINDOWS
+/// 測量多個 thread 同時透過 StartSendInFdrThread() 要求 fdr thread 處理的負擔.
+class BenchFdrHandler : public fon9::io::FdrEventHandler {
+   fon9_NON_COPY_NON_MOVE(BenchFdrHandler);
+   using base = fon9::io::FdrEventHandler;
+   void OnFdrEvent_Handling(fon9::io::FdrEventFlag) override {
+   }
+   void OnFdrEvent_StartSend() override {
+      this->StartSendCount_.store(this->StartSendCount_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   }
+   // 由 BenchPendingReqs() 負責 BenchFdrHandler 的生命週期, 此處僅記錄參考計數.
+   void OnFdrEvent_AddRef() override {
+      ++this->RefCount_;
+   }
+   void OnFdrEvent_ReleaseRef() override {
+      --this->RefCount_;
+   }
+public:
+   std::atomic<uint64_t>   StartSendCount_{0};
+   std::atomic<unsigned>   RefCount_{0};
+   BenchFdrHandler(fon9::io::FdrService& iosv)
+      : base{iosv, fon9::FdrAuto{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)}} {
+   }
+   fon9::io::FdrEventFlag GetRequiredFdrEventFlag() const override {
+      return fon9::io::FdrEventFlag::None;
+   }
+};
+// 每個 thread 使用各自的 handlers, 輪流要求 StartSendInFdrThread(),
+// 因為同一個 handler 在 fdr thread 取出之前, 重複的要求會被合併.
+static const unsigned kHandlerCountPerThread = 64;
+static const unsigned kTimesPerThread = 1000 * 1000;
+void BenchPendingReqs(const char* iosvCfg) {
+   fon9::io::IoServiceArgs iosvArgs;
+   fon9::RevBufferList     rbuf{128};
+   fon9::ParseConfig(iosvArgs, fon9::StrView_cstr(iosvCfg), rbuf);
+   iosvArgs.ThreadCount_ = 1;
+   IoService::MakeResult   err;
+   IoServiceSP iosv = IoService::MakeService(iosvArgs, "BenchPendingReqs", err);
+   if (!iosv) {
+      std::cout << "IoService.MakeService|" << fon9::RevPrintTo<std::string>(err) << std::endl;
+      return;
+   }
+   for (unsigned thrCount : {1u, 2u, 4u, 8u}) {
+      std::vector<std::unique_ptr<BenchFdrHandler>> handlers(thrCount * kHandlerCountPerThread);
+      for (auto& h : handlers)
+         h.reset(new BenchFdrHandler{*iosv});
+      std::vector<std::thread> thrs(thrCount);
+      fon9::StopWatch stopWatch;
+      for (unsigned L = 0; L < thrCount; ++L) {
+         thrs[L] = std::thread([&handlers, L]() {
+            const size_t hbeg = L * kHandlerCountPerThread;
+            for (unsigned count = 0; count < kTimesPerThread; ++count)
+               handlers[hbeg + count % kHandlerCountPerThread]->StartSendInFdrThread();
+         });
+      }
+      fon9::JoinThreads(thrs);
+      const double span = stopWatch.StopTimer();
+      uint64_t startSendCount = 0;
+      for (auto& h : handlers) {
+         while (h->RefCount_ != 0) // 等候 fdr thread 處理完畢.
+            std::this_thread::yield();
+         startSendCount += h->StartSendCount_;
+      }
+      const std::string msg = "threads=" + std::to_string(thrCount) + "|StartSendInFdrThread";
+      stopWatch.PrintResultNoEOL(span, msg.c_str(), thrCount * kTimesPerThread)
+         << "|OnFdrEvent_StartSend=" << startSendCount << std::endl;
+   }
+}
+#endif
+
+#ifdef __linux__
+/// 測試 FdrDgram 的 "RecvBatch=n": 一次 recvmmsg() 取出多個封包, 在一次 OnDevice_Recv() 提供.
+class RecvBatchSession : public fon9::io::Session {
+   fon9_NON_COPY_NON_MOVE(RecvBatchSession);
+   using base = fon9::io::Session;
+   fon9::io::RecvBufferSize OnDevice_LinkReady(fon9::io::Device&) override {
+      this->IsLinkReady_ = true;
+      return fon9::io::RecvBufferSize::Default;
+   }
+   fon9::io::RecvBufferSize OnDevice_Recv(fon9::io::Device&, fon9::DcQueue& rxbuf) override {
+      // 每個封包為一個獨立的區塊.
+      unsigned pkCount = 0;
+      while (const size_t blksz = rxbuf.GetCurrBlockSize()) {
+         rxbuf.PopConsumed(blksz);
+         ++pkCount;
+      }
+      this->RecvPkCounts_.push_back(pkCount);
+      ++this->RecvEvents_;
+      // 收到第1個封包後, 等測試端送出後續封包, 讓後續封包在同一次 recvmmsg() 取出.
+      while (this->RecvEvents_ == 1 && !this->IsAllSent_)
+         std::this_thread::yield();
+      this->RecvCount_.fetch_add(pkCount);
+      return fon9::io::RecvBufferSize::Default;
+   }
+public:
+   RecvBatchSession() = default;
+   std::atomic<bool>       IsLinkReady_{false};
+   std::atomic<bool>       IsAllSent_{false};
+   std::atomic<unsigned>   RecvEvents_{0};
+   std::atomic<unsigned>   RecvCount_{0};
+   /// 每次 OnDevice_Recv() 收到的封包數量, 僅在 io thread 存取, 測試結束後才檢查.
+   std::vector<unsigned>   RecvPkCounts_;
+};
+static void TestRecvBatch() {
+   std::cout << "[TEST ] FdrDgram.RecvBatch";
+   const uint16_t          kPort = 19381;
+   const unsigned          kBatchCount = 8;
+   fon9::io::IoServiceArgs iosvArgs;
+   iosvArgs.ThreadCount_ = 1;
+   IoService::MakeResult   err;
+   IoServiceSP iosv = IoService::MakeService(iosvArgs, "RecvBatch", err);
+   if (!iosv) {
+      std::cout << "|IoService.MakeService|" << fon9::RevPrintTo<std::string>(err) << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   fon9::io::ManagerCSP mgr{new fon9::io::SimpleManager{}};
+   fon9::intrusive_ptr<RecvBatchSession> ses{new RecvBatchSession};
+   fon9::io::DeviceSP   dev{new Dgram(iosv, ses, mgr)};
+   dev->Initialize();
+   dev->AsyncOpen("Bind=127.0.0.1:" + std::to_string(kPort) + "|RecvBatch=" + std::to_string(kBatchCount));
+   dev->WaitGetDeviceId();
+   while (!ses->IsLinkReady_)
+      std::this_thread::yield();
+
+   struct sockaddr_in dst;
+   memset(&dst, 0, sizeof(dst));
+   dst.sin_family = AF_INET;
+   dst.sin_port = htons(kPort);
+   dst.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   fon9::FdrAuto so{::socket(AF_INET, SOCK_DGRAM, 0)};
+   auto fnSend = [&so, &dst](unsigned idx) {
+      const std::string msg = "pk" + std::to_string(idx);
+      ::sendto(so.GetFD(), msg.data(), msg.size(), 0, reinterpret_cast<struct sockaddr*>(&dst), sizeof(dst));
+   };
+   // 第1個封包: io thread 在 OnDevice_Recv() 等候, 此時送出的 (kBatchCount - 1) 個封包會在 kernel 排隊.
+   fnSend(0);
+   while (ses->RecvEvents_ == 0)
+      std::this_thread::yield();
+   for (unsigned L = 1; L < kBatchCount; ++L)
+      fnSend(L);
+   ses->IsAllSent_ = true;
+   for (unsigned ms = 0; ses->RecvCount_ < kBatchCount && ms < 1000; ++ms)
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+
+   const std::string info = dev->WaitGetDeviceInfo();
+   dev->AsyncDispose("TestRecvBatch");
+   dev->WaitGetDeviceId();
+   const std::string expectedInfo = "RecvBatch=" + std::to_string(kBatchCount) + "/2";
+   if (ses->RecvCount_ != kBatchCount || ses->RecvPkCounts_.size() != 2
+       || ses->RecvPkCounts_[1] != kBatchCount - 1
+       || info.find(expectedInfo) == std::string::npos) {
+      std::cout << "|recvCount=" << ses->RecvCount_ << "|recvEvents=" << ses->RecvPkCounts_.size()
+         << "|info=" << info << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "|" << expectedInfo << "\r[OK   ]" << std::endl;
+}
+
+/// 測試 "Engine=uring" 的完成式讀寫(READV/WRITEV):
+/// TcpServer(PingpongSession) 將收到的資料送回, TcpClient 檢查送回的資料是否與送出的相同.
+class RingEchoClient : public fon9::io::Session {
+   fon9_NON_COPY_NON_MOVE(RingEchoClient);
+   fon9::io::RecvBufferSize OnDevice_LinkReady(fon9::io::Device&) override {
+      this->IsLinkReady_ = true;
+      return fon9::io::RecvBufferSize::Default;
+   }
+   fon9::io::RecvBufferSize OnDevice_Recv(fon9::io::Device&, fon9::DcQueue& rxbuf) override {
+      fon9::BufferAppendTo(rxbuf.MoveOutToList(), this->Received_);
+      this->RecvBytes_ = this->Received_.size();
+      return fon9::io::RecvBufferSize::Default;
+   }
+public:
+   RingEchoClient() = default;
+   std::atomic<bool>    IsLinkReady_{false};
+   std::atomic<size_t>  RecvBytes_{0};
+   /// 僅在 io thread 存取, 收完之後才由測試端檢查.
+   std::string          Received_;
+};
+static void TestRingEcho() {
+   std::cout << "[TEST ] FdrServiceUring.Echo";
+   fon9::io::IoServiceArgs iosvArgs;
+   iosvArgs.ThreadCount_ = 1;
+   fon9::io::FdrServiceUring::MakeResult err;
+   IoServiceSP iosv = fon9::io::FdrServiceUring::MakeService(iosvArgs, "RingEcho", err);
+   if (!iosv) {
+      std::cout << "|MakeService|" << fon9::RevPrintTo<std::string>(err) << "\r[SKIP ]" << std::endl;
+      return;
+   }
+   fon9::io::ManagerCSP mgr{new fon9::io::SimpleManager{}};
+   PingpongSP           sesServer{new PingpongSession{false}};
+   fon9::io::DeviceSP   server{new TcpServer(iosv, sesServer, mgr)};
+   server->Initialize();
+   server->AsyncOpen("19382");
+   server->WaitGetDeviceId();
+
+   fon9::intrusive_ptr<RingEchoClient> sesClient{new RingEchoClient};
+   fon9::io::DeviceSP   client{new TcpClient(iosv, sesClient, mgr)};
+   client->Initialize();
+   client->AsyncOpen("127.0.0.1:19382");
+   for (unsigned ms = 0; !sesClient->IsLinkReady_ && ms < 1000; ++ms)
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+
+   // 各種大小的資料, 輪流使用 SendASAP(), SendBuffered();
+   // 最後的 1MB 超過 socket 緩衝區, 會分成多次 WRITEV, READV 完成.
+   std::string expected;
+   for (unsigned L = 0; L <= 100; ++L) {
+      const size_t sz = (L == 100 ? 1024 * 1024 : (L * 997) % 5000 + 1);
+      std::string  msg(sz, '\0');
+      for (size_t i = 0; i < sz; ++i)
+         msg[i] = static_cast<char>('A' + (L + i) % 26);
+      if (L % 2)
+         client->SendASAP(msg.data(), msg.size());
+      else
+         client->SendBuffered(msg.data(), msg.size());
+      expected.append(msg);
+   }
+   for (unsigned ms = 0; sesClient->RecvBytes_ < expected.size() && ms < 5000; ++ms)
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+
+   const size_t recvBytes = sesClient->RecvBytes_;
+   client->AsyncDispose("TestRingEcho");
+   client->WaitGetDeviceId();
+   server->AsyncDispose("TestRingEcho");
+   server->WaitGetDeviceId();
+   if (!sesClient->IsLinkReady_ || recvBytes != expected.size() || sesClient->Received_ != expected) {
+      std::cout << "|isLinkReady=" << sesClient->IsLinkReady_
+         << "|sent=" << expected.size() << "|recv=" << recvBytes << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "|bytes=" << recvBytes << "\r[OK   ]" << std::endl;
+}
+
+/// Loopback 來回延遲(round trip), 用來比較 "Engine=epoll" 與 "Engine=uring":
+/// TcpClient 送出 msgSize bytes, TcpServer(PingpongSession) 送回,
+/// TcpClient 收完之後(在 io thread) 立即送出下一筆.
+class RoundtripClient : public fon9::io::Session {
+   fon9_NON_COPY_NON_MOVE(RoundtripClient);
+   fon9::io::RecvBufferSize OnDevice_LinkReady(fon9::io::Device&) override {
+      this->IsLinkReady_ = true;
+      return fon9::io::RecvBufferSize::Default;
+   }
+   fon9::io::RecvBufferSize OnDevice_Recv(fon9::io::Device& dev, fon9::DcQueue& rxbuf) override {
+      this->PendingBytes_ -= rxbuf.CalcSize();
+      rxbuf.PopConsumedAll();
+      if (this->PendingBytes_ == 0) {
+         if (++this->Count_ >= this->Times_)
+            this->IsDone_ = true;
+         else
+            this->SendNext(dev);
+      }
+      return fon9::io::RecvBufferSize::Default;
+   }
+public:
+   const unsigned       Times_;
+   const std::string    Msg_;
+   size_t               PendingBytes_{0};
+   unsigned             Count_{0};
+   std::atomic<bool>    IsLinkReady_{false};
+   std::atomic<bool>    IsDone_{false};
+   RoundtripClient(unsigned times, size_t msgSize) : Times_{times}, Msg_(msgSize, 'x') {
+   }
+   void SendNext(fon9::io::Device& dev) {
+      this->PendingBytes_ = this->Msg_.size();
+      dev.SendASAP(this->Msg_.data(), this->Msg_.size());
+   }
+};
+static double GetCpuTimeUS() {
+   struct rusage ru;
+   getrusage(RUSAGE_SELF, &ru);
+   return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e6 + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec);
+}
+void BenchRoundtrip(const char* iosvCfg, unsigned times, size_t msgSize) {
+   fon9::io::IoServiceArgs iosvArgs;
+   fon9::RevBufferList     rbuf{128};
+   if (!fon9::ParseConfig(iosvArgs, fon9::StrView_cstr(iosvCfg), rbuf)) {
+      std::cout << "IoServiceArgs.Parse|" << fon9::BufferTo<std::string>(rbuf.MoveOut()) << std::endl;
+      return;
+   }
+   IoService::MakeResult   err;
+   IoServiceSP iosv = IoService::MakeService(iosvArgs, "BenchRoundtrip", err);
+   if (!iosv) {
+      std::cout << "IoService.MakeService|" << fon9::RevPrintTo<std::string>(err) << std::endl;
+      return;
+   }
+   fon9::io::ManagerCSP mgr{new fon9::io::SimpleManager{}};
+   PingpongSP           sesServer{new PingpongSession{false}};
+   fon9::io::DeviceSP   server{new TcpServer(iosv, sesServer, mgr)};
+   server->Initialize();
+   server->AsyncOpen("19383");
+   server->WaitGetDeviceId();
+
+   fon9::intrusive_ptr<RoundtripClient> sesClient{new RoundtripClient{times, msgSize}};
+   fon9::io::DeviceSP   client{new TcpClient(iosv, sesClient, mgr)};
+   client->Initialize();
+   client->AsyncOpen("127.0.0.1:19383");
+   for (unsigned ms = 0; !sesClient->IsLinkReady_ && ms < 1000; ++ms)
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+
+   const double    cpuBeg = GetCpuTimeUS();
+   fon9::StopWatch stopWatch;
+   sesClient->SendNext(*client);
+   while (!sesClient->IsDone_)
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+   const double span = stopWatch.StopTimer();
+   const double cpuUS = GetCpuTimeUS() - cpuBeg;
+
+   client->AsyncDispose("BenchRoundtrip");
+   client->WaitGetDeviceId();
+   server->AsyncDispose("BenchRoundtrip");
+   server->WaitGetDeviceId();
+   const std::string msg = std::string{iosvCfg} + "|msgSize=" + std::to_string(msgSize) + "|Roundtrip";
+   stopWatch.PrintResultNoEOL(span, msg.c_str(), times)
+      << "|cpu=" << cpuUS * 1000 / times << " ns/roundtrip" << std::endl;
+}
+#endif
+
+//--------------------------------------------------------------------------//
+
 int main(int argc, const char** argv) {
+#ifdef __linux__
+   if (argc < 2) {
+      fon9::AutoPrintTestInfo utinfo("IoDev.Fdr");
+      TestRecvBatch();
+      TestRingEcho();
+      return 0;
+   }
+#endif
+#ifndef fon9_WINDOWS
+   if (argc >= 2 && argv[1][0] == 'b') {
+      fon9::AutoPrintTestInfo utinfo("IoDev.BenchPendingReqs");
+      BenchPendingReqs(argc >= 3 ? argv[2] : "");
+      return 0;
+   }
+#endif
+#ifdef __linux__
+   if (argc >= 3 && argv[1][0] == 'r') {
+      fon9::AutoPrintTestInfo utinfo("IoDev.BenchRoundtrip");
+      BenchRoundtrip(argv[2],
+                     argc >= 4 ? fon9::StrTo(fon9::StrView_cstr(argv[3]), 100000u) : 100000u,
+                     argc >= 5 ? fon9::StrTo(fon9::StrView_cstr(argv[4]), size_t{64}) : size_t{64});
+      return 0;
+   }
+#endif
    if (argc < 3) {
 __USAGE:
       std::cout << R"**(
@@ -165,6 +519,10 @@ Usage:
     c "TcpClientConfigs" "IoServiceConfigs"
     s "TcpServerConfigs"
     u "DgramConfigs(UDP or Multicast)" "IoServiceConfigs"
+    b "IoServiceConfigs"    Benchmark: multi-thread StartSendInFdrThread().
+    r "IoServiceConfigs" [times] [msgSize]
+                            Linux: loopback TCP round trip, e.g. compare "Engine=epoll" and "Engine=uring".
+    (no args)               Linux: test FdrDgram "RecvBatch=n", FdrServiceUring READV/WRITEV.
 
 e.g.
     c "127.0.0.1:9000|Timeout=30" "ThreadCount=2|Wait=Block|Cpus="
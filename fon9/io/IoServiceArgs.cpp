@@ -18,6 +18,22 @@ ConfigParser::Result IoServiceArgs::OnTagValue(StrView tag, StrView& value) {
    }
    else if (tag == "Capacity")
       this->Capacity_ = StrTo(value, 0u);
+   else if (tag == "IdleSpin")
+      this->IdleSpin_ = StrTo(value, 0u);
+   else if (tag == "IdleSleep")
+      this->IdleSleepUS_ = StrTo(value, 0u);
+   else if (tag == "BusyPoll")
+      this->BusyPollUS_ = StrTo(value, 0u);
+   else if (tag == "Engine") {
+      if (value == "epoll")
+         this->Engine_ = IoEngine::Epoll;
+      else if (value == "uring")
+         this->Engine_ = IoEngine::Uring;
+      else {
+         this->Engine_ = IoEngine::Default;
+         return ConfigParser::Result::EInvalidValue;
+      }
+   }
    else if (tag == "Wait") {
       if ((this->HowWait_ = StrToHowWait(value)) == HowWait::Unknown) {
          this->HowWait_ = HowWait::Block;
@@ -56,7 +72,10 @@ void ServiceThreadArgs::OnThrRunBegin(StrView msgHead) const {
       "|index=", this->ThreadPoolIndex_ + 1,
       "|Cpu=", this->CpuAffinity_, ':', cpuAffinityResult,
       "|Wait=", HowWaitToStr(this->HowWait_),
-      "|Capacity=", this->Capacity_);
+      "|Capacity=", this->Capacity_,
+      "|IdleSpin=", this->IdleSpin_,
+      "|IdleSleep=", this->IdleSleepUS_,
+      "|BusyPoll=", this->BusyPollUS_);
    fon9_LOG_ThrRun(thrName);
    SetCurrentThreadName(thrName.c_str());
 }
@@ -4,6 +4,7 @@
 #define __fon9_io_IoServiceArgs_hpp__
 #include "fon9/ConfigParser.hpp"
 #include "fon9/Tools.hpp"
+#include "fon9/SleepPolicy.hpp"
 
 fon9_BEFORE_INCLUDE_STD;
 #include <thread>
@@ -12,9 +13,21 @@ fon9_AFTER_INCLUDE_STD;
 
 namespace fon9 { namespace io {
 
+/// \ingroup io
+/// io service 使用的事件偵測機制.
+enum class IoEngine : uint8_t {
+   /// 由 io service 自行決定, 在 Linux = Epoll.
+   Default,
+   Epoll,
+   /// Linux io_uring.
+   Uring,
+};
+
 /// \ingroup io
 /// args: "ThreadCount=n|Wait=Policy|Cpus=List|Capacity=0"
 /// Policy: Block(default)
+/// - Engine: 在 Linux 可選擇 "epoll"(default) 或 "uring"(io_uring; 若系統不支援, 則改用 epoll).
+/// - 低延遲(獨占 cpu)的設定例: "ThreadCount=1|Wait=Busy|Cpus=3|BusyPoll=50|IdleSpin=100000|IdleSleep=10"
 struct fon9_API IoServiceArgs {
    /// 若有設定 CpuAffinity, 則每個 io service thread 會綁定一個固定的 cpu, 而不是所有的 thread 共用這裡設定的 cpu.
    /// 例如: ThreadCount_=3; CpuAffinity=0,1;
@@ -30,6 +43,17 @@ struct fon9_API IoServiceArgs {
    /// 0 = 由 io service 自行決定最佳值.
    size_t   Capacity_{0};
 
+   /// 當 HowWait_ 為 Busy or Yield 時(不會在 epoll_wait() 等候事件):
+   /// 連續 IdleSpin_ 次沒有事件之後, 才開始退讓(back-off).
+   /// 0 = 每次沒有事件都退讓: Yield = std::this_thread::yield(); Busy = 不退讓.
+   uint32_t IdleSpin_{0};
+   /// 退讓時的沉睡時間(microseconds), 0 = 依照 HowWait_ 決定退讓方式.
+   uint32_t IdleSleepUS_{0};
+   /// > 0: 在 socket 加入 io service thread 時, 設定 SO_BUSY_POLL(microseconds).
+   /// 通常需要 CAP_NET_ADMIN 權限.
+   uint32_t BusyPollUS_{0};
+   IoEngine Engine_{IoEngine::Default};
+
    IoServiceArgs() = default;
 
    int GetCpuAffinity(size_t threadPoolIndex) const {
@@ -45,6 +69,10 @@ struct fon9_API IoServiceArgs {
    /// Capacity    | >= 0
    /// Wait        | "Block" or "Busy" or "Yield"
    /// Cpus        | c0, c1, c2 ... 根據 thread pool index 依序選擇 c0 或 c1 或 c2...
+   /// IdleSpin    | >= 0
+   /// IdleSleep   | >= 0 microseconds
+   /// BusyPoll    | >= 0 microseconds
+   /// Engine      | "epoll" or "uring"
    ConfigParser::Result OnTagValue(StrView tag, StrView& value);
 };
 
@@ -56,6 +84,9 @@ struct fon9_API ServiceThreadArgs {
    int         CpuAffinity_;
    HowWait     HowWait_;
    size_t      Capacity_;
+   uint32_t    IdleSpin_;
+   uint32_t    IdleSleepUS_;
+   uint32_t    BusyPollUS_;
 
    ServiceThreadArgs() = default;
    ServiceThreadArgs(const IoServiceArgs& ioArgs, const std::string& name, size_t index)
@@ -63,12 +94,30 @@ struct fon9_API ServiceThreadArgs {
       , ThreadPoolIndex_{index}
       , CpuAffinity_{ioArgs.GetCpuAffinity(index)}
       , HowWait_{ioArgs.HowWait_}
-      , Capacity_{ioArgs.Capacity_} {
+      , Capacity_{ioArgs.Capacity_}
+      , IdleSpin_{ioArgs.IdleSpin_}
+      , IdleSleepUS_{ioArgs.IdleSleepUS_}
+      , BusyPollUS_{ioArgs.BusyPollUS_} {
    }
 
    /// - 透過 fon9_LOG_ThrRun(msgHead, ".ThrRun|name=", this->Name_...) 記錄 log.
    /// - if (this->CpuAffinity_ >= 0) 設定 cpu affinity.
    void OnThrRunBegin(StrView msgHead) const;
+
+   /// 非 Block 模式, 一次輪詢沒有事件時呼叫, 依照設定退讓:
+   /// - 連續 IdleSpin_ 次沒有事件之前: 不退讓, 僅累計 idleCount;
+   /// - IdleSleepUS_ > 0: MicroSleepPolicy{IdleSleepUS_};
+   /// - HowWait_ == Yield: YieldSleepPolicy; 否則(Busy): BusySleepPolicy;
+   void OnIdle(uint32_t& idleCount) const {
+      if (idleCount < this->IdleSpin_)
+         ++idleCount;
+      else if (this->IdleSleepUS_ > 0)
+         MicroSleepPolicy{this->IdleSleepUS_}.Sleep();
+      else if (this->HowWait_ == HowWait::Yield)
+         YieldSleepPolicy::Sleep();
+      else
+         BusySleepPolicy::Sleep();
+   }
 };
 
 } } // namespaces
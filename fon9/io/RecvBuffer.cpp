@@ -55,5 +55,16 @@ DcQueueList& RecvBuffer::SetDataReceived(size_t rxsz) {
    }
    return this->Queue_;
 }
+DcQueueList& RecvBuffer::SetBatchReceived(FwdBufferNode** nodes, size_t count) {
+   assert(this->State_ == RecvBufferState::NotInUse);
+   this->State_ = RecvBufferState::InvokingEvent;
+   for (; count > 0; --count, ++nodes) {
+      if ((*nodes)->GetDataSize() > 0) {
+         this->Queue_.push_back(*nodes);
+         *nodes = nullptr;
+      }
+   }
+   return this->Queue_;
+}
 
 } } // namespace
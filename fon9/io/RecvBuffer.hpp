@@ -89,6 +89,14 @@ public:
    /// \return 存放接收資料的 DcQueueList.
    DcQueueList& SetDataReceived(size_t rxsz);
 
+   /// 批次接收(例: recvmmsg()) 完成: 每個封包(datagram)各自放在一個由呼叫端分配的區塊.
+   /// - 依序將有資料的 nodes[i] 加入接收佇列, 並設定 nodes[i] = nullptr;
+   ///   沒有資料的 nodes[i] 保留給呼叫端.
+   /// - 然後進入 RecvBufferState::InvokingEvent 狀態.
+   /// - 每個封包在 DcQueueList 裡面是各自獨立的區塊, 可用來判斷封包的邊界.
+   /// \return 存放接收資料的 DcQueueList.
+   DcQueueList& SetBatchReceived(FwdBufferNode** nodes, size_t count);
+
    /// 僅能在 OnDevice_Recv() 事件之後呼叫一次.
    void SetContinueRecv() {
       assert(this->IsInvokingEvent());
@@ -3,6 +3,7 @@
 #include "fon9/rc/RcMdRtsDecoder.hpp"
 #include "fon9/fmkt/SymbDealData.hpp"
 #include "fon9/fmkt/SymbBSData.hpp"
+#include "fon9/fmkt/SymbBarData.hpp"
 #include "fon9/fmkt/SymbTabNames.h"
 #include "fon9/seed/RawWr.hpp"
 #include "fon9/BitvDecode.hpp"
@@ -112,6 +113,11 @@ RcMdRtsDecoder_TabFields::RcMdRtsDecoder_TabFields(svc::TreeRec& tree) {
          break;
       }
    }
+   // K 線: 欄位由 Server 端的週期設定決定, 每個週期 fmkt::kSymbBarFieldCount 個欄位.
+   if ((tab = GetTabOrNull(*tree.Layout_, fon9_kCSTR_TabName_Bars)) == nullptr)
+      this->TabIdxBars_ = f9sv_TabSize_Null;
+   else
+      this->TabIdxBars_ = static_cast<f9sv_TabSize>(tab->GetIndex());
 }
 void RcMdRtsDecoder_TabFields::SetBSFields(FieldPQList& dst, const seed::Fields& flds, char ch1, char ch2) {
    dst.reserve(fmkt::SymbBSData::kBSCount);
@@ -346,6 +352,15 @@ struct RcSvStreamDecoder_MdRts : public RcMdRtsDecoder {
       }
       case f9sv_RtsPackType_UpdateBS:
          return this->DecodeUpdateBS(rx, rpt, rxbuf);
+      case f9sv_RtsPackType_SnapshotBook:
+      {
+         InfoAux  aux{rx, rpt, rxbuf, this->TabIdxBS_};
+         if (this->IsBSMktSeqNewer(aux, rx, rxbuf))
+            this->DecodeSnapshotBook(std::move(aux), rx, rpt, rxbuf);
+         return;
+      }
+      case f9sv_RtsPackType_UpdateBook:
+         return this->DecodeUpdateBook(rx, rpt, rxbuf);
       case f9sv_RtsPackType_DealBS:
          return this->DecodeDealBS(rx, rpt, rxbuf);
 
@@ -369,6 +384,10 @@ struct RcSvStreamDecoder_MdRts : public RcMdRtsDecoder {
          return this->DecodeTabValues_NoInfoTime(rx, rpt, rxbuf);
       case f9sv_RtsPackType_TabValues_AndInfoTime:
          return this->DecodeTabValues_AndInfoTime(rx, rpt, rxbuf);
+      case f9sv_RtsPackType_BarClosed:
+         return this->DecodeBars(rx, rpt, rxbuf, false);
+      case f9sv_RtsPackType_BarUpdate:
+         return this->DecodeBars(rx, rpt, rxbuf, true);
       case f9sv_RtsPackType_Count: // 增加此 case 僅是為了避免警告.
          break;
       }
@@ -673,6 +692,109 @@ struct RcSvStreamDecoder_MdRts : public RcMdRtsDecoder {
       this->ReportBS(rx, rpt, aux.RawWr_, bsFlags);
    }
    // -----
+   /// 取出 Pri(Bitv), Qty(Bitv) 但不使用: 發行端的檔位數量超過訂閱端的欄位數量.
+   static void BitvSkipPQ(DcQueue& rxbuf, bool hasPri) {
+      fmkt::PriQty pq;
+      if (hasPri)
+         BitvTo(rxbuf, pq.Pri_);
+      BitvTo(rxbuf, pq.Qty_);
+   }
+   void DecodeSnapshotBookSide(svc::RxSubrData& rx, const seed::RawWr& wr, const FieldPQList& flds, DcQueue& rxbuf) {
+      unsigned count{0};
+      BitvTo(rxbuf, count);
+      auto ifld = flds.cbegin();
+      for (; count > 0; --count) {
+         if (fon9_UNLIKELY(ifld == flds.cend())) {
+            BitvSkipPQ(rxbuf, true);
+            continue;
+         }
+         ifld->FldPri_->BitvToCell(wr, rxbuf);
+         ifld->FldQty_->BitvToCell(wr, rxbuf);
+         if (fon9_UNLIKELY(rx.IsNeedsLog_)) {
+            RevPrint(rx.LogBuf_, '|');
+            RevPrintPQ(rx.LogBuf_, *ifld, wr);
+         }
+         ++ifld;
+      }
+      this->ClearFieldPQs(wr, ifld, flds.cend());
+   }
+   void DecodeSnapshotBook(InfoAux&& aux, svc::RxSubrData& rx, f9sv_ClientReport& rpt, DcQueue& rxbuf) {
+      aux.PutDecField(*this->FldBSInfoTime_, *aux.SeInfoTime_);
+      const f9sv_BSFlag bsFlags = static_cast<f9sv_BSFlag>(ReadOrRaise<uint8_t>(rxbuf));
+      if (fon9_UNLIKELY(rx.IsNeedsLog_))
+         RevPrint(rx.LogBuf_, "|rtBook=", ToHex(cast_to_underlying(bsFlags)));
+      if (IsEnumContains(bsFlags, f9sv_BSFlag_OrderSell))
+         this->DecodeSnapshotBookSide(rx, aux.RawWr_, this->FldOrderSells_, rxbuf);
+      else
+         this->ClearFieldPQs(aux.RawWr_, this->FldOrderSells_.cbegin(), this->FldOrderSells_.cend());
+      if (IsEnumContains(bsFlags, f9sv_BSFlag_OrderBuy))
+         this->DecodeSnapshotBookSide(rx, aux.RawWr_, this->FldOrderBuys_, rxbuf);
+      else
+         this->ClearFieldPQs(aux.RawWr_, this->FldOrderBuys_.cbegin(), this->FldOrderBuys_.cend());
+      this->ReportBS(rx, rpt, aux.RawWr_, bsFlags);
+   }
+   void DecodeUpdateBook(svc::RxSubrData& rx, f9sv_ClientReport& rpt, DcQueue& rxbuf) {
+      InfoAux  aux(rx, rpt, rxbuf, this->TabIdxBS_);
+      if (!this->IsBSMktSeqNewer(aux, rx, rxbuf))
+         return;
+      aux.PutDecField(*this->FldBSInfoTime_, *aux.SeInfoTime_);
+      const uint8_t first = ReadOrRaise<uint8_t>(rxbuf);
+      f9sv_BSFlag   bsFlags{};
+      if (first & 0x80)
+         bsFlags |= f9sv_BSFlag_Calculated;
+      unsigned           count = (first & 0x7fu);
+      const FieldPQList* flds;
+      for (;;) {
+         const uint8_t bsType = ReadOrRaise<uint8_t>(rxbuf);
+         switch (static_cast<fmkt::RtBSType>(bsType & cast_to_underlying(fmkt::RtBSType::Mask))) {
+         case_RtBSType(OrderBuy);
+         case_RtBSType(OrderSell);
+         default:
+            assert(!"Unknown RtBSType.");
+            fon9_LOG_ERROR("DecodeUpdateBook|err=Unknown RtBSType|rtBS=", ToHex(bsType));
+            return;
+         }
+         unsigned lv{0};
+         BitvTo(rxbuf, lv);
+         const auto act = static_cast<fmkt::RtBSAction>(bsType & cast_to_underlying(fmkt::RtBSAction::Mask));
+         if (fon9_UNLIKELY(lv >= flds->size())) {
+            // 發行端的檔位比訂閱端的欄位多: 略過此檔位.
+            if (act != fmkt::RtBSAction::Delete)
+               BitvSkipPQ(rxbuf, act != fmkt::RtBSAction::ChangeQty);
+         }
+         else {
+            const auto iLv = flds->cbegin() + lv;
+            switch (act) {
+            case fmkt::RtBSAction::New:
+               InsertPQ(aux.RawWr_, iLv, flds->cend());
+               /* fall through */ // 繼續取出 rxbuf 裡面的 Pri,Qty; 填入 iLv;
+            case fmkt::RtBSAction::ChangePQ:
+               iLv->FldPri_->BitvToCell(aux.RawWr_, rxbuf);
+               iLv->FldQty_->BitvToCell(aux.RawWr_, rxbuf);
+               if (fon9_UNLIKELY(rx.IsNeedsLog_))
+                  RevPrintPQ(rx.LogBuf_, *iLv, aux.RawWr_);
+               break;
+            case fmkt::RtBSAction::ChangeQty:
+               iLv->FldQty_->BitvToCell(aux.RawWr_, rxbuf);
+               if (fon9_UNLIKELY(rx.IsNeedsLog_))
+                  iLv->FldQty_->CellRevPrint(aux.RawWr_, nullptr, rx.LogBuf_);
+               break;
+            case fmkt::RtBSAction::Delete:
+               DeletePQ(aux.RawWr_, iLv, flds->cend());
+               break;
+            }
+         }
+         if (fon9_UNLIKELY(rx.IsNeedsLog_))
+            RevPrint(rx.LogBuf_, "|rtBook.", ToHex(bsType), '.', lv, '=');
+         if (count <= 0)
+            break;
+         --count;
+      }
+      assert(count == 0 && rxbuf.empty());
+      // -----
+      this->ReportBS(rx, rpt, aux.RawWr_, bsFlags);
+   }
+   // -----
    bool IsFldDealMktSeqNewer(const InfoAux& aux, svc::RxSubrData& rx, DcQueue& rxbuf) const {
       if (!this->FldDealMktSeq_)
          return true;
@@ -894,6 +1016,37 @@ struct RcSvStreamDecoder_MdRts : public RcMdRtsDecoder {
       BitvToDayTimeOrUnchange(rxbuf, *note->SelectInfoTime(rx));
       DecodeTabValues_NoInfoTime(rx, rpt, rxbuf);
    }
+   // -----
+   /// 每根 K 線觸發一次 FnOnReport_,
+   /// 可用 rpt.StreamPackType_ 判斷是「已完成(BarClosed)」或「尚未完成(BarUpdate)」的 K 線.
+   void DecodeBars(svc::RxSubrData& rx, f9sv_ClientReport& rpt, DcQueue& rxbuf, bool isRtOnly) {
+      if (this->TabIdxBars_ == f9sv_TabSize_Null)
+         return;
+      NoteAux aux{rx, rpt};
+      if (!isRtOnly)
+         BitvToDayTimeOrUnchange(rxbuf, *aux.Note_.SelectInfoTime(rx));
+      else { // BarUpdate 不影響 InfoTime.
+         DayTime infoTime{DayTime::Null()};
+         BitvTo(rxbuf, infoTime);
+      }
+      auto  fnOnReport = rx.SubrRec_->SubrHandler_.FnOnReport_;
+      auto* tab = rx.SubrRec_->Tree_->Layout_->GetTab(this->TabIdxBars_);
+      seed::SimpleRawWr wr{SetRptTabSeed(rpt, this->TabIdxBars_)};
+      while (!rxbuf.empty()) {
+         const unsigned fldidx = ReadOrRaise<uint8_t>(rxbuf) * fmkt::kSymbBarFieldCount;
+         if (fon9_UNLIKELY(tab->Fields_.Get(fldidx + fmkt::kSymbBarFieldCount - 1) == nullptr)) {
+            RevPrint(rx.LogBuf_, "|barFldIdx=", fldidx, "|err=Unknown bar fields");
+            rx.FlushLog();
+            return;
+         }
+         for (unsigned L = 0; L < fmkt::kSymbBarFieldCount; ++L)
+            this->FieldBitvToCell(rx, rxbuf, tab->Fields_.Get(fldidx + L), wr);
+         if (fon9_UNLIKELY(rx.IsNeedsLog_))
+            rx.FlushLog();
+         if (fnOnReport)
+            fnOnReport(&rx.Session_, &rpt);
+      }
+   }
 };
 
 } } // namespaces
@@ -19,6 +19,8 @@ struct RcMdRtsDecoder_TabFields_POD {
    f9sv_TabSize         TabIdxDeal_;
    f9sv_TabSize         TabIdxBase_;
    f9sv_TabSize         TabIdxRef_;
+   f9sv_TabSize         TabIdxBars_;
+   char                 Padding___[4];
 
    const seed::Field*   FldBaseTDay_;
    const seed::Field*   FldBaseSession_;
@@ -5,6 +5,7 @@
 #include "fon9/rc/RcFuncConnServer.hpp"
 #include "fon9/auth/PolicyAcl.hpp"
 #include "fon9/seed/FieldMaker.hpp"
+#include "fon9/LatencyHist.hpp"
 
 #ifdef _DEBUG
 // 通知 Server 端暫停執行訂閱, 等收到[取消訂閱]後, 才執行上次暫停的[訂閱要求].
@@ -19,7 +20,10 @@ RcSeedVisitorServerAgent::~RcSeedVisitorServerAgent() {
 RcFunctionNoteSP RcSeedVisitorServerAgent::OnCreateRcSeedVisitorServerNote(RcSession& ses,
                                                                            const auth::AuthResult& authr,
                                                                            seed::AclConfig&& aclcfg) {
-   return RcFunctionNoteSP{new RcSeedVisitorServerNote(ses, authr, std::move(aclcfg))};
+   auto* note = new RcSeedVisitorServerNote(ses, authr, std::move(aclcfg));
+   if (this->ConflateBusyBytes_)
+      note->ConflateBusyBytes_ = this->ConflateBusyBytes_;
+   return RcFunctionNoteSP{note};
 }
 void RcSeedVisitorServerAgent::OnRecvFunctionCall(RcSession& ses, RcFunctionParam& param) {
    (void)param;
@@ -90,6 +94,32 @@ struct RcSeedVisitorServerNote::SeedVisitor : public seed::SeedVisitor {
    }
 };
 //--------------------------------------------------------------------------//
+/// 放在訂閱資料之後, 當 device 送出訂閱資料後, 從 SentBytes_ 扣除.
+struct RcSeedVisitorServerNote::SentNode : public BufferNodeVirtual {
+   fon9_NON_COPY_NON_MOVE(SentNode);
+   using base = BufferNodeVirtual;
+   friend class BufferNode;// for BufferNode::Alloc();
+protected:
+   const SentBytesSP SentBytes_;
+   const uint64_t    Bytes_;
+   SentNode(BufferNodeSize blockSize, StyleFlag style, SentBytesSP sentBytes, uint64_t bytes)
+      : base(blockSize, style)
+      , SentBytes_{std::move(sentBytes)}
+      , Bytes_{bytes} {
+   }
+   void OnBufferConsumed() override {
+      this->SentBytes_->PendingBytes_.fetch_sub(this->Bytes_, std::memory_order_relaxed);
+   }
+   void OnBufferConsumedErr(const ErrC&) override {
+      this->SentBytes_->PendingBytes_.fetch_sub(this->Bytes_, std::memory_order_relaxed);
+   }
+public:
+   static SentNode* Alloc(SentBytesSP sentBytes, uint64_t bytes) {
+      sentBytes->PendingBytes_.fetch_add(bytes, std::memory_order_relaxed);
+      return base::Alloc<SentNode>(0, StyleFlag::AllowCrossing, std::move(sentBytes), bytes);
+   }
+};
+//--------------------------------------------------------------------------//
 RcSeedVisitorServerNote::RcSeedVisitorServerNote(RcSession& ses,
                                                  const auth::AuthResult& authr,
                                                  seed::AclConfig&& aclcfg)
@@ -98,7 +128,8 @@ RcSeedVisitorServerNote::RcSeedVisitorServerNote(RcSession& ses,
    , FcRecover_(aclcfg.FcRecover_.FcCount_ * 1000u,
                 TimeInterval_Millisecond(aclcfg.FcRecover_.FcTimeMS_),
                 aclcfg.FcRecover_.FcTimeMS_ /* 讓時間分割單位=1ms */)
-   , Visitor_{new SeedVisitor(ses.GetDevice(), authr, std::move(aclcfg))} {
+   , Visitor_{new SeedVisitor(ses.GetDevice(), authr, std::move(aclcfg))}
+   , SentBytes_{new SentBytes} {
 }
 RcSeedVisitorServerNote::~RcSeedVisitorServerNote() {
 }
@@ -388,6 +419,8 @@ void RcSeedVisitorServerNote::OnSubscribeNotify(RcSvsSubrSP preg, const seed::Se
    case seed::SeedNotifyKind::StreamRecoverEnd:
       if (auto* note = static_cast<RcSeedVisitorServerNote*>(ses.GetNote(f9rc_FunctionCode_SeedVisitor))) {
          assert(dynamic_cast<const seed::SeedNotifyStreamRecoverArgs*>(&e) != nullptr);
+         // 同一個 RcSession 的回補要求, 由發行者(例: MdRtRecoverSch)公平分配回補資源.
+         static_cast<const seed::SeedNotifyStreamRecoverArgs*>(&e)->FlowControlKey_ = &ses;
          const auto gvsz = PutGridViewBuffer(ackbuf, *static_cast<const seed::SeedNotifyStreamRecoverArgs*>(&e));
          TimeInterval fc = note->FcRecover_.CalcUsed(UtcNow(), gvsz + 16);
          if (!fc.IsZero() && e.NotifyKind_ != seed::SeedNotifyKind::StreamRecoverEnd) {
@@ -400,11 +433,31 @@ void RcSeedVisitorServerNote::OnSubscribeNotify(RcSvsSubrSP preg, const seed::Se
          goto __CHECK_PUT_KEY_FOR_SUBR_TREE;
       }
       return;
+   case seed::SeedNotifyKind::StreamData:
+      if (fon9_UNLIKELY(e.Conflate_ == seed::StreamDataConflate::Allowed)) {
+         if (auto* note = static_cast<RcSeedVisitorServerNote*>(ses.GetNote(f9rc_FunctionCode_SeedVisitor))) {
+            note->IsConflating_.store(true, std::memory_order_relaxed);
+            // 尚未送出的資料量超過門檻, 告知發行者: 合併之後的異動.
+            if (note->SentBytes_->PendingBytes_.load(std::memory_order_relaxed) > note->ConflateBusyBytes_) {
+               e.Conflate_ = seed::StreamDataConflate::Busy;
+               return;
+            }
+         }
+      }
+      {  // 同一次發行的內容只打包一次, 全部訂閱者共用, 不用每個 session 各自複製.
+         const BufferShared& gvShared = e.GetGridViewShared();
+         if (gvShared.empty())
+            RevPutBitv(ackbuf, fon9_BitvV_ByteArrayEmpty);
+         else {
+            ackbuf.PushFront(gvShared.MakeRefNode());
+            ByteArraySizeToBitvT(ackbuf, gvShared.size());
+         }
+      }
+      goto __CHECK_PUT_KEY_FOR_SUBR_TREE;
    case seed::SeedNotifyKind::StreamEnd:
       preg->IsSubjectClosed_ = true;
       /* fall through */ // 繼續處理 gv 及 key 填入 ackbuf;
    case seed::SeedNotifyKind::SeedChanged:
-   case seed::SeedNotifyKind::StreamData:
       ToBitv(ackbuf, e.GetGridView());
       goto __CHECK_PUT_KEY_FOR_SUBR_TREE;
    case seed::SeedNotifyKind::PodRemoved:
@@ -424,7 +477,20 @@ void RcSeedVisitorServerNote::OnSubscribeNotify(RcSvsSubrSP preg, const seed::Se
    }
    ToBitv(ackbuf, preg->SubrIndex_);
    PutBigEndian(ackbuf.AllocBuffer(sizeof(SvFunc)), SvFuncSubscribeData(e.NotifyKind_));
-   ses.Send(f9rc_FunctionCode_SeedVisitor, std::move(ackbuf));
+   {
+      fon9_LATENCY_SCOPE("RcSvs.SendSubrData");
+      auto* note = static_cast<RcSeedVisitorServerNote*>(ses.GetNote(f9rc_FunctionCode_SeedVisitor));
+      if (fon9_LIKELY(note == nullptr || !note->IsConflating_.load(std::memory_order_relaxed)))
+         ses.Send(f9rc_FunctionCode_SeedVisitor, std::move(ackbuf));
+      else {
+         // 有合併模式的訂閱: 計算尚未送出的訂閱資料量.
+         const auto bytes = CalcDataSize(ackbuf.cfront());
+         ses.Send(f9rc_FunctionCode_SeedVisitor, std::move(ackbuf));
+         preg->Device_->Send(BufferList{SentNode::Alloc(note->SentBytes_, bytes)});
+      }
+   }
+   // 若在收到行情的 thread 直接送出, 則可記錄從收到封包到送出的時間.
+   fon9_LATENCY_SINCE_ORIGIN("TickToSend");
 }
 
 } } // namespaces
@@ -433,19 +499,28 @@ void RcSeedVisitorServerNote::OnSubscribeNotify(RcSvsSubrSP preg, const seed::Se
 #include "fon9/framework/IoManager.hpp"
 
 static bool RcSvServerAgent_Start(fon9::seed::PluginsHolder& holder, fon9::StrView args) {
+   // args = "ConflateBusyBytes=n|AddTo=RcFunctionMgr"
+   // 先解析全部參數, 再加入 AddTo 指定的 RcFunctionMgr, 所以參數順序不影響結果.
    fon9::StrView tag, value;
+   uint64_t      conflateBusyBytes = 0;
+   std::vector<fon9::rc::RcFunctionMgr*> addTo;
    while (fon9::SbrFetchTagValue(args, tag, value)) {
       if (tag == "AddTo") {
          if (fon9::rc::RcFunctionMgr* rcFuncMgr = fon9::rc::FindRcFunctionMgr(holder, value))
-            rcFuncMgr->Add(fon9::rc::RcFunctionAgentSP{new fon9::rc::RcSeedVisitorServerAgent{}});
+            addTo.push_back(rcFuncMgr);
          else
             return false;
       }
+      else if (tag == "ConflateBusyBytes") {
+         conflateBusyBytes = fon9::StrTo(value, uint64_t{0});
+      }
       else {
          holder.SetPluginsSt(fon9::LogLevel::Error, "Unknown tag=", tag);
          return false;
       }
    }
+   for (fon9::rc::RcFunctionMgr* rcFuncMgr : addTo)
+      rcFuncMgr->Add(fon9::rc::RcFunctionAgentSP{new fon9::rc::RcSeedVisitorServerAgent{conflateBusyBytes}});
    return true;
 }
 extern "C" fon9_API fon9::seed::PluginsDesc f9p_RcSvServerAgent;
@@ -15,11 +15,16 @@ class fon9_API RcSeedVisitorServerAgent : public RcFunctionAgent {
    fon9_NON_COPY_NON_MOVE(RcSeedVisitorServerAgent);
    using base = RcFunctionAgent;
 protected:
+   /// 建立 note 時, 設定 RcSeedVisitorServerNote::ConflateBusyBytes_;
+   uint64_t ConflateBusyBytes_;
+
    virtual RcFunctionNoteSP OnCreateRcSeedVisitorServerNote(RcSession& ses,
                                                             const auth::AuthResult& authr,
                                                             seed::AclConfig&& aclcfg);
 public:
-   RcSeedVisitorServerAgent() : base{f9rc_FunctionCode_SeedVisitor} {
+   RcSeedVisitorServerAgent(uint64_t conflateBusyBytes = 0)
+      : base{f9rc_FunctionCode_SeedVisitor}
+      , ConflateBusyBytes_{conflateBusyBytes} {
    }
    ~RcSeedVisitorServerAgent();
 
@@ -35,7 +40,17 @@ class fon9_API RcSeedVisitorServerNote : public RcFunctionNote {
    FlowControlCalc   FcRecover_;
    SeedVisitorSP     Visitor_;
    uint32_t          FcOverCount_{};
-   char              Padding____[4];
+   /// 是否有合併模式的訂閱(SeedNotifyArgs::Conflate_), 若有, 才需要計算尚未送出的訂閱資料量.
+   std::atomic<bool> IsConflating_{false};
+   char              Padding____[3];
+
+   /// 尚未送出的訂閱資料量, 在 device 送出後扣除.
+   struct SentBytes : public intrusive_ref_counter<SentBytes> {
+      std::atomic<uint64_t> PendingBytes_{0};
+   };
+   using SentBytesSP = intrusive_ptr<SentBytes>;
+   const SentBytesSP SentBytes_;
+   struct SentNode;
 
    using SubrListImpl = std::vector<RcSvsSubrSP>; // 索引值為 Client 端的 SubrIndex;
    using SubrList = MustLock<SubrListImpl>;
@@ -57,6 +72,11 @@ class fon9_API RcSeedVisitorServerNote : public RcFunctionNote {
    void OnRecvUnsubscribe(RcSession& ses, f9sv_SubrIndex usidx);
 
 public:
+   static constexpr uint64_t kDefaultConflateBusyBytes = 1024 * 256;
+   /// 合併模式訂閱的忙碌門檻: 若尚未送出的訂閱資料量超過此值,
+   /// 則告知發行者 seed::StreamDataConflate::Busy, 由發行者合併之後的異動.
+   uint64_t ConflateBusyBytes_{kDefaultConflateBusyBytes};
+
    RcSeedVisitorServerNote(RcSession& ses,
                            const auth::AuthResult& authr,
                            seed::AclConfig&& aclcfg);
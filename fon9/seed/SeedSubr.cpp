@@ -29,6 +29,10 @@ void SeedNotifyArgs::MakeGridView() const {
    FieldsCellRevPrint0NoSpl(this->Tab_->Fields_, *this->Rd_, rbuf, *fon9_kCSTR_CELLSPL);
    this->CacheGV_ = BufferTo<std::string>(rbuf.MoveOut());
 }
+void SeedNotifyArgs::MakeGridViewShared() const {
+   const std::string& gv = this->GetGridView();
+   this->CacheGvShared_.reset(new BufferShared{gv.data(), gv.size()});
+}
 //--------------------------------------------------------------------------//
 SeedNotifySubscribeOK::SeedNotifySubscribeOK(TreeOp& opTree, Tab& tab)
    : base(opTree.Tree_, &tab, TextBegin(), nullptr, SeedNotifyKind::SubscribeOK)
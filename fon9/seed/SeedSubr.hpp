@@ -6,7 +6,7 @@
 #include "fon9/seed/RawRd.hpp"
 #include "fon9/Subr.hpp"
 #include "fon9/TimeInterval.hpp"
-#include "fon9/buffer/BufferList.hpp"
+#include "fon9/buffer/BufferShared.hpp"
 
 namespace fon9 { namespace seed {
 
@@ -41,12 +41,25 @@ enum class SeedNotifyKind {
    StreamEnd = 10,
 };
 
+/// SeedNotifyKind::StreamData 的合併(conflate)協商, 請參考 SeedNotifyArgs::Conflate_;
+enum class StreamDataConflate : uint8_t {
+   /// 訂閱者必須處理此次通知.
+   None,
+   /// 訂閱者若忙碌, 可設定成 Busy, 然後「不處理」此次通知.
+   Allowed,
+   /// 由訂閱者設定: 忙碌中, 此次通知未處理.
+   Busy,
+};
+
 fon9_WARN_DISABLE_PADDING;
 class fon9_API SeedNotifyArgs {
    fon9_NON_COPY_NON_MOVE(SeedNotifyArgs);
 protected:
    std::string    mutable CacheGV_;
    virtual void MakeGridView() const;
+   BufferSharedSP mutable CacheGvShared_;
+   /// 預設: 使用 GetGridView() 的內容建立 CacheGvShared_;
+   virtual void MakeGridViewShared() const;
 
 public:
    SeedNotifyKind NotifyKind_;
@@ -69,6 +82,14 @@ public:
    /// 讓訂閱者可以依此判斷此次的 Stream 所提供的內容.
    /// 由「Stream 發行者」解釋此欄位, 例: fon9/fmkt/MdRtsTypes.hpp: enum class MdRtsKind.
    uintmax_t            StreamDataKind_{};
+   /// NotifyKind = StreamData 事件, 由發行者在呼叫訂閱者前設定.
+   /// 若為 StreamDataConflate::Allowed, 則訂閱者忙碌時(例: 傳送緩衝超過上限),
+   /// 可設定成 StreamDataConflate::Busy 並「不處理」此次通知,
+   /// 由發行者合併之後的異動, 等訂閱者不忙碌時, 再提供最新狀態.
+   /// 例: fon9::fmkt::MdRtStream 的合併模式訂閱.
+   /// 目前只有 fon9::rc::RcSeedVisitorServer 會回覆 Busy;
+   /// fon9::web::WsSeedVisitor 不處理 StreamData, 所以 WebSocket 端沒有合併模式.
+   mutable StreamDataConflate Conflate_{StreamDataConflate::None};
 
    SeedNotifyArgs(Tree& tree, Tab* tab, const StrView& keyText, const RawRd* rd, SeedNotifyKind kind)
       : NotifyKind_(kind), Tree_(tree), Tab_(tab), KeyText_(keyText), Rd_(rd) {
@@ -97,6 +118,14 @@ public:
          this->MakeGridView();
       return this->CacheGV_;
    }
+   /// 與 GetGridView() 的內容相同, 但放在可共用的(不可變)緩衝區.
+   /// - 同一次通知只會建立一次, 例: 發行 StreamData 給多個訂閱者時,
+   ///   每個訂閱者可透過 GetGridViewShared().MakeRefNode() 將內容加入各自的傳送佇列, 不用各自複製.
+   const BufferShared& GetGridViewShared() const {
+      if (!this->CacheGvShared_)
+         this->MakeGridViewShared();
+      return *this->CacheGvShared_;
+   }
 };
 fon9_WARN_POP;
 //--------------------------------------------------------------------------//
@@ -149,6 +178,9 @@ public:
    ///      發行者應「盡量配合」此返回值來管制流量,
    ///      但沒有「約束」效果, 發行者可以不遵守。
    mutable TimeInterval FlowControlWait_;
+   /// 訂閱者返回前, 可設定此值, 告知發行者此次回補的歸屬(例: 同一個連線).
+   /// 發行者可依此值, 在多個回補要求之間公平分配回補資源.
+   mutable const void*  FlowControlKey_{nullptr};
 
    using base::base;
 
@@ -0,0 +1,153 @@
+﻿// \file fon9/tools/f9logbin.cpp
+// 將 LogBin 檔(fon9_LOGB) 轉成文字 log.
+// \author fonwinz@gmail.com
+#include "fon9/LogBin.hpp"
+#include "fon9/File.hpp"
+#include "fon9/StrTo.hpp"
+#include "fon9/ThreadTools.hpp"
+
+fon9_BEFORE_INCLUDE_STD;
+#include <iostream>
+fon9_AFTER_INCLUDE_STD;
+
+static void PrintUsage(const char* prog) {
+   std::cerr << "Usage: " << prog << " [options] LogBinFile...\n"
+      "  -f time    from time(file TimeZone), e.g. \"20260101-093000\"\n"
+      "  -t time    to time(file TimeZone)\n"
+      "  -l level   min level: 0..6 or TRACE,DEBUG,INFO,IMP,WARN,ERROR,FATAL\n"
+      "  -T thrid   only this thread id\n"
+      "  -s         show call-site: |@FileName:Line\n"
+      "  -F         follow: wait for more data(like tail -f), only for the last file\n"
+      << std::endl;
+}
+
+static bool StrToLevel(fon9::StrView str, fon9::LogLevel& level) {
+   if (fon9::isdigit(static_cast<unsigned char>(*str.begin()))) {
+      level = static_cast<fon9::LogLevel>(fon9::StrTo(str, 0u));
+      return level < fon9::LogLevel::Count;
+   }
+   for (unsigned L = 0; L < static_cast<unsigned>(fon9::LogLevel::Count); ++L) {
+      fon9::StrView lvstr{fon9::CstrLevelMap[L] + 1, sizeof(fon9::CstrLevelMap[L]) - 3};
+      if (fon9::StrTrimTail(&lvstr) == str) {
+         level = static_cast<fon9::LogLevel>(L);
+         return true;
+      }
+   }
+   return false;
+}
+
+fon9_WARN_DISABLE_PADDING;
+struct LogBinFilter {
+   fon9::TimeStamp   From_{fon9::TimeStamp::Null()};
+   fon9::TimeStamp   To_{fon9::TimeStamp::Null()};
+   fon9::LogLevel    Level_{fon9::LogLevel::Trace};
+   bool              IsShowSite_{false};
+   bool              IsFollow_{false};
+   bool              HasThreadId_{false};
+   uint32_t          ThreadId_{0};
+
+   bool IsMatch(const fon9::LogBinDecoder& dec, const fon9::LogBinRec& rec) const {
+      if (rec.Level_ < this->Level_)
+         return false;
+      if (this->HasThreadId_ && rec.ThreadId_ != this->ThreadId_)
+         return false;
+      if (!this->From_.IsNull() || !this->To_.IsNull()) {
+         const fon9::TimeStamp tm = rec.UtcTime_ + dec.GetTimeZone();
+         if ((!this->From_.IsNull() && tm < this->From_) || (!this->To_.IsNull() && this->To_ < tm))
+            return false;
+      }
+      return true;
+   }
+};
+fon9_WARN_POP;
+
+static int DecodeFile(const std::string& fname, const LogBinFilter& filter, bool isFollow) {
+   fon9::File  fd;
+   auto        res = fd.Open(fname, fon9::FileMode::Read);
+   if (!res) {
+      std::cerr << "Open|fname=" << fname << "|err=" << fon9::RevPrintTo<std::string>(res.GetError()) << std::endl;
+      return 1;
+   }
+   fon9::LogBinDecoder dec;
+   dec.OnLogRec_ = [&dec, &filter](const fon9::LogBinRec& rec) {
+      if (filter.IsMatch(dec, rec))
+         std::cout << dec.ToText(rec, filter.IsShowSite_) << '\n';
+   };
+   char              buf[1024 * 64];
+   fon9::File::PosType pos = 0;
+   for (;;) {
+      res = fd.Read(pos, buf, sizeof(buf));
+      if (!res) {
+         std::cerr << "Read|fname=" << fname << "|err=" << fon9::RevPrintTo<std::string>(res.GetError()) << std::endl;
+         return 1;
+      }
+      if (res.GetResult() == 0) {
+         if (!isFollow)
+            break;
+         std::cout.flush();
+         std::this_thread::sleep_for(std::chrono::milliseconds(200));
+         continue;
+      }
+      pos += res.GetResult();
+      dec.Feed(buf, res.GetResult());
+   }
+   if (dec.GetPendingSize() > 0)
+      std::cerr << "Incomplete|fname=" << fname << "|size=" << dec.GetPendingSize() << std::endl;
+   if (dec.GetBadRecCount() > 0)
+      std::cerr << "BadRec|fname=" << fname << "|count=" << dec.GetBadRecCount() << std::endl;
+   return 0;
+}
+
+int main(int argc, char** argv) {
+   // 避免 fon9 的訊息(例: TimerThread 的啟動/結束), 混入 stdout 的解碼結果.
+   fon9::LogLevel_ = fon9::LogLevel::Error;
+   LogBinFilter               filter;
+   std::vector<std::string>   files;
+   for (int L = 1; L < argc; ++L) {
+      const char* arg = argv[L];
+      if (arg[0] != '-' || arg[1] == '\0' || arg[2] != '\0') {
+         files.emplace_back(arg);
+         continue;
+      }
+      switch (arg[1]) {
+      case 's': filter.IsShowSite_ = true;   continue;
+      case 'F': filter.IsFollow_ = true;     continue;
+      case 'f': case 't': case 'l': case 'T':
+         if (L + 1 < argc)
+            break;
+         /* fall through */
+      default:
+         PrintUsage(argv[0]);
+         return 2;
+      }
+      const fon9::StrView val = fon9::StrView_cstr(argv[++L]);
+      switch (arg[1]) {
+      case 'f':
+         filter.From_ = fon9::StrTo(val, fon9::TimeStamp::Null());
+         break;
+      case 't':
+         filter.To_ = fon9::StrTo(val, fon9::TimeStamp::Null());
+         break;
+      case 'T':
+         filter.HasThreadId_ = true;
+         filter.ThreadId_ = fon9::StrTo(val, uint32_t{0});
+         break;
+      case 'l':
+         if (!val.empty() && StrToLevel(val, filter.Level_))
+            break;
+         PrintUsage(argv[0]);
+         return 2;
+      }
+   }
+   if (files.empty()) {
+      PrintUsage(argv[0]);
+      return 2;
+   }
+   int retval = 0;
+   for (size_t idx = 0; idx < files.size(); ++idx) {
+      if (int r = DecodeFile(files[idx], filter, filter.IsFollow_ && idx + 1 == files.size()))
+         retval = r;
+   }
+   std::cout.flush();
+   return retval;
+}
@@ -82,6 +82,7 @@ struct WsSeedVisitor::SeedVisitor : public seed::SeedVisitor {
          const char*   cmdEcho;
          switch (args.NotifyKind_) {
          default:
+         // 不支援 Stream 訂閱, 所以也不會有 StreamData 的合併模式(SeedNotifyArgs::Conflate_).
          case fon9::seed::SeedNotifyKind::SubscribeStreamOK:
          case fon9::seed::SeedNotifyKind::StreamData:
          case fon9::seed::SeedNotifyKind::StreamRecover: